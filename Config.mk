@@ -29,12 +29,18 @@ BUILD_LDFLAGS = -L ${TOPDIR}/HurdLib
 BUILD_ELFLIB = $(shell pkg-config libelf --libs)
 
 # SSL library location.
-BUILD_LIBCRYPTO = $(shell pkg-config libcrypto --libs)
+BUILD_LIBCRYPTO = $(shell pkg-config libssl libcrypto --libs)
 
 # If defined, the kernel source directory to be used for building the
 # TSEM kernel modules.
 # BUILD_KERNEL_SOURCE
 
+# If defined, the TSEM control interface honors the TSEM_SECURITYFS
+# environment variable and the quixote-replay benchmark harness is
+# built.  This allows the orchestrators to be benchmarked without a
+# TSEM kernel and must not be defined for production builds.
+# BUILD_REPLAY = true
+
 # Trusted Modeling Agent implentations.
 BUILD_SANCHOS     = # Xen SGX Nordic STmcu
 BUILD_XEN_VERSION = 4.15
@@ -64,7 +70,7 @@ BUILD_NRFUTIL = nrfutil
 export CC BUILD_KERNEL_VERSION BUILD_KERNEL_SOURCE BUILD_LDFLAGS	\
 	BUILD_ELFLIB BUILD_LIBCRYPTO BUILD_SANCHOS BUILD_INSTPATH	\
 	BUILD_MBEDDIR BUILD_MBEDURL BUILD_XEN_VERSION BUILD_NORDIC_URL	\
-	BUILD_NORDIC_DIR BUILD_ARM_TOOLDIR BUILD_NRFUTIL
+	BUILD_NORDIC_DIR BUILD_ARM_TOOLDIR BUILD_NRFUTIL BUILD_REPLAY
 
 
 #
@@ -110,3 +110,10 @@
 #define NAAAIM_TSEMparser_OBJID		70
 #define NAAAIM_TSEMevent_OBJID		71
 #define NAAAIM_MQTTduct_OBJID		72
+#define NAAAIM_AES256_gcm_OBJID		73
+#define NAAAIM_IvyIndex_OBJID		74
+#define NAAAIM_PossumMux_OBJID		75
+#define NAAAIM_DuctServer_OBJID		76
+#define NAAAIM_ModelCache_OBJID		77
+#define NAAAIM_EventLoop_OBJID		78
+#define NAAAIM_EventStats_OBJID		79
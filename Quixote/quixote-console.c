@@ -11,6 +11,14 @@
  *
  * Depending on whether the security domain is running in cartridge or
  * process mode.
+ *
+ * The namespaces modeled by the quixote-tmad daemon are managed through
+ * the following socket:
+ *
+ * /var/lib/Quixote/mgmt/tmad
+ *
+ * With the namespace that a command is directed to selected with the
+ * -n option.
  */
 
 /**************************************************************************
@@ -60,7 +68,9 @@ enum Oneshot_mode {
 	oneshot_forensics,
 	oneshot_points,
 	oneshot_events,
-	oneshot_map
+	oneshot_map,
+	oneshot_namespaces,
+	oneshot_stats
 };
 
 /**
@@ -71,8 +81,15 @@ enum Oneshot_mode {
 	 show_mode,
 	 process_mode,
 	 cartridge_mode,
+	 daemon_mode
 } Mode = show_mode;
 
+/**
+ * The name of the namespace that commands are directed to in daemon
+ * mode.
+ */
+static char *Namespace = NULL;
+
 /**
  * The following variable is used to indicate whether or not output
  * is being directed to a tty or a pipe.
@@ -206,6 +223,11 @@ static _Bool setup_management(CO(LocalDuct, mgmt), const char *pidstr, \
 			if ( !sockpath->add(sockpath, cartridge) )
 				ERR(goto done);
 			break;
+
+		case daemon_mode:
+			if ( !sockpath->add(sockpath, QUIXOTE_TMAD_MGMT) )
+				ERR(goto done);
+			break;
 	}
 
 
@@ -593,6 +615,8 @@ static _Bool receive_command(CO(LocalDuct, mgmt), CO(Buffer, cmdbufr), \
 	switch ( cmdnum ) {
 		case seal_event:
 		case enable_cell:
+		case enable_stats:
+		case disable_stats:
 			if ( !mgmt->receive_Buffer(mgmt, cmdbufr) )
 				ERR(goto done);
 			fprintf(stdout, "%s\n", cmdbufr->get(cmdbufr));
@@ -615,6 +639,8 @@ static _Bool receive_command(CO(LocalDuct, mgmt), CO(Buffer, cmdbufr), \
 
 		case show_counts:
 		case show_forensics_counts:
+		case show_namespaces:
+		case show_stats:
 			retn = receive_list(mgmt, cmdbufr);
 			break;
 
@@ -668,6 +694,10 @@ static _Bool process_command(CO(LocalDuct, mgmt), CO(char *, cmd))
 {
 	_Bool retn = false;
 
+	char *syntax;
+
+	const char *arg = Namespace;
+
 	int lp,
 	    cmdnum = 0;
 
@@ -681,6 +711,16 @@ static _Bool process_command(CO(LocalDuct, mgmt), CO(char *, cmd))
 		if ( strcmp(cp[lp].syntax, cmd) == 0 )
 			cmdnum = cp[lp].command;
 	}
+
+	/* The daemon accepts a command that specifies a cartridge. */
+	if ( (Mode == daemon_mode) && (cmdnum == 0) ) {
+		syntax = Sancho_cmd_list[start_cartridge - 1].syntax;
+		if ( strncmp(cmd, syntax, strlen(syntax)) == 0 ) {
+			cmdnum = start_cartridge;
+			arg    = cmd + strlen(syntax);
+		}
+	}
+
 	if ( cmdnum == 0 ) {
 		fprintf(stdout, "Unknown command: %s\n", cmd);
 		retn = true;
@@ -691,10 +731,28 @@ static _Bool process_command(CO(LocalDuct, mgmt), CO(char *, cmd))
 	INIT(HurdLib, Buffer, cmdbufr, ERR(goto done));
 
 	cmdbufr->add(cmdbufr, (unsigned char *) &cmdnum, sizeof(cmdnum));
+	if ( (Mode == daemon_mode) && (arg != NULL) )
+		cmdbufr->add(cmdbufr, (unsigned char *) arg, strlen(arg) + 1);
 	if ( !mgmt->send_Buffer(mgmt, cmdbufr) )
 		ERR(goto done);
 
+	/*
+	 * The daemon returns the status of a command before the
+	 * response to the command.
+	 */
 	cmdbufr->reset(cmdbufr);
+	if ( (Mode == daemon_mode) && (cmdnum != show_namespaces) ) {
+		if ( !mgmt->receive_Buffer(mgmt, cmdbufr) )
+			ERR(goto done);
+		if ( (cmdnum == start_cartridge) || \
+		     (strcmp((char *) cmdbufr->get(cmdbufr), "OK") != 0) ) {
+			fprintf(stdout, "%s\n", cmdbufr->get(cmdbufr));
+			retn = true;
+			goto done;
+		}
+		cmdbufr->reset(cmdbufr);
+	}
+
 	if ( !receive_command(mgmt, cmdbufr, cmdnum) )
 		ERR(goto done);
 	retn = true;
@@ -762,6 +820,14 @@ static _Bool process_oneshot(CO(LocalDuct, mgmt), enum Oneshot_mode mode)
 			cmd = Sancho_cmd_list[show_counts - 1].syntax;
 			break;
 
+		case oneshot_namespaces:
+			cmd = Sancho_cmd_list[show_namespaces - 1].syntax;
+			break;
+
+		case oneshot_stats:
+			cmd = Sancho_cmd_list[show_stats - 1].syntax;
+			break;
+
 		case oneshot_none:
 			break;
 	}
@@ -803,20 +869,30 @@ extern int main(int argc, char *argv[])
 	File infile = NULL;
 
 
-	while ( (opt = getopt(argc, argv, "CEFMPSTc:p:")) != EOF )
+	while ( (opt = getopt(argc, argv, "CDEFLMNPSTc:n:p:")) != EOF )
 		switch ( opt ) {
 			case 'C':
 				oneshot = oneshot_counts;
 				break;
+			case 'D':
+				Mode = daemon_mode;
+				break;
 			case 'E':
 				oneshot = oneshot_events;
 				break;
 			case 'F':
 				oneshot = oneshot_forensics;
 				break;
+			case 'L':
+				oneshot = oneshot_stats;
+				break;
 			case 'M':
 				oneshot = oneshot_map;
 				break;
+			case 'N':
+				Mode	= daemon_mode;
+				oneshot = oneshot_namespaces;
+				break;
 			case 'P':
 				oneshot = oneshot_points;
 				break;
@@ -831,6 +907,10 @@ extern int main(int argc, char *argv[])
 				Mode = cartridge_mode;
 				cartridge = optarg;
 				break;
+			case 'n':
+				Mode	  = daemon_mode;
+				Namespace = optarg;
+				break;
 			case 'p':
 				Mode = process_mode;
 				pid = optarg;
@@ -845,7 +925,7 @@ extern int main(int argc, char *argv[])
 
 
 	/* Handle show mode. */
-	if ( oneshot == oneshot_none ) {
+	if ( (oneshot == oneshot_none) && (Mode != daemon_mode) ) {
 		fprintf(stdout, "%s:\n", QUIXOTE_CARTRIDGE_MGMT_DIR);
 		show_domains(QUIXOTE_CARTRIDGE_MGMT_DIR);
 		fputs("\n", stdout);
@@ -857,7 +937,7 @@ extern int main(int argc, char *argv[])
 
 
 	/* Verify that a socket type has been specified. */
-	if ( (pid == NULL) && (cartridge == NULL) ) {
+	if ( (pid == NULL) && (cartridge == NULL) && (Mode != daemon_mode) ) {
 		fputs("No domain specified.\n", stderr);
 		goto done;
 	}
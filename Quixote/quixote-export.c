@@ -22,8 +22,6 @@
 #define READ_SIDE  0
 #define WRITE_SIDE 1
 
-#define TSEM_ROOT_EXPORT "/sys/kernel/security/tsem/external_tma/0"
-
 #define _GNU_SOURCE
 
 
@@ -70,6 +68,7 @@
 #include "SecurityPoint.h"
 #include "SecurityEvent.h"
 #include "TSEM.h"
+#include "EventLoop.h"
 #include "TSEMcontrol.h"
 #include "TSEMevent.h"
 
@@ -388,9 +387,7 @@ static _Bool setup_namespace(int *fdptr)
 
 
 	/* Create the pathname to the event update file. */
-	memset(fname, '\0', sizeof(fname));
-	if ( snprintf(fname, sizeof(fname), TSEM_UPDATE_FILE, \
-		      (long long int) id) >= sizeof(fname) )
+	if ( !Control->update_file(Control, id, fname, sizeof(fname)) )
 		ERR(goto done);
 	if ( Debug )
 		fprintf(Debug, "Update file: %s\n", fname);
@@ -508,22 +505,25 @@ static _Bool child_monitor(CO(char *, cartridge), int fd)
 
 	unsigned int cycle = 0;
 
-	struct pollfd poll_data[2];
-
 	Buffer cmdbufr = NULL;
 
+	EventLoop loop = NULL;
+
 
 	INIT(HurdLib, Buffer, cmdbufr, ERR(goto done));
 
-	poll_data[0].fd	    = fd;
-	poll_data[0].events = POLLIN;
+	INIT(NAAAIM, EventLoop, loop, ERR(goto done));
+	if ( !loop->init(loop, 32, false) )
+		ERR(goto done);
+	if ( !loop->watch(loop, 0, fd) )
+		ERR(goto done);
 
 
 	/* Dispatch loop. */
 	if ( Debug ) {
 		fprintf(Debug, "%d: Calling event loop\n", getpid());
-		fprintf(Debug, "descriptor 1: %d, descriptor 2: %d\n", \
-			poll_data[0].fd, poll_data[1].fd);
+		fprintf(Debug, "descriptor: %d, io_uring: %s\n", fd, \
+			loop->uses_ring(loop) ? "yes" : "no");
 	}
 
 	while ( 1 ) {
@@ -531,7 +531,7 @@ static _Bool child_monitor(CO(char *, cartridge), int fd)
 			fprintf(Debug, "\n%d: Poll cycle: %d\n", getpid(), \
 				++cycle);
 
-		rc = poll(poll_data, 2, -1);
+		rc = loop->wait(loop);
 		if ( rc < 0 ) {
 			if ( Signals.stop ) {
 				if ( Debug )
@@ -559,11 +559,10 @@ static _Bool child_monitor(CO(char *, cartridge), int fd)
 		}
 
 		if ( Debug )
-			fprintf(Debug, "Poll retn=%d, Data poll=%0x, "	     \
-				"Mgmt poll=%0x\n", rc, poll_data[0].revents, \
-				poll_data[1].revents);
+			fprintf(Debug, "Poll retn=%d, Data poll=%0x\n", rc, \
+				loop->revents(loop, 0));
 
-		if ( poll_data[0].revents & POLLHUP ) {
+		if ( loop->revents(loop, 0) & POLLHUP ) {
 			if ( Signals.stop ) {
 				retn = true;
 				goto done;
@@ -576,7 +575,7 @@ static _Bool child_monitor(CO(char *, cartridge), int fd)
 			}
 		}
 
-		if ( poll_data[0].revents & POLLIN ) {
+		if ( loop->revents(loop, 0) & POLLIN ) {
 			if ( !Event->read_event(Event, fd) ) {
 				kill_cartridge(false);
 				break;
@@ -603,6 +602,7 @@ static _Bool child_monitor(CO(char *, cartridge), int fd)
 
  done:
 	WHACK(cmdbufr);
+	WHACK(loop);
 
 	return retn;
 }
@@ -685,8 +685,7 @@ static _Bool fire_cartridge(CO(char *, cartridge), int argc, char *argv[],
 {
 	_Bool retn = false;
 
-	char *bundle = NULL,
-	     bufr[TSEM_READ_BUFFER];
+	char *bundle = NULL;
 
 	int rc,
 	    event_pipe[2],
@@ -694,10 +693,12 @@ static _Bool fire_cartridge(CO(char *, cartridge), int argc, char *argv[],
 
 	pid_t cartridge_pid;
 
-	struct pollfd poll_data[1];
+	Buffer events = NULL;
 
 	String cartridge_dir = NULL;
 
+	EventLoop loop = NULL;
+
 
 	/* Create the name of the bundle directory if in cartridge mode . */
 	if ( Mode == cartridge_mode ) {
@@ -813,12 +814,20 @@ static _Bool fire_cartridge(CO(char *, cartridge), int argc, char *argv[],
 			}
 		}
 
-		/* Parent process - monitor for events. */
+		/*
+		 * Parent process - monitor for events.  The events
+		 * that are available are read as a batch and written
+		 * to the exporter with a single write.
+		 */
 		if ( !_set_user(user) )
 			ERR(goto done);
 
-		poll_data[0].fd	    = event_fd;
-		poll_data[0].events = POLLIN;
+		INIT(HurdLib, Buffer, events, ERR(goto done));
+		INIT(NAAAIM, EventLoop, loop, ERR(goto done));
+		if ( !loop->init(loop, 32, false) )
+			ERR(goto done);
+		if ( !loop->watch(loop, 0, event_fd) )
+			ERR(goto done);
 
 		while ( true ) {
 			if ( Signals.stop ) {
@@ -844,118 +853,38 @@ static _Bool fire_cartridge(CO(char *, cartridge), int argc, char *argv[],
 				}
 			}
 
-			memset(bufr, '\0', sizeof(bufr));
-
-			rc = poll(poll_data, 1, -1);
+			rc = loop->wait(loop);
 			if ( rc < 0 ) {
-				if ( errno == -EINTR ) {
-					fputs("poll interrupted.\n", stderr);
+				if ( errno == EINTR )
 					continue;
-				}
+				fputs("Event loop error.\n", stderr);
+				break;
 			}
 
-			if ( (poll_data[0].revents & POLLIN) == 0 )
+			if ( (loop->revents(loop, 0) & POLLIN) == 0 )
 				continue;
 
-			while ( true ) {
-				rc = read(event_fd, bufr, sizeof(bufr));
-				if ( rc == 0 )
-					break;
-				if ( rc < 0 ) {
-					if ( errno != ENODATA ) {
-						fputs("Fatal event read.\n", \
-						      stderr);
-						exit(1);
-					}
-					break;
-				}
-				if ( rc > 0 ) {
-					write(event_pipe[WRITE_SIDE], bufr, \
-					      rc);
-					lseek(event_fd, 0, SEEK_SET);
-				}
-			}
-
-			if ( lseek(event_fd, 0, SEEK_SET) < 0 ) {
-				fputs("Seek error.\n", stderr);
-				break;
+			if ( !loop->drain(loop, event_fd, events) ) {
+				fputs("Fatal event read.\n", stderr);
+				exit(1);
 			}
+			if ( events->size(events) > 0 )
+				write(event_pipe[WRITE_SIDE],		\
+				      events->get(events), events->size(events));
+			events->reset(events);
 		}
 	}
 
 
  done:
+	WHACK(events);
 	WHACK(cartridge_dir);
+	WHACK(loop);
 
 	return retn;
 }
 
 
-/**
- * Private helper function.
- *
- * This function is a helper function for the export_root function.  This
- * function reads a single event description and loads it into the
- * supplied TSEMevent object.
- *
- * \param fd		The file descriptor of the pseudo-file from which
- *			the event description is to be read.
- *
- * \param output	The object that is used to queue the event
- *			descriptions that are to be output.
- *
- * \param nodata	A pointer to a boolean variable that will be
- *			used to indicate whether or not the end of the
- *			current events had been reached.
- *
- * \return	A boolean value is returned to reflect the status of
- *		the read.  A false value indicates an error was
- *		encountered while a true value indicates the output
- *		structure was populated with an event.
- */
-
-static _Bool _get_event(const int fd, CO(Gaggle, output), _Bool *nodata)
-
-{
-	_Bool retn = false;
-
-	char bufr[PAGE_SIZE + 1];
-
-	int rc;
-
-	String str;
-
-
-	memset(bufr, '\0', sizeof(bufr));
-
-	rc = read(fd, bufr, sizeof(bufr));
-	if ( Signals.stop || (rc == 0) ) {
-		retn = true;
-		goto done;
-	}
-
-	if ( rc > 0 ) {
-		str = GGET(output, str);
-		str->reset(str);
-		if ( !str->add(str, bufr) )
-			ERR(goto done);
-		retn = true;
-	} else {
-		if ( errno == ENODATA ) {
-			*nodata = true;
-			retn = true;
-		}
-	}
-
-	if ( lseek(fd, 0, SEEK_SET) < 0 )
-		ERR(goto done);
-
-
- done:
-	return retn;
-}
-
-
 /**
  * Private helper function.
  *
@@ -1019,9 +948,15 @@ static _Bool _output_events(CO(Gaggle, output))
  * function reads and outputs all of the oustanding events that are
  * available.
  *
+ * \param loop		The event loop that is used to read the event
+ *			descriptions.
+ *
  * \param fd		The file descriptor of the pseudo-file from which
  *			the event descriptions are to be read.
  *
+ * \param events	The object that is used to hold the event
+ *			descriptions that are read.
+ *
  * \param output	The object that is used to hold the event
  *			entries.
  *
@@ -1031,24 +966,48 @@ static _Bool _output_events(CO(Gaggle, output))
  *		available events have been exported.
  */
 
-static _Bool _export_events(const int fd, CO(Gaggle, output))
+static _Bool _export_events(CO(EventLoop, loop), const int fd, \
+			    CO(Buffer, events), CO(Gaggle, output))
 
 {
-	_Bool retn   = false,
-	      nodata = false;
+	_Bool retn = false;
+
+	char *p,
+	     *end,
+	     save;
+
+	String str;
 
 
-	/* Output events until the end of the event list is met. */
+	/* Read the events that are available. */
+	events->reset(events);
+	if ( !loop->drain(loop, fd, events) )
+		ERR(goto done);
+	if ( events->size(events) == 0 ) {
+		retn = true;
+		goto done;
+	}
+	if ( !events->add(events, (unsigned char *) "\0", 1) )
+		ERR(goto done);
+
+
+	/* Queue each event description for output. */
 	output->rewind_cursor(output);
 
-	while ( true ) {
-		if ( !_get_event(fd, output, &nodata) )
+	p = (char *) events->get(events);
+	while ( (*p != '\0') && !Signals.stop ) {
+		if ( (end = strchr(p, '\n')) == NULL )
+			end = p + strlen(p) - 1;
+		save   = end[1];
+		end[1] = '\0';
+
+		str = GGET(output, str);
+		str->reset(str);
+		if ( !str->add(str, p) )
 			ERR(goto done);
 
-		if ( nodata ) {
-			retn = true;
-			break;
-		}
+		end[1] = save;
+		p      = end + 1;
 
 		if ( ++Queued == output->size(output) ) {
 			if ( !_output_events(output) )
@@ -1056,6 +1015,7 @@ static _Bool _export_events(const int fd, CO(Gaggle, output))
 			Queued = 0;
 		}
 	}
+	retn = true;
 
 
  done:
@@ -1088,6 +1048,8 @@ static _Bool export_root(const _Bool follow, CO(char *, queue_size))
 {
 	_Bool retn = false;
 
+	char fname[PATH_MAX];
+
 	int rc,
 	    fd;
 
@@ -1097,15 +1059,19 @@ static _Bool export_root(const _Bool follow, CO(char *, queue_size))
 
 	unsigned int cycle = 0;
 
-	struct pollfd poll_data[1];
-
 	String str;
 
+	Buffer events = NULL;
+
 	Gaggle output = NULL;
 
+	EventLoop loop = NULL;
+
 
 	/* Open the root export file. */
-	if ( (fd = open(TSEM_ROOT_EXPORT, O_RDONLY)) < 0 )
+	if ( !Control->update_file(Control, 0, fname, sizeof(fname)) )
+		ERR(goto done);
+	if ( (fd = open(fname, O_RDONLY)) < 0 )
 		ERR(goto done);
 
 	/* Establish the queue size. */
@@ -1121,8 +1087,16 @@ static _Bool export_root(const _Bool follow, CO(char *, queue_size))
 			ERR(goto done);
 	}
 
+	/* Initialize the event loop. */
+	INIT(HurdLib, Buffer, events, ERR(goto done));
+	INIT(NAAAIM, EventLoop, loop, ERR(goto done));
+	if ( !loop->init(loop, 32, false) )
+		ERR(goto done);
+	if ( !loop->watch(loop, 0, fd) )
+		ERR(goto done);
+
 	/* Output entries that have been queued. */
-	if ( !_export_events(fd, output) )
+	if ( !_export_events(loop, fd, events, output) )
 		ERR(goto done);
 
 	if ( !follow ) {
@@ -1136,15 +1110,12 @@ static _Bool export_root(const _Bool follow, CO(char *, queue_size))
 	if ( Debug )
 		fprintf(Debug, "%d: Running root event loop.\n", getpid());
 
-	poll_data[0].fd	    = fd;
-	poll_data[0].events = POLLIN;
-
 	while ( 1 ) {
 		if ( Debug )
 			fprintf(Debug, "\n%d: Poll cycle: %d\n", getpid(), \
 				++cycle);
 
-		rc = poll(poll_data, 1, -1);
+		rc = loop->wait(loop);
 		if ( rc < 0 ) {
 			if ( Signals.stop ) {
 				if ( Debug )
@@ -1157,10 +1128,10 @@ static _Bool export_root(const _Bool follow, CO(char *, queue_size))
 
 		if ( Debug )
 			fprintf(Debug, "Poll retn=%d, Data poll=%0x\n", \
-				rc, poll_data[0].revents);
+				rc, loop->revents(loop, 0));
 
-		if ( poll_data[0].revents & POLLIN ) {
-			if ( !_export_events(fd, output) )
+		if ( loop->revents(loop, 0) & POLLIN ) {
+			if ( !_export_events(loop, fd, events, output) )
 				ERR(goto done);
 		}
 	}
@@ -1168,6 +1139,8 @@ static _Bool export_root(const _Bool follow, CO(char *, queue_size))
 
  done:
 	GWHACK(output, String);
+	WHACK(events);
+	WHACK(loop);
 
 	return retn;
 }
@@ -78,6 +78,7 @@
 #include "quixote.h"
 #include "sancho-cmd.h"
 
+#include <EventLoop.h>
 #include <TSEMcontrol.h>
 #include <TSEMevent.h>
 
@@ -1360,9 +1361,7 @@ static _Bool setup_namespace(int *fdptr, _Bool enforce)
 	}
 
 	/* Create the pathname to the event update file. */
-	memset(fname, '\0', sizeof(fname));
-	if ( snprintf(fname, sizeof(fname), TSEM_UPDATE_FILE, \
-		      (long long int) id) >= sizeof(fname) )
+	if ( !Control->update_file(Control, id, fname, sizeof(fname)) )
 		ERR(goto done);
 	if ( Debug )
 		fprintf(Debug, "Update file: %s\n", fname);
@@ -1480,32 +1479,42 @@ static _Bool child_monitor(LocalDuct mgmt, CO(char *, cartridge), int fd)
 	      retn = false,
 	      connected = false;
 
-	int rc;
+	int rc,
+	    error,
+	    mgmt_fd;
 
 	unsigned int cycle = 0;
 
-	struct pollfd poll_data[2];
-
 	Buffer cmdbufr = NULL;
 
+	EventLoop loop = NULL;
+
 
 	INIT(HurdLib, Buffer, cmdbufr, ERR(goto done));
 
-	poll_data[0].fd	    = fd;
-	poll_data[0].events = POLLIN;
+	INIT(NAAAIM, EventLoop, loop, ERR(goto done));
+	if ( !loop->init(loop, 64, false) )
+		ERR(goto done);
+	if ( !loop->watch(loop, 0, fd) )
+		ERR(goto done);
 
-	if ( !mgmt->get_socket(mgmt, &poll_data[1].fd) ) {
+	if ( !mgmt->get_socket(mgmt, &mgmt_fd) ) {
 		fputs("Error setting up polling data.\n", stderr);
 		goto done;
 	}
-	poll_data[1].events = POLLIN;
+	if ( !loop->watch(loop, 1, mgmt_fd) )
+		ERR(goto done);
+
+	if ( !Control->set_loop(Control, loop) )
+		ERR(goto done);
 
 
 	/* Dispatch loop. */
 	if ( Debug ) {
 		fprintf(Debug, "%d: Calling event loop\n", getpid());
-		fprintf(Debug, "descriptor 1: %d, descriptor 2: %d\n", \
-			poll_data[0].fd, poll_data[1].fd);
+		fprintf(Debug, "descriptor 1: %d, descriptor 2: %d, " \
+			"io_uring: %s\n", fd, mgmt_fd,		      \
+			loop->uses_ring(loop) ? "yes" : "no");
 	}
 
 	while ( 1 ) {
@@ -1513,7 +1522,10 @@ static _Bool child_monitor(LocalDuct mgmt, CO(char *, cartridge), int fd)
 			fprintf(Debug, "\n%d: Poll cycle: %d\n", getpid(), \
 				++cycle);
 
-		rc = poll(poll_data, 2, -1);
+		rc = loop->wait(loop);
+		if ( (error = loop->write_error(loop)) != 0 )
+			fprintf(stderr, "[%s]: Release actor status: %d:%s\n",
+				__func__, error, strerror(error));
 		if ( rc < 0 ) {
 			if ( Signals.stop ) {
 				if ( Debug )
@@ -1541,11 +1553,11 @@ static _Bool child_monitor(LocalDuct mgmt, CO(char *, cartridge), int fd)
 		}
 
 		if ( Debug )
-			fprintf(Debug, "Poll retn=%d, Data poll=%0x, "	     \
-				"Mgmt poll=%0x\n", rc, poll_data[0].revents, \
-				poll_data[1].revents);
+			fprintf(Debug, "Poll retn=%d, Data poll=%0x, "	\
+				"Mgmt poll=%0x\n", rc,			\
+				loop->revents(loop, 0), loop->revents(loop, 1));
 
-		if ( poll_data[0].revents & POLLHUP ) {
+		if ( loop->revents(loop, 0) & POLLHUP ) {
 			if ( Signals.stop ) {
 				retn = true;
 				goto done;
@@ -1558,7 +1570,7 @@ static _Bool child_monitor(LocalDuct mgmt, CO(char *, cartridge), int fd)
 			}
 		}
 
-		if ( poll_data[0].revents & POLLIN ) {
+		if ( loop->revents(loop, 0) & POLLIN ) {
 			if ( !Event->read_event(Event, fd) ) {
 				kill_cartridge(false);
 				break;
@@ -1586,7 +1598,7 @@ static _Bool child_monitor(LocalDuct mgmt, CO(char *, cartridge), int fd)
 			}
 		}
 
-		if ( poll_data[1].revents & POLLIN ) {
+		if ( loop->revents(loop, 1) & POLLIN ) {
 			if ( !connected ) {
 				if ( Debug )
 					fputs("Have socket connection.\n", \
@@ -1594,7 +1606,9 @@ static _Bool child_monitor(LocalDuct mgmt, CO(char *, cartridge), int fd)
 
 				if ( !mgmt->accept_connection(mgmt) )
 					ERR(goto done);
-				if ( !mgmt->get_fd(mgmt, &poll_data[1].fd) )
+				if ( !mgmt->get_fd(mgmt, &mgmt_fd) )
+					ERR(goto done);
+				if ( !loop->watch(loop, 1, mgmt_fd) )
 					ERR(goto done);
 				connected = true;
 				continue;
@@ -1606,8 +1620,9 @@ static _Bool child_monitor(LocalDuct mgmt, CO(char *, cartridge), int fd)
 					fputs("Terminating management.\n", \
 					      Debug);
 				mgmt->reset(mgmt);
-				if ( !mgmt->get_socket(mgmt, \
-						       &poll_data[1].fd) )
+				if ( !mgmt->get_socket(mgmt, &mgmt_fd) )
+					ERR(goto done);
+				if ( !loop->watch(loop, 1, mgmt_fd) )
 					ERR(goto done);
 				connected = false;
 				continue;
@@ -1623,7 +1638,11 @@ static _Bool child_monitor(LocalDuct mgmt, CO(char *, cartridge), int fd)
 
 
  done:
+	if ( Control != NULL )
+		Control->set_loop(Control, NULL);
+
 	WHACK(cmdbufr);
+	WHACK(loop);
 
 	return retn;
 }
@@ -1661,8 +1680,7 @@ static _Bool fire_cartridge(CO(LocalDuct, mgmt), CO(char *, cartridge), \
 {
 	_Bool retn = false;
 
-	char *bundle = NULL,
-	     bufr[TSEM_READ_BUFFER];
+	char *bundle = NULL;
 
 	int rc,
 	    event_pipe[2],
@@ -1670,10 +1688,12 @@ static _Bool fire_cartridge(CO(LocalDuct, mgmt), CO(char *, cartridge), \
 
 	pid_t cartridge_pid;
 
-	struct pollfd poll_data[1];
+	Buffer events = NULL;
 
 	String cartridge_dir = NULL;
 
+	EventLoop loop = NULL;
+
 
 	/* Create the name of the bundle directory if in cartridge mode. */
 	if ( Mode == cartridge_mode ) {
@@ -1770,8 +1790,12 @@ static _Bool fire_cartridge(CO(LocalDuct, mgmt), CO(char *, cartridge), \
 		/* Parent process - monitor for events. */
 		Workload_pid = cartridge_pid;
 
-		poll_data[0].fd	    = event_fd;
-		poll_data[0].events = POLLIN;
+		INIT(HurdLib, Buffer, events, ERR(goto done));
+		INIT(NAAAIM, EventLoop, loop, ERR(goto done));
+		if ( !loop->init(loop, 32, false) )
+			ERR(goto done);
+		if ( !loop->watch(loop, 0, event_fd) )
+			ERR(goto done);
 
 		while ( true ) {
 			if ( Signals.stop ) {
@@ -1803,50 +1827,35 @@ static _Bool fire_cartridge(CO(LocalDuct, mgmt), CO(char *, cartridge), \
 				}
 			}
 
-			memset(bufr, '\0', sizeof(bufr));
-
-			rc = poll(poll_data, 1, -1);
+			rc = loop->wait(loop);
 			if ( Debug )
 				fprintf(Debug, "Poll returns: %d\n", rc);
 			if ( rc < 0 ) {
-				if ( errno == -EINTR ) {
-					fputs("poll interrupted.\n", stderr);
+				if ( errno == EINTR )
 					continue;
-				}
+				fputs("Event loop error.\n", stderr);
+				break;
 			}
 
-			if ( (poll_data[0].revents & POLLIN) == 0 )
+			if ( (loop->revents(loop, 0) & POLLIN) == 0 )
 				continue;
 
-			while ( true ) {
-				rc = read(event_fd, bufr, sizeof(bufr));
-				if ( rc == 0 )
-					break;
-				if ( rc < 0 ) {
-					if ( errno != ENODATA ) {
-						fputs("Fatal event read.\n", \
-						      stderr);
-						exit(1);
-					}
-					break;
-				}
-				if ( rc > 0 ) {
-					write(event_pipe[WRITE_SIDE], bufr, \
-					      rc);
-					lseek(event_fd, 0, SEEK_SET);
-				}
-			}
-
-			if ( lseek(event_fd, 0, SEEK_SET) < 0 ) {
-				fputs("Seek error.\n", stderr);
-				break;
+			if ( !loop->drain(loop, event_fd, events) ) {
+				fputs("Fatal event read.\n", stderr);
+				exit(1);
 			}
+			if ( events->size(events) > 0 )
+				write(event_pipe[WRITE_SIDE],		\
+				      events->get(events), events->size(events));
+			events->reset(events);
 		}
 	}
 
 
  done:
+	WHACK(events);
 	WHACK(cartridge_dir);
+	WHACK(loop);
 
 	return retn;
 }
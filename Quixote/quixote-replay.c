@@ -0,0 +1,977 @@
+/** \file
+ *
+ * This file implements a utility for benchmarking a trust orchestrator
+ * without a kernel that implements TSEM.  The utility creates a
+ * directory that stands in for the TSEM securityfs directory:
+ *
+ * DIR/control
+ * DIR/id
+ * DIR/external_tma/1
+ *
+ * Where the control and external_tma files are FIFO's.  The
+ * orchestrator is run with the TSEM_SECURITYFS environment variable
+ * set to the directory so that the orchestrator creates its modeling
+ * namespace, reads its security events and writes its release
+ * commands through the FIFO's rather then through the kernel.  The
+ * relocation is only honored by orchestrators that were built with
+ * the BUILD_REPLAY configuration option.
+ *
+ * A recorded trajectory of exported security events, in the JSON
+ * format generated by the kernel and output by quixote-export, is
+ * replayed into the event file at a specified rate, or as fast as the
+ * orchestrator will accept them.  Each event is assigned the process
+ * identifier of one of a set of simulated tasks and a task is not
+ * reused until the orchestrator has released or disciplined it, as
+ * would be the case with a task that is blocked in the kernel.
+ *
+ * The time from the write of an event to the receipt of its verdict
+ * is recorded and the throughput and latency percentiles of the run
+ * are output when the replay completes.  The orchestrator to be
+ * benchmarked, and its arguments, follow the options to the utility,
+ * for example:
+ *
+ * quixote-replay -t trajectory.json -w 8 -- quixote-us -X sleep 3600
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+#define _GNU_SOURCE
+
+/* The environment variable used to relocate the TSEM directory. */
+#define TSEM_DIRECTORY_ENV "TSEM_SECURITYFS"
+
+/* The identifier of the simulated namespace. */
+#define NAMESPACE_ID 1
+
+/* The process identifier of the first simulated task. */
+#define PID_BASE 1000000
+
+/* The size requested for the FIFO's. */
+#define FIFO_SIZE (1024 * 1024)
+
+/* The key that introduces the process identifier of an event. */
+#define PID_KEY "\"pid\": \""
+
+
+/* Include files. */
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <limits.h>
+#include <time.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <HurdLib.h>
+#include <Buffer.h>
+#include <String.h>
+
+#include "NAAAIM.h"
+#include "EventStats.h"
+#include "TSEMevent.h"
+
+
+/** A security event in the trajectory being replayed. */
+struct replay_event {
+	enum TSEM_export_type type;
+	char name[32];
+	size_t offset;
+	size_t length;
+	size_t pid_offset;
+	size_t pid_length;
+};
+
+/** A simulated task waiting for the verdict on its event. */
+struct replay_task {
+	_Bool busy;
+	uint64_t start;
+	const struct replay_event *event;
+};
+
+
+/**
+ * The text of the trajectory and the description of each event.
+ */
+static Buffer Text = NULL;
+static Buffer Events = NULL;
+
+/**
+ * The simulated tasks.
+ */
+static struct replay_task *Tasks = NULL;
+static unsigned int Task_count = 1;
+
+/**
+ * The object used to collect the latencies of the verdicts.
+ */
+static EventStats Stats = NULL;
+
+/**
+ * The file that the verdicts are to be logged to.
+ */
+static FILE *Verdicts = NULL;
+
+/**
+ * The stand-in for the TSEM directory and its files.
+ */
+static char Root[PATH_MAX];
+static char Control_file[PATH_MAX];
+static char Id_file[PATH_MAX];
+static char Event_dir[PATH_MAX];
+static char Event_file[PATH_MAX];
+
+/**
+ * The process identifier of the orchestrator.
+ */
+static pid_t Orchestrator = -1;
+
+/**
+ * Signal flag used to terminate the replay.
+ */
+static volatile sig_atomic_t Stop = false;
+
+
+/**
+ * Private function.
+ *
+ * This function implements the signal handler for the utility.
+ *
+ * \param signal	The number of the signal which caused the
+ *			handler to execute.
+ */
+
+static void signal_handler(int signal)
+
+{
+	Stop = true;
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function returns the current time.
+ *
+ * \return	The value of the monotonic clock in nanoseconds is
+ *		returned.
+ */
+
+static uint64_t now(void)
+
+{
+	struct timespec ts;
+
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function loads the trajectory that is to be replayed.  Each
+ * line of the file is classified by its export type and the location
+ * of the process identifier of each event that the orchestrator will
+ * return a verdict for is recorded.
+ *
+ * \param fname		A pointer to the null-terminated name of the
+ *			file containing the trajectory.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the trajectory was loaded.
+ */
+
+static _Bool load_trajectory(CO(char *, fname))
+
+{
+	_Bool retn = false;
+
+	char *p,
+	     *line = NULL;
+
+	size_t size = 0;
+
+	ssize_t length;
+
+	FILE *infile = NULL;
+
+	String str   = NULL,
+	       field = NULL;
+
+	TSEMevent event = NULL;
+
+	struct replay_event entry;
+
+
+	INIT(HurdLib, String, str, ERR(goto done));
+	INIT(HurdLib, String, field, ERR(goto done));
+	INIT(NAAAIM, TSEMevent, event, ERR(goto done));
+
+	if ( (infile = fopen(fname, "r")) == NULL ) {
+		fprintf(stderr, "Cannot open trajectory: %s\n", fname);
+		goto done;
+	}
+
+	while ( (length = getline(&line, &size, infile)) > 0 ) {
+		if ( line[length - 1] != '\n' ) {
+			fputs("Trajectory is truncated.\n", stderr);
+			goto done;
+		}
+		if ( length == 1 )
+			continue;
+
+		/* Classify the event. */
+		memset(&entry, '\0', sizeof(entry));
+
+		str->reset(str);
+		line[length - 1] = '\0';
+		if ( !str->add(str, line) )
+			ERR(goto done);
+		line[length - 1] = '\n';
+
+		event->reset(event);
+		if ( !event->set_event(event, str) )
+			ERR(goto done);
+		if ( (entry.type = event->extract_export(event)) == \
+		     TSEM_EVENT_UNKNOWN ) {
+			fprintf(stderr, "Invalid event: %s", line);
+			goto done;
+		}
+
+		if ( (entry.type == TSEM_EVENT_EVENT) || \
+		     (entry.type == TSEM_EVENT_ASYNC_EVENT) ) {
+			field->reset(field);
+			if ( !event->get_text(event, "type", field) )
+				ERR(goto done);
+			strncpy(entry.name, field->get(field), \
+				sizeof(entry.name) - 1);
+		}
+
+		/* Locate the process identifier to be replaced. */
+		if ( entry.type == TSEM_EVENT_EVENT ) {
+			if ( (p = strstr(line, PID_KEY)) == NULL ) {
+				fprintf(stderr, "No event pid: %s", line);
+				goto done;
+			}
+			p += strlen(PID_KEY);
+			entry.pid_offset = p - line;
+			entry.pid_length = strcspn(p, "\"");
+		}
+
+		entry.offset = Text->size(Text);
+		entry.length = length;
+		if ( !Text->add(Text, (unsigned char *) line, length) )
+			ERR(goto done);
+		if ( !Events->add(Events, (unsigned char *) &entry, \
+				  sizeof(entry)) )
+			ERR(goto done);
+	}
+
+	if ( Events->size(Events) == 0 ) {
+		fputs("Trajectory is empty.\n", stderr);
+		goto done;
+	}
+	retn = true;
+
+
+ done:
+	if ( infile != NULL )
+		fclose(infile);
+	free(line);
+
+	WHACK(str);
+	WHACK(field);
+	WHACK(event);
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function creates the directory that stands in for the TSEM
+ * securityfs directory.
+ *
+ * \param root		A pointer to the null-terminated name of the
+ *			directory to be used.  A NULL value causes a
+ *			temporary directory to be created.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the directory was created.
+ */
+
+static _Bool setup_directory(CO(char *, root))
+
+{
+	_Bool retn = false;
+
+	FILE *idfile = NULL;
+
+
+	/* Create the directory. */
+	if ( root == NULL ) {
+		strcpy(Root, "/tmp/tsem-replay.XXXXXX");
+		if ( mkdtemp(Root) == NULL )
+			ERR(goto done);
+	} else {
+		if ( snprintf(Root, sizeof(Root), "%s", root) >= \
+		     sizeof(Root) )
+			ERR(goto done);
+		if ( (mkdir(Root, 0700) == -1) && (errno != EEXIST) )
+			ERR(goto done);
+	}
+
+	snprintf(Control_file, sizeof(Control_file), "%s/control", Root);
+	snprintf(Id_file, sizeof(Id_file), "%s/id", Root);
+	snprintf(Event_dir, sizeof(Event_dir), "%s/external_tma", Root);
+	if ( snprintf(Event_file, sizeof(Event_file), "%s/%d", Event_dir, \
+		      NAMESPACE_ID) >= sizeof(Event_file) )
+		ERR(goto done);
+
+
+	/* Create the files. */
+	if ( (mkdir(Event_dir, 0700) == -1) && (errno != EEXIST) )
+		ERR(goto done);
+
+	if ( (mkfifo(Control_file, 0600) == -1) && (errno != EEXIST) )
+		ERR(goto done);
+	if ( (mkfifo(Event_file, 0600) == -1) && (errno != EEXIST) )
+		ERR(goto done);
+
+	if ( (idfile = fopen(Id_file, "w")) == NULL )
+		ERR(goto done);
+	fprintf(idfile, "%d\n", NAMESPACE_ID);
+	retn = true;
+
+
+ done:
+	if ( idfile != NULL )
+		fclose(idfile);
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function removes the files that stand in for the TSEM
+ * securityfs files.
+ *
+ * \param remove_root	A flag indicating whether or not the directory
+ *			itself is to be removed.
+ */
+
+static void remove_directory(const _Bool remove_root)
+
+{
+	unlink(Event_file);
+	rmdir(Event_dir);
+	unlink(Id_file);
+	unlink(Control_file);
+
+	if ( remove_root )
+		rmdir(Root);
+
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function starts the orchestrator that is to be benchmarked.
+ * The orchestrator is placed in its own process group so that it,
+ * and the processes it creates, can be terminated when the replay
+ * completes.
+ *
+ * \param argv	A pointer to the NULL terminated array containing the
+ *		command line of the orchestrator.
+ *
+ * \return	The process identifier of the orchestrator is returned.
+ *		A value of -1 indicates the orchestrator could not be
+ *		started.
+ */
+
+static pid_t start_orchestrator(char *argv[])
+
+{
+	pid_t pid;
+
+
+	if ( (pid = fork()) == -1 )
+		return -1;
+
+	if ( pid == 0 ) {
+		setpgid(0, 0);
+		if ( setenv(TSEM_DIRECTORY_ENV, Root, 1) == -1 )
+			_exit(1);
+		execvp(argv[0], argv);
+		fprintf(stderr, "Cannot execute orchestrator: %s\n", argv[0]);
+		_exit(1);
+	}
+
+	setpgid(pid, pid);
+	return pid;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function terminates the orchestrator and the processes that
+ * it has created.  The orchestrator is given five seconds to shut
+ * down after being interrupted before it is killed.
+ *
+ * \param pid	The process identifier of the orchestrator.
+ */
+
+static void stop_orchestrator(const pid_t pid)
+
+{
+	unsigned int lp;
+
+
+	kill(-pid, SIGINT);
+	for (lp= 0; lp < 50; ++lp) {
+		if ( waitpid(pid, NULL, WNOHANG) == pid ) {
+			kill(-pid, SIGKILL);
+			return;
+		}
+		usleep(100000);
+	}
+
+	kill(-pid, SIGKILL);
+	waitpid(pid, NULL, 0);
+
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function processes a command that the orchestrator wrote to
+ * the control file.
+ *
+ * \param cmd		A pointer to the null-terminated command.
+ *
+ * \param created	A pointer to the flag that is set when the
+ *			orchestrator creates its namespace.
+ *
+ * \return		The number of verdicts that the command
+ *			completed is returned.
+ */
+
+static unsigned int process_command(CO(char *, cmd), _Bool *created)
+
+{
+	_Bool trusted;
+
+	char *p;
+
+	long int pid;
+
+	uint64_t latency;
+
+	struct replay_task *task;
+
+
+	if ( strncmp(cmd, "external", 8) == 0 ) {
+		*created = true;
+		return 0;
+	}
+
+	if ( strncmp(cmd, "trusted pid=", 12) == 0 )
+		trusted = true;
+	else if ( strncmp(cmd, "untrusted pid=", 14) == 0 )
+		trusted = false;
+	else
+		return 0;
+
+	p   = strchr(cmd, '=') + 1;
+	pid = strtol(p, NULL, 10) - PID_BASE;
+	if ( (pid < 0) || (pid >= Task_count) || !Tasks[pid].busy ) {
+		fprintf(stderr, "Verdict for unknown task: %s\n", cmd);
+		return 0;
+	}
+
+
+	/* Record the verdict. */
+	task	= &Tasks[pid];
+	latency = now() - task->start;
+
+	Stats->set_type(Stats, task->event->name);
+	Stats->record(Stats, EVENTSTATS_TOTAL, latency);
+	Stats->increment(Stats, trusted ? EVENTSTATS_RELEASES : \
+			 EVENTSTATS_DISCIPLINES);
+
+	if ( Verdicts != NULL )
+		fprintf(Verdicts, "pid=%ld type=%s verdict=%s latency=%lu\n", \
+			pid + PID_BASE, task->event->name,		      \
+			trusted ? "trusted" : "untrusted",		      \
+			(unsigned long int) latency);
+
+	task->busy = false;
+	return 1;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function reads the commands that the orchestrator has written
+ * to the control file and processes each complete command.
+ *
+ * \param fd		The file descriptor of the control file.
+ *
+ * \param input		The object holding a partial command from the
+ *			previous read.
+ *
+ * \param created	A pointer to the flag that is set when the
+ *			orchestrator creates its namespace.
+ *
+ * \return		The number of verdicts that were received is
+ *			returned.  A negative value indicates an error
+ *			reading the control file.
+ */
+
+static int read_commands(const int fd, CO(Buffer, input), _Bool *created)
+
+{
+	char *cmd,
+	     *p,
+	     bufr[16384];
+
+	int verdicts = 0;
+
+	size_t used;
+
+	ssize_t amt;
+
+
+	while ( (amt = read(fd, bufr, sizeof(bufr))) > 0 ) {
+		if ( !input->add(input, (unsigned char *) bufr, amt) )
+			return -1;
+	}
+	if ( (amt < 0) && (errno != EAGAIN) )
+		return -1;
+
+
+	/* Process each complete command. */
+	if ( !input->add(input, (unsigned char *) "", 1) )
+		return -1;
+
+	cmd = (char *) input->get(input);
+	while ( (p = strchr(cmd, '\n')) != NULL ) {
+		*p = '\0';
+		verdicts += process_command(cmd, created);
+		cmd = p + 1;
+	}
+
+	used = cmd - (char *) input->get(input);
+	amt  = input->size(input) - 1 - used;
+	memmove(input->get(input), cmd, amt);
+	input->shrink(input, input->size(input) - amt);
+
+	return verdicts;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function adds an event to the output that is to be written to
+ * the event file.  An event that the orchestrator will return a
+ * verdict for is assigned to a simulated task.
+ *
+ * \param event		A pointer to the description of the event.
+ *
+ * \param task		The number of the task that the event is
+ *			assigned to.
+ *
+ * \param output	The object that the event is to be added to.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the event was added.
+ */
+
+static _Bool queue_event(CO(struct replay_event *, event), \
+			 const unsigned int task, CO(Buffer, output))
+
+{
+	char pid[16];
+
+	unsigned char *text = Text->get(Text) + event->offset;
+
+
+	if ( event->type != TSEM_EVENT_EVENT )
+		return output->add(output, text, event->length);
+
+	snprintf(pid, sizeof(pid), "%u", PID_BASE + task);
+	if ( !output->add(output, text, event->pid_offset) )
+		return false;
+	if ( !output->add(output, (unsigned char *) pid, strlen(pid)) )
+		return false;
+	if ( !output->add(output, text + event->pid_offset +		    \
+			  event->pid_length, event->length -		    \
+			  event->pid_offset - event->pid_length) )
+		return false;
+
+	Tasks[task].busy  = true;
+	Tasks[task].event = event;
+	Tasks[task].start = now();
+
+	return true;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function carries out the replay of the trajectory.
+ *
+ * \param count		The number of events to be replayed.
+ *
+ * \param rate		The rate, in events per second, at which the
+ *			events are to be written.  A value of zero
+ *			causes the events to be written as fast as
+ *			the orchestrator will accept them.
+ *
+ * \param timeout	The number of seconds to wait for the
+ *			orchestrator before the replay is abandoned.
+ *
+ * \param elapsed	A pointer to the variable that will be loaded
+ *			with the duration of the replay in nanoseconds.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the replay completed.
+ */
+
+static _Bool replay(const unsigned long int count, const unsigned long rate, \
+		    const unsigned int timeout, uint64_t *elapsed)
+
+{
+	_Bool retn    = false,
+	      created = false;
+
+	int rc,
+	    verdicts,
+	    wait,
+	    control_fd = -1,
+	    event_fd   = -1;
+
+	unsigned int lp,
+		     free_task	 = 0,
+		     outstanding = 0;
+
+	unsigned long int sent = 0,
+			  events;
+
+	uint64_t start	   = 0,
+		 progress  = now(),
+		 next_send = 0,
+		 interval  = rate ? 1000000000ULL / rate : 0,
+		 current;
+
+	size_t written = 0;
+
+	ssize_t amt;
+
+	struct pollfd poll_data[2];
+
+	struct replay_event *event;
+
+	Buffer input  = NULL,
+	       output = NULL;
+
+
+	INIT(HurdLib, Buffer, input, ERR(goto done));
+	INIT(HurdLib, Buffer, output, ERR(goto done));
+
+	event  = (struct replay_event *) Events->get(Events);
+	events = Events->size(Events) / sizeof(struct replay_event);
+
+	/*
+	 * The FIFO's are opened for reading and writing so that they
+	 * can be opened before the orchestrator opens them and do not
+	 * report an end of file if the orchestrator closes them.
+	 */
+	if ( (control_fd = open(Control_file, O_RDWR | O_NONBLOCK)) < 0 )
+		ERR(goto done);
+	if ( (event_fd = open(Event_file, O_RDWR | O_NONBLOCK)) < 0 )
+		ERR(goto done);
+	fcntl(control_fd, F_SETPIPE_SZ, FIFO_SIZE);
+	fcntl(event_fd, F_SETPIPE_SZ, FIFO_SIZE);
+
+	poll_data[0].fd = control_fd;
+	poll_data[1].fd = event_fd;
+
+
+	/* Replay the events until all of the verdicts are received. */
+	while ( !Stop && ((sent < count) || (outstanding > 0) || \
+			  (written < output->size(output))) ) {
+		current = now();
+
+		/* Queue the next event if it can be sent. */
+		while ( created && (sent < count) && (current >= next_send) ) {
+			lp = sent % events;
+			if ( event[lp].type == TSEM_EVENT_EVENT ) {
+				if ( outstanding == Task_count )
+					break;
+				for (free_task= 0; Tasks[free_task].busy; \
+					     ++free_task)
+					continue;
+				++outstanding;
+				Stats->increment(Stats, EVENTSTATS_EVENTS);
+			}
+			if ( event[lp].type == TSEM_EVENT_ASYNC_EVENT )
+				Stats->increment(Stats, EVENTSTATS_ASYNC_EVENTS);
+
+			if ( !queue_event(&event[lp], free_task, output) )
+				ERR(goto done);
+			if ( start == 0 )
+				start = current;
+			++sent;
+			next_send = interval ? start + sent * interval : 0;
+			if ( interval )
+				break;
+		}
+
+
+		/* Wait for the files to be ready. */
+		poll_data[0].events = POLLIN;
+		poll_data[1].events = written < output->size(output) ? \
+			POLLOUT : 0;
+
+		wait = 100;
+		if ( interval && (sent < count) && (next_send > current) &&
+		     (outstanding < Task_count) )
+			wait = (next_send - current) / 1000000;
+
+		if ( (rc = poll(poll_data, 2, wait)) < 0 ) {
+			if ( errno == EINTR )
+				continue;
+			ERR(goto done);
+		}
+
+		if ( (rc == 0) && (waitpid(Orchestrator, NULL, WNOHANG) == \
+				   Orchestrator) ) {
+			fputs("Orchestrator exited.\n", stderr);
+			kill(-Orchestrator, SIGKILL);
+			Orchestrator = -1;
+			goto done;
+		}
+		if ( (rc == 0) && \
+		     ((now() - progress) / 1000000000ULL >= timeout) ) {
+			fprintf(stderr, "Orchestrator timed out, %s.\n", \
+				created ? "missing verdicts" :		 \
+				"no namespace created");
+			goto done;
+		}
+
+
+		/* Write the queued events. */
+		if ( poll_data[1].revents & POLLOUT ) {
+			amt = write(event_fd, output->get(output) + written, \
+				    output->size(output) - written);
+			if ( (amt < 0) && (errno != EAGAIN) )
+				ERR(goto done);
+			if ( amt > 0 ) {
+				written += amt;
+				progress = now();
+			}
+			if ( written == output->size(output) ) {
+				output->reset(output);
+				written = 0;
+			}
+		}
+
+
+		/* Process the verdicts. */
+		if ( poll_data[0].revents & POLLIN ) {
+			if ( (verdicts = read_commands(control_fd, input, \
+						       &created)) < 0 )
+				ERR(goto done);
+			outstanding -= verdicts;
+			progress = now();
+		}
+	}
+
+	if ( !Stop )
+		retn = true;
+
+
+ done:
+	*elapsed = start ? now() - start : 0;
+
+	if ( control_fd != -1 )
+		close(control_fd);
+	if ( event_fd != -1 )
+		close(event_fd);
+
+	WHACK(input);
+	WHACK(output);
+
+	return retn;
+}
+
+
+/*
+ * Program entry point begins here.
+ */
+
+extern int main(int argc, char *argv[])
+
+{
+	char *root	 = NULL,
+	     *backend	 = NULL,
+	     *trajectory = NULL,
+	     *verdicts	 = NULL;
+
+	int opt,
+	    retn = 1;
+
+	unsigned long int rate	= 0,
+			  count = 0;
+
+	unsigned int timeout = 10;
+
+	uint64_t elapsed;
+
+	String str = NULL;
+
+
+	while ( (opt = getopt(argc, argv, "R:T:b:n:r:t:v:w:")) != EOF )
+		switch ( opt ) {
+			case 'R':
+				rate = strtoul(optarg, NULL, 0);
+				break;
+			case 'T':
+				timeout = strtoul(optarg, NULL, 0);
+				break;
+
+			case 'b':
+				backend = optarg;
+				break;
+			case 'n':
+				count = strtoul(optarg, NULL, 0);
+				break;
+			case 'r':
+				root = optarg;
+				break;
+			case 't':
+				trajectory = optarg;
+				break;
+			case 'v':
+				verdicts = optarg;
+				break;
+			case 'w':
+				Task_count = strtoul(optarg, NULL, 0);
+				break;
+		}
+
+	if ( trajectory == NULL ) {
+		fputs("No trajectory specified.\n", stderr);
+		goto done;
+	}
+	if ( optind == argc ) {
+		fputs("No orchestrator specified.\n", stderr);
+		goto done;
+	}
+	if ( Task_count == 0 ) {
+		fputs("Invalid number of tasks.\n", stderr);
+		goto done;
+	}
+	if ( backend == NULL )
+		backend = basename(argv[optind]);
+
+	signal(SIGINT, signal_handler);
+	signal(SIGTERM, signal_handler);
+	signal(SIGPIPE, SIG_IGN);
+
+
+	/* Load the trajectory. */
+	INIT(HurdLib, Buffer, Text, ERR(goto done));
+	INIT(HurdLib, Buffer, Events, ERR(goto done));
+	if ( !load_trajectory(trajectory) )
+		goto done;
+	if ( count == 0 )
+		count = Events->size(Events) / sizeof(struct replay_event);
+
+	if ( (Tasks = calloc(Task_count, sizeof(struct replay_task))) == NULL )
+		ERR(goto done);
+
+	INIT(NAAAIM, EventStats, Stats, ERR(goto done));
+	Stats->enable(Stats, true);
+
+	if ( verdicts != NULL ) {
+		if ( (Verdicts = fopen(verdicts, "w")) == NULL ) {
+			fputs("Cannot open verdict file.\n", stderr);
+			goto done;
+		}
+	}
+
+
+	/* Run the orchestrator against the replayed trajectory. */
+	if ( !setup_directory(root) ) {
+		fputs("Cannot create TSEM directory.\n", stderr);
+		goto done;
+	}
+
+	if ( (Orchestrator = start_orchestrator(&argv[optind])) == -1 ) {
+		fputs("Cannot start orchestrator.\n", stderr);
+		goto done;
+	}
+
+	if ( !replay(count, rate, timeout, &elapsed) )
+		goto done;
+
+
+	/* Output the results. */
+	INIT(HurdLib, String, str, ERR(goto done));
+	if ( !Stats->dump(Stats, str) )
+		ERR(goto done);
+
+	fprintf(stdout, "backend=%s events=%lu tasks=%u rate=%lu " \
+		"seconds=%.3f throughput=%.0f\n", backend, count,   \
+		Task_count, rate, elapsed / 1e9,		    \
+		elapsed ? count / (elapsed / 1e9) : 0.0);
+	fputs(str->get(str), stdout);
+	retn = 0;
+
+
+ done:
+	if ( Orchestrator > 0 )
+		stop_orchestrator(Orchestrator);
+	if ( Root[0] != '\0' )
+		remove_directory(root == NULL);
+
+	if ( Verdicts != NULL )
+		fclose(Verdicts);
+	free(Tasks);
+
+	WHACK(Text);
+	WHACK(Events);
+	WHACK(Stats);
+	WHACK(str);
+
+	return retn;
+}
@@ -75,6 +75,7 @@
 #include "quixote.h"
 #include "sancho-cmd.h"
 
+#include <EventLoop.h>
 #include <TSEMcontrol.h>
 #include <TSEMevent.h>
 
@@ -1548,9 +1549,7 @@ static _Bool setup_namespace(int *fdptr, _Bool enforce)
 	}
 
 	/* Create the pathname to the event update file. */
-	memset(fname, '\0', sizeof(fname));
-	if ( snprintf(fname, sizeof(fname), TSEM_UPDATE_FILE, \
-		      (long long int) id) >= sizeof(fname) )
+	if ( !Control->update_file(Control, id, fname, sizeof(fname)) )
 		ERR(goto done);
 	if ( Debug )
 		fprintf(Debug, "Update file: %s\n", fname);
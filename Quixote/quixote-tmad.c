@@ -0,0 +1,2387 @@
+/** \file
+ *
+ * This file implements a daemon that models a collection of userspace
+ * disciplined security namespaces from a single process.  Each
+ * namespace runs a software 'cartridge' that is launched by the daemon
+ * in an independent measurement domain.  The daemon monitors the
+ * following file for each of the namespaces:
+ *
+ * /sys/kernel/security/tsem/external_tma/NNNNNNNNNN
+ *
+ * Where NNNNNNNNNN is the id number of the security event modeling
+ * domain.
+ *
+ * A single epoll based event loop monitors the event files of all of
+ * the namespaces.  A namespace with pending security events is handed
+ * to a pool of worker threads that parse and model the events and
+ * release the processes that generated them.  The events of a
+ * namespace are only processed by one worker at a time so the events
+ * are modeled in the order they were generated while the events of
+ * different namespaces are modeled in parallel.
+ *
+ * Each namespace has its own security model.  A compiled security
+ * model, as generated by the sign-model utility, is mapped once and
+ * shared by the models of all of the namespaces.
+ *
+ * The namespaces are managed through a single UNIX domain socket
+ * in the following location:
+ *
+ * /var/lib/Quixote/mgmt/tmad
+ *
+ * The quixote-console utility selects the namespace that a command
+ * is directed to with the -n option.  The 'show namespaces' command
+ * reports the event rate and the memory held by the security model of
+ * each namespace and the 'start NAME' command launches an additional
+ * cartridge.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+#define READ_SIDE  0
+#define WRITE_SIDE 1
+
+#define _GNU_SOURCE
+
+/* Number of epoll events retrieved per cycle. */
+#define TMAD_MAX_EVENTS 64
+
+/* Maximum number of worker threads. */
+#define TMAD_MAX_WORKERS 64
+
+/* Amount of event data read from a namespace per dispatch. */
+#define TMAD_READ_LIMIT 65536
+
+/*
+ * Approximate memory retained by a security model for each event
+ * description, in addition to the description itself, and for each
+ * security state point.
+ */
+#define TMAD_EVENT_COST 1024
+#define TMAD_POINT_COST 128
+
+
+/* Include files. */
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/capability.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/epoll.h>
+#include <fcntl.h>
+#include <pthread.h>
+
+#include <HurdLib.h>
+#include <Buffer.h>
+#include <String.h>
+#include <File.h>
+
+#include "quixote.h"
+#include "sancho-cmd.h"
+
+#include "NAAAIM.h"
+#include "LocalDuct.h"
+#include "ModelCache.h"
+
+#include "SecurityPoint.h"
+#include "SecurityEvent.h"
+#include "TSEM.h"
+#include "EventLoop.h"
+#include "TSEMcontrol.h"
+#include "TSEMevent.h"
+#include "tsem_model.h"
+
+
+/**
+ * The following structure holds the state of each security namespace
+ * that is being modeled by the daemon.
+ */
+typedef struct tma_namespace {
+	/* The name of the cartridge and the process running it. */
+	char *name;
+	pid_t pid;
+
+	/* The id of the namespace and the event file descriptor. */
+	uint64_t id;
+	int fd;
+
+	_Bool sealed;
+	_Bool model_error;
+	_Bool exited;
+
+	/* The security model of the namespace and its controller. */
+	TSEM model;
+	TSEMcontrol control;
+	TSEMevent event;
+	Buffer aggregate;
+
+	/* Objects used to hold the security events read from the kernel. */
+	Buffer input;
+	String update;
+
+	/* Statistics for the namespace. */
+	unsigned long int events;
+	unsigned long int last_events;
+	double rate;
+	size_t memory;
+
+	/* Lock serializing access to the model of the namespace. */
+	pthread_mutex_t lock;
+
+	/* Worker pool state, protected by the lock of the pool. */
+	_Bool queued;
+	_Bool busy;
+	struct tma_namespace *next_ready;
+
+	struct tma_namespace *next;
+} * TMAnamespace;
+
+
+/**
+ * Variable used to indicate that debugging is enabled and to provide
+ * the filehandle to be used for debugging.
+ */
+static FILE *Debug = NULL;
+
+/**
+ * The list of namespaces being modeled.  The list is only modified
+ * by the thread running the event loop.
+ */
+static TMAnamespace Namespaces = NULL;
+
+/**
+ * The epoll instance that monitors the event files and the management
+ * socket.
+ */
+static int Epoll = -1;
+
+/**
+ * A flag to indicate whether or not the security model is to
+ * be enforced.
+ */
+static _Bool Enforce = false;
+
+/**
+ * This variable is used to control whether the security event
+ * descriptions are to reference the initial user namespace or
+ * the current user namespace that the process is running in.
+ */
+static _Bool Current_Namespace = false;
+
+/**
+ * The name of the hash function to be used for the namespaces.
+ */
+static char *Digest = NULL;
+
+/**
+ * The size of the atomic magazine to be allocated for a namespace.
+ */
+static unsigned long Magazine_Size = 0;
+
+/**
+ * The alternate TSEM model that is to be used.
+ */
+static char *TSEM_model = NULL;
+
+/**
+ * The security model that each namespace is initialized with.
+ */
+static char *Model_file = NULL;
+
+/**
+ * The cache of verified security models.
+ */
+static ModelCache Cache = NULL;
+
+/**
+ * The read-only mapping of a compiled security model that is shared
+ * by all of the namespaces.
+ */
+static void *Model_map = NULL;
+static size_t Model_map_size = 0;
+
+/**
+ * The following variable holds booleans which describe signals
+ * which were received.
+ */
+struct {
+	_Bool stop;
+	_Bool sigchild;
+} Signals;
+
+/**
+ * The pool of worker threads and the queue of namespaces that have
+ * security events ready to be processed.
+ */
+static struct {
+	pthread_mutex_t lock;
+	pthread_cond_t ready;
+
+	_Bool stopping;
+	unsigned int workers;
+	pthread_t threads[TMAD_MAX_WORKERS];
+
+	TMAnamespace head;
+	TMAnamespace tail;
+} Pool = {
+	.lock  = PTHREAD_MUTEX_INITIALIZER,
+	.ready = PTHREAD_COND_INITIALIZER
+};
+
+
+/**
+ * Private function.
+ *
+ * This function implements the signal handler for the utility.  It
+ * sets the signal type in the Signals structure.
+ *
+ * \param signal	The number of the signal which caused the
+ *			handler to execute.
+ */
+
+void signal_handler(int signal, siginfo_t *siginfo, void *private)
+
+{
+	switch ( signal ) {
+		case SIGINT:
+		case SIGTERM:
+		case SIGHUP:
+		case SIGQUIT:
+			Signals.stop = true;
+			return;
+		case SIGCHLD:
+			Signals.sigchild = true;
+			return;
+	}
+
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function returns the number of seconds which have elapsed
+ * since the supplied starting time.
+ *
+ * \param start	A pointer to the structure containing the starting
+ *		time.
+ *
+ * \return	The number of elapsed seconds.
+ */
+
+static double elapsed(const struct timespec *start)
+
+{
+	struct timespec end;
+
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) + \
+		(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function is responsible for shutting down the workload of
+ * a namespace.
+ *
+ * \param name		A pointer to the null-terminated buffer
+ *			containing the name of the cartridge.
+ *
+ * \param wait		A boolean flag used to indicate whether or
+ *			not the termination of the runc kill process
+ *			should be waited for.
+ *
+ * \return	No return value is defined.
+ */
+
+static void kill_cartridge(CO(char *, name), const _Bool wait)
+
+{
+	int status;
+
+	pid_t kill_process;
+
+
+	kill_process = fork();
+	if ( kill_process == -1 )
+		return;
+
+	/* Child process - execute runc in kill mode. */
+	if ( kill_process == 0 ) {
+		execlp("runc", "runc", "kill", name, "SIGKILL", NULL);
+		_exit(1);
+	}
+
+	/* Parent process - wait for the kill process to complete. */
+	if ( wait )
+		waitpid(kill_process, &status, 0);
+
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function sets up the UNIX domain management socket.
+ *
+ * \param mgmt		The object that will be used to handle management
+ *			requests.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not setup of the management socket was
+ *			successful.  A true value indicates the setup
+ *			was successful while a false value indicates the
+ *			setup failed.
+ */
+
+static _Bool setup_management(CO(LocalDuct, mgmt))
+
+{
+	_Bool rc,
+	      retn = false;
+
+	mode_t mask;
+
+
+	/* Initialize socket server mode. */
+	if ( !mgmt->init_server(mgmt) ) {
+		fputs("Cannot set management server mode.\n", stderr);
+		goto done;
+	}
+
+	/* Create socket in designated path. */
+	if ( Debug )
+		fprintf(Debug, "Opening management socket: %s\n", \
+			QUIXOTE_TMAD_MGMT);
+
+	mask = umask(0x2);
+	rc = mgmt->init_port(mgmt, QUIXOTE_TMAD_MGMT);
+	umask(mask);
+
+	if ( !rc ) {
+		fprintf(stderr, "Cannot initialize socket: %s.\n", \
+			QUIXOTE_TMAD_MGMT);
+		goto done;
+	}
+
+	retn = true;
+
+
+ done:
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function carries out the addition of a security state event
+ * to the security model of a namespace.
+ *
+ * \param ns		The namespace that generated the event.
+ *
+ * \param update	The object containing the event description
+ *			to be processed.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not addition of the event succeeded.  A
+ *			false value indicates the addition failed while
+ *			a true value indicates the addition succeeded.
+ */
+
+static _Bool add_event(CO(TMAnamespace, ns), CO(String, update))
+
+{
+	_Bool hit = false,
+	      status,
+	      discipline,
+	      sealed,
+	      retn = false;
+
+	pid_t pid;
+
+	SecurityEvent event = NULL;
+
+
+	/* Register a recurring event from the event cache. */
+	if ( !ns->model_error ) {
+		if ( !ns->model->cached_update(ns->model, update, &hit, \
+					       &status, &discipline, &sealed) )
+			ERR(goto done);
+	}
+
+	if ( !hit ) {
+		/* Parse the event. */
+		if ( !ns->model->new_event(ns->model, &event) )
+			ERR(goto done);
+		if ( !event->parse(event, update) )
+			ERR(goto done);
+
+
+		/*
+		 * If this is a model error release the actor so the
+		 * runc instance can release the domain.
+		 */
+		if ( ns->model_error ) {
+			if ( !event->get_pid(event, &pid) )
+				ERR(goto done);
+			if ( !ns->control->release(ns->control, pid) ) {
+				fprintf(stderr, "[%s]: Bad actor release " \
+					"error: %d:%s\n", ns->name, errno, \
+					strerror(errno));
+			}
+			else
+				retn = true;
+
+			goto done;
+		}
+
+
+		/* Proceed with modeling the event. */
+		if ( !ns->model->update(ns->model, event, &status, \
+					&discipline, &sealed) )
+			ERR(goto done);
+	}
+
+	ns->model->discipline_pid(ns->model, &pid);
+
+	if ( Debug )
+		fprintf(Debug, "%s: Model update: cached=%d, status=%d, " \
+			"discipline=%d\n", ns->name, hit, status, discipline);
+
+
+	/* Release the process as a good or bad actor. */
+	if ( sealed && discipline ) {
+		if ( !ns->control->discipline(ns->control, pid) ) {
+			fprintf(stderr, "[%s]: Bad actor release error: " \
+				"%d:%s\n", ns->name, errno, strerror(errno));
+			goto done;
+		}
+	} else {
+		if ( !ns->control->release(ns->control, pid) ) {
+			fprintf(stderr, "[%s]: Good actor release error: " \
+				"%d:%s\n", ns->name, errno, strerror(errno));
+			goto done;
+		}
+	}
+
+	retn = true;
+
+
+ done:
+	ns->model->release_event(ns->model, event);
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function handles the receipt of an asynchronous security event
+ * from a namespace.
+ *
+ * \param ns		The namespace that generated the event.
+ *
+ * \param update	The object containing the event description
+ *			to be processed.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not addition of the event succeeded.  A
+ *			false value indicates the addition failed while
+ *			a true value indicates the addition succeeded.
+ */
+
+static _Bool add_async_event(CO(TMAnamespace, ns), CO(String, update))
+
+{
+	_Bool hit = false,
+	      status,
+	      violation,
+	      sealed,
+	      retn = false;
+
+	SecurityEvent event = NULL;
+
+
+	if ( ns->model_error )
+		goto done;
+
+
+	/* Register a recurring event from the event cache. */
+	if ( !ns->model->cached_update(ns->model, update, &hit, &status, \
+				       &violation, &sealed) )
+		ERR(goto done);
+
+	if ( !hit ) {
+		/* Parse the event and proceed with modeling it. */
+		if ( !ns->model->new_event(ns->model, &event) )
+			ERR(goto done);
+		if ( !event->parse(event, update) )
+			ERR(goto done);
+
+		if ( !ns->model->update(ns->model, event, &status, \
+					&violation, &sealed) )
+			ERR(goto done);
+	}
+
+	if ( Debug )
+		fprintf(Debug, "%s: Model update: cached=%d, status=%d, " \
+			"violation=%d\n", ns->name, hit, status, violation);
+
+
+	/* Handle a sealed model that is in violation. */
+	if ( sealed && violation && Enforce ) {
+		fprintf(stderr, "[%s]: Security violation in atomic " \
+			"context, shutting down workload.\n", ns->name);
+		kill_cartridge(ns->name, false);
+	}
+
+	retn = true;
+
+
+ done:
+	ns->model->release_event(ns->model, event);
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function carries out the addition of the hardware aggregate
+ * measurement to the security model of a namespace.
+ *
+ * \param ns	The namespace that generated the event.
+ *
+ * \return	A boolean value is returned to indicate whether or
+ *		addition of the aggregate value succeeded.  A false
+ *		value indicates the addition failed while a true
+ *		value indicates the addition succeeded.
+ */
+
+static _Bool add_aggregate(CO(TMAnamespace, ns))
+
+{
+	_Bool retn = false;
+
+	String str = ns->update;
+
+
+	str->reset(str);
+	if ( !ns->event->get_text(ns->event, "value", str) )
+		ERR(goto done);
+
+	if ( ns->aggregate == NULL ) {
+		INIT(HurdLib, Buffer, ns->aggregate, ERR(goto done));
+		if ( !ns->aggregate->add_hexstring(ns->aggregate, \
+						   str->get(str)) )
+			ERR(goto done);
+	}
+
+	if ( !ns->model->set_aggregate(ns->model, ns->aggregate) )
+		ERR(goto done);
+
+	retn = true;
+
+
+ done:
+	return retn;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function returns the number of event descriptions that are
+ * retained by the security model of a namespace.
+ *
+ * \param ns	The namespace whose model is to be queried.
+ *
+ * \return	The number of events held in the trajectory, forensics
+ *		and TSEM event lists of the model.
+ */
+
+static size_t _retained_events(CO(TMAnamespace, ns))
+
+{
+	TSEM model = ns->model;
+
+
+	return model->trajectory_size(model) + \
+		model->forensics_size(model) + model->TSEM_events_size(model);
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function charges a namespace for the growth of its security
+ * model caused by the event that was just processed.  Each event
+ * retained by the model is charged the size of its description plus
+ * an allowance for the parsed representation of the event, each new
+ * security state point is charged a fixed amount.
+ *
+ * \param ns		The namespace which processed the event.
+ *
+ * \param events	The number of events retained by the model
+ *			before the event was processed.
+ *
+ * \param points	The number of security state points in the
+ *			model before the event was processed.
+ */
+
+static void _charge_namespace(CO(TMAnamespace, ns), const size_t events, \
+			      const size_t points)
+
+{
+	size_t added;
+
+
+	if ( (added = _retained_events(ns)) > events )
+		ns->memory += (added - events) * \
+			(ns->update->size(ns->update) + TMAD_EVENT_COST);
+	if ( (added = ns->model->points_size(ns->model)) > points )
+		ns->memory += (added - points) * TMAD_POINT_COST;
+
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function is responsible for the processing of a security
+ * event generated by the kernel for a namespace.  The event
+ * description is held in the update object of the namespace.
+ *
+ * \param ns	The namespace that generated the event.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		processing of the event was successful.  A false value
+ *		indicates a failure in event processing while a true
+ *		value indicates that event processing has succeeded.
+ */
+
+static _Bool process_event(CO(TMAnamespace, ns))
+
+{
+	_Bool retn = false;
+
+	size_t events,
+	       points;
+
+
+	/* Note the size of the model so the event can be charged. */
+	events = _retained_events(ns);
+	points = ns->model->points_size(ns->model);
+
+	if ( Debug )
+		fprintf(Debug, "%s: Processing event: '%s'\n", ns->name, \
+			ns->update->get(ns->update));
+
+	/* Dispatch the event. */
+	ns->event->reset(ns->event);
+	if ( !ns->event->set_event(ns->event, ns->update) )
+		ERR(goto done);
+
+	switch ( ns->event->extract_export(ns->event) ) {
+		case TSEM_EVENT_AGGREGATE:
+			retn = add_aggregate(ns);
+			break;
+
+		case TSEM_EVENT_EVENT:
+			retn = add_event(ns, ns->update);
+			break;
+
+		case TSEM_EVENT_ASYNC_EVENT:
+			retn = add_async_event(ns, ns->update);
+			break;
+
+		case TSEM_EVENT_LOG:
+			retn = ns->model->add_TSEM_event(ns->model, \
+							 ns->update);
+			break;
+
+		default:
+			ERR(goto done);
+	}
+
+	++ns->events;
+
+
+ done:
+	_charge_namespace(ns, events, points);
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function reads and models the security events that are
+ * pending for a namespace.  It is called by a worker thread with
+ * the lock of the namespace held.  The amount of event data read
+ * is limited so that a namespace with a large number of events
+ * is placed back on the ready queue behind the other namespaces.
+ *
+ * \param ns	The namespace whose events are to be processed.
+ *
+ * \return	No return value is defined.
+ */
+
+static void process_namespace(CO(TMAnamespace, ns))
+
+{
+	char *start,
+	     *end,
+	     bufr[2048];
+
+	ssize_t rc;
+
+	size_t used = 0,
+	       size;
+
+
+	if ( ns->fd == -1 )
+		return;
+
+	/* Read the event descriptions that are available. */
+	while ( ns->input->size(ns->input) < TMAD_READ_LIMIT ) {
+		rc = read(ns->fd, bufr, sizeof(bufr));
+		if ( rc == 0 )
+			break;
+		if ( rc < 0 ) {
+			if ( (errno == ENODATA) || (errno == EAGAIN) )
+				break;
+			if ( errno == EINTR )
+				continue;
+			fprintf(stderr, "[%s]: Fatal event read.\n", ns->name);
+			ns->model_error = true;
+			kill_cartridge(ns->name, false);
+			return;
+		}
+		if ( !ns->input->add(ns->input, (unsigned char *) bufr, rc) )
+			ERR(return);
+		lseek(ns->fd, 0, SEEK_SET);
+	}
+
+
+	/* Model each complete event description. */
+	start = (char *) ns->input->get(ns->input);
+	size  = ns->input->size(ns->input);
+
+	while ( (end = memchr(start + used, '\n', size - used)) != NULL ) {
+		*end = '\0';
+		ns->update->reset(ns->update);
+		if ( !ns->update->add(ns->update, start + used) )
+			ERR(return);
+		used = end - start + 1;
+
+		if ( !process_event(ns) && !ns->model_error ) {
+			fprintf(stderr, "[%s]: Event processing error, " \
+				"shutting down workload.\n", ns->name);
+			ns->model_error = true;
+			kill_cartridge(ns->name, false);
+		}
+	}
+
+	if ( used > 0 ) {
+		memmove(start, start + used, size - used);
+		ns->input->shrink(ns->input, used);
+	}
+
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function implements the worker threads.  Each worker removes
+ * namespaces from the ready queue and processes their events until
+ * the pool is stopped and the queue is empty.  The event file of the
+ * namespace is re-armed in the event loop after its events have been
+ * processed.
+ *
+ * \param arg	An unused pointer.
+ *
+ * \return	A NULL value is returned.
+ */
+
+static void * _worker(void *arg)
+
+{
+	TMAnamespace ns;
+
+	struct epoll_event event;
+
+
+	while ( true ) {
+		pthread_mutex_lock(&Pool.lock);
+		while ( (Pool.head == NULL) && !Pool.stopping )
+			pthread_cond_wait(&Pool.ready, &Pool.lock);
+		if ( Pool.head == NULL ) {
+			pthread_mutex_unlock(&Pool.lock);
+			break;
+		}
+
+		ns = Pool.head;
+		if ( (Pool.head = ns->next_ready) == NULL )
+			Pool.tail = NULL;
+		ns->queued = false;
+		ns->busy   = true;
+		pthread_mutex_unlock(&Pool.lock);
+
+		pthread_mutex_lock(&ns->lock);
+		process_namespace(ns);
+
+		if ( ns->fd != -1 ) {
+			memset(&event, '\0', sizeof(event));
+			event.events   = EPOLLIN | EPOLLONESHOT;
+			event.data.ptr = ns;
+			epoll_ctl(Epoll, EPOLL_CTL_MOD, ns->fd, &event);
+		}
+		pthread_mutex_unlock(&ns->lock);
+
+		pthread_mutex_lock(&Pool.lock);
+		ns->busy = false;
+		pthread_mutex_unlock(&Pool.lock);
+	}
+
+	return NULL;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function places a namespace with pending security events on
+ * the ready queue of the worker pool.
+ *
+ * \param ns	The namespace to be queued.
+ *
+ * \return	No return value is defined.
+ */
+
+static void dispatch(CO(TMAnamespace, ns))
+
+{
+	pthread_mutex_lock(&Pool.lock);
+	if ( !ns->queued ) {
+		ns->queued     = true;
+		ns->next_ready = NULL;
+		if ( Pool.tail == NULL )
+			Pool.head = ns;
+		else
+			Pool.tail->next_ready = ns;
+		Pool.tail = ns;
+		pthread_cond_signal(&Pool.ready);
+	}
+	pthread_mutex_unlock(&Pool.lock);
+
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function starts the worker threads.  Signals are blocked in
+ * the workers so that they are delivered to the event loop.
+ *
+ * \param workers	The number of worker threads to start.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the workers were started.
+ */
+
+static _Bool start_workers(const unsigned int workers)
+
+{
+	_Bool retn = false;
+
+	sigset_t blocked,
+		 saved;
+
+
+	sigfillset(&blocked);
+	if ( pthread_sigmask(SIG_BLOCK, &blocked, &saved) != 0 )
+		ERR(goto done);
+
+	for (Pool.workers= 0; Pool.workers < workers; ++Pool.workers) {
+		if ( pthread_create(&Pool.threads[Pool.workers], NULL, \
+				    _worker, NULL) != 0 )
+			break;
+	}
+
+	pthread_sigmask(SIG_SETMASK, &saved, NULL);
+	if ( Pool.workers == workers )
+		retn = true;
+
+
+ done:
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function stops the worker threads after the namespaces that
+ * are on the ready queue have been processed.
+ *
+ * \return	No return value is defined.
+ */
+
+static void stop_workers(void)
+
+{
+	unsigned int lp;
+
+
+	pthread_mutex_lock(&Pool.lock);
+	Pool.stopping = true;
+	pthread_cond_broadcast(&Pool.ready);
+	pthread_mutex_unlock(&Pool.lock);
+
+	for (lp= 0; lp < Pool.workers; ++lp)
+		pthread_join(Pool.threads[lp], NULL);
+	Pool.workers = 0;
+
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function maps the security model that the namespaces are
+ * initialized with if it is a compiled model.  The model is mapped
+ * once, read-only and private, and the mapping is referenced by the
+ * models of all of the namespaces.  Each namespace verifies the
+ * model as it is attached to the mapping, a private mapping ensures
+ * the model is only replaced, by sign-model renaming a new file over
+ * it, rather than rewritten underneath the namespaces.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		an error was encountered.  A true value is returned if
+ *		the model is not a compiled model.
+ */
+
+static _Bool map_model(void)
+
+{
+	_Bool retn = false;
+
+	char magic[sizeof(TSEM_MODEL_MAGIC) - 1];
+
+	int fd = -1;
+
+	struct stat statbuf;
+
+
+	if ( (fd = open(Model_file, O_RDONLY)) == -1 )
+		ERR(goto done);
+	if ( fstat(fd, &statbuf) == -1 )
+		ERR(goto done);
+
+	if ( (statbuf.st_size < sizeof(struct tsem_model)) || \
+	     (pread(fd, magic, sizeof(magic), 0) != sizeof(magic)) || \
+	     (memcmp(magic, TSEM_MODEL_MAGIC, sizeof(magic)) != 0) ) {
+		retn = true;
+		goto done;
+	}
+
+	Model_map = mmap(NULL, statbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if ( Model_map == MAP_FAILED ) {
+		Model_map = NULL;
+		ERR(goto done);
+	}
+	Model_map_size = statbuf.st_size;
+
+	if ( Debug )
+		fprintf(Debug, "Mapped compiled model: %s\n", Model_file);
+	retn = true;
+
+
+ done:
+	if ( fd != -1 )
+		close(fd);
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function initializes the security model of a namespace from
+ * the shared compiled model or from the security model file.
+ *
+ * \param ns	The namespace whose model is to be initialized.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the model was loaded.  A false value indicates the load
+ *		of the model failed while a true value indicates the
+ *		model was successfully loaded.
+ */
+
+static _Bool load_model(CO(TMAnamespace, ns))
+
+{
+	_Bool retn = false;
+
+	String str = NULL;
+
+	File model = NULL;
+
+
+	if ( Cache != NULL )
+		ns->model->set_model_cache(ns->model, Cache);
+
+	if ( Model_map != NULL ) {
+		if ( !ns->model->map_model(ns->model, Model_map, \
+					   Model_map_size, &ns->sealed) )
+			ERR(goto done);
+		retn = true;
+		goto done;
+	}
+
+
+	/* Loop over the mapfile. */
+	INIT(HurdLib, String, str, ERR(goto done));
+
+	INIT(HurdLib, File, model, ERR(goto done));
+	if ( !model->open_ro(model, Model_file) )
+		ERR(goto done);
+
+	while ( model->read_String(model, str) ) {
+		if ( strcmp(str->get(str), "seal") == 0 )
+			ns->sealed = true;
+
+		if ( !ns->model->load(ns->model, str) )
+			ERR(goto done);
+		str->reset(str);
+	}
+
+	retn = true;
+
+
+ done:
+	ns->model->set_model_cache(ns->model, NULL);
+
+	WHACK(str);
+	WHACK(model);
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function releases the resources held by a namespace.
+ *
+ * \param ns	The namespace to be released.
+ *
+ * \return	No return value is defined.
+ */
+
+static void whack_namespace(CO(TMAnamespace, ns))
+
+{
+	if ( ns->fd != -1 ) {
+		epoll_ctl(Epoll, EPOLL_CTL_DEL, ns->fd, NULL);
+		close(ns->fd);
+	}
+
+	WHACK(ns->model);
+	WHACK(ns->control);
+	WHACK(ns->event);
+	WHACK(ns->aggregate);
+	WHACK(ns->input);
+	WHACK(ns->update);
+
+	pthread_mutex_destroy(&ns->lock);
+	free(ns->name);
+	free(ns);
+
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function launches a software cartridge in a new security
+ * namespace and adds the event file of the namespace to the event
+ * loop.  The subordinate process creates the namespace, returns the
+ * id of the namespace over a pipe and then executes the cartridge.
+ *
+ * \param name	A pointer to the null-terminated buffer containing
+ *		the name of the cartridge to be run.
+ *
+ * \return	A boolean value is returned to reflect the status of
+ *		the launch.  A false value indicates an error was
+ *		encountered while a true value indicates the cartridge
+ *		was successfully launched.
+ */
+
+static _Bool start_namespace(CO(char *, name))
+
+{
+	_Bool retn = false;
+
+	char fname[PATH_MAX];
+
+	int id_pipe[2] = {-1, -1};
+
+	uint64_t id;
+
+	enum TSEMcontrol_ns_config nsref = 0;
+
+	struct epoll_event event;
+
+	TMAnamespace ns;
+
+	String bundle = NULL;
+
+
+	/* Verify the cartridge is not already being modeled. */
+	for (ns= Namespaces; ns != NULL; ns= ns->next) {
+		if ( !ns->exited && (strcmp(ns->name, name) == 0) ) {
+			fprintf(stderr, "Cartridge already running: %s\n", \
+				name);
+			return false;
+		}
+	}
+
+
+	/* Initialize the namespace and its security model. */
+	if ( (ns = calloc(1, sizeof(struct tma_namespace))) == NULL )
+		ERR(return false);
+	ns->fd = -1;
+	pthread_mutex_init(&ns->lock, NULL);
+
+	if ( (ns->name = strdup(name)) == NULL )
+		ERR(goto done);
+
+	INIT(NAAAIM, TSEM, ns->model, ERR(goto done));
+	INIT(NAAAIM, TSEMevent, ns->event, ERR(goto done));
+	INIT(HurdLib, Buffer, ns->input, ERR(goto done));
+	INIT(HurdLib, String, ns->update, ERR(goto done));
+
+	INIT(NAAAIM, TSEMcontrol, ns->control, ERR(goto done));
+	if ( !ns->control->generate_key(ns->control) )
+		ERR(goto done);
+
+	if ( (Model_file != NULL) && !load_model(ns) ) {
+		fprintf(stderr, "Cannot initialize security model for: %s\n", \
+			name);
+		goto done;
+	}
+
+	INIT(HurdLib, String, bundle, ERR(goto done));
+	bundle->add(bundle, QUIXOTE_MAGAZINE);
+	bundle->add(bundle, "/");
+	if ( !bundle->add(bundle, name) )
+		ERR(goto done);
+
+
+	/* Create the cartridge process. */
+	if ( pipe2(id_pipe, O_CLOEXEC) == -1 )
+		ERR(goto done);
+
+	ns->pid = fork();
+	if ( ns->pid == -1 )
+		ERR(goto done);
+
+	/* Child process - create the namespace and run the cartridge. */
+	if ( ns->pid == 0 ) {
+		close(id_pipe[READ_SIDE]);
+
+		if ( Current_Namespace )
+			nsref = TSEMcontrol_CURRENT_NS;
+		if ( !ns->control->create_ns(ns->control,		   \
+					     TSEMcontrol_TYPE_EXTERNAL,   \
+					     TSEM_model, Digest, nsref,	   \
+					     Magazine_Size) )
+			_exit(1);
+		if ( !ns->control->id(ns->control, &id) )
+			_exit(1);
+		if ( Enforce && !ns->control->enforce(ns->control) )
+			_exit(1);
+		if ( ns->sealed && !ns->control->seal(ns->control) )
+			_exit(1);
+
+		if ( write(id_pipe[WRITE_SIDE], &id, sizeof(id)) != \
+		     sizeof(id) )
+			_exit(1);
+		close(id_pipe[WRITE_SIDE]);
+
+		/* Drop the ability to modify the trust state. */
+		if ( cap_drop_bound(CAP_MAC_ADMIN) != 0 )
+			_exit(1);
+
+		execlp("runc", "runc", "run", "-b", bundle->get(bundle), \
+		       name, NULL);
+		fputs("Cartridge execution failed.\n", stderr);
+		_exit(1);
+	}
+
+
+	/* Parent process - add the event file to the event loop. */
+	close(id_pipe[WRITE_SIDE]);
+	id_pipe[WRITE_SIDE] = -1;
+
+	if ( read(id_pipe[READ_SIDE], &id, sizeof(id)) != sizeof(id) ) {
+		fprintf(stderr, "Cannot create namespace for: %s\n", name);
+		waitpid(ns->pid, NULL, 0);
+		goto done;
+	}
+	ns->id = id;
+
+	if ( !ns->control->update_file(ns->control, id, fname, \
+				       sizeof(fname)) )
+		ERR(goto done);
+	if ( Debug )
+		fprintf(Debug, "%s: pid=%d, update file: %s\n", name, \
+			ns->pid, fname);
+
+	if ( (ns->fd = open(fname, O_RDONLY | O_NONBLOCK | O_CLOEXEC)) < 0 )
+		ERR(goto done);
+
+	memset(&event, '\0', sizeof(event));
+	event.events   = EPOLLIN | EPOLLONESHOT;
+	event.data.ptr = ns;
+	if ( epoll_ctl(Epoll, EPOLL_CTL_ADD, ns->fd, &event) == -1 )
+		ERR(goto done);
+
+	ns->next   = Namespaces;
+	Namespaces = ns;
+	retn = true;
+
+
+ done:
+	if ( id_pipe[READ_SIDE] != -1 )
+		close(id_pipe[READ_SIDE]);
+	if ( id_pipe[WRITE_SIDE] != -1 )
+		close(id_pipe[WRITE_SIDE]);
+
+	if ( !retn ) {
+		if ( ns->pid > 0 )
+			kill_cartridge(name, false);
+		whack_namespace(ns);
+	}
+	WHACK(bundle);
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function collects the status of the cartridge processes
+ * which have terminated and removes the event files of their
+ * namespaces from the event loop.
+ *
+ * \return	No return value is defined.
+ */
+
+static void reap_namespaces(void)
+
+{
+	pid_t pid;
+
+	TMAnamespace ns;
+
+
+	while ( (pid = waitpid(-1, NULL, WNOHANG)) > 0 ) {
+		for (ns= Namespaces; ns != NULL; ns= ns->next) {
+			if ( !ns->exited && (ns->pid == pid) )
+				break;
+		}
+		if ( ns == NULL )
+			continue;
+
+		pthread_mutex_lock(&ns->lock);
+		if ( ns->fd != -1 ) {
+			epoll_ctl(Epoll, EPOLL_CTL_DEL, ns->fd, NULL);
+			close(ns->fd);
+			ns->fd = -1;
+		}
+		ns->exited = true;
+
+		fprintf(stdout, "%s: exited, events=%lu, memory=%zu KB\n", \
+			ns->name, ns->events, ns->memory / 1024);
+		pthread_mutex_unlock(&ns->lock);
+	}
+
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function updates the event rate of each namespace and releases
+ * the namespaces whose cartridges have terminated once they are no
+ * longer referenced by the worker pool.
+ *
+ * \param interval	The number of seconds since the statistics were
+ *			last updated.
+ *
+ * \return		No return value is defined.
+ */
+
+static void update_statistics(const double interval)
+
+{
+	_Bool idle;
+
+	TMAnamespace ns,
+		     *prev = &Namespaces;
+
+
+	while ( (ns = *prev) != NULL ) {
+		if ( ns->exited ) {
+			pthread_mutex_lock(&Pool.lock);
+			idle = !ns->queued && !ns->busy;
+			pthread_mutex_unlock(&Pool.lock);
+
+			if ( idle ) {
+				*prev = ns->next;
+				whack_namespace(ns);
+				continue;
+			}
+		}
+
+		pthread_mutex_lock(&ns->lock);
+		ns->rate = (ns->events - ns->last_events) / interval;
+		ns->last_events = ns->events;
+		pthread_mutex_unlock(&ns->lock);
+
+		prev = &ns->next;
+	}
+
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function is responsible for returning the current security event
+ * trajectory list of a namespace to the caller.  The protocol used is
+ * to send the number of elements in the list followed by each point as
+ * an ASCII string.
+ *
+ * \param model		The security model of the namespace.
+ *
+ * \param mgmt		The socket object used to communicate with
+ *			the quixote-console management instance.
+ *
+ * \param cmdbufr	The object which will be used to hold the
+ *			information which will be transmitted.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the command was processed.
+ */
+
+static _Bool send_trajectory(CO(TSEM, model), CO(LocalDuct, mgmt), \
+			     CO(Buffer, cmdbufr))
+
+{
+	_Bool retn = false;
+
+	size_t lp,
+	       cnt = 0;
+
+	SecurityEvent event;
+
+	String es = NULL;
+
+
+	cnt = model->trajectory_size(model);
+
+	cmdbufr->reset(cmdbufr);
+	cmdbufr->add(cmdbufr, (unsigned char *) &cnt, sizeof(cnt));
+	if ( !mgmt->send_Buffer(mgmt, cmdbufr) )
+		ERR(goto done);
+
+
+	/* Send each trajectory point. */
+	INIT(HurdLib, String, es, ERR(goto done));
+
+	model->rewind_event(model);
+
+	for (lp= 0; lp < cnt; ++lp ) {
+		if ( !model->get_event(model, &event) )
+			ERR(goto done);
+		if ( event == NULL )
+			continue;
+		if ( !event->format(event, es) )
+			ERR(goto done);
+
+		cmdbufr->reset(cmdbufr);
+		cmdbufr->add(cmdbufr, (unsigned char *) es->get(es), \
+			     es->size(es) + 1);
+		if ( !mgmt->send_Buffer(mgmt, cmdbufr) )
+			ERR(goto done);
+		es->reset(es);
+	}
+
+	retn = true;
+
+ done:
+	WHACK(es);
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function is responsible for returning the population counts for
+ * the security state coefficients of a namespace.
+ *
+ * \param model		The security model of the namespace.
+ *
+ * \param mgmt		The socket object used to communicate with
+ *			the quixote-console management instance.
+ *
+ * \param cmdbufr	The object which will be used to hold the
+ *			information that will be transmitted.
+ *
+ * \param type		A flag used to indicate what type of counts
+ *			are to be set.  A true value indicates that
+ *			the counts of valid points are to be returned
+ *			while a false value indicates that invalid
+ *			points are to be returned.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the command was processed.
+ */
+
+static _Bool send_trajectory_counts(CO(TSEM, model), CO(LocalDuct, mgmt), \
+				    CO(Buffer, cmdbufr), const _Bool type)
+
+{
+	_Bool retn = false;
+
+	char bufr[21];
+
+	size_t lp,
+	       cnt = 0;
+
+	SecurityPoint cp = NULL;
+
+
+	if ( type ) {
+		cnt = model->points_size(model);
+		cnt -= model->forensics_size(model);
+	}
+	else
+		cnt = model->forensics_size(model);
+
+	cmdbufr->reset(cmdbufr);
+	cmdbufr->add(cmdbufr, (unsigned char *) &cnt, sizeof(cnt));
+	if ( !mgmt->send_Buffer(mgmt, cmdbufr) )
+		ERR(goto done);
+
+
+	/* Send the count of each point. */
+	model->rewind_points(model);
+
+	for (lp= 0; lp < model->points_size(model); ++lp ) {
+		if ( !model->get_point(model, &cp) )
+			ERR(goto done);
+		if ( cp == NULL )
+			continue;
+		if ( cp->is_valid(cp) != type )
+			continue;
+
+		snprintf(bufr, sizeof(bufr), "%lu", cp->get_count(cp));
+
+		cmdbufr->reset(cmdbufr);
+		cmdbufr->add(cmdbufr, (unsigned char *) bufr, sizeof(bufr));
+		if ( !mgmt->send_Buffer(mgmt, cmdbufr) )
+			ERR(goto done);
+	}
+
+	retn = true;
+
+ done:
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function is responsible for returning the forensics list of a
+ * namespace to the caller.  The protocol used is to send the number
+ * of elements in the list followed by each event in the forensics
+ * path as an ASCII string.
+ *
+ * \param model		The security model of the namespace.
+ *
+ * \param mgmt		The socket object used to communicate with
+ *			the the quixote-console management instance.
+ *
+ * \param cmdbufr	The object which will be used to hold the
+ *			information which will be transmitted.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the command was processed.
+ */
+
+static _Bool send_forensics(CO(TSEM, model), CO(LocalDuct, mgmt), \
+			    CO(Buffer, cmdbufr))
+
+{
+	_Bool retn = false;
+
+	size_t lp,
+	       cnt = 0;
+
+	SecurityEvent event;
+
+	String es = NULL;
+
+
+	cnt = model->forensics_size(model);
+
+	cmdbufr->reset(cmdbufr);
+	cmdbufr->add(cmdbufr, (unsigned char *) &cnt, sizeof(cnt));
+	if ( !mgmt->send_Buffer(mgmt, cmdbufr) )
+		ERR(goto done);
+
+
+	/* Send each forensics event. */
+	INIT(HurdLib, String, es, ERR(goto done));
+
+	model->rewind_forensics(model);
+
+	for (lp= 0; lp < cnt; ++lp ) {
+		if ( !model->get_forensics(model, &event) )
+			ERR(goto done);
+		if ( event == NULL )
+			continue;
+		if ( !event->format(event, es) )
+			ERR(goto done);
+		if ( es->size(es) == 0 ) {
+			if ( !es->add(es, "Unknown event.") )
+				ERR(goto done);
+		}
+
+		cmdbufr->reset(cmdbufr);
+		cmdbufr->add(cmdbufr, (unsigned char *) es->get(es), \
+			     es->size(es) + 1);
+		if ( !mgmt->send_Buffer(mgmt, cmdbufr) )
+			ERR(goto done);
+		es->reset(es);
+	}
+
+	retn = true;
+
+ done:
+	WHACK(es);
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function is responsible for returning the security state
+ * coefficients of a namespace to the caller.  The protocol used is to
+ * send the number of elements in the map followed by each state in the
+ * model as a hexadecimal ASCII string.
+ *
+ * \param model		The security model of the namespace.
+ *
+ * \param mgmt		The socket object used to communicate with
+ *			the quixote-console management instance.
+ *
+ * \param cmdbufr	The object which will be used to hold the
+ *			information which will be transmitted.
+ *
+ * \param type		A boolean variable used to indicate which
+ *			security state coefficients are to be returned.
+ *			A true value sends valid coefficients while
+ *			a false value sends invalid coefficients.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the command was processed.
+ */
+
+static _Bool send_trajectory_coefficients(CO(TSEM, model), \
+					  CO(LocalDuct, mgmt), \
+					  CO(Buffer, cmdbufr), \
+					  const _Bool type)
+
+{
+	_Bool retn = false;
+
+	uint8_t *p,
+		 pi;
+
+	char point[NAAAIM_IDSIZE * 2 + 1];
+
+	size_t lp,
+	       cnt = 0;
+
+	SecurityPoint cp = NULL;
+
+
+	if ( type ) {
+		cnt = model->points_size(model);
+		cnt -= model->forensics_size(model);
+	}
+	else
+		cnt = model->forensics_size(model);
+
+	cmdbufr->reset(cmdbufr);
+	cmdbufr->add(cmdbufr, (unsigned char *) &cnt, sizeof(cnt));
+	if ( !mgmt->send_Buffer(mgmt, cmdbufr) )
+		ERR(goto done);
+
+
+	/* Send each security state point. */
+	model->rewind_points(model);
+
+	for (lp= 0; lp < model->points_size(model); ++lp ) {
+		if ( !model->get_point(model, &cp) )
+			ERR(goto done);
+		if ( cp == NULL )
+			continue;
+		if ( cp->is_valid(cp) != type )
+			continue;
+
+		memset(point, '\0', sizeof(point));
+		p = cp->get(cp);
+		for (pi= 0; pi < NAAAIM_IDSIZE; ++pi)
+			snprintf(&point[pi*2], 3, "%02x", *p++);
+
+		cmdbufr->reset(cmdbufr);
+		cmdbufr->add(cmdbufr, (unsigned char *) point, sizeof(point));
+		if ( !mgmt->send_Buffer(mgmt, cmdbufr) )
+			ERR(goto done);
+	}
+
+	retn = true;
+
+ done:
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function is responsible for returning the security event
+ * descriptions that were logged by a namespace.
+ *
+ * \param model		The security model of the namespace.
+ *
+ * \param mgmt		The socket object used to communicate with
+ *			the quixote-console management instance.
+ *
+ * \param cmdbufr	The object which will be used to hold the
+ *			information which will be transmitted.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the command was processed.
+ */
+
+static _Bool send_events(CO(TSEM, model), CO(LocalDuct, mgmt), \
+			 CO(Buffer, cmdbufr))
+
+{
+	_Bool retn = false;
+
+	size_t lp,
+	       cnt = 0;
+
+	String event = NULL;
+
+
+	cnt = model->TSEM_events_size(model);
+
+	cmdbufr->reset(cmdbufr);
+	cmdbufr->add(cmdbufr, (unsigned char *) &cnt, sizeof(cnt));
+	if ( !mgmt->send_Buffer(mgmt, cmdbufr) )
+		ERR(goto done);
+
+
+	/* Send each event. */
+	model->TSEM_rewind_event(model);
+
+	for (lp= 0; lp < cnt; ++lp) {
+		if ( !model->get_TSEM_event(model, &event) )
+			ERR(goto done);
+		if ( event == NULL )
+			continue;
+
+		cmdbufr->reset(cmdbufr);
+		cmdbufr->add(cmdbufr, (unsigned char *) event->get(event), \
+			     event->size(event) + 1);
+		if ( !mgmt->send_Buffer(mgmt, cmdbufr) )
+			ERR(goto done);
+	}
+
+	retn = true;
+
+
+ done:
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function is responsible for returning a description of each
+ * namespace being modeled.  The protocol used is to send the number
+ * of lines in the description followed by each line as an ASCII
+ * string.
+ *
+ * \param mgmt		The socket object used to communicate with
+ *			the quixote-console management instance.
+ *
+ * \param cmdbufr	The object which will be used to hold the
+ *			information which will be transmitted.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the command was processed.
+ */
+
+static _Bool send_namespaces(CO(LocalDuct, mgmt), CO(Buffer, cmdbufr))
+
+{
+	_Bool retn = false;
+
+	size_t cnt = 1;
+
+	double rate = 0;
+
+	TMAnamespace ns;
+
+	String str = NULL;
+
+
+	for (ns= Namespaces; ns != NULL; ns= ns->next) {
+		rate += ns->rate;
+		++cnt;
+	}
+
+	cmdbufr->reset(cmdbufr);
+	cmdbufr->add(cmdbufr, (unsigned char *) &cnt, sizeof(cnt));
+	if ( !mgmt->send_Buffer(mgmt, cmdbufr) )
+		ERR(goto done);
+
+
+	/* Send the daemon summary followed by each namespace. */
+	INIT(HurdLib, String, str, ERR(goto done));
+
+	str->add_sprintf(str, "namespaces=%zu, workers=%u, rate=%.1f/sec, " \
+			 "shared model=%zu KB", cnt - 1, Pool.workers, rate, \
+			 Model_map_size / 1024);
+
+	for (ns= Namespaces; ns != NULL; ns= ns->next) {
+		cmdbufr->reset(cmdbufr);
+		cmdbufr->add(cmdbufr, (unsigned char *) str->get(str), \
+			     str->size(str) + 1);
+		if ( !mgmt->send_Buffer(mgmt, cmdbufr) )
+			ERR(goto done);
+
+		str->reset(str);
+		pthread_mutex_lock(&ns->lock);
+		str->add_sprintf(str, "%s: id=%llu, pid=%d, events=%lu, " \
+				 "rate=%.1f/sec, memory=%zu KB%s%s%s",	  \
+				 ns->name, (long long unsigned int) ns->id, \
+				 ns->pid, ns->events, ns->rate,		  \
+				 ns->memory / 1024,			  \
+				 ns->sealed ? ", sealed" : "",		  \
+				 ns->model_error ? ", error" : "",	  \
+				 ns->exited ? ", exited" : "");
+		pthread_mutex_unlock(&ns->lock);
+	}
+
+	cmdbufr->reset(cmdbufr);
+	cmdbufr->add(cmdbufr, (unsigned char *) str->get(str), \
+		     str->size(str) + 1);
+	if ( !mgmt->send_Buffer(mgmt, cmdbufr) )
+		ERR(goto done);
+
+	retn = true;
+
+
+ done:
+	WHACK(str);
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function sends the status of a management command.
+ *
+ * \param mgmt		The socket object used to communicate with
+ *			the quixote-console management instance.
+ *
+ * \param cmdbufr	The object which will be used to hold the
+ *			status which will be transmitted.
+ *
+ * \param status	A pointer to the null-terminated buffer
+ *			containing the status.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the status was sent.
+ */
+
+static _Bool send_status(CO(LocalDuct, mgmt), CO(Buffer, cmdbufr), \
+			 CO(char *, status))
+
+{
+	cmdbufr->reset(cmdbufr);
+	if ( !cmdbufr->add(cmdbufr, (unsigned char *) status, \
+			   strlen(status) + 1) )
+		return false;
+	return mgmt->send_Buffer(mgmt, cmdbufr);
+}
+
+
+/**
+ * Private function.
+ *
+ * This function implements the processing of a command for a
+ * namespace.  It is called with the lock of the namespace held.
+ *
+ * \param ns		The namespace the command is directed to.
+ *
+ * \param mgmt		The socket object used to communicate with
+ *			the quixote-console management instance.
+ *
+ * \param cmdbufr	The object which will be used to hold the
+ *			information which will be transmitted.
+ *
+ * \param cmd		The command to be processed.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the command was processed.
+ */
+
+static _Bool namespace_command(CO(TMAnamespace, ns), CO(LocalDuct, mgmt), \
+			       CO(Buffer, cmdbufr), const int cmd)
+
+{
+	_Bool retn = false;
+
+	static unsigned char ok[] = "OK";
+
+	TSEM model = ns->model;
+
+
+	switch ( cmd ) {
+		case show_measurement:
+			cmdbufr->reset(cmdbufr);
+			if ( !model->get_measurement(model, cmdbufr) )
+				ERR(goto done);
+			retn = mgmt->send_Buffer(mgmt, cmdbufr);
+			break;
+
+		case show_state:
+			cmdbufr->reset(cmdbufr);
+			if ( !model->get_state(model, cmdbufr) )
+				ERR(goto done);
+			retn = mgmt->send_Buffer(mgmt, cmdbufr);
+			break;
+
+		case show_trajectory:
+			retn = send_trajectory(model, mgmt, cmdbufr);
+			break;
+
+		case show_coefficients:
+			retn = send_trajectory_coefficients(model, mgmt, \
+							    cmdbufr, true);
+			break;
+
+		case show_counts:
+			retn = send_trajectory_counts(model, mgmt, cmdbufr, \
+						      true);
+			break;
+
+		case show_forensics:
+			retn = send_forensics(model, mgmt, cmdbufr);
+			break;
+
+		case show_forensics_coefficients:
+			retn = send_trajectory_coefficients(model, mgmt, \
+							    cmdbufr, false);
+			break;
+
+		case show_forensics_counts:
+			retn = send_trajectory_counts(model, mgmt, cmdbufr, \
+						      false);
+			break;
+
+		case show_events:
+			retn = send_events(model, mgmt, cmdbufr);
+			break;
+
+		case show_map:
+			cmdbufr->reset(cmdbufr);
+			if ( ns->aggregate != NULL )
+				cmdbufr->add_Buffer(cmdbufr, ns->aggregate);
+			if ( !mgmt->send_Buffer(mgmt, cmdbufr) )
+				ERR(goto done);
+			retn = send_trajectory_coefficients(model, mgmt, \
+							    cmdbufr, true);
+			break;
+
+		case seal_event:
+			model->seal(model);
+
+			cmdbufr->reset(cmdbufr);
+			if ( !cmdbufr->add(cmdbufr, ok, sizeof(ok)) )
+				ERR(goto done);
+			retn = mgmt->send_Buffer(mgmt, cmdbufr);
+			break;
+	}
+
+
+ done:
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function implements the processing of a command from the
+ * quixote-console utility.  A command consists of the command number
+ * followed by the null-terminated name of the namespace that the
+ * command is directed to, or the cartridge to be started.  Commands
+ * directed to a namespace are answered with a status string followed,
+ * if the status is OK, by the response to the command.
+ *
+ * \param mgmt		The socket object used to communicate with
+ *			the security domain management instance.
+ *
+ * \param cmdbufr	The object containing the command to be
+ *			processed.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the command was processed.  A false value
+ *			indicates the management connection should be
+ *			closed.
+ */
+
+static _Bool process_command(CO(LocalDuct, mgmt), CO(Buffer, cmdbufr))
+
+{
+	_Bool retn = false;
+
+	char *name = NULL;
+
+	int cmd;
+
+	TMAnamespace ns;
+
+	String str = NULL;
+
+
+	if ( cmdbufr->size(cmdbufr) < sizeof(int) )
+		ERR(goto done);
+	cmd = *(int *) cmdbufr->get(cmdbufr);
+
+	INIT(HurdLib, String, str, ERR(goto done));
+	if ( cmdbufr->size(cmdbufr) > sizeof(int) ) {
+		if ( cmdbufr->get(cmdbufr)[cmdbufr->size(cmdbufr) - 1] != '\0' )
+			ERR(goto done);
+		if ( !str->add(str, (char *) cmdbufr->get(cmdbufr) + \
+			       sizeof(int)) )
+			ERR(goto done);
+		name = str->get(str);
+	}
+
+
+	/* Commands directed to the daemon. */
+	if ( cmd == show_namespaces ) {
+		retn = send_namespaces(mgmt, cmdbufr);
+		goto done;
+	}
+
+	if ( cmd == start_cartridge ) {
+		if ( (name == NULL) || !start_namespace(name) ) {
+			retn = send_status(mgmt, cmdbufr, \
+					   "Cannot start cartridge.");
+			goto done;
+		}
+		retn = send_status(mgmt, cmdbufr, "OK");
+		goto done;
+	}
+
+
+	/* Commands directed to a namespace. */
+	switch ( cmd ) {
+		case show_measurement:
+		case show_state:
+		case show_trajectory:
+		case show_coefficients:
+		case show_counts:
+		case show_forensics:
+		case show_forensics_coefficients:
+		case show_forensics_counts:
+		case show_events:
+		case show_map:
+		case seal_event:
+			break;
+
+		default:
+			retn = send_status(mgmt, cmdbufr, \
+					   "Unsupported command.");
+			goto done;
+	}
+
+	for (ns= Namespaces; ns != NULL; ns= ns->next) {
+		if ( (name != NULL) && !ns->exited && \
+		     (strcmp(ns->name, name) == 0) )
+			break;
+	}
+	if ( ns == NULL ) {
+		retn = send_status(mgmt, cmdbufr, "Unknown namespace.");
+		goto done;
+	}
+
+	if ( !send_status(mgmt, cmdbufr, "OK") )
+		ERR(goto done);
+
+	pthread_mutex_lock(&ns->lock);
+	retn = namespace_command(ns, mgmt, cmdbufr, cmd);
+	pthread_mutex_unlock(&ns->lock);
+
+
+ done:
+	WHACK(str);
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function implements the event loop of the daemon.  The loop
+ * monitors the event files of the namespaces and the management
+ * socket, hands namespaces with pending events to the worker pool
+ * and updates the statistics of the namespaces once a second.
+ *
+ * \param mgmt		The object that will be used to receive management
+ *			requests.
+ *
+ * \return		A boolean value is used to indicate the status
+ *			of the event loop.  A true value indicates the
+ *			daemon was terminated while a false value
+ *			indicates an error occurred.
+ */
+
+static _Bool event_loop(CO(LocalDuct, mgmt))
+
+{
+	_Bool retn	= false,
+	      connected = false;
+
+	int rc,
+	    lp,
+	    mgmt_fd;
+
+	double interval;
+
+	struct timespec last;
+
+	struct epoll_event event,
+			   events[TMAD_MAX_EVENTS];
+
+	Buffer cmdbufr = NULL;
+
+
+	INIT(HurdLib, Buffer, cmdbufr, ERR(goto done));
+
+	if ( !mgmt->get_socket(mgmt, &mgmt_fd) )
+		ERR(goto done);
+	memset(&event, '\0', sizeof(event));
+	event.events   = EPOLLIN;
+	event.data.ptr = NULL;
+	if ( epoll_ctl(Epoll, EPOLL_CTL_ADD, mgmt_fd, &event) == -1 )
+		ERR(goto done);
+
+	clock_gettime(CLOCK_MONOTONIC, &last);
+
+
+	/* Dispatch loop. */
+	while ( true ) {
+		rc = epoll_wait(Epoll, events, TMAD_MAX_EVENTS, 1000);
+		if ( (rc < 0) && (errno != EINTR) )
+			ERR(goto done);
+
+		if ( Signals.stop ) {
+			if ( Debug )
+				fputs("Daemon terminated.\n", Debug);
+			retn = true;
+			goto done;
+		}
+
+		if ( Signals.sigchild ) {
+			Signals.sigchild = false;
+			reap_namespaces();
+		}
+
+		for (lp= 0; lp < rc; ++lp) {
+			if ( events[lp].data.ptr != NULL ) {
+				dispatch(events[lp].data.ptr);
+				continue;
+			}
+
+			/* Process management requests. */
+			if ( !connected ) {
+				if ( !mgmt->accept_connection(mgmt) )
+					ERR(goto done);
+				epoll_ctl(Epoll, EPOLL_CTL_DEL, mgmt_fd, NULL);
+				if ( !mgmt->get_fd(mgmt, &mgmt_fd) )
+					ERR(goto done);
+				if ( epoll_ctl(Epoll, EPOLL_CTL_ADD, mgmt_fd, \
+					       &event) == -1 )
+					ERR(goto done);
+				connected = true;
+				continue;
+			}
+
+			cmdbufr->reset(cmdbufr);
+			if ( mgmt->receive_Buffer(mgmt, cmdbufr) && \
+			     !mgmt->eof(mgmt) ) {
+				if ( process_command(mgmt, cmdbufr) )
+					continue;
+				fputs("Management command error.\n", stderr);
+			}
+
+			if ( Debug )
+				fputs("Terminating management.\n", Debug);
+			epoll_ctl(Epoll, EPOLL_CTL_DEL, mgmt_fd, NULL);
+			mgmt->reset(mgmt);
+			if ( !mgmt->get_socket(mgmt, &mgmt_fd) )
+				ERR(goto done);
+			if ( epoll_ctl(Epoll, EPOLL_CTL_ADD, mgmt_fd, \
+				       &event) == -1 )
+				ERR(goto done);
+			connected = false;
+		}
+
+		if ( (interval = elapsed(&last)) >= 1.0 ) {
+			update_statistics(interval);
+			clock_gettime(CLOCK_MONOTONIC, &last);
+		}
+	}
+
+
+ done:
+	WHACK(cmdbufr);
+
+	return retn;
+}
+
+
+/*
+ * Program entry point begins here.
+ */
+
+extern int main(int argc, char *argv[])
+
+{
+	char *debug	    = NULL,
+	     *magazine_size = NULL;
+
+	int opt,
+	    retn = 1;
+
+	long int workers = sysconf(_SC_NPROCESSORS_ONLN);
+
+	struct sigaction signal_action;
+
+	TMAnamespace ns;
+
+	LocalDuct mgmt = NULL;
+
+
+	while ( (opt = getopt(argc, argv, "euM:d:h:m:n:w:")) != EOF )
+		switch ( opt ) {
+			case 'e':
+				Enforce = true;
+				break;
+			case 'u':
+				Current_Namespace = true;
+				break;
+
+			case 'M':
+				TSEM_model = optarg;
+				break;
+
+			case 'd':
+				debug = optarg;
+				break;
+			case 'h':
+				Digest = optarg;
+				break;
+			case 'm':
+				Model_file = optarg;
+				break;
+			case 'n':
+				magazine_size = optarg;
+				break;
+			case 'w':
+				workers = strtol(optarg, NULL, 0);
+				break;
+		}
+
+	if ( (workers < 1) || (workers > TMAD_MAX_WORKERS) ) {
+		fprintf(stderr, "Number of workers must be between 1 and " \
+			"%d.\n", TMAD_MAX_WORKERS);
+		goto done;
+	}
+
+	/* Handle a debug invocation. */
+	if ( debug ) {
+		if ( (Debug = fopen(debug, "w+")) == NULL ) {
+			fputs("Cannot open debug file.\n", stderr);
+			goto done;
+		}
+		setlinebuf(Debug);
+	}
+
+	/* Verify the magazine size if specified. */
+	if ( magazine_size != NULL ) {
+		Magazine_Size = strtoul(magazine_size, NULL, 0);
+		if ( (errno == EINVAL) || (errno == ERANGE) ) {
+			fputs("Invalid magazine size.\n", stderr);
+			goto done;
+		}
+	}
+
+	/* Setup signal handlers. */
+	if ( sigemptyset(&signal_action.sa_mask) == -1 )
+		ERR(goto done);
+
+	signal_action.sa_flags = SA_SIGINFO | SA_NODEFER | SA_RESTART;
+	signal_action.sa_sigaction = signal_handler;
+	if ( sigaction(SIGINT, &signal_action, NULL) == -1 )
+		goto done;
+	if ( sigaction(SIGTERM, &signal_action, NULL) == -1 )
+		goto done;
+	if ( sigaction(SIGHUP, &signal_action, NULL) == -1 )
+		goto done;
+	if ( sigaction(SIGQUIT, &signal_action, NULL) == -1 )
+		goto done;
+	if ( sigaction(SIGCHLD, &signal_action, NULL) == -1 )
+		goto done;
+
+
+	/* Map a shared compiled model and open the verified model cache. */
+	if ( Model_file != NULL ) {
+		INIT(NAAAIM, ModelCache, Cache, ERR(goto done));
+		if ( !Cache->open(Cache, QUIXOTE_MODEL_CACHE) ) {
+			if ( Debug )
+				fputs("Model cache not available.\n", Debug);
+			WHACK(Cache);
+		}
+
+		if ( !map_model() ) {
+			fputs("Cannot map security model.\n", stderr);
+			goto done;
+		}
+	}
+
+
+	/* Setup the event loop, worker pool and management socket. */
+	if ( (Epoll = epoll_create1(EPOLL_CLOEXEC)) == -1 )
+		ERR(goto done);
+
+	if ( !start_workers(workers) ) {
+		fputs("Cannot start worker threads.\n", stderr);
+		goto done;
+	}
+
+	INIT(NAAAIM, LocalDuct, mgmt, ERR(goto done));
+	if ( !setup_management(mgmt) )
+		ERR(goto done);
+
+
+	/* Launch the cartridges specified on the command-line. */
+	while ( optind < argc ) {
+		if ( !start_namespace(argv[optind]) ) {
+			fprintf(stderr, "Cannot start cartridge: %s\n", \
+				argv[optind]);
+			goto done;
+		}
+		++optind;
+	}
+
+	if ( event_loop(mgmt) )
+		retn = 0;
+
+
+ done:
+	for (ns= Namespaces; ns != NULL; ns= ns->next) {
+		if ( !ns->exited )
+			kill_cartridge(ns->name, true);
+	}
+
+	if ( Pool.workers > 0 )
+		stop_workers();
+
+	while ( Namespaces != NULL ) {
+		ns = Namespaces;
+		Namespaces = ns->next;
+		whack_namespace(ns);
+	}
+
+	WHACK(mgmt);
+	WHACK(Cache);
+
+	if ( Model_map != NULL )
+		munmap(Model_map, Model_map_size);
+	if ( Epoll != -1 )
+		close(Epoll);
+
+	return retn;
+}
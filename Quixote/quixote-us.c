@@ -68,6 +68,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <pthread.h>
 #include <sys/socket.h>
@@ -86,12 +87,16 @@
 #include "TTYduct.h"
 #include "LocalDuct.h"
 #include "SHA256.h"
+#include "ModelCache.h"
 
 #include "SecurityPoint.h"
 #include "SecurityEvent.h"
 #include "TSEM.h"
+#include "EventLoop.h"
+#include "EventStats.h"
 #include "TSEMcontrol.h"
 #include "TSEMevent.h"
+#include "tsem_model.h"
 
 
 /**
@@ -180,11 +185,24 @@ static _Bool Enforce = false;
  */
 static char *TSEM_model = NULL;
 
+/**
+ * The read-only mapping of a compiled security model.
+ */
+static void *Model_map = NULL;
+static size_t Model_map_size = 0;
+
 /**
  * Object used to manage invocation of a specific command in execute mode.
  */
 static Process Execute = NULL;
 
+/**
+ * The object used to collect the event processing statistics and the
+ * time at which the current batch of events arrived.
+ */
+static EventStats Stats = NULL;
+static uint64_t Arrival = 0;
+
 /**
  * The following variable holds booleans which describe signals
  * which were received.
@@ -437,6 +455,88 @@ static _Bool setup_management(CO(LocalDuct, mgmt), const char *cartridge)
 }
 
 
+/**
+ * Private function.
+ *
+ * This function records the time spent in a stage of event processing.
+ *
+ * \param stage	The stage whose time is to be recorded.
+ *
+ * \param start	The time at which the stage started.  A value of
+ *		zero indicates statistics are not being collected.
+ *
+ * \return	The time at which the stage ended is returned, or zero
+ *		if statistics are not being collected.
+ */
+
+static uint64_t record_stage(const unsigned int stage, const uint64_t start)
+
+{
+	uint64_t now;
+
+
+	if ( start == 0 )
+		return 0;
+
+	now = Stats->now(Stats);
+	Stats->record(Stats, stage, now - start);
+	return now;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function records the statistics of a model update.  The time
+ * spent modeling the event excludes the time spent parsing it.
+ *
+ * \param hit		A flag indicating whether or not the event was
+ *			registered from the event cache.
+ *
+ * \param status	A flag indicating whether or not the event
+ *			added a point to the model.
+ *
+ * \param start		The time at which modeling of the event
+ *			started.
+ *
+ * \param parse		The time spent parsing the event.
+ *
+ * \return		The time at which the statistics were recorded
+ *			is returned, or zero if statistics are not being
+ *			collected.
+ */
+
+static uint64_t record_update(const _Bool hit, const _Bool status, \
+			      const uint64_t start, const uint64_t parse)
+
+{
+	uint64_t now,
+		 pseudonym,
+		 measure,
+		 lookup;
+
+
+	if ( start == 0 )
+		return 0;
+
+	now = Stats->now(Stats);
+	Stats->record(Stats, EVENTSTATS_MODEL, now - start - parse);
+
+	if ( hit )
+		Stats->increment(Stats, EVENTSTATS_CACHE_HITS);
+	else {
+		Model->get_timing(Model, &pseudonym, &measure, &lookup);
+		Stats->record(Stats, EVENTSTATS_PSEUDONYM, pseudonym);
+		Stats->record(Stats, EVENTSTATS_MEASURE, measure);
+		Stats->record(Stats, EVENTSTATS_LOOKUP, lookup);
+	}
+	if ( status )
+		Stats->increment(Stats, EVENTSTATS_NEW_POINTS);
+
+	return now;
+}
+
+
 /**
  * Private function.
  *
@@ -455,52 +555,73 @@ static _Bool setup_management(CO(LocalDuct, mgmt), const char *cartridge)
 static _Bool add_event(CO(String, update))
 
 {
-	_Bool status,
+	_Bool hit = false,
+	      status = false,
 	      discipline,
 	      sealed,
 	      retn = false;
 
 	pid_t pid;
 
+	uint64_t start,
+		 parse = 0;
+
 	SecurityEvent event = NULL;
 
 
-	/* Parse the event. */
-	INIT(NAAAIM, SecurityEvent, event, ERR(goto done));
-	if ( !event->parse(event, update) )
-		ERR(goto done);
+	/* Register a recurring event from the event cache. */
+	start = Stats->now(Stats);
+	if ( !Model_Error ) {
+		if ( !Model->cached_update(Model, update, &hit, &status, \
+					   &discipline, &sealed) )
+			ERR(goto done);
+	}
 
+	if ( !hit ) {
+		/* Parse the event. */
+		parse = Stats->now(Stats);
+		if ( !Model->new_event(Model, &event) )
+			ERR(goto done);
+		if ( !event->parse(event, update) )
+			ERR(goto done);
+		if ( parse != 0 )
+			parse = record_stage(EVENTSTATS_PARSE, parse) - parse;
 
-	/*
-	 * If this is a model error release the actor so the runc
-	 * instance can release the domain.
-	 */
-	if ( Model_Error ) {
-		if ( Debug )
-			fputs("Model error, releasing actor.\n", Debug);
 
-		if ( !event->get_pid(event, &pid) )
-			ERR(goto done);
-		if ( !Control->release(Control, pid) ) {
-			fprintf(stderr, "Bad actor release error: "  \
-				"%d:%s\n", errno, strerror(errno));
-		}
-		else
-			retn = true;
+		/*
+		 * If this is a model error release the actor so the
+		 * runc instance can release the domain.
+		 */
+		if ( Model_Error ) {
+			if ( Debug )
+				fputs("Model error, releasing actor.\n", \
+				      Debug);
 
-		goto done;
-	}
+			if ( !event->get_pid(event, &pid) )
+				ERR(goto done);
+			if ( !Control->release(Control, pid) ) {
+				fprintf(stderr, "Bad actor release error: " \
+					"%d:%s\n", errno, strerror(errno));
+			}
+			else
+				retn = true;
 
+			goto done;
+		}
 
-	/* Proceed with modeling the event. */
-	if ( !Model->update(Model, event, &status, &discipline, &sealed) )
-		ERR(goto done);
+
+		/* Proceed with modeling the event. */
+		if ( !Model->update(Model, event, &status, &discipline, \
+				    &sealed) )
+			ERR(goto done);
+	}
 
 	Model->discipline_pid(Model, &pid);
+	start = record_update(hit, status, start, parse);
 
 	if ( Debug )
-		fprintf(Debug, "Model update: status=%d, discipline=%d\n",
-			status, discipline);
+		fprintf(Debug, "Model update: cached=%d, status=%d, " \
+			"discipline=%d\n", hit, status, discipline);
 
 
 	/* Security domain is not being disciplined, release the process. */
@@ -540,12 +661,23 @@ static _Bool add_event(CO(String, update))
 		}
 	}
 
+	if ( start != 0 ) {
+		record_stage(EVENTSTATS_RELEASE, start);
+		record_stage(EVENTSTATS_TOTAL, Arrival);
+
+		if ( sealed && status )
+			Stats->increment(Stats, EVENTSTATS_FORENSICS);
+		if ( sealed && discipline )
+			Stats->increment(Stats, EVENTSTATS_DISCIPLINES);
+		else
+			Stats->increment(Stats, EVENTSTATS_RELEASES);
+	}
+
 	retn = true;
 
 
  done:
-	if ( !status )
-		WHACK(event);
+	Model->release_event(Model, event);
 
 	return retn;
 }
@@ -568,20 +700,19 @@ static _Bool add_event(CO(String, update))
 static _Bool add_async_event(CO(String, update))
 
 {
-	_Bool status,
+	_Bool hit = false,
+	      status = false,
 	      violation,
 	      sealed,
 	      retn = false;
 
 	pid_t pid;
 
-	SecurityEvent event = NULL;
+	uint64_t start,
+		 parse = 0;
 
+	SecurityEvent event = NULL;
 
-	/* Parse the event. */
-	INIT(NAAAIM, SecurityEvent, event, ERR(goto done));
-	if ( !event->parse(event, update) )
-		ERR(goto done);
 
 	/*
 	 * If this is a model error release the actor so the runc
@@ -594,15 +725,38 @@ static _Bool add_async_event(CO(String, update))
 	}
 
 
-	/* Proceed with modeling the event. */
-	if ( !Model->update(Model, event, &status, &violation, &sealed) )
+	/* Register a recurring event from the event cache. */
+	start = Stats->now(Stats);
+	if ( !Model->cached_update(Model, update, &hit, &status, &violation, \
+				   &sealed) )
 		ERR(goto done);
 
+	if ( !hit ) {
+		/* Parse the event and proceed with modeling it. */
+		parse = Stats->now(Stats);
+		if ( !Model->new_event(Model, &event) )
+			ERR(goto done);
+		if ( !event->parse(event, update) )
+			ERR(goto done);
+		if ( parse != 0 )
+			parse = record_stage(EVENTSTATS_PARSE, parse) - parse;
+
+		if ( !Model->update(Model, event, &status, &violation, \
+				    &sealed) )
+			ERR(goto done);
+	}
+
 	Model->discipline_pid(Model, &pid);
+	if ( record_update(hit, status, start, parse) != 0 ) {
+		Stats->increment(Stats, EVENTSTATS_ASYNC_EVENTS);
+		record_stage(EVENTSTATS_TOTAL, Arrival);
+		if ( sealed && status )
+			Stats->increment(Stats, EVENTSTATS_FORENSICS);
+	}
 
 	if ( Debug )
-		fprintf(Debug, "Model update: status=%d, violation=%d\n",
-			status, violation);
+		fprintf(Debug, "Model update: cached=%d, status=%d, " \
+			"violation=%d\n", hit, status, violation);
 
 
 	/* Handle a sealed model that is in violation. */
@@ -620,8 +774,7 @@ static _Bool add_async_event(CO(String, update))
 
 
  done:
-	if ( !status )
-		WHACK(event);
+	Model->release_event(Model, event);
 
 	return retn;
 }
@@ -741,6 +894,22 @@ static _Bool process_event()
 		ERR(goto done);
 
 	INIT(HurdLib, String, str, ERR(goto done));
+
+	if ( Stats->enabled(Stats) ) {
+		if ( (type == TSEM_EVENT_EVENT) || \
+		     (type == TSEM_EVENT_ASYNC_EVENT) ) {
+			Stats->increment(Stats, EVENTSTATS_EVENTS);
+			if ( !Event->get_text(Event, "type", str) )
+				ERR(goto done);
+			if ( !Stats->set_type(Stats, str->get(str)) )
+				ERR(goto done);
+			str->reset(str);
+		}
+		else
+			Stats->set_type(Stats, NULL);
+		record_stage(EVENTSTATS_QUEUE, Arrival);
+	}
+
 	if ( !str->add(str, Event->get_event(Event)) )
 		ERR(goto done);
 
@@ -1291,6 +1460,103 @@ static _Bool send_map(CO(LocalDuct, mgmt), CO(Buffer, cmdbufr))
 }
 
 
+/**
+ * Private function.
+ *
+ * This function is responsible for returning the event processing
+ * statistics to the caller.  The protocol used is to send the number
+ * of lines in the description of the statistics followed by each
+ * line as an ASCII string.
+ *
+ * \param mgmt		The socket object used to communicate with
+ *			the quixote-console management instance.
+ *
+ * \param cmdbufr	The object which will be used to hold the
+ *			information which will be transmitted.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the command was processed.  A false value
+ *			indicates the processing of commands should be
+ *			terminated while a true value indicates an
+ *			additional command cycle should be processed.
+ */
+
+static _Bool send_stats(CO(LocalDuct, mgmt), CO(Buffer, cmdbufr))
+
+{
+	_Bool retn = false;
+
+	char *p,
+	     *line;
+
+	unsigned int cnt = 0;
+
+	String str = NULL;
+
+
+	/* Generate the statistics and count the lines. */
+	INIT(HurdLib, String, str, ERR(goto done));
+	if ( !Stats->dump(Stats, str) )
+		ERR(goto done);
+
+	for (p= str->get(str); *p != '\0'; ++p) {
+		if ( *p == '\n' )
+			++cnt;
+	}
+
+	cmdbufr->reset(cmdbufr);
+	cmdbufr->add(cmdbufr, (unsigned char *) &cnt, sizeof(cnt));
+	if ( !mgmt->send_Buffer(mgmt, cmdbufr) )
+		ERR(goto done);
+	if ( Debug )
+		fprintf(Debug, "Sent statistics size: %u\n", cnt);
+
+
+	/* Send each line. */
+	for (line= str->get(str); cnt > 0; --cnt) {
+		p = strchr(line, '\n');
+		*p = '\0';
+
+		cmdbufr->reset(cmdbufr);
+		if ( !cmdbufr->add(cmdbufr, (unsigned char *) line, \
+				   strlen(line) + 1) )
+			ERR(goto done);
+		if ( !mgmt->send_Buffer(mgmt, cmdbufr) )
+			ERR(goto done);
+		line = p + 1;
+	}
+
+	retn = true;
+
+
+ done:
+	WHACK(str);
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function enables or disables the collection of the event
+ * processing statistics.
+ *
+ * \param enable	A flag indicating whether or not statistics are
+ *			to be collected.
+ */
+
+static void enable_statistics(const _Bool enable)
+
+{
+	Stats->enable(Stats, enable);
+	Model->enable_timing(Model, enable);
+	Arrival = 0;
+
+	return;
+}
+
+
 /**
  * Private function.
  *
@@ -1389,10 +1655,105 @@ static _Bool process_command(CO(LocalDuct, mgmt), CO(Buffer, cmdbufr))
 
 			retn = true;
 			break;
+
+		case show_stats:
+			retn = send_stats(mgmt, cmdbufr);
+			break;
+
+		case enable_stats:
+		case disable_stats:
+			enable_statistics(*cp == enable_stats);
+
+			cmdbufr->reset(cmdbufr);
+			if ( !cmdbufr->add(cmdbufr, ok, sizeof(ok)) )
+				ERR(goto done);
+			if ( !mgmt->send_Buffer(mgmt, cmdbufr) )
+				ERR(goto done);
+
+			retn = true;
+			break;
+	}
+
+
+ done:
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function maps a compiled security model into the process and
+ * initializes the security model from it.  The model is mapped
+ * read-only and private so that the mapping cannot be written through
+ * after it has been verified, the unmodified pages of the model are
+ * still shared through the page cache by all of the instances which
+ * use the model.  The sign-model utility replaces a compiled model by
+ * renaming a new file over it so a mapped model is not rewritten.
+ *
+ * \param model_file	The name of the file containing the security
+ *			model.
+ *
+ * \param mapped	A pointer to a boolean value that will be set
+ *			to indicate whether or not the file contained
+ *			a compiled model.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not an error was encountered.  A false value
+ *			indicates the compiled model could not be
+ *			mapped or was not valid.
+ */
+
+static _Bool map_model(CO(char *, model_file), _Bool *mapped)
+
+{
+	_Bool retn = false;
+
+	char magic[sizeof(TSEM_MODEL_MAGIC) - 1];
+
+	int fd = -1;
+
+	struct stat statbuf;
+
+
+	/* Verify the file contains a compiled model. */
+	*mapped = false;
+
+	if ( (fd = open(model_file, O_RDONLY)) == -1 )
+		ERR(goto done);
+	if ( fstat(fd, &statbuf) == -1 )
+		ERR(goto done);
+
+	if ( (statbuf.st_size < sizeof(struct tsem_model)) || \
+	     (pread(fd, magic, sizeof(magic), 0) != sizeof(magic)) || \
+	     (memcmp(magic, TSEM_MODEL_MAGIC, sizeof(magic)) != 0) ) {
+		retn = true;
+		goto done;
 	}
 
 
+	/* Map the model and initialize the security model with it. */
+	Model_map = mmap(NULL, statbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if ( Model_map == MAP_FAILED ) {
+		Model_map = NULL;
+		ERR(goto done);
+	}
+	Model_map_size = statbuf.st_size;
+
+	if ( !Model->map_model(Model, Model_map, Model_map_size, &Sealed) )
+		ERR(goto done);
+
+	if ( Debug )
+		fprintf(Debug, "Mapped compiled model: %s\n", model_file);
+
+	*mapped = true;
+	retn	= true;
+
+
  done:
+	if ( fd != -1 )
+		close(fd);
+
 	return retn;
 }
 
@@ -1401,7 +1762,8 @@ static _Bool process_command(CO(LocalDuct, mgmt), CO(Buffer, cmdbufr))
  * Private function.
  *
  * This function implements the initialization of a security model from
- * a file.
+ * a file.  A file containing a compiled model is mapped rather than
+ * loaded.
  *
  * \param model_file	The name of the file containing the security
  *			model.
@@ -1416,12 +1778,32 @@ static _Bool process_command(CO(LocalDuct, mgmt), CO(Buffer, cmdbufr))
 static _Bool load_model(char *model_file)
 
 {
-	_Bool retn = false;
+	_Bool retn = false,
+	      mapped;
 
 	String str = NULL;
 
 	File model = NULL;
 
+	ModelCache cache = NULL;
+
+
+	/* Use the cache of verified models if it is available. */
+	INIT(NAAAIM, ModelCache, cache, ERR(goto done));
+	if ( cache->open(cache, QUIXOTE_MODEL_CACHE) )
+		Model->set_model_cache(Model, cache);
+	else if ( Debug )
+		fputs("Model cache not available.\n", Debug);
+
+
+	/* Map a compiled model. */
+	if ( !map_model(model_file, &mapped) )
+		ERR(goto done);
+	if ( mapped ) {
+		retn = true;
+		goto done;
+	}
+
 
 	/* Open the behavioral map and initialize the binary point object. */
 	INIT(HurdLib, String, str, ERR(goto done));
@@ -1448,8 +1830,11 @@ static _Bool load_model(char *model_file)
 
 
  done:
+	Model->set_model_cache(Model, NULL);
+
 	WHACK(str);
 	WHACK(model);
+	WHACK(cache);
 
 	return retn;
 }
@@ -1719,9 +2104,7 @@ static _Bool setup_namespace(int *fdptr, _Bool enforce)
 	}
 
 	/* Create the pathname to the event update file. */
-	memset(fname, '\0', sizeof(fname));
-	if ( snprintf(fname, sizeof(fname), TSEM_UPDATE_FILE, \
-		      (long long int) id) >= sizeof(fname) )
+	if ( !Control->update_file(Control, id, fname, sizeof(fname)) )
 		ERR(goto done);
 	if ( Debug )
 		fprintf(Debug, "Update file: %s\n", fname);
@@ -1815,7 +2198,9 @@ static void show_magazine(CO(char *, root))
  *
  * This function is responsible for monitoring the child process that
  * is running the modeled workload.  The event loop monitors for a
- * a child exit and process management requests.
+ * a child exit and process management requests.  The commands that
+ * release the processes which generated a batch of security events
+ * are queued to the event loop and written when the loop next waits.
  *
  * \param mgmt		The object that will be used to receive management
  *			requests.
@@ -1839,32 +2224,44 @@ static _Bool child_monitor(LocalDuct mgmt, CO(char *, cartridge), int fd)
 	      retn = false,
 	      connected = false;
 
-	int rc;
+	int rc,
+	    error,
+	    mgmt_fd;
 
 	unsigned int cycle = 0;
 
-	struct pollfd poll_data[2];
+	uint64_t start;
 
 	Buffer cmdbufr = NULL;
 
+	EventLoop loop = NULL;
+
 
 	INIT(HurdLib, Buffer, cmdbufr, ERR(goto done));
 
-	poll_data[0].fd	    = fd;
-	poll_data[0].events = POLLIN;
+	INIT(NAAAIM, EventLoop, loop, ERR(goto done));
+	if ( !loop->init(loop, 64, false) )
+		ERR(goto done);
+	if ( !loop->watch(loop, 0, fd) )
+		ERR(goto done);
 
-	if ( !mgmt->get_socket(mgmt, &poll_data[1].fd) ) {
+	if ( !mgmt->get_socket(mgmt, &mgmt_fd) ) {
 		fputs("Error setting up polling data.\n", stderr);
 		goto done;
 	}
-	poll_data[1].events = POLLIN;
+	if ( !loop->watch(loop, 1, mgmt_fd) )
+		ERR(goto done);
+
+	if ( !Control->set_loop(Control, loop) )
+		ERR(goto done);
 
 
 	/* Dispatch loop. */
 	if ( Debug ) {
 		fprintf(Debug, "%d: Calling event loop\n", getpid());
-		fprintf(Debug, "descriptor 1: %d, descriptor 2: %d\n", \
-			poll_data[0].fd, poll_data[1].fd);
+		fprintf(Debug, "descriptor 1: %d, descriptor 2: %d, " \
+			"io_uring: %s\n", fd, mgmt_fd,		      \
+			loop->uses_ring(loop) ? "yes" : "no");
 	}
 
 	while ( 1 ) {
@@ -1872,7 +2269,10 @@ static _Bool child_monitor(LocalDuct mgmt, CO(char *, cartridge), int fd)
 			fprintf(Debug, "\n%d: Poll cycle: %d\n", getpid(), \
 				++cycle);
 
-		rc = poll(poll_data, 2, -1);
+		rc = loop->wait(loop);
+		if ( (error = loop->write_error(loop)) != 0 )
+			fprintf(stderr, "[%s]: Release actor status: %d:%s\n",
+				__func__, error, strerror(error));
 		if ( rc < 0 ) {
 			if ( Signals.stop ) {
 				if ( Debug )
@@ -1900,11 +2300,11 @@ static _Bool child_monitor(LocalDuct mgmt, CO(char *, cartridge), int fd)
 		}
 
 		if ( Debug )
-			fprintf(Debug, "Poll retn=%d, Data poll=%0x, "	     \
-				"Mgmt poll=%0x\n", rc, poll_data[0].revents, \
-				poll_data[1].revents);
+			fprintf(Debug, "Poll retn=%d, Data poll=%0x, "	\
+				"Mgmt poll=%0x\n", rc,			\
+				loop->revents(loop, 0), loop->revents(loop, 1));
 
-		if ( poll_data[0].revents & POLLHUP ) {
+		if ( loop->revents(loop, 0) & POLLHUP ) {
 			if ( Signals.stop ) {
 				retn = true;
 				goto done;
@@ -1917,7 +2317,8 @@ static _Bool child_monitor(LocalDuct mgmt, CO(char *, cartridge), int fd)
 			}
 		}
 
-		if ( poll_data[0].revents & POLLIN ) {
+		if ( loop->revents(loop, 0) & POLLIN ) {
+			Arrival = Stats->now(Stats);
 			if ( !Event->read_event(Event, fd) ) {
 				kill_cartridge(false);
 				break;
@@ -1935,6 +2336,8 @@ static _Bool child_monitor(LocalDuct mgmt, CO(char *, cartridge), int fd)
 							"processing error, " \
 							"%u killing %u\n",   \
 							getpid(), Monitor_pid);
+					Stats->increment(Stats, \
+							 EVENTSTATS_ERRORS);
 					Model_Error = true;
 					break;
 				}
@@ -1943,9 +2346,23 @@ static _Bool child_monitor(LocalDuct mgmt, CO(char *, cartridge), int fd)
 				kill_cartridge(false);
 				break;
 			}
+
+			/*
+			 * Time the write of the control commands for the
+			 * batch of events when statistics are being
+			 * collected, otherwise the commands are written
+			 * when the loop next waits.
+			 */
+			if ( Arrival != 0 ) {
+				Stats->set_type(Stats, NULL);
+				start = Stats->now(Stats);
+				if ( !loop->flush(loop) )
+					ERR(goto done);
+				record_stage(EVENTSTATS_WRITE, start);
+			}
 		}
 
-		if ( poll_data[1].revents & POLLIN ) {
+		if ( loop->revents(loop, 1) & POLLIN ) {
 			if ( !connected ) {
 				if ( Debug )
 					fputs("Have socket connection.\n", \
@@ -1953,7 +2370,9 @@ static _Bool child_monitor(LocalDuct mgmt, CO(char *, cartridge), int fd)
 
 				if ( !mgmt->accept_connection(mgmt) )
 					ERR(goto done);
-				if ( !mgmt->get_fd(mgmt, &poll_data[1].fd) )
+				if ( !mgmt->get_fd(mgmt, &mgmt_fd) )
+					ERR(goto done);
+				if ( !loop->watch(loop, 1, mgmt_fd) )
 					ERR(goto done);
 				connected = true;
 				continue;
@@ -1968,8 +2387,9 @@ static _Bool child_monitor(LocalDuct mgmt, CO(char *, cartridge), int fd)
 					fputs("Terminating management.\n", \
 					      Debug);
 				mgmt->reset(mgmt);
-				if ( !mgmt->get_socket(mgmt, \
-						       &poll_data[1].fd) )
+				if ( !mgmt->get_socket(mgmt, &mgmt_fd) )
+					ERR(goto done);
+				if ( !loop->watch(loop, 1, mgmt_fd) )
 					ERR(goto done);
 				connected = false;
 				continue;
@@ -1985,7 +2405,11 @@ static _Bool child_monitor(LocalDuct mgmt, CO(char *, cartridge), int fd)
 
 
  done:
+	if ( Control != NULL )
+		Control->set_loop(Control, NULL);
+
 	WHACK(cmdbufr);
+	WHACK(loop);
 
 	return retn;
 }
@@ -2032,8 +2456,7 @@ static _Bool fire_cartridge(CO(LocalDuct, mgmt), CO(char *, cartridge), \
 {
 	_Bool retn = false;
 
-	char *bundle = NULL,
-	     bufr[2048];
+	char *bundle = NULL;
 
 	int rc,
 	    event_pipe[2],
@@ -2041,10 +2464,12 @@ static _Bool fire_cartridge(CO(LocalDuct, mgmt), CO(char *, cartridge), \
 
 	pid_t cartridge_pid;
 
-	struct pollfd poll_data[1];
+	Buffer events = NULL;
 
 	String cartridge_dir = NULL;
 
+	EventLoop loop = NULL;
+
 
 	/* Create the name of the bundle directory if in cartridge mode . */
 	if ( Mode == cartridge_mode ) {
@@ -2160,9 +2585,17 @@ static _Bool fire_cartridge(CO(LocalDuct, mgmt), CO(char *, cartridge), \
 			}
 		}
 			
-		/* Parent process - monitor for events. */
-		poll_data[0].fd	    = event_fd;
-		poll_data[0].events = POLLIN;
+		/*
+		 * Parent process - monitor for events.  The events
+		 * that are available are read as a batch and written
+		 * to the orchestrator with a single write.
+		 */
+		INIT(HurdLib, Buffer, events, ERR(goto done));
+		INIT(NAAAIM, EventLoop, loop, ERR(goto done));
+		if ( !loop->init(loop, 32, false) )
+			ERR(goto done);
+		if ( !loop->watch(loop, 0, event_fd) )
+			ERR(goto done);
 
 		while ( true ) {
 			if ( Signals.stop ) {
@@ -2188,48 +2621,33 @@ static _Bool fire_cartridge(CO(LocalDuct, mgmt), CO(char *, cartridge), \
 				}
 			}
 
-			memset(bufr, '\0', sizeof(bufr));
-
-			rc = poll(poll_data, 1, -1);
+			rc = loop->wait(loop);
 			if ( rc < 0 ) {
-				if ( errno == -EINTR ) {
-					fputs("poll interrupted.\n", stderr);
+				if ( errno == EINTR )
 					continue;
-				}
+				fputs("Event loop error.\n", stderr);
+				break;
 			}
 
-			if ( (poll_data[0].revents & POLLIN) == 0 )
+			if ( (loop->revents(loop, 0) & POLLIN) == 0 )
 				continue;
 
-			while ( true ) {
-				rc = read(event_fd, bufr, sizeof(bufr));
-				if ( rc == 0 )
-					break;
-				if ( rc < 0 ) {
-					if ( errno != ENODATA ) {
-						fputs("Fatal event read.\n", \
-						      stderr);
-						exit(1);
-					}
-					break;
-				}
-				if ( rc > 0 ) {
-					write(event_pipe[WRITE_SIDE], bufr, \
-					      rc);
-					lseek(event_fd, 0, SEEK_SET);
-				}
-			}
-
-			if ( lseek(event_fd, 0, SEEK_SET) < 0 ) {
-				fputs("Seek error.\n", stderr);
-				break;
+			if ( !loop->drain(loop, event_fd, events) ) {
+				fputs("Fatal event read.\n", stderr);
+				exit(1);
 			}
+			if ( events->size(events) > 0 )
+				write(event_pipe[WRITE_SIDE],		\
+				      events->get(events), events->size(events));
+			events->reset(events);
 		}
 	}
 
 
  done:
+	WHACK(events);
 	WHACK(cartridge_dir);
+	WHACK(loop);
 
 	return retn;
 }
@@ -2242,7 +2660,8 @@ static _Bool fire_cartridge(CO(LocalDuct, mgmt), CO(char *, cartridge), \
 extern int main(int argc, char *argv[])
 
 {
-	_Bool enforce = false;
+	_Bool enforce = false,
+	      statistics = false;
 
 	char *debug	    = NULL,
 	     *model	    = NULL,
@@ -2259,7 +2678,7 @@ extern int main(int argc, char *argv[])
 	LocalDuct mgmt = NULL;
 
 
-	while ( (opt = getopt(argc, argv, "CPSXetuM:c:d:h:m:n:o:p:")) != EOF )
+	while ( (opt = getopt(argc, argv, "CPSXestuM:c:d:h:m:n:o:p:")) != EOF )
 		switch ( opt ) {
 			case 'C':
 				Mode = cartridge_mode;
@@ -2277,6 +2696,9 @@ extern int main(int argc, char *argv[])
 				enforce = true;
 				Enforce = true;
 				break;
+			case 's':
+				statistics = true;
+				break;
 			case 't':
 				Trajectory = true;
 				break;
@@ -2371,6 +2793,10 @@ extern int main(int argc, char *argv[])
 	if ( !Control->generate_key(Control) )
 		ERR(goto done);
 
+	INIT(NAAAIM, EventStats, Stats, ERR(goto done));
+	if ( statistics )
+		enable_statistics(true);
+
 
 	/* Load and seal a security model if specified. */
 	if ( model != NULL ) {
@@ -2418,6 +2844,10 @@ extern int main(int argc, char *argv[])
 	WHACK(Control);
 	WHACK(Event);
 	WHACK(Execute);
+	WHACK(Stats);
+
+	if ( Model_map != NULL )
+		munmap(Model_map, Model_map_size);
 
 	if ( fd > 0 )
 		close(fd);
@@ -76,6 +76,8 @@
 #include "SHA256.h"
 #include "Base64.h"
 #include "RSAkey.h"
+#include "ModelCache.h"
+#include "EventLoop.h"
 #include "TSEMcontrol.h"
 #include "TSEMevent.h"
 
@@ -950,36 +952,46 @@ static _Bool process_command(CO(LocalDuct, mgmt), CO(Buffer, cmdbufr))
  * Internal private function.
  *
  * This function encapsulates the addition of a line from a model file
- * to the Buffer object that will be hashed to generate the signature
- * for the model.
+ * to the digest that the signature for the model is verified against.
+ * Each line is hashed as it is loaded so the contents of the model do
+ * not need to be retained until the signature is reached.
  *
- * \param bufr		The state information for the model object.
+ * \param digest	The object which the model contents are being
+ *			hashed into.
+ *
+ * \param bufr		An object which is used to hold the line while
+ *			it is hashed.  The object is empty on return.
  *
  * \param line		The object containing the line to add to the
- *			file.
+ *			digest.
  *
  * \return	A boolean value is used to indicate the status of the
  *		addition of the line.  A false value indicates the
  *		addition failed while a true value indicates the
- *		contents of the line had been added to the buffer.
+ *		contents of the line had been added to the digest.
  */
 
-static _Bool _add_entry(CO(Buffer, bufr), CO(String, line))
+static _Bool _add_entry(CO(Sha256, digest), CO(Buffer, bufr), \
+			CO(String, line))
 
 {
 	_Bool retn = false;
 
 
-	if ( bufr == NULL )
+	if ( digest == NULL )
 		return true;
 
+	bufr->reset(bufr);
 	if ( !bufr->add(bufr, (void *) line->get(line), line->size(line) + 1) )
 		ERR(goto done);
+	if ( !digest->add(digest, bufr) )
+		ERR(goto done);
 
 	retn = true;
 
 
  done:
+	bufr->reset(bufr);
 	return retn;
 
 }
@@ -990,15 +1002,18 @@ static _Bool _add_entry(CO(Buffer, bufr), CO(String, line))
  *
  * This function carries out the validation of a signed security model.
  *
- * \param key		The object containing
- *			model over which the signature is generated.
+ * \param key		The object containing the Base64 encoded public
+ *			key which the model was signed with.
  *
- * \param sigdata	The object containing the contents of the
- *			security model in a form suitable for computing
- *			the hash signature.
+ * \param sigdata	The object containing the digest of the contents
+ *			of the security model.
  *
  * \param sig		The Base64 encoded signature.
  *
+ * \param cache		An optional cache of verified models which is
+ *			checked before the signature is verified and
+ *			which is updated after a successful verification.
+ *
  * \param valid		A pointer to the boolean value that will be
  *			loaded with the result of the signature
  *			validation.
@@ -1011,11 +1026,12 @@ static _Bool _add_entry(CO(Buffer, bufr), CO(String, line))
  *		contains the status of the signature.
  */
 
-static _Bool _verify_model(CO(Buffer, key), CO(Buffer, sigdata), char * sig, \
-			   _Bool *valid)
+static _Bool _verify_model(CO(Buffer, key), CO(Sha256, sigdata), char * sig, \
+			   CO(ModelCache, cache), _Bool *valid)
 
 {
-	_Bool retn = false;
+	_Bool retn = false,
+	      hit  = false;
 
 	Buffer signature = NULL;
 
@@ -1026,7 +1042,12 @@ static _Bool _verify_model(CO(Buffer, key), CO(Buffer, sigdata), char * sig, \
 	RSAkey rsakey = NULL;
 
 
-	/* Load the key that was provided. */
+	/* Complete the digest of the model. */
+	if ( !sigdata->compute(sigdata) )
+		ERR(goto done);
+
+
+	/* Decode the key and the signature. */
 	INIT(HurdLib, String, str, ERR(goto done));
 	if ( !str->add(str, (char *) key->get(key)) )
 		ERR(goto done);
@@ -1036,12 +1057,6 @@ static _Bool _verify_model(CO(Buffer, key), CO(Buffer, sigdata), char * sig, \
 	if ( !base64->decode(base64, str, key) )
 		ERR(goto done);
 
-	INIT(NAAAIM, RSAkey, rsakey, ERR(goto done));
-	if ( !rsakey->load_public(rsakey, key) )
-		ERR(goto done);
-
-
-	/* Decode and verify the signature. */
 	str->reset(str);
 	if ( !str->add(str, sig) )
 		ERR(goto done);
@@ -1050,9 +1065,35 @@ static _Bool _verify_model(CO(Buffer, key), CO(Buffer, sigdata), char * sig, \
 	if ( !base64->decode(base64, str, signature) )
 		ERR(goto done);
 
-	if ( !rsakey->verify(rsakey, signature, sigdata, valid) )
+
+	/* Use a previous verification of the model. */
+	if ( (cache != NULL) && \
+	     !cache->check(cache, sigdata->get_Buffer(sigdata), key, \
+			   signature, &hit) )
+		hit = false;
+	if ( hit ) {
+		if ( Debug != NULL )
+			fprintf(Debug, "%s: Using cached verification.\n", \
+				__func__);
+		*valid = true;
+		retn   = true;
+		goto done;
+	}
+
+
+	/* Verify the signature against the model digest. */
+	INIT(NAAAIM, RSAkey, rsakey, ERR(goto done));
+	if ( !rsakey->load_public(rsakey, key) )
+		ERR(goto done);
+
+	if ( !rsakey->verify_digest(rsakey, signature, \
+				    sigdata->get_Buffer(sigdata), valid) )
 		ERR(goto done);
 
+	if ( *valid && (cache != NULL) )
+		cache->add(cache, sigdata->get_Buffer(sigdata), key, \
+			   signature);
+
 	retn = true;
 
 
@@ -1096,10 +1137,13 @@ static _Bool load(CO(String, entry))
 
 	Buffer bufr = NULL;
 
+	ModelCache cache = NULL;
+
 	static _Bool loading = false;
 
-	static Buffer key     = NULL,
-		      sigdata = NULL;
+	static Buffer key = NULL;
+
+	static Sha256 sigdata = NULL;
 
 
 	/* Locate the load command being requested. */
@@ -1128,14 +1172,14 @@ static _Bool load(CO(String, entry))
 
 	switch ( dp->command ) {
 		case model_cmd_comment:
-			if ( !_add_entry(sigdata, entry) )
+			if ( !_add_entry(sigdata, bufr, entry) )
 				ERR(goto done);
 			break;
 
 		case model_cmd_key:
-			INIT(HurdLib, Buffer, sigdata, ERR(goto done));
+			INIT(NAAAIM, Sha256, sigdata, ERR(goto done));
 
-			if ( !_add_entry(sigdata, entry) )
+			if ( !_add_entry(sigdata, bufr, entry) )
 				ERR(goto done);
 
 			if ( key != NULL )
@@ -1146,12 +1190,12 @@ static _Bool load(CO(String, entry))
 			break;
 
 		case model_cmd_aggregate:
-			if ( !_add_entry(sigdata, entry) )
+			if ( !_add_entry(sigdata, bufr, entry) )
 				ERR(goto done);
 			break;
 
 		case model_cmd_base:
-			if ( !_add_entry(sigdata, entry) )
+			if ( !_add_entry(sigdata, bufr, entry) )
 				ERR(goto done);
 
 			if ( Debug != NULL )
@@ -1164,7 +1208,7 @@ static _Bool load(CO(String, entry))
 			break;
 
 		case model_cmd_state:
-			if ( !_add_entry(sigdata, entry) )
+			if ( !_add_entry(sigdata, bufr, entry) )
 				ERR(goto done);
 
 			if ( Debug != NULL )
@@ -1177,7 +1221,7 @@ static _Bool load(CO(String, entry))
 			break;
 
 		case model_cmd_pseudonym:
-			if ( !_add_entry(sigdata, entry) )
+			if ( !_add_entry(sigdata, bufr, entry) )
 				ERR(goto done);
 
 			if ( Debug != NULL )
@@ -1190,7 +1234,7 @@ static _Bool load(CO(String, entry))
 			break;
 
 		case model_cmd_seal:
-			if ( !_add_entry(sigdata, entry) )
+			if ( !_add_entry(sigdata, bufr, entry) )
 				ERR(goto done);
 
 			if ( !Control->seal(Control) )
@@ -1201,7 +1245,16 @@ static _Bool load(CO(String, entry))
 			if ( (sigdata == NULL) || (key == NULL) )
 				ERR(goto done);
 
-			retn = _verify_model(key, sigdata, arg, &sig_valid);
+			INIT(NAAAIM, ModelCache, cache, ERR(goto done));
+			if ( !cache->open(cache, QUIXOTE_MODEL_CACHE) ) {
+				if ( Debug != NULL )
+					fprintf(Debug, "%s: Model cache not "
+						"available.\n", __func__);
+				WHACK(cache);
+			}
+
+			retn = _verify_model(key, sigdata, arg, cache, \
+					     &sig_valid);
 			WHACK(key);
 			WHACK(sigdata);
 
@@ -1214,7 +1267,7 @@ static _Bool load(CO(String, entry))
 			break;
 
 		case model_cmd_end:
-			if ( !_add_entry(sigdata, entry) )
+			if ( !_add_entry(sigdata, bufr, entry) )
 				ERR(goto done);
 
 			loading = false;
@@ -1226,6 +1279,7 @@ static _Bool load(CO(String, entry))
 
  done:
 	WHACK(bufr);
+	WHACK(cache);
 
 	return retn;
 }
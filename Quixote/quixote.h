@@ -13,8 +13,9 @@
 
 /* Filesystem locations. */
 #define TSEM_CONTROL_FILE		"/sys/kernel/security/tsem/control"
-#define TSEM_UPDATE_FILE		"/sys/kernel/security/tsem/external_tma/%llu"
 
 #define QUIXOTE_PROCESS_MGMT_DIR	"/var/lib/Quixote/mgmt/processes"
 #define QUIXOTE_CARTRIDGE_MGMT_DIR	"/var/lib/Quixote/mgmt/cartridges"
+#define QUIXOTE_TMAD_MGMT		"/var/lib/Quixote/mgmt/tmad"
 #define QUIXOTE_MAGAZINE		"/var/lib/Quixote/Magazine"
+#define QUIXOTE_MODEL_CACHE		"/var/lib/Quixote/Verified"
@@ -31,6 +31,11 @@ enum {
 	show_map,
 	enable_cell,
 	sancho_reset,
+	show_namespaces,
+	start_cartridge,
+	show_stats,
+	enable_stats,
+	disable_stats,
 	sancho_cmds_max
 } sancho_commands;
 
@@ -57,5 +62,10 @@ struct sancho_cmd_definition Sancho_cmd_list[] = {
 	{show_map,			"show map"},
 	{enable_cell,			"enable cellular"},
 	{sancho_reset,			"reset"},
+	{show_namespaces,		"show namespaces"},
+	{start_cartridge,		"start "},
+	{show_stats,			"show stats"},
+	{enable_stats,			"enable stats"},
+	{disable_stats,			"disable stats"},
 	{0, NULL}
 };
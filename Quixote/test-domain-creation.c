@@ -29,6 +29,7 @@
 #include <File.h>
 
 #include "NAAAIM.h"
+#include "EventLoop.h"
 #include "TSEMcontrol.h"
 
 
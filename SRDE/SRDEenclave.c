@@ -30,6 +30,7 @@
 #include <sys/ioctl.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <immintrin.h>
 
 #include <Origin.h>
 #include <HurdLib.h>
@@ -107,6 +108,18 @@ struct NAAAIM_SRDEenclave_State
 	 */
 	size_t thread_cnt;
 	Buffer threads;
+
+	/*
+	 * The following members hold the state of an offline
+	 * measurement of the enclave.  When the measure flag is set
+	 * the pages added to the enclave are hashed into the
+	 * MRENCLAVE value rather than being loaded into the SGX
+	 * device.
+	 */
+	_Bool measure;
+	_Bool sha_ni;
+	uint32_t mrenclave[8];
+	uint64_t mr_size;
 };
 
 
@@ -169,6 +182,374 @@ static void _init_state(CO(SRDEenclave_State, S)) {
 	S->thread_cnt = 0;
 	S->threads    = NULL;
 
+	S->measure = false;
+	S->sha_ni  = false;
+	memset(S->mrenclave, '\0', sizeof(S->mrenclave));
+	S->mr_size = 0;
+
+	return;
+}
+
+
+/**
+ * The following table contains the SHA-256 round constants used by
+ * the offline measurement functions.
+ */
+static const uint32_t K256[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/* The SHA-256 initial hash value. */
+static const uint32_t IV256[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+	0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+#define ROR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+
+/**
+ * Private function.
+ *
+ * This function implements the SHA-256 compression function over a
+ * run of 64 byte blocks.  Every record which makes up an enclave
+ * measurement is a multiple of the block size so the measurement is
+ * carried forward without buffering partial blocks.
+ *
+ * \param state		A pointer to the eight word hash state which
+ *			is to be updated.
+ *
+ * \param data		A pointer to the blocks to be hashed.
+ *
+ * \param blocks	The number of blocks to be hashed.
+ *
+ * \return		No return value is defined.
+ */
+
+static void _sha256_blocks(uint32_t *state, const uint8_t *data, \
+			   size_t blocks)
+
+{
+	unsigned int lp;
+
+	uint32_t a, b, c, d, e, f, g, h,
+		 s0,
+		 s1,
+		 t1,
+		 t2,
+		 w[64];
+
+
+	while ( blocks-- ) {
+		for (lp= 0; lp < 16; ++lp, data += 4)
+			w[lp] = ((uint32_t) data[0] << 24) |	\
+				((uint32_t) data[1] << 16) |	\
+				((uint32_t) data[2] << 8) | data[3];
+		for (lp= 16; lp < 64; ++lp) {
+			s0 = ROR(w[lp-15], 7) ^ ROR(w[lp-15], 18) ^ \
+				(w[lp-15] >> 3);
+			s1 = ROR(w[lp-2], 17) ^ ROR(w[lp-2], 19) ^ \
+				(w[lp-2] >> 10);
+			w[lp] = w[lp-16] + s0 + w[lp-7] + s1;
+		}
+
+		a = state[0];
+		b = state[1];
+		c = state[2];
+		d = state[3];
+		e = state[4];
+		f = state[5];
+		g = state[6];
+		h = state[7];
+
+		for (lp= 0; lp < 64; ++lp) {
+			t1 = h + (ROR(e, 6) ^ ROR(e, 11) ^ ROR(e, 25)) + \
+				((e & f) ^ (~e & g)) + K256[lp] + w[lp];
+			t2 = (ROR(a, 2) ^ ROR(a, 13) ^ ROR(a, 22)) + \
+				((a & b) ^ (a & c) ^ (b & c));
+			h = g;
+			g = f;
+			f = e;
+			e = d + t1;
+			d = c;
+			c = b;
+			b = a;
+			a = t1 + t2;
+		}
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+		state[5] += f;
+		state[6] += g;
+		state[7] += h;
+	}
+
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function is a version of the SHA-256 compression function
+ * which uses the SHA extensions to the x86 instruction set.  The
+ * function is compiled for these instructions independently of the
+ * build flags and is only called after the ->open_measurement method
+ * has verified the processor supports them.
+ *
+ * \param state		A pointer to the eight word hash state which
+ *			is to be updated.
+ *
+ * \param data		A pointer to the blocks to be hashed.
+ *
+ * \param blocks	The number of blocks to be hashed.
+ *
+ * \return		No return value is defined.
+ */
+
+__attribute__((target("sha,sse4.1,ssse3")))
+static void _sha256_blocks_ni(uint32_t *state, const uint8_t *data, \
+			      size_t blocks)
+
+{
+	unsigned int lp;
+
+	__m128i abef,
+		cdgh,
+		abef_save,
+		cdgh_save,
+		msg,
+		tmp,
+		w[4];
+
+	const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, \
+					    0x0405060700010203ULL);
+
+
+	/* Convert the state into the order used by the instructions. */
+	tmp  = _mm_loadu_si128((const __m128i *) &state[0]);
+	cdgh = _mm_loadu_si128((const __m128i *) &state[4]);
+	tmp  = _mm_shuffle_epi32(tmp, 0xb1);
+	cdgh = _mm_shuffle_epi32(cdgh, 0x1b);
+	abef = _mm_alignr_epi8(tmp, cdgh, 8);
+	cdgh = _mm_blend_epi16(cdgh, tmp, 0xf0);
+
+	while ( blocks-- ) {
+		abef_save = abef;
+		cdgh_save = cdgh;
+
+#pragma GCC unroll 16
+		for (lp= 0; lp < 16; ++lp) {
+			if ( lp < 4 ) {
+				msg = _mm_loadu_si128((const __m128i *) \
+						      (data + 16 * lp));
+				w[lp] = _mm_shuffle_epi8(msg, mask);
+			} else {
+				msg = _mm_sha256msg1_epu32(w[lp & 3], \
+							   w[(lp + 1) & 3]);
+				tmp = _mm_alignr_epi8(w[(lp + 3) & 3], \
+						      w[(lp + 2) & 3], 4);
+				msg = _mm_add_epi32(msg, tmp);
+				w[lp & 3] = _mm_sha256msg2_epu32(msg, \
+							 w[(lp + 3) & 3]);
+			}
+
+			msg = _mm_add_epi32(w[lp & 3], _mm_loadu_si128( \
+					    (const __m128i *) &K256[4 * lp]));
+			cdgh = _mm_sha256rnds2_epu32(cdgh, abef, msg);
+			msg  = _mm_shuffle_epi32(msg, 0x0e);
+			abef = _mm_sha256rnds2_epu32(abef, cdgh, msg);
+		}
+
+		abef = _mm_add_epi32(abef, abef_save);
+		cdgh = _mm_add_epi32(cdgh, cdgh_save);
+		data += 64;
+	}
+
+	/* Return the state to its standard order. */
+	tmp  = _mm_shuffle_epi32(abef, 0x1b);
+	cdgh = _mm_shuffle_epi32(cdgh, 0xb1);
+	abef = _mm_blend_epi16(tmp, cdgh, 0xf0);
+	cdgh = _mm_alignr_epi8(cdgh, tmp, 8);
+	_mm_storeu_si128((__m128i *) &state[0], abef);
+	_mm_storeu_si128((__m128i *) &state[4], cdgh);
+
+	return;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function determines whether or not the processor implements
+ * the SHA extensions along with the SSSE3 and SSE4.1 instructions
+ * used with them.
+ *
+ * No arguments are specified.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the extensions are available.
+ */
+
+static _Bool _have_sha_ni(void)
+
+{
+	uint32_t eax,
+		 ebx,
+		 ecx,
+		 edx;
+
+
+	__asm("movl %4, %%eax\n\t"
+	      "movl %5, %%ecx\n\t"
+	      "cpuid\n\t"
+	      "movl %%eax, %0\n\t"
+	      "movl %%ebx, %1\n\t"
+	      "movl %%ecx, %2\n\t"
+	      "movl %%edx, %3\n\t"
+	      /* Output. */
+	      : "=r" (eax), "=r" (ebx), "=r" (ecx), "=r" (edx)
+	      /* Input. */
+	      : "r" (0x0), "r" (0x0)
+	      /* Clobbers. */
+	      : "eax", "ebx", "ecx", "edx");
+	if ( eax < 7 )
+		return false;
+
+	/* Leaf 1: ECX bit 9 => SSSE3, bit 19 => SSE4.1 */
+	__asm("movl %4, %%eax\n\t"
+	      "movl %5, %%ecx\n\t"
+	      "cpuid\n\t"
+	      "movl %%eax, %0\n\t"
+	      "movl %%ebx, %1\n\t"
+	      "movl %%ecx, %2\n\t"
+	      "movl %%edx, %3\n\t"
+	      /* Output. */
+	      : "=r" (eax), "=r" (ebx), "=r" (ecx), "=r" (edx)
+	      /* Input. */
+	      : "r" (0x1), "r" (0x0)
+	      /* Clobbers. */
+	      : "eax", "ebx", "ecx", "edx");
+	if ( !(ecx & (1U << 9)) || !(ecx & (1U << 19)) )
+		return false;
+
+	/* Leaf 7: EBX bit 29 => SHA */
+	__asm("movl %4, %%eax\n\t"
+	      "movl %5, %%ecx\n\t"
+	      "cpuid\n\t"
+	      "movl %%eax, %0\n\t"
+	      "movl %%ebx, %1\n\t"
+	      "movl %%ecx, %2\n\t"
+	      "movl %%edx, %3\n\t"
+	      /* Output. */
+	      : "=r" (eax), "=r" (ebx), "=r" (ecx), "=r" (edx)
+	      /* Input. */
+	      : "r" (0x7), "r" (0x0)
+	      /* Clobbers. */
+	      : "eax", "ebx", "ecx", "edx");
+
+	return (ebx & (1U << 29)) != 0;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function extends the offline enclave measurement with a run
+ * of blocks.
+ *
+ * \param S		A pointer to the state of the object whose
+ *			measurement is to be extended.
+ *
+ * \param data		A pointer to the blocks to be added.
+ *
+ * \param blocks	The number of 64 byte blocks to be added.
+ *
+ * \return		No return value is defined.
+ */
+
+static void _measure(CO(SRDEenclave_State, S), CO(uint8_t *, data), \
+		     const size_t blocks)
+
+{
+	if ( S->sha_ni )
+		_sha256_blocks_ni(S->mrenclave, data, blocks);
+	else
+		_sha256_blocks(S->mrenclave, data, blocks);
+
+	S->mr_size += blocks * 64;
+	return;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function adds the measurement records generated by the EADD
+ * and EEXTEND instructions for a page to the offline measurement.
+ * The EEXTEND data is hashed directly from the page so the only
+ * material staged for each 256 byte chunk is its 64 byte header.
+ *
+ * \param S		A pointer to the state of the object whose
+ *			measurement is to be extended.
+ *
+ * \param page		A pointer to the contents of the page.
+ *
+ * \param secinfo	A pointer to the security information for
+ *			the page.
+ *
+ * \param flags		The page insertion flags.
+ *
+ * \return		No return value is defined.
+ */
+
+static void _measure_page(CO(SRDEenclave_State, S), CO(uint8_t *, page), \
+			  CO(struct SGX_secinfo *, secinfo),	      \
+			  const uint8_t flags)
+
+{
+	uint8_t record[64];
+
+	uint64_t offset = S->page_cnt * 4096;
+
+	unsigned int lp;
+
+
+	memset(record, '\0', sizeof(record));
+	memcpy(record, "EADD", 4);
+	memcpy(&record[8], &offset, sizeof(offset));
+	memcpy(&record[16], secinfo, 48);
+	_measure(S, record, 1);
+
+	if ( !(flags & SGX_PAGE_EXTEND) )
+		return;
+
+	memset(record, '\0', sizeof(record));
+	memcpy(record, "EEXTEND", 7);
+	for (lp= 0; lp < 4096; lp += 256, offset += 256) {
+		memcpy(&record[8], &offset, sizeof(offset));
+		_measure(S, record, 1);
+		_measure(S, &page[lp], 4);
+	}
+
 	return;
 }
 
@@ -375,6 +756,66 @@ static _Bool open_enclave_memory(CO(SRDEenclave, this), CO(char *, device),  \
 }
 
 
+/**
+ * External public method.
+ *
+ * This method loads the SGX metadata and program segment data of an
+ * enclave which is to be measured rather than loaded.  After this
+ * method the ->create_enclave and ->load_enclave methods compute the
+ * MRENCLAVE value which the processor would generate for the enclave
+ * without the SGX device being present.  This allows the measurement
+ * of an enclave to be generated or verified on systems which do not
+ * support SGX.
+ *
+ * \param this		A pointer to the object which is to hold the
+ *			metadata.
+ *
+ * \param enclave	A pointer to a null-terminated buffer which
+ *			contains the path specification to the shared
+ *			object implementation of the enclave.
+ *
+ * \param debug		A boolean flag used to indicate whether or not
+ *			the enclave attributes are to be computed for
+ *			debug mode.
+ *
+ * \return	If an error is encountered while opening the enclave a
+ *		false value is returned.   A true value indicates the
+ *		enclave is ready for measurement.
+ */
+
+static _Bool open_measurement(CO(SRDEenclave, this), CO(char *, enclave), \
+			      _Bool debug)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+
+	/* Load the SGX metadata and shared object file. */
+	INIT(NAAAIM, SRDEloader, S->loader, ERR(goto done));
+	if ( S->debug )
+		S->loader->debug(S->loader, true);
+	if ( !S->loader->load_secs(S->loader, enclave, &S->secs, debug) )
+		ERR(goto done);
+
+	/* Initialize the thread control arena. */
+	INIT(HurdLib, Buffer, S->threads, ERR(goto done));
+
+	S->measure = true;
+	S->sha_ni  = _have_sha_ni();
+	if ( S->debug )
+		fprintf(stdout, "Measurement using SHA extensions: %s\n", \
+			S->sha_ni ? "yes" : "no");
+
+	retn = true;
+
+
+ done:
+	return retn;
+}
+
+
 /**
  * External public method.
  *
@@ -398,6 +839,8 @@ static _Bool create_enclave(CO(SRDEenclave, this))
 
 	void *address;
 
+	uint8_t record[64];
+
 	struct SGX_create_param create_param;
 
 
@@ -405,6 +848,27 @@ static _Bool create_enclave(CO(SRDEenclave, this))
 	if ( S->poisoned )
 		ERR(goto done);
 
+	/*
+	 * For an offline measurement start the measurement with the
+	 * record generated by the ECREATE instruction.  The enclave
+	 * is measured relative to a base address of zero.
+	 */
+	if ( S->measure ) {
+		memset(record, '\0', sizeof(record));
+		memcpy(record, "ECREATE", 7);
+		memcpy(&record[8], &S->secs.ssaframesize, \
+		       sizeof(S->secs.ssaframesize));
+		memcpy(&record[12], &S->secs.size, sizeof(S->secs.size));
+
+		memcpy(S->mrenclave, IV256, sizeof(S->mrenclave));
+		S->mr_size  = 0;
+		S->page_cnt = 0;
+		_measure(S, record, 1);
+
+		retn = true;
+		goto done;
+	}
+
 	/* Create an appropriate memory mapping for the enclave. */
 	if ( (address = mmap(NULL, S->secs.size,		 \
 			     PROT_READ | PROT_WRITE | PROT_EXEC, \
@@ -800,6 +1264,15 @@ static _Bool add_page(CO(SRDEenclave, this), CO(uint8_t *, page), \
 		ERR(goto done);
 
 
+	/* Extend an offline measurement with the page. */
+	if ( S->measure ) {
+		_measure_page(S, page, secinfo, flags);
+		S->page_cnt += 1;
+		retn = true;
+		goto done;
+	}
+
+
 	/* Initialize the page addition parameters and add page. */
 	memset(&add_param, '\0', sizeof(add_param));
 	add_param.addr	    = S->enclave_address + (4096 * S->page_cnt);
@@ -1381,6 +1854,72 @@ static void get_psvn(CO(SRDEenclave, this), struct SGX_psvn *psvn)
 }
 
 
+/**
+ * External public method.
+ *
+ * This method returns the MRENCLAVE value computed by an offline
+ * measurement of an enclave.  The measurement is completed on a
+ * copy of the running hash so the method may be called at any point
+ * after the enclave has been created.
+ *
+ * \param this		A pointer to the object whose measurement is
+ *			to be returned.
+ *
+ * \param mrenclave	A pointer to a 32 byte buffer which will be
+ *			loaded with the measurement.
+ *
+ * \return	A false value is returned if the object is poisoned or
+ *		was not opened for measurement.  A true value indicates
+ *		the supplied buffer holds a valid measurement.
+ */
+
+static _Bool get_measurement(CO(SRDEenclave, this), uint8_t *mrenclave)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	uint8_t pad[64];
+
+	uint32_t lp,
+		 hash[8];
+
+	uint64_t bits;
+
+
+	/* Verify object status. */
+	if ( S->poisoned )
+		ERR(goto done);
+	if ( !S->measure || (S->mr_size == 0) )
+		ERR(goto done);
+
+
+	/* The measurement is block aligned so one padding block ends it. */
+	memcpy(hash, S->mrenclave, sizeof(hash));
+
+	memset(pad, '\0', sizeof(pad));
+	pad[0] = 0x80;
+	bits   = S->mr_size * 8;
+	for (lp= 0; lp < 8; ++lp)
+		pad[63 - lp] = bits >> (8 * lp);
+	_sha256_blocks(hash, pad, 1);
+
+	for (lp= 0; lp < 8; ++lp) {
+		mrenclave[4*lp]	    = hash[lp] >> 24;
+		mrenclave[4*lp + 1] = hash[lp] >> 16;
+		mrenclave[4*lp + 2] = hash[lp] >> 8;
+		mrenclave[4*lp + 3] = hash[lp];
+	}
+
+	retn = true;
+
+
+ done:
+	return retn;
+}
+
+
 /**
  * External public method.
  *
@@ -1428,11 +1967,14 @@ static void whack(CO(SRDEenclave, this))
 	} ocall;
 
 
-	/* Run enclave uninitialization routine. */
-	ocall.nr_ocall = 1;
-	ocall.table[0] = SRDEfusion_ocall_table[0];
-	ocall.table[1] = NULL;
-	this->boot_slot(this, -5, (struct OCALL_api *) &ocall, NULL, &retn);
+	/* Run enclave uninitialization routine if it was created. */
+	if ( S->enclave_address != 0 ) {
+		ocall.nr_ocall = 1;
+		ocall.table[0] = SRDEfusion_ocall_table[0];
+		ocall.table[1] = NULL;
+		this->boot_slot(this, -5, (struct OCALL_api *) &ocall, NULL, \
+				&retn);
+	}
 
 
 	if ( S->enclave_address != 0 )
@@ -1490,6 +2032,7 @@ extern SRDEenclave NAAAIM_SRDEenclave_Init(void)
 
 	this->open_enclave	  = open_enclave;
 	this->open_enclave_memory = open_enclave_memory;
+	this->open_measurement	  = open_measurement;
 	this->create_enclave = create_enclave;
 	this->load_enclave   = load_enclave;
 
@@ -1510,6 +2053,7 @@ extern SRDEenclave NAAAIM_SRDEenclave_Init(void)
 	this->get_attributes  = get_attributes;
 	this->get_secs	      = get_secs;
 	this->get_psvn	      = get_psvn;
+	this->get_measurement = get_measurement;
 
 	this->debug = debug;
 	this->whack = whack;
@@ -31,6 +31,7 @@ struct NAAAIM_SRDEenclave
 			      _Bool);
 	_Bool (*open_enclave_memory)(const SRDEenclave, const char *, \
 				     const char *, size_t, _Bool);
+	_Bool (*open_measurement)(const SRDEenclave, const char *, _Bool);
 
 	_Bool (*create_enclave)(const SRDEenclave);
 	_Bool (*load_enclave)(const SRDEenclave);
@@ -55,6 +56,7 @@ struct NAAAIM_SRDEenclave
 	_Bool (*get_attributes)(const SRDEenclave, sgx_attributes_t *);
 	void (*get_secs)(const SRDEenclave, struct SGX_secs *);
 	void (*get_psvn)(const SRDEenclave, struct SGX_psvn *);
+	_Bool (*get_measurement)(const SRDEenclave, uint8_t *);
 
 	void (*debug)(const SRDEenclave, const _Bool);
 	void (*whack)(const SRDEenclave);
@@ -37,6 +37,25 @@
 #endif
 
 
+/* Allocation statistics for all Buffer objects. */
+static struct HurdLib_Buffer_stats Stats;
+
+/*
+ * Table used by the hexadecimal conversion which maps an ASCII
+ * character to one more than the value of the hexadecimal digit it
+ * represents.  Characters which are not hexadecimal digits have a zero
+ * value.
+ */
+static const unsigned char Nybble[256] = {
+	['0'] = 0x1, ['1'] = 0x2, ['2'] = 0x3, ['3'] = 0x4, ['4'] = 0x5,
+	['5'] = 0x6, ['6'] = 0x7, ['7'] = 0x8, ['8'] = 0x9, ['9'] = 0xa,
+	['A'] = 0xb, ['B'] = 0xc, ['C'] = 0xd, ['D'] = 0xe, ['E'] = 0xf,
+	['F'] = 0x10,
+	['a'] = 0xb, ['b'] = 0xc, ['c'] = 0xd, ['d'] = 0xe, ['e'] = 0xf,
+	['f'] = 0x10
+};
+
+
 /** Buffer private state information. */
 struct HurdLib_Buffer_State
 {
@@ -55,9 +74,15 @@ struct HurdLib_Buffer_State
 	/* The current allocation size. */
 	size_t used;
 
+	/* The number of bytes which the buffer can hold. */
+	size_t capacity;
+
  	/* A pointer to the memory buffer implemented by the object. */
 	unsigned char *bf;
 
+	/* Inline storage used until the contents outgrow it. */
+	unsigned char inline_bf[BUFFER_INLINE_SIZE];
+
 	/* The Fibonacci sequence used to implement dynamic object size. */
 	Fibsequence seqn;
 };
@@ -79,8 +104,9 @@ static void _init_state(CO(Buffer_State, S)) {
 	S->objid = HurdLib_Buffer_OBJID;
 
 	S->poisoned = false;
-	S->used = 0;
-	S->bf   = NULL;
+	S->used	    = 0;
+	S->capacity = sizeof(S->inline_bf);
+	S->bf	    = S->inline_bf;
 
 	return;
 }
@@ -89,27 +115,53 @@ static void _init_state(CO(Buffer_State, S)) {
 /**
  * Internal private method.
  *
- * This method allocates or re-allocates memory allocation for this
- * buffer.
- * 
+ * This method insures the buffer is capable of holding the specified
+ * number of bytes.  The allocator is only called if the current
+ * capacity is exceeded, in which case the capacity is grown to the
+ * next member of the Fibonacci sequence which will hold the contents.
+ * Contents held in the inline storage area are copied to heap memory
+ * when they outgrow it.
+ *
  * \param S	A pointer to the state of the buffer whose memory allocation
  *		is being modified.
  *
+ * \param needed	The total number of bytes the buffer must hold.
+ *
  * \return	A boolean value is used to indicate whether or not the
  *		re-allocation was successful.  A true value indicates
  *		success.
  */
 
-static _Bool _do_alloc(CO(Buffer_State, S))
+static _Bool _do_alloc(CO(Buffer_State, S), const size_t needed)
 
 {
+	unsigned char *bf;
+
 
-	S->bf = realloc(S->bf, S->seqn->get(S->seqn));
-	if (S->bf == NULL ) {
+	if ( needed <= S->capacity )
+		return true;
+
+	while ( S->seqn->get(S->seqn) < needed )
+		S->seqn->next(S->seqn);
+
+	if ( S->bf == S->inline_bf ) {
+		if ( (bf = malloc(S->seqn->get(S->seqn))) != NULL ) {
+			memcpy(bf, S->inline_bf, S->used);
+			memset(S->inline_bf, '\0', sizeof(S->inline_bf));
+		}
+	}
+	else
+		bf = realloc(S->bf, S->seqn->get(S->seqn));
+
+	if ( bf == NULL ) {
 		S->poisoned = true;
 		return false;
 	}
 
+	++Stats.allocations;
+	S->bf	    = bf;
+	S->capacity = S->seqn->get(S->seqn);
+
 	return true;
 }
 
@@ -141,19 +193,12 @@ static _Bool add(CO(Buffer, this), CO(unsigned char *, src), size_t const cnt)
 {
 	STATE(S);
 
-	size_t free = S->seqn->get(S->seqn) - S->used;
-
 
 	if ( S->poisoned )
 		return false;
 
-	if ( cnt > free )
-		do {
-			S->seqn->next(S->seqn);
-			free = S->seqn->get(S->seqn) - S->used;
-		} while ( cnt > free );
-
-	if ( !_do_alloc(S) )
+	++Stats.appends;
+	if ( !_do_alloc(S, S->used + cnt) )
 		return false;
 	memcpy(S->bf + S->used, src, cnt);
 	S->used += cnt;
@@ -187,6 +232,38 @@ static _Bool add_Buffer(CO(Buffer, this), CO(Buffer, bf))
 }
 
 
+/**
+ * External public method.
+ *
+ * This method implements pre-allocation of the memory needed to
+ * hold a subsequent series of additions to the buffer.  This allows
+ * a caller which knows the eventual size of the contents to avoid
+ * repeated growth of the buffer.
+ *
+ * \param this	A pointer to the buffer object whose capacity is to
+ *		be expanded.
+ *
+ * \param cnt	The number of bytes, beyond the current contents of
+ *		the buffer, which are to be reserved.
+ *
+ * \return	A boolean value is used to indicate the success or
+ *		failure of the reservation.  A true value indicates
+ *		success.
+ */
+
+static _Bool reserve(CO(Buffer, this), size_t const cnt)
+
+{
+	STATE(S);
+
+
+	if ( S->poisoned )
+		return false;
+
+	return _do_alloc(S, S->used + cnt);
+}
+
+
 /**
  * External public method.
  *
@@ -216,11 +293,14 @@ static _Bool add_hexstring(CO(Buffer, this), CO(char *,hexbufr))
 {
 	STATE(S);
 
-	_Bool retn	   = false,
-	      first_nybble = true;
+	_Bool retn = false;
 
-	unsigned char nybble,
-		      byte[1];
+	unsigned char hi,
+		      lo,
+		      bad = 0,
+		      *bp;
+
+	const unsigned char *p = (const unsigned char *) hexbufr;
 
 	size_t lp,
 	       hexbufr_length;
@@ -242,78 +322,31 @@ static _Bool add_hexstring(CO(Buffer, this), CO(char *,hexbufr))
 		goto done;
 	}
 
+	if ( !_do_alloc(S, S->used + (hexbufr_length / 2)) )
+		goto done;
+
 
 	/*
-	 * The somewhat brute force conversion occurs below.  The output
-	 * buffer is big-endian.  An invalid character causes a failure
-	 * of the conversion.
+	 * The conversion is carried out directly into the buffer with
+	 * a lookup table.  The output buffer is big-endian.  An invalid
+	 * character, which has a zero table value, causes a failure
+	 * of the conversion which is detected once all of the characters
+	 * have been processed.
 	 */
-	for (lp= 0; lp < hexbufr_length; ++lp) {
-		switch ( toupper(hexbufr[lp]) )
-		{
-			case '0':
-				nybble = 0;
-				break;
-			case '1':
-				nybble = 1;
-				break;
-			case '2':
-				nybble = 2;
-				break;
-		    	case '3':
-				nybble = 3;
-				break;
-		    	case '4':
-				nybble = 4;
-				break;
-		    	case '5':
-				nybble = 5;
-				break;
-	    		case '6':
-				nybble = 6;
-				break;
-		    	case '7':
-				nybble = 7;
-				break;
-		    	case '8':
-				nybble = 8;
-				break;
-	    		case '9':
-				nybble = 9;
-				break;
-	    		case 'A':
-				nybble = 10;
-				break;
-		    	case 'B':
-				nybble = 11;
-				break;
-	    		case 'C':
-				nybble = 12;
-				break;
-		    	case 'D':
-				nybble = 13;
-				break;
-		    	case 'E':
-				nybble = 14;
-				break;
-		    	case 'F':
-				nybble = 15;
-				break;
-	    		default:
-				this->state->poisoned = true;
-				goto done;
-		}
-
-		if ( first_nybble ) {
-			byte[0] = nybble << 4;
-			first_nybble = false;
-		}		
-		else {
-			byte[0] = (byte[0] | nybble);
-			add(this, byte, sizeof(byte));
-			first_nybble = true;
-		}
+	bp = S->bf + S->used;
+	for (lp= 0; lp < (hexbufr_length / 2); ++lp) {
+		hi = Nybble[*p++];
+		lo = Nybble[*p++];
+		bad |= (hi == 0) | (lo == 0);
+		*bp++ = ((hi - 1U) << 4) | ((lo - 1U) & 0xf);
 	}
+	if ( bad ) {
+		S->poisoned = true;
+		goto done;
+	}
+
+	S->used += hexbufr_length / 2;
+	++Stats.appends;
 	retn = true;
 
 
@@ -613,7 +646,8 @@ static void dump(CO(Buffer, this), int offset)
 	root->iprint(root, offset, __FILE__ " dump: %p\n", this);
 	root->iprint(root, offset, "\tbufr: %p\n", S->bf);
 	root->iprint(root, offset, "\tused: %u\n", S->used);
-	root->iprint(root, offset, "\tallocated: %u\n", S->seqn->get(S->seqn));
+	root->iprint(root, offset, "\tallocated: %zu%s\n", S->capacity, \
+		     S->bf == S->inline_bf ? " (inline)" : "");
 	root->iprint(root, offset, "\tstatus: %s\n", S->poisoned ? \
 		     "POISONED" : "OK");
 
@@ -662,9 +696,9 @@ static void whack(CO(Buffer, this))
 {
 	STATE(S);
 
-	if ( S->bf != NULL )
-		memset(S->bf, '\0', S->seqn->get(S->seqn));
-	free(S->bf);
+	memset(S->bf, '\0', S->capacity);
+	if ( S->bf != S->inline_bf )
+		free(S->bf);
 
 	S->seqn->whack(S->seqn);
 	S->root->whack(S->root, this, S);
@@ -716,6 +750,7 @@ extern Buffer HurdLib_Buffer_Init(void)
 	this->add     	    = add;
 	this->add_Buffer    = add_Buffer;
 	this->add_hexstring = add_hexstring;
+	this->reserve	    = reserve;
 	this->equal	    = equal;
 
 	this->get     	    = get;
@@ -730,3 +765,23 @@ extern Buffer HurdLib_Buffer_Init(void)
 
 	return this;
 }
+
+
+/**
+ * External function.
+ *
+ * This function returns the allocation statistics which have been
+ * accumulated by all of the Buffer objects in the program.  The
+ * statistics are maintained without locking and are intended for
+ * benchmarking purposes.
+ *
+ * \param stats	A pointer to the structure which the statistics are
+ *		to be copied into.
+ */
+
+extern void HurdLib_Buffer_stats(struct HurdLib_Buffer_stats *stats)
+
+{
+	*stats = Stats;
+	return;
+}
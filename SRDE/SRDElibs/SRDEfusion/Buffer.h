@@ -15,6 +15,16 @@
 #define HurdLib_Buffer_HEADER
 
 
+/* Size of the storage area used for small buffers. */
+#define BUFFER_INLINE_SIZE 64
+
+/* Allocation statistics for Buffer objects. */
+struct HurdLib_Buffer_stats {
+	unsigned long int appends;
+	unsigned long int allocations;
+};
+
+
 /* Object type definitions. */
 typedef struct HurdLib_Buffer * Buffer;
 
@@ -29,6 +39,7 @@ struct HurdLib_Buffer
 	_Bool (*add)(const Buffer, unsigned char const *, size_t);
 	_Bool (*add_Buffer)(const Buffer, const Buffer);
 	_Bool (*add_hexstring)(const Buffer, char const *);
+	_Bool (*reserve)(const Buffer, size_t);
 	_Bool (*equal)(const Buffer, const Buffer);
 
 	unsigned char * (*get)(const Buffer);
@@ -48,4 +59,7 @@ struct HurdLib_Buffer
 
 /* Buffer constructor call. */
 extern HCLINK Buffer HurdLib_Buffer_Init(void);
+
+/* Buffer allocation statistics. */
+extern HCLINK void HurdLib_Buffer_stats(struct HurdLib_Buffer_stats *);
 #endif
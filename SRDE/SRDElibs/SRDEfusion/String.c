@@ -108,12 +108,8 @@ static _Bool add(const String const this, char const * const src)
 
 	S->buffer->shrink(S->buffer, 1);
 
-	if ( !S->buffer->add(S->buffer, (unsigned char *) src, strlen(src)) )
-		return false;
-	if ( !S->buffer->add(S->buffer, (unsigned char *) "\0", 1) )
-		return false;
-
-	return true;
+	return S->buffer->add(S->buffer, (unsigned char *) src, \
+			      strlen(src) + 1);
 }
 
 
@@ -153,12 +149,13 @@ static _Bool add_sprintf(CO(String, this), CO(char *, fmt), ...)
 
 	int rc;
 
-	unsigned int lp;
-
-	size_t add,
+	size_t cnt,
+	       add,
 	       nullposn,
 	       needed;
 
+	static const unsigned char pad[BUFFER_INLINE_SIZE];
+
 	va_list ap;
 
 
@@ -180,9 +177,13 @@ static _Bool add_sprintf(CO(String, this), CO(char *, fmt), ...)
 		--add;
 	}
 
-	for (lp=0; lp < add; ++lp) {
-		if ( !S->buffer->add(S->buffer, (void *) "\0", 1) )
+	if ( !S->buffer->reserve(S->buffer, add) )
+		goto done;
+	while ( add > 0 ) {
+		cnt = add > sizeof(pad) ? sizeof(pad) : add;
+		if ( !S->buffer->add(S->buffer, pad, cnt) )
 			goto done;
+		add -= cnt;
 	}
 
 
@@ -205,6 +206,31 @@ static _Bool add_sprintf(CO(String, this), CO(char *, fmt), ...)
 }
 
 
+/**
+ * External public method.
+ *
+ * This method implements pre-allocation of storage for characters
+ * which are to be subsequently added to the string.
+ *
+ * \param this	A pointer to the object whose storage is to be
+ *		expanded.
+ *
+ * \param cnt	The number of characters to be reserved.
+ *
+ * \return	A boolean value is returned to indicate the status of
+ *		the reservation.  A true value indicates success.
+ */
+
+static _Bool reserve(CO(String, this), size_t const cnt)
+
+{
+	STATE(S);
+
+
+	return S->buffer->reserve(S->buffer, cnt + 1);
+}
+
+
 /**
  * External public method.
  *
@@ -379,6 +405,7 @@ extern String HurdLib_String_Init(void)
 	/* Method initialization. */
 	this->add	  = add;
 	this->add_sprintf = add_sprintf;
+	this->reserve	  = reserve;
 
 	this->get	= get;
 	this->size	= size;
@@ -31,6 +31,7 @@ struct HurdLib_String
 	/* External methods. */
 	_Bool (*add)(const String, char const *);
 	_Bool (*add_sprintf)(const String, const char *, ...);
+	_Bool (*reserve)(const String, size_t);
 
 	char * (*get)(const String);
 	size_t (*size)(const String);
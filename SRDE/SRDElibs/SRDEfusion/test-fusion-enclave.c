@@ -167,6 +167,103 @@ static void test_four(void)
 }
 
 
+/*
+ * Test five is an allocation benchmark based on a security model
+ * update workload.  Each event generates a description, a 32 byte
+ * state point and an extension of the model measurement.
+ */
+
+#define MODEL_EVENTS 1000
+
+static void test_five(void)
+
+{
+	unsigned int lp;
+
+	struct HurdLib_Buffer_stats start,
+				    end;
+
+	sgx_sha256_hash_t digest;
+
+	Buffer point	   = NULL,
+	       points	   = NULL,
+	       measurement = NULL;
+
+	String event = NULL;
+
+
+	fputs("Test number: 5\n", stdout);
+
+	INIT(HurdLib, Buffer, points, ERR(goto done));
+	INIT(HurdLib, Buffer, measurement, ERR(goto done));
+
+	memset(digest, '\0', sizeof(digest));
+	if ( !measurement->add(measurement, digest, sizeof(digest)) )
+		ERR(goto done);
+
+	HurdLib_Buffer_stats(&start);
+
+	for (lp= 0; lp < MODEL_EVENTS; ++lp) {
+		INIT(HurdLib, String, event, ERR(goto done));
+		INIT(HurdLib, Buffer, point, ERR(goto done));
+
+		if ( !event->add_sprintf(event, "file_open{process=test, " \
+					 "pid=%u, uid=0, euid=0, ", lp) )
+			ERR(goto done);
+		if ( !event->add(event, "file{flags=32800, " \
+				 "digest=0000000000000000000000000000000}}") )
+			ERR(goto done);
+
+		if ( sgx_sha256_msg((void *) event->get(event),	    \
+				    event->size(event), &digest) != \
+		     SGX_SUCCESS )
+			ERR(goto done);
+		if ( !point->add(point, digest, sizeof(digest)) )
+			ERR(goto done);
+		if ( !points->add_Buffer(points, point) )
+			ERR(goto done);
+
+		if ( !measurement->add_Buffer(measurement, point) )
+			ERR(goto done);
+		if ( sgx_sha256_msg(measurement->get(measurement),	 \
+				    measurement->size(measurement), &digest) \
+		     != SGX_SUCCESS )
+			ERR(goto done);
+		measurement->reset(measurement);
+		if ( !measurement->add(measurement, digest, sizeof(digest)) )
+			ERR(goto done);
+
+		WHACK(event);
+		WHACK(point);
+	}
+
+	HurdLib_Buffer_stats(&end);
+
+	fprintf(stdout, "Events: %u, points: %zu bytes\n", MODEL_EVENTS, \
+		points->size(points));
+	fputs("Measurement: ", stdout);
+	measurement->print(measurement);
+
+	/*
+	 * The previous implementation called the allocator on every
+	 * append, one byte at a time for formatted strings, so the
+	 * append count is a lower bound on its allocation count.
+	 */
+	fprintf(stdout, "Appends: %lu\n", end.appends - start.appends);
+	fprintf(stdout, "Allocations: %lu\n", \
+		end.allocations - start.allocations);
+
+
+ done:
+	WHACK(point);
+	WHACK(points);
+	WHACK(measurement);
+	WHACK(event);
+
+	return;
+}
+
+
 static void test_lost_object(void)
 
 {
@@ -197,6 +294,9 @@ void test_fusion(int test)
 		case 4:
 			test_four();
 			break;
+		case 5:
+			test_five();
+			break;
 		case 100:
 			test_lost_object();
 			break;
@@ -57,12 +57,13 @@
  * The following structure is used to define an enclave program segment.
  * For simplicity sake the structure uses the ELF program header to
  * save all of the information about the segment.   The physical data
- * is saved in the Buffer object which the structure references.
+ * is referenced in place in the memory image of the enclave so pages
+ * are passed to the enclave without an intermediate copy.
  */
 struct segment {
 	uint64_t flags;
 	Elf64_Phdr phdr;
-	Buffer data;
+	uint8_t *data;
 };
 
 
@@ -91,9 +92,6 @@ struct NAAAIM_SRDEloader_State
 	void *soimage;
 	size_t sosize;
 
-	/* ELF library descriptor. */
-	Elf *elf;
-
 	/* SGX metadata. */
 	SRDEmetadata metadata;
 
@@ -222,12 +220,7 @@ static _Bool _pt_load_segment(CO(SRDEloader_State, S), CO(Elf64_Phdr *, phdr))
 		segment.flags |= SGX_SECINFO_X;
 
 	segment.phdr = *phdr;
-
-	INIT(HurdLib, Buffer, segment.data, ERR(goto done));
-
-	if ( !segment.data->add(segment.data, S->soimage + phdr->p_offset, \
-				phdr->p_filesz) )
-		ERR(goto done);
+	segment.data = (uint8_t *) S->soimage + phdr->p_offset;
 
 	if ( !S->segments->add(S->segments, (unsigned char *) &segment, \
 			       sizeof(struct segment)) )
@@ -281,11 +274,91 @@ static _Bool _build_relocation_map(CO(SRDEloader_State, S))
 }
 
 
+/**
+ * Internal private method.
+ *
+ * This method parses the ELF program headers of the enclave image in
+ * place.  References to the loadable segments and the dynamic section
+ * are saved after verifying they are contained in the image.
+ *
+ * \param S	A pointer to the internal state of the loader object
+ *		whose image is to be parsed.
+ *
+ * \return	If an error is encountered while parsing the image a
+ *		false value is returned.  A true value indicates the
+ *		segments were saved.
+ */
+
+static _Bool _load_image(CO(SRDEloader_State, S))
+
+{
+	_Bool retn = false;
+
+	uint32_t segindex;
+
+	Elf64_Ehdr *ehdr = S->soimage;
+
+	Elf64_Phdr *phdr;
+
+
+	/* Verify the ELF header and the program header table. */
+	if ( S->sosize < sizeof(Elf64_Ehdr) )
+		ERR(goto done);
+	if ( memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 )
+		ERR(goto done);
+	if ( ehdr->e_ident[EI_CLASS] != ELFCLASS64 )
+		ERR(goto done);
+	if ( ehdr->e_phentsize != sizeof(Elf64_Phdr) )
+		ERR(goto done);
+	if ( (ehdr->e_phoff > S->sosize) || \
+	     ((ehdr->e_phnum * sizeof(Elf64_Phdr)) > \
+	      (S->sosize - ehdr->e_phoff)) )
+		ERR(goto done);
+
+
+	/*
+	 * Iterate through the program segments and save references to
+	 * relevant segments.
+	 */
+	phdr = (Elf64_Phdr *) (S->soimage + ehdr->e_phoff);
+
+	for(segindex= 0; segindex < ehdr->e_phnum; ++segindex, ++phdr) {
+		if ( (phdr->p_type != PT_LOAD) && (phdr->p_type != PT_DYNAMIC) )
+			continue;
+		if ( (phdr->p_offset > S->sosize) || \
+		     (phdr->p_filesz > (S->sosize - phdr->p_offset)) )
+			ERR(goto done);
+
+		if ( phdr->p_type == PT_LOAD ) {
+			if ( !_pt_load_segment(S, phdr) )
+				ERR(goto done);
+		}
+		if ( phdr->p_type == PT_DYNAMIC )
+			S->dynptr = (Elf64_Dyn *) (S->soimage + \
+						   phdr->p_offset);
+	}
+
+	if ( _build_relocation_map(S) ) {
+		fputs("Writable TEXT relocations present but not " \
+		      "supported.\n", stderr);
+		goto done;
+	}
+
+	retn = true;
+
+
+ done:
+	return retn;
+}
+
+
 /**
  * External public method.
  *
  * This method implements the loading of the SGX binary data from the
- * enclave file.
+ * enclave file.  The file is mapped privately and the metadata and
+ * program headers are parsed in place.  Patches are applied to the
+ * mapping so only the pages which are patched are copied.
  *
  * \param this		A pointer to the object which is to hold the
  *			metadata.
@@ -308,32 +381,14 @@ static _Bool load(CO(SRDEloader, this), CO(char *, enclave), const _Bool debug)
 
 	_Bool retn = false;
 
-	uint32_t segindex;
-
-	size_t phnum;
-
 	struct stat statbuf;
 
-	Elf64_Ehdr *ehdr;
-
-	Elf64_Phdr *phdr;
-
 
 	/* Sanity check the object. */
 	if ( S->poisoned )
 		goto done;
 
 
-	/* Load the SGA metadata. */
-	INIT(NAAAIM, SRDEmetadata, S->metadata, ERR(goto done));
-	if ( S->debug )
-		S->metadata->debug(S->metadata, true);
-	if ( !S->metadata->load(S->metadata, enclave) )
-		ERR(goto done);
-	if ( !S->metadata->compute_attributes(S->metadata, debug) )
-		ERR(goto done);
-
-
 	/* Open the shared object enclave and memory map the file. */
 	if ( (S->fd = open(enclave, O_RDONLY, 0)) < 0 )
 		ERR(goto done);
@@ -342,47 +397,29 @@ static _Bool load(CO(SRDEloader, this), CO(char *, enclave), const _Bool debug)
 		ERR(goto done);
 	S->sosize = statbuf.st_size;
 	if ( (S->soimage = mmap(NULL, S->sosize, PROT_READ | PROT_WRITE, \
-				MAP_PRIVATE, S->fd, 0)) == NULL )
+				MAP_PRIVATE, S->fd, 0)) == MAP_FAILED ) {
+		S->soimage = NULL;
 		ERR(goto done);
+	}
 
 
-	/* Patch the enclave shared image. */
-	S->metadata->patch_enclave(S->metadata, S->soimage);
-
-
-	/* Setup and initialize ELF access to the enclave. */
-	if ( elf_version(EV_CURRENT) == EV_NONE )
-		ERR(goto done);
-	if ( (S->elf = elf_begin(S->fd, ELF_C_READ, NULL)) == NULL )
+	/* Load the SGX metadata from the mapped image. */
+	INIT(NAAAIM, SRDEmetadata, S->metadata, ERR(goto done));
+	if ( S->debug )
+		S->metadata->debug(S->metadata, true);
+	if ( !S->metadata->load_memory(S->metadata, S->soimage, S->sosize) )
 		ERR(goto done);
-	if ( (ehdr = elf64_getehdr(S->elf)) == NULL )
+	if ( !S->metadata->compute_attributes(S->metadata, debug) )
 		ERR(goto done);
 
 
-	/*
-	 * Iterate through the program segments and save references to
-	 * relevant segments.
-	 */
-	if ( elf_getphdrnum(S->elf, &phnum) == -1 )
-		ERR(goto done);
-	if ( (phdr = elf64_getphdr(S->elf)) == NULL )
-		ERR(goto done);
+	/* Patch the enclave shared image. */
+	S->metadata->patch_enclave(S->metadata, S->soimage);
 
-	for(segindex= 0; segindex < phnum; ++segindex, ++phdr) {
-		if ( phdr->p_type == PT_LOAD ) {
-			if ( !_pt_load_segment(S, phdr) )
-				ERR(goto done);
-		}
-		if ( phdr->p_type == PT_DYNAMIC )
-			S->dynptr = (Elf64_Dyn *) (S->soimage + \
-						   phdr->p_offset);
-	}
 
-	if ( _build_relocation_map(S) ) {
-		fputs("Writable TEXT relocations present but not " \
-		      "supported.\n", stderr);
-		goto done;
-	}
+	/* Locate the program segments. */
+	if ( !_load_image(S) )
+		ERR(goto done);
 
 	retn = true;
 
@@ -484,14 +521,6 @@ static _Bool load_memory(CO(SRDEloader, this), const char * enclave, \
 
 	_Bool retn = false;
 
-	uint32_t segindex;
-
-	size_t phnum;
-
-	Elf64_Ehdr *ehdr;
-
-	Elf64_Phdr *phdr;
-
 
 	/* Sanity check the object. */
 	if ( S->poisoned )
@@ -522,39 +551,9 @@ static _Bool load_memory(CO(SRDEloader, this), const char * enclave, \
 	S->metadata->patch_enclave(S->metadata, S->soimage);
 
 
-	/* Setup and initialize ELF access to the enclave. */
-	if ( elf_version(EV_CURRENT) == EV_NONE )
-		ERR(goto done);
-	if ( (S->elf = elf_memory(S->soimage, S->sosize)) == NULL )
-		ERR(goto done);
-	if ( (ehdr = elf64_getehdr(S->elf)) == NULL )
-		ERR(goto done);
-
-
-	/*
-	 * Iterate through the program segments and save references to
-	 * relevant segments.
-	 */
-	if ( elf_getphdrnum(S->elf, &phnum) == -1 )
+	/* Locate the program segments. */
+	if ( !_load_image(S) )
 		ERR(goto done);
-	if ( (phdr = elf64_getphdr(S->elf)) == NULL )
-		ERR(goto done);
-
-	for(segindex= 0; segindex < phnum; ++segindex, ++phdr) {
-		if ( phdr->p_type == PT_LOAD ) {
-			if ( !_pt_load_segment(S, phdr) )
-				ERR(goto done);
-		}
-		if ( phdr->p_type == PT_DYNAMIC )
-			S->dynptr = (Elf64_Dyn *) (S->soimage + \
-						   phdr->p_offset);
-	}
-
-	if ( _build_relocation_map(S) ) {
-		fputs("Writable TEXT relocations present but not " \
-		      "supported.\n", stderr);
-		goto done;
-	}
 
 	retn = true;
 
@@ -759,7 +758,7 @@ static _Bool _build_segment(CO(SRDEenclave, enclave),	   \
 
 	memset(&secinfo, '\0', sizeof(struct SGX_secinfo));
 
-	data_ptr = (uint8_t *) segment->data->get(segment->data);
+	data_ptr = segment->data;
 	if ( offset == 0 )
 		data_ptr += 4096;
 	else
@@ -829,8 +828,15 @@ static _Bool _build_segment(CO(SRDEenclave, enclave),	   \
 			size = segment->phdr.p_memsz - (loaded - offset);
 		size = r2p(size);
 
+		/*
+		 * Version 1.3 metadata was generated by a signer which
+		 * adds the page rounded size of the uninitialized data
+		 * after the file data, regardless of whether or not the
+		 * last file page covers part of it.
+		 */
 		if ( compatibility & NULL_PADDING_NEEDED )
-			size += 4096;
+			size = r2p(segment->phdr.p_memsz - \
+				   segment->phdr.p_filesz);
 
 		if ( debug ) {
 			fprintf(stdout, "\tMemory/file size mismatch, "	      \
@@ -926,7 +932,7 @@ static _Bool _build_segment(CO(SRDEenclave, enclave),	   \
 	 segptr = (struct segment *) S->segments->get(S->segments);
 
 	 for (lp= 0; lp < segcnt; ++lp, ++segptr) {
-		 data = segptr->data->get(segptr->data);
+		 data = segptr->data;
 
 		 if ( segptr->phdr.p_vaddr > max_rva )
 			 max_rva = segptr->phdr.p_vaddr;
@@ -1172,7 +1178,7 @@ static void dump(CO(SRDEloader, this))
 
 	Elf64_Dyn *dynptr = S->dynptr;
 
-	Buffer bf;
+	Buffer bf = NULL;
 
 
 	segcnt = S->segments->size(S->segments) / sizeof(struct segment);
@@ -1190,8 +1196,10 @@ static void dump(CO(SRDEloader, this))
 		fprintf(stdout, "\tenclave flags: 0x%lx\n", segptr->flags);
 
 		fprintf(stdout, "\nSegment #%d contents:\n", lp);
-		bf = segptr->data;
-		bf->hprint(bf);
+		INIT(HurdLib, Buffer, bf, return);
+		if ( bf->add(bf, segptr->data, segptr->phdr.p_filesz) )
+			bf->hprint(bf);
+		WHACK(bf);
 		fputc('\n', stdout);
 	}
 
@@ -1218,28 +1226,15 @@ static void whack(CO(SRDEloader, this))
 {
 	STATE(S);
 
-	uint32_t lp,
-		 segcnt;
-
-	struct segment *segptr;
 
+	/* The metadata references the image so it is released first. */
+	WHACK(S->metadata);
 
 	if ( S->soimage != NULL )
 		munmap(S->soimage, S->sosize);
-	if ( S->elf != NULL )
-		elf_end(S->elf);
 	if ( S->fd != -1 )
 		close(S->fd);
 
-	WHACK(S->metadata);
-
-	if ( S->segments != NULL ) {
-		segcnt = S->segments->size(S->segments) \
-			/ sizeof(struct segment);
-		segptr = (struct segment *) S->segments->get(S->segments);
-		for (lp= 0; lp < segcnt; ++lp, ++segptr)
-			WHACK(segptr->data);
-	}
 	WHACK(S->segments);
 
 	S->root->whack(S->root, this, S);
@@ -344,7 +344,7 @@ static _Bool load(CO(SRDEmetadata, this), CO(char *, enclave))
 		ERR(goto done);
 	if ( (S->fd = open(enclave, O_RDONLY, 0)) < 0 )
 		ERR(goto done);
-	if ( (S->elf = elf_begin(S->fd, ELF_C_READ, NULL)) == NULL )
+	if ( (S->elf = elf_begin(S->fd, ELF_C_READ_MMAP, NULL)) == NULL )
 		ERR(goto done);
 	if ( (ehdr = elf64_getehdr(S->elf)) == NULL )
 		ERR(goto done);
@@ -359,26 +359,30 @@ static _Bool load(CO(SRDEmetadata, this), CO(char *, enclave))
 		ERR(goto done);
 
 
-	/* Iterate through the sections looking for the metadata section.. */
+	/*
+	 * Iterate through the sections looking for the metadata section.
+	 * Only the section headers are examined for the remaining
+	 * sections so their contents are not read.
+	 */
 	for (index= 1; index < ehdr->e_shnum; index++) {
 		if ( (section = elf_getscn(S->elf, index)) == NULL )
 			ERR(goto done);
 		if ( (shdr = elf64_getshdr(section)) == NULL )
 			ERR(goto done);
+		if ( strcmp((char *) (name_data->d_buf + shdr->sh_name),
+			    ".note.sgxmeta") != 0 )
+			continue;
+
 		if ( (data = elf_getdata(section, NULL)) == NULL )
 			ERR(goto done);
 
-		if ( strcmp((char *) (name_data->d_buf + shdr->sh_name),
-			    ".note.sgxmeta") == 0 ) {
-			name_size = *((uint32_t *) data->d_buf);
-			S->section_size = *((uint32_t *) (data->d_buf + \
-							  sizeof(uint32_t)));
-			metaptr = data->d_buf + (3 * sizeof(uint32_t)) + \
-				name_size;
-
-			if ( !_load_metadata(this, metaptr) )
-				ERR(goto done);
-		}
+		name_size = *((uint32_t *) data->d_buf);
+		S->section_size = *((uint32_t *) (data->d_buf + \
+						  sizeof(uint32_t)));
+		metaptr = data->d_buf + (3 * sizeof(uint32_t)) + name_size;
+
+		if ( !_load_metadata(this, metaptr) )
+			ERR(goto done);
 	}
 
 
@@ -422,6 +426,8 @@ static _Bool load(CO(SRDEmetadata, this), CO(char *, enclave))
 			close(S->fd);
 		if ( S->elf != NULL )
 			elf_end(S->elf);
+		S->fd  = -1;
+		S->elf = NULL;
 	}
 
 	return retn;
@@ -503,26 +509,30 @@ static _Bool load_memory(CO(SRDEmetadata, this), char * enclave, \
 		ERR(goto done);
 
 
-	/* Iterate through the sections looking for the metadata section.. */
+	/*
+	 * Iterate through the sections looking for the metadata section.
+	 * Only the section headers are examined for the remaining
+	 * sections so their contents are not read.
+	 */
 	for (index= 1; index < ehdr->e_shnum; index++) {
 		if ( (section = elf_getscn(S->elf, index)) == NULL )
 			ERR(goto done);
 		if ( (shdr = elf64_getshdr(section)) == NULL )
 			ERR(goto done);
+		if ( strcmp((char *) (name_data->d_buf + shdr->sh_name),
+			    ".note.sgxmeta") != 0 )
+			continue;
+
 		if ( (data = elf_getdata(section, NULL)) == NULL )
 			ERR(goto done);
 
-		if ( strcmp((char *) (name_data->d_buf + shdr->sh_name),
-			    ".note.sgxmeta") == 0 ) {
-			name_size = *((uint32_t *) data->d_buf);
-			S->section_size = *((uint32_t *) (data->d_buf + \
-							  sizeof(uint32_t)));
-			metaptr = data->d_buf + (3 * sizeof(uint32_t)) + \
-				name_size;
-
-			if ( !_load_metadata(this, metaptr) )
-				ERR(goto done);
-		}
+		name_size = *((uint32_t *) data->d_buf);
+		S->section_size = *((uint32_t *) (data->d_buf + \
+						  sizeof(uint32_t)));
+		metaptr = data->d_buf + (3 * sizeof(uint32_t)) + name_size;
+
+		if ( !_load_metadata(this, metaptr) )
+			ERR(goto done);
 	}
 
 
@@ -564,6 +574,7 @@ static _Bool load_memory(CO(SRDEmetadata, this), char * enclave, \
 	if ( !retn ) {
 		if ( S->elf != NULL )
 			elf_end(S->elf);
+		S->elf = NULL;
 	}
 
 	return retn;
@@ -29,7 +29,6 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
-#include <regex.h>
 
 #include <arpa/inet.h>
 
@@ -48,10 +47,6 @@
 #include "PCEenclave.h"
 #include "SRDEquote.h"
 
-#if !defined(REG_OK)
-#define REG_OK REG_NOERROR
-#endif
-
 
 /* Object state extraction macro. */
 #define STATE(var) CO(SRDEquote_State, var) = this->state
@@ -328,6 +323,50 @@ static const char *Quote_status[] = {
 };
 
 
+/**
+ * The following enumeration and array define the fields which are
+ * extracted from an attestation report by the ->decode_report method.
+ * The names of the header fields are in lower case since they are
+ * matched without regard to case.
+ */
+enum report_fields {
+	field_signature=0,
+	field_certificate,
+	field_report,
+	field_version,
+	field_id,
+	field_timestamp,
+	field_nonce,
+	field_quote_status,
+	field_quote_body,
+	field_platform_info,
+	field_end
+};
+
+static const char *Report_fields[] = {
+	"x-iasreport-signature",
+	"x-iasreport-signing-certificate",
+	NULL,
+	"version",
+	"id",
+	"timestamp",
+	"nonce",
+	"isvEnclaveQuoteStatus",
+	"isvEnclaveQuoteBody",
+	"platformInfoBlob"
+};
+
+
+/**
+ * The following structure describes the location of a field in an
+ * attestation report which is being decoded.
+ */
+struct report_field {
+	const char *value;
+	size_t length;
+};
+
+
 /**
  * The following structure defines the information 'blob' that is
  * returned from the Intel attestation servers if the EPID group
@@ -735,334 +774,218 @@ static _Bool generate_report(CO(SRDEquote, this), CO(Buffer, quote), \
 /**
  * Internal private function.
  *
- * This method parses the supplied input for conformance with the
- * version of IAS services that the SRDEquote object is designed to
- * handle.  It is a subordinate helper function for the ->decode_report
- * method.
+ * This function compares the name of a header or JSON field with
+ * the input being scanned without regard to the case of the
+ * letters in the name.
  *
- * \param field	The object containing the field to be parsed.
+ * \param p	A pointer to the input being scanned.
  *
- * \param rgx	The object which is to be used to create the
- *		regular expression.
+ * \param name	A pointer to the null-terminated buffer containing
+ *		the name to be compared.
  *
- * \param value	A pointer to the object that will be loaded with
- *		the parsed field value.
+ * \param len	The length of the name.
  *
- * \return	A boolean value is used to indicate the success or
- *		failure of the field extraction.  A false value is
- *		used to indicate a failure occurred during the field
- *		entry extraction.  A true value indicates the
- *		field has been successfully extracted and the value
- *		variable contains a legitimate value.
+ * \return	A boolean value is used to indicate whether or not
+ *		the input matches the name.
  */
 
-static _Bool _get_version(CO(String, field), CO(String, rgx), \
-			  CO(String, value))
+static _Bool _name_match(const char *p, const char *name, size_t len)
 
 {
-	_Bool retn       = false,
-	      have_regex = false;
-
-	char *fp,
-	     element[2];
+	char c;
 
-	size_t len;
-
-	regex_t regex;
-
-	regmatch_t regmatch[2];
-
-
-	/* Extract the field element. */
-	rgx->reset(rgx);
-	if ( !rgx->add(rgx, "[,{]\"version\":([^,}]*).*") )
-		ERR(goto done);
-	value->reset(value);
-
-
-	if ( regcomp(&regex, rgx->get(rgx), REG_EXTENDED) != 0 )
-		ERR(goto done);
-	have_regex = true;
-
-	if ( regexec(&regex, field->get(field), 2, regmatch, 0) != REG_OK )
-		ERR(goto done);
-
-	len = regmatch[1].rm_eo - regmatch[1].rm_so;
-	if ( len > field->size(field) )
-		ERR(goto done);
-
-
-	/* Copy the field element to the output object. */
-	memset(element, '\0', sizeof(element));
-	fp = field->get(field) + regmatch[1].rm_so;
 
 	while ( len-- ) {
-		element[0] = *fp;
-		value->add(value, element);
-		++fp;
+		c = *p++;
+		if ( (c >= 'A') && (c <= 'Z') )
+			c += 'a' - 'A';
+		if ( c != *name++ )
+			return false;
 	}
-	if ( value->poisoned(value) )
-		ERR(goto done);
 
-	retn = true;
-
-
- done:
-	if ( have_regex )
-		regfree(&regex);
-
-	return retn;
+	return true;
 }
 
 
 /**
  * Internal private function.
  *
- * This method parses the supplied input and extracts the brace
- * delimited report.
+ * This function skips the whitespace which may separate the elements
+ * of a JSON object.
  *
- * \param field		The object containing the field to be parsed.
+ * \param p	A pointer to the input being scanned.
  *
- * \param value		A pointer to the object that will be loaded
- *			with the parsed report.
- *
- * \return	A boolean value is used to indicate the success or
- *		failure of the report extraction.  A false value is
- *		used to indicate a failure occurred during the
- *		extraction.  A true value indicates the report has
- *		been successfully extracted and the value object
- *		contains a legitimate value.
+ * \return	A pointer to the first character in the input which is
+ *		not whitespace.
  */
 
-static _Bool _get_report(CO(String, field), CO(String, report))
+static const char *_skip_space(const char *p)
 
 {
-	_Bool retn       = false,
-	      have_regex = false;
-
-	char *fp,
-	     element[2];
-
-	const char *rgx = "(\\{[^\\}]*\\})";
-
-	size_t len;
-
-	regex_t regex;
-
-	regmatch_t regmatch[2];
-
-
-	/* Match the report field. */
-	if ( regcomp(&regex, rgx, REG_EXTENDED) != 0 )
-		ERR(goto done);
-	have_regex = true;
-
-	if ( regexec(&regex, field->get(field), 2, regmatch, 0) != REG_OK )
-		ERR(goto done);
-
-	len = regmatch[1].rm_eo - regmatch[1].rm_so;
-	if ( len > field->size(field) )
-		ERR(goto done);
-
-
-	/* Copy the field element to the output object. */
-	memset(element, '\0', sizeof(element));
-	fp = field->get(field) + regmatch[1].rm_so;
-
-	while ( len-- ) {
-		element[0] = *fp;
-		report->add(report, element);
-		++fp;
-	}
-	if ( report->poisoned(report) )
-		ERR(goto done);
-
-	retn = true;
-
-
- done:
-	if ( have_regex )
-		regfree(&regex);
-
-	return retn;
+	while ( (*p == ' ') || (*p == '\t') || (*p == '\r') || (*p == '\n') )
+		++p;
+	return p;
 }
 
 
 /**
  * Internal private function.
  *
- * This method parses the supplied input for a single JSON field.  It
- * is a subordinate helper function for the ->decode_report method.
- *
- * \param noerr	A flag variable used to indicate that an error
- *		condition should not be generated if there is
- *		no field match.
- *
- * \param field	The object containing the field to be parsed.
+ * This method scans an attestation report in a single pass and
+ * records the location of each of the fields which the ->decode_report
+ * method extracts.  The signature and certificate are taken from the
+ * HTTP header lines which precede the brace delimited report, the
+ * remaining fields are the members of the report itself.
  *
- * \param rgx	The object which is to be used to create the
- *		regular expression.
+ * \param report	The object containing the attestation report.
  *
- * \param fd	The field descriptor tag which is to be returned.
+ * \param fields	A pointer to the array of field descriptors,
+ *			indexed by the report_field enumeration, which
+ *			are to be loaded.  A field which is not present
+ *			in the report is left with a NULL value.
  *
- * \param value	A pointer to the object that will be loaded with
- *		the parsed field value.
- *
- * \return	A boolean value is used to indicate the success or
- *		failure of the field extraction.  A false value is
- *		used to indicate a failure occurred during the field
- *		entry extraction.  A true value indicates the
- *		field has been successfully extracted and the value
- *		variable contains a legitimate value.
+ * \return	A boolean value is used to indicate whether or not the
+ *		report was scanned.  A false value indicates the report
+ *		is not in the expected format.
  */
 
-static _Bool _get_field(const _Bool noerr, CO(String, field), \
-			CO(String, rgx), CO(char *, fd), CO(String, value))
+static _Bool _scan_report(CO(String, report), struct report_field *fields)
 
 {
-	_Bool retn       = false,
-	      have_regex = false;
+	const char *p = report->get(report),
+		   *eol,
+		   *key,
+		   *value;
 
-	char *fp,
-	     element[2];
+	size_t lp,
+	       len,
+	       key_len,
+	       value_len;
 
-	size_t len;
-
-	regex_t regex;
-
-	regmatch_t regmatch[2];
 
+	for (lp= 0; lp < field_end; ++lp) {
+		fields[lp].value  = NULL;
+		fields[lp].length = 0;
+	}
 
-	/* Extract the field element. */
-	value->reset(value);
 
-	rgx->reset(rgx);
-	rgx->add(rgx, ".*\"");
-	rgx->add(rgx, fd);
-	if ( !rgx->add(rgx, "\":\"([^\"]*).*") )
-		ERR(goto done);
+	/* Locate the header fields ahead of the report. */
+	while ( (*p != '\0') && (*p != '{') ) {
+		if ( (eol = strchr(p, '\r')) == NULL )
+			break;
 
-	if ( regcomp(&regex, rgx->get(rgx), REG_EXTENDED) != 0 )
-		ERR(goto done);
-	have_regex = true;
+		for (lp= field_signature; lp <= field_certificate; ++lp) {
+			len = strlen(Report_fields[lp]);
+			if ( ((size_t) (eol - p) < (len + 2)) || \
+			     !_name_match(p, Report_fields[lp], len) || \
+			     (p[len] != ':') || (p[len + 1] != ' ') )
+				continue;
+			fields[lp].value  = p + len + 2;
+			fields[lp].length = eol - fields[lp].value;
+		}
 
-	if ( regexec(&regex, field->get(field), 2, regmatch, 0) != REG_OK ) {
-		if ( noerr )
-			goto done;
-		ERR(goto done);
+		p = eol + 1;
+		if ( *p == '\n' )
+			++p;
 	}
 
-	len = regmatch[1].rm_eo - regmatch[1].rm_so;
-	if ( len > field->size(field) )
-		ERR(goto done);
-
+	if ( (p = strchr(p, '{')) == NULL )
+		ERR(return false);
+	fields[field_report].value = p;
+
+
+	/* Locate the members of the report. */
+	p = _skip_space(p + 1);
+	while ( *p != '}' ) {
+		if ( *p++ != '"' )
+			ERR(return false);
+		key = p;
+		if ( (p = strchr(p, '"')) == NULL )
+			ERR(return false);
+		key_len = p - key;
+
+		p = _skip_space(p + 1);
+		if ( *p++ != ':' )
+			ERR(return false);
+		p = _skip_space(p);
+
+		if ( *p == '"' ) {
+			value = ++p;
+			if ( (p = strchr(p, '"')) == NULL )
+				ERR(return false);
+			value_len = p++ - value;
+		} else {
+			value = p;
+			if ( *p == '[' ) {
+				if ( (p = strchr(p, ']')) == NULL )
+					ERR(return false);
+				++p;
+			} else
+				p += strcspn(p, ",} \t\r\n");
+			value_len = p - value;
+		}
 
-	/* Copy the field element to the output object. */
-	memset(element, '\0', sizeof(element));
-	fp = field->get(field) + regmatch[1].rm_so;
+		for (lp= field_version; lp < field_end; ++lp) {
+			if ( (key_len == strlen(Report_fields[lp])) && \
+			     (memcmp(key, Report_fields[lp], key_len) == 0) ) {
+				fields[lp].value  = value;
+				fields[lp].length = value_len;
+			}
+		}
 
-	while ( len-- ) {
-		element[0] = *fp;
-		value->add(value, element);
-		++fp;
+		p = _skip_space(p);
+		if ( *p == ',' )
+			p = _skip_space(p + 1);
+		else if ( *p != '}' )
+			ERR(return false);
 	}
-	if ( value->poisoned(value) )
-		ERR(goto done);
 
-	retn = true;
-
- done:
-	if ( have_regex )
-		regfree(&regex);
-
-	return retn;
+	fields[field_report].length = p + 1 - fields[field_report].value;
+	return true;
 }
 
 
 /**
  * Internal private function.
  *
- * This is a support function for the ->decode_report method that
- * compartmentalizes the extraction of the report signature and
- * certificate.  This method leaves the binary form of the signature
- * in the object state and the percent-decoded certification in the
- * object state.
- *
- * \param S		A pointer to the object state.
- *
- * \param field		The report data that is to be parsed.
+ * This method loads the value of a field located by the _scan_report
+ * function into an object.  It is a subordinate helper function for
+ * the ->decode_report method.
  *
- * \param rgx		A pointer to the object that will be used to
- *			hold the regular expression.
+ * \param noerr	A flag variable used to indicate that an error
+ *		condition should not be generated if the field is
+ *		not present.
  *
- * \param hd		The header definition that is to be extracted.
+ * \param field	A pointer to the descriptor of the field which is to
+ *		be loaded.
  *
- * \param header	The object that the extracted header will be
- *			placed into.
+ * \param value	A pointer to the object that will be loaded with
+ *		the field value.
  *
  * \return	A boolean value is used to indicate the success or
- *		failure of the header extraction.  A false value is
- *		used to indicate a failure occurred during the
- *		extraction.  A true value indicates the signature and
- *		certificate have been successfully extracted.
+ *		failure of the field extraction.  A false value is
+ *		used to indicate the field is not present or could
+ *		not be loaded.  A true value indicates the value
+ *		object contains the field value.
  */
 
-static _Bool _get_header(CO(String, field), CO(String, rgx), CO(char *, hd), \
-			 CO(String, header))
+static _Bool _get_field(const _Bool noerr, CO(struct report_field *, field), \
+			CO(String, value))
 
 {
-	_Bool retn       = false,
-	      have_regex = false;
-
-	char *fp,
-	     element[2];
-
-	size_t len;
-
-	regex_t regex;
-
-	regmatch_t regmatch[2];
-
-
-	/* Extract and convert the signature to binary form. */
-	rgx->reset(rgx);
-	if ( !rgx->add(rgx, hd) )
-		ERR(goto done);
-	if ( !rgx->add(rgx, ": ([^\r]*)\r") )
-		ERR(goto done);
-
-	if ( regcomp(&regex, rgx->get(rgx), REG_EXTENDED) != 0 )
-		ERR(goto done);
-	have_regex = true;
-
-	if ( regexec(&regex, field->get(field), 2, regmatch, 0) != REG_OK )
-		ERR(goto done);
-
-	len = regmatch[1].rm_eo - regmatch[1].rm_so;
-	if ( len > field->size(field) )
-		ERR(goto done);
-
-
-	/* Copy the field element to the output object. */
-	memset(element, '\0', sizeof(element));
-	fp = field->get(field) + regmatch[1].rm_so;
+	value->reset(value);
 
-	while ( len-- ) {
-		element[0] = *fp;
-		header->add(header, element);
-		++fp;
+	if ( field->value == NULL ) {
+		if ( !noerr )
+			ERR(return false);
+		return false;
 	}
 
-	if ( header->poisoned(header) )
-		ERR(goto done);
-	retn = true;
-
+	if ( !value->add_sprintf(value, "%.*s", (int) field->length, \
+				 field->value) )
+		ERR(return false);
 
- done:
-	if ( have_regex )
-		regfree(&regex);
-
-	return retn;
+	return true;
 }
 
 
@@ -1182,20 +1105,22 @@ static _Bool decode_report(CO(SRDEquote, this), CO(String, report))
 		uint16_t size;
 	} __attribute__((packed)) *tlv;
 
+	struct report_field fields[field_end];
+
 	Buffer bufr = NULL;
 
-	String rpt    = NULL,
-	       field  = NULL,
-	       fregex = NULL;
+	String field = NULL;
 
 	Base64 base64 = NULL;
 
 
-	/* Decode the version file and abort if not correct. */
-	INIT(HurdLib, String, fregex, ERR(goto done));
+	/* Locate the report fields. */
+	if ( !_scan_report(report, fields) )
+		ERR(goto done);
 
+	/* Decode the version file and abort if not correct. */
 	INIT(HurdLib, String, S->version, ERR(goto done));
-	if ( !_get_version(report, fregex, S->version) )
+	if ( !_get_field(false, &fields[field_version], S->version) )
 		ERR(goto done);
 	if ( memcmp(IAS_VERSION, S->version->get(S->version), \
 		    S->version->size(S->version)) != 0 )
@@ -1203,33 +1128,32 @@ static _Bool decode_report(CO(SRDEquote, this), CO(String, report))
 
 	/* Extract the report itself. */
 	INIT(HurdLib, String, S->report, ERR(goto done));
-	if ( !_get_report(report, S->report) )
+	if ( !_get_field(false, &fields[field_report], S->report) )
 		ERR(goto done);
 
 	/* Extract the report signature and certificate. */
 	INIT(HurdLib, String, S->signature, ERR(goto done));
-	if ( !_get_header(report, fregex, "[xX]-[iI][aA][sS][rR]" \
-			  "eport-[sS]ignature", S->signature) )
+	if ( !_get_field(false, &fields[field_signature], S->signature) )
 		ERR(goto done);
 
 	INIT(HurdLib, String, S->certificate, ERR(goto done));
-	if ( !_get_header(report, fregex, "[xX]-[iI][aA][sS][rR]" \
-			  "eport-[sS]igning-[cC]ertificate", S->certificate) )
+	if ( !_get_field(false, &fields[field_certificate], \
+			 S->certificate) )
 		ERR(goto done);
 	if ( !_decode_certificate(S->certificate) )
 		ERR(goto done);
 
 	/* Extract the report fields. */
 	INIT(HurdLib, String, S->id, ERR(goto done));
-	if ( !_get_field(false, S->report, fregex, "id", S->id) )
+	if ( !_get_field(false, &fields[field_id], S->id) )
 		ERR(goto done);
 
 	INIT(HurdLib, String, S->timestamp, ERR(goto done));
-	if ( !_get_field(false, S->report, fregex, "timestamp", S->timestamp) )
+	if ( !_get_field(false, &fields[field_timestamp], S->timestamp) )
 		ERR(goto done);
 
 	INIT(HurdLib, String, field, ERR(goto done));
-	if ( _get_field(true, S->report, fregex, "nonce", field) ) {
+	if ( _get_field(true, &fields[field_nonce], field) ) {
 		if ( S->nonce == NULL ) {
 			INIT(HurdLib, Buffer, S->nonce, ERR(goto done));
 		}
@@ -1240,8 +1164,7 @@ static _Bool decode_report(CO(SRDEquote, this), CO(String, report))
 		field->reset(field);
 	}
 
-	if ( !_get_field(false, S->report, fregex, "isvEnclaveQuoteStatus", \
-			 field) )
+	if ( !_get_field(false, &fields[field_quote_status], field) )
 		ERR(goto done);
 
 	for (S->status= 0; Quote_status[S->status] != NULL; ++S->status) {
@@ -1253,8 +1176,7 @@ static _Bool decode_report(CO(SRDEquote, this), CO(String, report))
 
 	/* Decode the quote body. */
 	field->reset(field);
-	if ( !_get_field(false, S->report, fregex, "isvEnclaveQuoteBody", \
-			 field) )
+	if ( !_get_field(false, &fields[field_quote_body], field) )
 		ERR(goto done);
 
 	INIT(HurdLib, Buffer, bufr, ERR(goto done));
@@ -1271,8 +1193,8 @@ static _Bool decode_report(CO(SRDEquote, this), CO(String, report))
 	     S->status == SRDEquote_status_GROUP_REVOKED ||     \
 	     S->status == SRDEquote_status_CONFIGURATION_NEEDED ) {
 		field->reset(field);
-		if ( !_get_field(false, S->report, fregex, \
-				 "platformInfoBlob", field) )
+		if ( !_get_field(false, &fields[field_platform_info], \
+				 field) )
 			ERR(goto done);
 
 		bufr->reset(bufr);
@@ -1303,10 +1225,7 @@ static _Bool decode_report(CO(SRDEquote, this), CO(String, report))
 		S->status = SRDEquote_status_UNDEFINED;
 
 	WHACK(bufr);
-
-	WHACK(rpt);
 	WHACK(field);
-	WHACK(fregex);
 
 	WHACK(base64);
 
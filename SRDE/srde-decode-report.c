@@ -0,0 +1,252 @@
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+/**
+ * Utility to decode attestation reports which have been saved, with
+ * their HTTP headers, from the Intel attestation service.
+ *
+ * By default each report is decoded and its elements are displayed.
+ * The -B option instead benchmarks the ->decode_report method by
+ * decoding the number of reports specified with the -n option,
+ * cycling through the reports which were supplied, and reporting
+ * the number of reports decoded per second.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+
+#include <Origin.h>
+#include <HurdLib.h>
+#include <Buffer.h>
+#include <String.h>
+#include <File.h>
+
+#include "NAAAIM.h"
+#include "SRDE.h"
+#include "SRDEquote.h"
+
+
+/**
+ * Private function.
+ *
+ * This function returns the number of seconds which have elapsed
+ * since the supplied starting time.
+ *
+ * \param start	A pointer to the structure containing the starting
+ *		time.
+ *
+ * \return	The number of elapsed seconds.
+ */
+
+static double elapsed(const struct timespec *start)
+
+{
+	struct timespec end;
+
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) + \
+		(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function loads a saved attestation report.
+ *
+ * \param name		A pointer to the null-terminated buffer
+ *			containing the name of the file holding the
+ *			report.
+ *
+ * \param report	The object which the report is to be loaded
+ *			into.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the report was loaded.
+ */
+
+static _Bool load(CO(char *, name), CO(String, report))
+
+{
+	_Bool retn = false;
+
+	Buffer bufr = NULL;
+
+	File file = NULL;
+
+
+	INIT(HurdLib, Buffer, bufr, ERR(goto done));
+	INIT(HurdLib, File, file, ERR(goto done));
+
+	if ( !file->open_ro(file, name) )
+		ERR(goto done);
+	if ( !file->slurp(file, bufr) )
+		ERR(goto done);
+	if ( !bufr->add(bufr, (unsigned char *) "\0", 1) )
+		ERR(goto done);
+
+	if ( !report->add(report, (char *) bufr->get(bufr)) )
+		ERR(goto done);
+	retn = true;
+
+
+ done:
+	WHACK(bufr);
+	WHACK(file);
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function decodes the specified number of reports with a new
+ * quote object for each report, in the manner of a verifier.
+ *
+ * \param reports	A pointer to the array of objects containing
+ *			the reports.
+ *
+ * \param cnt		The number of reports in the array.
+ *
+ * \param count		The number of reports to be decoded.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the benchmark was completed.
+ */
+
+static _Bool benchmark(CO(String *, reports), const unsigned int cnt, \
+		       const unsigned long int count)
+
+{
+	_Bool retn = false;
+
+	unsigned long int lp;
+
+	double seconds;
+
+	struct timespec start;
+
+	SRDEquote quote = NULL;
+
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (lp= 0; lp < count; ++lp) {
+		INIT(NAAAIM, SRDEquote, quote, ERR(goto done));
+		if ( !quote->decode_report(quote, reports[lp % cnt]) ) {
+			fprintf(stderr, "Report %lu failed decoding.\n", \
+				lp % cnt);
+			goto done;
+		}
+		WHACK(quote);
+	}
+	seconds = elapsed(&start);
+
+	fprintf(stdout, "Reports: %lu\n", count);
+	fprintf(stdout, "\tDecode time: %.2f usec\n", \
+		(seconds * 1e6) / count);
+	fprintf(stdout, "\tReports/second: %.0f\n", count / seconds);
+	retn = true;
+
+
+ done:
+	WHACK(quote);
+
+	return retn;
+}
+
+
+extern int main(int argc, char *argv[])
+
+{
+	_Bool bench = false;
+
+	int opt,
+	    retn = 1;
+
+	unsigned int lp,
+		     cnt = 0;
+
+	unsigned long int count = 10000;
+
+	String *reports = NULL;
+
+	SRDEquote quote = NULL;
+
+
+	while ( (opt = getopt(argc, argv, "Bn:")) != EOF )
+		switch ( opt ) {
+			case 'B':
+				bench = true;
+				break;
+			case 'n':
+				count = strtoul(optarg, NULL, 0);
+				break;
+		}
+
+	if ( (optind == argc) || (count == 0) ) {
+		fprintf(stderr, "%s: Specify one or more report files.\n", \
+			argv[0]);
+		goto done;
+	}
+
+
+	/* Load the reports. */
+	cnt = argc - optind;
+	if ( (reports = calloc(cnt, sizeof(String))) == NULL )
+		ERR(goto done);
+
+	for (lp= 0; lp < cnt; ++lp) {
+		INIT(HurdLib, String, reports[lp], ERR(goto done));
+		if ( !load(argv[optind + lp], reports[lp]) ) {
+			fprintf(stderr, "Cannot load report: %s\n", \
+				argv[optind + lp]);
+			goto done;
+		}
+	}
+
+	if ( bench ) {
+		if ( benchmark(reports, cnt, count) )
+			retn = 0;
+		goto done;
+	}
+
+
+	/* Decode and display each report. */
+	for (lp= 0; lp < cnt; ++lp) {
+		INIT(NAAAIM, SRDEquote, quote, ERR(goto done));
+		if ( !quote->decode_report(quote, reports[lp]) ) {
+			fprintf(stderr, "Cannot decode report: %s\n", \
+				argv[optind + lp]);
+			goto done;
+		}
+
+		fprintf(stdout, "Report: %s\n", argv[optind + lp]);
+		quote->dump_report(quote);
+		fputc('\n', stdout);
+		WHACK(quote);
+	}
+
+	retn = 0;
+
+
+ done:
+	if ( reports != NULL ) {
+		for (lp= 0; lp < cnt; ++lp)
+			WHACK(reports[lp]);
+		free(reports);
+	}
+	WHACK(quote);
+
+	return retn;
+}
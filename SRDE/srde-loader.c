@@ -5,14 +5,29 @@
  * the source tree for copyright and licensing information.
  **************************************************************************/
 
+/**
+ * Utility to load an enclave image and dump the loader state.
+ *
+ * If a count is specified after the debug status the utility instead
+ * benchmarks the metadata and loader stages of enclave startup.  The
+ * enclave is opened, created and loaded the requested number of times
+ * with the pages directed into an offline measurement rather than the
+ * SGX device.  The average time spent opening the image and loading
+ * its pages along with the peak resident set size of the process are
+ * reported.
+ */
+
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/resource.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <string.h>
+#include <time.h>
 
 #include <Origin.h>
 #include <HurdLib.h>
@@ -23,6 +38,105 @@
 #include "SRDEloader.h"
 
 
+/**
+ * Private function.
+ *
+ * This function returns the number of seconds which have elapsed
+ * since the supplied starting time.
+ *
+ * \param start	A pointer to the structure containing the starting
+ *		time.
+ *
+ * \return	The number of elapsed seconds.
+ */
+
+static double elapsed(const struct timespec *start)
+
+{
+	struct timespec end;
+
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) + \
+		(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function runs the metadata and loader stages of enclave
+ * startup the specified number of times.
+ *
+ * \param name	A pointer to the null-terminated buffer containing
+ *		the name of the enclave.
+ *
+ * \param debug	The debug status the enclave is to be loaded with.
+ *
+ * \param count	The number of times the enclave is to be loaded.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the benchmark was completed.
+ */
+
+static _Bool benchmark(CO(char *, name), const _Bool debug, \
+		       const unsigned long int count)
+
+{
+	_Bool retn = false;
+
+	uint8_t mrenclave[32];
+
+	unsigned long int lp;
+
+	double open_time = 0,
+	       load_time = 0;
+
+	struct timespec start;
+
+	struct rusage usage;
+
+	SRDEenclave enclave = NULL;
+
+
+	for (lp= 0; lp < count; ++lp) {
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		INIT(NAAAIM, SRDEenclave, enclave, ERR(goto done));
+		if ( !enclave->open_measurement(enclave, name, debug) )
+			ERR(goto done);
+		open_time += elapsed(&start);
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		if ( !enclave->create_enclave(enclave) )
+			ERR(goto done);
+		if ( !enclave->load_enclave(enclave) )
+			ERR(goto done);
+		if ( !enclave->get_measurement(enclave, mrenclave) )
+			ERR(goto done);
+		WHACK(enclave);
+		load_time += elapsed(&start);
+	}
+
+	if ( getrusage(RUSAGE_SELF, &usage) != 0 )
+		ERR(goto done);
+
+	fprintf(stdout, "Enclave: %s\n", name);
+	fprintf(stdout, "\tLoads: %lu\n", count);
+	fprintf(stdout, "\tOpen time: %.1f usec\n", \
+		(open_time * 1e6) / count);
+	fprintf(stdout, "\tLoad time: %.1f usec\n", \
+		(load_time * 1e6) / count);
+	fprintf(stdout, "\tPeak RSS: %ld KB\n", usage.ru_maxrss);
+	retn = true;
+
+
+ done:
+	WHACK(enclave);
+
+	return retn;
+}
+
+
 extern int main(int argc, char *argv[])
 
 {
@@ -33,14 +147,20 @@ extern int main(int argc, char *argv[])
 	SRDEloader loader = NULL;
 
 
-	if (argc != 3) {
-		fprintf(stderr, "%s: Specify enclave name and debug " \
-			"status.\n", argv[0]);
+	if ( (argc != 3) && (argc != 4) ) {
+		fprintf(stderr, "%s: Specify enclave name, debug status " \
+			"and optional benchmark count.\n", argv[0]);
 		goto done;
 	}
 	if ( strcmp(argv[2], "1") == 0 )
 		debug = true;
 
+	if ( argc == 4 ) {
+		if ( benchmark(argv[1], debug, strtoul(argv[3], NULL, 0)) )
+			retn = 0;
+		goto done;
+	}
+
 	INIT(NAAAIM, SRDEloader, loader, ERR(goto done));
 
 	if ( !loader->load(loader, argv[1], debug) ) {
@@ -18,6 +18,7 @@
 
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -64,6 +65,7 @@ static void usage(char *err)
 	fputc('\n', stdout);
 	fputs("Modes:\n", stdout);
 	fputs("\t-D:\tDump mode (default).\n", stdout);
+	fputs("\t-M:\tMeasurement mode.\n", stdout);
 	fputs("\t-S:\tSignature structure mode.\n", stdout);
 
 	fputs("\nArguments:\n", stdout);
@@ -225,6 +227,79 @@ static int signature_mode(SRDEmetadata metadata, char *output)
 }
 
 
+/**
+ * Internal public function.
+ *
+ * This method implements the measurement mode of the utility.  This
+ * mode computes the MRENCLAVE value of the enclave offline and
+ * compares it to the enclave measurement in the signature
+ * structure.  The SGX device is not needed so this mode can be used
+ * to verify a signed enclave on a system without SGX support.
+ *
+ * \param metadata	The object which represents the enclave
+ *			metadata.
+ *
+ * \param name		A pointer to a null-terminated character buffer
+ *			containing the name of the enclave.
+ *
+ * \return		The value to be returned by the main function
+ *			is returned.  A non-zero value is returned if
+ *			the measurement does not match the signature
+ *			structure.
+ */
+
+static int measurement_mode(SRDEmetadata metadata, char *name)
+
+{
+	int retn = 1;
+
+	uint8_t mrenclave[32];
+
+	struct SGX_sigstruct sigstruct;
+
+	SRDEenclave enclave = NULL;
+
+
+	/* Measure the enclave. */
+	INIT(NAAAIM, SRDEenclave, enclave, ERR(goto done));
+	if ( !enclave->open_measurement(enclave, name, false) )
+		ERR(goto done);
+	if ( !enclave->create_enclave(enclave) )
+		ERR(goto done);
+	if ( !enclave->load_enclave(enclave) )
+		ERR(goto done);
+	if ( !enclave->get_measurement(enclave, mrenclave) )
+		ERR(goto done);
+
+	fputs("mrenclave:\n", stdout);
+	_print_buffer("\t", mrenclave, sizeof(mrenclave));
+
+
+	/* Compare to the signed measurement. */
+	if ( !metadata->get_sigstruct(metadata, &sigstruct) )
+		ERR(goto done);
+
+	if ( memcmp(mrenclave, sigstruct.enclave_hash, \
+		    sizeof(mrenclave)) == 0 ) {
+		fputs("\nMeasurement matches signature structure.\n", \
+		      stdout);
+		retn = 0;
+	}
+	else {
+		fputs("\nMeasurement does not match signature structure:\n", \
+		      stdout);
+		_print_buffer("\t", sigstruct.enclave_hash, \
+			      sizeof(sigstruct.enclave_hash));
+	}
+
+
+ done:
+	WHACK(enclave);
+
+	return retn;
+}
+
+
 /*
  * Main program.
  */
@@ -240,6 +315,7 @@ int main(int argc, char *argv[])
 
 	enum {
 		dump,
+		measurement,
 		signature
 	} mode = dump;
 
@@ -247,11 +323,14 @@ int main(int argc, char *argv[])
 
 
 	/* Parse and verify arguements. */
-	while ( (opt = getopt(argc, argv, "DSe:o:")) != EOF )
+	while ( (opt = getopt(argc, argv, "DMSe:o:")) != EOF )
 		switch ( opt ) {
 			case 'D':
 				mode = dump;
 				break;
+			case 'M':
+				mode = measurement;
+				break;
 			case 'S':
 				mode = signature;
 				break;
@@ -287,6 +366,11 @@ int main(int argc, char *argv[])
 	}
 
 
+	/* Measurement mode. */
+	if ( mode == measurement )
+		retn = measurement_mode(metadata, enclave_name);
+
+
 	/* Signature structure mode. */
 	if ( mode == signature ) {
 		retn = signature_mode(metadata, output_file);
@@ -17,6 +17,7 @@
 
 #include <NAAAIM.h>
 
+#include <EventLoop.h>
 #include <TSEMcontrol.h>
 
 #include <SRDEfusion-ocall.h>
@@ -170,7 +171,8 @@ _Bool update_model(struct ISOidentity_ecall1_interface *ecall1)
 
 
 	/* Parse and measure the event. */
-	INIT(NAAAIM, SecurityEvent, event, ERR(goto done));
+	if ( !Model->new_event(Model, &event) )
+		ERR(goto done);
 	if ( !event->parse(event, input) )
 		ERR(goto done);
 
@@ -179,8 +181,7 @@ _Bool update_model(struct ISOidentity_ecall1_interface *ecall1)
 	if ( !Model->update(Model, event, &updated, &ecall1->discipline, \
 			    &ecall1->sealed) )
 		ERR(goto done);
-	if ( !updated )
-		WHACK(event);
+	Model->release_event(Model, event);
 	if ( ecall1->async ) {
 		retn = true;
 		goto done;
@@ -44,6 +44,7 @@
 #include <SecurityPoint.h>
 #include <SecurityEvent.h>
 
+#include <EventLoop.h>
 #include <TSEMcontrol.h>
 
 #include "SanchoSGX.h"
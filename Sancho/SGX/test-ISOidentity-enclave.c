@@ -45,6 +45,7 @@
 #include <SecurityEvent.h>
 #include <SecurityPoint.h>
 
+#include <EventLoop.h>
 #include <TSEMcontrol.h>
 
 #include <SRDEfusion-ocall.h>
@@ -171,7 +171,8 @@ static void add_event(CO(TTYduct, duct), CO(TSEM, model), CO(Buffer, bufr))
 	if ( !update->add(update, p) )
 		ERR(goto done);
 
-	INIT(NAAAIM, SecurityEvent, event, ERR(goto done));
+	if ( !model->new_event(model, &event) )
+		ERR(goto done);
 	if ( !event->parse(event, update) )
 		ERR(goto done);
 	if ( !model->update(model, event, &updated, &discipline, &sealed) )
@@ -201,8 +202,7 @@ static void add_event(CO(TTYduct, duct), CO(TSEM, model), CO(Buffer, bufr))
 
  done:
 	WHACK(update);
-	if ( !updated )
-		WHACK(event);
+	model->release_event(model, event);
 
 	return;
 }
@@ -765,6 +765,87 @@ static _Bool verify(CO(RSAkey, this), CO(Buffer, signature), \
 	return retn;
 }
 
+/**
+ * External public method.
+ *
+ * This method implements verification of a signature over a SHA256
+ * digest which has already been computed.  This allows a caller
+ * which hashes the signed data as it is read to verify the signature
+ * without retaining the data and having it hashed a second time.
+ *
+ * \param this		A pointer to the object describing the key that
+ *			is to be used for verifying a signature.
+ *
+ * \param signature	The object containing the signature that is to
+ *			be verified.
+ *
+ * \param digest	The object containing the SHA256 digest of the
+ *			data whose signature is to be verified.
+ *
+ * \param status	A pointer to a boolean value used to indicate
+ *			whether or not the provided signature was
+ *			correct.
+ *
+ * \return		A boolean value is returned to indicate the
+ *			status of the verification process.  A false
+ *			value implies an error was encountered and
+ *			no assumptions can be made about the status
+ *			value.  A true value indicates the process
+ *			succeeded and the status variable will be
+ *			updated to reflect the status of the
+ *			signature verification.
+ */
+
+static _Bool verify_digest(CO(RSAkey, this), CO(Buffer, signature), \
+			   CO(Buffer, digest), _Bool *status)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	int rc;
+
+
+	/* Verify object status. */
+	if ( signature == NULL )
+		ERR(goto done);
+	if ( signature->poisoned(signature) )
+		ERR(goto done);
+	if ( digest == NULL )
+		ERR(goto done);
+	if ( digest->poisoned(digest) )
+		ERR(goto done);
+	if ( digest->size(digest) != NAAAIM_IDSIZE )
+		ERR(goto done);
+	if ( S->type != public_key )
+		ERR(goto done);
+
+
+	/* Verify the signature. */
+	rc = mbedtls_pk_verify(&S->key, MBEDTLS_MD_SHA256, \
+			       digest->get(digest), 0,	   \
+			       signature->get(signature),  \
+			       signature->size(signature));
+
+	if ( rc == MBEDTLS_ERR_RSA_VERIFY_FAILED ) {
+		*status = false;
+		retn = true;
+		goto done;
+	}
+
+	if ( rc != 0 )
+		goto done;
+
+	*status = true;
+	retn = true;
+
+
+ done:
+	return retn;
+}
+
+
 
 /**
  * External public method.
@@ -1017,8 +1098,9 @@ extern RSAkey NAAAIM_RSAkey_Init(void)
 	this->encrypt = encrypt;
 	this->decrypt = decrypt;
 
-	this->verify = verify;
-	this->sign   = sign;
+	this->verify	     = verify;
+	this->verify_digest = verify_digest;
+	this->sign	     = sign;
 
 	this->init_engine = init_engine;
 	this->set_padding = set_padding;
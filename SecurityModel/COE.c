@@ -81,6 +81,10 @@ struct NAAAIM_COE_State
 	/* Measured identity. */
 	_Bool measured;
 	Sha256 identity;
+
+	/* Objects reused by each parse and measurement. */
+	TSEMparser parser;
+	Buffer bufr;
 };
 
 
@@ -107,6 +111,9 @@ static void _init_state(CO(COE_State, S))
 	S->measured = false;
 	S->identity = NULL;
 
+	S->parser = NULL;
+	S->bufr	  = NULL;
+
 	return;
 }
 
@@ -261,7 +268,7 @@ static _Bool parse(CO(COE, this), CO(String, entry))
 
 	_Bool retn = false;
 
-	TSEMparser parser = NULL;
+	TSEMparser parser = S->parser;
 
 
 	/* Verify object and caller state. */
@@ -272,7 +279,7 @@ static _Bool parse(CO(COE, this), CO(String, entry))
 
 
 	/* Extract coe field. */
-	INIT(NAAAIM, TSEMparser, parser, ERR(goto done));
+	parser->reset(parser);
 	if ( !parser->extract_field(parser, entry, "COE") )
 		ERR(goto done);
 
@@ -312,8 +319,6 @@ static _Bool parse(CO(COE, this), CO(String, entry))
 	if ( !retn )
 		S->poisoned = true;
 
-	WHACK(parser);
-
 	return retn;
 }
 
@@ -340,7 +345,7 @@ static _Bool measure(CO(COE, this))
 
 	_Bool retn = false;
 
-	Buffer bufr = NULL;
+	Buffer bufr = S->bufr;
 
 
 	/* Object verifications. */
@@ -350,7 +355,7 @@ static _Bool measure(CO(COE, this))
 		ERR(goto done);
 
 
-	INIT(HurdLib, Buffer, bufr, ERR(goto done));
+	bufr->reset(bufr);
 	bufr->add(bufr, (void *) &S->character.uid, sizeof(S->character.uid));
 	bufr->add(bufr, (void *) &S->character.euid, \
 		  sizeof(S->character.euid));
@@ -380,7 +385,6 @@ static _Bool measure(CO(COE, this))
  done:
 	if ( !retn )
 		S->poisoned = true;
-	WHACK(bufr);
 
 	return retn;
 }
@@ -512,6 +516,7 @@ static void reset(CO(COE, this))
 	memset(&S->character, '\0', sizeof(struct coe_characteristics));
 
 	S->identity->reset(S->identity);
+	S->bufr->reset(S->bufr);
 
 	return;
 }
@@ -567,6 +572,8 @@ static void whack(CO(COE, this))
 	STATE(S);
 
 	WHACK(S->identity);
+	WHACK(S->parser);
+	WHACK(S->bufr);
 
 	S->root->whack(S->root, this, S);
 	return;
@@ -609,6 +616,8 @@ extern COE NAAAIM_COE_Init(void)
 
 	/* Initialize aggregate objects. */
 	INIT(NAAAIM, Sha256, this->state->identity, ERR(goto fail));
+	INIT(NAAAIM, TSEMparser, this->state->parser, ERR(goto fail));
+	INIT(HurdLib, Buffer, this->state->bufr, ERR(goto fail));
 
 	/* Method initialization. */
 	this->set_characteristics   = set_characteristics;
@@ -625,6 +634,8 @@ extern COE NAAAIM_COE_Init(void)
 
 fail:
 	WHACK(this->state->identity);
+	WHACK(this->state->parser);
+	WHACK(this->state->bufr);
 
 	root->whack(root, this, this->state);
 	return NULL;
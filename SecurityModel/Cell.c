@@ -41,6 +41,7 @@
 
 #include "NAAAIM.h"
 #include "SHA256.h"
+#include "Hex.h"
 #include "Cell.h"
 
 #if !defined(REG_OK)
@@ -197,6 +198,11 @@ struct NAAAIM_Cell_State
 	/* Measured identity. */
 	_Bool measured;
 	Sha256 identity;
+
+	/* Objects reused by each parse and measurement. */
+	TSEMparser parser;
+	Buffer bufr;
+	String match;
 };
 
 
@@ -225,6 +231,10 @@ static void _init_state(CO(Cell_State, S))
 	S->identity	      = NULL;
 	S->file.path.pathname = NULL;
 
+	S->parser = NULL;
+	S->bufr	  = NULL;
+	S->match  = NULL;
+
 	return;
 }
 
@@ -324,8 +334,8 @@ static _Bool _get_field(CO(TSEMparser, parser), CO(char *, field), \
  * digest field is assumed to have a size equal to the operative
  * identity size.
  *
- * \param parser	The parser object used to extract the field
- *			description.
+ * \param S		A pointer to the state of the object whose
+ *			parser is used to extract the field.
  *
  * \param field		A character pointer to the characteristic that
  *			is to be parsed.
@@ -343,37 +353,32 @@ static _Bool _get_field(CO(TSEMparser, parser), CO(char *, field), \
  *		variable contains a legitimate value.
  */
 
-static _Bool _get_digest(CO(TSEMparser, parser), CO(char *, field),
+static _Bool _get_digest(CO(Cell_State, S), CO(char *, field),
 			 uint8_t *fb, size_t size)
 
 {
 	_Bool retn = false;
 
-	Buffer bufr  = NULL;
+	String match = S->match;
 
-	String match = NULL;
+	TSEMparser parser = S->parser;
 
 
 	/* Get the ASCII hexadecimal value of the field itself. */
-	INIT(HurdLib, String, match, ERR(goto done));
+	match->reset(match);
 	if ( !parser->get_text(parser, field, match) )
 		ERR(goto done);
 
-	/* Convert the hexadecimal value to the binary value. */
-	INIT(HurdLib, Buffer, bufr, ERR(goto done));
-	if ( !bufr->add_hexstring(bufr, (char *) match->get(match)) )
+	/* Convert the hexadecimal value directly into the field. */
+	if ( match->size(match) != (2 * size) )
 		ERR(goto done);
-	if ( bufr->size(bufr) != size )
+	if ( !Hex_decode(match->get(match), 2 * size, fb) )
 		ERR(goto done);
-	memcpy(fb, bufr->get(bufr), bufr->size(bufr));
 
 	retn = true;
 
 
  done:
-	WHACK(bufr);
-	WHACK(match);
-
 	return retn;
 }
 
@@ -383,8 +388,8 @@ static _Bool _get_digest(CO(TSEMparser, parser), CO(char *, field),
  *
  * This method parses a text value from a cell characteristic field.
  *
- * \param parser	The parser object used to extract the field
- *			description.
+ * \param S		A pointer to the state of the object whose
+ *			parser is used to extract the field.
  *
  * \param field		A pointer to the field that is to be parsed.
  *
@@ -402,17 +407,19 @@ static _Bool _get_digest(CO(TSEMparser, parser), CO(char *, field),
  *		variable contains a legitimate value.
  */
 
-static _Bool _get_text(CO(TSEMparser, parser), CO(char *, field), \
+static _Bool _get_text(CO(Cell_State, S), CO(char *, field), \
 		       uint8_t *fb, size_t fblen)
 
 {
 	_Bool retn = false;
 
-	String match = NULL;
+	String match = S->match;
+
+	TSEMparser parser = S->parser;
 
 
 	/* Get the field itself. */
-	INIT(HurdLib, String, match, ERR(goto done));
+	match->reset(match);
 	if ( !parser->get_text(parser, field, match) )
 		ERR(goto done);
 
@@ -424,8 +431,6 @@ static _Bool _get_text(CO(TSEMparser, parser), CO(char *, field), \
 
 
  done:
-	WHACK(match);
-
 	return retn;
 }
 
@@ -436,8 +441,8 @@ static _Bool _get_text(CO(TSEMparser, parser), CO(char *, field), \
  * This function implements the parsing of a JSON file structure into
  * it the file_parameters structure.
  *
- * \param parser	The parser object used to parse the event
- *			description.
+ * \param S		A pointer to the state of the object whose
+ *			parser is used to parse the event.
  *
  * \param event		The structure containing the JSON description
  *			that is holding a JSON file structure description.
@@ -452,12 +457,14 @@ static _Bool _get_text(CO(TSEMparser, parser), CO(char *, field), \
  *			argument was properly populated.
  */
 
-static _Bool _parse_file(CO(TSEMparser, parser), CO(String, event), \
+static _Bool _parse_file(CO(Cell_State, S), CO(String, event), \
 			 struct file_parameters *fp)
 
 {
 	_Bool retn = false;
 
+	TSEMparser parser = S->parser;
+
 
 	/* Extract the file field. */
 	if ( !parser->extract_field(parser, event, "file") )
@@ -471,7 +478,7 @@ static _Bool _parse_file(CO(TSEMparser, parser), CO(String, event), \
 	if ( !_get_field(parser, "flags", &fp->flags) )
 		ERR(goto done);
 
-	if ( !_get_digest(parser, "digest", (uint8_t *) fp->digest,
+	if ( !_get_digest(S, "digest", (uint8_t *) fp->digest,
 			  NAAAIM_IDSIZE) )
 		ERR(goto done);
 
@@ -491,11 +498,11 @@ static _Bool _parse_file(CO(TSEMparser, parser), CO(String, event), \
 	if ( !_get_field(parser, "s_magic", &fp->inode.s_magic) )
 		ERR(goto done);
 
-	if ( !_get_text(parser, "s_id", (uint8_t *) fp->inode.s_id, \
+	if ( !_get_text(S, "s_id", (uint8_t *) fp->inode.s_id, \
 			sizeof(fp->inode.s_id)) )
 		ERR(goto done);
 
-	if ( !_get_digest(parser, "s_uuid", fp->inode.s_uuid, \
+	if ( !_get_digest(S, "s_uuid", fp->inode.s_uuid, \
 			  sizeof(fp->inode.s_uuid)) )
 		ERR(goto done);
 
@@ -551,24 +558,22 @@ static _Bool parse_file_open(CO(Cell_State, S), CO(String, event))
 {
 	_Bool retn = false;
 
-	TSEMparser parser = NULL;
+	TSEMparser parser = S->parser;
 
 
 	/* Extract the file_open and then the file field. */
-	INIT(NAAAIM, TSEMparser, parser, ERR(goto done));
+	parser->reset(parser);
 	if ( !parser->extract_field(parser, event, "file_open") )
 		ERR(goto done);
 
 	/* Parse the file{} structure. */
-	if ( !_parse_file(parser, event, &S->file) )
+	if ( !_parse_file(S, event, &S->file) )
 		ERR(goto done);
 
 	retn = true;
 
 
  done:
-	WHACK(parser);
-
 	return retn;
 }
 
@@ -597,11 +602,11 @@ static _Bool parse_mmap_file(CO(Cell_State, S), CO(String, entry))
 {
 	_Bool retn = false;
 
-	TSEMparser parser = NULL;
+	TSEMparser parser = S->parser;
 
 
 	/* Extract the field. */
-	INIT(NAAAIM, TSEMparser, parser, ERR(goto done));
+	parser->reset(parser);
 	if ( !parser->extract_field(parser, entry, "mmap_file") )
 		ERR(goto done);
 
@@ -619,14 +624,12 @@ static _Bool parse_mmap_file(CO(Cell_State, S), CO(String, entry))
 		goto done;
 	}
 
-	if ( !_parse_file(parser, entry, &S->file) )
+	if ( !_parse_file(S, entry, &S->file) )
 		ERR(goto done);
 	retn = true;
 
 
  done:
-	WHACK(parser);
-
 	return retn;
 }
 
@@ -637,8 +640,8 @@ static _Bool parse_mmap_file(CO(Cell_State, S), CO(String, entry))
  * This method implements parsing the characteristics of a JSON encoded
  * sock structure.
  *
- * \param parser	The parser that will be used to extract the
- *			sock structure.
+ * \param S		A pointer to the state of the object whose
+ *			parser is used to extract the sock structure.
  *
  * \param entry		The object containing the security event description
  *			from which the sock structure will be extracted.
@@ -653,12 +656,14 @@ static _Bool parse_mmap_file(CO(Cell_State, S), CO(String, entry))
  *		populated.
  */
 
-static _Bool _parse_sock(CO(TSEMparser, parser), CO(String, entry), \
+static _Bool _parse_sock(CO(Cell_State, S), CO(String, entry), \
 			struct sock *sp)
 
 {
 	_Bool retn;
 
+	TSEMparser parser = S->parser;
+
 
 	/* Extract the field itself. */
 	if ( !parser->extract_field(parser, entry, "sock") )
@@ -674,7 +679,7 @@ static _Bool _parse_sock(CO(TSEMparser, parser), CO(String, entry), \
 	if ( !_get_field(parser, "protocol", &sp->protocol) )
 		ERR(goto done);
 
-	if ( !_get_digest(parser, "owner", sp->owner, sizeof(sp->owner)) )
+	if ( !_get_digest(S, "owner", sp->owner, sizeof(sp->owner)) )
 		ERR(goto done);
 
 	retn = true;
@@ -709,9 +714,9 @@ static _Bool parse_socket_create(CO(Cell_State, S), CO(String, entry))
 {
 	_Bool retn = false;
 
-	TSEMparser parser = NULL;
+	TSEMparser parser = S->parser;
 
-	INIT(NAAAIM, TSEMparser, parser, ERR(goto done));
+	parser->reset(parser);
 	if ( !parser->extract_field(parser, entry, "socket_create") )
 		ERR(goto done);
 
@@ -732,8 +737,6 @@ static _Bool parse_socket_create(CO(Cell_State, S), CO(String, entry))
 
 
  done:
-	WHACK(parser);
-
 	return retn;
 }
 
@@ -768,9 +771,9 @@ static _Bool parse_socket_connect_bind(CO(Cell_State, S), CO(String, entry))
 
 	uint32_t value;
 
-	String str = NULL;
+	String str = S->match;
 
-	TSEMparser parser = NULL;
+	TSEMparser parser = S->parser;
 
 	static char *type[2] = {
 		"socket_connect",
@@ -791,7 +794,7 @@ static _Bool parse_socket_connect_bind(CO(Cell_State, S), CO(String, entry))
 			break;
 
 	}
-	INIT(NAAAIM, TSEMparser, parser, ERR(goto done));
+	parser->reset(parser);
 	if ( !parser->extract_field(parser, entry, type[value]) )
 		ERR(goto done);
 
@@ -800,7 +803,7 @@ static _Bool parse_socket_connect_bind(CO(Cell_State, S), CO(String, entry))
 		ERR(goto done);
 
 	/* Parse socket information. */
-	if ( !_parse_sock(parser, entry, &S->socket_connect.sock) )
+	if ( !_parse_sock(S, entry, &S->socket_connect.sock) )
 		ERR(goto done);
 
 	/* Scope parser to the addr{} field and address types. */
@@ -835,7 +838,7 @@ static _Bool parse_socket_connect_bind(CO(Cell_State, S), CO(String, entry))
 
 			p = S->socket_connect.u.ipv6_addr;
 			cnt = sizeof(S->socket_connect.u.ipv6_addr);
-			if ( !_get_digest(parser, "address", p, cnt) )
+			if ( !_get_digest(S, "address", p, cnt) )
 				ERR(goto done);
 			break;
 
@@ -844,7 +847,7 @@ static _Bool parse_socket_connect_bind(CO(Cell_State, S), CO(String, entry))
 						    "af_unix") )
 				ERR(goto done);
 
-			INIT(HurdLib, String, str, ERR(goto done));
+			str->reset(str);
 			if ( !parser->get_text(parser, "address", str) )
 				ERR(goto done);
 			cnt = sizeof(S->socket_connect.u.unix_addr);
@@ -863,7 +866,7 @@ static _Bool parse_socket_connect_bind(CO(Cell_State, S), CO(String, entry))
 
 			p = S->socket_connect.u.addr;
 			cnt = sizeof(S->socket_connect.u.addr);
-			if ( !_get_digest(parser, "address", p, cnt) )
+			if ( !_get_digest(S, "address", p, cnt) )
 				ERR(goto done);
 			break;
 	}
@@ -872,9 +875,6 @@ static _Bool parse_socket_connect_bind(CO(Cell_State, S), CO(String, entry))
 
 
  done:
-	WHACK(str);
-	WHACK(parser);
-
 	return retn;
 }
 
@@ -907,13 +907,13 @@ static _Bool parse_socket_accept(CO(Cell_State, S), CO(String, entry))
 
 	unsigned int cnt;
 
-	String str = NULL;
+	String str = S->match;
 
-	TSEMparser parser = NULL;
+	TSEMparser parser = S->parser;
 
 
 	/* Compile the regular expressions once. */
-	INIT(NAAAIM, TSEMparser, parser, ERR(goto done));
+	parser->reset(parser);
 	if ( !parser->extract_field(parser, entry, "socket_accept") )
 		ERR(goto done);
 
@@ -922,7 +922,7 @@ static _Bool parse_socket_accept(CO(Cell_State, S), CO(String, entry))
 		ERR(goto done);
 
 	/* Parse socket information. */
-	if ( !_parse_sock(parser, entry, &S->socket_accept.sock) )
+	if ( !_parse_sock(S, entry, &S->socket_accept.sock) )
 		ERR(goto done);
 
 	/* Scope parser to the addr{} field and address types. */
@@ -946,7 +946,7 @@ static _Bool parse_socket_accept(CO(Cell_State, S), CO(String, entry))
 
 			p = S->socket_accept.u.ipv6_addr;
 			cnt = sizeof(S->socket_accept.u.ipv6_addr);
-			if ( !_get_digest(parser, "address", p, cnt) )
+			if ( !_get_digest(S, "address", p, cnt) )
 				ERR(goto done);
 			break;
 
@@ -955,7 +955,7 @@ static _Bool parse_socket_accept(CO(Cell_State, S), CO(String, entry))
 						    "af_unix") )
 				ERR(goto done);
 
-			INIT(HurdLib, String, str, ERR(goto done));
+			str->reset(str);
 			if ( !parser->get_text(parser, "address", str) )
 				ERR(goto done);
 			cnt = sizeof(S->socket_accept.u.unix_addr);
@@ -974,7 +974,7 @@ static _Bool parse_socket_accept(CO(Cell_State, S), CO(String, entry))
 
 			p = S->socket_accept.u.addr;
 			cnt = sizeof(S->socket_accept.u.addr);
-			if ( !_get_digest(parser, "address", p, cnt) )
+			if ( !_get_digest(S, "address", p, cnt) )
 				ERR(goto done);
 			break;
 	}
@@ -983,9 +983,6 @@ static _Bool parse_socket_accept(CO(Cell_State, S), CO(String, entry))
 
 
  done:
-	WHACK(str);
-	WHACK(parser);
-
 	return retn;
 }
 
@@ -1014,11 +1011,11 @@ static _Bool _parse_task_kill(CO(Cell_State, S), CO(String, entry))
 {
 	_Bool retn = false;
 
-	TSEMparser parser = NULL;
+	TSEMparser parser = S->parser;
 
 
 	/* Extract task_kill event. */
-	INIT(NAAAIM, TSEMparser, parser, ERR(goto done));
+	parser->reset(parser);
 	if ( !parser->extract_field(parser, entry, "task_kill") )
 		ERR(goto done);
 
@@ -1029,7 +1026,7 @@ static _Bool _parse_task_kill(CO(Cell_State, S), CO(String, entry))
 	if ( !_get_field(parser, "signal", &S->task_kill.signal) )
 		ERR(goto done);
 
-	if ( !_get_digest(parser, "target", S->task_kill.task_id, \
+	if ( !_get_digest(S, "target", S->task_kill.task_id, \
 			  NAAAIM_IDSIZE) )
 		ERR(goto done);
 
@@ -1037,8 +1034,6 @@ static _Bool _parse_task_kill(CO(Cell_State, S), CO(String, entry))
 
 
  done:
-	WHACK(parser);
-
 	return retn;
 }
 
@@ -1067,11 +1062,11 @@ static _Bool _parse_generic_event(CO(Cell_State, S), CO(String, entry))
 {
 	_Bool retn = false;
 
-	TSEMparser parser = NULL;
+	TSEMparser parser = S->parser;
 
 
 	/* Extract the generic event. */
-	INIT(NAAAIM, TSEMparser, parser, ERR(goto done));
+	parser->reset(parser);
 	if ( !parser->extract_field(parser, entry, "event") )
 		ERR(goto done);
 
@@ -1082,8 +1077,6 @@ static _Bool _parse_generic_event(CO(Cell_State, S), CO(String, entry))
 
 
  done:
-	WHACK(parser);
-
 	return retn;
 }
 
@@ -1202,12 +1195,12 @@ static _Bool _measure_file(CO(Cell_State, S))
 
 	struct inode *i;
 
-	Buffer bufr = NULL;
+	Buffer bufr = S->bufr;
 
 	String s;
 
 
-	INIT(HurdLib, Buffer, bufr, ERR(goto done));
+	bufr->reset(bufr);
 	if ( !bufr->add(bufr, (void *) &S->file.flags, sizeof(S->file.flags)) )
 		ERR(goto done);
 
@@ -1247,8 +1240,6 @@ static _Bool _measure_file(CO(Cell_State, S))
 
 
  done:
-	WHACK(bufr);
-
 	return retn;
 }
 
@@ -1277,7 +1268,7 @@ static _Bool _measure_mmap_file(CO(Cell_State, S))
 
 	size_t size;
 
-	Buffer bufr = NULL;
+	Buffer bufr = S->bufr;
 
 
 	/* Add file measurement if this is a non-anonymous mapping. */
@@ -1287,7 +1278,7 @@ static _Bool _measure_mmap_file(CO(Cell_State, S))
 	}
 
 	/* Add the mapping protections and flags. */
-	INIT(HurdLib, Buffer, bufr, ERR(goto done));
+	bufr->reset(bufr);
 	p = (unsigned char *) &S->mmap_file.prot;
 	size = sizeof(S->mmap_file.prot);
 	bufr->add(bufr, p, size);
@@ -1301,8 +1292,6 @@ static _Bool _measure_mmap_file(CO(Cell_State, S))
 	retn = true;
 
  done:
-	WHACK(bufr);
-
 	return retn;
 }
 
@@ -1382,10 +1371,10 @@ static _Bool _measure_socket_create(CO(Cell_State, S))
 
 	size_t size;
 
-	Buffer bufr = NULL;
+	Buffer bufr = S->bufr;
 
 
-	INIT(HurdLib, Buffer, bufr, ERR(goto done));
+	bufr->reset(bufr);
 
 	p = (unsigned char *) &S->socket_create.family;
 	size = sizeof(S->socket_create.family);
@@ -1409,8 +1398,6 @@ static _Bool _measure_socket_create(CO(Cell_State, S))
 	retn = true;
 
  done:
-	WHACK(bufr);
-
 	return retn;
 }
 
@@ -1438,10 +1425,10 @@ static _Bool _measure_socket_connect(CO(Cell_State, S))
 
 	size_t size;
 
-	Buffer bufr = NULL;
+	Buffer bufr = S->bufr;
 
 
-	INIT(HurdLib, Buffer, bufr, ERR(goto done));
+	bufr->reset(bufr);
 
 	if ( !_measure_sock(&S->socket_connect.sock, bufr) )
 		ERR(goto done);
@@ -1492,8 +1479,6 @@ static _Bool _measure_socket_connect(CO(Cell_State, S))
 	retn = true;
 
  done:
-	WHACK(bufr);
-
 	return retn;
 }
 
@@ -1521,10 +1506,10 @@ static _Bool _measure_socket_accept(CO(Cell_State, S))
 
 	size_t size;
 
-	Buffer bufr = NULL;
+	Buffer bufr = S->bufr;
 
 
-	INIT(HurdLib, Buffer, bufr, ERR(goto done));
+	bufr->reset(bufr);
 
 	if ( !_measure_sock(&S->socket_accept.sock, bufr) )
 		ERR(goto done);
@@ -1568,8 +1553,6 @@ static _Bool _measure_socket_accept(CO(Cell_State, S))
 	retn = true;
 
  done:
-	WHACK(bufr);
-
 	return retn;
 }
 
@@ -1598,10 +1581,10 @@ static _Bool _measure_task_kill(CO(Cell_State, S))
 
 	size_t size;
 
-	Buffer bufr = NULL;
+	Buffer bufr = S->bufr;
 
 
-	INIT(HurdLib, Buffer, bufr, ERR(goto done));
+	bufr->reset(bufr);
 	p = (unsigned char *) &S->task_kill.cross_model;
 	size = sizeof(S->task_kill.cross_model);
 	bufr->add(bufr, p, size);
@@ -1619,8 +1602,6 @@ static _Bool _measure_task_kill(CO(Cell_State, S))
 	retn = true;
 
  done:
-	WHACK(bufr);
-
 	return retn;
 }
 
@@ -1649,10 +1630,10 @@ static _Bool _measure_generic_event(CO(Cell_State, S))
 
 	size_t size;
 
-	Buffer bufr = NULL;
+	Buffer bufr = S->bufr;
 
 
-	INIT(HurdLib, Buffer, bufr, ERR(goto done));
+	bufr->reset(bufr);
 	p = (unsigned char *) S->event->get(S->event);
 	size = S->event->size(S->event);
 	bufr->add(bufr, p, size);
@@ -1666,8 +1647,6 @@ static _Bool _measure_generic_event(CO(Cell_State, S))
 	retn = true;
 
  done:
-	WHACK(bufr);
-
 	return retn;
 }
 
@@ -1952,8 +1931,6 @@ static _Bool _format_file(struct file_parameters *fp, CO(String, str))
 
 	char *name;
 
-	unsigned int lp;
-
 	struct inode *inode = &fp->inode;
 
 
@@ -1974,11 +1951,8 @@ static _Bool _format_file(struct file_parameters *fp, CO(String, str))
 		ERR(goto done);
 
 
-	for (lp= 0; lp < sizeof(inode->s_uuid); ++lp) {
-		if ( !str->add_sprintf(str, "%02x", \
-				       (unsigned char) inode->s_uuid[lp]) )
-		     ERR(goto done);
-	}
+	if ( !Hex_add_String(str, inode->s_uuid, sizeof(inode->s_uuid)) )
+		ERR(goto done);
 
 	/* Path description. */
 	if ( !str->add_sprintf(str, "\"}, \"path\": {\"dev\": {"	 \
@@ -1989,11 +1963,9 @@ static _Bool _format_file(struct file_parameters *fp, CO(String, str))
 		ERR(goto done);
 
 	/* File digest. */
-	for (lp= 0; lp < sizeof(fp->digest); ++lp) {
-		if ( !str->add_sprintf(str, "%02x",
-				       (unsigned char) fp->digest[lp]) )
-		     ERR(goto done);
-	}
+	if ( !Hex_add_String(str, (uint8_t *) fp->digest, \
+			     sizeof(fp->digest)) )
+		ERR(goto done);
 
 	/* Ending squiggles. */
 	if ( !str->add_sprintf(str, "\"}") )
@@ -2121,8 +2093,6 @@ static _Bool _format_sock(CO(struct sock, *sp), CO(String, str))
 {
 	_Bool retn = false;
 
-	unsigned int lp;
-
 	if ( !str->add_sprintf(str, "\"sock\": {\"family\": \"%u\", "	     \
 			       "\"type\": \"%u\", \"protocol\": \"%u\", ",   \
 			       sp->family, sp->type,  sp->protocol) )
@@ -2130,11 +2100,8 @@ static _Bool _format_sock(CO(struct sock, *sp), CO(String, str))
 
 	if ( !str->add(str, "\"owner\": \"") )
 		ERR(goto done);
-	for (lp= 0; lp < sizeof(sp->owner); ++lp) {
-		if ( !str->add_sprintf(str, "%02x", \
-				       (unsigned char) sp->owner[lp]) )
-			ERR(goto done);
-	}
+	if ( !Hex_add_String(str, sp->owner, sizeof(sp->owner)) )
+		ERR(goto done);
 	if ( !str->add(str, "\"}") )
 		ERR(goto done);
 
@@ -2211,8 +2178,7 @@ static _Bool _format_socket_connect(CO(Cell_State, S), CO(String, str))
 
 	unsigned char *p;
 
-	unsigned int lp,
-		     size;
+	unsigned int size;
 
 
 	type = (S->type == TSEM_SOCKET_CONNECT) ? "socket_connect" : \
@@ -2250,11 +2216,8 @@ static _Bool _format_socket_connect(CO(Cell_State, S), CO(String, str))
 
 			p = S->socket_connect.u.ipv6_addr;
 			size = sizeof(S->socket_connect.u.ipv6_addr);
-			for (lp= 0; lp < size; ++lp) {
-				if ( !str->add_sprintf(str, "%02x", *p) )
-					ERR(goto done);
-				++p;
-			}
+			if ( !Hex_add_String(str, p, size) )
+				ERR(goto done);
 
 			if ( !str->add(str, "\"") )
 				ERR(goto done);
@@ -2274,11 +2237,8 @@ static _Bool _format_socket_connect(CO(Cell_State, S), CO(String, str))
 
 			p = S->socket_connect.u.addr;
 			size = sizeof(S->socket_connect.u.addr);
-			for (lp= 0; lp < size; ++lp) {
-				if ( !str->add_sprintf(str, "%02x", *p) )
-					ERR(goto done);
-				++p;
-			}
+			if ( !Hex_add_String(str, p, size) )
+				ERR(goto done);
 
 			if ( !str->add(str, "\"") )
 				ERR(goto done);
@@ -2319,8 +2279,7 @@ static _Bool _format_socket_accept(CO(Cell_State, S), CO(String, str))
 
 	unsigned char *p;
 
-	unsigned int lp,
-		     size;
+	unsigned int size;
 
 
 	if ( !str->add_sprintf(str, "\"socket_accept\": {\"family\": "	      \
@@ -2361,11 +2320,8 @@ static _Bool _format_socket_accept(CO(Cell_State, S), CO(String, str))
 				ERR(goto done);
 
 			size = sizeof(S->socket_accept.u.ipv6_addr);
-			for (lp= 0; lp < size; ++lp) {
-				if ( !str->add_sprintf(str, "%02x", *p) )
-					ERR(goto done);
-				++p;
-			}
+			if ( !Hex_add_String(str, p, size) )
+				ERR(goto done);
 
 			if ( !str->add(str, "\"") )
 				ERR(goto done);
@@ -2386,11 +2342,8 @@ static _Bool _format_socket_accept(CO(Cell_State, S), CO(String, str))
 
 			p = S->socket_accept.u.addr;
 			size = sizeof(S->socket_accept.u.addr);
-			for (lp= 0; lp < size; ++lp) {
-				if ( !str->add_sprintf(str, "%02x", *p) )
-					ERR(goto done);
-				++p;
-			}
+			if ( !Hex_add_String(str, p, size) )
+				ERR(goto done);
 			break;
 	}
 
@@ -2426,8 +2379,7 @@ static _Bool _format_task_kill(CO(Cell_State, S), CO(String, str))
 {
 	unsigned char *p;
 
-	unsigned int size,
-		     lp;
+	unsigned int size;
 
 	_Bool retn = false;
 
@@ -2439,11 +2391,8 @@ static _Bool _format_task_kill(CO(Cell_State, S), CO(String, str))
 
 	p    = S->task_kill.task_id;
 	size = sizeof(S->task_kill.task_id);
-	for (lp= 0; lp < size; ++lp) {
-		if ( !str->add_sprintf(str, "%02x", *p) )
-			ERR(goto done);
-		++p;
-	}
+	if ( !Hex_add_String(str, p, size) )
+		ERR(goto done);
 
 	if ( !str->add(str, "}") )
 		ERR(goto done);
@@ -2538,6 +2487,9 @@ static void reset(CO(Cell, this))
 	S->event->reset(S->event);
 	S->identity->reset(S->identity);
 
+	S->bufr->reset(S->bufr);
+	S->match->reset(S->match);
+
 	return;
 }
 
@@ -2630,12 +2582,12 @@ void _dump_socket_create(CO(Cell_State, S))
 void _dump_socket_connect(CO(Cell_State, S))
 
 {
-	char *type;
+	char *type,
+	     hex[2 * sizeof(S->socket_connect.u.addr) + 1];
 
 	unsigned char *p;
 
-	unsigned int lp,
-		     size;
+	unsigned int size;
 
 
 	switch ( S->socket_connect.sock.family ) {
@@ -2673,9 +2625,9 @@ void _dump_socket_connect(CO(Cell_State, S))
 			fputs("addr:   ", stdout);
 			p = S->socket_connect.u.ipv6_addr;
 			size = sizeof(S->socket_connect.u.ipv6_addr);
-			for (lp= 0; lp < size; ++lp)
-				fprintf(stdout, "%02x", *p++);
-			fputs("\n", stdout);
+			Hex_encode(p, size, hex);
+			hex[2 * size] = '\0';
+			fprintf(stdout, "%s\n", hex);
 			break;
 		case AF_UNIX:
 			fprintf(stdout, "path:   %s", \
@@ -2686,9 +2638,9 @@ void _dump_socket_connect(CO(Cell_State, S))
 			fputs("addr:   ", stdout);
 			p = S->socket_connect.u.addr;
 			size = sizeof(S->socket_connect.u.addr);
-			for (lp= 0; lp < size; ++lp)
-				fprintf(stdout, "%02x", *p++);
-			fputs("\n", stdout);
+			Hex_encode(p, size, hex);
+			hex[2 * size] = '\0';
+			fprintf(stdout, "%s\n", hex);
 			break;
 	}
 
@@ -2882,6 +2834,10 @@ static void whack(CO(Cell, this))
 	WHACK(S->event);
 	WHACK(S->identity);
 
+	WHACK(S->parser);
+	WHACK(S->bufr);
+	WHACK(S->match);
+
 	S->root->whack(S->root, this, S);
 	return;
 }
@@ -2926,6 +2882,10 @@ extern Cell NAAAIM_Cell_Init(void)
 	INIT(HurdLib, String, this->state->event, ERR(goto fail));
 	INIT(NAAAIM, Sha256, this->state->identity, ERR(goto fail));
 
+	INIT(NAAAIM, TSEMparser, this->state->parser, ERR(goto fail));
+	INIT(HurdLib, Buffer, this->state->bufr, ERR(goto fail));
+	INIT(HurdLib, String, this->state->match, ERR(goto fail));
+
 	/* Method initialization. */
 	this->parse		    = parse;
 	this->measure		    = measure;
@@ -2948,6 +2908,10 @@ fail:
 	WHACK(this->state->event);
 	WHACK(this->state->identity);
 
+	WHACK(this->state->parser);
+	WHACK(this->state->bufr);
+	WHACK(this->state->match);
+
 	root->whack(root, this, this->state);
 	return NULL;
 }
@@ -39,6 +39,7 @@
 
 #include "NAAAIM.h"
 #include "SHA256.h"
+#include "Hex.h"
 #include "SecurityEvent.h"
 #include "COE.h"
 #include "Cell.h"
@@ -188,6 +189,11 @@ struct NAAAIM_SecurityEvent_State
 
 	/* Event identity/measurement. */
 	Sha256 identity;
+
+	/* Objects reused by each parse and measurement. */
+	TSEMparser parser;
+	Buffer bufr;
+	String str;
 };
 
 
@@ -219,6 +225,10 @@ static void _init_state(CO(SecurityEvent_State, S))
 	S->cell	       = NULL;
 	S->identity    = NULL;
 
+	S->parser = NULL;
+	S->bufr	  = NULL;
+	S->str	  = NULL;
+
 	return;
 }
 
@@ -314,7 +324,7 @@ static _Bool _parse_event(CO(SecurityEvent_State, S), \
 
 	unsigned int lp;
 
-	String str = NULL;
+	String str = S->str;
 
 
 	/* Extract the event field itself. */
@@ -324,7 +334,7 @@ static _Bool _parse_event(CO(SecurityEvent_State, S), \
 		ERR(goto done);
 
 	/* Then the numeric event type. */
-	INIT(HurdLib, String, str, ERR(goto done));
+	str->reset(str);
 	if ( !parser->get_text(parser, "type", str) )
 		ERR(goto done);
 
@@ -345,8 +355,6 @@ static _Bool _parse_event(CO(SecurityEvent_State, S), \
 
 
  done:
-	WHACK(str);
-
 	return retn;
 }
 
@@ -377,7 +385,7 @@ static _Bool parse(CO(SecurityEvent, this), CO(String, event))
 
 	_Bool retn = false;
 
-	TSEMparser parser = NULL;
+	TSEMparser parser = S->parser;
 
 
 	/* Verify object and event state. */
@@ -388,7 +396,7 @@ static _Bool parse(CO(SecurityEvent, this), CO(String, event))
 
 
 	/* Parse the event definition. */
-	INIT(NAAAIM, TSEMparser, parser, ERR(goto done));
+	parser->reset(parser);
 	if ( !_parse_event(S, parser, event) )
 		ERR(goto done);
 
@@ -406,8 +414,6 @@ static _Bool parse(CO(SecurityEvent, this), CO(String, event))
 
 
  done:
-	WHACK(parser);
-
 	if ( !retn )
 		S->poisoned = true;
 
@@ -441,14 +447,14 @@ static _Bool measure(CO(SecurityEvent, this))
 
 	_Bool retn = false;
 
-	Buffer bufr = NULL;
+	Buffer bufr = S->bufr;
 
 
 	/* Verify object and event state. */
 	if ( S->poisoned )
 		ERR(goto done);
 
-	INIT(HurdLib, Buffer, bufr, ERR(goto done));
+	bufr->reset(bufr);
 
 	/* Measure the individual components. */
 	if ( !S->coe->measure(S->coe) )
@@ -460,7 +466,7 @@ static _Bool measure(CO(SecurityEvent, this))
 	if ( !bufr->add(bufr, (uint8_t *) TSEM_name[S->type], \
 			strlen(TSEM_name[S->type])) )
 		ERR(goto done);
-	if ( !bufr->add_hexstring(bufr, S->task_id->get(S->task_id)) )
+	if ( !Hex_add_Buffer(bufr, S->task_id->get(S->task_id)) )
 		ERR(goto done);
 	if ( !S->coe->get_measurement(S->coe, bufr) )
 		ERR(goto done);
@@ -477,8 +483,6 @@ static _Bool measure(CO(SecurityEvent, this))
 	if ( !retn )
 		S->poisoned = true;
 
-	WHACK(bufr);
-
 	return retn;
 }
 
@@ -509,7 +513,7 @@ static _Bool evaluate_pseudonym(CO(SecurityEvent, this), CO(Buffer, pseudonym))
 
 	_Bool retn = false;
 
-	Buffer bufr = NULL;
+	Buffer bufr = S->bufr;
 
 
 	/* Verify object status. */
@@ -518,7 +522,7 @@ static _Bool evaluate_pseudonym(CO(SecurityEvent, this), CO(Buffer, pseudonym))
 
 
 	/* Retrieve the pseudonym value for the event. */
-	INIT(HurdLib, Buffer, bufr, ERR(goto done));
+	bufr->reset(bufr);
 
 	if ( !S->cell->get_pseudonym(S->cell, bufr) )
 		ERR(goto done);;
@@ -527,7 +531,7 @@ static _Bool evaluate_pseudonym(CO(SecurityEvent, this), CO(Buffer, pseudonym))
 	/* If the event matches set the digest value. */
 	if ( pseudonym->equal(pseudonym, bufr) ) {
 		bufr->reset(bufr);
-		if ( !bufr->add_hexstring(bufr, ZERO_LENGTH_FILE) )
+		if ( !Hex_add_Buffer(bufr, ZERO_LENGTH_FILE) )
 			ERR(goto done);
 		S->cell->set_digest(S->cell, bufr);
 	}
@@ -539,8 +543,6 @@ static _Bool evaluate_pseudonym(CO(SecurityEvent, this), CO(Buffer, pseudonym))
 	if ( !retn )
 		S->poisoned = true;
 
-	WHACK(bufr);
-
 	return retn;
 }
 
@@ -741,6 +743,7 @@ static void reset(CO(SecurityEvent, this))
 	S->poisoned = false;
 
 	S->type = TSEM_UNDEFINED;
+	S->pid	= 0;
 
 	S->event->reset(S->event);
 	S->task_id->reset(S->task_id);
@@ -748,6 +751,9 @@ static void reset(CO(SecurityEvent, this))
 	S->cell->reset(S->cell);
 	S->identity->reset(S->identity);
 
+	S->bufr->reset(S->bufr);
+	S->str->reset(S->str);
+
 	return;
 }
 
@@ -805,6 +811,10 @@ static void whack(CO(SecurityEvent, this))
 	WHACK(S->cell);
 	WHACK(S->identity);
 
+	WHACK(S->parser);
+	WHACK(S->bufr);
+	WHACK(S->str);
+
 	S->root->whack(S->root, this, S);
 	return;
 }
@@ -852,6 +862,10 @@ extern SecurityEvent NAAAIM_SecurityEvent_Init(void)
 	INIT(NAAAIM, Cell, this->state->cell, goto fail);
 	INIT(NAAAIM, Sha256, this->state->identity, goto fail);
 
+	INIT(NAAAIM, TSEMparser, this->state->parser, goto fail);
+	INIT(HurdLib, Buffer, this->state->bufr, goto fail);
+	INIT(HurdLib, String, this->state->str, goto fail);
+
 	/* Method initialization. */
 	this->parse		 = parse;
 	this->measure		 = measure;
@@ -876,6 +890,10 @@ fail:
 	WHACK(this->state->cell);
 	WHACK(this->state->identity);
 
+	WHACK(this->state->parser);
+	WHACK(this->state->bufr);
+	WHACK(this->state->str);
+
 	root->whack(root, this, this->state);
 	return NULL;
 }
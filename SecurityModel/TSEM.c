@@ -16,7 +16,11 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <errno.h>
 #include <sys/types.h>
+#if defined(TSEM_TIMING)
+#include <time.h>
+#endif
 
 #include <Origin.h>
 #include <HurdLib.h>
@@ -26,18 +30,36 @@
 
 #include "NAAAIM.h"
 #include "SHA256.h"
+#include "Hex.h"
 #include "Base64.h"
 #include "RSAkey.h"
+#include "ModelCache.h"
 #include "SecurityPoint.h"
 #include "SecurityEvent.h"
 #include "TSEM.h"
 #include "EventModel.h"
+#include "tsem_model.h"
 
 
 /* Default aggregate value. */
 #define DEFAULT_AGGREGATE \
 	"0000000000000000000000000000000000000000000000000000000000000000"
 
+/*
+ * The geometry of the event fingerprint cache.  Events are assigned
+ * to a set by their fingerprint with replacement within a set
+ * managed by a CLOCK hand.
+ */
+#define EVENT_CACHE_SETS 256
+#define EVENT_CACHE_WAYS 4
+
+/* The introduction to the event clause of an event description. */
+#define EVENT_CLAUSE "\"event\": {"
+
+/* FNV-1a parameters for event fingerprints. */
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME  0x100000001b3ULL
+
 /* Object state extraction macro. */
 #define STATE(var) CO(TSEM_State, var) = this->state
 
@@ -85,6 +107,36 @@ struct security_load_definition Security_cmd_list[] = {
 };
 
 
+/**
+ * The structure used to map an event description to its point.  A
+ * point in a compiled model is identified by its slot in the model.
+ */
+struct event_fingerprint {
+	_Bool valid;
+	_Bool referenced;
+	uint64_t hash;
+	Buffer text;
+	SecurityPoint point;
+	uint32_t slot;
+};
+
+
+/**
+ * The event clause fields which do not contribute to the identity of
+ * an event and are excluded from its fingerprint.  The process
+ * identifier must be the first member of the list.
+ */
+static const char *Volatile_fields[] = {
+	"pid",
+	"process",
+	"ttd",
+	"p_ttd",
+	"p_task_id",
+	"ts",
+	NULL
+};
+
+
 /** ExchangeEvent private state information. */
 struct NAAAIM_TSEM_State
 {
@@ -138,9 +190,54 @@ struct NAAAIM_TSEM_State
 	/* An optional security event model. */
 	EventModel model;
 
-	/* The key and signature of a loaded security model. */
+	/* The key and signed content digest of a loaded security model. */
 	Buffer key;
-	Buffer sigdata;
+	Sha256 sigdata;
+
+	/* An optional cache of verified security models. */
+	ModelCache cache;
+
+	/* Objects reused by each model update. */
+	Buffer point;
+	Buffer bufr;
+	Sha256 sha256;
+	SecurityPoint probe;
+
+	/* An event object available for reuse. */
+	SecurityEvent spare;
+
+	/* The most recent event retained by the model. */
+	SecurityEvent retained;
+
+	/* Cache of security state points indexed by event fingerprint. */
+	struct event_fingerprint *fingerprints;
+	unsigned char hands[EVENT_CACHE_SETS];
+	Buffer canonical;
+
+	/* The fingerprint of an event which missed the cache. */
+	_Bool have_pending;
+	uint64_t pending_hash;
+	pid_t pending_pid;
+
+	/* Event fingerprint cache statistics. */
+	unsigned long int cache_hits;
+	unsigned long int cache_misses;
+
+	/* The stage times of the most recent model update. */
+	_Bool timing;
+	uint64_t pseudonym_time;
+	uint64_t measure_time;
+	uint64_t lookup_time;
+
+	/* A compiled security model mapped by the caller. */
+	const struct tsem_model *table;
+	const uint32_t *table_index;
+	const unsigned char *table_points;
+
+	/* The counts and retrieval state of the compiled model points. */
+	uint64_t *table_counts;
+	uint32_t table_cursor;
+	SecurityPoint table_point;
 };
 
 
@@ -181,6 +278,37 @@ static void _init_state(CO(TSEM_State, S))
 
 	S->key		= NULL;
 	S->sigdata	= NULL;
+	S->cache	= NULL;
+
+	S->point    = NULL;
+	S->bufr	    = NULL;
+	S->sha256   = NULL;
+	S->probe    = NULL;
+	S->spare    = NULL;
+	S->retained = NULL;
+
+	S->fingerprints = NULL;
+	S->canonical	= NULL;
+	memset(S->hands, '\0', sizeof(S->hands));
+
+	S->have_pending = false;
+	S->pending_hash = 0;
+	S->pending_pid	= 0;
+
+	S->cache_hits	= 0;
+	S->cache_misses = 0;
+
+	S->timing	  = false;
+	S->pseudonym_time = 0;
+	S->measure_time	  = 0;
+	S->lookup_time	  = 0;
+
+	S->table	= NULL;
+	S->table_index	= NULL;
+	S->table_points = NULL;
+	S->table_counts = NULL;
+	S->table_cursor = 0;
+	S->table_point	= NULL;
 
 	return;
 }
@@ -198,13 +326,19 @@ static void _init_state(CO(TSEM_State, S))
  * \param point	The object containing the security point that is to
  *		be checked.
  *
+ * \param mapped	A pointer to the variable which will be loaded
+ *			with the point in the model which matched.  A
+ *			NULL value indicates the matching point is not
+ *			needed by the caller.
+ *
  * \return	A boolean value is used to indicate whether or not
  *		the point was in the current security model.  A false
  *		false value indicates the point was not found while
  *		a true value indicated the point was present.
  */
 
-static _Bool _is_mapped(CO(Gaggle, map), CO(SecurityPoint, point))
+static _Bool _is_mapped(CO(Gaggle, map), CO(SecurityPoint, point), \
+			SecurityPoint *mapped)
 
 {
 	_Bool retn = false;
@@ -225,6 +359,8 @@ static _Bool _is_mapped(CO(Gaggle, map), CO(SecurityPoint, point))
 			if ( !cp->is_valid(cp) )
 				point->set_invalid(point);
 			cp->increment(cp);
+			if ( mapped != NULL )
+				*mapped = cp;
 			return true;
 		}
 	}
@@ -264,13 +400,13 @@ static _Bool _extend_measurement(CO(TSEM_State, S),    \
 	_Bool retn = false;
 
 	Buffer b,
-	       bufr = NULL;
+	       bufr = S->bufr;
 
-	Sha256 sha256 = NULL;
+	Sha256 sha256 = S->sha256;
 
 
-	INIT(HurdLib, Buffer, bufr, ERR(goto done));
-	INIT(NAAAIM, Sha256, sha256, ERR(goto done));
+	bufr->reset(bufr);
+	sha256->reset(sha256);
 
 	/* Project the update into a domain specific value. */
 	bufr->add(bufr, S->base, sizeof(S->base));
@@ -295,13 +431,353 @@ static _Bool _extend_measurement(CO(TSEM_State, S),    \
 	retn = true;
 
  done:
-	WHACK(bufr);
-	WHACK(sha256);
+	return retn;
+}
+
+
+/**
+ * Internal private method.
+ *
+ * This method is responsible for searching the compiled model for a
+ * security state point.  The index of the model locates the range of
+ * sorted points which share the bucket value of the point so a
+ * search typically requires a single comparison.
+ *
+ * \param S	A pointer to the state information of the model.
+ *
+ * \param point	A pointer to the security state point which is to be
+ *		located.
+ *
+ * \param slot	A pointer to the variable which will be loaded with
+ *		the slot number of the point in the compiled model.
+ *
+ * \return	A boolean value is used to indicate whether or not
+ *		the point is in the compiled model.  A false value
+ *		indicates the point was not found while a true value
+ *		indicates the slot variable has been loaded.
+ */
+
+static _Bool _table_lookup(CO(TSEM_State, S), CO(unsigned char *, point), \
+			   uint32_t *slot)
+
+{
+	int rc;
+
+	uint32_t lp,
+		 bucket;
+
+
+	if ( S->table == NULL )
+		return false;
+
+	bucket = TSEM_MODEL_BUCKET(point, S->table->index_bits);
+	for (lp= S->table_index[bucket]; lp < S->table_index[bucket + 1]; \
+	     ++lp) {
+		rc = memcmp(point, S->table_points + (lp * NAAAIM_IDSIZE), \
+			    NAAAIM_IDSIZE);
+		if ( rc == 0 ) {
+			*slot = lp;
+			return true;
+		}
+		if ( rc < 0 )
+			break;
+	}
+
+	return false;
+}
+
 
+/**
+ * Internal private method.
+ *
+ * This method is responsible for incrementing the count of a point
+ * in the compiled model.  The counts are the only per-instance state
+ * that is maintained for the compiled model and are allocated when
+ * the first event maps to the model.
+ *
+ * \param S	A pointer to the state information of the model.
+ *
+ * \param slot	The slot number of the point whose count is to be
+ *		incremented.
+ *
+ * \return	A boolean value is used to indicate whether or not
+ *		the count was incremented.  A false value indicates
+ *		the counts could not be allocated.
+ */
+
+static _Bool _count_table_point(CO(TSEM_State, S), const uint32_t slot)
+
+{
+	if ( S->table_counts == NULL ) {
+		S->table_counts = calloc(S->table->points, sizeof(uint64_t));
+		if ( S->table_counts == NULL )
+			return false;
+	}
+
+	++S->table_counts[slot];
+	return true;
+}
+
+
+/**
+ * Internal private method.
+ *
+ * This method is responsible for generating the fingerprint of a
+ * security event description.  The fingerprint is computed over
+ * the canonical form of the description, which is the description
+ * with the values of the event clause fields that do not contribute
+ * to the identity of the event removed, so that the recurring events
+ * of different processes have the same fingerprint.  The canonical
+ * form is left in the canonical buffer of the model for verification
+ * against the cache entries.
+ *
+ * \param S	A pointer to the state information of the model.
+ *
+ * \param event	The object containing the event description.
+ *
+ * \param hash	A pointer to the variable which will be loaded with
+ *		the fingerprint of the event.
+ *
+ * \param pid	A pointer to the variable which will be loaded with
+ *		the process identifier of the event.
+ *
+ * \return	A boolean value is used to indicate whether or not
+ *		the event has a fingerprint.  A false value indicates
+ *		the description does not have an event clause with a
+ *		process identifier while a true value indicates the
+ *		fingerprint was generated.
+ */
+
+static _Bool _fingerprint(CO(TSEM_State, S), CO(String, event), \
+			  uint64_t *hash, pid_t *pid)
+
+{
+	_Bool retn     = false,
+	      have_pid = false;
+
+	const char **kp;
+
+	char *p,
+	     *ep,
+	     *start,
+	     *copied,
+	     *clause,
+	     *key,
+	     *value;
+
+	unsigned char *bp;
+
+	unsigned long int vl = 0;
+
+	uint64_t fnv = FNV_OFFSET;
+
+	size_t lp,
+	       length;
+
+	Buffer bufr = S->canonical;
+
+
+	/* Locate the event clause. */
+	start = event->get(event);
+	if ( (p = strstr(start, EVENT_CLAUSE)) == NULL )
+		goto done;
+	p += sizeof(EVENT_CLAUSE) - 1;
+	if ( (clause = strchr(p, '}')) == NULL )
+		goto done;
+
+
+	/*
+	 * Traverse the key/value pairs of the clause and copy the
+	 * description up to the value of each volatile field.
+	 */
+	bufr->reset(bufr);
+	copied = start;
+
+	while ( (key = memchr(p, '"', clause - p)) != NULL ) {
+		++key;
+		if ( ((ep = strchr(key, '"')) == NULL) || (ep > clause) )
+			goto done;
+		length = ep - key;
+		if ( strncmp(ep, "\": \"", 4) != 0 )
+			goto done;
+
+		value = ep + 4;
+		if ( ((ep = strchr(value, '"')) == NULL) || (ep > clause) )
+			goto done;
+		p = ep + 1;
+
+		for (kp= Volatile_fields; *kp != NULL; ++kp) {
+			if ( (strlen(*kp) == length) && \
+			     (memcmp(*kp, key, length) == 0) )
+				break;
+		}
+		if ( *kp == NULL )
+			continue;
+
+		if ( kp == Volatile_fields ) {
+			errno = 0;
+			vl = strtoul(value, &ep, 10);
+			if ( (ep == value) || (*ep != '"') || \
+			     (errno == ERANGE) || (vl > UINT32_MAX) )
+				goto done;
+			have_pid = true;
+		}
+
+		if ( !bufr->add(bufr, (unsigned char *) copied, \
+				value - copied) )
+			ERR(goto done);
+		copied = ep;
+	}
+
+	if ( !have_pid )
+		goto done;
+	if ( !bufr->add(bufr, (unsigned char *) copied, \
+			event->size(event) - (copied - start)) )
+		ERR(goto done);
+
+
+	/* Generate the fingerprint of the canonical description. */
+	bp = bufr->get(bufr);
+	for (lp= 0; lp < bufr->size(bufr); ++lp) {
+		fnv ^= bp[lp];
+		fnv *= FNV_PRIME;
+	}
+
+	*hash = fnv;
+	*pid  = vl;
+	retn  = true;
+
+
+ done:
 	return retn;
 }
 
 
+/**
+ * Internal private method.
+ *
+ * This method is responsible for adding the security state point of
+ * an event which missed the fingerprint cache to the cache.  The
+ * entry to be replaced is selected from the set which the fingerprint
+ * maps to by advancing the CLOCK hand of the set past entries which
+ * have been referenced since the hand last passed them.
+ *
+ * \param S	A pointer to the state information of the model.
+ *
+ * \param point	The object containing the security state point in
+ *		the model which the event mapped to.  A NULL value
+ *		indicates the event mapped to a point in the compiled
+ *		model.
+ *
+ * \param slot	The slot of the point in the compiled model.
+ *
+ * \return	A boolean value is used to indicate whether or not
+ *		the point was cached.  A false value indicates an
+ *		error was encountered while a true value indicates
+ *		the point was added to the cache.
+ */
+
+static _Bool _cache_point(CO(TSEM_State, S), CO(SecurityPoint, point), \
+			  const uint32_t slot)
+
+{
+	_Bool retn = false;
+
+	unsigned int set,
+		     hand;
+
+	struct event_fingerprint *fp;
+
+
+	set  = S->pending_hash % EVENT_CACHE_SETS;
+	hand = S->hands[set];
+
+	while ( true ) {
+		fp = &S->fingerprints[(set * EVENT_CACHE_WAYS) + hand];
+		hand = (hand + 1) % EVENT_CACHE_WAYS;
+		if ( !fp->valid || !fp->referenced )
+			break;
+		fp->referenced = false;
+	}
+	S->hands[set] = hand;
+
+	if ( fp->text == NULL )
+		INIT(HurdLib, Buffer, fp->text, ERR(goto done));
+	fp->text->reset(fp->text);
+	if ( !fp->text->add_Buffer(fp->text, S->canonical) )
+		ERR(goto done);
+
+	fp->valid      = true;
+	fp->hash       = S->pending_hash;
+	fp->referenced = false;
+	fp->point      = point;
+	fp->slot       = slot;
+	retn = true;
+
+
+ done:
+	return retn;
+}
+
+
+/**
+ * Internal private method.
+ *
+ * This method is responsible for invalidating all of the entries in
+ * the event fingerprint cache.  This is required when the event
+ * model changes the mapping of event descriptions to security state
+ * points.
+ *
+ * \param S	A pointer to the state information of the model.
+ */
+
+static void _flush_cache(CO(TSEM_State, S))
+
+{
+	unsigned int lp;
+
+
+	S->have_pending = false;
+	if ( S->fingerprints == NULL )
+		return;
+
+	for (lp= 0; lp < EVENT_CACHE_SETS * EVENT_CACHE_WAYS; ++lp) {
+		S->fingerprints[lp].valid      = false;
+		S->fingerprints[lp].referenced = false;
+	}
+	memset(S->hands, '\0', sizeof(S->hands));
+
+	return;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function returns the current time for the timing of the
+ * stages of a model update.  The monotonic clock is only available
+ * to userspace builds, enclave and firmware builds of the object do
+ * not define TSEM_TIMING and never enable timing.
+ *
+ * \return	The value of the monotonic clock in nanoseconds is
+ *		returned.
+ */
+
+static uint64_t _now(void)
+
+{
+#if defined(TSEM_TIMING)
+	struct timespec ts;
+
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#else
+	return 0;
+#endif
+}
+
+
 /**
  * External public method.
  *
@@ -339,13 +815,19 @@ static _Bool update(CO(TSEM, this), CO(SecurityEvent, event), _Bool *status, \
 
 	_Bool retn	    = false,
 	      added	    = false,
+	      in_table	    = false,
 	      release_point = true;
 
-	Buffer point = NULL;
+	Buffer point = S->point;
 
 	Gaggle list;
 
-	SecurityPoint cp = NULL;
+	uint32_t slot = 0;
+
+	uint64_t start = 0;
+
+	SecurityPoint cp     = NULL,
+		      mapped = NULL;
 
 
 	/* Verify object status. */
@@ -354,11 +836,17 @@ static _Bool update(CO(TSEM, this), CO(SecurityEvent, event), _Bool *status, \
 	if ( S->loading )
 		ERR(goto done);
 
+	if ( S->timing ) {
+		S->pseudonym_time = 0;
+		S->measure_time	  = 0;
+		S->lookup_time	  = 0;
+		start = _now();
+	}
+
 
 	/* Use a default aggregate measurement if not specified. */
 	if ( !S->have_aggregate ) {
-		if ( !S->aggregate->add_hexstring(S->aggregate, \
-						  DEFAULT_AGGREGATE) )
+		if ( !Hex_add_Buffer(S->aggregate, DEFAULT_AGGREGATE) )
 			ERR(goto done);
 		if ( !_extend_measurement(S, S->aggregate->get(S->aggregate), \
 					  S->measurement) )
@@ -379,12 +867,17 @@ static _Bool update(CO(TSEM, this), CO(SecurityEvent, event), _Bool *status, \
 			ERR(goto done);
 	}
 
+	if ( S->timing ) {
+		S->pseudonym_time = _now() - start;
+		start += S->pseudonym_time;
+	}
+
 
 	/*
 	 * Measure the current security exchange event to obtain the
 	 * security state point that will be added to the model.
 	 */
-	INIT(HurdLib, Buffer, point, ERR(goto done));
+	point->reset(point);
 
 	if ( !event->measure(event) )
 		ERR(goto done);
@@ -393,17 +886,47 @@ static _Bool update(CO(TSEM, this), CO(SecurityEvent, event), _Bool *status, \
 	if ( !event->get_pid(event, &S->discipline_pid) )
 		ERR(goto done);
 
-	INIT(NAAAIM, SecurityPoint, cp, ERR(goto done));
-	cp->add(cp, point);
+	S->probe->reset(S->probe);
+	S->probe->add(S->probe, point);
 
+	if ( S->timing ) {
+		S->measure_time = _now() - start;
+		start += S->measure_time;
+	}
 
-	/* Register the security state point. */
-	if ( _is_mapped(S->points, cp) ) {
+
+	/*
+	 * Register the security state point.  A point already in the
+	 * model is evaluated with the probe object so that an event
+	 * which maps to the current model does not allocate memory.
+	 * Only the count of a point in a compiled model is updated,
+	 * the point itself remains in the shared mapping of the model.
+	 */
+	if ( _table_lookup(S, point->get(point), &slot) ) {
+		if ( !_count_table_point(S, slot) )
+			ERR(goto done);
+		in_table = true;
+		cp	 = S->probe;
+		retn	 = true;
+		*status	 = false;
+		goto done;
+	}
+
+	if ( _is_mapped(S->points, S->probe, &mapped) ) {
+		cp	   = S->probe;
 		retn	   = true;
 		*status	   = false;
 		goto done;
 	}
 
+	if ( S->timing ) {
+		S->lookup_time = _now() - start;
+		start = 0;
+	}
+
+	INIT(NAAAIM, SecurityPoint, cp, ERR(goto done));
+	cp->add(cp, point);
+
 
 	/* Update the platform measurement. */
 	if ( !_extend_measurement(S, cp->get(cp), S->measurement) )
@@ -415,6 +938,7 @@ static _Bool update(CO(TSEM, this), CO(SecurityEvent, event), _Bool *status, \
 		ERR(goto done);
 	cp->increment(cp);
 	release_point = false;
+	mapped	      = cp;
 
 	if ( S->sealed ) {
 		cp->set_invalid(cp);
@@ -428,6 +952,7 @@ static _Bool update(CO(TSEM, this), CO(SecurityEvent, event), _Bool *status, \
 	if ( S->logging ) {
 		if ( !GADD(list, event) )
 			ERR(goto done);
+		S->retained = event;
 	}
 
 	retn  = true;
@@ -440,8 +965,23 @@ static _Bool update(CO(TSEM, this), CO(SecurityEvent, event), _Bool *status, \
 		*sealed	    = S->sealed;
 	}
 
-	WHACK(point);
-	if ( release_point )
+	if ( start != 0 )
+		S->lookup_time = _now() - start;
+
+	/*
+	 * Cache the point for an event which missed the fingerprint
+	 * cache.  The process identifier which was removed from the
+	 * description is verified to be the one which the event
+	 * carried.
+	 */
+	if ( retn && S->have_pending && ((mapped != NULL) || in_table) && \
+	     (S->pending_pid == S->discipline_pid) ) {
+		if ( !_cache_point(S, mapped, slot) )
+			retn = false;
+	}
+	S->have_pending = false;
+
+	if ( release_point && (cp != S->probe) )
 		WHACK(cp);
 
 	if ( !retn )
@@ -451,6 +991,223 @@ static _Bool update(CO(TSEM, this), CO(SecurityEvent, event), _Bool *status, \
 }
 
 
+/**
+ * External public method.
+ *
+ * This method implements updating the model with a recurring security
+ * event without parsing and measuring the event.  The fingerprint of
+ * the event description, with the fields which do not contribute to
+ * the identity of the event excluded, is used to locate the security
+ * state point which an identical description previously mapped to.
+ * A hit is confirmed by comparing the full description with the one
+ * which was cached.
+ *
+ * If the event is not in the cache the caller is expected to parse
+ * the event and register it with the ->update method, which will add
+ * the resulting security state point to the cache.
+ *
+ * \param this	A pointer to the object which is being modeled.
+ *
+ * \param event	The object containing the description of the event
+ *		which is to be registered.
+ *
+ * \param hit		A pointer to a boolean value used to inform the
+ *			caller as to whether or not the event was
+ *			registered from the cache.
+ *
+ * \param status	A pointer to a boolean value used to inform
+ *			the caller as to whether or not the event was
+ *			added to the current model.
+ *
+ * \param discipline	A pointer to a boolean value used to inform
+ *			the caller as to whether or not the update
+ *			requires the process to be disciplined.
+ *
+ * \param sealed	A poiner to a boolean value that is used to
+ *			advise the caller whether or not the model
+ *			was sealed.
+ *
+ * \return	A boolean value is used to indicate whether or not
+ *		the cache was interrogated.  A false value indicates
+ *		a failure while a true value indicates the hit value
+ *		describes whether or not the event was registered.
+ */
+
+static _Bool cached_update(CO(TSEM, this), CO(String, event), _Bool *hit, \
+			   _Bool *status, _Bool *discipline, _Bool *sealed)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	unsigned int lp;
+
+	uint64_t hash;
+
+	pid_t pid;
+
+	struct event_fingerprint *fp;
+
+
+	/* Verify object status. */
+	S->have_pending = false;
+	*hit = false;
+
+	if ( S->poisoned )
+		ERR(goto done);
+	if ( S->loading )
+		ERR(goto done);
+	if ( event->poisoned(event) )
+		ERR(goto done);
+
+	if ( S->fingerprints == NULL ) {
+		S->fingerprints = calloc(EVENT_CACHE_SETS * EVENT_CACHE_WAYS, \
+					 sizeof(struct event_fingerprint));
+		if ( S->fingerprints == NULL )
+			ERR(goto done);
+		INIT(HurdLib, Buffer, S->canonical, ERR(goto done));
+	}
+
+
+	/* Descriptions without a process identifier are not cached. */
+	if ( !_fingerprint(S, event, &hash, &pid) ) {
+		if ( S->canonical->poisoned(S->canonical) )
+			ERR(goto done);
+		++S->cache_misses;
+		retn = true;
+		goto done;
+	}
+
+
+	/* Search the set which the fingerprint maps to. */
+	fp = &S->fingerprints[(hash % EVENT_CACHE_SETS) * EVENT_CACHE_WAYS];
+
+	for (lp= 0; lp < EVENT_CACHE_WAYS; ++lp, ++fp) {
+		if ( !fp->valid || (fp->hash != hash) )
+			continue;
+		if ( fp->text->equal(fp->text, S->canonical) )
+			break;
+	}
+
+	if ( lp == EVENT_CACHE_WAYS ) {
+		++S->cache_misses;
+		S->have_pending = true;
+		S->pending_hash = hash;
+		S->pending_pid	= pid;
+		retn = true;
+		goto done;
+	}
+
+
+	/* Register the event against the cached point. */
+	fp->referenced = true;
+	if ( fp->point == NULL ) {
+		if ( !_count_table_point(S, fp->slot) )
+			ERR(goto done);
+		*discipline = false;
+	} else {
+		fp->point->increment(fp->point);
+		*discipline = !fp->point->is_valid(fp->point);
+	}
+
+	S->discipline_pid = pid;
+	++S->cache_hits;
+
+	*hit	    = true;
+	*status	    = false;
+	*sealed	    = S->sealed;
+	retn = true;
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements the allocation of an object to hold a
+ * security event which is to be submitted to the model.  An event
+ * object which was previously released to the model, and not
+ * retained by it, is reset and returned in preference to the
+ * construction of a new object.  This allows an event that maps to
+ * the current model to be processed without memory allocation.
+ *
+ * \param this	A pointer to the object which is to supply the event.
+ *
+ * \param event	A pointer to the object pointer which will be
+ *		loaded with the event object.
+ *
+ * \return	A boolean value is used to indicate whether or not
+ *		an event object was returned.  A false value indicates
+ *		an object could not be allocated while a true value
+ *		indicates the event pointer is valid.
+ */
+
+static _Bool new_event(CO(TSEM, this), SecurityEvent * const event)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+
+	if ( S->spare != NULL ) {
+		*event	 = S->spare;
+		S->spare = NULL;
+		retn = true;
+		goto done;
+	}
+
+	INIT(NAAAIM, SecurityEvent, *event, ERR(goto done));
+	retn = true;
+
+
+ done:
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements the release of an event object which was
+ * obtained with the ->new_event method.  An event which was retained
+ * by the last model update is left in place.  Otherwise the event is
+ * reset and held for reuse, or destroyed if an event is already
+ * being held.
+ *
+ * \param this	A pointer to the object which the event is being
+ *		released to.
+ *
+ * \param event	The event object being released.
+ */
+
+static void release_event(CO(TSEM, this), CO(SecurityEvent, event))
+
+{
+	STATE(S);
+
+
+	if ( (event == NULL) || (event == S->retained) )
+		return;
+
+	if ( S->spare == NULL ) {
+		event->reset(event);
+		S->spare = event;
+	}
+	else
+		event->whack(event);
+
+	return;
+}
+
+
 /**
  * Internal public method.
  *
@@ -475,6 +1232,8 @@ static _Bool _update_map(CO(TSEM, this), CO(Buffer, bpoint))
 
 	_Bool retn = false;
 
+	uint32_t slot;
+
 	SecurityPoint cp = NULL;
 
 
@@ -490,67 +1249,156 @@ static _Bool _update_map(CO(TSEM, this), CO(Buffer, bpoint))
 
 
 	/* Register the security state point. */
-	INIT(NAAAIM, SecurityPoint, cp, ERR(goto done));
+	if ( _table_lookup(S, bpoint->get(bpoint), &slot) ) {
+		retn = true;
+		goto done;
+	}
 
-	cp->add(cp, bpoint);
-	if ( _is_mapped(S->points, cp) ) {
+	S->probe->reset(S->probe);
+	S->probe->add(S->probe, bpoint);
+	if ( _is_mapped(S->points, S->probe, NULL) ) {
 		retn = true;
 		goto done;
 	}
 
+	INIT(NAAAIM, SecurityPoint, cp, ERR(goto done));
+	cp->add(cp, bpoint);
+
+
+	/* Update the platform measurement. */
+	if ( !_extend_measurement(S, cp->get(cp), S->measurement) )
+		ERR(goto done);
+
+
+	/* Add the security state point. */
+	if ( !GADD(S->points, cp) )
+		ERR(goto done);
+	retn = true;
+
+
+ done:
+	if ( !retn )
+		WHACK(cp);
+
+	return retn;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function encapsulates the addition of a line from a model file
+ * to the digest that the signature for the model is verified against.
+ * Each line is hashed as it is loaded so the contents of the model do
+ * not need to be retained until the signature is reached.
+ *
+ * \param digest	The object which the model contents are being
+ *			hashed into.
+ *
+ * \param bufr		An object which is used to hold the line while
+ *			it is hashed.  The object is empty on return.
+ *
+ * \param line		The object containing the line to add to the
+ *			digest.
+ *
+ * \return	A boolean value is used to indicate the status of the
+ *		addition of the line.  A false value indicates the
+ *		addition failed while a true value indicates the
+ *		contents of the line had been added to the digest.
+ */
+
+static _Bool _add_entry(CO(Sha256, digest), CO(Buffer, bufr), \
+			CO(String, line))
+
+{
+	_Bool retn = false;
+
 
-	/* Update the platform measurement. */
-	if ( !_extend_measurement(S, cp->get(cp), S->measurement) )
+	bufr->reset(bufr);
+	if ( !bufr->add(bufr, (void *) line->get(line), line->size(line) + 1) )
 		ERR(goto done);
-
-
-	/* Add the security state point. */
-	if ( !GADD(S->points, cp) )
+	if ( !digest->add(digest, bufr) )
 		ERR(goto done);
+
 	retn = true;
 
 
  done:
-	if ( !retn )
-		WHACK(cp);
-
+	bufr->reset(bufr);
 	return retn;
+
 }
 
 
 /**
  * Internal private function.
  *
- * This function encapsulates the addition of a line from a model file
- * to the Buffer object that will be hashed to generate the signature
- * for the model.
+ * This function carries out the verification of the signature over
+ * the digest of a security model.
  *
- * \param bufr		The state information for the model object.
+ * \param key		The object containing the public key which the
+ *			model was signed with.
  *
- * \param line		The object containing the line to add to the
- *			file.
+ * \param digest	The object containing the digest of the contents
+ *			of the security model.
+ *
+ * \param signature	The object containing the signature.
+ *
+ * \param cache		An optional cache of verified models which is
+ *			checked before the signature is verified and
+ *			which is updated after a successful verification.
+ *
+ * \param valid		A pointer to the boolean value that will be
+ *			loaded with the result of the signature
+ *			validation.
  *
  * \return	A boolean value is used to indicate the status of the
- *		addition of the line.  A false value indicates the
- *		addition failed while a true value indicates the
- *		contents of the line had been added to the buffer.
+ *		verification of the signature.  A false value indicates
+ *		an error was encountered while verifying the signature.
+ *		A true value indicates the variable pointed to by the
+ *		valid variable contains the status of the signature.
  */
 
-static _Bool _add_entry(CO(Buffer, bufr), CO(String, line))
+static _Bool _verify_signature(CO(Buffer, key), CO(Buffer, digest), \
+			       CO(Buffer, signature), CO(ModelCache, cache), \
+			       _Bool *valid)
 
 {
-	_Bool retn = false;
+	_Bool retn = false,
+	      hit  = false;
 
+	RSAkey rsakey = NULL;
 
-	if ( !bufr->add(bufr, (void *) line->get(line), line->size(line) + 1) )
+
+	/* Use a previous verification of the model. */
+	if ( (cache != NULL) && \
+	     !cache->check(cache, digest, key, signature, &hit) )
+		hit = false;
+	if ( hit ) {
+		*valid = true;
+		retn   = true;
+		goto done;
+	}
+
+
+	/* Verify the signature against the model digest. */
+	INIT(NAAAIM, RSAkey, rsakey, ERR(goto done));
+	if ( !rsakey->load_public(rsakey, key) )
+		ERR(goto done);
+
+	if ( !rsakey->verify_digest(rsakey, signature, digest, valid) )
 		ERR(goto done);
 
+	if ( *valid && (cache != NULL) )
+		cache->add(cache, digest, key, signature);
+
 	retn = true;
 
 
  done:
-	return retn;
+	WHACK(rsakey);
 
+	return retn;
 }
 
 
@@ -559,15 +1407,18 @@ static _Bool _add_entry(CO(Buffer, bufr), CO(String, line))
  *
  * This function carries out the validation of a signed security model.
  *
- * \param key		The object containing
- *			model over which the signature is generated.
+ * \param key		The object containing the Base64 encoded public
+ *			key which the model was signed with.
  *
- * \param sigdata	The object containing the contents of the
- *			security model in a form suitable for computing
- *			the hash signature.
+ * \param sigdata	The object containing the digest of the contents
+ *			of the security model.
  *
  * \param sig		The Base64 encoded signature.
  *
+ * \param cache		An optional cache of verified models which is
+ *			checked before the signature is verified and
+ *			which is updated after a successful verification.
+ *
  * \param valid		A pointer to the boolean value that will be
  *			loaded with the result of the signature
  *			validation.
@@ -580,8 +1431,8 @@ static _Bool _add_entry(CO(Buffer, bufr), CO(String, line))
  *		contains the status of the signature.
  */
 
-static _Bool _verify_model(CO(Buffer, key), CO(Buffer, sigdata), char * sig, \
-			   _Bool *valid)
+static _Bool _verify_model(CO(Buffer, key), CO(Sha256, sigdata), char * sig, \
+			   CO(ModelCache, cache), _Bool *valid)
 
 {
 	_Bool retn = false;
@@ -592,10 +1443,13 @@ static _Bool _verify_model(CO(Buffer, key), CO(Buffer, sigdata), char * sig, \
 
 	Base64 base64 = NULL;
 
-	RSAkey rsakey = NULL;
+
+	/* Complete the digest of the model. */
+	if ( !sigdata->compute(sigdata) )
+		ERR(goto done);
 
 
-	/* Load the key that was provided. */
+	/* Decode the key and the signature. */
 	INIT(HurdLib, String, str, ERR(goto done));
 	if ( !str->add(str, (char *) key->get(key)) )
 		ERR(goto done);
@@ -605,12 +1459,6 @@ static _Bool _verify_model(CO(Buffer, key), CO(Buffer, sigdata), char * sig, \
 	if ( !base64->decode(base64, str, key) )
 		ERR(goto done);
 
-	INIT(NAAAIM, RSAkey, rsakey, ERR(goto done));
-	if ( !rsakey->load_public(rsakey, key) )
-		ERR(goto done);
-
-
-	/* Decode and verify the signature. */
 	str->reset(str);
 	if ( !str->add(str, sig) )
 		ERR(goto done);
@@ -619,9 +1467,11 @@ static _Bool _verify_model(CO(Buffer, key), CO(Buffer, sigdata), char * sig, \
 	if ( !base64->decode(base64, str, signature) )
 		ERR(goto done);
 
-	if ( !rsakey->verify(rsakey, signature, sigdata, valid) )
-		ERR(goto done);
 
+	/* Verify the signature against the model digest. */
+	if ( !_verify_signature(key, sigdata->get_Buffer(sigdata), signature, \
+				cache, valid) )
+		ERR(goto done);
 	retn = true;
 
 
@@ -629,7 +1479,6 @@ static _Bool _verify_model(CO(Buffer, key), CO(Buffer, sigdata), char * sig, \
 	WHACK(signature);
 	WHACK(str);
 	WHACK(base64);
-	WHACK(rsakey);
 
 	return retn;
 
@@ -697,18 +1546,18 @@ static _Bool load(CO(TSEM, this), CO(String, entry))
 
 	/* Implement the command. */
 	if ( S->sigdata == NULL )
-		INIT(HurdLib, Buffer, S->sigdata, ERR(goto done));
+		INIT(NAAAIM, Sha256, S->sigdata, ERR(goto done));
 
 	INIT(HurdLib, Buffer, bufr, ERR(goto done));
 
 	switch ( dp->command ) {
 		case model_cmd_comment:
-			if ( !_add_entry(S->sigdata, entry) )
+			if ( !_add_entry(S->sigdata, S->bufr, entry) )
 				ERR(goto done);
 			break;
 
 		case model_cmd_key:
-			if ( !_add_entry(S->sigdata, entry) )
+			if ( !_add_entry(S->sigdata, S->bufr, entry) )
 				ERR(goto done);
 
 			if ( S->key != NULL )
@@ -720,50 +1569,51 @@ static _Bool load(CO(TSEM, this), CO(String, entry))
 			break;
 
 		case model_cmd_base:
-			if ( !_add_entry(S->sigdata, entry) )
+			if ( !_add_entry(S->sigdata, S->bufr, entry) )
 				ERR(goto done);
 
-			if ( !bufr->add_hexstring(bufr, arg) )
+			if ( !Hex_add_Buffer(bufr, arg) )
 				ERR(goto done);
 			memcpy(S->base, bufr->get(bufr), sizeof(S->base));
 			break;
 
 		case model_cmd_aggregate:
-			if ( !_add_entry(S->sigdata, entry) )
+			if ( !_add_entry(S->sigdata, S->bufr, entry) )
 				ERR(goto done);
 
-			if ( !bufr->add_hexstring(bufr, arg) )
+			if ( !Hex_add_Buffer(bufr, arg) )
 				ERR(goto done);
 			if ( !this->set_aggregate(this, bufr) )
 				ERR(goto done);
 			break;
 
 		case model_cmd_state:
-			if ( !_add_entry(S->sigdata, entry) )
+			if ( !_add_entry(S->sigdata, S->bufr, entry) )
 				ERR(goto done);
 
-			if ( !bufr->add_hexstring(bufr, arg) )
+			if ( !Hex_add_Buffer(bufr, arg) )
 				ERR(goto done);
 			if ( !_update_map(this, bufr) )
 				ERR(goto done);
 			break;
 
 		case model_cmd_pseudonym:
-			if ( !_add_entry(S->sigdata, entry) )
+			if ( !_add_entry(S->sigdata, S->bufr, entry) )
 				ERR(goto done);
 
 			if ( S->model == NULL )
 				INIT(NAAAIM, EventModel, S->model, \
 				     ERR(goto done));
 
-			if ( !bufr->add_hexstring(bufr, arg) )
+			if ( !Hex_add_Buffer(bufr, arg) )
 				ERR(goto done);
 			if ( !S->model->add_pseudonym(S->model, bufr) )
 				ERR(goto done);
+			_flush_cache(S);
 			break;
 
 		case model_cmd_seal:
-			if ( !_add_entry(S->sigdata, entry) )
+			if ( !_add_entry(S->sigdata, S->bufr, entry) )
 				ERR(goto done);
 
 			this->seal(this);
@@ -774,14 +1624,15 @@ static _Bool load(CO(TSEM, this), CO(String, entry))
 				ERR(goto done);
 
 			if ( !_verify_model(S->key, S->sigdata, arg, \
-					    &sig_valid) )
+					    S->cache, &sig_valid) )
 				ERR(goto done);
+			S->sigdata->reset(S->sigdata);
 			if ( !sig_valid )
 				ERR(goto done);
 			break;
 
 		case model_cmd_end:
-			if ( !_add_entry(S->sigdata, entry) )
+			if ( !_add_entry(S->sigdata, S->bufr, entry) )
 				ERR(goto done);
 
 			S->loading = false;
@@ -798,6 +1649,239 @@ static _Bool load(CO(TSEM, this), CO(String, entry))
 }
 
 
+/**
+ * Internal private method.
+ *
+ * This method carries out the verification of the signature of a
+ * compiled security model.  The digest of the model is computed
+ * directly from the mapping of the model in blocks so that the
+ * model is not copied into private memory.
+ *
+ * \param S	A pointer to the state information of the model.
+ *
+ * \param model	A pointer to the compiled model.
+ *
+ * \param size	The size of the compiled model.
+ *
+ * \param valid	A pointer to the boolean value that will be loaded
+ *		with the result of the signature validation.
+ *
+ * \return	A boolean value is used to indicate the status of the
+ *		verification of the signature.  A false value indicates
+ *		an error was encountered while verifying the signature.
+ *		A true value indicates the variable pointed to by the
+ *		valid variable contains the status of the signature.
+ */
+
+static _Bool _verify_table(CO(TSEM_State, S), CO(unsigned char *, model), \
+			   const size_t size, _Bool *valid)
+
+{
+	_Bool retn = false;
+
+	const struct tsem_model *hdr = (const struct tsem_model *) model;
+
+	size_t lp,
+	       block,
+	       signed_size;
+
+	Buffer key	 = NULL,
+	       signature = NULL,
+	       bufr	 = S->bufr;
+
+	Sha256 digest = NULL;
+
+
+	/* Compute the digest over the signed portion of the model. */
+	INIT(NAAAIM, Sha256, digest, ERR(goto done));
+
+	signed_size = size - hdr->signature_size;
+	for (lp= 0; lp < signed_size; lp += block) {
+		block = signed_size - lp;
+		if ( block > 65536 )
+			block = 65536;
+
+		bufr->reset(bufr);
+		if ( !bufr->add(bufr, model + lp, block) )
+			ERR(goto done);
+		if ( !digest->add(digest, bufr) )
+			ERR(goto done);
+	}
+	bufr->reset(bufr);
+
+	if ( !digest->compute(digest) )
+		ERR(goto done);
+
+
+	/* Verify the signature with the key carried by the model. */
+	INIT(HurdLib, Buffer, key, ERR(goto done));
+	if ( !key->add(key, model + signed_size - hdr->key_size, \
+		       hdr->key_size) )
+		ERR(goto done);
+
+	INIT(HurdLib, Buffer, signature, ERR(goto done));
+	if ( !signature->add(signature, model + signed_size, \
+			     hdr->signature_size) )
+		ERR(goto done);
+
+	if ( !_verify_signature(key, digest->get_Buffer(digest), signature, \
+				S->cache, valid) )
+		ERR(goto done);
+	retn = true;
+
+
+ done:
+	WHACK(key);
+	WHACK(signature);
+	WHACK(digest);
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements the initialization of the model from a
+ * compiled security model.  The compiled model is referenced in place
+ * and must remain mapped by the caller for the lifetime of the
+ * object.  Only the events which are not in the compiled model cause
+ * security state points to be allocated by the object.
+ *
+ * \param this		A pointer to the object that is to be
+ *			initialized.
+ *
+ * \param model		A pointer to the compiled model.
+ *
+ * \param size		The size of the compiled model.
+ *
+ * \param sealed	A pointer to a boolean value that is used to
+ *			advise the caller whether or not the compiled
+ *			model sealed the model.
+ *
+ * \return	A boolean value is used to indicate whether or not
+ *		the compiled model was verified and loaded.  A false
+ *		value indicates a failure occurred while a true value
+ *		indicates the security model was initialized.
+ */
+
+static _Bool map_model(CO(TSEM, this), CO(unsigned char *, model), \
+		       const size_t size, _Bool *sealed)
+
+{
+	STATE(S);
+
+	_Bool retn  = false,
+	      valid = false;
+
+	const struct tsem_model *hdr = (const struct tsem_model *) model;
+
+	const unsigned char *p;
+
+	size_t expected;
+
+	uint32_t lp,
+		 buckets;
+
+	Buffer bufr = NULL;
+
+
+	/* Verify object status. */
+	if ( S->poisoned )
+		ERR(goto done);
+	if ( S->loading || (S->table != NULL) )
+		ERR(goto done);
+	if ( S->points->size(S->points) != 0 )
+		ERR(goto done);
+
+
+	/* Verify the structure of the compiled model. */
+	if ( size < sizeof(struct tsem_model) )
+		ERR(goto done);
+	if ( memcmp(hdr->magic, TSEM_MODEL_MAGIC, sizeof(hdr->magic)) != 0 )
+		ERR(goto done);
+	if ( hdr->version != TSEM_MODEL_VERSION )
+		ERR(goto done);
+	if ( hdr->index_bits > TSEM_MODEL_MAX_BITS )
+		ERR(goto done);
+	if ( (hdr->key_size == 0) || (hdr->signature_size == 0) )
+		ERR(goto done);
+
+	buckets	 = 1 << hdr->index_bits;
+	expected = sizeof(struct tsem_model);
+	expected += ((size_t) buckets + 1) * sizeof(uint32_t);
+	expected += ((size_t) hdr->points + hdr->pseudonyms) * NAAAIM_IDSIZE;
+	expected += (size_t) hdr->key_size + hdr->signature_size;
+	if ( expected != size )
+		ERR(goto done);
+
+	if ( !_verify_table(S, model, size, &valid) )
+		ERR(goto done);
+	if ( !valid )
+		ERR(goto done);
+
+	S->table_index	= (const uint32_t *) (model + sizeof(struct tsem_model));
+	S->table_points = (const unsigned char *) \
+		(S->table_index + buckets + 1);
+
+	if ( S->table_index[0] != 0 )
+		ERR(goto done);
+	if ( S->table_index[buckets] != hdr->points )
+		ERR(goto done);
+	for (lp= 0; lp < buckets; ++lp) {
+		if ( S->table_index[lp] > S->table_index[lp + 1] )
+			ERR(goto done);
+	}
+
+
+	/* Initialize the model from the compiled model. */
+	memcpy(S->base, hdr->base, sizeof(S->base));
+
+	INIT(HurdLib, Buffer, bufr, ERR(goto done));
+	if ( hdr->flags & TSEM_MODEL_AGGREGATE ) {
+		if ( !bufr->add(bufr, hdr->aggregate, sizeof(hdr->aggregate)) )
+			ERR(goto done);
+		if ( !this->set_aggregate(this, bufr) )
+			ERR(goto done);
+	}
+	memcpy(S->measurement, hdr->measurement, sizeof(S->measurement));
+
+	p = S->table_points + ((size_t) hdr->points * NAAAIM_IDSIZE);
+	for (lp= 0; lp < hdr->pseudonyms; ++lp, p += NAAAIM_IDSIZE) {
+		if ( S->model == NULL )
+			INIT(NAAAIM, EventModel, S->model, ERR(goto done));
+
+		bufr->reset(bufr);
+		if ( !bufr->add(bufr, p, NAAAIM_IDSIZE) )
+			ERR(goto done);
+		if ( !S->model->add_pseudonym(S->model, bufr) )
+			ERR(goto done);
+	}
+	_flush_cache(S);
+
+	INIT(NAAAIM, SecurityPoint, S->table_point, ERR(goto done));
+	S->table = hdr;
+
+	if ( hdr->flags & TSEM_MODEL_SEALED )
+		this->seal(this);
+	*sealed = S->sealed;
+
+	retn = true;
+
+
+ done:
+	WHACK(bufr);
+
+	if ( !retn ) {
+		S->table_index	= NULL;
+		S->table_points = NULL;
+		S->poisoned	= true;
+	}
+
+	return retn;
+}
+
+
 /**
  * External public method.
  *
@@ -1141,6 +2225,12 @@ static _Bool get_state(CO(TSEM, this), CO(Buffer, out))
 	/* Clone the list of security coefficients. */
 	INIT(HurdLib, Buffer, points, ERR(goto done));
 
+	if ( S->table != NULL ) {
+		if ( !points->add(points, S->table_points, \
+				  (size_t) S->table->points * NAAAIM_IDSIZE) )
+			ERR(goto done);
+	}
+
 	cnt = S->points->size(S->points);
 	S->points->rewind_cursor(S->points);
 
@@ -1151,7 +2241,7 @@ static _Bool get_state(CO(TSEM, this), CO(Buffer, out))
 	}
 
 	/* Sort the points. */
-	cnt = S->points->size(S->points);
+	cnt = points->size(points) / NAAAIM_IDSIZE;
 	qsort(points->get(points), cnt, NAAAIM_IDSIZE, _state_sort);
 
 	/* Generate the state measurement. */
@@ -1332,6 +2422,10 @@ static size_t trajectory_size(CO(TSEM, this))
  * is completely traversed.  The traversal can be reset by calling the
  * ->rewind_points method.
  *
+ * The points of a compiled model are returned first.  Each of these
+ * is returned in an object owned by the model which is reused by the
+ * next call to this method.
+ *
  * \param this	A pointer to the object whose points are to be
  *		retrieved.
  *
@@ -1356,6 +2450,8 @@ static _Bool get_point(CO(TSEM, this), SecurityPoint * const point)
 
 	void *p;
 
+	Buffer bufr;
+
 	SecurityPoint return_point = NULL;
 
 
@@ -1364,6 +2460,26 @@ static _Bool get_point(CO(TSEM, this), SecurityPoint * const point)
 		goto done;
 
 
+	/* Return the next point from the compiled model. */
+	if ( (S->table != NULL) && (S->table_cursor < S->table->points) ) {
+		bufr = S->bufr;
+		bufr->reset(bufr);
+		if ( !bufr->add(bufr, S->table_points + \
+				(S->table_cursor * NAAAIM_IDSIZE), \
+				NAAAIM_IDSIZE) )
+			ERR(retn = false; goto done);
+
+		return_point = S->table_point;
+		return_point->reset(return_point);
+		return_point->add(return_point, bufr);
+		if ( S->table_counts != NULL )
+			return_point->set_count(return_point, \
+					S->table_counts[S->table_cursor]);
+		++S->table_cursor;
+		goto done;
+	}
+
+
 	/* Verify that we are in the bounds of the list. */
 	if ( (p = S->points->get(S->points)) == NULL ) {
 		retn = true;
@@ -1400,6 +2516,7 @@ static void rewind_points(CO(TSEM, this))
 {
 	STATE(S);
 
+	S->table_cursor = 0;
 	S->points->rewind_cursor(S->points);
 	return;
 }
@@ -1423,7 +2540,12 @@ static size_t points_size(CO(TSEM, this))
 {
 	STATE(S);
 
-	return S->points->size(S->points);
+	size_t size = S->points->size(S->points);
+
+
+	if ( S->table != NULL )
+		size += S->table->points;
+	return size;
 }
 
 
@@ -1694,6 +2816,121 @@ static void disable_logging(CO(TSEM, this))
 }
 
 
+/**
+ * External public method.
+ *
+ * This method sets the cache of verified security models that is
+ * used when the signature of a loaded model is verified.  The cache
+ * remains owned by the caller.
+ *
+ * \param this	A pointer to the model which is to use the cache.
+ *
+ * \param cache	The cache object which is to be used.
+ */
+
+static void set_model_cache(CO(TSEM, this), CO(ModelCache, cache))
+
+{
+	this->state->cache = cache;
+	return;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method returns the number of events which were registered
+ * from the event fingerprint cache and the number which missed the
+ * cache and were parsed and measured.
+ *
+ * \param this		A pointer to the model whose cache statistics
+ *			are to be returned.
+ *
+ * \param hits		A pointer to the variable which will be loaded
+ *			with the number of cache hits.
+ *
+ * \param misses	A pointer to the variable which will be loaded
+ *			with the number of cache misses.
+ */
+
+static void cache_statistics(CO(TSEM, this), unsigned long int *hits, \
+			     unsigned long int *misses)
+
+{
+	*hits	= this->state->cache_hits;
+	*misses = this->state->cache_misses;
+	return;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method enables or disables the timing of the stages of a
+ * model update.  Timing is only available if the object was built
+ * with TSEM_TIMING defined, otherwise the request is ignored.
+ *
+ * \param this		A pointer to the model whose updates are to
+ *			be timed.
+ *
+ * \param timing	A flag indicating whether or not the updates
+ *			are to be timed.
+ */
+
+static void enable_timing(CO(TSEM, this), const _Bool timing)
+
+{
+	STATE(S);
+
+
+#if defined(TSEM_TIMING)
+	S->timing	  = timing;
+#endif
+	S->pseudonym_time = 0;
+	S->measure_time	  = 0;
+	S->lookup_time	  = 0;
+
+	return;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method returns the time spent in each stage of the most
+ * recent model update.  The times are zero if timing has not been
+ * enabled with the ->enable_timing method.
+ *
+ * \param this		A pointer to the model whose update times
+ *			are to be returned.
+ *
+ * \param pseudonym	A pointer to the variable which will be loaded
+ *			with the time spent evaluating the event against
+ *			the pseudonyms of the model.
+ *
+ * \param measure	A pointer to the variable which will be loaded
+ *			with the time spent measuring the event.
+ *
+ * \param lookup	A pointer to the variable which will be loaded
+ *			with the time spent locating the security state
+ *			point in the model.
+ */
+
+static void get_timing(CO(TSEM, this), uint64_t *pseudonym, \
+		       uint64_t *measure, uint64_t *lookup)
+
+{
+	STATE(S);
+
+
+	*pseudonym = S->pseudonym_time;
+	*measure   = S->measure_time;
+	*lookup	   = S->lookup_time;
+
+	return;
+}
+
+
 /**
  * External public method.
  *
@@ -1727,6 +2964,8 @@ static void whack(CO(TSEM, this))
 {
 	STATE(S);
 
+	unsigned int lp;
+
 
 	WHACK(S->aggregate);
 
@@ -1747,6 +2986,22 @@ static void whack(CO(TSEM, this))
 	WHACK(S->key);
 	WHACK(S->sigdata);
 
+	WHACK(S->point);
+	WHACK(S->bufr);
+	WHACK(S->sha256);
+	WHACK(S->probe);
+	WHACK(S->spare);
+
+	if ( S->fingerprints != NULL ) {
+		for (lp= 0; lp < EVENT_CACHE_SETS * EVENT_CACHE_WAYS; ++lp)
+			WHACK(S->fingerprints[lp].text);
+		free(S->fingerprints);
+	}
+	WHACK(S->canonical);
+
+	free(S->table_counts);
+	WHACK(S->table_point);
+
 	S->root->whack(S->root, this, S);
 	return;
 }
@@ -1794,9 +3049,19 @@ extern TSEM NAAAIM_TSEM_Init(void)
 	INIT(HurdLib, Gaggle, this->state->forensics, goto fail);
 	INIT(HurdLib, Gaggle, this->state->TE_events, goto fail);
 
+	INIT(HurdLib, Buffer, this->state->point, goto fail);
+	INIT(HurdLib, Buffer, this->state->bufr, goto fail);
+	INIT(NAAAIM, Sha256, this->state->sha256, goto fail);
+	INIT(NAAAIM, SecurityPoint, this->state->probe, goto fail);
+
 	/* Method initialization. */
-	this->update	 = update;
-	this->load	 = load;
+	this->update	    = update;
+	this->cached_update = cached_update;
+	this->load	    = load;
+	this->map_model	    = map_model;
+
+	this->new_event	    = new_event;
+	this->release_event = release_event;
 
 	this->set_aggregate   = set_aggregate;
 
@@ -1825,9 +3090,13 @@ extern TSEM NAAAIM_TSEM_Init(void)
 	this->dump_points  = dump_points;
 	this->dump_forensics = dump_forensics;
 
-	this->disable_logging = disable_logging;
-	this->seal	      = seal;
-	this->whack	      = whack;
+	this->disable_logging  = disable_logging;
+	this->set_model_cache  = set_model_cache;
+	this->cache_statistics = cache_statistics;
+	this->enable_timing    = enable_timing;
+	this->get_timing       = get_timing;
+	this->seal	       = seal;
+	this->whack	       = whack;
 
 	return this;
 
@@ -1835,6 +3104,13 @@ fail:
 	WHACK(this->state->aggregate);
 	WHACK(this->state->trajectory);
 	WHACK(this->state->points);
+	WHACK(this->state->forensics);
+	WHACK(this->state->TE_events);
+
+	WHACK(this->state->point);
+	WHACK(this->state->bufr);
+	WHACK(this->state->sha256);
+	WHACK(this->state->probe);
 
 	root->whack(root, this, this->state);
 	return NULL;
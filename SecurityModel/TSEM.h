@@ -20,6 +20,8 @@ typedef struct NAAAIM_TSEM * TSEM;
 
 typedef struct NAAAIM_TSEM_State * TSEM_State;
 
+struct NAAAIM_ModelCache;
+
 /**
  * External ExchangeEvent object representation.
  */
@@ -28,7 +30,14 @@ struct NAAAIM_TSEM
 	/* External methods. */
 	_Bool (*update)(const TSEM, const SecurityEvent, _Bool *, \
 			_Bool *, _Bool *);
+	_Bool (*cached_update)(const TSEM, const String, _Bool *, \
+			       _Bool *, _Bool *, _Bool *);
 	_Bool (*load)(const TSEM, const String);
+	_Bool (*map_model)(const TSEM, const unsigned char *, const size_t, \
+			   _Bool *);
+
+	_Bool (*new_event)(const TSEM, SecurityEvent *);
+	void (*release_event)(const TSEM, const SecurityEvent);
 
 	_Bool (*set_aggregate)(const TSEM, const Buffer);
 
@@ -58,6 +67,11 @@ struct NAAAIM_TSEM
 	void (*dump_forensics)(const TSEM);
 
 	void (*disable_logging)(const TSEM);
+	void (*set_model_cache)(const TSEM, struct NAAAIM_ModelCache * const);
+	void (*cache_statistics)(const TSEM, unsigned long int *, \
+				 unsigned long int *);
+	void (*enable_timing)(const TSEM, const _Bool);
+	void (*get_timing)(const TSEM, uint64_t *, uint64_t *, uint64_t *);
 	void (*seal)(const TSEM);
 	void (*whack)(const TSEM);
 
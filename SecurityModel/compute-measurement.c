@@ -5,6 +5,15 @@
  * the host identity projected behavior trajectory points.  In addition
  * the hardware based measurement which is an extension of of the
  * aggregate boot measurement is computed.
+ *
+ * The contours file may contain either a security state point on each
+ * line or a security model in which the points are specified with
+ * state commands, such as the output of the threaded mode of the
+ * generate-states utility.  The -t option requests that the host
+ * projection of the points be computed by the specified number of
+ * threads.  The projected points are extended into the measurement in
+ * the order of the contours file so the measurement is independent of
+ * the number of threads.
  */
 
 /**************************************************************************
@@ -15,6 +24,15 @@
  **************************************************************************/
 
 
+/* Local defines. */
+
+/* The maximum number of threads that can project the points. */
+#define MAX_THREADS 64
+
+/* The model command which introduces a security state point. */
+#define STATE_CMD "state "
+
+
 /* Include files. */
 #include <stdio.h>
 #include <string.h>
@@ -27,6 +45,9 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <pthread.h>
 
 #include <HurdLib.h>
 #include <Buffer.h>
@@ -36,11 +57,299 @@
 #include <NAAAIM.h>
 #include <SHA256.h>
 
+#include <Hex.h>
+
 #include "tsem_event.h"
 #include "COE.h"
 #include "Cell.h"
 
 
+/** The model commands that do not specify a security state point. */
+static const char *Model_commands[] = {
+	"aggregate ",
+	"pseudonym ",
+	"key ",
+	"base ",
+	"signature ",
+	"seal",
+	"end",
+	NULL
+};
+
+/** The portion of the points projected by a thread. */
+struct project_thread {
+	pthread_t thread;
+	_Bool started;
+	_Bool error;
+
+	size_t start;
+	size_t end;
+
+	uint8_t *points;
+	const uint8_t *host;
+
+	Sha256 sha256;
+	Buffer bufr;
+};
+
+
+/**
+ * Private function.
+ *
+ * This function locates the security state point in a line of the
+ * contours file.
+ *
+ * \param line		A pointer to the line.
+ *
+ * \param length	A pointer to the length of the line, which is
+ *			updated to the length of the point.
+ *
+ * \return		A pointer to the point is returned.  A NULL value
+ *			indicates the line does not contain a point.
+ */
+
+static const char * contour_point(const char *line, size_t *length)
+
+{
+	const char **cp;
+
+
+	if ( (*length == 0) || (*line == '#') )
+		return NULL;
+
+	for (cp= Model_commands; *cp != NULL; ++cp) {
+		if ( (*length >= strlen(*cp)) && \
+		     (strncmp(line, *cp, strlen(*cp)) == 0) )
+			return NULL;
+	}
+
+	if ( (*length > strlen(STATE_CMD)) && \
+	     (strncmp(line, STATE_CMD, strlen(STATE_CMD)) == 0) ) {
+		line	+= strlen(STATE_CMD);
+		*length -= strlen(STATE_CMD);
+	}
+
+	return line;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function implements the thread that computes the host
+ * projection of a range of the security state points.  Each point is
+ * replaced with its projection.
+ *
+ * \param arg	A pointer to the description of the points to be
+ *		projected.
+ *
+ * \return	A NULL value is returned.
+ */
+
+static void * project_thread(void *arg)
+
+{
+	size_t lp;
+
+	Buffer b;
+
+	struct project_thread *tp = arg;
+
+
+	for (lp= tp->start; lp < tp->end; ++lp) {
+		tp->bufr->reset(tp->bufr);
+		tp->bufr->add(tp->bufr, tp->host, NAAAIM_IDSIZE);
+		if ( !tp->bufr->add(tp->bufr, tp->points + lp * NAAAIM_IDSIZE, \
+				    NAAAIM_IDSIZE) )
+			ERR(goto done);
+
+		tp->sha256->reset(tp->sha256);
+		tp->sha256->add(tp->sha256, tp->bufr);
+		if ( !tp->sha256->compute(tp->sha256) )
+			ERR(goto done);
+
+		b = tp->sha256->get_Buffer(tp->sha256);
+		memcpy(tp->points + lp * NAAAIM_IDSIZE, b->get(b), \
+		       NAAAIM_IDSIZE);
+	}
+
+	return NULL;
+
+
+ done:
+	tp->error = true;
+	return NULL;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function implements the threaded computation of the
+ * measurement of the contours file.
+ *
+ * \param contours	A pointer to the null-terminated name of the
+ *			contours file.
+ *
+ * \param host		The object containing the host identity.
+ *
+ * \param threads	The number of threads to be used.
+ *
+ * \param measurement	A pointer to the measurement that is to be
+ *			extended.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the measurement was computed.
+ */
+
+static _Bool measure_threaded(CO(char *, contours), CO(Buffer, host), \
+			      const unsigned int threads,	       \
+			      uint8_t *measurement)
+
+{
+	_Bool retn = false;
+
+	char *map = MAP_FAILED;
+
+	const char *p,
+		   *eol,
+		   *point;
+
+	int fd = -1;
+
+	unsigned int lp;
+
+	size_t cnt,
+	       length,
+	       total = 0;
+
+	uint8_t *points = NULL;
+
+	struct stat statbuf;
+
+	struct project_thread thread[MAX_THREADS];
+
+	Buffer b,
+	       bufr = NULL;
+
+	Sha256 sha256 = NULL;
+
+
+	memset(thread, '\0', sizeof(thread));
+
+
+	/* Decode the points in the contours file. */
+	if ( (fd = open(contours, O_RDONLY)) == -1 )
+		ERR(goto done);
+	if ( fstat(fd, &statbuf) == -1 )
+		ERR(goto done);
+	if ( statbuf.st_size == 0 ) {
+		retn = true;
+		goto done;
+	}
+
+	map = mmap(NULL, statbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if ( map == MAP_FAILED )
+		ERR(goto done);
+
+	for (p= map; p < map + statbuf.st_size; p= eol + 1) {
+		if ( (eol = memchr(p, '\n', map + statbuf.st_size - p)) == \
+		     NULL )
+			eol = map + statbuf.st_size;
+		++total;
+	}
+	if ( (points = malloc(total * NAAAIM_IDSIZE)) == NULL )
+		ERR(goto done);
+
+	for (p= map, total= 0; p < map + statbuf.st_size; p= eol + 1) {
+		if ( (eol = memchr(p, '\n', map + statbuf.st_size - p)) == \
+		     NULL )
+			eol = map + statbuf.st_size;
+
+		length = eol - p;
+		if ( (point = contour_point(p, &length)) == NULL )
+			continue;
+		if ( (length != NAAAIM_IDSIZE * 2) ||			   \
+		     !Hex_decode(point, length,				   \
+				 points + total * NAAAIM_IDSIZE) ) {
+			fprintf(stderr, "Invalid contour point: %.*s\n", \
+				(int) (eol - p), p);
+			goto done;
+		}
+		++total;
+	}
+
+
+	/* Project the points onto the host. */
+	for (lp= 0; lp < threads; ++lp) {
+		thread[lp].start  = (total / threads) * lp;
+		thread[lp].end	  = lp == (threads - 1) ? total : \
+			(total / threads) * (lp + 1);
+		thread[lp].points = points;
+		thread[lp].host	  = host->get(host);
+
+		INIT(NAAAIM, Sha256, thread[lp].sha256, ERR(goto done));
+		INIT(HurdLib, Buffer, thread[lp].bufr, ERR(goto done));
+	}
+
+	for (lp= 0; lp < threads; ++lp) {
+		if ( pthread_create(&thread[lp].thread, NULL, project_thread, \
+				    &thread[lp]) != 0 )
+			ERR(goto done);
+		thread[lp].started = true;
+	}
+
+	for (lp= 0; lp < threads; ++lp) {
+		pthread_join(thread[lp].thread, NULL);
+		thread[lp].started = false;
+		if ( thread[lp].error )
+			ERR(goto done);
+	}
+
+
+	/* Extend the measurement in the order of the contours. */
+	INIT(HurdLib, Buffer, bufr, ERR(goto done));
+	INIT(NAAAIM, Sha256, sha256, ERR(goto done));
+
+	for (cnt= 0; cnt < total; ++cnt) {
+		bufr->reset(bufr);
+		bufr->add(bufr, measurement, NAAAIM_IDSIZE);
+		if ( !bufr->add(bufr, points + cnt * NAAAIM_IDSIZE, \
+				NAAAIM_IDSIZE) )
+			ERR(goto done);
+
+		sha256->reset(sha256);
+		sha256->add(sha256, bufr);
+		if ( !sha256->compute(sha256) )
+			ERR(goto done);
+
+		b = sha256->get_Buffer(sha256);
+		memcpy(measurement, b->get(b), NAAAIM_IDSIZE);
+	}
+	retn = true;
+
+
+ done:
+	for (lp= 0; lp < threads; ++lp) {
+		if ( thread[lp].started )
+			pthread_join(thread[lp].thread, NULL);
+		WHACK(thread[lp].sha256);
+		WHACK(thread[lp].bufr);
+	}
+
+	if ( map != MAP_FAILED )
+		munmap(map, statbuf.st_size);
+	if ( fd != -1 )
+		close(fd);
+	free(points);
+
+	WHACK(bufr);
+	WHACK(sha256);
+
+	return retn;
+}
+
+
 
 /*
  * Program entry point begins here.
@@ -55,11 +364,17 @@ extern int main(int argc, char *argv[])
 	     *hostid	= NULL,
 	     *aggregate	= NULL;
 
+	const char *point;
+
+	size_t length;
+
 	unsigned char measurement[NAAAIM_IDSIZE];
 
 	int opt,
 	    retn = 1;
 
+	unsigned int threads = 0;
+
 	Buffer b,
 	       bufr = NULL,
 	       host = NULL;
@@ -72,7 +387,7 @@ extern int main(int argc, char *argv[])
 
 
 	/* Parse and verify arguements. */
-	while ( (opt = getopt(argc, argv, "va:c:h:")) != EOF )
+	while ( (opt = getopt(argc, argv, "va:c:h:t:")) != EOF )
 		switch ( opt ) {
 			case 'v':
 				verbose = true;
@@ -86,6 +401,9 @@ extern int main(int argc, char *argv[])
 			case 'h':
 				hostid = optarg;
 				break;
+			case 't':
+				threads = strtoul(optarg, NULL, 0);
+				break;
 		}
 
 	if ( contours == NULL ) {
@@ -171,6 +489,19 @@ extern int main(int argc, char *argv[])
 	sha256->reset(sha256);
 
 
+	/* Project and extend the contour points with multiple threads. */
+	if ( threads > 0 ) {
+		if ( threads > MAX_THREADS ) {
+			fprintf(stderr, "Maximum number of threads is %d.\n", \
+				MAX_THREADS);
+			goto done;
+		}
+		if ( !measure_threaded(contours, host, threads, measurement) )
+			ERR(goto done);
+		goto output;
+	}
+
+
 	/* Read and process the contours file. */
 	INIT(HurdLib, File, trajectory, ERR(goto done));
 	if ( !trajectory->open_ro(trajectory, contours) )
@@ -179,8 +510,15 @@ extern int main(int argc, char *argv[])
 	INIT(HurdLib, String, entry, ERR(goto done));
 
 	while ( trajectory->read_String(trajectory, entry) ) {
+		length = entry->size(entry);
+		if ( (point = contour_point(entry->get(entry), &length)) == \
+		     NULL ) {
+			entry->reset(entry);
+			continue;
+		}
+
 		/* Host extend the contour point. */
-		if ( !bufr->add_hexstring(bufr, entry->get(entry)) )
+		if ( !bufr->add_hexstring(bufr, point) )
 		     ERR(goto done);
 		if ( verbose ) {
 			fputs("c: ", stdout);
@@ -189,7 +527,7 @@ extern int main(int argc, char *argv[])
 
 		bufr->reset(bufr);
 		bufr->add_Buffer(bufr, host);
-		if ( !bufr->add_hexstring(bufr, entry->get(entry)) )
+		if ( !bufr->add_hexstring(bufr, point) )
 		     ERR(goto done);
 
 		sha256->add(sha256, bufr);
@@ -230,7 +568,9 @@ extern int main(int argc, char *argv[])
 			fputc('\n', stdout);
 	}
 
-	if ( !verbose ) {
+
+ output:
+	if ( !verbose || (threads > 0) ) {
 		bufr->reset(bufr);
 		bufr->add(bufr, measurement, sizeof(measurement));
 		bufr->print(bufr);
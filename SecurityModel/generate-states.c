@@ -2,6 +2,20 @@
  * This file implements the generation of the security states represented
  * by an execution trajectory of security interaction events.  The generated
  * states represent the final state of a security domain.
+ *
+ * By default each event in the trajectory is measured in order and the
+ * identity of every event is output.  The -t option requests that the
+ * trajectory be divided, at line boundaries, among the specified number
+ * of threads which measure the events concurrently.  In this mode each
+ * security state point is only output once, in the order in which it
+ * was first generated by the trajectory.  This is the order in which
+ * the points extend the measurement of the security domain, so the
+ * output is identical regardless of the number of threads used.
+ *
+ * In threaded mode the -c option outputs a comment line with the number
+ * of events that generated a point before each point and the -s option
+ * outputs the points sorted by their value rather then in extension
+ * order.
  */
 
 /**************************************************************************
@@ -12,6 +26,18 @@
  **************************************************************************/
 
 
+/* Local defines. */
+
+/* The maximum number of threads that can measure a trajectory. */
+#define MAX_THREADS 64
+
+/* The number of independently locked segments of the point set. */
+#define SET_SHARDS 256
+
+/* The initial number of slots in each segment of the point set. */
+#define SHARD_SIZE 1024
+
+
 /* Include files. */
 #include <stdio.h>
 #include <string.h>
@@ -24,6 +50,9 @@
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <pthread.h>
 
 #include <HurdLib.h>
 #include <Buffer.h>
@@ -33,9 +62,460 @@
 #include <NAAAIM.h>
 #include <SHA256.h>
 
+#include <Hex.h>
+
 #include "SecurityEvent.h"
 
 
+/** A security state point generated by the trajectory. */
+struct state_point {
+	_Bool used;
+	uint8_t point[NAAAIM_IDSIZE];
+	uint64_t first;
+	uint64_t count;
+};
+
+/** A segment of the set of security state points. */
+struct point_shard {
+	pthread_mutex_t lock;
+	struct state_point *table;
+	size_t size;
+	size_t used;
+};
+
+/** The portion of the trajectory measured by a thread. */
+struct measure_thread {
+	pthread_t thread;
+	_Bool started;
+	_Bool error;
+
+	const char *start;
+	const char *end;
+	const char *base;
+
+	SecurityEvent event;
+	String entry;
+	Buffer bufr;
+};
+
+
+/**
+ * The set of unique security state points.
+ */
+static struct point_shard Set[SET_SHARDS];
+
+
+/**
+ * Private function.
+ *
+ * This function places a point into a segment of the point set
+ * without checking for a duplicate or the capacity of the segment.
+ *
+ * \param shard	A pointer to the segment that the point is to be
+ *			placed in.
+ *
+ * \param sp		A pointer to the point to be placed.
+ */
+
+static void _place_point(struct point_shard *shard, \
+			 CO(struct state_point *, sp))
+
+{
+	size_t slot;
+
+	uint64_t hash;
+
+
+	memcpy(&hash, sp->point, sizeof(hash));
+	slot = (hash >> 8) & (shard->size - 1);
+
+	while ( shard->table[slot].used )
+		slot = (slot + 1) & (shard->size - 1);
+	shard->table[slot] = *sp;
+
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function doubles the number of slots in a segment of the
+ * point set.
+ *
+ * \param shard	A pointer to the segment to be expanded.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the segment was expanded.
+ */
+
+static _Bool _grow_shard(struct point_shard *shard)
+
+{
+	size_t lp,
+	       size = shard->size;
+
+	struct state_point *old = shard->table;
+
+
+	if ( (shard->table = calloc(size * 2, sizeof(*old))) == NULL ) {
+		shard->table = old;
+		return false;
+	}
+	shard->size = size * 2;
+
+	for (lp= 0; lp < size; ++lp) {
+		if ( old[lp].used )
+			_place_point(shard, &old[lp]);
+	}
+	free(old);
+
+	return true;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function adds a security state point to the point set.  The
+ * set is divided into segments, selected by the value of the point,
+ * that are locked independently so that the threads measuring the
+ * trajectory rarely contend for a segment.
+ *
+ * \param point		A pointer to the security state point.
+ *
+ * \param offset	The offset in the trajectory of the event which
+ *			generated the point.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the point was added.
+ */
+
+static _Bool add_point(CO(uint8_t *, point), const uint64_t offset)
+
+{
+	_Bool retn = false;
+
+	size_t slot;
+
+	uint64_t hash;
+
+	struct point_shard *shard;
+
+	struct state_point *sp,
+			   new;
+
+
+	memcpy(&hash, point, sizeof(hash));
+	shard = &Set[hash % SET_SHARDS];
+
+	pthread_mutex_lock(&shard->lock);
+
+	slot = (hash >> 8) & (shard->size - 1);
+	while ( true ) {
+		sp = &shard->table[slot];
+		if ( !sp->used )
+			break;
+		if ( memcmp(sp->point, point, sizeof(sp->point)) == 0 ) {
+			++sp->count;
+			if ( offset < sp->first )
+				sp->first = offset;
+			retn = true;
+			goto done;
+		}
+		slot = (slot + 1) & (shard->size - 1);
+	}
+
+	if ( (shard->used + 1) * 2 > shard->size ) {
+		if ( !_grow_shard(shard) )
+			goto done;
+	}
+
+	new.used  = true;
+	new.first = offset;
+	new.count = 1;
+	memcpy(new.point, point, sizeof(new.point));
+	_place_point(shard, &new);
+
+	++shard->used;
+	retn = true;
+
+
+ done:
+	pthread_mutex_unlock(&shard->lock);
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function implements the thread that measures a portion of the
+ * trajectory.
+ *
+ * \param arg	A pointer to the description of the portion of the
+ *		trajectory to be measured.
+ *
+ * \return	A NULL value is returned.
+ */
+
+static void * measure_thread(void *arg)
+
+{
+	const char *p,
+		   *eol;
+
+	struct measure_thread *tp = arg;
+
+
+	for (p= tp->start; p < tp->end; p= eol + 1) {
+		if ( (eol = memchr(p, '\n', tp->end - p)) == NULL )
+			eol = tp->end;
+		if ( eol == p )
+			continue;
+
+		tp->entry->reset(tp->entry);
+		if ( !tp->entry->add_sprintf(tp->entry, "%.*s", \
+					     (int) (eol - p), p) )
+			ERR(goto done);
+
+		tp->event->parse(tp->event, tp->entry);
+		if ( !tp->event->measure(tp->event) )
+			ERR(goto done);
+
+		tp->bufr->reset(tp->bufr);
+		if ( !tp->event->get_identity(tp->event, tp->bufr) )
+			ERR(goto done);
+		if ( !add_point(tp->bufr->get(tp->bufr), p - tp->base) )
+			ERR(goto done);
+
+		tp->event->reset(tp->event);
+	}
+
+	return NULL;
+
+
+ done:
+	tp->error = true;
+	return NULL;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function is the comparison function used to sort the security
+ * state points into the order in which they were generated.
+ *
+ * \param a	A pointer to the first point to be compared.
+ *
+ * \param b	A pointer to the second point to be compared.
+ *
+ * \return	An integer indicating the relative order of the points.
+ */
+
+static int compare_first(const void *a, const void *b)
+
+{
+	const struct state_point *pa = a,
+				 *pb = b;
+
+
+	return (pa->first > pb->first) - (pa->first < pb->first);
+}
+
+
+/**
+ * Private function.
+ *
+ * This function is the comparison function used to sort the security
+ * state points by their value.
+ *
+ * \param a	A pointer to the first point to be compared.
+ *
+ * \param b	A pointer to the second point to be compared.
+ *
+ * \return	An integer indicating the relative order of the points.
+ */
+
+static int compare_point(const void *a, const void *b)
+
+{
+	const struct state_point *pa = a,
+				 *pb = b;
+
+
+	return memcmp(pa->point, pb->point, sizeof(pa->point));
+}
+
+
+/**
+ * Private function.
+ *
+ * This function implements the threaded generation of the security
+ * state points.
+ *
+ * \param input		A pointer to the null-terminated name of the
+ *			trajectory file.
+ *
+ * \param threads	The number of threads to be used.
+ *
+ * \param prefix	A flag indicating whether or not each point is
+ *			to be output as a model state command.
+ *
+ * \param counts	A flag indicating whether or not the number of
+ *			events generating each point is to be output.
+ *
+ * \param sort		A flag indicating whether or not the points are
+ *			to be output in the order of their values.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the points were generated.
+ */
+
+static _Bool generate_threaded(CO(char *, input), const unsigned int threads, \
+			       const _Bool prefix, const _Bool counts,	      \
+			       const _Bool sort)
+
+{
+	_Bool retn = false;
+
+	char *map = MAP_FAILED,
+	     hex[NAAAIM_IDSIZE * 2 + 1];
+
+	const char *p;
+
+	int fd = -1;
+
+	unsigned int lp;
+
+	size_t cnt,
+	       total = 0;
+
+	struct stat statbuf;
+
+	struct state_point *points = NULL;
+
+	struct measure_thread thread[MAX_THREADS];
+
+
+	memset(thread, '\0', sizeof(thread));
+	for (lp= 0; lp < SET_SHARDS; ++lp) {
+		pthread_mutex_init(&Set[lp].lock, NULL);
+		Set[lp].size = SHARD_SIZE;
+		Set[lp].table = calloc(SHARD_SIZE, sizeof(struct state_point));
+		if ( Set[lp].table == NULL )
+			ERR(goto done);
+	}
+
+
+	/* Map the trajectory. */
+	if ( (fd = open(input, O_RDONLY)) == -1 )
+		ERR(goto done);
+	if ( fstat(fd, &statbuf) == -1 )
+		ERR(goto done);
+
+	if ( statbuf.st_size > 0 ) {
+		map = mmap(NULL, statbuf.st_size, PROT_READ, MAP_PRIVATE, \
+			   fd, 0);
+		if ( map == MAP_FAILED )
+			ERR(goto done);
+		madvise(map, statbuf.st_size, MADV_SEQUENTIAL);
+	}
+
+
+	/* Divide the trajectory at line boundaries and measure it. */
+	p = map;
+	for (lp= 0; (lp < threads) && (statbuf.st_size > 0); ++lp) {
+		thread[lp].base	 = map;
+		thread[lp].start = p;
+		if ( lp == (threads - 1) )
+			p = map + statbuf.st_size;
+		else {
+			p = map + (statbuf.st_size / threads) * (lp + 1);
+			if ( p < thread[lp].start )
+				p = thread[lp].start;
+			while ( (p < map + statbuf.st_size) && (*p != '\n') )
+				++p;
+			if ( p < map + statbuf.st_size )
+				++p;
+		}
+		thread[lp].end = p;
+
+		INIT(NAAAIM, SecurityEvent, thread[lp].event, ERR(goto done));
+		INIT(HurdLib, String, thread[lp].entry, ERR(goto done));
+		INIT(HurdLib, Buffer, thread[lp].bufr, ERR(goto done));
+	}
+
+	for (lp= 0; (lp < threads) && (statbuf.st_size > 0); ++lp) {
+		if ( pthread_create(&thread[lp].thread, NULL, measure_thread, \
+				    &thread[lp]) != 0 )
+			ERR(goto done);
+		thread[lp].started = true;
+	}
+
+	for (lp= 0; lp < threads; ++lp) {
+		if ( !thread[lp].started )
+			continue;
+		pthread_join(thread[lp].thread, NULL);
+		thread[lp].started = false;
+		if ( thread[lp].error ) {
+			fputs("Error measuring trajectory.\n", stderr);
+			goto done;
+		}
+	}
+
+
+	/* Output the points. */
+	for (lp= 0; lp < SET_SHARDS; ++lp)
+		total += Set[lp].used;
+	if ( (points = calloc(total + 1, sizeof(*points))) == NULL )
+		ERR(goto done);
+
+	for (lp= 0, total= 0; lp < SET_SHARDS; ++lp) {
+		for (cnt= 0; cnt < Set[lp].size; ++cnt) {
+			if ( Set[lp].table[cnt].used )
+				points[total++] = Set[lp].table[cnt];
+		}
+	}
+	qsort(points, total, sizeof(*points), \
+	      sort ? compare_point : compare_first);
+
+	hex[sizeof(hex) - 1] = '\0';
+	for (cnt= 0; cnt < total; ++cnt) {
+		Hex_encode(points[cnt].point, sizeof(points[cnt].point), hex);
+		if ( counts )
+			fprintf(stdout, "# count %lu\n", \
+				(unsigned long int) points[cnt].count);
+		fprintf(stdout, "%s%s\n", prefix ? "state " : "", hex);
+	}
+	retn = true;
+
+
+ done:
+	for (lp= 0; lp < threads; ++lp) {
+		if ( thread[lp].started )
+			pthread_join(thread[lp].thread, NULL);
+		WHACK(thread[lp].event);
+		WHACK(thread[lp].entry);
+		WHACK(thread[lp].bufr);
+	}
+
+	for (lp= 0; lp < SET_SHARDS; ++lp) {
+		free(Set[lp].table);
+		pthread_mutex_destroy(&Set[lp].lock);
+	}
+	free(points);
+
+	if ( map != MAP_FAILED )
+		munmap(map, statbuf.st_size);
+	if ( fd != -1 )
+		close(fd);
+
+	return retn;
+}
+
+
 /*
  * Program entry point begins here.
  */
@@ -43,7 +523,9 @@
 extern int main(int argc, char *argv[])
 
 {
-	_Bool prefix  = false,
+	_Bool sort    = false,
+	      counts  = false,
+	      prefix  = false,
 	      verbose = false;
 
 	char *input_file = NULL;
@@ -51,6 +533,8 @@ extern int main(int argc, char *argv[])
 	int opt,
 	    retn = 1;
 
+	unsigned int threads = 0;
+
 	Buffer bufr = NULL;
 
 	File trajectory = NULL;
@@ -61,11 +545,17 @@ extern int main(int argc, char *argv[])
 
 
 	/* Parse and verify arguements. */
-	while ( (opt = getopt(argc, argv, "pvi:")) != EOF )
+	while ( (opt = getopt(argc, argv, "cpsvi:t:")) != EOF )
 		switch ( opt ) {
+			case 'c':
+				counts = true;
+				break;
 			case 'p':
 				prefix = true;
 				break;
+			case 's':
+				sort = true;
+				break;
 			case 'v':
 				verbose = true;
 				break;
@@ -73,6 +563,9 @@ extern int main(int argc, char *argv[])
 			case 'i':
 				input_file = optarg;
 				break;
+			case 't':
+				threads = strtoul(optarg, NULL, 0);
+				break;
 		}
 
 	if ( input_file == NULL ) {
@@ -81,6 +574,20 @@ extern int main(int argc, char *argv[])
 	}
 
 
+	/* Generate the unique points with multiple threads. */
+	if ( threads > 0 ) {
+		if ( threads > MAX_THREADS ) {
+			fprintf(stderr, "Maximum number of threads is %d.\n", \
+				MAX_THREADS);
+			goto done;
+		}
+		if ( generate_threaded(input_file, threads, prefix, counts, \
+				       sort) )
+			retn = 0;
+		goto done;
+	}
+
+
 	/* Read and process file. */
 	INIT(HurdLib, Buffer, bufr, ERR(goto done));
 
@@ -0,0 +1,724 @@
+/** \file
+ * This file implements a utility that merges a collection of security
+ * model maps into a single signed model.  The state points of each
+ * input model are expected to be in sorted order, which allows the
+ * models to be combined with a streaming k-way merge whose memory
+ * footprint is independent of the size of the models.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+
+/* Include files. */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <HurdLib.h>
+#include <Buffer.h>
+#include <String.h>
+#include <File.h>
+
+#include <NAAAIM.h>
+#include <RSAkey.h>
+#include <Base64.h>
+#include <SHA256.h>
+#include <Hex.h>
+
+
+/**
+ * The structure used to track the position of the merge in each of
+ * the input models.
+ */
+struct model_input {
+	const char *name;
+	unsigned long int line;
+
+	File file;
+	String str;
+
+	_Bool have_point;
+	unsigned long int count;
+	unsigned long int pending;
+	uint8_t point[NAAAIM_IDSIZE];
+};
+
+
+/**
+ * The output stream and the digest of the merged model which the
+ * signature is generated over.
+ */
+static FILE *Output = NULL;
+
+static Sha256 Digest = NULL;
+
+static Buffer Line = NULL;
+
+
+/**
+ * The model components which are not state points.  The aggregate
+ * and base values need to be consistent across all of the models
+ * being merged.
+ */
+static _Bool Started = false;
+
+static _Bool Sealed = false;
+
+static _Bool Have_aggregate = false;
+
+static uint8_t Aggregate[NAAAIM_IDSIZE];
+
+static _Bool Have_base = false;
+
+static uint8_t Base[NAAAIM_IDSIZE];
+
+static Buffer Pseudonyms = NULL;
+
+
+/**
+ * Private function.
+ *
+ * This function emits a line of the merged model and adds it to the
+ * digest of the model.  Each line is hashed with its terminating
+ * null byte, which is the form that the TSEM model loader verifies
+ * the signature over.
+ *
+ * \param line	A pointer to the null-terminated buffer containing
+ *		the line to be emitted.
+ *
+ * \return	A boolean value is returned to indicate whether or
+ *		not the line was emitted.
+ */
+
+static _Bool emit(CO(char *, line))
+
+{
+	_Bool retn = false;
+
+
+	if ( fprintf(Output, "%s\n", line) < 0 )
+		ERR(goto done);
+
+	if ( Digest != NULL ) {
+		Line->reset(Line);
+		if ( !Line->add(Line, (void *) line, strlen(line) + 1) )
+			ERR(goto done);
+		if ( !Digest->add(Digest, Line) )
+			ERR(goto done);
+	}
+
+	retn = true;
+
+
+ done:
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function emits a model command which carries a binary value
+ * as its argument.
+ *
+ * \param cmd	A pointer to the null-terminated buffer containing
+ *		the command, including its separating space.
+ *
+ * \param value	A pointer to the value which is to be hexadecimally
+ *		encoded as the argument to the command.
+ *
+ * \return	A boolean value is returned to indicate whether or
+ *		not the command was emitted.
+ */
+
+static _Bool emit_value(CO(char *, cmd), CO(uint8_t *, value))
+
+{
+	char line[32 + NAAAIM_IDSIZE * 2 + 1];
+
+
+	strcpy(line, cmd);
+	Hex_encode(value, NAAAIM_IDSIZE, line + strlen(cmd));
+	line[strlen(cmd) + NAAAIM_IDSIZE * 2] = '\0';
+
+	return emit(line);
+}
+
+
+/**
+ * Private function.
+ *
+ * This function decodes the hexadecimal argument of a model command.
+ *
+ * \param arg	A pointer to the null-terminated buffer containing
+ *		the argument.
+ *
+ * \param value	A pointer to the buffer which the value will be
+ *		decoded into.
+ *
+ * \return	A boolean value is returned to indicate whether or
+ *		not the argument was a valid value.
+ */
+
+static _Bool decode_value(CO(char *, arg), uint8_t *value)
+
+{
+	if ( strlen(arg) != NAAAIM_IDSIZE * 2 )
+		return false;
+	return Hex_decode(arg, NAAAIM_IDSIZE * 2, value);
+}
+
+
+/**
+ * Private function.
+ *
+ * This function records a model value, such as the aggregate, which
+ * must be consistent across all of the input models.
+ *
+ * \param input	A pointer to the input the value was read from.
+ *
+ * \param label	A pointer to the null-terminated buffer containing
+ *		the name of the value for error reporting.
+ *
+ * \param arg	A pointer to the null-terminated buffer containing
+ *		the hexadecimal value.
+ *
+ * \param have	A pointer to the flag indicating whether or not the
+ *		value has been recorded.
+ *
+ * \param value	A pointer to the buffer holding the recorded value.
+ *
+ * \return	A boolean value is returned to indicate whether or
+ *		not the value was consistent with the merged model.
+ */
+
+static _Bool record_value(CO(struct model_input *, input), \
+			  CO(char *, label), CO(char *, arg), _Bool *have, \
+			  uint8_t *value)
+
+{
+	uint8_t bufr[NAAAIM_IDSIZE];
+
+
+	if ( !decode_value(arg, bufr) ) {
+		fprintf(stderr, "%s[%lu]: Invalid %s value.\n", input->name, \
+			input->line, label);
+		return false;
+	}
+
+	if ( *have ) {
+		if ( memcmp(value, bufr, sizeof(bufr)) == 0 )
+			return true;
+		fprintf(stderr, "%s[%lu]: Inconsistent %s value.\n", \
+			input->name, input->line, label);
+		return false;
+	}
+
+	if ( Started ) {
+		fprintf(stderr, "%s[%lu]: The %s value follows the state " \
+			"points.\n", input->name, input->line, label);
+		return false;
+	}
+
+	memcpy(value, bufr, sizeof(bufr));
+	*have = true;
+	return true;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function adds a pseudonym to the merged model if it has not
+ * already been seen.  The pseudonym list of a model is small so it
+ * is retained and searched linearly.
+ *
+ * \param input	A pointer to the input the pseudonym was read from.
+ *
+ * \param arg	A pointer to the null-terminated buffer containing
+ *		the hexadecimal pseudonym.
+ *
+ * \return	A boolean value is returned to indicate whether or
+ *		not the pseudonym was valid.
+ */
+
+static _Bool add_pseudonym(CO(struct model_input *, input), CO(char *, arg))
+
+{
+	uint8_t *p,
+		pseudonym[NAAAIM_IDSIZE];
+
+	size_t lp,
+	       cnt = Pseudonyms->size(Pseudonyms) / NAAAIM_IDSIZE;
+
+
+	if ( !decode_value(arg, pseudonym) ) {
+		fprintf(stderr, "%s[%lu]: Invalid pseudonym.\n", input->name, \
+			input->line);
+		return false;
+	}
+
+	p = Pseudonyms->get(Pseudonyms);
+	for (lp= 0; lp < cnt; ++lp) {
+		if ( memcmp(p + (lp * NAAAIM_IDSIZE), pseudonym, \
+			    NAAAIM_IDSIZE) == 0 )
+			return true;
+	}
+
+	return Pseudonyms->add(Pseudonyms, pseudonym, sizeof(pseudonym));
+}
+
+
+/**
+ * Private function.
+ *
+ * This function advances an input model to its next state point.
+ * The non-point components of the model that are encountered along
+ * the way are folded into the merged model.  A point may be preceded
+ * by a count comment of the form emitted by generate-states which
+ * specifies the number of times the point was observed.
+ *
+ * \param input	A pointer to the input which is to be advanced.
+ *
+ * \return	A boolean value is returned to indicate whether or
+ *		not the input was advanced.  A false value indicates
+ *		the model was invalid.  A true value indicates the
+ *		input was advanced, the have_point member of the
+ *		structure indicates whether a point is available or
+ *		the end of the model was reached.
+ */
+
+static _Bool advance(struct model_input *input)
+
+{
+	_Bool retn = false;
+
+	char *p,
+	     *line;
+
+	uint8_t point[NAAAIM_IDSIZE];
+
+
+	while ( true ) {
+		input->str->reset(input->str);
+		if ( !input->file->read_String(input->file, input->str) ) {
+			input->have_point = false;
+			retn = true;
+			goto done;
+		}
+		++input->line;
+		line = input->str->get(input->str);
+
+		if ( strncmp(line, "# count ", 8) == 0 ) {
+			input->pending = strtoul(line + 8, &p, 10);
+			if ( (*p != '\0') || (input->pending == 0) ) {
+				fprintf(stderr, "%s[%lu]: Invalid count.\n", \
+					input->name, input->line);
+				goto done;
+			}
+			continue;
+		}
+
+		if ( (*line == '#') || (*line == '\0') )
+			continue;
+		if ( strncmp(line, "key ", 4) == 0 )
+			continue;
+		if ( strncmp(line, "signature ", 10) == 0 )
+			continue;
+		if ( strcmp(line, "end") == 0 )
+			continue;
+
+		if ( strcmp(line, "seal") == 0 ) {
+			Sealed = true;
+			continue;
+		}
+		if ( strncmp(line, "aggregate ", 10) == 0 ) {
+			if ( !record_value(input, "aggregate", line + 10, \
+					   &Have_aggregate, Aggregate) )
+				goto done;
+			continue;
+		}
+		if ( strncmp(line, "base ", 5) == 0 ) {
+			if ( !record_value(input, "base", line + 5, \
+					   &Have_base, Base) )
+				goto done;
+			continue;
+		}
+		if ( strncmp(line, "pseudonym ", 10) == 0 ) {
+			if ( !add_pseudonym(input, line + 10) )
+				goto done;
+			continue;
+		}
+
+		if ( strncmp(line, "state ", 6) == 0 )
+			line += 6;
+		if ( !decode_value(line, point) ) {
+			fprintf(stderr, "%s[%lu]: Invalid model entry.\n", \
+				input->name, input->line);
+			goto done;
+		}
+		break;
+	}
+
+
+	/*
+	 * Verify the point ordering and set the current point.  A
+	 * repeated point is returned as a new point so that its count
+	 * is accumulated with the previous instance.
+	 */
+	if ( input->have_point && \
+	     (memcmp(input->point, point, sizeof(point)) > 0) ) {
+		fprintf(stderr, "%s[%lu]: State points are not sorted.\n", \
+			input->name, input->line);
+		goto done;
+	}
+
+	memcpy(input->point, point, sizeof(point));
+	input->count	  = input->pending ? input->pending : 1;
+	input->pending	  = 0;
+	input->have_point = true;
+	retn = true;
+
+
+ done:
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function restores the heap property of the priority queue of
+ * inputs, ordered by their current state point, from the specified
+ * position downward.
+ *
+ * \param heap	A pointer to the array of inputs organized as a
+ *		binary heap.
+ *
+ * \param size	The number of inputs in the heap.
+ *
+ * \param pos	The position in the heap to restore the property
+ *		from.
+ */
+
+static void sift_down(struct model_input **heap, const size_t size, \
+		      size_t pos)
+
+{
+	size_t child;
+
+	struct model_input *input;
+
+
+	while ( (child = (2 * pos) + 1) < size ) {
+		if ( ((child + 1) < size) && \
+		     (memcmp(heap[child + 1]->point, heap[child]->point, \
+			     NAAAIM_IDSIZE) < 0) )
+			++child;
+		if ( memcmp(heap[pos]->point, heap[child]->point, \
+			    NAAAIM_IDSIZE) <= 0 )
+			break;
+
+		input	    = heap[pos];
+		heap[pos]   = heap[child];
+		heap[child] = input;
+		pos	    = child;
+	}
+
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function carries out the merge of the input models.  The
+ * inputs are kept in a binary heap ordered by their current state
+ * point so that each point of the merged model is produced in
+ * logarithmic time with respect to the number of models.
+ *
+ * \param inputs	A pointer to the array of input models.
+ *
+ * \param cnt		The number of input models.
+ *
+ * \param minimum	The minimum number of observations a state
+ *			point must have to be included in the merged
+ *			model.
+ *
+ * \param counts	A flag indicating whether or not the merged
+ *			observation counts are to be emitted.
+ *
+ * \return	A boolean value is returned to indicate whether or
+ *		not the merge succeeded.
+ */
+
+static _Bool merge(struct model_input *inputs, const size_t cnt, \
+		   const unsigned long int minimum, const _Bool counts)
+
+{
+	_Bool retn = false;
+
+	char line[32];
+
+	uint8_t point[NAAAIM_IDSIZE];
+
+	size_t lp,
+	       size = 0;
+
+	unsigned long int total;
+
+	struct model_input **heap = NULL;
+
+
+	/* Position each input on its first point. */
+	if ( (heap = calloc(cnt, sizeof(*heap))) == NULL )
+		ERR(goto done);
+
+	for (lp= 0; lp < cnt; ++lp) {
+		if ( !advance(&inputs[lp]) )
+			goto done;
+		if ( inputs[lp].have_point )
+			heap[size++] = &inputs[lp];
+	}
+	for (lp= size / 2; lp > 0; --lp)
+		sift_down(heap, size, lp - 1);
+
+
+	/* Emit the model header. */
+	Started = true;
+	if ( Have_base && !emit_value("base ", Base) )
+		ERR(goto done);
+	if ( Have_aggregate && !emit_value("aggregate ", Aggregate) )
+		ERR(goto done);
+
+
+	/* Merge the state points. */
+	while ( size > 0 ) {
+		memcpy(point, heap[0]->point, sizeof(point));
+		total = 0;
+
+		while ( (size > 0) && \
+			(memcmp(heap[0]->point, point, sizeof(point)) == 0) ) {
+			total += heap[0]->count;
+			if ( !advance(heap[0]) )
+				goto done;
+			if ( !heap[0]->have_point )
+				heap[0] = heap[--size];
+			sift_down(heap, size, 0);
+		}
+
+		if ( total < minimum )
+			continue;
+		if ( counts ) {
+			snprintf(line, sizeof(line), "# count %lu", total);
+			if ( !emit(line) )
+				ERR(goto done);
+		}
+		if ( !emit_value("state ", point) )
+			ERR(goto done);
+	}
+
+
+	/* Emit the pseudonyms and the closing tags. */
+	for (lp= 0; lp < Pseudonyms->size(Pseudonyms) / NAAAIM_IDSIZE; ++lp) {
+		if ( !emit_value("pseudonym ", Pseudonyms->get(Pseudonyms) + \
+				 (lp * NAAAIM_IDSIZE)) )
+			ERR(goto done);
+	}
+	if ( Sealed && !emit("seal") )
+		ERR(goto done);
+	if ( !emit("end") )
+		ERR(goto done);
+
+	retn = true;
+
+
+ done:
+	free(heap);
+
+	return retn;
+}
+
+
+/*
+ * Program entry point begins here.
+ */
+
+extern int main(int argc, char *argv[])
+
+{
+	_Bool counts = false;
+
+	char *p,
+	     *key_file	  = NULL,
+	     *output_file = NULL;
+
+	int opt,
+	    lp,
+	    cnt	 = 0,
+	    retn = 1;
+
+	unsigned long int minimum = 1;
+
+	struct model_input *inputs = NULL;
+
+	Buffer bufr	 = NULL,
+	       signature = NULL;
+
+	String str = NULL;
+
+	RSAkey rsakey = NULL;
+
+	Base64 encoder = NULL;
+
+
+	/* Parse and verify arguements. */
+	while ( (opt = getopt(argc, argv, "ck:n:o:")) != EOF )
+		switch ( opt ) {
+			case 'c':
+				counts = true;
+				break;
+
+			case 'k':
+				key_file = optarg;
+				break;
+
+			case 'n':
+				minimum = strtoul(optarg, &p, 10);
+				if ( (*p != '\0') || (minimum == 0) ) {
+					fputs("Invalid minimum count.\n", \
+					      stderr);
+					goto done;
+				}
+				break;
+
+			case 'o':
+				output_file = optarg;
+				break;
+		}
+
+	if ( optind == argc ) {
+		fputs("No models specified.\n", stderr);
+		goto done;
+	}
+
+
+	/* Open the input models. */
+	cnt = argc - optind;
+	if ( (inputs = calloc(cnt, sizeof(*inputs))) == NULL )
+		ERR(goto done);
+
+	for (lp= 0; lp < cnt; ++lp) {
+		inputs[lp].name = argv[optind + lp];
+		INIT(HurdLib, String, inputs[lp].str, ERR(goto done));
+		INIT(HurdLib, File, inputs[lp].file, ERR(goto done));
+		if ( !inputs[lp].file->open_ro(inputs[lp].file, \
+					       inputs[lp].name) ) {
+			fprintf(stderr, "Cannot open model: %s\n", \
+				inputs[lp].name);
+			goto done;
+		}
+	}
+
+	INIT(HurdLib, Buffer, Pseudonyms, ERR(goto done));
+	INIT(HurdLib, Buffer, Line, ERR(goto done));
+
+
+	/* Open the output. */
+	if ( output_file == NULL )
+		Output = stdout;
+	else {
+		if ( (Output = fopen(output_file, "w")) == NULL ) {
+			fprintf(stderr, "Cannot open output: %s\n", \
+				output_file);
+			goto done;
+		}
+	}
+
+
+	/*
+	 * Load the signing key and emit the public key as the first
+	 * line of the model in the same form as sign-model.
+	 */
+	if ( key_file != NULL ) {
+		INIT(NAAAIM, RSAkey, rsakey, ERR(goto done));
+		if ( !rsakey->load_private_key(rsakey, key_file, NULL) )
+			ERR(goto done);
+
+		INIT(HurdLib, Buffer, bufr, ERR(goto done));
+		if ( !rsakey->get_public_key(rsakey, bufr) )
+			ERR(goto done);
+
+		INIT(HurdLib, String, str, ERR(goto done));
+		if ( !str->add(str, "key ") )
+			ERR(goto done);
+		INIT(NAAAIM, Base64, encoder, ERR(goto done));
+		if ( !encoder->encode(encoder, bufr, str) )
+			ERR(goto done);
+
+		INIT(NAAAIM, Sha256, Digest, ERR(goto done));
+		if ( !emit(str->get(str)) )
+			ERR(goto done);
+	}
+
+
+	/* Merge the models. */
+	if ( !merge(inputs, cnt, minimum, counts) )
+		goto done;
+
+
+	/* Sign the digest of the merged model. */
+	if ( rsakey != NULL ) {
+		if ( !Digest->compute(Digest) )
+			ERR(goto done);
+
+		INIT(HurdLib, Buffer, signature, ERR(goto done));
+		if ( !rsakey->sign_digest(rsakey, Digest->get_Buffer(Digest), \
+					  signature) )
+			ERR(goto done);
+
+		str->reset(str);
+		if ( !str->add(str, "signature ") )
+			ERR(goto done);
+		if ( !encoder->encode(encoder, signature, str) )
+			ERR(goto done);
+		if ( fprintf(Output, "%s\n", str->get(str)) < 0 )
+			ERR(goto done);
+	}
+
+	if ( fflush(Output) != 0 )
+		ERR(goto done);
+	retn = 0;
+
+
+ done:
+	for (lp= 0; (inputs != NULL) && (lp < cnt); ++lp) {
+		WHACK(inputs[lp].str);
+		WHACK(inputs[lp].file);
+	}
+	free(inputs);
+
+	if ( (Output != NULL) && (Output != stdout) ) {
+		if ( (fclose(Output) != 0) && (retn == 0) )
+			retn = 1;
+	}
+
+	WHACK(bufr);
+	WHACK(signature);
+	WHACK(str);
+	WHACK(rsakey);
+	WHACK(encoder);
+	WHACK(Digest);
+	WHACK(Line);
+	WHACK(Pseudonyms);
+
+	return retn;
+}
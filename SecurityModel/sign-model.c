@@ -1,5 +1,7 @@
 /** \file
  * This file implements the generation of a signed security model map.
+ * A model map can also be compiled into a signed lookup table which
+ * orchestrators map read-only and share.
  */
 
 /**************************************************************************
@@ -12,9 +14,14 @@
 
 /* Include files. */
 #include <stdio.h>
+#include <stdint.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <limits.h>
+#include <errno.h>
+#include <sys/stat.h>
 
 #include <HurdLib.h>
 #include <Buffer.h>
@@ -25,6 +32,318 @@
 #include <RSAkey.h>
 #include <Base64.h>
 
+#include "SecurityPoint.h"
+#include "SecurityEvent.h"
+#include "TSEM.h"
+#include "tsem_model.h"
+
+
+/**
+ * Private function.
+ *
+ * This function implements the sort comparison function for the
+ * security state points of a compiled model.
+ *
+ * \param p1	A pointer to the first point to be compared.
+ *
+ * \param p2	A pointer to the second point to be compared.
+ *
+ * \return	An integer value is returned to reflect the lexicographic
+ *		order of the two points.
+ */
+
+static int point_sort(const void *p1, const void *p2)
+
+{
+	return memcmp(p1, p2, NAAAIM_IDSIZE);
+}
+
+
+/**
+ * Private function.
+ *
+ * This function atomically replaces a compiled model table.  The
+ * table is written to a temporary file in the directory of the
+ * table and the file is renamed to the name of the table once its
+ * contents have been committed to storage.
+ *
+ * \param table_file	A pointer to the null-terminated buffer that
+ *			contains the name of the table.
+ *
+ * \param bufr		The object containing the table.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the table was written.
+ */
+
+static _Bool write_table(CO(char *, table_file), CO(Buffer, bufr))
+
+{
+	_Bool retn    = false,
+	      created = false;
+
+	char tmpname[PATH_MAX];
+
+	int fd = -1;
+
+	unsigned char *p = bufr->get(bufr);
+
+	size_t size = bufr->size(bufr);
+
+	ssize_t cnt;
+
+	mode_t mode = 0644;
+
+	struct stat statbuf;
+
+
+	if ( snprintf(tmpname, sizeof(tmpname), "%s.XXXXXX", table_file) >= \
+	     sizeof(tmpname) )
+		ERR(goto done);
+	if ( (fd = mkstemp(tmpname)) == -1 )
+		ERR(goto done);
+	created = true;
+
+	if ( stat(table_file, &statbuf) == 0 )
+		mode = statbuf.st_mode & 07777;
+	if ( fchmod(fd, mode) == -1 )
+		ERR(goto done);
+
+	while ( size > 0 ) {
+		if ( (cnt = write(fd, p, size)) == -1 ) {
+			if ( errno == EINTR )
+				continue;
+			ERR(goto done);
+		}
+		p    += cnt;
+		size -= cnt;
+	}
+	if ( fsync(fd) == -1 )
+		ERR(goto done);
+	if ( close(fd) == -1 ) {
+		fd = -1;
+		ERR(goto done);
+	}
+	fd = -1;
+
+	if ( rename(tmpname, table_file) == -1 )
+		ERR(goto done);
+
+	retn = true;
+
+
+ done:
+	if ( fd != -1 )
+		close(fd);
+	if ( !retn && created )
+		unlink(tmpname);
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function compiles a security model map into the signed lookup
+ * table format described in tsem_model.h.  The map is loaded into a
+ * model object in order to compute the measurement of the model that
+ * is carried by the table.
+ *
+ * \param rsakey	The object containing the key that the table is
+ *			to be signed with.
+ *
+ * \param model_file	A pointer to the null-terminated buffer that
+ *			contains the name of the model map.
+ *
+ * \param table_file	A pointer to the null-terminated buffer that
+ *			contains the name of the file that the table is
+ *			to be written to.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the table was generated.
+ */
+
+static _Bool compile(CO(RSAkey, rsakey), CO(char *, model_file), \
+		     CO(char *, table_file))
+
+{
+	_Bool retn = false;
+
+	char *arg;
+
+	uint32_t lp,
+		 cnt,
+		 bucket,
+		 *index = NULL;
+
+	unsigned char *p;
+
+	struct tsem_model hdr;
+
+	Buffer bufr	  = NULL,
+	       points	  = NULL,
+	       pseudonyms = NULL,
+	       key	  = NULL,
+	       signature  = NULL;
+
+	String str = NULL;
+
+	File file = NULL;
+
+	TSEM model = NULL;
+
+
+	/* Load the model map and extract its components. */
+	memset(&hdr, '\0', sizeof(hdr));
+	memcpy(hdr.magic, TSEM_MODEL_MAGIC, sizeof(hdr.magic));
+	hdr.version = TSEM_MODEL_VERSION;
+
+	INIT(HurdLib, Buffer, bufr, ERR(goto done));
+	INIT(HurdLib, Buffer, points, ERR(goto done));
+	INIT(HurdLib, Buffer, pseudonyms, ERR(goto done));
+	INIT(HurdLib, String, str, ERR(goto done));
+	INIT(NAAAIM, TSEM, model, ERR(goto done));
+
+	INIT(HurdLib, File, file, ERR(goto done));
+	if ( !file->open_ro(file, model_file) )
+		ERR(goto done);
+
+	while ( file->read_String(file, str) ) {
+		if ( !model->load(model, str) ) {
+			fprintf(stderr, "Invalid model entry: %s\n", \
+				str->get(str));
+			goto done;
+		}
+
+		arg = strchr(str->get(str), ' ');
+		if ( arg != NULL ) {
+			bufr->reset(bufr);
+			if ( !bufr->add_hexstring(bufr, ++arg) )
+				bufr->reset(bufr);
+		}
+
+		if ( strncmp(str->get(str), "base ", 5) == 0 ) {
+			if ( bufr->size(bufr) != sizeof(hdr.base) )
+				ERR(goto done);
+			memcpy(hdr.base, bufr->get(bufr), sizeof(hdr.base));
+		}
+		if ( strncmp(str->get(str), "aggregate ", 10) == 0 ) {
+			if ( bufr->size(bufr) != sizeof(hdr.aggregate) )
+				ERR(goto done);
+			memcpy(hdr.aggregate, bufr->get(bufr), \
+			       sizeof(hdr.aggregate));
+			hdr.flags |= TSEM_MODEL_AGGREGATE;
+		}
+		if ( strncmp(str->get(str), "state ", 6) == 0 ) {
+			if ( !points->add_Buffer(points, bufr) )
+				ERR(goto done);
+		}
+		if ( strncmp(str->get(str), "pseudonym ", 10) == 0 ) {
+			if ( !pseudonyms->add_Buffer(pseudonyms, bufr) )
+				ERR(goto done);
+		}
+		if ( strcmp(str->get(str), "seal") == 0 )
+			hdr.flags |= TSEM_MODEL_SEALED;
+
+		str->reset(str);
+	}
+
+	bufr->reset(bufr);
+	if ( !model->get_measurement(model, bufr) )
+		ERR(goto done);
+	memcpy(hdr.measurement, bufr->get(bufr), sizeof(hdr.measurement));
+
+
+	/* Sort the points, remove duplicates and index them. */
+	cnt = points->size(points) / NAAAIM_IDSIZE;
+	p   = points->get(points);
+	qsort(p, cnt, NAAAIM_IDSIZE, point_sort);
+
+	for (lp= 1, hdr.points= cnt ? 1 : 0; lp < cnt; ++lp) {
+		if ( memcmp(p + (lp * NAAAIM_IDSIZE), \
+			    p + ((hdr.points - 1) * NAAAIM_IDSIZE), \
+			    NAAAIM_IDSIZE) == 0 )
+			continue;
+		memmove(p + (hdr.points * NAAAIM_IDSIZE), \
+			p + (lp * NAAAIM_IDSIZE), NAAAIM_IDSIZE);
+		++hdr.points;
+	}
+	hdr.pseudonyms = pseudonyms->size(pseudonyms) / NAAAIM_IDSIZE;
+
+	while ( ((1U << hdr.index_bits) < hdr.points) && \
+		(hdr.index_bits < TSEM_MODEL_MAX_BITS) )
+		++hdr.index_bits;
+
+	if ( (index = calloc((1U << hdr.index_bits) + 1, \
+			     sizeof(uint32_t))) == NULL )
+		ERR(goto done);
+	for (lp= 0; lp < hdr.points; ++lp) {
+		bucket = TSEM_MODEL_BUCKET(p + (lp * NAAAIM_IDSIZE), \
+					   hdr.index_bits);
+		++index[bucket + 1];
+	}
+	for (lp= 1; lp <= (1U << hdr.index_bits); ++lp)
+		index[lp] += index[lp - 1];
+
+
+	/* Assemble and sign the table. */
+	INIT(HurdLib, Buffer, key, ERR(goto done));
+	if ( !rsakey->get_public_key(rsakey, key) )
+		ERR(goto done);
+	hdr.key_size = key->size(key);
+
+	INIT(HurdLib, Buffer, signature, ERR(goto done));
+	hdr.signature_size = rsakey->size(rsakey);
+
+	bufr->reset(bufr);
+	if ( !bufr->add(bufr, (unsigned char *) &hdr, sizeof(hdr)) )
+		ERR(goto done);
+	if ( !bufr->add(bufr, (unsigned char *) index, \
+			((1U << hdr.index_bits) + 1) * sizeof(uint32_t)) )
+		ERR(goto done);
+	if ( !bufr->add(bufr, p, hdr.points * NAAAIM_IDSIZE) )
+		ERR(goto done);
+	if ( !bufr->add_Buffer(bufr, pseudonyms) )
+		ERR(goto done);
+	if ( !bufr->add_Buffer(bufr, key) )
+		ERR(goto done);
+
+	if ( !rsakey->sign(rsakey, bufr, signature) )
+		ERR(goto done);
+	if ( signature->size(signature) != hdr.signature_size )
+		ERR(goto done);
+	if ( !bufr->add_Buffer(bufr, signature) )
+		ERR(goto done);
+
+
+	/*
+	 * Write the table to a temporary file in the same directory
+	 * and rename it over the table being replaced.  Orchestrators
+	 * that have the existing table mapped continue to reference
+	 * the file they verified rather than seeing it rewritten.
+	 */
+	if ( !write_table(table_file, bufr) )
+		ERR(goto done);
+
+	retn = true;
+
+
+ done:
+	free(index);
+
+	WHACK(bufr);
+	WHACK(points);
+	WHACK(pseudonyms);
+	WHACK(key);
+	WHACK(signature);
+	WHACK(str);
+	WHACK(file);
+	WHACK(model);
+
+	return retn;
+}
+
 
 /*
  * Program entry point begins here.
@@ -37,7 +356,8 @@ extern int main(int argc, char *argv[])
 	    retn = 1;
 
 	char *key_file   	= NULL,
-	     *model_file	= NULL;
+	     *model_file	= NULL,
+	     *table_file	= NULL;
 
 	enum {
 		sign_mode,
@@ -57,7 +377,7 @@ extern int main(int argc, char *argv[])
 
 
 	/* Parse and verify arguements. */
-	while ( (opt = getopt(argc, argv, "Gk:m:")) != EOF )
+	while ( (opt = getopt(argc, argv, "Gk:m:o:")) != EOF )
 		switch ( opt ) {
 			case 'G':
 				mode = generate_mode;
@@ -71,6 +391,10 @@ extern int main(int argc, char *argv[])
 				model_file = optarg;
 				break;
 
+			case 'o':
+				table_file = optarg;
+				break;
+
 		}
 
 
@@ -109,6 +433,12 @@ extern int main(int argc, char *argv[])
 	/* Load and emit the public signing key. */
 	if ( !rsakey->load_private_key(rsakey, key_file, NULL) )
 		ERR(goto done);
+
+	if ( table_file != NULL ) {
+		if ( compile(rsakey, model_file, table_file) )
+			retn = 0;
+		goto done;
+	}
 	if ( !rsakey->get_public_key(rsakey, bufr) )
 		ERR(goto done);
 
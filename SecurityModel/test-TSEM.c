@@ -19,6 +19,9 @@
 #include <stdbool.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
 #include <HurdLib.h>
 #include <Buffer.h>
@@ -87,6 +90,62 @@ static void model_load(CO(TSEM, model), CO(char *, model_input))
 }
 
 
+/**
+ * Private function.
+ *
+ * This function tests the mapping of a compiled security model into
+ * a model.  The model remains mapped until the process exits.
+ *
+ * \param table_input	The name of the file containing the compiled
+ *			model to be mapped.
+ *
+ * \return		This function exits the process if an
+ *			error is encountered.
+ */
+
+static void model_map(CO(TSEM, model), CO(char *, table_input))
+
+{
+	_Bool retn = false,
+	      sealed;
+
+	int fd = -1;
+
+	void *table;
+
+	struct stat statbuf;
+
+
+	if ( (fd = open(table_input, O_RDONLY)) == -1 ) {
+		fputs("Cannot open compiled model.\n", stderr);
+		goto done;
+	}
+	if ( fstat(fd, &statbuf) == -1 )
+		ERR(goto done);
+
+	table = mmap(NULL, statbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if ( table == MAP_FAILED )
+		ERR(goto done);
+
+	if ( !model->map_model(model, table, statbuf.st_size, &sealed) ) {
+		fputs("Failed compiled model map.\n", stderr);
+		goto done;
+	}
+
+	retn = true;
+
+
+ done:
+	if ( fd != -1 )
+		close(fd);
+
+	if ( !retn )
+		exit(1);
+
+	return;
+}
+
+
 /*
  * Program entry point begins here.
  */
@@ -97,6 +156,8 @@ extern int main(int argc, char *argv[])
 	_Bool updated,
 	      discipline,
 	      sealed,
+	      hit,
+	      cached		= false,
 	      forensics		= false,
 	      verbose		= false,
 	      dump_measurement	= false,
@@ -108,11 +169,15 @@ extern int main(int argc, char *argv[])
 
 	char *aggregate  = NULL,
 	     *trajectory = NULL,
-	     *model_file = NULL;
+	     *model_file = NULL,
+	     *table_file = NULL;
 
 	int opt,
 	    retn = 1;
 
+	unsigned long int hits,
+			  misses;
+
 	Buffer bufr = NULL;
 
 	File infile = NULL;
@@ -125,7 +190,7 @@ extern int main(int argc, char *argv[])
 
 
 	/* Parse and verify arguements. */
-	while ( (opt = getopt(argc, argv, "CEFLMSa:fm:i:v")) != EOF )
+	while ( (opt = getopt(argc, argv, "CEFLMST:a:cfm:i:v")) != EOF )
 		switch ( opt ) {
 			case 'C':
 				dump_points = true;
@@ -145,9 +210,15 @@ extern int main(int argc, char *argv[])
 			case 'S':
 				dump_state = true;
 				break;
+			case 'T':
+				table_file = optarg;
+				break;
 			case 'a':
 				aggregate = optarg;
 				break;
+			case 'c':
+				cached = true;
+				break;
 			case 'f':
 				forensics = true;
 				break;
@@ -169,11 +240,21 @@ extern int main(int argc, char *argv[])
 
 	/* Test model loading. */
 	if ( load_model ) {
-		model_load(model, model_file);
+		if ( table_file != NULL )
+			model_map(model, table_file);
+		else
+			model_load(model, model_file);
 		goto done;
 	}
 
 
+	/* Initialize the model from a model map or a compiled model. */
+	if ( model_file != NULL )
+		model_load(model, model_file);
+	if ( table_file != NULL )
+		model_map(model, table_file);
+
+
 	/* Open the trajectory file. */
 	if ( !load_model && trajectory == NULL ) {
 		fputs("No trajectory file specified.\n", stderr);
@@ -204,7 +285,19 @@ extern int main(int argc, char *argv[])
 	INIT(HurdLib, String, input, ERR(goto done));
 
 	while ( infile->read_String(infile, input) ) {
-		INIT(NAAAIM, SecurityEvent, event, ERR(goto done));
+		if ( cached ) {
+			if ( !model->cached_update(model, input, &hit, \
+						   &updated, &discipline, \
+						   &sealed) )
+				ERR(goto done);
+			if ( hit ) {
+				input->reset(input);
+				continue;
+			}
+		}
+
+		if ( !model->new_event(model, &event) )
+			ERR(goto done);
 		if ( !event->parse(event, input) ) {
 			fputs("Failed to parse event:\n", stderr);
 			input->print(input);
@@ -215,8 +308,13 @@ extern int main(int argc, char *argv[])
 		if ( !model->update(model, event, &updated, &discipline, \
 				    &sealed) )
 			ERR(goto done);
-		if ( !updated )
-			WHACK(event);
+		model->release_event(model, event);
+	}
+
+	if ( cached && verbose ) {
+		model->cache_statistics(model, &hits, &misses);
+		fprintf(stdout, "Event cache: hits=%lu, misses=%lu\n", hits, \
+			misses);
 	}
 
 
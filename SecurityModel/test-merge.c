@@ -0,0 +1,238 @@
+/** \file
+ * This file implements a test driver for the merge-model utility.  It
+ * generates a set of sorted security model maps with overlapping
+ * state points and pseudonyms along with the model that merging them
+ * is expected to produce.
+ *
+ * The merge is verified with:
+ *
+ *	test-merge -d DIR -n 2
+ *	merge-model -c -n 2 DIR/model-* | cmp - DIR/expected
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+
+/* Include files. */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <HurdLib.h>
+#include <Buffer.h>
+#include <String.h>
+
+#include <NAAAIM.h>
+#include <Hex.h>
+
+
+/* Number of pseudonyms generated for each model. */
+#define PSEUDONYMS 2
+
+
+/**
+ * Private function.
+ *
+ * This function implements the sort comparison function for the
+ * generated state points.
+ *
+ * \param p1	A pointer to the first point to be compared.
+ *
+ * \param p2	A pointer to the second point to be compared.
+ *
+ * \return	An integer value is returned to reflect the lexicographic
+ *		order of the two points.
+ */
+
+static int point_sort(const void *p1, const void *p2)
+
+{
+	return memcmp(p1, p2, NAAAIM_IDSIZE);
+}
+
+
+/**
+ * Private function.
+ *
+ * This function writes a model command with a binary argument.
+ *
+ * \param output	The stream the command is to be written to.
+ *
+ * \param cmd		A pointer to the null-terminated buffer
+ *			containing the command.
+ *
+ * \param value		A pointer to the value to be encoded as the
+ *			argument to the command.
+ */
+
+static void put_value(FILE *output, CO(char *, cmd), CO(uint8_t *, value))
+
+{
+	char hex[NAAAIM_IDSIZE * 2 + 1];
+
+
+	Hex_encode(value, NAAAIM_IDSIZE, hex);
+	hex[sizeof(hex) - 1] = '\0';
+	fprintf(output, "%s%s\n", cmd, hex);
+
+	return;
+}
+
+
+/*
+ * Program entry point begins here.
+ */
+
+extern int main(int argc, char *argv[])
+
+{
+	char *dir = NULL,
+	     fname[FILENAME_MAX];
+
+	int opt,
+	    retn = 1;
+
+	unsigned int lp,
+		     cnt,
+		     count,
+		     models	= 8,
+		     points	= 10000,
+		     seed	= 1;
+
+	unsigned long int minimum = 1,
+			  *totals = NULL;
+
+	uint8_t *pool = NULL,
+		aggregate[NAAAIM_IDSIZE],
+		pseudonym[NAAAIM_IDSIZE];
+
+	FILE *output = NULL;
+
+
+	/* Parse and verify arguements. */
+	while ( (opt = getopt(argc, argv, "d:m:n:p:s:")) != EOF )
+		switch ( opt ) {
+			case 'd':
+				dir = optarg;
+				break;
+			case 'm':
+				models = strtoul(optarg, NULL, 0);
+				break;
+			case 'n':
+				minimum = strtoul(optarg, NULL, 0);
+				break;
+			case 'p':
+				points = strtoul(optarg, NULL, 0);
+				break;
+			case 's':
+				seed = strtoul(optarg, NULL, 0);
+				break;
+		}
+
+	if ( dir == NULL ) {
+		fputs("No output directory specified.\n", stderr);
+		goto done;
+	}
+	if ( (models == 0) || (models > 100) || (points == 0) ) {
+		fputs("Invalid model parameters.\n", stderr);
+		goto done;
+	}
+
+
+	/* Generate the sorted pool of points the models draw from. */
+	srandom(seed);
+	if ( (pool = malloc(points * NAAAIM_IDSIZE)) == NULL )
+		ERR(goto done);
+	if ( (totals = calloc(points, sizeof(*totals))) == NULL )
+		ERR(goto done);
+
+	for (lp= 0; lp < points * NAAAIM_IDSIZE; ++lp)
+		pool[lp] = random();
+	qsort(pool, points, NAAAIM_IDSIZE, point_sort);
+	for (lp= 0; lp < NAAAIM_IDSIZE; ++lp)
+		aggregate[lp] = random();
+
+
+	/*
+	 * Write the models.  Each model carries half of the pool with
+	 * random observation counts and shares one of its pseudonyms
+	 * with its predecessor.
+	 */
+	for (cnt= 0; cnt < models; ++cnt) {
+		snprintf(fname, sizeof(fname), "%s/model-%02u", dir, cnt);
+		if ( (output = fopen(fname, "w")) == NULL ) {
+			fprintf(stderr, "Cannot open %s\n", fname);
+			goto done;
+		}
+
+		put_value(output, "aggregate ", aggregate);
+		for (lp= 0; lp < PSEUDONYMS; ++lp) {
+			memset(pseudonym, '\0', sizeof(pseudonym));
+			pseudonym[0] = cnt + lp;
+			put_value(output, "pseudonym ", pseudonym);
+		}
+
+		for (lp= 0; lp < points; ++lp) {
+			if ( random() & 1 )
+				continue;
+			count = (random() % 5) + 1;
+			totals[lp] += count;
+			fprintf(output, "# count %u\n", count);
+			put_value(output, "state ", \
+				  pool + (lp * NAAAIM_IDSIZE));
+		}
+
+		if ( cnt == 0 )
+			fputs("seal\n", output);
+		fputs("end\n", output);
+
+		if ( fclose(output) != 0 ) {
+			output = NULL;
+			ERR(goto done);
+		}
+		output = NULL;
+	}
+
+
+	/* Write the expected merge. */
+	snprintf(fname, sizeof(fname), "%s/expected", dir);
+	if ( (output = fopen(fname, "w")) == NULL ) {
+		fprintf(stderr, "Cannot open %s\n", fname);
+		goto done;
+	}
+
+	put_value(output, "aggregate ", aggregate);
+	for (lp= 0; lp < points; ++lp) {
+		if ( (totals[lp] == 0) || (totals[lp] < minimum) )
+			continue;
+		fprintf(output, "# count %lu\n", totals[lp]);
+		put_value(output, "state ", pool + (lp * NAAAIM_IDSIZE));
+	}
+
+	for (lp= 0; lp < models + PSEUDONYMS - 1; ++lp) {
+		memset(pseudonym, '\0', sizeof(pseudonym));
+		pseudonym[0] = lp;
+		put_value(output, "pseudonym ", pseudonym);
+	}
+	fputs("seal\nend\n", output);
+
+	retn = 0;
+
+
+ done:
+	if ( (output != NULL) && (fclose(output) != 0) )
+		retn = 1;
+
+	free(pool);
+	free(totals);
+
+	return retn;
+}
@@ -0,0 +1,76 @@
+/** \file
+ * This file contains the definitions for the compiled form of a
+ * security model.  A compiled model is generated from a security
+ * model map by the sign-model utility and is memory mapped, read-only,
+ * by the TSEM object so that the pages holding the model are shared
+ * by all of the orchestrators that use the model.
+ *
+ * A compiled model consists of the following components in the
+ * order listed, all values are in host byte order:
+ *
+ *	The tsem_model header structure.
+ *
+ *	An index of (1 << index_bits) + 1 32-bit values.  Entry N of
+ *	the index is the number of the first security state point
+ *	whose bucket value is N.
+ *
+ *	The security state points in ascending sorted order.
+ *
+ *	The pseudonyms of the model.
+ *
+ *	The public key that the model is signed with.
+ *
+ *	The signature over all of the preceding components.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+#ifndef TSEM_MODEL_HEADER
+#define TSEM_MODEL_HEADER
+
+
+/* Compiled model identification. */
+#define TSEM_MODEL_MAGIC	"TSEMmap1"
+#define TSEM_MODEL_VERSION	1
+
+/* Compiled model flags. */
+#define TSEM_MODEL_AGGREGATE	0x1
+#define TSEM_MODEL_SEALED	0x2
+
+/* The largest index used for a compiled model. */
+#define TSEM_MODEL_MAX_BITS	24
+
+/*
+ * The index bucket of a security state point is the most significant
+ * index_bits of the point.
+ */
+#define TSEM_MODEL_BUCKET(point, bits) ((bits) == 0 ? 0 :	\
+	(((uint32_t) (point)[0] << 24 | (uint32_t) (point)[1] << 16 | \
+	  (uint32_t) (point)[2] << 8  | (uint32_t) (point)[3]) >>	\
+	 (32 - (bits))))
+
+
+/** The header of a compiled security model. */
+struct tsem_model {
+	char magic[8];
+	uint32_t version;
+	uint32_t flags;
+
+	uint32_t points;
+	uint32_t pseudonyms;
+	uint32_t index_bits;
+
+	uint32_t key_size;
+	uint32_t signature_size;
+	uint32_t reserved;
+
+	uint8_t base[32];
+	uint8_t aggregate[32];
+	uint8_t measurement[32];
+};
+#endif
@@ -0,0 +1,474 @@
+/** \file
+ * This file contains the implementation of an object which implements
+ * 256 bit AES authenticated encryption/decryption in GCM mode.
+ *
+ * The cipher context and its expanded key schedule are established
+ * once when the object is created.  Each encryption or decryption
+ * request only loads a new initialization vector into the context,
+ * which allows the object to be kept for the lifetime of a session
+ * and used to process a stream of messages.  Messages are processed
+ * in place in the caller supplied Buffer object with the
+ * authentication tag carried at the end of the ciphertext.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+
+/* Include files. */
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <string.h>
+
+#include <openssl/evp.h>
+
+#include <Origin.h>
+#include <HurdLib.h>
+#include <Buffer.h>
+
+#include "NAAAIM.h"
+#include "AES256_gcm.h"
+
+
+/* Verify library/object header file inclusions. */
+#if !defined(NAAAIM_LIBID)
+#error Library identifier not defined.
+#endif
+
+#if !defined(NAAAIM_AES256_gcm_OBJID)
+#error Object identifier not defined.
+#endif
+
+
+/* Object state extraction macro. */
+#define STATE(var) CO(AES256_gcm_State, var) = this->state
+
+
+/** AES256_GCM private state information. */
+struct NAAAIM_AES256_gcm_State
+{
+	/* The root object. */
+	Origin root;
+
+	/* Library identifier. */
+	uint32_t libid;
+
+	/* Object identifier. */
+	uint32_t objid;
+
+	/* Object status. */
+	_Bool poisoned;
+
+	/* The mode of the object. */
+	enum
+	{
+		encrypt_mode=1,
+		decrypt_mode
+	} mode;
+
+	/* The encryption control structure. */
+	EVP_CIPHER_CTX *context;
+};
+
+
+/**
+ * Internal private method.
+ *
+ * This method is responsible for initializing the NAAAIM_AES256_GCM_State
+ * structure which holds state information for each instantiated object.
+ *
+ * \param S A pointer to the object containing the state information which
+ *        is to be initialized.
+ */
+
+static void _init_state(CO(AES256_gcm_State, S))
+
+{
+	S->libid = NAAAIM_LIBID;
+	S->objid = NAAAIM_AES256_gcm_OBJID;
+
+	S->poisoned = false;
+	S->mode	    = 0;
+
+	S->context = EVP_CIPHER_CTX_new();
+
+	return;
+}
+
+
+/**
+ * Internal private method.
+ *
+ * This method is responsible for loading the additional authenticated
+ * data into the cipher context.
+ *
+ * \param S	A pointer to the state of the object which is processing
+ *		the message.
+ *
+ * \param aad	The object containing the additional data which is to
+ *		be authenticated.  A NULL value indicates there is no
+ *		additional data.
+ *
+ * \return	A boolean value is used to indicate the status of the
+ *		addition of the authenticated data.  A false value
+ *		indicates an error occurred while a true value indicates
+ *		the context is ready for the message payload.
+ */
+
+static _Bool _add_aad(CO(AES256_gcm_State, S), CO(Buffer, aad))
+
+{
+	int outsize;
+
+
+	if ( (aad == NULL) || (aad->size(aad) == 0) )
+		return true;
+	if ( aad->poisoned(aad) || (aad->size(aad) > INT_MAX) )
+		return false;
+
+	if ( S->mode == encrypt_mode )
+		return EVP_EncryptUpdate(S->context, NULL, &outsize, \
+					 aad->get(aad), aad->size(aad));
+	return EVP_DecryptUpdate(S->context, NULL, &outsize, aad->get(aad), \
+				 aad->size(aad));
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements in place encryption of the Buffer object
+ * which is supplied by the caller.  The authentication tag is
+ * appended to the encrypted payload.
+ *
+ * \param this		A pointer to the cipher object which is to carry
+ *			out the encryption.
+ *
+ * \param iv		A pointer to the AES256_GCM_IV_SIZE byte
+ *			initialization vector to be used for the message.
+ *			The vector must never be re-used with the same key.
+ *
+ * \param aad		The object containing additional data which is to
+ *			be authenticated but not encrypted.  This value
+ *			may be NULL.
+ *
+ * \param payload	The object containing the message to be encrypted.
+ *			The contents of the object are replaced with
+ *			the ciphertext and authentication tag.
+ *
+ * \return	A boolean value is used to indicate the status of the
+ *		encryption.  A false value indicates an error occurred
+ *		and the contents of the payload are undefined.  A true
+ *		value indicates the payload holds the encrypted message.
+ */
+
+static _Bool encrypt(CO(AES256_gcm, this), CO(unsigned char *, iv), \
+		     CO(Buffer, aad), CO(Buffer, payload))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	unsigned char *p,
+		      tag[AES256_GCM_TAG_SIZE];
+
+	int encsize;
+
+	size_t size;
+
+
+	if ( S->poisoned )
+		ERR(goto done);
+	if ( S->mode != encrypt_mode )
+		ERR(goto done);
+	if ( (payload == NULL) || payload->poisoned(payload) )
+		ERR(goto done);
+	if ( (size = payload->size(payload)) > INT_MAX )
+		ERR(goto done);
+
+
+	/* Load the message vector and encrypt in place. */
+	if ( !EVP_EncryptInit_ex(S->context, NULL, NULL, NULL, iv) )
+		ERR(goto done);
+	if ( !_add_aad(S, aad) )
+		ERR(goto done);
+
+	p = payload->get(payload);
+	if ( !EVP_EncryptUpdate(S->context, p, &encsize, p, size) )
+		ERR(goto done);
+	if ( !EVP_EncryptFinal_ex(S->context, p + encsize, &encsize) )
+		ERR(goto done);
+
+	if ( !EVP_CIPHER_CTX_ctrl(S->context, EVP_CTRL_GCM_GET_TAG, \
+				  sizeof(tag), tag) )
+		ERR(goto done);
+	if ( !payload->add(payload, tag, sizeof(tag)) )
+		ERR(goto done);
+
+	retn = true;
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements in place authentication and decryption of
+ * the Buffer object which is supplied by the caller.
+ *
+ * \param this		A pointer to the cipher object which is to carry
+ *			out the decryption.
+ *
+ * \param iv		A pointer to the AES256_GCM_IV_SIZE byte
+ *			initialization vector which was used to encrypt
+ *			the message.
+ *
+ * \param aad		The object containing the additional data which
+ *			was authenticated with the message.  This value
+ *			may be NULL.
+ *
+ * \param payload	The object containing the ciphertext and trailing
+ *			authentication tag.  On success the contents of
+ *			the object are replaced with the plaintext.
+ *
+ * \return	A boolean value is used to indicate the status of the
+ *		decryption.  A false value indicates the message could
+ *		not be authenticated.  The object is not poisoned by an
+ *		authentication failure.  A true value indicates the
+ *		payload holds the authenticated plaintext.
+ */
+
+static _Bool decrypt(CO(AES256_gcm, this), CO(unsigned char *, iv), \
+		     CO(Buffer, aad), CO(Buffer, payload))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	unsigned char *p;
+
+	int decsize;
+
+	size_t size;
+
+
+	if ( S->poisoned )
+		ERR(goto done);
+	if ( S->mode != decrypt_mode )
+		ERR(goto done);
+	if ( (payload == NULL) || payload->poisoned(payload) )
+		ERR(goto done);
+	if ( (size = payload->size(payload)) < AES256_GCM_TAG_SIZE )
+		ERR(goto done);
+	if ( (size -= AES256_GCM_TAG_SIZE) > INT_MAX )
+		ERR(goto done);
+
+
+	/* Load the message vector and expected tag then decrypt in place. */
+	p = payload->get(payload);
+	if ( !EVP_DecryptInit_ex(S->context, NULL, NULL, NULL, iv) )
+		ERR(goto done);
+	if ( !EVP_CIPHER_CTX_ctrl(S->context, EVP_CTRL_GCM_SET_TAG, \
+				  AES256_GCM_TAG_SIZE, p + size) )
+		ERR(goto done);
+	if ( !_add_aad(S, aad) )
+		ERR(goto done);
+
+	if ( !EVP_DecryptUpdate(S->context, p, &decsize, p, size) )
+		ERR(goto done);
+	if ( EVP_DecryptFinal_ex(S->context, p + decsize, &decsize) <= 0 )
+		goto done;
+
+	payload->shrink(payload, AES256_GCM_TAG_SIZE);
+	retn = true;
+
+
+ done:
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements an accessor for determining whether or not
+ * the cipher object has been poisoned by a processing error.
+ *
+ * \param this	The cipher object whose status is to be returned.
+ *
+ * \return	A true value indicates the object is poisoned and
+ *		no longer usable.
+ */
+
+static _Bool poisoned(CO(AES256_gcm, this))
+
+{
+	STATE(S);
+
+
+	return S->poisoned;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements a destructor for a AES256_GCM object.
+ *
+ * \param this	A pointer to the object which is to be destroyed.
+ */
+
+static void whack(CO(AES256_gcm, this))
+
+{
+	STATE(S);
+
+
+	EVP_CIPHER_CTX_free(S->context);
+
+	S->root->whack(S->root, this, S);
+	return;
+}
+
+
+/**
+ * External constructor call.
+ *
+ * This function implements a constructor call for a AES256_GCM object.
+ *
+ * \return	A pointer to the initialized AES256_GCM.  A null value
+ *		indicates an error was encountered in object generation.
+ */
+
+extern AES256_gcm NAAAIM_AES256_gcm_Init(void)
+
+{
+	Origin root;
+
+	AES256_gcm this = NULL;
+
+	struct HurdLib_Origin_Retn retn;
+
+
+	/* Get the root object. */
+	root = HurdLib_Origin_Init();
+
+	/* Allocate the object and internal state. */
+	retn.object_size  = sizeof(struct NAAAIM_AES256_gcm);
+	retn.state_size   = sizeof(struct NAAAIM_AES256_gcm_State);
+	if ( !root->init(root, NAAAIM_LIBID, NAAAIM_AES256_gcm_OBJID, &retn) )
+		return NULL;
+	this	    	  = retn.object;
+	this->state 	  = retn.state;
+	this->state->root = root;
+
+	/* Initialize object state. */
+	_init_state(this->state);
+	if ( this->state->context == NULL ) {
+		root->whack(root, this, this->state);
+		return NULL;
+	}
+
+	/* Method initialization. */
+	this->encrypt  = encrypt;
+	this->decrypt  = decrypt;
+	this->poisoned = poisoned;
+	this->whack    = whack;
+
+	return this;
+}
+
+
+/**
+ * External constructor call.
+ *
+ * This function implements a constructor call to set an AES256_GCM
+ * object for encryption.  The key schedule is computed once and
+ * retained for all messages processed by the object.
+ *
+ * \param key	The object containing the 32 byte encryption key.
+ *
+ * \return	A pointer to the initialized AES256_GCM encryption object.
+ *		A null value indicates an error was encountered in object
+ *		generation.
+ */
+
+extern AES256_gcm NAAAIM_AES256_gcm_Init_encrypt(const Buffer key)
+
+{
+	AES256_gcm_State S;
+
+	AES256_gcm this;
+
+
+	if ( (key == NULL) || key->poisoned(key) || (key->size(key) != 32) )
+		return NULL;
+
+	if ( (this = NAAAIM_AES256_gcm_Init()) == NULL )
+		return NULL;
+	S = this->state;
+
+	S->mode = encrypt_mode;
+
+	if ( !EVP_EncryptInit_ex(S->context, EVP_aes_256_gcm(), NULL, \
+				 key->get(key), NULL) ) {
+		this->whack(this);
+		return NULL;
+	}
+
+	return this;
+}
+
+
+/**
+ * External constructor call.
+ *
+ * This function implements a constructor call to set an AES256_GCM
+ * object for decryption.  The key schedule is computed once and
+ * retained for all messages processed by the object.
+ *
+ * \param key	The object containing the 32 byte decryption key.
+ *
+ * \return	A pointer to the initialized AES256_GCM decryption object.
+ *		A null value indicates an error was encountered in object
+ *		generation.
+ */
+
+extern AES256_gcm NAAAIM_AES256_gcm_Init_decrypt(const Buffer key)
+
+{
+	AES256_gcm_State S;
+
+	AES256_gcm this;
+
+
+	if ( (key == NULL) || key->poisoned(key) || (key->size(key) != 32) )
+		return NULL;
+
+	if ( (this = NAAAIM_AES256_gcm_Init()) == NULL )
+		return NULL;
+	S = this->state;
+
+	S->mode = decrypt_mode;
+
+	if ( !EVP_DecryptInit_ex(S->context, EVP_aes_256_gcm(), NULL, \
+				 key->get(key), NULL) ) {
+		this->whack(this);
+		return NULL;
+	}
+
+	return this;
+}
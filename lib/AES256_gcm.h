@@ -0,0 +1,51 @@
+/** \file
+ * This file contains the API definitions for an object which implements
+ * authenticated encryption and decryption of Buffer objects using
+ * 256-bit AES encryption in Galois/Counter mode.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+
+#ifndef NAAAIM_AES256_GCM_HEADER
+#define NAAAIM_AES256_GCM_HEADER
+
+
+/* Size of the initialization vector and authentication tag. */
+#define AES256_GCM_IV_SIZE  12
+#define AES256_GCM_TAG_SIZE 16
+
+
+/* Object type definitions. */
+typedef struct NAAAIM_AES256_gcm * AES256_gcm;
+
+typedef struct NAAAIM_AES256_gcm_State * AES256_gcm_State;
+
+/**
+ * External AES256_GCM object representation.
+ */
+struct NAAAIM_AES256_gcm
+{
+	/* External methods. */
+	_Bool (*encrypt)(const AES256_gcm, const unsigned char *, \
+			 const Buffer, const Buffer);
+	_Bool (*decrypt)(const AES256_gcm, const unsigned char *, \
+			 const Buffer, const Buffer);
+	_Bool (*poisoned)(const AES256_gcm);
+	void (*whack)(const AES256_gcm);
+
+	/* Private state. */
+	AES256_gcm_State state;
+};
+
+
+/* AES256_GCM constructor call. */
+extern HCLINK AES256_gcm NAAAIM_AES256_gcm_Init(void);
+extern HCLINK AES256_gcm NAAAIM_AES256_gcm_Init_encrypt(const Buffer);
+extern HCLINK AES256_gcm NAAAIM_AES256_gcm_Init_decrypt(const Buffer);
+#endif
@@ -1,6 +1,20 @@
 /** \file
  * This file provides the method implementations for an object which
  * implements the encoding and decoding of data in Base64 format.
+ *
+ * The codec operates on whole buffers.  Each pass converts up to
+ * BASE64_CHUNK characters into, or out of, a local buffer which is
+ * then added to the output object.  On x86 platforms the AVX2 or
+ * SSSE3 instruction sets are used to convert 32 or 16 characters per
+ * iteration.  The vector versions are compiled for these instructions
+ * independently of the build flags and are selected at runtime if the
+ * processor supports them.  A table driven scalar implementation
+ * handles the remainder of the data, processors without these
+ * instructions and enclave and firmware builds.
+ *
+ * The update and final methods allow data which is too large to be
+ * held in memory as a single object to be processed in sections of
+ * arbitrary size.
  */
 
 /**************************************************************************
@@ -17,7 +31,16 @@
 #include <stdio.h>
 #include <string.h>
 
-#include <openssl/evp.h>
+/*
+ * Runtime instruction set selection requires CPUID and the processor
+ * model data of the compiler runtime, neither of which is available
+ * to SGX enclave or Mini-OS builds.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && \
+	!defined(SRDE_ENCLAVE) && !defined(__MINIOS__)
+#define BASE64_X86
+#include <immintrin.h>
+#endif
 
 #include <Origin.h>
 #include <HurdLib.h>
@@ -54,6 +77,39 @@ struct NAAAIM_Base64_State
 
 	/* Object status. */
 	_Bool poisoned;
+
+	/* Input held over between update calls. */
+	unsigned char carry[4];
+	unsigned int carried;
+
+	/* Flag to indicate a padded group has been decoded. */
+	_Bool finished;
+};
+
+
+/* Base64 alphabet. */
+static const char Alphabet[] = \
+	"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/**
+ * Table which maps an ASCII character to one more than the value it
+ * represents in the Base64 alphabet.  Characters which are not in the
+ * alphabet have a zero value.
+ */
+static const uint8_t Sextet[256] = {
+	['A'] = 1, ['B'] = 2, ['C'] = 3, ['D'] = 4, ['E'] = 5,
+	['F'] = 6, ['G'] = 7, ['H'] = 8, ['I'] = 9, ['J'] = 10,
+	['K'] = 11, ['L'] = 12, ['M'] = 13, ['N'] = 14, ['O'] = 15,
+	['P'] = 16, ['Q'] = 17, ['R'] = 18, ['S'] = 19, ['T'] = 20,
+	['U'] = 21, ['V'] = 22, ['W'] = 23, ['X'] = 24, ['Y'] = 25,
+	['Z'] = 26, ['a'] = 27, ['b'] = 28, ['c'] = 29, ['d'] = 30,
+	['e'] = 31, ['f'] = 32, ['g'] = 33, ['h'] = 34, ['i'] = 35,
+	['j'] = 36, ['k'] = 37, ['l'] = 38, ['m'] = 39, ['n'] = 40,
+	['o'] = 41, ['p'] = 42, ['q'] = 43, ['r'] = 44, ['s'] = 45,
+	['t'] = 46, ['u'] = 47, ['v'] = 48, ['w'] = 49, ['x'] = 50,
+	['y'] = 51, ['z'] = 52, ['0'] = 53, ['1'] = 54, ['2'] = 55,
+	['3'] = 56, ['4'] = 57, ['5'] = 58, ['6'] = 59, ['7'] = 60,
+	['8'] = 61, ['9'] = 62, ['+'] = 63, ['/'] = 64
 };
 
 
@@ -74,10 +130,740 @@ static void _init_state(CO(Base64_State, S)) {
 
 	S->poisoned  = false;
 
+	memset(S->carry, '\0', sizeof(S->carry));
+	S->carried  = 0;
+	S->finished = false;
+
 	return;
 }
 
 
+#if defined(BASE64_X86)
+/**
+ * Private function.
+ *
+ * This function translates a vector of six bit values into the
+ * corresponding characters of the Base64 alphabet.
+ *
+ * \param idx	The vector of values to be translated.
+ *
+ * \return	The vector of characters.
+ */
+
+__attribute__((target("avx2")))
+static inline __m256i _translate256(const __m256i idx)
+
+{
+	__m256i v,
+		less;
+
+	const __m256i shift = _mm256_setr_epi8(
+		'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		'0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+		'/' - 63, 'A', 0, 0,
+		'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		'0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+		'/' - 63, 'A', 0, 0);
+
+
+	/*
+	 * Values in the ranges 52-61, 62 and 63 map to table entries
+	 * 1-12, values in the range 26-51 map to entry zero and values
+	 * below 26 map to entry 13.
+	 */
+	v    = _mm256_subs_epu8(idx, _mm256_set1_epi8(51));
+	less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), idx);
+	v    = _mm256_or_si256(v, _mm256_and_si256(less, \
+						   _mm256_set1_epi8(13)));
+
+	return _mm256_add_epi8(_mm256_shuffle_epi8(shift, v), idx);
+}
+
+
+/**
+ * Private function.
+ *
+ * This function is the 128 bit equivalent of the _translate256
+ * function.
+ *
+ * \param idx	The vector of values to be translated.
+ *
+ * \return	The vector of characters.
+ */
+
+__attribute__((target("ssse3")))
+static inline __m128i _translate128(const __m128i idx)
+
+{
+	__m128i v,
+		less;
+
+	const __m128i shift = _mm_setr_epi8(
+		'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+		'0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+		'/' - 63, 'A', 0, 0);
+
+
+	v    = _mm_subs_epu8(idx, _mm_set1_epi8(51));
+	less = _mm_cmpgt_epi8(_mm_set1_epi8(26), idx);
+	v    = _mm_or_si128(v, _mm_and_si128(less, _mm_set1_epi8(13)));
+
+	return _mm_add_epi8(_mm_shuffle_epi8(shift, v), idx);
+}
+
+
+#endif
+
+
+/**
+ * Private function.
+ *
+ * This function implements the scalar encoding of complete three
+ * byte groups of binary data.
+ *
+ * \param in	A pointer to the data to be encoded.
+ *
+ * \param cnt	The number of groups to be encoded.
+ *
+ * \param out	A pointer to the buffer which the four characters
+ *		generated for each group are to be written to.
+ */
+
+static void _encode_scalar(const uint8_t *in, size_t cnt, char *out)
+
+{
+	uint32_t group;
+
+
+	while ( cnt-- ) {
+		group = (in[0] << 16) | (in[1] << 8) | in[2];
+		*out++ = Alphabet[(group >> 18) & 0x3f];
+		*out++ = Alphabet[(group >> 12) & 0x3f];
+		*out++ = Alphabet[(group >> 6) & 0x3f];
+		*out++ = Alphabet[group & 0x3f];
+		in += 3;
+	}
+
+	return;
+}
+
+
+#if defined(BASE64_X86)
+/*
+ * The vector encoders load 16 bytes at a time, of which 12 bytes are
+ * used, so they stop while at least 16 bytes remain.  The bytes of
+ * each group are arranged into a 32 bit word and the four six bit
+ * fields are moved into separate bytes with a pair of multiplies.
+ */
+
+/**
+ * Private function.
+ *
+ * This function encodes complete three byte groups of binary data
+ * four groups at a time with the SSSE3 instructions.  The remaining
+ * groups are encoded by the scalar implementation.
+ *
+ * \param in	A pointer to the data to be encoded.
+ *
+ * \param cnt	The number of groups to be encoded.
+ *
+ * \param out	A pointer to the buffer which the four characters
+ *		generated for each group are to be written to.
+ */
+
+__attribute__((target("ssse3")))
+static void _encode_ssse3(const uint8_t *in, size_t cnt, char *out)
+
+{
+	__m128i v,
+		t0,
+		t1;
+
+	const __m128i order = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, \
+					    7, 6, 8, 7, 10, 9, 11, 10);
+
+
+	while ( cnt >= 6 ) {
+		v = _mm_loadu_si128((const __m128i *) in);
+		v = _mm_shuffle_epi8(v, order);
+
+		t0 = _mm_and_si128(v, _mm_set1_epi32(0x0fc0fc00));
+		t0 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+		t1 = _mm_and_si128(v, _mm_set1_epi32(0x003f03f0));
+		t1 = _mm_mullo_epi16(t1, _mm_set1_epi32(0x01000010));
+
+		v = _translate128(_mm_or_si128(t0, t1));
+		_mm_storeu_si128((__m128i *) out, v);
+
+		in  += 12;
+		out += 16;
+		cnt -= 4;
+	}
+
+	_encode_scalar(in, cnt, out);
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function is the AVX2 equivalent of the _encode_ssse3 function
+ * and encodes eight groups at a time.
+ *
+ * \param in	A pointer to the data to be encoded.
+ *
+ * \param cnt	The number of groups to be encoded.
+ *
+ * \param out	A pointer to the buffer which the four characters
+ *		generated for each group are to be written to.
+ */
+
+__attribute__((target("avx2")))
+static void _encode_avx2(const uint8_t *in, size_t cnt, char *out)
+
+{
+	__m256i v,
+		t0,
+		t1;
+
+	const __m256i order = _mm256_setr_epi8(
+		1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+		1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+
+
+	while ( cnt >= 10 ) {
+		v = _mm256_inserti128_si256(				\
+			_mm256_castsi128_si256(				\
+				_mm_loadu_si128((const __m128i *) in)),	\
+			_mm_loadu_si128((const __m128i *) (in + 12)), 1);
+		v = _mm256_shuffle_epi8(v, order);
+
+		t0 = _mm256_and_si256(v, _mm256_set1_epi32(0x0fc0fc00));
+		t0 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+		t1 = _mm256_and_si256(v, _mm256_set1_epi32(0x003f03f0));
+		t1 = _mm256_mullo_epi16(t1, _mm256_set1_epi32(0x01000010));
+
+		v = _translate256(_mm256_or_si256(t0, t1));
+		_mm256_storeu_si256((__m256i *) out, v);
+
+		in  += 24;
+		out += 32;
+		cnt -= 8;
+	}
+
+	_encode_ssse3(in, cnt, out);
+	return;
+}
+#endif
+
+
+/**
+ * Private function.
+ *
+ * This function encodes complete three byte groups of binary data
+ * with the fastest implementation supported by the processor.
+ *
+ * \param in	A pointer to the data to be encoded.
+ *
+ * \param cnt	The number of groups to be encoded.
+ *
+ * \param out	A pointer to the buffer which the four characters
+ *		generated for each group are to be written to.
+ */
+
+static void _encode_groups(const uint8_t *in, size_t cnt, char *out)
+
+{
+#if defined(BASE64_X86)
+	if ( __builtin_cpu_supports("avx2") ) {
+		_encode_avx2(in, cnt, out);
+		return;
+	}
+	if ( __builtin_cpu_supports("ssse3") ) {
+		_encode_ssse3(in, cnt, out);
+		return;
+	}
+#endif
+
+	_encode_scalar(in, cnt, out);
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function encodes the one or two bytes at the end of the data
+ * into a padded group of four characters.
+ *
+ * \param in	A pointer to the data to be encoded.
+ *
+ * \param cnt	The number of bytes to be encoded.
+ *
+ * \param out	A pointer to the buffer which the characters are to
+ *		be written to.
+ */
+
+static void _encode_tail(const uint8_t *in, const size_t cnt, char *out)
+
+{
+	uint32_t group;
+
+
+	group = in[0] << 16;
+	if ( cnt > 1 )
+		group |= in[1] << 8;
+
+	out[0] = Alphabet[(group >> 18) & 0x3f];
+	out[1] = Alphabet[(group >> 12) & 0x3f];
+	out[2] = cnt > 1 ? Alphabet[(group >> 6) & 0x3f] : '=';
+	out[3] = '=';
+
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function adds the encoding of complete three byte groups of
+ * binary data to a String object.
+ *
+ * \param in	A pointer to the data to be encoded.
+ *
+ * \param cnt	The number of groups to be encoded.
+ *
+ * \param out	The object which the encoding is to be added to.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the encoding was added to the output object.
+ */
+
+static _Bool _add_encoded(const uint8_t *in, size_t cnt, CO(String, out))
+
+{
+	char bp[BASE64_CHUNK + 1];
+
+	size_t groups;
+
+
+	while ( cnt > 0 ) {
+		groups = cnt > (BASE64_CHUNK / 4) ? BASE64_CHUNK / 4 : cnt;
+		_encode_groups(in, groups, bp);
+		bp[4 * groups] = '\0';
+		if ( !out->add(out, bp) )
+			return false;
+
+		in  += 3 * groups;
+		cnt -= groups;
+	}
+
+	return true;
+}
+
+
+#if defined(BASE64_X86)
+/**
+ * Private function.
+ *
+ * This function converts a vector of Base64 characters into the six
+ * bit values which they represent.
+ *
+ * \param v	A pointer to the vector to be converted.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		all of the characters were in the Base64 alphabet.
+ */
+
+__attribute__((target("avx2")))
+static inline _Bool _sextets256(__m256i *v)
+
+{
+	__m256i hi,
+		lo,
+		roll,
+		hi_nybbles,
+		lo_nybbles,
+		slashes;
+
+	const __m256i mask = _mm256_set1_epi8(0x2f);
+
+	const __m256i lut_lo = _mm256_setr_epi8(
+		0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+		0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+		0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+		0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+
+	const __m256i lut_hi = _mm256_setr_epi8(
+		0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+		0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+		0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+		0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+
+	const __m256i lut_roll = _mm256_setr_epi8(
+		0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+		0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+
+
+	/*
+	 * Each character is classified by its high and low nybbles.
+	 * A character is valid only if the two classifications have
+	 * no bits in common.  The value of the character is obtained
+	 * by adding an offset selected by the high nybble, with the
+	 * slash character being given its own offset.
+	 */
+	hi_nybbles = _mm256_and_si256(_mm256_srli_epi32(*v, 4), mask);
+	lo_nybbles = _mm256_and_si256(*v, mask);
+	hi = _mm256_shuffle_epi8(lut_hi, hi_nybbles);
+	lo = _mm256_shuffle_epi8(lut_lo, lo_nybbles);
+	if ( !_mm256_testz_si256(lo, hi) )
+		return false;
+
+	slashes = _mm256_cmpeq_epi8(*v, mask);
+	roll	= _mm256_shuffle_epi8(lut_roll, \
+				      _mm256_add_epi8(slashes, hi_nybbles));
+	*v = _mm256_add_epi8(*v, roll);
+
+	return true;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function is the 128 bit equivalent of the _sextets256
+ * function.
+ *
+ * \param v	A pointer to the vector to be converted.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		all of the characters were in the Base64 alphabet.
+ */
+
+__attribute__((target("ssse3")))
+static inline _Bool _sextets128(__m128i *v)
+
+{
+	__m128i hi,
+		lo,
+		roll,
+		hi_nybbles,
+		lo_nybbles,
+		slashes;
+
+	const __m128i mask = _mm_set1_epi8(0x2f);
+
+	const __m128i lut_lo = _mm_setr_epi8(
+		0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+		0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+
+	const __m128i lut_hi = _mm_setr_epi8(
+		0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+		0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+
+	const __m128i lut_roll = _mm_setr_epi8(
+		0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+
+
+	hi_nybbles = _mm_and_si128(_mm_srli_epi32(*v, 4), mask);
+	lo_nybbles = _mm_and_si128(*v, mask);
+	hi = _mm_shuffle_epi8(lut_hi, hi_nybbles);
+	lo = _mm_shuffle_epi8(lut_lo, lo_nybbles);
+	if ( _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), \
+					      _mm_setzero_si128())) != 0xffff )
+		return false;
+
+	slashes = _mm_cmpeq_epi8(*v, mask);
+	roll	= _mm_shuffle_epi8(lut_roll, _mm_add_epi8(slashes, hi_nybbles));
+	*v = _mm_add_epi8(*v, roll);
+
+	return true;
+}
+
+
+#endif
+
+
+/**
+ * Private function.
+ *
+ * This function implements the scalar decoding of complete groups of
+ * four Base64 characters which do not contain padding.
+ *
+ * \param in	A pointer to the characters to be decoded.
+ *
+ * \param cnt	The number of groups to be decoded.
+ *
+ * \param out	A pointer to the buffer which the three bytes
+ *		generated for each group are to be written to.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		all of the characters were in the Base64 alphabet.
+ */
+
+static _Bool _decode_scalar(const unsigned char *in, size_t cnt, \
+			    uint8_t *out)
+
+{
+	uint8_t a,
+		b,
+		c,
+		d,
+		bad = 0;
+
+	uint32_t group;
+
+
+	while ( cnt-- ) {
+		a = Sextet[*in++];
+		b = Sextet[*in++];
+		c = Sextet[*in++];
+		d = Sextet[*in++];
+		bad |= (a == 0) | (b == 0) | (c == 0) | (d == 0);
+
+		group = ((a - 1U) << 18) | ((b - 1U) << 12) | \
+			((c - 1U) << 6) | (d - 1U);
+		*out++ = group >> 16;
+		*out++ = group >> 8;
+		*out++ = group;
+	}
+
+	return bad == 0;
+}
+
+
+#if defined(BASE64_X86)
+/*
+ * The vector decoders merge the six bit values into 12 and then 24
+ * bit fields with multiply-add instructions and gather the three
+ * bytes of each field with a shuffle.
+ */
+
+/**
+ * Private function.
+ *
+ * This function decodes groups of Base64 characters four groups at a
+ * time with the SSSE3 instructions.  The remaining groups are decoded
+ * by the scalar implementation.
+ *
+ * \param in	A pointer to the characters to be decoded.
+ *
+ * \param cnt	The number of groups to be decoded.
+ *
+ * \param out	A pointer to the buffer which the three bytes
+ *		generated for each group are to be written to.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		all of the characters were in the Base64 alphabet.
+ */
+
+__attribute__((target("ssse3")))
+static _Bool _decode_ssse3(const unsigned char *in, size_t cnt, \
+			   uint8_t *out)
+
+{
+	uint32_t word;
+
+	__m128i v;
+
+	const __m128i order = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, \
+					    14, 13, 12, -1, -1, -1, -1);
+
+
+	while ( cnt >= 4 ) {
+		v = _mm_loadu_si128((const __m128i *) in);
+		if ( !_sextets128(&v) )
+			return false;
+
+		v = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+		v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+		v = _mm_shuffle_epi8(v, order);
+
+		_mm_storel_epi64((__m128i *) out, v);
+		word = _mm_cvtsi128_si32(_mm_srli_si128(v, 8));
+		memcpy(out + 8, &word, sizeof(word));
+
+		in  += 16;
+		out += 12;
+		cnt -= 4;
+	}
+
+	return _decode_scalar(in, cnt, out);
+}
+
+
+/**
+ * Private function.
+ *
+ * This function is the AVX2 equivalent of the _decode_ssse3 function
+ * and decodes eight groups at a time.
+ *
+ * \param in	A pointer to the characters to be decoded.
+ *
+ * \param cnt	The number of groups to be decoded.
+ *
+ * \param out	A pointer to the buffer which the three bytes
+ *		generated for each group are to be written to.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		all of the characters were in the Base64 alphabet.
+ */
+
+__attribute__((target("avx2")))
+static _Bool _decode_avx2(const unsigned char *in, size_t cnt, \
+			  uint8_t *out)
+
+{
+	__m256i v;
+
+	const __m256i order = _mm256_setr_epi8(
+		2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+		2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+
+	while ( cnt >= 8 ) {
+		v = _mm256_loadu_si256((const __m256i *) in);
+		if ( !_sextets256(&v) )
+			return false;
+
+		v = _mm256_maddubs_epi16(v, _mm256_set1_epi32(0x01400140));
+		v = _mm256_madd_epi16(v, _mm256_set1_epi32(0x00011000));
+		v = _mm256_shuffle_epi8(v, order);
+		v = _mm256_permutevar8x32_epi32(v, \
+			_mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+
+		_mm_storeu_si128((__m128i *) out, _mm256_castsi256_si128(v));
+		_mm_storel_epi64((__m128i *) (out + 16), \
+				 _mm256_extracti128_si256(v, 1));
+
+		in  += 32;
+		out += 24;
+		cnt -= 8;
+	}
+
+	return _decode_ssse3(in, cnt, out);
+}
+#endif
+
+
+/**
+ * Private function.
+ *
+ * This function decodes complete groups of four Base64 characters
+ * which do not contain padding with the fastest implementation
+ * supported by the processor.
+ *
+ * \param in	A pointer to the characters to be decoded.
+ *
+ * \param cnt	The number of groups to be decoded.
+ *
+ * \param out	A pointer to the buffer which the three bytes
+ *		generated for each group are to be written to.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		all of the characters were in the Base64 alphabet.
+ */
+
+static _Bool _decode_groups(const unsigned char *in, size_t cnt, \
+			    uint8_t *out)
+
+{
+#if defined(BASE64_X86)
+	if ( __builtin_cpu_supports("avx2") )
+		return _decode_avx2(in, cnt, out);
+	if ( __builtin_cpu_supports("ssse3") )
+		return _decode_ssse3(in, cnt, out);
+#endif
+
+	return _decode_scalar(in, cnt, out);
+}
+
+
+/**
+ * Private function.
+ *
+ * This function decodes the final group of Base64 characters.  The
+ * group may be padded to four characters or may consist of two or
+ * three characters without padding.
+ *
+ * \param in	A pointer to the characters to be decoded.
+ *
+ * \param cnt	The number of characters in the group.
+ *
+ * \param out	A pointer to the buffer which the decoded bytes are to
+ *		be written to.
+ *
+ * \param used	A pointer to the variable which will be loaded with
+ *		the number of bytes which were decoded.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the group was valid.
+ */
+
+static _Bool _decode_tail(const unsigned char *in, size_t cnt, \
+			  uint8_t *out, size_t *used)
+
+{
+	unsigned char group[4] = {'A', 'A', 'A', 'A'};
+
+
+	if ( cnt == 4 ) {
+		if ( in[3] == '=' )
+			cnt = (in[2] == '=') ? 2 : 3;
+	}
+	if ( cnt < 2 )
+		return false;
+
+	memcpy(group, in, cnt);
+	if ( !_decode_groups(group, 1, out) )
+		return false;
+
+	*used = cnt - 1;
+	return true;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function adds the decoding of complete groups of Base64
+ * characters, which do not contain padding, to a Buffer object.
+ *
+ * \param in	A pointer to the characters to be decoded.
+ *
+ * \param cnt	The number of groups to be decoded.
+ *
+ * \param out	The object which the decoded data is to be added to.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the data was decoded and added to the output object.
+ */
+
+static _Bool _add_decoded(const unsigned char *in, size_t cnt, \
+			  CO(Buffer, out))
+
+{
+	uint8_t bp[3 * (BASE64_CHUNK / 4)];
+
+	size_t groups;
+
+
+	while ( cnt > 0 ) {
+		groups = cnt > (BASE64_CHUNK / 4) ? BASE64_CHUNK / 4 : cnt;
+		if ( !_decode_groups(in, groups, bp) )
+			return false;
+		if ( !out->add(out, bp, 3 * groups) )
+			return false;
+
+		in  += 4 * groups;
+		cnt -= groups;
+	}
+
+	return true;
+}
+
+
 /**
  * External public method.
  *
@@ -106,13 +892,11 @@ static _Bool encode(CO(Base64, this), CO(Buffer, input), CO(String, output))
 
 	_Bool retn = false;
 
-	unsigned char *p;
+	char tail[5];
 
-	unsigned char encbufr[5];
+	unsigned char *p;
 
-	uint32_t lp,
-		 blocks,
-		 residual;
+	size_t size;
 
 
 	/* Validate object and inputs. */
@@ -125,23 +909,16 @@ static _Bool encode(CO(Base64, this), CO(Buffer, input), CO(String, output))
 
 
 	/* Base64 encode the input buffer. */
-	p = input->get(input);
-
-	blocks   = input->size(input) / 3;
-	residual = input->size(input) % 3;
+	p    = input->get(input);
+	size = input->size(input);
 
-	for (lp= 0; lp < blocks; ++lp) {
-		memset(encbufr, '\0', sizeof(encbufr));
-		EVP_EncodeBlock(encbufr, p, 3);
-		if ( !output->add(output, (char *) encbufr) )
-			ERR(goto done);
-		p += 3;
-	}
+	if ( !_add_encoded(p, size / 3, output) )
+		ERR(goto done);
 
-	if ( residual > 0 ) {
-		memset(encbufr, '\0', sizeof(encbufr));
-		EVP_EncodeBlock(encbufr, p, residual);
-		if ( !output->add(output, (char *) encbufr) )
+	if ( (size % 3) > 0 ) {
+		_encode_tail(p + size - (size % 3), size % 3, tail);
+		tail[4] = '\0';
+		if ( !output->add(output, tail) )
 			ERR(goto done);
 	}
 
@@ -160,7 +937,8 @@ static _Bool encode(CO(Base64, this), CO(Buffer, input), CO(String, output))
  * External public method.
  *
  * This method implements the decoding of the ASCII specification of
- * a Base64 string into its binary form.
+ * a Base64 string into its binary form.  Whitespace at the beginning
+ * and end of the string is ignored.
  *
  * \param this		A pointer to the object which is requesting
  *			decoding of a Base64 string.
@@ -184,12 +962,13 @@ static _Bool decode(CO(Base64, this), CO(String, input), CO(Buffer, output))
 
 	_Bool retn = false;
 
-	uint32_t lp,
-		 blocks,
-		 residual;
+	uint8_t tail[3];
+
+	unsigned char *p;
 
-	unsigned char *p,
-		       decbufr[3];
+	size_t size,
+	       used,
+	       residual;
 
 
 	/* Verify object and inputs. */
@@ -201,36 +980,343 @@ static _Bool decode(CO(Base64, this), CO(String, input), CO(Buffer, output))
 		ERR(goto done);
 
 
-	/* Run the initial loop over the total data blocks. */
-	p = (unsigned char *) input->get(input);
+	/* Trim surrounding whitespace. */
+	p    = (unsigned char *) input->get(input);
+	size = input->size(input);
 
-	blocks   = input->size(input) / 4;
-	residual = input->size(input) % 4;
+	while ( (size > 0) && ((*p == ' ') || (*p == '\t') || \
+			       (*p == '\r') || (*p == '\n')) ) {
+		++p;
+		--size;
+	}
+	while ( (size > 0) && ((p[size - 1] == ' ') ||  \
+			       (p[size - 1] == '\t') || \
+			       (p[size - 1] == '\r') || \
+			       (p[size - 1] == '\n')) )
+		--size;
+
+	if ( size == 0 ) {
+		retn = true;
+		goto done;
+	}
+
+
+	/* Decode the groups before the final, possibly padded, group. */
+	residual = size % 4;
+	if ( residual == 0 )
+		residual = 4;
+
+	if ( !_add_decoded(p, (size - residual) / 4, output) )
+		ERR(goto done);
+
+	if ( !_decode_tail(p + size - residual, residual, tail, &used) )
+		ERR(goto done);
+	if ( !output->add(output, tail, used) )
+		ERR(goto done);
+
+	retn = true;
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements the encoding of a section of a larger body
+ * of binary data.  Bytes which do not complete a three byte group
+ * are held by the object until the next call to this method or the
+ * encode_final method.
+ *
+ * \param this		A pointer to the object which is encoding
+ *			the data.
+ *
+ * \param input		The object containing the section of data to
+ *			be encoded.
+ *
+ * \param output	The object which the Base64 encoding is to be
+ *			added to.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the section was encoded.
+ */
+
+static _Bool encode_update(CO(Base64, this), CO(Buffer, input), \
+			   CO(String, output))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	char group[5];
+
+	unsigned char *p;
+
+	size_t size;
 
-	for (lp= 0; lp < blocks; ++lp) {
-		EVP_DecodeBlock(decbufr, p, 4);
-		if ( !output->add(output, decbufr, sizeof(decbufr)) )
+
+	/* Validate object and inputs. */
+	if ( S->poisoned )
+		ERR(goto done);
+	if ( input->poisoned(input) )
+		ERR(goto done);
+	if ( output->poisoned(output) )
+		ERR(goto done);
+
+	p    = input->get(input);
+	size = input->size(input);
+
+
+	/* Complete a group from the previous section. */
+	while ( (S->carried > 0) && (S->carried < 3) && (size > 0) ) {
+		S->carry[S->carried++] = *p++;
+		--size;
+	}
+	if ( S->carried == 3 ) {
+		_encode_groups(S->carry, 1, group);
+		group[4] = '\0';
+		if ( !output->add(output, group) )
 			ERR(goto done);
-		p += 4;
+		S->carried = 0;
 	}
 
 
-	/* Decode the residual bytes. */
-	if ( residual > 0 ) {
-		memset(decbufr, '\0', sizeof(decbufr));
-		EVP_DecodeBlock(decbufr, p, residual);
-		if ( !output->add(output, (void *) decbufr, sizeof(decbufr)) )
+	/* Encode the complete groups and hold the remainder. */
+	if ( !_add_encoded(p, size / 3, output) )
+		ERR(goto done);
+
+	p += size - (size % 3);
+	while ( (size % 3) > 0 ) {
+		S->carry[S->carried++] = *p++;
+		--size;
+	}
+
+	retn = true;
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method completes the encoding of a body of binary data which
+ * was supplied to the encode_update method.
+ *
+ * \param this		A pointer to the object which is encoding
+ *			the data.
+ *
+ * \param output	The object which the final group of the Base64
+ *			encoding is to be added to.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the encoding was completed.
+ */
+
+static _Bool encode_final(CO(Base64, this), CO(String, output))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	char tail[5];
+
+
+	if ( S->poisoned )
+		ERR(goto done);
+	if ( output->poisoned(output) )
+		ERR(goto done);
+
+	if ( S->carried > 0 ) {
+		_encode_tail(S->carry, S->carried, tail);
+		tail[4] = '\0';
+		if ( !output->add(output, tail) )
+			ERR(goto done);
+	}
+
+	S->carried = 0;
+	retn = true;
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements the decoding of a section of a larger body
+ * of Base64 encoded data.  Characters which do not complete a group
+ * are held by the object until the next call to this method or the
+ * decode_final method.  Whitespace is not accepted within the
+ * section.
+ *
+ * \param this		A pointer to the object which is decoding
+ *			the data.
+ *
+ * \param input		The object containing the section of
+ *			characters to be decoded.
+ *
+ * \param output	The object which the decoded data is to be
+ *			added to.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the section was decoded.  A false value is returned if
+ *		the section contains an invalid character or follows a
+ *		padded group.
+ */
+
+static _Bool decode_update(CO(Base64, this), CO(String, input), \
+			   CO(Buffer, output))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	uint8_t tail[3];
+
+	unsigned char *p;
+
+	size_t size,
+	       used,
+	       groups;
+
+
+	/* Verify object and inputs. */
+	if ( S->poisoned )
+		ERR(goto done);
+	if ( input->poisoned(input) )
+		ERR(goto done);
+	if ( output->poisoned(output) )
+		ERR(goto done);
+
+	p    = (unsigned char *) input->get(input);
+	size = input->size(input);
+	if ( size == 0 ) {
+		retn = true;
+		goto done;
+	}
+	if ( S->finished )
+		ERR(goto done);
+
+
+	/* Complete a group from the previous section. */
+	while ( (S->carried > 0) && (S->carried < 4) && (size > 0) ) {
+		S->carry[S->carried++] = *p++;
+		--size;
+	}
+	if ( S->carried == 4 ) {
+		if ( !_decode_tail(S->carry, 4, tail, &used) )
+			ERR(goto done);
+		if ( !output->add(output, tail, used) )
+			ERR(goto done);
+
+		S->carried  = 0;
+		S->finished = (used < 3);
+		if ( S->finished && (size > 0) )
+			ERR(goto done);
+	}
+
+
+	/*
+	 * Decode the complete groups.  A padded group can only be the
+	 * last group of the data.
+	 */
+	groups = size / 4;
+	if ( (groups > 0) && (p[4 * groups - 1] == '=') ) {
+		if ( (size % 4) != 0 )
+			ERR(goto done);
+		if ( !_add_decoded(p, groups - 1, output) )
+			ERR(goto done);
+		if ( !_decode_tail(p + 4 * (groups - 1), 4, tail, &used) )
+			ERR(goto done);
+		if ( !output->add(output, tail, used) )
+			ERR(goto done);
+		S->finished = true;
+	}
+	else {
+		if ( !_add_decoded(p, groups, output) )
+			ERR(goto done);
+	}
+
+	p += 4 * groups;
+	while ( (size % 4) > 0 ) {
+		S->carry[S->carried++] = *p++;
+		--size;
+	}
+
+	retn = true;
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method completes the decoding of a body of Base64 data which
+ * was supplied to the decode_update method.  A final group without
+ * padding is accepted.
+ *
+ * \param this		A pointer to the object which is decoding
+ *			the data.
+ *
+ * \param output	The object which the final decoded bytes are
+ *			to be added to.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the decoding was completed.  A false value is returned
+ *		if a single character is left over.
+ */
+
+static _Bool decode_final(CO(Base64, this), CO(Buffer, output))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	uint8_t tail[3];
+
+	size_t used;
+
+
+	if ( S->poisoned )
+		ERR(goto done);
+	if ( output->poisoned(output) )
+		ERR(goto done);
+
+	if ( S->carried > 0 ) {
+		if ( !_decode_tail(S->carry, S->carried, tail, &used) )
+			ERR(goto done);
+		if ( !output->add(output, tail, used) )
 			ERR(goto done);
-	} else {
-		p -= 4;
-		lp = 0;
-		if ( *(p+2) == '=' )
-			++lp;
-		if ( *(p+3) == '=' )
-			++lp;
-		output->shrink(output, lp);
 	}
 
+	S->carried  = 0;
+	S->finished = false;
 	retn = true;
 
 
@@ -300,6 +1386,11 @@ extern Base64 NAAAIM_Base64_Init(void)
 	this->encode = encode;
 	this->decode = decode;
 
+	this->encode_update = encode_update;
+	this->encode_final  = encode_final;
+	this->decode_update = decode_update;
+	this->decode_final  = decode_final;
+
 	this->whack = whack;
 
 	return this;
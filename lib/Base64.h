@@ -14,6 +14,13 @@
 #define NAAAIM_Base64_HEADER
 
 
+/*
+ * Number of encoded characters which are generated or consumed in one
+ * pass of the codec.  This value must be a multiple of four.
+ */
+#define BASE64_CHUNK 4096
+
+
 /* Object type definitions. */
 typedef struct NAAAIM_Base64 * Base64;
 
@@ -28,6 +35,11 @@ struct NAAAIM_Base64
 	_Bool (*encode)(const Base64, const Buffer, const String);
 	_Bool (*decode)(const Base64, const String, const Buffer);
 
+	_Bool (*encode_update)(const Base64, const Buffer, const String);
+	_Bool (*encode_final)(const Base64, const String);
+	_Bool (*decode_update)(const Base64, const String, const Buffer);
+	_Bool (*decode_final)(const Base64, const Buffer);
+
 	void (*whack)(const Base64);
 
 
@@ -0,0 +1,417 @@
+/** \file
+ * This file implements a test and benchmark driver for the Base64
+ * object.
+ *
+ * The encoding and decoding methods, and their update/final
+ * equivalents, are first verified against the OpenSSL Base64 codec
+ * for a range of input sizes.  The throughput of the methods is then
+ * compared with the previous implementation, which called the
+ * OpenSSL block functions once for each group, on 1 KiB and 1 MiB
+ * inputs.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+
+#include <openssl/evp.h>
+
+#include <HurdLib.h>
+#include <Buffer.h>
+#include <String.h>
+
+#include <NAAAIM.h>
+#include "Base64.h"
+
+
+/* Largest input size verified. */
+#define MAX_VERIFY 1100
+
+
+/**
+ * Private function.
+ *
+ * This function returns the number of seconds which have elapsed
+ * since the supplied starting time.
+ *
+ * \param start	A pointer to the structure containing the starting
+ *		time.
+ *
+ * \return	The number of elapsed seconds.
+ */
+
+static double elapsed(const struct timespec *start)
+
+{
+	struct timespec end;
+
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) + \
+		(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function implements the encoding method which the Base64
+ * object previously used.
+ */
+
+static _Bool legacy_encode(CO(Buffer, input), CO(String, output))
+
+{
+	unsigned char *p,
+		      encbufr[5];
+
+	uint32_t lp,
+		 blocks,
+		 residual;
+
+
+	p = input->get(input);
+
+	blocks	 = input->size(input) / 3;
+	residual = input->size(input) % 3;
+
+	for (lp= 0; lp < blocks; ++lp) {
+		memset(encbufr, '\0', sizeof(encbufr));
+		EVP_EncodeBlock(encbufr, p, 3);
+		if ( !output->add(output, (char *) encbufr) )
+			return false;
+		p += 3;
+	}
+
+	if ( residual > 0 ) {
+		memset(encbufr, '\0', sizeof(encbufr));
+		EVP_EncodeBlock(encbufr, p, residual);
+		if ( !output->add(output, (char *) encbufr) )
+			return false;
+	}
+
+	return true;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function implements the decoding method which the Base64
+ * object previously used.
+ */
+
+static _Bool legacy_decode(CO(String, input), CO(Buffer, output))
+
+{
+	uint32_t lp,
+		 blocks;
+
+	unsigned char *p,
+		      decbufr[3];
+
+
+	p = (unsigned char *) input->get(input);
+	blocks = input->size(input) / 4;
+
+	for (lp= 0; lp < blocks; ++lp) {
+		EVP_DecodeBlock(decbufr, p, 4);
+		if ( !output->add(output, decbufr, sizeof(decbufr)) )
+			return false;
+		p += 4;
+	}
+
+	p -= 4;
+	lp = 0;
+	if ( *(p+2) == '=' )
+		++lp;
+	if ( *(p+3) == '=' )
+		++lp;
+	output->shrink(output, lp);
+
+	return true;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function verifies the Base64 object against the OpenSSL
+ * codec.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the object generated the expected results.
+ */
+
+static _Bool verify(void)
+
+{
+	_Bool retn = false;
+
+	char ref[4 * (MAX_VERIFY / 3) + 8];
+
+	uint8_t data[MAX_VERIFY];
+
+	size_t lp,
+	       pos,
+	       split;
+
+	Buffer in   = NULL,
+	       out  = NULL,
+	       part = NULL;
+
+	String str  = NULL,
+	       spart = NULL;
+
+	Base64 base64 = NULL;
+
+
+	INIT(HurdLib, Buffer, in, ERR(goto done));
+	INIT(HurdLib, Buffer, out, ERR(goto done));
+	INIT(HurdLib, Buffer, part, ERR(goto done));
+	INIT(HurdLib, String, str, ERR(goto done));
+	INIT(HurdLib, String, spart, ERR(goto done));
+	INIT(NAAAIM, Base64, base64, ERR(goto done));
+
+	for (lp= 0; lp < sizeof(data); ++lp)
+		data[lp] = random();
+
+	for (lp= 0; lp < sizeof(data); ++lp) {
+		memset(ref, '\0', sizeof(ref));
+		EVP_EncodeBlock((unsigned char *) ref, data, lp);
+
+		/* Whole buffer encoding and decoding. */
+		in->reset(in);
+		if ( !in->add(in, data, lp) )
+			ERR(goto done);
+		str->reset(str);
+		if ( !base64->encode(base64, in, str) )
+			ERR(goto done);
+		if ( (lp > 0) && (strcmp(str->get(str), ref) != 0) ) {
+			fprintf(stdout, "Encode failed, size=%zu\n", lp);
+			goto done;
+		}
+
+		out->reset(out);
+		if ( !base64->decode(base64, str, out) )
+			ERR(goto done);
+		if ( (out->size(out) != lp) || \
+		     ((lp > 0) && (memcmp(out->get(out), data, lp) != 0)) ) {
+			fprintf(stdout, "Decode failed, size=%zu\n", lp);
+			goto done;
+		}
+
+		/* Sectioned encoding and decoding. */
+		split = 1 + (random() % (lp + 1));
+		str->reset(str);
+		for (pos= 0; pos < lp; pos += split) {
+			part->reset(part);
+			if ( !part->add(part, data + pos, \
+					pos + split > lp ? lp - pos : split) )
+				ERR(goto done);
+			if ( !base64->encode_update(base64, part, str) )
+				ERR(goto done);
+		}
+		if ( !base64->encode_final(base64, str) )
+			ERR(goto done);
+		if ( (lp > 0) && (strcmp(str->get(str), ref) != 0) ) {
+			fprintf(stdout, "Update encode failed, size=%zu, "
+				"split=%zu\n", lp, split);
+			goto done;
+		}
+
+		out->reset(out);
+		split = 1 + (random() % (strlen(ref) + 1));
+		for (pos= 0; pos < strlen(ref); pos += split) {
+			spart->reset(spart);
+			if ( !spart->add(spart, ref + pos) )
+				ERR(goto done);
+			if ( pos + split < strlen(ref) )
+				spart->get(spart)[split] = '\0';
+			str->reset(str);
+			if ( !str->add(str, spart->get(spart)) )
+				ERR(goto done);
+			if ( !base64->decode_update(base64, str, out) )
+				ERR(goto done);
+		}
+		if ( !base64->decode_final(base64, out) )
+			ERR(goto done);
+		if ( (out->size(out) != lp) || \
+		     ((lp > 0) && (memcmp(out->get(out), data, lp) != 0)) ) {
+			fprintf(stdout, "Update decode failed, size=%zu, "
+				"split=%zu\n", lp, split);
+			goto done;
+		}
+	}
+
+
+	/* Verify invalid characters are detected at each position. */
+	memset(ref, '\0', sizeof(ref));
+	EVP_EncodeBlock((unsigned char *) ref, data, 96);
+	for (pos= 0; pos < strlen(ref); ++pos) {
+		str->reset(str);
+		if ( !str->add(str, ref) )
+			ERR(goto done);
+		str->get(str)[pos] = (pos % 2) ? '*' : 0x80 | ref[pos];
+
+		WHACK(base64);
+		INIT(NAAAIM, Base64, base64, ERR(goto done));
+		out->reset(out);
+		if ( base64->decode(base64, str, out) ) {
+			fprintf(stdout, "Invalid character accepted, "
+				"position=%zu\n", pos);
+			goto done;
+		}
+	}
+
+	fputs("Base64 codec verified.\n", stdout);
+	retn = true;
+
+
+ done:
+	WHACK(in);
+	WHACK(out);
+	WHACK(part);
+	WHACK(str);
+	WHACK(spart);
+	WHACK(base64);
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function measures the throughput of the legacy and current
+ * implementations for a given input size.
+ *
+ * \param size	The size of the binary input in bytes.
+ *
+ * \param count	The number of iterations to be run.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the benchmark was completed.
+ */
+
+static _Bool benchmark(const size_t size, const unsigned long int count)
+
+{
+	_Bool retn = false;
+
+	unsigned long int lp;
+
+	double mb = (double) size * count / (1024 * 1024);
+
+	struct timespec start;
+
+	Buffer in  = NULL,
+	       out = NULL;
+
+	String str = NULL;
+
+	Base64 base64 = NULL;
+
+
+	INIT(HurdLib, Buffer, in, ERR(goto done));
+	INIT(HurdLib, Buffer, out, ERR(goto done));
+	INIT(HurdLib, String, str, ERR(goto done));
+	INIT(NAAAIM, Base64, base64, ERR(goto done));
+
+	for (lp= 0; lp < size; ++lp) {
+		if ( !in->add(in, (unsigned char *) &lp, 1) )
+			ERR(goto done);
+	}
+	fprintf(stdout, "\n%zu bytes, %lu iterations:\n", size, count);
+
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (lp= 0; lp < count; ++lp) {
+		str->reset(str);
+		if ( !legacy_encode(in, str) )
+			ERR(goto done);
+	}
+	fprintf(stdout, "  legacy encode: %9.1f MiB/s\n", mb / elapsed(&start));
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (lp= 0; lp < count; ++lp) {
+		str->reset(str);
+		if ( !base64->encode(base64, in, str) )
+			ERR(goto done);
+	}
+	fprintf(stdout, "  encode:        %9.1f MiB/s\n", mb / elapsed(&start));
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (lp= 0; lp < count; ++lp) {
+		out->reset(out);
+		if ( !legacy_decode(str, out) )
+			ERR(goto done);
+	}
+	fprintf(stdout, "  legacy decode: %9.1f MiB/s\n", mb / elapsed(&start));
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (lp= 0; lp < count; ++lp) {
+		out->reset(out);
+		if ( !base64->decode(base64, str, out) )
+			ERR(goto done);
+	}
+	fprintf(stdout, "  decode:        %9.1f MiB/s\n", mb / elapsed(&start));
+
+	if ( !in->equal(in, out) ) {
+		fputs("Benchmark output mismatch.\n", stdout);
+		goto done;
+	}
+	retn = true;
+
+
+ done:
+	WHACK(in);
+	WHACK(out);
+	WHACK(str);
+	WHACK(base64);
+
+	return retn;
+}
+
+
+extern int main(int argc, char *argv[])
+
+{
+	int opt,
+	    retn = 1;
+
+	unsigned long int count = 20;
+
+
+	while ( (opt = getopt(argc, argv, "n:")) != EOF )
+		switch ( opt ) {
+			case 'n':
+				count = strtoul(optarg, NULL, 0);
+				break;
+		}
+
+	if ( !verify() )
+		goto done;
+
+	if ( !benchmark(1024, count * 1024) )
+		goto done;
+	if ( !benchmark(1024 * 1024, count) )
+		goto done;
+
+	retn = 0;
+
+
+ done:
+	return retn;
+}
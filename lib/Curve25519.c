@@ -6,6 +6,14 @@
  * The implementation was taken from the 64-bit C based reference
  * implement available from Google code and which serves as the
  * most common reference implementation.
+ *
+ * Sets of key generations and key agreements can be computed with the
+ * batch functions.  On x86 processors which support the AVX2
+ * instruction set these compute four independent scalar
+ * multiplications at a time with a vectorized version of the
+ * Montgomery ladder.  The vectorized version is compiled for AVX2
+ * independently of the build flags and is selected at runtime, the
+ * reference implementation is used otherwise and in enclave builds.
  */
 
 /**************************************************************************
@@ -71,6 +79,17 @@
 #include <stdbool.h>
 #include <string.h>
 
+/*
+ * Runtime instruction set selection requires CPUID and the processor
+ * model data of the compiler runtime, neither of which is available
+ * to SGX enclave or Mini-OS builds.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && \
+	!defined(SRDE_ENCLAVE) && !defined(__MINIOS__)
+#define CURVE25519_X86
+#include <immintrin.h>
+#endif
+
 #include <Origin.h>
 #include <HurdLib.h>
 #include <Buffer.h>
@@ -82,6 +101,12 @@
 /* State extraction macro. */
 #define STATE(var) CO(Curve25519_State, var) = this->state
 
+/*
+ * The smallest group of scalar multiplications which is computed
+ * with the vectorized implementation.
+ */
+#define BATCH_MINIMUM 3
+
 
 /* Verify library/object header file inclusions. */
 #if !defined(NAAAIM_LIBID)
@@ -647,6 +672,489 @@ static void curve25519_donna(uint8_t *mypublic, const uint8_t *secret, \
 }
 
 
+#if defined(CURVE25519_X86)
+/*
+ * The following functions implement a four way vectorized version of
+ * the scalar multiplication.  Field elements are represented in radix
+ * 2^25.5, as ten limbs of alternating 26 and 25 bit size, with each
+ * 64-bit lane of a vector holding the limb of one of four independent
+ * field elements.  The 32x32 bit lane multiplier is used to form the
+ * 64-bit limb products.
+ *
+ * A reduced element has limbs no larger than 2^26 and 2^25 plus a
+ * small carry.  Sums and differences of reduced elements are not
+ * carried and have limbs below 3 * 2^26, which keeps the limbs that
+ * are multiplied by 19 within 32 bits and the accumulated products
+ * within 64 bits.
+ */
+typedef __m256i vlimb;
+typedef vlimb vfelem[10];
+
+
+/**
+ * Internal private function.
+ *
+ * Carry limb i into limb i + 1.
+ */
+
+__attribute__((target("avx2")))
+static inline void force_inline vcarry_limb(vfelem h, const int i)
+
+{
+	const int bits = (i & 1) ? 25 : 26;
+
+	vlimb c = _mm256_srli_epi64(h[i], bits);
+
+
+	h[i]	 = _mm256_and_si256(h[i], _mm256_set1_epi64x((1 << bits) - 1));
+	h[i + 1] = _mm256_add_epi64(h[i + 1], c);
+}
+
+
+/**
+ * Internal private function.
+ *
+ * Reduce the limbs of an element which has been formed from
+ * accumulated products.  The two halves of the element are carried
+ * in parallel.
+ *
+ * Output: reduced form
+ */
+
+__attribute__((target("avx2")))
+static inline void force_inline vcarry(vfelem h)
+
+{
+	vlimb c;
+
+
+	vcarry_limb(h, 0);
+	vcarry_limb(h, 4);
+	vcarry_limb(h, 1);
+	vcarry_limb(h, 5);
+	vcarry_limb(h, 2);
+	vcarry_limb(h, 6);
+	vcarry_limb(h, 3);
+	vcarry_limb(h, 7);
+	vcarry_limb(h, 4);
+	vcarry_limb(h, 8);
+
+	c    = _mm256_srli_epi64(h[9], 25);
+	h[9] = _mm256_and_si256(h[9], _mm256_set1_epi64x(0x1ffffff));
+	h[0] = _mm256_add_epi64(h[0], c);
+	h[0] = _mm256_add_epi64(h[0], _mm256_slli_epi64(c, 1));
+	h[0] = _mm256_add_epi64(h[0], _mm256_slli_epi64(c, 4));
+
+	vcarry_limb(h, 0);
+}
+
+
+/**
+ * Internal private function.
+ *
+ * Sum two numbers: output = a + b
+ */
+
+__attribute__((target("avx2")))
+static inline void force_inline vadd(vfelem output, const vfelem a, \
+				     const vfelem b)
+
+{
+	unsigned int i;
+
+	for (i= 0; i < 10; ++i)
+		output[i] = _mm256_add_epi64(a[i], b[i]);
+}
+
+
+/**
+ * Internal private function.
+ *
+ * Find the difference of two numbers: output = a - b
+ *
+ * A multiple of the prime is added so that the limbs of the result
+ * remain positive.
+ */
+
+__attribute__((target("avx2")))
+static inline void force_inline vsub(vfelem output, const vfelem a, \
+				     const vfelem b)
+
+{
+	unsigned int i;
+
+	const vlimb two_p0   = _mm256_set1_epi64x(0x7ffffda),
+		    two_peven = _mm256_set1_epi64x(0x7fffffe),
+		    two_podd  = _mm256_set1_epi64x(0x3fffffe);
+
+
+	output[0] = _mm256_sub_epi64(_mm256_add_epi64(a[0], two_p0), b[0]);
+	for (i= 1; i < 10; ++i)
+		output[i] = _mm256_sub_epi64(_mm256_add_epi64(a[i], \
+					     (i & 1) ? two_podd : two_peven), b[i]);
+}
+
+
+/**
+ * Internal private function.
+ *
+ * Multiply two numbers: output = in2 * in
+ *
+ * The inputs may be sums or differences of reduced elements, the
+ * output is reduced.
+ */
+
+__attribute__((target("avx2")))
+static void vmul(vfelem output, const vfelem in2, const vfelem in)
+
+{
+	unsigned int i,
+		     j;
+
+	vfelem h,
+	       in2x2,
+	       inx19;
+
+
+	for (i= 0; i < 10; ++i) {
+		in2x2[i] = (i & 1) ? _mm256_add_epi64(in2[i], in2[i]) : in2[i];
+		inx19[i] = _mm256_mul_epu32(in[i], _mm256_set1_epi64x(19));
+		h[i]	 = _mm256_setzero_si256();
+	}
+
+#pragma GCC unroll 10
+	for (i= 0; i < 10; ++i) {
+#pragma GCC unroll 10
+		for (j= 0; j < 10; ++j)
+			h[(i + j) % 10] = _mm256_add_epi64(h[(i + j) % 10], \
+				_mm256_mul_epu32((i & j & 1) ? in2x2[i] : in2[i], \
+						 (i + j >= 10) ? inx19[j] : in[j]));
+	}
+
+	vcarry(h);
+	memcpy(output, h, sizeof(h));
+}
+
+
+/**
+ * Internal private function.
+ *
+ * Square a number: output = in^2
+ *
+ * Each cross product is formed once and doubled.
+ */
+
+__attribute__((target("avx2")))
+static void vsquare(vfelem output, const vfelem in)
+
+{
+	unsigned int i,
+		     j;
+
+	vfelem h,
+	       inx2,
+	       inx4,
+	       inx19;
+
+
+	for (i= 0; i < 10; ++i) {
+		inx2[i]	 = _mm256_add_epi64(in[i], in[i]);
+		inx4[i]	 = _mm256_add_epi64(inx2[i], inx2[i]);
+		inx19[i] = _mm256_mul_epu32(in[i], _mm256_set1_epi64x(19));
+		h[i]	 = _mm256_setzero_si256();
+	}
+
+#pragma GCC unroll 10
+	for (i= 0; i < 10; ++i) {
+#pragma GCC unroll 10
+		for (j= i; j < 10; ++j)
+			h[(i + j) % 10] = _mm256_add_epi64(h[(i + j) % 10], \
+				_mm256_mul_epu32((i == j) ? \
+						 ((i & 1) ? inx2[i] : in[i]) : \
+						 ((i & j & 1) ? inx4[i] : inx2[i]), \
+						 (i + j >= 10) ? inx19[j] : in[j]));
+	}
+
+	vcarry(h);
+	memcpy(output, h, sizeof(h));
+}
+
+
+/**
+ * Internal private function.
+ *
+ * Square a number n times.
+ */
+
+__attribute__((target("avx2")))
+static void vsquare_times(vfelem output, const vfelem in, unsigned int count)
+
+{
+	vsquare(output, in);
+	while ( --count )
+		vsquare(output, output);
+}
+
+
+/**
+ * Internal private function.
+ *
+ * Multiply a number by the curve constant a24: output = 121665 * in
+ */
+
+__attribute__((target("avx2")))
+static inline void force_inline vmul121665(vfelem output, const vfelem in)
+
+{
+	unsigned int i;
+
+	const vlimb a24 = _mm256_set1_epi64x(121665);
+
+
+	for (i= 0; i < 10; ++i)
+		output[i] = _mm256_mul_epu32(in[i], a24);
+	vcarry(output);
+}
+
+
+/**
+ * Internal private function.
+ *
+ * Swap the contents of two elements in each lane whose mask is all
+ * ones without leaking any side-channel information.
+ */
+
+__attribute__((target("avx2")))
+static inline void force_inline vswap_conditional(vfelem a, vfelem b, \
+						  const vlimb swap)
+
+{
+	unsigned int i;
+
+	vlimb x;
+
+
+	for (i= 0; i < 10; ++i) {
+		x    = _mm256_and_si256(swap, _mm256_xor_si256(a[i], b[i]));
+		a[i] = _mm256_xor_si256(a[i], x);
+		b[i] = _mm256_xor_si256(b[i], x);
+	}
+}
+
+
+/**
+ * Internal private function.
+ *
+ * The vectorized equivalent of crecip.
+ */
+
+__attribute__((target("avx2")))
+static void vcrecip(vfelem out, const vfelem z)
+
+{
+	vfelem a,t0,b,c;
+
+	/* 2 */ vsquare_times(a, z, 1); // a = 2
+	/* 8 */ vsquare_times(t0, a, 2);
+	/* 9 */ vmul(b, t0, z); // b = 9
+	/* 11 */ vmul(a, b, a); // a = 11
+	/* 22 */ vsquare_times(t0, a, 1);
+	/* 2^5 - 2^0 = 31 */ vmul(b, t0, b);
+	/* 2^10 - 2^5 */ vsquare_times(t0, b, 5);
+	/* 2^10 - 2^0 */ vmul(b, t0, b);
+	/* 2^20 - 2^10 */ vsquare_times(t0, b, 10);
+	/* 2^20 - 2^0 */ vmul(c, t0, b);
+	/* 2^40 - 2^20 */ vsquare_times(t0, c, 20);
+	/* 2^40 - 2^0 */ vmul(t0, t0, c);
+	/* 2^50 - 2^10 */ vsquare_times(t0, t0, 10);
+	/* 2^50 - 2^0 */ vmul(b, t0, b);
+	/* 2^100 - 2^50 */ vsquare_times(t0, b, 50);
+	/* 2^100 - 2^0 */ vmul(c, t0, b);
+	/* 2^200 - 2^100 */ vsquare_times(t0, c, 100);
+	/* 2^200 - 2^0 */ vmul(t0, t0, c);
+	/* 2^250 - 2^50 */ vsquare_times(t0, t0, 50);
+	/* 2^250 - 2^0 */ vmul(t0, t0, b);
+	/* 2^255 - 2^5 */ vsquare_times(t0, t0, 5);
+	/* 2^255 - 21 */ vmul(out, t0, a);
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function computes four independent scalar multiplications
+ * with a Montgomery ladder which is run in parallel over the four
+ * lanes.  The sequence of operations does not depend on the values of
+ * the secrets.
+ *
+ * \param mypublic	A pointer to the four character buffers which
+ *			will receive key output.
+ *
+ * \param secret	A pointer to the four character buffers
+ *			containing the private key values.
+ *
+ * \param basepoint	A pointer to the four character buffers
+ *			containing the points to be multiplied.
+ *
+ * \return		No return value is defined.
+ */
+
+__attribute__((target("avx2")))
+static void curve25519_donna_x4(uint8_t mypublic[4][32], \
+				uint8_t secret[4][32], \
+				uint8_t basepoint[4][32])
+
+{
+	unsigned int i,
+		     lane;
+
+	int pos;
+
+	uint64_t lanes[10][4];
+
+	limb bp[5];
+
+	vlimb bit,
+	      swap = _mm256_setzero_si256();
+
+	vfelem x1, x2, z2, x3, z3,
+	       a, aa, b, bb, c, d, e, da, cb, t;
+
+
+	/* Expand the points into the lanes. */
+	for (lane= 0; lane < 4; ++lane) {
+		secret[lane][0]	 &= 248;
+		secret[lane][31] &= 127;
+		secret[lane][31] |= 64;
+
+		fexpand(bp, basepoint[lane]);
+		for (i= 0; i < 5; ++i) {
+			lanes[2 * i][lane]     = bp[i] & 0x3ffffff;
+			lanes[2 * i + 1][lane] = bp[i] >> 26;
+		}
+	}
+
+	for (i= 0; i < 10; ++i) {
+		x1[i] = _mm256_loadu_si256((__m256i *) lanes[i]);
+		x3[i] = x1[i];
+		x2[i] = _mm256_setzero_si256();
+		z2[i] = _mm256_setzero_si256();
+		z3[i] = _mm256_setzero_si256();
+	}
+	x2[0] = _mm256_set1_epi64x(1);
+	z3[0] = x2[0];
+
+
+	/* Run the ladder over the bits of the clamped secrets. */
+	for (pos= 254; pos >= 0; --pos) {
+		bit = _mm256_set_epi64x((secret[3][pos >> 3] >> (pos & 7)) & 1, \
+					(secret[2][pos >> 3] >> (pos & 7)) & 1, \
+					(secret[1][pos >> 3] >> (pos & 7)) & 1, \
+					(secret[0][pos >> 3] >> (pos & 7)) & 1);
+		swap = _mm256_xor_si256(swap, bit);
+		swap = _mm256_sub_epi64(_mm256_setzero_si256(), swap);
+		vswap_conditional(x2, x3, swap);
+		vswap_conditional(z2, z3, swap);
+		swap = bit;
+
+		vadd(a, x2, z2);
+		vsquare(aa, a);
+		vsub(b, x2, z2);
+		vsquare(bb, b);
+		vsub(e, aa, bb);
+		vadd(c, x3, z3);
+		vsub(d, x3, z3);
+		vmul(da, d, a);
+		vmul(cb, c, b);
+
+		vadd(t, da, cb);
+		vsquare(x3, t);
+		vsub(t, da, cb);
+		vsquare(t, t);
+		vmul(z3, x1, t);
+
+		vmul(x2, aa, bb);
+		vmul121665(t, e);
+		vadd(t, t, aa);
+		vmul(z2, e, t);
+	}
+
+	swap = _mm256_sub_epi64(_mm256_setzero_si256(), swap);
+	vswap_conditional(x2, x3, swap);
+	vswap_conditional(z2, z3, swap);
+
+
+	/* Compute the affine coordinates and contract each lane. */
+	vcrecip(t, z2);
+	vmul(x1, x2, t);
+
+	for (i= 0; i < 10; ++i)
+		_mm256_storeu_si256((__m256i *) lanes[i], x1[i]);
+	for (lane= 0; lane < 4; ++lane) {
+		for (i= 0; i < 5; ++i)
+			bp[i] = lanes[2 * i][lane] + \
+				(lanes[2 * i + 1][lane] << 26);
+		fcontract(mypublic[lane], bp);
+	}
+
+	memset(lanes, '\0', sizeof(lanes));
+	memset(bp, '\0', sizeof(bp));
+
+	return;
+}
+#endif
+
+
+/**
+ * Internal private function.
+ *
+ * This function computes a group of up to four independent scalar
+ * multiplications.  If the vectorized implementation is available
+ * the group is computed in a single pass with unused lanes filled
+ * from the first member of the group.  Otherwise each member is
+ * computed with the reference implementation.
+ *
+ * \param cnt		The number of members in the group.
+ *
+ * \param mypublic	A pointer to the character buffers which will
+ *			receive key output.
+ *
+ * \param secret	A pointer to the character buffers containing
+ *			the private key values.  The values are clamped
+ *			in place.
+ *
+ * \param basepoint	A pointer to the character buffers containing
+ *			the points to be multiplied.
+ *
+ * \return		No return value is defined.
+ */
+
+static void _multiply_group(const unsigned int cnt, uint8_t mypublic[4][32], \
+			    uint8_t secret[4][32], uint8_t basepoint[4][32])
+
+{
+	unsigned int lp;
+
+
+#if defined(CURVE25519_X86)
+	if ( (cnt >= BATCH_MINIMUM) && __builtin_cpu_supports("avx2") ) {
+		for (lp= cnt; lp < 4; ++lp) {
+			memcpy(secret[lp], secret[0], sizeof(secret[lp]));
+			memcpy(basepoint[lp], basepoint[0], \
+			       sizeof(basepoint[lp]));
+		}
+		curve25519_donna_x4(mypublic, secret, basepoint);
+		return;
+	}
+#endif
+
+	for (lp= 0; lp < cnt; ++lp)
+		curve25519_donna(mypublic[lp], secret[lp], basepoint[lp]);
+
+	return;
+}
+
+
 /**
  * Internal private method.
  *
@@ -862,6 +1370,194 @@ static void whack(CO(Curve25519, this))
 	return;
 }
 
+
+/**
+ * External function.
+ *
+ * This function implements generation of public/private keypairs for
+ * a set of objects.  The result is identical to calling the
+ * ->generate method of each object but the scalar multiplications
+ * are computed in groups of four when the vectorized implementation
+ * is available.
+ *
+ * \param keys	A pointer to the array of objects which are to have
+ *		keypairs generated.
+ *
+ * \param cnt	The number of objects in the array.
+ *
+ * \return	A boolean value is used to indicate the status of key
+ *		generation.  A false value indicates a failure which
+ *		will be secondary to the status of one of the objects.
+ *		A true value indicates all of the keypairs are valid.
+ */
+
+extern _Bool Curve25519_generate_batch(const Curve25519 *keys, \
+				       const unsigned int cnt)
+
+{
+	_Bool retn = false;
+
+	unsigned int lp,
+		     member,
+		     group;
+
+	uint8_t public[4][32],
+		private[4][32],
+		bp[4][32];
+
+	Buffer b;
+
+	Curve25519_State S;
+
+	RandomBuffer rnd = NULL;
+
+
+	INIT(NAAAIM, RandomBuffer, rnd, goto done);
+	memset(bp, '\0', sizeof(bp));
+
+	for (lp= 0; lp < cnt; lp += group) {
+		group = (cnt - lp) < 4 ? (cnt - lp) : 4;
+
+		/* Generate and save the private keys. */
+		if ( !rnd->generate(rnd, group * sizeof(private[0])) )
+			goto done;
+		b = rnd->get_Buffer(rnd);
+		memcpy(private, b->get(b), group * sizeof(private[0]));
+
+		for (member= 0; member < group; ++member) {
+			S = keys[lp + member]->state;
+			if ( S->poisoned )
+				goto done;
+			if ( !S->private->add(S->private, private[member], \
+					      sizeof(private[member])) )
+				goto done;
+			bp[member][0] = 9;
+		}
+
+		/* Generate and save the public keys. */
+		_multiply_group(group, public, private, bp);
+
+		for (member= 0; member < group; ++member) {
+			S = keys[lp + member]->state;
+			if ( !S->public->add(S->public, public[member], \
+					     sizeof(public[member])) )
+				goto done;
+		}
+	}
+
+	retn = true;
+
+
+ done:
+	memset(public, '\0', sizeof(public));
+	memset(private, '\0', sizeof(private));
+
+	WHACK(rnd);
+	return retn;
+}
+
+
+/**
+ * External function.
+ *
+ * This function implements computation of shared secrets for a set
+ * of objects.  The result is identical to calling the ->compute
+ * method of each object with the corresponding public key but the
+ * scalar multiplications are computed in groups of four when the
+ * vectorized implementation is available.  This allows a server to
+ * complete the key agreements for a set of pending connections in
+ * a single pass.
+ *
+ * \param keys		A pointer to the array of objects which are to
+ *			have shared secrets generated.
+ *
+ * \param pubs		A pointer to the array of objects containing
+ *			the public keys which the shared secrets are to
+ *			be generated from.
+ *
+ * \param shared	A pointer to the array of objects into which
+ *			the shared secrets are to be loaded.
+ *
+ * \param cnt		The number of members in each of the arrays.
+ *
+ * \return		A boolean value is used to indicate the status
+ *			of key generation.  A false value indicates a
+ *			failure which will be secondary to input
+ *			parameters or the status of one of the objects,
+ *			the object in error is poisoned.  A true value
+ *			indicates all of the keys are valid.
+ */
+
+extern _Bool Curve25519_compute_batch(const Curve25519 *keys, \
+				      const Buffer *pubs, const Buffer *shared, \
+				      const unsigned int cnt)
+
+{
+	_Bool retn = false;
+
+	unsigned int lp,
+		     member,
+		     group;
+
+	uint8_t output[4][32],
+		private[4][32],
+		public[4][32];
+
+	Buffer pub,
+	       key;
+
+	Curve25519_State S = NULL;
+
+
+	for (lp= 0; lp < cnt; lp += group) {
+		group = (cnt - lp) < 4 ? (cnt - lp) : 4;
+
+		/* Arguement check and load of public/private values. */
+		for (member= 0; member < group; ++member) {
+			S   = keys[lp + member]->state;
+			pub = pubs[lp + member];
+			key = shared[lp + member];
+
+			if ( S->poisoned )
+				goto done;
+			if ( (pub == NULL) || pub->poisoned(pub) || \
+			     (pub->size(pub) != 32) )
+				goto done;
+			if ( (key == NULL) || key->poisoned(key) )
+				goto done;
+
+			memcpy(private[member], S->private->get(S->private), \
+			       sizeof(private[member]));
+			memcpy(public[member], pub->get(pub), \
+			       sizeof(public[member]));
+		}
+
+		_multiply_group(group, output, private, public);
+
+		/* Copy the shared keys to the objects provided. */
+		for (member= 0; member < group; ++member) {
+			S   = keys[lp + member]->state;
+			key = shared[lp + member];
+			if ( !key->add(key, output[member], \
+				       sizeof(output[member])) )
+				goto done;
+		}
+	}
+
+	retn = true;
+
+
+ done:
+	memset(output, '\0', sizeof(output));
+	memset(private, '\0', sizeof(private));
+	memset(public, '\0', sizeof(public));
+
+	if ( !retn && (S != NULL) )
+		S->poisoned = true;
+
+	return retn;
+}
+
 	
 /**
  * External constructor call.
@@ -40,4 +40,11 @@ struct NAAAIM_Curve25519
 
 /* Curve25519 constructor call. */
 extern HCLINK Curve25519 NAAAIM_Curve25519_Init(void);
+
+/* Batched key generation and agreement. */
+extern HCLINK _Bool Curve25519_generate_batch(const Curve25519 *, \
+					      const unsigned int);
+extern HCLINK _Bool Curve25519_compute_batch(const Curve25519 *, \
+					     const Buffer *, const Buffer *, \
+					     const unsigned int);
 #endif
@@ -1,3 +1,13 @@
+/** \file
+ * This file implements a test driver for the Curve25519 object.
+ *
+ * By default a shared secret is generated from two keypairs and the
+ * batch key generation and agreement functions are verified against
+ * the object methods.  The -B option also measures the number of key
+ * agreements per second which the methods and the batch functions
+ * complete on a single processor.
+ */
+
 /**************************************************************************
  * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
  *
@@ -20,13 +30,326 @@
 #include <File.h>
 
 #include <NAAAIM.h>
+#include "RandomBuffer.h"
 #include "Curve25519.h"
 
 
+/* Largest batch size verified and benchmarked. */
+#define MAX_BATCH 16
+
+
+/**
+ * Private function.
+ *
+ * This function returns the number of seconds which have elapsed
+ * since the supplied starting time.
+ *
+ * \param start	A pointer to the structure containing the starting
+ *		time.
+ *
+ * \return	The number of elapsed seconds.
+ */
+
+static double elapsed(const struct timespec *start)
+
+{
+	struct timespec end;
+
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) + \
+		(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function creates the objects used by the batch verification
+ * and benchmark.  Each key is given a generated keypair and each
+ * peer public key is filled with random data, which includes values
+ * which are not valid curve points and values with the most
+ * significant bit set.
+ *
+ * \param keys		A pointer to the array of keys to be created.
+ *
+ * \param pubs		A pointer to the array of peer public keys to
+ *			be created.
+ *
+ * \param shared	A pointer to the array of shared secret objects
+ *			to be created.
+ *
+ * \param cnt		The number of members in the arrays.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the objects were created.
+ */
+
+static _Bool create(Curve25519 *keys, Buffer *pubs, Buffer *shared, \
+		    const unsigned int cnt)
+
+{
+	_Bool retn = false;
+
+	unsigned int lp;
+
+	RandomBuffer rnd = NULL;
+
+
+	INIT(NAAAIM, RandomBuffer, rnd, ERR(goto done));
+
+	for (lp= 0; lp < cnt; ++lp) {
+		INIT(NAAAIM, Curve25519, keys[lp], ERR(goto done));
+		INIT(HurdLib, Buffer, pubs[lp], ERR(goto done));
+		INIT(HurdLib, Buffer, shared[lp], ERR(goto done));
+
+		if ( !keys[lp]->generate(keys[lp]) )
+			ERR(goto done);
+		if ( !rnd->generate(rnd, 32) )
+			ERR(goto done);
+		if ( !pubs[lp]->add_Buffer(pubs[lp], rnd->get_Buffer(rnd)) )
+			ERR(goto done);
+	}
+
+	retn = true;
+
+
+ done:
+	WHACK(rnd);
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function releases the objects used by the batch verification
+ * and benchmark.
+ *
+ * \param keys		A pointer to the array of keys to be released.
+ *
+ * \param pubs		A pointer to the array of peer public keys to
+ *			be released.
+ *
+ * \param shared	A pointer to the array of shared secret objects
+ *			to be released.
+ *
+ * \param cnt		The number of members in the arrays.
+ */
+
+static void release(Curve25519 *keys, Buffer *pubs, Buffer *shared, \
+		    const unsigned int cnt)
+
+{
+	unsigned int lp;
+
+
+	for (lp= 0; lp < cnt; ++lp) {
+		WHACK(keys[lp]);
+		WHACK(pubs[lp]);
+		WHACK(shared[lp]);
+	}
+
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function verifies that the batch functions generate the same
+ * results as the object methods for each batch size.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the batch functions generated the expected results.
+ */
+
+static _Bool verify(void)
+
+{
+	_Bool retn = false;
+
+	unsigned int lp,
+		     cnt;
+
+	Curve25519 keys[MAX_BATCH],
+		   peers[MAX_BATCH];
+
+	Buffer pubs[MAX_BATCH],
+	       shared[MAX_BATCH],
+	       peer_shared[MAX_BATCH],
+	       ref = NULL;
+
+
+	memset(keys, '\0', sizeof(keys));
+	memset(peers, '\0', sizeof(peers));
+	memset(pubs, '\0', sizeof(pubs));
+	memset(shared, '\0', sizeof(shared));
+	memset(peer_shared, '\0', sizeof(peer_shared));
+
+	INIT(HurdLib, Buffer, ref, ERR(goto done));
+
+	for (cnt= 1; cnt <= MAX_BATCH; ++cnt) {
+		if ( !create(keys, pubs, shared, cnt) )
+			ERR(goto done);
+
+		/* Agreement with arbitrary public values. */
+		if ( !Curve25519_compute_batch(keys, pubs, shared, cnt) )
+			ERR(goto done);
+
+		for (lp= 0; lp < cnt; ++lp) {
+			ref->reset(ref);
+			if ( !keys[lp]->compute(keys[lp], pubs[lp], ref) )
+				ERR(goto done);
+			if ( !ref->equal(ref, shared[lp]) ) {
+				fprintf(stdout, "Batch compute failed, "
+					"size=%u, member=%u\n", cnt, lp);
+				goto done;
+			}
+		}
+
+		/* Agreement between batch generated keypairs. */
+		for (lp= 0; lp < cnt; ++lp) {
+			INIT(NAAAIM, Curve25519, peers[lp], ERR(goto done));
+			INIT(HurdLib, Buffer, peer_shared[lp], ERR(goto done));
+			pubs[lp]->reset(pubs[lp]);
+			shared[lp]->reset(shared[lp]);
+		}
+		if ( !Curve25519_generate_batch(peers, cnt) )
+			ERR(goto done);
+
+		for (lp= 0; lp < cnt; ++lp) {
+			if ( !pubs[lp]->add_Buffer(pubs[lp], \
+					peers[lp]->get_public(peers[lp])) )
+				ERR(goto done);
+			ref->reset(ref);
+			if ( !ref->add_Buffer(ref, \
+					      keys[lp]->get_public(keys[lp])) )
+				ERR(goto done);
+			if ( !peers[lp]->compute(peers[lp], ref, \
+						 peer_shared[lp]) )
+				ERR(goto done);
+		}
+		if ( !Curve25519_compute_batch(keys, pubs, shared, cnt) )
+			ERR(goto done);
+
+		for (lp= 0; lp < cnt; ++lp) {
+			if ( !shared[lp]->equal(shared[lp], peer_shared[lp]) ) {
+				fprintf(stdout, "Batch generate failed, "
+					"size=%u, member=%u\n", cnt, lp);
+				goto done;
+			}
+		}
+
+		release(keys, pubs, shared, cnt);
+		for (lp= 0; lp < cnt; ++lp) {
+			WHACK(peers[lp]);
+			WHACK(peer_shared[lp]);
+		}
+	}
+
+	fputs("\nBatch functions verified.\n", stdout);
+	retn = true;
+
+
+ done:
+	release(keys, pubs, shared, MAX_BATCH);
+	for (lp= 0; lp < MAX_BATCH; ++lp) {
+		WHACK(peers[lp]);
+		WHACK(peer_shared[lp]);
+	}
+	WHACK(ref);
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function measures the rate at which key agreements are
+ * completed by the ->compute method and by the batch function for a
+ * range of batch sizes.
+ *
+ * \param count	The number of agreements to be completed for each
+ *		measurement.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the benchmark was completed.
+ */
+
+static _Bool benchmark(const unsigned long int count)
+
+{
+	_Bool retn = false;
+
+	static const unsigned int sizes[] = {1, 2, 3, 4, 8, MAX_BATCH};
+
+	unsigned int lp,
+		     size;
+
+	unsigned long int completed;
+
+	struct timespec start;
+
+	Curve25519 keys[MAX_BATCH];
+
+	Buffer pubs[MAX_BATCH],
+	       shared[MAX_BATCH];
+
+
+	memset(keys, '\0', sizeof(keys));
+	memset(pubs, '\0', sizeof(pubs));
+	memset(shared, '\0', sizeof(shared));
+
+	if ( !create(keys, pubs, shared, MAX_BATCH) )
+		ERR(goto done);
+	fprintf(stdout, "\nKey agreements per second, %lu agreements:\n", \
+		count);
+
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (completed= 0; completed < count; ++completed) {
+		shared[0]->reset(shared[0]);
+		if ( !keys[0]->compute(keys[0], pubs[0], shared[0]) )
+			ERR(goto done);
+	}
+	fprintf(stdout, "  compute:          %9.0f\n", count / elapsed(&start));
+
+	for (size= 0; size < sizeof(sizes) / sizeof(sizes[0]); ++size) {
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (completed= 0; completed < count; \
+		     completed += sizes[size]) {
+			for (lp= 0; lp < sizes[size]; ++lp)
+				shared[lp]->reset(shared[lp]);
+			if ( !Curve25519_compute_batch(keys, pubs, shared, \
+						       sizes[size]) )
+				ERR(goto done);
+		}
+		fprintf(stdout, "  batch size %2u:    %9.0f\n", sizes[size], \
+			completed / elapsed(&start));
+	}
+
+	retn = true;
+
+
+ done:
+	release(keys, pubs, shared, MAX_BATCH);
+
+	return retn;
+}
+
+
 extern int main(int argc, char *argv[])
 
 {
-	_Bool retn = 1;
+	_Bool retn = 1,
+	      bench = false;
+
+	int opt;
+
+	unsigned long int count = 20000;
 
 	Curve25519 ours	  = NULL,
 		   theirs = NULL;
@@ -35,6 +358,17 @@ extern int main(int argc, char *argv[])
 	       shared = NULL;
 
 
+	while ( (opt = getopt(argc, argv, "Bn:")) != EOF )
+		switch ( opt ) {
+			case 'B':
+				bench = true;
+				break;
+			case 'n':
+				count = strtoul(optarg, NULL, 0);
+				break;
+		}
+
+
 	/* Create the public/private keypairs. */
 	INIT(NAAAIM, Curve25519, ours, goto done);
 	fputs("Generate our keypair.\n", stdout);
@@ -65,6 +399,12 @@ extern int main(int argc, char *argv[])
 	fputs("\nTheir key:\n", stdout);
 	shared->print(shared);
 
+	/* Verify and optionally benchmark the batch functions. */
+	if ( !verify() )
+		goto done;
+	if ( bench && !benchmark(count) )
+		goto done;
+
 	retn = 0;
 
 
@@ -83,6 +83,9 @@ struct NAAAIM_Duct_State
 	/* Flag to indicate whether or not reverse DNS lookup is done. */
 	_Bool do_reverse;
 
+	/* Flag to indicate a delay before closing a server connection. */
+	_Bool linger;
+
 	/* Client ip and hostname .*/
 	struct in_addr ipv4;
 	Buffer client;
@@ -118,6 +121,7 @@ static void _init_state(CO(Duct_State, S)) {
 	S->fd		= -1;
 	S->server	= INADDR_ANY;
 	S->do_reverse	= false;
+	S->linger	= true;
 	S->ipv4.s_addr	= 0;
 	S->client       = NULL;
 
@@ -353,6 +357,52 @@ static _Bool init_port(CO(Duct, this), CO(char *, host), int const port)
 }
 
 
+/**
+ * Internal private method.
+ *
+ * This method records the address and name of the client which is
+ * the counter-party to a server connection.
+ *
+ * \param S		A pointer to the state information for a server
+ *			Duct object.
+ *
+ * \param client	A pointer to the address of the client.
+ *
+ * \return		A boolean return value is used to indicate
+ *			whether or not the client information was set.
+ */
+
+static _Bool _set_client(CO(Duct_State, S), const struct sockaddr_in *client)
+
+{
+	char host[256];
+	static const char * const reverse = " [reverse disabled]";
+
+
+	S->ipv4.s_addr = client->sin_addr.s_addr;
+	if ( getnameinfo((struct sockaddr *) client,			    \
+			 sizeof(struct sockaddr), host, sizeof(host), NULL, \
+			 0, S->do_reverse ? 0 : NI_NUMERICHOST) != 0 )
+		ERR(return false);
+	if ( S->client == NULL ) {
+		S->client = HurdLib_Buffer_Init();
+		if ( S->client == NULL )
+			ERR(return false);
+	}
+	else
+		S->client->reset(S->client);
+
+	S->client->add(S->client, (unsigned char *) host, strlen(host));
+	if ( !S->do_reverse )
+		S->client->add(S->client, (unsigned char *) reverse, \
+			       strlen(reverse));
+	if ( !S->client->add(S->client, (unsigned char *) "\0", 1) )
+		ERR(return false);
+
+	return true;
+}
+
+
 /**
  * External public method.
  *
@@ -372,9 +422,6 @@ static _Bool accept_connection(CO(Duct, this))
 
 	_Bool retn = false;
 
-	char host[256];
-	static const char * const reverse = " [reverse disabled]";
-
 	int client_size;
 
 	struct sockaddr_in client;
@@ -392,24 +439,69 @@ static _Bool accept_connection(CO(Duct, this))
 			     (void *) &client_size)) == -1 )
 		ERR(goto done);
 
-	S->ipv4.s_addr = client.sin_addr.s_addr;
-	if ( getnameinfo((struct sockaddr *) &client,			    \
-			 sizeof(struct sockaddr), host, sizeof(host), NULL, \
-			 0, S->do_reverse ? 0 : NI_NUMERICHOST) != 0 )
+	if ( !_set_client(S, &client) )
 		ERR(goto done);
-	if ( S->client == NULL ) {
-		S->client = HurdLib_Buffer_Init();
-		if ( S->client == NULL )
-			ERR(goto done);
-	}
-	else
-		S->client->reset(S->client);
 
-	S->client->add(S->client, (unsigned char *) host, strlen(host));
-	if ( !S->do_reverse )
-		S->client->add(S->client, (unsigned char *) reverse, \
-			       strlen(reverse));
-	if ( !S->client->add(S->client, (unsigned char *) "\0", 1) )
+	retn = true;
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements attaching a connection which was accepted
+ * outside of the object to a server Duct.  This allows a connection
+ * accepted by an event driven listener to be processed by the
+ * standard communications methods.
+ *
+ * Connections attached by this method are closed immediately when
+ * the object is reset or destroyed rather than after the delay used
+ * for connections accepted by the object.
+ *
+ * \param this	The communications object which is to take
+ *		ownership of the connection.
+ *
+ * \param fd	The file descriptor of the connected socket.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the connection was attached.  A true value indicates the
+ *		object is ready to communicate over the connection.
+ */
+
+static _Bool set_connection(CO(Duct, this), const int fd)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	socklen_t client_size;
+
+	struct sockaddr_in client;
+
+
+	if ( S->poisoned )
+		ERR(goto done);
+	if ( (S->type != server) || (S->fd != -1) )
+		ERR(goto done);
+
+	client_size = sizeof(client);
+	memset(&client, '\0', client_size);
+	if ( getpeername(fd, (struct sockaddr *) &client, &client_size) \
+	     == -1 )
+		ERR(goto done);
+
+	S->fd	  = fd;
+	S->linger = false;
+
+	if ( !_set_client(S, &client) )
 		ERR(goto done);
 
 	retn = true;
@@ -520,6 +612,10 @@ static _Bool _receive(CO(Duct, this), CO(Buffer, bufr), size_t outstanding)
 			S->error = errno;
 			ERR(goto done);
 		}
+		if ( amt_read == 0 ) {
+			S->eof = true;
+			goto done;
+		}
 
 		outstanding -= amt_read;
 		if ( !bufr->add(bufr, S->bufr, amt_read) ) {
@@ -744,9 +840,11 @@ static void reset(CO(Duct, this))
 	S->eof = false;
 
 	if ( (S->type == server) && (S->fd != -1) ) {
-		sleep(3);
+		if ( S->linger )
+			sleep(3);
 		close(S->fd);
-		S->fd = -1;
+		S->fd	  = -1;
+		S->linger = true;
 	}
 	return;
 }
@@ -780,7 +878,8 @@ static void whack(CO(Duct, this))
 	if ( S->fd != -1 ) {
 		shutdown(S->fd, SHUT_RDWR);
 		if ( S->type == server ) {
-			sleep(3);
+			if ( S->linger )
+				sleep(3);
 			close(S->fd);
 		}
 	}
@@ -839,6 +938,7 @@ extern Duct NAAAIM_Duct_Init(void)
 
 	this->init_port		= init_port;
 	this->accept_connection	= accept_connection;
+	this->set_connection	= set_connection;
 
 	this->send_Buffer	= send_Buffer;
 	this->receive_Buffer	= receive_Buffer;
@@ -80,6 +80,7 @@ struct NAAAIM_Duct
 	_Bool (*set_server)(const Duct, const char *);
 	_Bool (*init_port)(const Duct, const char *, int);
 	_Bool (*accept_connection)(const Duct);
+	_Bool (*set_connection)(const Duct, const int);
 	_Bool (*init_connection)(const Duct);
 	_Bool (*send_Buffer)(const Duct, const Buffer);
 	_Bool (*receive_Buffer)(const Duct, const Buffer);
@@ -0,0 +1,729 @@
+/** \file
+ * This file contains the implementation of an object which implements
+ * an event driven server for Duct based connections.
+ *
+ * A single thread runs an epoll based event loop which accepts
+ * connections on a non-blocking listening socket and monitors each
+ * accepted connection until the client has sent its first message.
+ * Only then is the connection handed to a pool of worker threads
+ * which carry out the computationally expensive portions of the
+ * connection, such as the PossumPipe host mode handshake.  Clients
+ * which are slow to send, or which never send, do not occupy a
+ * worker and a large number of concurrent connections can be held
+ * by the server without a process or thread per connection.  A
+ * connection handed to a worker carries a receive timeout so that a
+ * client which stalls after its first message releases the worker.
+ *
+ * If the descriptor limit is reached accepting connections is
+ * suspended for DUCTSERVER_ACCEPT_BACKOFF milliseconds, leaving the
+ * clients in the listen backlog of the kernel, rather than spinning
+ * on a listening socket which remains readable.
+ *
+ * The handler which services a connection runs in a worker thread
+ * and may use any of the blocking Duct based objects, for example by
+ * attaching the connection to a PossumPipe with its set_connection
+ * method.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+
+/* Local defines. */
+#define _GNU_SOURCE
+#define MAX_EVENTS 256
+
+
+/* Include files. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+
+#include <Origin.h>
+#include <HurdLib.h>
+
+#include "NAAAIM.h"
+#include "DuctServer.h"
+
+
+/* Verify library/object header file inclusions. */
+#if !defined(NAAAIM_LIBID)
+#error Library identifier not defined.
+#endif
+
+#if !defined(NAAAIM_DuctServer_OBJID)
+#error Object identifier not defined.
+#endif
+
+
+/* Object state extraction macro. */
+#define STATE(var) CO(DuctServer_State, var) = this->state
+
+
+/** DuctServer private state information. */
+struct NAAAIM_DuctServer_State
+{
+	/* The root object. */
+	Origin root;
+
+	/* Library identifier. */
+	uint32_t libid;
+
+	/* Object identifier. */
+	uint32_t objid;
+
+	/* Object status. */
+	_Bool poisoned;
+
+	/* Listening socket, event loop and termination descriptors. */
+	int sockt;
+	int epoll;
+	int stopfd;
+
+	/* Flag indicating accepting connections is suspended. */
+	_Bool suspended;
+
+	/*
+	 * Map, indexed by descriptor, of the connections monitored by
+	 * the event loop for their first message.
+	 */
+	size_t monitored_size;
+	unsigned char *monitored;
+
+	/* Connection handler and its context. */
+	DuctServer_handler handler;
+	void *context;
+
+	/* Worker threads. */
+	unsigned int workers;
+	pthread_t threads[DUCTSERVER_MAX_WORKERS];
+
+	/* Queue of connections ready for a worker. */
+	pthread_mutex_t lock;
+	pthread_cond_t ready;
+	pthread_cond_t space;
+
+	_Bool stopping;
+	unsigned int head;
+	unsigned int count;
+	int queue[DUCTSERVER_QUEUE_SIZE];
+};
+
+
+/**
+ * Internal private method.
+ *
+ * This method is responsible for initializing the NAAAIM_DuctServer_State
+ * structure which holds state information for each instantiated object.
+ *
+ * \param S A pointer to the object containing the state information which
+ *        is to be initialized.
+ */
+
+static void _init_state(CO(DuctServer_State, S))
+
+{
+	S->libid = NAAAIM_LIBID;
+	S->objid = NAAAIM_DuctServer_OBJID;
+
+	S->poisoned = false;
+
+	S->sockt  = -1;
+	S->epoll  = -1;
+	S->stopfd = -1;
+
+	S->suspended	  = false;
+	S->monitored_size = 0;
+	S->monitored	  = NULL;
+
+	S->handler = NULL;
+	S->context = NULL;
+	S->workers = 0;
+
+	S->stopping = false;
+	S->head	    = 0;
+	S->count    = 0;
+
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function implements the worker threads.  Each worker removes
+ * connections from the ready queue and calls the connection handler
+ * for them until the server is stopped and the queue is empty.
+ *
+ * \param arg	A pointer to the state of the server.
+ *
+ * \return	A NULL value is returned.
+ */
+
+static void * _worker(void *arg)
+
+{
+	DuctServer_State S = arg;
+
+	int fd;
+
+
+	while ( true ) {
+		pthread_mutex_lock(&S->lock);
+		while ( (S->count == 0) && !S->stopping )
+			pthread_cond_wait(&S->ready, &S->lock);
+		if ( S->count == 0 ) {
+			pthread_mutex_unlock(&S->lock);
+			break;
+		}
+
+		fd = S->queue[S->head];
+		S->head = (S->head + 1) % DUCTSERVER_QUEUE_SIZE;
+		--S->count;
+		pthread_cond_signal(&S->space);
+		pthread_mutex_unlock(&S->lock);
+
+		S->handler(fd, S->context);
+	}
+
+	return NULL;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function places a connection on the ready queue.  If the
+ * queue is full the event loop waits for a worker to remove a
+ * connection, which leaves additional clients in the listen backlog
+ * of the kernel.
+ *
+ * \param S	A pointer to the state of the server.
+ *
+ * \param fd	The connection to be queued.
+ */
+
+static void _dispatch(CO(DuctServer_State, S), const int fd)
+
+{
+	pthread_mutex_lock(&S->lock);
+	while ( S->count == DUCTSERVER_QUEUE_SIZE )
+		pthread_cond_wait(&S->space, &S->lock);
+
+	S->queue[(S->head + S->count) % DUCTSERVER_QUEUE_SIZE] = fd;
+	++S->count;
+	pthread_cond_signal(&S->ready);
+	pthread_mutex_unlock(&S->lock);
+
+	return;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function accepts all of the pending connections on the
+ * listening socket and adds them to the event loop.  Each connection
+ * is monitored for a single event which indicates the client has
+ * sent data or closed the connection.
+ *
+ * If the descriptor limit has been reached the listening socket is
+ * disarmed and the event loop re-arms it after a backoff interval.
+ *
+ * \param S	A pointer to the state of the server.
+ *
+ * \return	A boolean value is used to indicate whether or not an
+ *		error was encountered on the listening socket.
+ */
+
+static _Bool _accept(CO(DuctServer_State, S))
+
+{
+	int fd;
+
+	size_t size;
+
+	unsigned char *map;
+
+	struct epoll_event event;
+
+
+	while ( true ) {
+		fd = accept4(S->sockt, NULL, NULL, \
+			     SOCK_NONBLOCK | SOCK_CLOEXEC);
+		if ( fd == -1 ) {
+			if ( (errno == EAGAIN) || (errno == EWOULDBLOCK) )
+				return true;
+			if ( (errno == EINTR) || (errno == ECONNABORTED) )
+				continue;
+			if ( (errno == EMFILE) || (errno == ENFILE) ) {
+				memset(&event, '\0', sizeof(event));
+				event.data.fd = S->sockt;
+				if ( epoll_ctl(S->epoll, EPOLL_CTL_MOD, \
+					       S->sockt, &event) == -1 )
+					ERR(return false);
+				S->suspended = true;
+				return true;
+			}
+			ERR(return false);
+		}
+
+		if ( (size_t) fd >= S->monitored_size ) {
+			size = 2 * (fd + 1);
+			if ( (map = realloc(S->monitored, size)) == NULL ) {
+				close(fd);
+				continue;
+			}
+			memset(map + S->monitored_size, '\0', \
+			       size - S->monitored_size);
+			S->monitored	  = map;
+			S->monitored_size = size;
+		}
+
+		memset(&event, '\0', sizeof(event));
+		event.events  = EPOLLIN | EPOLLRDHUP | EPOLLONESHOT;
+		event.data.fd = fd;
+		if ( epoll_ctl(S->epoll, EPOLL_CTL_ADD, fd, &event) == -1 ) {
+			close(fd);
+			continue;
+		}
+		S->monitored[fd] = true;
+	}
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function re-arms the listening socket after accepting
+ * connections was suspended by the descriptor limit.
+ *
+ * \param S	A pointer to the state of the server.
+ *
+ * \return	A boolean value is used to indicate whether or not the
+ *		listening socket was re-armed.
+ */
+
+static _Bool _resume_accept(CO(DuctServer_State, S))
+
+{
+	struct epoll_event event;
+
+
+	memset(&event, '\0', sizeof(event));
+	event.events  = EPOLLIN;
+	event.data.fd = S->sockt;
+	if ( epoll_ctl(S->epoll, EPOLL_CTL_MOD, S->sockt, &event) == -1 )
+		ERR(return false);
+
+	S->suspended = false;
+	return true;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function is called when a monitored connection becomes
+ * readable.  The connection is removed from the event loop, returned
+ * to blocking mode with a receive timeout and handed to the worker
+ * pool.
+ *
+ * \param S	A pointer to the state of the server.
+ *
+ * \param event	A pointer to the event for the connection.
+ */
+
+static void _ready(CO(DuctServer_State, S), const struct epoll_event *event)
+
+{
+	int flags,
+	    fd = event->data.fd;
+
+	struct timeval timeout;
+
+
+	epoll_ctl(S->epoll, EPOLL_CTL_DEL, fd, NULL);
+	S->monitored[fd] = false;
+
+	if ( !(event->events & EPOLLIN) ) {
+		close(fd);
+		return;
+	}
+
+	if ( (flags = fcntl(fd, F_GETFL)) == -1 ) {
+		close(fd);
+		return;
+	}
+	if ( fcntl(fd, F_SETFL, flags & ~O_NONBLOCK) == -1 ) {
+		close(fd);
+		return;
+	}
+
+	memset(&timeout, '\0', sizeof(timeout));
+	timeout.tv_sec = DUCTSERVER_RECEIVE_TIMEOUT;
+	if ( setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, \
+			sizeof(timeout)) == -1 ) {
+		close(fd);
+		return;
+	}
+
+	_dispatch(S, fd);
+	return;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements the initialization of the port which the
+ * server listens on.
+ *
+ * \param this	A pointer to the server whose port is to be
+ *		initialized.
+ *
+ * \param host	The name or address of the interface which the
+ *		server is to listen on.  A NULL value specifies all
+ *		interfaces.
+ *
+ * \param port	The port number which the server is to listen on.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the server is listening for connections.
+ */
+
+static _Bool init_port(CO(DuctServer, this), CO(char *, host), \
+		       const int port)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	int on = 1;
+
+	struct hostent *hdef;
+
+	struct sockaddr_in sdef;
+
+	struct epoll_event event;
+
+
+	if ( S->poisoned )
+		ERR(goto done);
+	if ( S->sockt != -1 )
+		ERR(goto done);
+
+	memset(&sdef, '\0', sizeof(sdef));
+	sdef.sin_family	     = AF_INET;
+	sdef.sin_port	     = htons(port);
+	sdef.sin_addr.s_addr = INADDR_ANY;
+	if ( host != NULL ) {
+		if ( (hdef = gethostbyname2(host, AF_INET)) == NULL )
+			ERR(goto done);
+		memcpy(&sdef.sin_addr.s_addr, hdef->h_addr_list[0], \
+		       sizeof(sdef.sin_addr.s_addr));
+	}
+
+	if ( (S->sockt = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | \
+				SOCK_CLOEXEC, IPPROTO_TCP)) == -1 )
+		ERR(goto done);
+	if ( setsockopt(S->sockt, SOL_SOCKET, SO_REUSEADDR, &on, \
+			sizeof(on)) == -1 )
+		ERR(goto done);
+	if ( bind(S->sockt, (struct sockaddr *) &sdef, sizeof(sdef)) == -1 )
+		ERR(goto done);
+	if ( listen(S->sockt, SOMAXCONN) == -1 )
+		ERR(goto done);
+
+	/* Set up the event loop. */
+	if ( (S->epoll = epoll_create1(EPOLL_CLOEXEC)) == -1 )
+		ERR(goto done);
+	if ( (S->stopfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) == -1 )
+		ERR(goto done);
+
+	memset(&event, '\0', sizeof(event));
+	event.events  = EPOLLIN;
+	event.data.fd = S->sockt;
+	if ( epoll_ctl(S->epoll, EPOLL_CTL_ADD, S->sockt, &event) == -1 )
+		ERR(goto done);
+
+	event.data.fd = S->stopfd;
+	if ( epoll_ctl(S->epoll, EPOLL_CTL_ADD, S->stopfd, &event) == -1 )
+		ERR(goto done);
+
+	retn = true;
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements starting the pool of worker threads which
+ * service connections.
+ *
+ * \param this		A pointer to the server whose workers are to
+ *			be started.
+ *
+ * \param workers	The number of worker threads to start.
+ *
+ * \param handler	The function which is to be called to service
+ *			each connection.
+ *
+ * \param context	A pointer which is passed to the handler.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the workers were started.
+ */
+
+static _Bool start(CO(DuctServer, this), const unsigned int workers, \
+		   DuctServer_handler handler, void *context)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+
+	if ( S->poisoned )
+		ERR(goto done);
+	if ( (S->workers != 0) || (handler == NULL) )
+		ERR(goto done);
+	if ( (workers == 0) || (workers > DUCTSERVER_MAX_WORKERS) )
+		ERR(goto done);
+
+	S->handler = handler;
+	S->context = context;
+
+	while ( S->workers < workers ) {
+		if ( pthread_create(&S->threads[S->workers], NULL, _worker, \
+				    S) != 0 )
+			ERR(goto done);
+		++S->workers;
+	}
+
+	retn = true;
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements the event loop of the server.  The caller
+ * blocks in this method until the stop method is called.
+ *
+ * \param this	A pointer to the server which is to be run.
+ *
+ * \return	A false value is returned if the event loop terminated
+ *		because of an error.  A true value indicates the server
+ *		was stopped.
+ */
+
+static _Bool run(CO(DuctServer, this))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	int lp,
+	    cnt;
+
+	struct epoll_event events[MAX_EVENTS];
+
+
+	if ( S->poisoned )
+		ERR(goto done);
+	if ( (S->epoll == -1) || (S->workers == 0) )
+		ERR(goto done);
+
+	while ( true ) {
+		cnt = epoll_wait(S->epoll, events, MAX_EVENTS, \
+				 S->suspended ? DUCTSERVER_ACCEPT_BACKOFF : -1);
+		if ( cnt == -1 ) {
+			if ( errno == EINTR )
+				continue;
+			ERR(goto done);
+		}
+		if ( (cnt == 0) && S->suspended ) {
+			if ( !_resume_accept(S) )
+				ERR(goto done);
+			continue;
+		}
+
+		for (lp= 0; lp < cnt; ++lp) {
+			if ( events[lp].data.fd == S->stopfd ) {
+				retn = true;
+				goto done;
+			}
+			if ( events[lp].data.fd == S->sockt ) {
+				if ( !_accept(S) )
+					ERR(goto done);
+				continue;
+			}
+			_ready(S, &events[lp]);
+		}
+	}
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements a request for the event loop to terminate.
+ * It may be called from a connection handler or a signal handler.
+ *
+ * \param this	A pointer to the server which is to be stopped.
+ */
+
+static void stop(CO(DuctServer, this))
+
+{
+	STATE(S);
+
+	uint64_t value = 1;
+
+
+	if ( S->stopfd != -1 )
+		write(S->stopfd, &value, sizeof(value));
+	return;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements a destructor for a DuctServer object.
+ * Connections which are queued for a worker are serviced before the
+ * worker threads exit.  Connections which are still monitored by the
+ * event loop because they have not yet sent data are closed.
+ *
+ * \param this	A pointer to the object which is to be destroyed.
+ */
+
+static void whack(CO(DuctServer, this))
+
+{
+	STATE(S);
+
+	unsigned int lp;
+
+	size_t fd;
+
+
+	pthread_mutex_lock(&S->lock);
+	S->stopping = true;
+	pthread_cond_broadcast(&S->ready);
+	pthread_mutex_unlock(&S->lock);
+
+	for (lp= 0; lp < S->workers; ++lp)
+		pthread_join(S->threads[lp], NULL);
+
+	pthread_mutex_destroy(&S->lock);
+	pthread_cond_destroy(&S->ready);
+	pthread_cond_destroy(&S->space);
+
+	if ( S->epoll != -1 )
+		close(S->epoll);
+	if ( S->stopfd != -1 )
+		close(S->stopfd);
+	if ( S->sockt != -1 )
+		close(S->sockt);
+
+	for (fd= 0; fd < S->monitored_size; ++fd) {
+		if ( S->monitored[fd] )
+			close(fd);
+	}
+	free(S->monitored);
+
+	S->root->whack(S->root, this, S);
+	return;
+}
+
+
+/**
+ * External constructor call.
+ *
+ * This function implements a constructor call for a DuctServer object.
+ *
+ * \return	A pointer to the initialized DuctServer.  A null value
+ *		indicates an error was encountered in object generation.
+ */
+
+extern DuctServer NAAAIM_DuctServer_Init(void)
+
+{
+	Origin root;
+
+	DuctServer this = NULL;
+
+	struct HurdLib_Origin_Retn retn;
+
+
+	/* Get the root object. */
+	root = HurdLib_Origin_Init();
+
+	/* Allocate the object and internal state. */
+	retn.object_size  = sizeof(struct NAAAIM_DuctServer);
+	retn.state_size   = sizeof(struct NAAAIM_DuctServer_State);
+	if ( !root->init(root, NAAAIM_LIBID, NAAAIM_DuctServer_OBJID, &retn) )
+		return NULL;
+	this	    	  = retn.object;
+	this->state 	  = retn.state;
+	this->state->root = root;
+
+	/* Initialize object state. */
+	_init_state(this->state);
+
+	pthread_mutex_init(&this->state->lock, NULL);
+	pthread_cond_init(&this->state->ready, NULL);
+	pthread_cond_init(&this->state->space, NULL);
+
+	/* Method initialization. */
+	this->init_port = init_port;
+	this->start	= start;
+
+	this->run  = run;
+	this->stop = stop;
+
+	this->whack = whack;
+
+	return this;
+}
@@ -0,0 +1,75 @@
+/** \file
+ * This file contains the API definitions for an object which
+ * implements an event driven server for Duct based connections.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+
+#ifndef NAAAIM_DuctServer_HEADER
+#define NAAAIM_DuctServer_HEADER
+
+
+/* Number of connections which may be waiting for a worker. */
+#define DUCTSERVER_QUEUE_SIZE 4096
+
+/* Maximum number of worker threads. */
+#define DUCTSERVER_MAX_WORKERS 64
+
+/*
+ * Receive timeout, in seconds, of a connection handed to a worker.
+ * The handler may change it once the client has been authenticated.
+ */
+#define DUCTSERVER_RECEIVE_TIMEOUT 30
+
+/*
+ * Milliseconds that accepting connections is suspended for when the
+ * descriptor limit has been reached.
+ */
+#define DUCTSERVER_ACCEPT_BACKOFF 100
+
+
+/**
+ * Function type for the handler which services a connection.  The
+ * handler is called from a worker thread with the file descriptor
+ * of the connection, which it takes ownership of, and the context
+ * pointer which was registered with the server.  The connection is
+ * in blocking mode with a receive timeout of DUCTSERVER_RECEIVE_TIMEOUT
+ * seconds.
+ */
+typedef void (*DuctServer_handler)(const int, void *);
+
+
+/* Object type definitions. */
+typedef struct NAAAIM_DuctServer * DuctServer;
+
+typedef struct NAAAIM_DuctServer_State * DuctServer_State;
+
+/**
+ * External DuctServer object representation.
+ */
+struct NAAAIM_DuctServer
+{
+	/* External methods. */
+	_Bool (*init_port)(const DuctServer, const char *, const int);
+	_Bool (*start)(const DuctServer, const unsigned int, \
+		       DuctServer_handler, void *);
+
+	_Bool (*run)(const DuctServer);
+	void (*stop)(const DuctServer);
+
+	void (*whack)(const DuctServer);
+
+	/* Private state. */
+	DuctServer_State state;
+};
+
+
+/* DuctServer constructor call. */
+extern HCLINK DuctServer NAAAIM_DuctServer_Init(void);
+#endif
@@ -0,0 +1,408 @@
+/** \file
+ * This file implements a test and load generation driver for the
+ * DuctServer object.
+ *
+ * In server mode (-S) connections are serviced by a DuctServer whose
+ * handler carries out a Curve25519 key exchange with each client.
+ * This is the computationally expensive portion of the PossumPipe
+ * handshake.
+ *
+ * In client mode (-C) the requested number of connections (-n) are
+ * made by a number of concurrent client threads (-c).  The handshake
+ * rate and the distribution of the handshake latencies are reported.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <HurdLib.h>
+#include <Buffer.h>
+
+#include <NAAAIM.h>
+#include "Duct.h"
+#include "Curve25519.h"
+#include "DuctServer.h"
+
+
+#define PORT 11991
+
+
+enum {
+	none,
+	client,
+	server
+} Mode;
+
+/* Server to be stopped when the connection limit is reached. */
+static DuctServer Server = NULL;
+
+/* Number of connections to be served or generated. */
+static unsigned long Count = 0;
+
+static unsigned long Served = 0;
+
+/* Client parameters and results. */
+static char *Host = "127.0.0.1";
+
+static unsigned long Failed = 0;
+
+static unsigned long Completed = 0;
+
+static double *Latency = NULL;
+
+static pthread_mutex_t Connect_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/**
+ * Private function.
+ *
+ * This function returns the number of milliseconds which have elapsed
+ * since the supplied starting time.
+ *
+ * \param start	A pointer to the structure containing the starting
+ *		time.
+ *
+ * \return	The number of elapsed milliseconds.
+ */
+
+static double elapsed_ms(const struct timespec *start)
+
+{
+	struct timespec end;
+
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) * 1e3 + \
+		(end.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function implements the connection handler for the server.
+ * The public key of the client is received, an ephemeral key is
+ * generated and used to compute the shared secret and the public key
+ * is returned to the client.
+ *
+ * \param fd		The file descriptor of the connection.
+ *
+ * \param context	Not used.
+ */
+
+static void handler(const int fd, void *context)
+
+{
+	Buffer bufr   = NULL,
+	       shared = NULL;
+
+	Duct duct = NULL;
+
+	Curve25519 key = NULL;
+
+
+	if ( (duct = NAAAIM_Duct_Init()) == NULL ) {
+		close(fd);
+		goto done;
+	}
+	if ( !duct->init_server(duct) || !duct->set_connection(duct, fd) ) {
+		close(fd);
+		goto done;
+	}
+
+	INIT(HurdLib, Buffer, bufr, goto done);
+	INIT(HurdLib, Buffer, shared, goto done);
+	INIT(NAAAIM, Curve25519, key, goto done);
+
+	if ( !duct->receive_Buffer(duct, bufr) )
+		goto done;
+	if ( !key->generate(key) )
+		goto done;
+	if ( !key->compute(key, bufr, shared) )
+		goto done;
+	duct->send_Buffer(duct, key->get_public(key));
+
+
+ done:
+	WHACK(bufr);
+	WHACK(shared);
+	WHACK(duct);
+	WHACK(key);
+
+	if ( (Count > 0) && (__sync_add_and_fetch(&Served, 1) == Count) )
+		Server->stop(Server);
+
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function implements a client thread.  Each thread makes the
+ * number of connections passed to it and records the latency of
+ * each handshake.
+ *
+ * \param arg	A pointer to the number of connections to be made.
+ *
+ * \return	A NULL value is returned.
+ */
+
+static void * client_thread(void *arg)
+
+{
+	_Bool ok;
+
+	unsigned long lp,
+		      slot,
+		      count = *(unsigned long *) arg;
+
+	struct timespec start;
+
+	Buffer bufr   = NULL,
+	       shared = NULL;
+
+	Duct duct = NULL;
+
+	Curve25519 key = NULL;
+
+
+	for (lp= 0; lp < count; ++lp) {
+		ok = false;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+
+		INIT(HurdLib, Buffer, bufr, goto next);
+		INIT(HurdLib, Buffer, shared, goto next);
+		INIT(NAAAIM, Curve25519, key, goto next);
+		INIT(NAAAIM, Duct, duct, goto next);
+
+		if ( !duct->init_client(duct) )
+			goto next;
+		pthread_mutex_lock(&Connect_lock);
+		ok = duct->init_port(duct, Host, PORT);
+		pthread_mutex_unlock(&Connect_lock);
+		if ( !ok )
+			goto next;
+		ok = false;
+
+		if ( !key->generate(key) )
+			goto next;
+		if ( !duct->send_Buffer(duct, key->get_public(key)) )
+			goto next;
+		if ( !duct->receive_Buffer(duct, bufr) )
+			goto next;
+		if ( !key->compute(key, bufr, shared) )
+			goto next;
+		ok = true;
+
+
+	next:
+		if ( ok ) {
+			slot = __sync_fetch_and_add(&Completed, 1);
+			Latency[slot] = elapsed_ms(&start);
+		}
+		else
+			__sync_add_and_fetch(&Failed, 1);
+
+		WHACK(bufr);
+		WHACK(shared);
+		WHACK(key);
+		WHACK(duct);
+	}
+
+	return NULL;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function is the comparison function used to sort the latency
+ * measurements.
+ */
+
+static int compare(const void *a, const void *b)
+
+{
+	double x = *(const double *) a,
+	       y = *(const double *) b;
+
+
+	return (x > y) - (x < y);
+}
+
+
+/**
+ * Private function.
+ *
+ * This function implements the load generator.
+ *
+ * \param clients	The number of concurrent client threads.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not all of the handshakes were completed.
+ */
+
+static _Bool load(const unsigned long clients)
+
+{
+	_Bool retn = false;
+
+	unsigned long lp,
+		      started = 0,
+		      *shares = NULL;
+
+	double elapsed;
+
+	struct timespec start;
+
+	pthread_t *threads = NULL;
+
+	pthread_attr_t attr;
+
+
+	if ( (clients == 0) || (Count < clients) ) {
+		fputs("Invalid client or connection count.\n", stderr);
+		return false;
+	}
+
+	Latency = calloc(Count, sizeof(double));
+	shares	= calloc(clients, sizeof(unsigned long));
+	threads = calloc(clients, sizeof(pthread_t));
+	if ( (Latency == NULL) || (shares == NULL) || (threads == NULL) )
+		goto done;
+
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, 256 * 1024);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (lp= 0; lp < clients; ++lp) {
+		shares[lp] = Count / clients;
+		if ( lp < (Count % clients) )
+			++shares[lp];
+		if ( pthread_create(&threads[lp], &attr, client_thread, \
+				    &shares[lp]) != 0 ) {
+			fputs("Cannot create client thread.\n", stderr);
+			break;
+		}
+		++started;
+	}
+	for (lp= 0; lp < started; ++lp)
+		pthread_join(threads[lp], NULL);
+	elapsed = elapsed_ms(&start);
+
+	fprintf(stdout, "Clients: %lu, handshakes: %lu, failed: %lu\n", \
+		started, Completed, Failed);
+	if ( Completed == 0 )
+		goto done;
+
+	qsort(Latency, Completed, sizeof(double), compare);
+	fprintf(stdout, "Elapsed: %.3f ms, %.1f handshakes/sec\n", elapsed, \
+		Completed / (elapsed / 1e3));
+	fprintf(stdout, "Latency: p50 %.3f ms, p99 %.3f ms, max %.3f ms\n", \
+		Latency[Completed / 2], Latency[(Completed * 99) / 100],   \
+		Latency[Completed - 1]);
+
+	retn = (Failed == 0) && (started == clients);
+
+
+ done:
+	free(Latency);
+	free(shares);
+	free(threads);
+
+	return retn;
+}
+
+
+extern int main(int argc, char *argv[])
+
+{
+	int opt,
+	    retn = 1;
+
+	unsigned long clients = 1000,
+		      workers = 0;
+
+
+	while ( (opt = getopt(argc, argv, "CSc:h:n:w:")) != EOF )
+		switch ( opt ) {
+			case 'C':
+				Mode = client;
+				break;
+			case 'S':
+				Mode = server;
+				break;
+
+			case 'c':
+				clients = strtoul(optarg, NULL, 0);
+				break;
+			case 'h':
+				Host = optarg;
+				break;
+			case 'n':
+				Count = strtoul(optarg, NULL, 0);
+				break;
+			case 'w':
+				workers = strtoul(optarg, NULL, 0);
+				break;
+		}
+
+	if ( Mode == none ) {
+		fputs("No mode specified.\n", stderr);
+		goto done;
+	}
+	signal(SIGPIPE, SIG_IGN);
+
+
+	if ( Mode == server ) {
+		if ( workers == 0 )
+			workers = sysconf(_SC_NPROCESSORS_ONLN);
+
+		INIT(NAAAIM, DuctServer, Server, ERR(goto done));
+		if ( !Server->init_port(Server, NULL, PORT) ) {
+			fputs("Cannot initialize server port.\n", stderr);
+			goto done;
+		}
+		if ( !Server->start(Server, workers, handler, NULL) ) {
+			fputs("Cannot start workers.\n", stderr);
+			goto done;
+		}
+
+		fprintf(stderr, "Serving with %lu workers.\n", workers);
+		if ( !Server->run(Server) ) {
+			fputs("Server error.\n", stderr);
+			goto done;
+		}
+		fprintf(stdout, "Served %lu connections.\n", Served);
+	}
+
+	if ( Mode == client ) {
+		if ( Count == 0 )
+			Count = 10 * clients;
+		if ( !load(clients) )
+			goto done;
+	}
+
+	retn = 0;
+
+
+ done:
+	WHACK(Server);
+
+	return retn;
+}
@@ -0,0 +1,1230 @@
+/** \file
+ * This file contains the implementation of an object which implements
+ * the event loop used by the orchestrators.  The loop waits for a
+ * small number of descriptors, typically the security event file of
+ * a modeling namespace and a management socket, to become readable,
+ * drains the security event file and issues the control commands
+ * that release the processes that generated the events.
+ *
+ * When the kernel supports it the loop is implemented with an
+ * io_uring instance.  The readiness polls of the watched descriptors
+ * and the control commands that have been queued are submitted with
+ * the same system call that waits for the next event and the reads
+ * of an event file are submitted as a linked batch.  This reduces
+ * the number of system calls needed for each security event from
+ * four or more to a fraction of one when events arrive in bursts.
+ *
+ * If an io_uring instance cannot be created, or its use is not
+ * requested, the loop falls back to an implementation based on the
+ * poll system call with the control commands written immediately.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+
+/* Include files. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/fs.h>
+#include <linux/io_uring.h>
+
+#include <Origin.h>
+#include <HurdLib.h>
+#include <Buffer.h>
+
+#include "NAAAIM.h"
+#include "EventLoop.h"
+
+
+/* Verify library/object header file inclusions. */
+#if !defined(NAAAIM_LIBID)
+#error Library identifier not defined.
+#endif
+
+#if !defined(NAAAIM_EventLoop_OBJID)
+#error Object identifier not defined.
+#endif
+
+
+/* Object state extraction macro. */
+#define STATE(var) CO(EventLoop_State, var) = this->state
+
+/* Size of the buffer used for each security event read. */
+#define RECORD_SIZE 4096
+
+/* Number of reads submitted in each batch when draining a file. */
+#define READ_BATCH 8
+
+/* Minimum number of submission queue entries. */
+#define MIN_ENTRIES 32
+
+/* Request types encoded in the completion user data. */
+#define REQUEST_POLL	1
+#define REQUEST_REMOVE	2
+#define REQUEST_READ	3
+#define REQUEST_WRITE	4
+
+#define USER_DATA(type, generation, index)				\
+	(((uint64_t) (type) << 56) |					\
+	 ((uint64_t) ((generation) & 0xffffff) << 32) | (index))
+#define USER_TYPE(data)		((data) >> 56)
+#define USER_GENERATION(data)	(((data) >> 32) & 0xffffff)
+#define USER_INDEX(data)	((data) & 0xffffffff)
+
+
+/** A descriptor being watched for input. */
+struct watch {
+	int fd;
+	_Bool armed;
+	uint32_t generation;
+	short int revents;
+};
+
+/** A control command waiting to be written. */
+struct write_request {
+	int fd;
+	size_t offset;
+	size_t length;
+};
+
+
+/** EventLoop private state information. */
+struct NAAAIM_EventLoop_State
+{
+	/* The root object. */
+	Origin root;
+
+	/* Library identifier. */
+	uint32_t libid;
+
+	/* Object identifier. */
+	uint32_t objid;
+
+	/* Object status. */
+	_Bool poisoned;
+
+	/* The io_uring descriptor, a value of -1 selects poll. */
+	int ring;
+
+	/* Submission queue. */
+	void *sq_map;
+	size_t sq_map_size;
+	unsigned int *sq_head;
+	unsigned int *sq_tail;
+	unsigned int *sq_mask;
+	unsigned int *sq_array;
+	unsigned int sq_entries;
+	unsigned int to_submit;
+
+	struct io_uring_sqe *sqes;
+	size_t sqes_size;
+
+	/* Completion queue. */
+	void *cq_map;
+	size_t cq_map_size;
+	unsigned int *cq_head;
+	unsigned int *cq_tail;
+	unsigned int *cq_mask;
+	struct io_uring_cqe *cqes;
+
+	/* The descriptors being watched. */
+	struct watch watch[EVENTLOOP_MAX_WATCH];
+
+	/* Buffers and results for the reads of an event file. */
+	unsigned char *slab;
+	int results[READ_BATCH];
+	unsigned int reads;
+
+	/* Flag indicating an event file does not support pread. */
+	_Bool stream;
+	_Bool probed;
+
+	/* Flag indicating reads are to be submitted as non-blocking. */
+	_Bool nowait;
+
+	/* Control commands waiting to be, or being, written. */
+	Buffer wdata;
+	Buffer wlist;
+	size_t wnext;
+	unsigned int writes;
+	int write_error;
+};
+
+
+/**
+ * Internal private method.
+ *
+ * This method is responsible for initializing the NAAAIM_EventLoop_State
+ * structure which holds state information for each instantiated object.
+ *
+ * \param S A pointer to the object containing the state information which
+ *        is to be initialized.
+ */
+
+static void _init_state(CO(EventLoop_State, S))
+
+{
+	unsigned int lp;
+
+
+	S->libid = NAAAIM_LIBID;
+	S->objid = NAAAIM_EventLoop_OBJID;
+
+	S->poisoned = false;
+
+	S->ring	       = -1;
+	S->sq_map      = MAP_FAILED;
+	S->sq_map_size = 0;
+	S->cq_map      = MAP_FAILED;
+	S->cq_map_size = 0;
+	S->sqes	       = MAP_FAILED;
+	S->sqes_size   = 0;
+	S->to_submit   = 0;
+
+	for (lp= 0; lp < EVENTLOOP_MAX_WATCH; ++lp) {
+		S->watch[lp].fd		= -1;
+		S->watch[lp].armed	= false;
+		S->watch[lp].generation = 0;
+		S->watch[lp].revents	= 0;
+	}
+
+	S->slab	  = NULL;
+	S->reads  = 0;
+	S->stream = false;
+	S->probed = false;
+	S->nowait = true;
+
+	S->wdata       = NULL;
+	S->wlist       = NULL;
+	S->wnext       = 0;
+	S->writes      = 0;
+	S->write_error = 0;
+
+	return;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function returns the next submission queue entry.  If the
+ * submission queue is full the pending entries are submitted to
+ * make room.
+ *
+ * \param S	A pointer to the state of the object that is
+ *		requesting the entry.
+ *
+ * \return	A pointer to the cleared entry is returned.  A NULL
+ *		value indicates the queue could not be submitted.
+ */
+
+static struct io_uring_sqe *_get_sqe(CO(EventLoop_State, S))
+
+{
+	int rc;
+
+	unsigned int tail = *S->sq_tail,
+		     index;
+
+	struct io_uring_sqe *sqe;
+
+
+	if ( (tail - __atomic_load_n(S->sq_head, __ATOMIC_ACQUIRE)) == \
+	     S->sq_entries ) {
+		rc = syscall(__NR_io_uring_enter, S->ring, S->to_submit, 0, \
+			     0, NULL, 0);
+		if ( rc < 0 )
+			return NULL;
+		S->to_submit -= rc;
+	}
+
+	index = tail & *S->sq_mask;
+	sqe   = &S->sqes[index];
+	memset(sqe, '\0', sizeof(*sqe));
+
+	S->sq_array[index] = index;
+	__atomic_store_n(S->sq_tail, tail + 1, __ATOMIC_RELEASE);
+	++S->to_submit;
+
+	return sqe;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function submits the pending submission queue entries and
+ * optionally waits for completions.
+ *
+ * \param S		A pointer to the state of the object whose
+ *			entries are to be submitted.
+ *
+ * \param wait		The number of completions to wait for.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the submission succeeded.  The errno
+ *			variable holds the cause of a failure.
+ */
+
+static _Bool _enter(CO(EventLoop_State, S), const unsigned int wait)
+
+{
+	int rc;
+
+
+	rc = syscall(__NR_io_uring_enter, S->ring, S->to_submit, wait, \
+		     wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+	if ( rc < 0 )
+		return false;
+
+	S->to_submit -= rc;
+	return true;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function processes the entries in the completion queue.
+ *
+ * \param S	A pointer to the state of the object whose completions
+ *		are to be processed.
+ *
+ * \return	The number of completions that were processed.
+ */
+
+static unsigned int _reap(CO(EventLoop_State, S))
+
+{
+	unsigned int head = *S->cq_head,
+		     index,
+		     cnt = 0;
+
+	uint64_t data;
+
+	struct io_uring_cqe *cqe;
+
+	struct watch *wp;
+
+	struct write_request *wr;
+
+
+	while ( head != __atomic_load_n(S->cq_tail, __ATOMIC_ACQUIRE) ) {
+		cqe   = &S->cqes[head & *S->cq_mask];
+		data  = cqe->user_data;
+		index = USER_INDEX(data);
+
+		switch ( USER_TYPE(data) ) {
+			case REQUEST_POLL:
+				wp = &S->watch[index];
+				if ( USER_GENERATION(data) != \
+				     (wp->generation & 0xffffff) )
+					break;
+				wp->armed   = false;
+				wp->revents = cqe->res < 0 ? POLLERR : cqe->res;
+				break;
+
+			case REQUEST_READ:
+				S->results[index] = cqe->res;
+				--S->reads;
+				break;
+
+			case REQUEST_WRITE:
+				wr = (struct write_request *) \
+					S->wlist->get(S->wlist);
+				wr += index;
+				if ( cqe->res < 0 )
+					S->write_error = -cqe->res;
+				else if ( (size_t) cqe->res != wr->length )
+					S->write_error = EIO;
+				--S->writes;
+				break;
+		}
+
+		++head;
+		++cnt;
+	}
+
+	__atomic_store_n(S->cq_head, head, __ATOMIC_RELEASE);
+	return cnt;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function places the control commands that have been queued
+ * since the last submission into the submission queue.
+ *
+ * \param S	A pointer to the state of the object whose commands
+ *		are to be queued.
+ *
+ * \return	A boolean value is returned to indicate whether or
+ *		not the commands were queued.
+ */
+
+static _Bool _queue_writes(CO(EventLoop_State, S))
+
+{
+	size_t cnt = S->wlist->size(S->wlist) / sizeof(struct write_request);
+
+	struct io_uring_sqe *sqe;
+
+	struct write_request *wr;
+
+
+	while ( S->wnext < cnt ) {
+		if ( (sqe = _get_sqe(S)) == NULL )
+			return false;
+
+		wr = (struct write_request *) S->wlist->get(S->wlist);
+		wr += S->wnext;
+
+		sqe->opcode    = IORING_OP_WRITE;
+		sqe->fd	       = wr->fd;
+		sqe->addr      = (uintptr_t) (S->wdata->get(S->wdata) + \
+					      wr->offset);
+		sqe->len       = wr->length;
+		sqe->off       = (uint64_t) -1;
+		sqe->user_data = USER_DATA(REQUEST_WRITE, 0, S->wnext);
+
+		++S->wnext;
+		++S->writes;
+	}
+
+	return true;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function waits for the control commands that have been
+ * submitted to complete and releases the memory that held them.
+ *
+ * \param S	A pointer to the state of the object whose commands
+ *		are to be completed.
+ *
+ * \return	A boolean value is returned to indicate whether or
+ *		not the commands were completed.
+ */
+
+static _Bool _settle(CO(EventLoop_State, S))
+
+{
+	while ( S->writes > 0 ) {
+		if ( !_enter(S, 1) && (errno != EINTR) )
+			return false;
+		_reap(S);
+	}
+
+	S->wdata->reset(S->wdata);
+	S->wlist->reset(S->wlist);
+	S->wnext = 0;
+
+	return true;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function attempts to create the io_uring instance used by
+ * the event loop.
+ *
+ * \param S		A pointer to the state of the object that the
+ *			ring is to be created for.
+ *
+ * \param entries	The number of submission queue entries to be
+ *			requested.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not a ring was created.
+ */
+
+static _Bool _setup_ring(CO(EventLoop_State, S), const unsigned int entries)
+
+{
+#if defined(__NR_io_uring_setup)
+	_Bool retn = false;
+
+	uint8_t *sq,
+		*cq;
+
+	struct io_uring_params params;
+
+
+	memset(&params, '\0', sizeof(params));
+	S->ring = syscall(__NR_io_uring_setup, entries, &params);
+	if ( S->ring < 0 )
+		goto done;
+	if ( !(params.features & IORING_FEAT_NODROP) || \
+	     !(params.features & IORING_FEAT_RW_CUR_POS) )
+		goto done;
+
+	S->sq_map_size = params.sq_off.array + \
+		params.sq_entries * sizeof(unsigned int);
+	S->cq_map_size = params.cq_off.cqes + \
+		params.cq_entries * sizeof(struct io_uring_cqe);
+	if ( params.features & IORING_FEAT_SINGLE_MMAP ) {
+		if ( S->cq_map_size > S->sq_map_size )
+			S->sq_map_size = S->cq_map_size;
+		S->cq_map_size = 0;
+	}
+
+	S->sq_map = mmap(NULL, S->sq_map_size, PROT_READ | PROT_WRITE, \
+			 MAP_SHARED | MAP_POPULATE, S->ring,	       \
+			 IORING_OFF_SQ_RING);
+	if ( S->sq_map == MAP_FAILED )
+		goto done;
+
+	if ( S->cq_map_size == 0 )
+		S->cq_map = S->sq_map;
+	else {
+		S->cq_map = mmap(NULL, S->cq_map_size,			\
+				 PROT_READ | PROT_WRITE,		\
+				 MAP_SHARED | MAP_POPULATE, S->ring,	\
+				 IORING_OFF_CQ_RING);
+		if ( S->cq_map == MAP_FAILED )
+			goto done;
+	}
+
+	S->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+	S->sqes = mmap(NULL, S->sqes_size, PROT_READ | PROT_WRITE, \
+		       MAP_SHARED | MAP_POPULATE, S->ring, IORING_OFF_SQES);
+	if ( S->sqes == MAP_FAILED )
+		goto done;
+
+	sq = S->sq_map;
+	S->sq_head    = (unsigned int *) (sq + params.sq_off.head);
+	S->sq_tail    = (unsigned int *) (sq + params.sq_off.tail);
+	S->sq_mask    = (unsigned int *) (sq + params.sq_off.ring_mask);
+	S->sq_array   = (unsigned int *) (sq + params.sq_off.array);
+	S->sq_entries = params.sq_entries;
+
+	cq = S->cq_map;
+	S->cq_head = (unsigned int *) (cq + params.cq_off.head);
+	S->cq_tail = (unsigned int *) (cq + params.cq_off.tail);
+	S->cq_mask = (unsigned int *) (cq + params.cq_off.ring_mask);
+	S->cqes	   = (struct io_uring_cqe *) (cq + params.cq_off.cqes);
+
+	retn = true;
+
+
+ done:
+	if ( !retn && (S->ring >= 0) ) {
+		if ( S->sqes != MAP_FAILED )
+			munmap(S->sqes, S->sqes_size);
+		if ( (S->cq_map != MAP_FAILED) && (S->cq_map != S->sq_map) )
+			munmap(S->cq_map, S->cq_map_size);
+		if ( S->sq_map != MAP_FAILED )
+			munmap(S->sq_map, S->sq_map_size);
+
+		S->sqes	  = MAP_FAILED;
+		S->cq_map = MAP_FAILED;
+		S->sq_map = MAP_FAILED;
+
+		close(S->ring);
+		S->ring = -1;
+	}
+
+	return retn;
+#else
+	return false;
+#endif
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements the initialization of the event loop.
+ *
+ * \param this		A pointer to the object which is to be
+ *			initialized.
+ *
+ * \param entries	The number of requests that can be queued to
+ *			the io_uring instance.
+ *
+ * \param use_poll	A flag used to indicate that the loop should
+ *			use the poll implementation even if the kernel
+ *			supports io_uring.
+ *
+ * \return		A boolean value is used to indicate whether
+ *			or not the loop was initialized.  A false
+ *			value indicates an error while a true value
+ *			indicates the loop is ready for use.
+ */
+
+static _Bool init(CO(EventLoop, this), const unsigned int entries, \
+		  const _Bool use_poll)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+
+	if ( S->poisoned )
+		ERR(goto done);
+
+	if ( (S->slab = malloc(READ_BATCH * RECORD_SIZE)) == NULL )
+		ERR(goto done);
+
+	if ( !use_poll )
+		_setup_ring(S, entries < MIN_ENTRIES ? MIN_ENTRIES : entries);
+	retn = true;
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method sets the file descriptor that is watched for input in
+ * one of the slots of the event loop.
+ *
+ * \param this	A pointer to the object whose descriptor is to be
+ *		set.
+ *
+ * \param slot	The slot number of the descriptor.
+ *
+ * \param fd	The file descriptor to be watched.  A value of -1
+ *		stops watching the slot.
+ *
+ * \return	A boolean value is used to indicate whether or not
+ *		the descriptor was set.
+ */
+
+static _Bool watch(CO(EventLoop, this), const unsigned int slot, \
+		   const int fd)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	struct watch *wp;
+
+	struct io_uring_sqe *sqe;
+
+
+	if ( S->poisoned )
+		ERR(goto done);
+	if ( slot >= EVENTLOOP_MAX_WATCH )
+		ERR(goto done);
+
+	wp = &S->watch[slot];
+	if ( (S->ring >= 0) && wp->armed ) {
+		if ( (sqe = _get_sqe(S)) == NULL )
+			ERR(goto done);
+
+		sqe->opcode    = IORING_OP_POLL_REMOVE;
+		sqe->addr      = USER_DATA(REQUEST_POLL, wp->generation, \
+					   slot);
+		sqe->user_data = USER_DATA(REQUEST_REMOVE, 0, slot);
+		wp->armed = false;
+	}
+
+	++wp->generation;
+	wp->fd	    = fd;
+	wp->revents = 0;
+	retn = true;
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method waits for one or more of the watched descriptors to
+ * have input available.  Control commands that have been queued
+ * are written before the method returns.
+ *
+ * \param this	A pointer to the object which is to wait.
+ *
+ * \return	The number of descriptors with events is returned.  A
+ *		negative value indicates an error with the errno
+ *		variable set to the cause, EINTR if the wait was
+ *		interrupted by a signal.
+ */
+
+static int wait(CO(EventLoop, this))
+
+{
+	STATE(S);
+
+	int retn = -1;
+
+	unsigned int lp,
+		     cnt;
+
+	nfds_t nfds = 0;
+
+	struct pollfd poll_data[EVENTLOOP_MAX_WATCH];
+
+	struct watch *wp;
+
+	struct io_uring_sqe *sqe;
+
+
+	if ( S->poisoned ) {
+		errno = EINVAL;
+		return -1;
+	}
+
+	for (lp= 0; lp < EVENTLOOP_MAX_WATCH; ++lp)
+		S->watch[lp].revents = 0;
+
+
+	/* Poll implementation. */
+	if ( S->ring < 0 ) {
+		for (lp= 0; lp < EVENTLOOP_MAX_WATCH; ++lp) {
+			if ( S->watch[lp].fd < 0 )
+				continue;
+			poll_data[nfds].fd	= S->watch[lp].fd;
+			poll_data[nfds].events	= POLLIN;
+			poll_data[nfds].revents = 0;
+			++nfds;
+		}
+
+		if ( (retn = poll(poll_data, nfds, -1)) <= 0 )
+			return retn;
+
+		for (lp= 0, nfds= 0; lp < EVENTLOOP_MAX_WATCH; ++lp) {
+			if ( S->watch[lp].fd < 0 )
+				continue;
+			S->watch[lp].revents = poll_data[nfds++].revents;
+		}
+		return retn;
+	}
+
+
+	/* Arm the watched descriptors and queue the control commands. */
+	for (lp= 0; lp < EVENTLOOP_MAX_WATCH; ++lp) {
+		wp = &S->watch[lp];
+		if ( (wp->fd < 0) || wp->armed )
+			continue;
+
+		if ( (sqe = _get_sqe(S)) == NULL )
+			return -1;
+		sqe->opcode	   = IORING_OP_POLL_ADD;
+		sqe->fd		   = wp->fd;
+		sqe->poll32_events = POLLIN;
+		sqe->user_data	   = USER_DATA(REQUEST_POLL, wp->generation, \
+					       lp);
+		wp->armed = true;
+	}
+
+	if ( !_queue_writes(S) )
+		return -1;
+
+
+	/*
+	 * Submit the requests and wait until a descriptor is ready
+	 * and the control commands are complete.  A wakeup without a
+	 * completion is the result of a signal.
+	 */
+	while ( true ) {
+		if ( !_enter(S, 1) )
+			return -1;
+		if ( _reap(S) == 0 ) {
+			errno = EINTR;
+			return -1;
+		}
+
+		if ( S->writes > 0 )
+			continue;
+		S->wdata->reset(S->wdata);
+		S->wlist->reset(S->wlist);
+		S->wnext = 0;
+
+		for (lp= 0, cnt= 0; lp < EVENTLOOP_MAX_WATCH; ++lp) {
+			if ( S->watch[lp].revents != 0 )
+				++cnt;
+		}
+		if ( cnt > 0 )
+			return cnt;
+	}
+}
+
+
+/**
+ * External public method.
+ *
+ * This method returns the events that were detected on a watched
+ * descriptor by the last call to the ->wait method.
+ *
+ * \param this	A pointer to the object being interrogated.
+ *
+ * \param slot	The slot number of the descriptor.
+ *
+ * \return	The poll events of the descriptor are returned.
+ */
+
+static short int revents(CO(EventLoop, this), const unsigned int slot)
+
+{
+	STATE(S);
+
+
+	if ( slot >= EVENTLOOP_MAX_WATCH )
+		return 0;
+	return S->watch[slot].revents;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function tests whether or not a descriptor without a file
+ * position has input available, so that a read of a blocking pipe
+ * does not wait for input that will not arrive until the events
+ * that have been read are processed.
+ *
+ * \param fd	The descriptor to be tested.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the descriptor can be read without blocking.
+ */
+
+static _Bool _stream_ready(const int fd)
+
+{
+	struct pollfd poll_data;
+
+
+	poll_data.fd	  = fd;
+	poll_data.events  = POLLIN;
+	poll_data.revents = 0;
+
+	return poll(&poll_data, 1, 0) > 0;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method reads the security event descriptions that are
+ * available from a TSEM event file.  Each read is done at offset
+ * zero of the file, which returns the next event, so the file does
+ * not need to be repositioned between events.  A descriptor that
+ * does not support positioned reads, such as the pipe used by the
+ * replay harness in place of a TSEM event file, is read until no
+ * further input is available.
+ *
+ * \param this	A pointer to the object which is to read the
+ *		events.
+ *
+ * \param fd	The descriptor of the event file.
+ *
+ * \param bufr	The object which the event descriptions are to be
+ *		added to.
+ *
+ * \return	A boolean value is used to indicate the status of the
+ *		read.  A false value indicates an error with the errno
+ *		variable set to the cause while a true value indicates
+ *		the available events were added to the buffer.
+ */
+
+static _Bool drain(CO(EventLoop, this), const int fd, CO(Buffer, bufr))
+
+{
+	STATE(S);
+
+	_Bool more = true;
+
+	int rc;
+
+	unsigned int lp;
+
+	struct io_uring_sqe *sqe;
+
+
+	if ( S->poisoned ) {
+		errno = EINVAL;
+		return false;
+	}
+
+
+	/*
+	 * A descriptor without a file position is read directly
+	 * since a pipe cannot be read from the ring without the
+	 * read waiting for input.
+	 */
+	if ( (S->ring >= 0) && !S->probed ) {
+		S->stream = (lseek(fd, 0, SEEK_CUR) == -1) && \
+			(errno == ESPIPE);
+		S->probed = true;
+	}
+
+
+	/* Poll implementation. */
+	if ( (S->ring < 0) || S->stream ) {
+		while ( true ) {
+			if ( S->stream ) {
+				if ( !_stream_ready(fd) )
+					return true;
+				rc = read(fd, S->slab, RECORD_SIZE);
+			} else {
+				rc = pread(fd, S->slab, RECORD_SIZE, 0);
+				if ( (rc < 0) && (errno == ESPIPE) ) {
+					S->stream = true;
+					continue;
+				}
+			}
+
+			if ( rc == 0 )
+				return true;
+			if ( rc < 0 )
+				return (errno == ENODATA) || (errno == EAGAIN);
+			if ( !bufr->add(bufr, S->slab, rc) )
+				return false;
+		}
+	}
+
+
+	/*
+	 * Submit the reads as a chain that executes in order and
+	 * continue with another chain if the last read returned an
+	 * event.
+	 */
+	while ( more ) {
+		for (lp= 0; lp < READ_BATCH; ++lp) {
+			if ( (sqe = _get_sqe(S)) == NULL )
+				return false;
+
+			sqe->opcode    = IORING_OP_READ;
+			sqe->fd	       = fd;
+			sqe->addr      = (uintptr_t) (S->slab + \
+						      lp * RECORD_SIZE);
+			sqe->len       = RECORD_SIZE;
+			sqe->off       = 0;
+			sqe->rw_flags  = S->nowait ? RWF_NOWAIT : 0;
+			sqe->user_data = USER_DATA(REQUEST_READ, 0, lp);
+			if ( lp < (READ_BATCH - 1) )
+				sqe->flags = IOSQE_IO_HARDLINK;
+
+			S->results[lp] = 0;
+			++S->reads;
+		}
+
+		while ( S->reads > 0 ) {
+			if ( !_enter(S, S->reads) && (errno != EINTR) )
+				return false;
+			_reap(S);
+		}
+
+		/*
+		 * A file that does not support non-blocking reads is
+		 * read from a blocking context by the kernel.
+		 */
+		if ( S->results[0] == -EOPNOTSUPP && S->nowait ) {
+			S->nowait = false;
+			continue;
+		}
+
+		for (lp= 0; lp < READ_BATCH; ++lp) {
+			rc = S->results[lp];
+			if ( rc > 0 ) {
+				if ( !bufr->add(bufr, S->slab + \
+						lp * RECORD_SIZE, rc) )
+					return false;
+				continue;
+			}
+			if ( (rc == 0) || (rc == -ENODATA) || \
+			     (rc == -EAGAIN) )
+				continue;
+
+			errno = -rc;
+			return false;
+		}
+		more = S->results[READ_BATCH - 1] > 0;
+	}
+
+	return true;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method queues a control command to be written to a
+ * descriptor.  With the io_uring implementation the commands are
+ * written as a batch by the next call to the ->wait or ->flush
+ * methods and a failure is reported by the ->write_error method.
+ * With the poll implementation the command is written immediately.
+ *
+ * \param this	A pointer to the object which is to write the
+ *		command.
+ *
+ * \param fd	The descriptor the command is to be written to.
+ *
+ * \param data	A pointer to the command.
+ *
+ * \param size	The length of the command.
+ *
+ * \return	A boolean value is used to indicate whether or not
+ *		the command was queued, or with the poll
+ *		implementation, written.
+ */
+
+static _Bool queue_write(CO(EventLoop, this), const int fd, \
+			 CO(unsigned char *, data), const size_t size)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	ssize_t rc;
+
+	struct write_request wr;
+
+
+	if ( S->poisoned ) {
+		errno = EINVAL;
+		return false;
+	}
+
+	if ( S->ring < 0 ) {
+		if ( (rc = write(fd, data, size)) < 0 )
+			return false;
+		if ( (size_t) rc != size ) {
+			errno = EIO;
+			return false;
+		}
+		return true;
+	}
+
+	if ( (S->writes > 0) && !_settle(S) )
+		ERR(goto done);
+
+	wr.fd	  = fd;
+	wr.offset = S->wdata->size(S->wdata);
+	wr.length = size;
+
+	if ( !S->wdata->add(S->wdata, data, size) )
+		ERR(goto done);
+	if ( !S->wlist->add(S->wlist, (unsigned char *) &wr, sizeof(wr)) )
+		ERR(goto done);
+	retn = true;
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method writes the control commands that have been queued
+ * and waits for the writes to complete.
+ *
+ * \param this	A pointer to the object whose commands are to be
+ *		written.
+ *
+ * \return	A boolean value is used to indicate whether or not
+ *		the commands were written.
+ */
+
+static _Bool flush(CO(EventLoop, this))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+
+	if ( S->poisoned )
+		ERR(goto done);
+	if ( S->ring < 0 )
+		return true;
+
+	if ( !_queue_writes(S) )
+		ERR(goto done);
+	if ( !_settle(S) )
+		ERR(goto done);
+	retn = true;
+
+
+ done:
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method returns, and clears, the error status of the queued
+ * control command writes.
+ *
+ * \param this	A pointer to the object being interrogated.
+ *
+ * \return	The errno value of the last write that failed is
+ *		returned.  A value of zero indicates all of the
+ *		writes succeeded.
+ */
+
+static int write_error(CO(EventLoop, this))
+
+{
+	STATE(S);
+
+	int retn = S->write_error;
+
+
+	S->write_error = 0;
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method returns whether or not the loop is implemented with
+ * an io_uring instance.
+ *
+ * \param this	A pointer to the object being interrogated.
+ *
+ * \return	A boolean value is returned that is true if io_uring
+ *		is being used and false if poll is being used.
+ */
+
+static _Bool uses_ring(CO(EventLoop, this))
+
+{
+	STATE(S);
+
+	return S->ring >= 0;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements a destructor for an EventLoop object.
+ *
+ * \param this	A pointer to the object which is to be destroyed.
+ */
+
+static void whack(CO(EventLoop, this))
+
+{
+	STATE(S);
+
+
+	if ( S->ring >= 0 ) {
+		if ( !S->poisoned ) {
+			_queue_writes(S);
+			_settle(S);
+		}
+
+		munmap(S->sqes, S->sqes_size);
+		if ( S->cq_map != S->sq_map )
+			munmap(S->cq_map, S->cq_map_size);
+		munmap(S->sq_map, S->sq_map_size);
+		close(S->ring);
+	}
+
+	free(S->slab);
+	WHACK(S->wdata);
+	WHACK(S->wlist);
+
+	S->root->whack(S->root, this, S);
+	return;
+}
+
+
+/**
+ * External constructor call.
+ *
+ * This function implements a constructor call for an EventLoop object.
+ *
+ * \return	A pointer to the initialized EventLoop.  A null value
+ *		indicates an error was encountered in object generation.
+ */
+
+extern EventLoop NAAAIM_EventLoop_Init(void)
+
+{
+	Origin root;
+
+	EventLoop this = NULL;
+
+	struct HurdLib_Origin_Retn retn;
+
+
+	/* Get the root object. */
+	root = HurdLib_Origin_Init();
+
+	/* Allocate the object and internal state. */
+	retn.object_size  = sizeof(struct NAAAIM_EventLoop);
+	retn.state_size   = sizeof(struct NAAAIM_EventLoop_State);
+	if ( !root->init(root, NAAAIM_LIBID, NAAAIM_EventLoop_OBJID, &retn) )
+		return NULL;
+	this	    	  = retn.object;
+	this->state 	  = retn.state;
+	this->state->root = root;
+
+	/* Initialize object state. */
+	_init_state(this->state);
+
+	/* Initialize aggregate objects. */
+	INIT(HurdLib, Buffer, this->state->wdata, goto fail);
+	INIT(HurdLib, Buffer, this->state->wlist, goto fail);
+
+	/* Method initialization. */
+	this->init = init;
+
+	this->watch   = watch;
+	this->wait    = wait;
+	this->revents = revents;
+
+	this->drain	  = drain;
+	this->queue_write = queue_write;
+	this->flush	  = flush;
+	this->write_error = write_error;
+
+	this->uses_ring = uses_ring;
+	this->whack	= whack;
+
+	return this;
+
+
+ fail:
+	WHACK(this->state->wdata);
+	WHACK(this->state->wlist);
+
+	root->whack(root, this, this->state);
+	return NULL;
+}
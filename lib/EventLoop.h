@@ -0,0 +1,56 @@
+/** \file
+ * This file contains the API definitions for an object which
+ * implements the event loop used by the orchestrators to wait for
+ * security events and management requests and to issue the
+ * resulting control commands.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+#ifndef NAAAIM_EventLoop_HEADER
+#define NAAAIM_EventLoop_HEADER
+
+
+/* The number of descriptors that can be watched by an event loop. */
+#define EVENTLOOP_MAX_WATCH 4
+
+
+/* Object type definitions. */
+typedef struct NAAAIM_EventLoop * EventLoop;
+
+typedef struct NAAAIM_EventLoop_State * EventLoop_State;
+
+/**
+ * External EventLoop object representation.
+ */
+struct NAAAIM_EventLoop
+{
+	/* External methods. */
+	_Bool (*init)(const EventLoop, const unsigned int, const _Bool);
+
+	_Bool (*watch)(const EventLoop, const unsigned int, const int);
+	int (*wait)(const EventLoop);
+	short int (*revents)(const EventLoop, const unsigned int);
+
+	_Bool (*drain)(const EventLoop, const int, const Buffer);
+	_Bool (*queue_write)(const EventLoop, const int, \
+			     const unsigned char *, const size_t);
+	_Bool (*flush)(const EventLoop);
+	int (*write_error)(const EventLoop);
+
+	_Bool (*uses_ring)(const EventLoop);
+	void (*whack)(const EventLoop);
+
+	/* Private state. */
+	EventLoop_State state;
+};
+
+
+/* EventLoop constructor call. */
+extern HCLINK EventLoop NAAAIM_EventLoop_Init(void);
+#endif
@@ -0,0 +1,222 @@
+/** \file
+ * This file implements a test driver for the EventLoop object.
+ *
+ * The loop is exercised with non-blocking pipes standing in for a
+ * security event file, a management socket and the TSEM control
+ * file.  The tests are run with the io_uring implementation, if the
+ * kernel supports it, and with the poll implementation.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+
+#include <HurdLib.h>
+#include <Buffer.h>
+
+#include <NAAAIM.h>
+#include "EventLoop.h"
+
+
+/**
+ * Private function.
+ *
+ * This function runs the tests against one implementation of the
+ * event loop.
+ *
+ * \param use_poll	A flag indicating whether or not the poll
+ *			implementation is to be tested.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the tests passed.
+ */
+
+static _Bool run_tests(const _Bool use_poll)
+
+{
+	_Bool retn = false;
+
+	static const char *events = "event 1\nevent 2\nevent 3\n",
+			  *commands = "trusted pid=1\ntrusted pid=2\n"	\
+				      "untrusted pid=3\n";
+
+	char bufr[256];
+
+	int rc,
+	    event[2]   = {-1, -1},
+	    mgmt[2]    = {-1, -1},
+	    mgmt2[2]   = {-1, -1},
+	    control[2] = {-1, -1};
+
+	Buffer input = NULL;
+
+	EventLoop loop = NULL;
+
+
+	INIT(HurdLib, Buffer, input, ERR(goto done));
+	INIT(NAAAIM, EventLoop, loop, ERR(goto done));
+	if ( !loop->init(loop, 64, use_poll) )
+		ERR(goto done);
+	fprintf(stdout, "Implementation: %s\n", \
+		loop->uses_ring(loop) ? "io_uring" : "poll");
+
+	if ( pipe2(event, O_NONBLOCK) || pipe2(mgmt, O_NONBLOCK) || \
+	     pipe2(mgmt2, O_NONBLOCK) || pipe2(control, O_NONBLOCK) )
+		ERR(goto done);
+
+	if ( !loop->watch(loop, 0, event[0]) )
+		ERR(goto done);
+	if ( !loop->watch(loop, 1, mgmt[0]) )
+		ERR(goto done);
+
+
+	/* Event input and drain. */
+	if ( write(event[1], events, strlen(events)) < 0 )
+		ERR(goto done);
+	if ( (rc = loop->wait(loop)) != 1 ) {
+		fprintf(stdout, "Event wait returned %d.\n", rc);
+		goto done;
+	}
+	if ( !(loop->revents(loop, 0) & POLLIN) || \
+	     (loop->revents(loop, 1) != 0) ) {
+		fputs("Event not reported on event descriptor.\n", stdout);
+		goto done;
+	}
+
+	if ( !loop->drain(loop, event[0], input) )
+		ERR(goto done);
+	if ( (input->size(input) != strlen(events)) || \
+	     (memcmp(input->get(input), events, strlen(events)) != 0) ) {
+		fputs("Drained events do not match.\n", stdout);
+		goto done;
+	}
+	fputs("Event drain: OK\n", stdout);
+
+
+	/* Queued commands are written before the next wait returns. */
+	if ( !loop->queue_write(loop, control[1],		  \
+				(unsigned char *) "trusted pid=1\n", 14) )
+		ERR(goto done);
+	if ( !loop->queue_write(loop, control[1],		  \
+				(unsigned char *) "trusted pid=2\n", 14) )
+		ERR(goto done);
+	if ( !loop->queue_write(loop, control[1],		    \
+				(unsigned char *) "untrusted pid=3\n", 16) )
+		ERR(goto done);
+
+	if ( write(mgmt[1], "x", 1) < 0 )
+		ERR(goto done);
+	if ( (rc = loop->wait(loop)) != 1 ) {
+		fprintf(stdout, "Command wait returned %d.\n", rc);
+		goto done;
+	}
+	if ( !(loop->revents(loop, 1) & POLLIN) ) {
+		fputs("Event not reported on management descriptor.\n", \
+		      stdout);
+		goto done;
+	}
+	if ( loop->write_error(loop) != 0 ) {
+		fputs("Command write error.\n", stdout);
+		goto done;
+	}
+
+	memset(bufr, '\0', sizeof(bufr));
+	if ( read(control[0], bufr, sizeof(bufr) - 1) != strlen(commands) ) {
+		fputs("Commands not written.\n", stdout);
+		goto done;
+	}
+	if ( strcmp(bufr, commands) != 0 ) {
+		fputs("Commands written out of order.\n", stdout);
+		goto done;
+	}
+	if ( read(mgmt[0], bufr, 1) != 1 )
+		ERR(goto done);
+	fputs("Command batch: OK\n", stdout);
+
+
+	/* Replacement of a watched descriptor. */
+	if ( !loop->watch(loop, 1, mgmt2[0]) )
+		ERR(goto done);
+	if ( write(mgmt[1], "x", 1) < 0 )
+		ERR(goto done);
+	if ( write(mgmt2[1], "y", 1) < 0 )
+		ERR(goto done);
+
+	if ( (rc = loop->wait(loop)) != 1 ) {
+		fprintf(stdout, "Replacement wait returned %d.\n", rc);
+		goto done;
+	}
+	if ( read(mgmt2[0], bufr, 1) != 1 ) {
+		fputs("Replacement descriptor not reported.\n", stdout);
+		goto done;
+	}
+	fputs("Descriptor replacement: OK\n", stdout);
+
+
+	/* A failed command write is reported. */
+	if ( !loop->queue_write(loop, -1, (unsigned char *) "x", 1) ) {
+		if ( use_poll || !loop->uses_ring(loop) ) {
+			fputs("Failed write: OK\n", stdout);
+			retn = true;
+		}
+		goto done;
+	}
+	if ( !loop->flush(loop) )
+		ERR(goto done);
+	if ( loop->write_error(loop) == 0 ) {
+		fputs("Failed write not reported.\n", stdout);
+		goto done;
+	}
+	fputs("Failed write: OK\n", stdout);
+	retn = true;
+
+
+ done:
+	close(event[0]);
+	close(event[1]);
+	close(mgmt[0]);
+	close(mgmt[1]);
+	close(mgmt2[0]);
+	close(mgmt2[1]);
+	close(control[0]);
+	close(control[1]);
+
+	WHACK(input);
+	WHACK(loop);
+
+	return retn;
+}
+
+
+extern int main(int argc, char *argv[])
+
+{
+	int retn = 1;
+
+
+	if ( !run_tests(false) )
+		goto done;
+	fputc('\n', stdout);
+	if ( !run_tests(true) )
+		goto done;
+	retn = 0;
+
+
+ done:
+	fprintf(stdout, "\nEventLoop tests: %s\n", retn ? "FAILED" : "OK");
+	return retn;
+}
@@ -0,0 +1,785 @@
+/** \file
+ * This file contains the implementation of an object which collects
+ * the statistics that describe the processing of security events by
+ * an orchestrator.  The time spent in each stage of processing an
+ * event is recorded in a histogram for the stage, and in a histogram
+ * for the stage and the type of the event, along with counters for
+ * the outcomes of the processing.
+ *
+ * The histograms are log-linear, in the style of an HDR histogram,
+ * with each power of two divided into sixteen buckets.  This bounds
+ * the error of a reported value to about six percent while allowing
+ * the full range of a nanosecond time to be recorded without any
+ * allocation after the first value for a stage has been recorded.
+ *
+ * Statistics are only collected after the object has been enabled,
+ * the methods used on the event path return immediately when it is
+ * not.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+
+/* Include files. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+
+#include <Origin.h>
+#include <HurdLib.h>
+#include <Buffer.h>
+#include <String.h>
+
+#include "NAAAIM.h"
+#include "EventStats.h"
+
+
+/* Verify library/object header file inclusions. */
+#if !defined(NAAAIM_LIBID)
+#error Library identifier not defined.
+#endif
+
+#if !defined(NAAAIM_EventStats_OBJID)
+#error Object identifier not defined.
+#endif
+
+/* Object state extraction macro. */
+#define STATE(var) CO(EventStats_State, var) = this->state
+
+/* The number of buckets each power of two is divided into. */
+#define SUB_BITS	4
+#define SUB_BUCKETS	(1 << SUB_BITS)
+
+/* The number of buckets needed to hold a 64-bit value. */
+#define HISTOGRAM_BUCKETS ((64 - SUB_BITS + 1) * SUB_BUCKETS)
+
+/* The maximum number of event types that are tracked. */
+#define MAX_TYPES 64
+
+/* The maximum length of an event type name. */
+#define TYPE_SIZE 32
+
+
+/** A latency histogram. */
+struct histogram {
+	uint64_t count;
+	uint64_t sum;
+	uint64_t min;
+	uint64_t max;
+	uint32_t buckets[HISTOGRAM_BUCKETS];
+};
+
+/** The histograms for a type of security event. */
+struct event_type {
+	char name[TYPE_SIZE];
+	struct histogram *stage[EVENTSTATS_STAGES];
+};
+
+
+/** The names of the processing stages. */
+static const char *Stage_names[EVENTSTATS_STAGES] = {
+	"queue",
+	"parse",
+	"model",
+	"pseudonym",
+	"measure",
+	"lookup",
+	"release",
+	"write",
+	"total"
+};
+
+/** The names of the counters. */
+static const char *Counter_names[EVENTSTATS_COUNTERS] = {
+	"events",
+	"cache_hits",
+	"new_points",
+	"forensics",
+	"disciplines",
+	"releases",
+	"async_events",
+	"errors"
+};
+
+
+/** EventStats private state information. */
+struct NAAAIM_EventStats_State
+{
+	/* The root object. */
+	Origin root;
+
+	/* Library identifier. */
+	uint32_t libid;
+
+	/* Object identifier. */
+	uint32_t objid;
+
+	/* Object status. */
+	_Bool poisoned;
+
+	/* Flag indicating statistics are being collected. */
+	_Bool enabled;
+
+	/* The event processing counters. */
+	uint64_t counters[EVENTSTATS_COUNTERS];
+
+	/* The histograms for all event types. */
+	struct histogram *all[EVENTSTATS_STAGES];
+
+	/* The histograms for each event type and the current type. */
+	Buffer types;
+	int current;
+};
+
+
+/**
+ * Internal private method.
+ *
+ * This method is responsible for initializing the NAAAIM_EventStats_State
+ * structure which holds state information for each instantiated object.
+ *
+ * \param S A pointer to the object containing the state information which
+ *        is to be initialized.
+ */
+
+static void _init_state(CO(EventStats_State, S))
+
+{
+	S->libid = NAAAIM_LIBID;
+	S->objid = NAAAIM_EventStats_OBJID;
+
+	S->poisoned = false;
+	S->enabled  = false;
+
+	memset(S->counters, '\0', sizeof(S->counters));
+	memset(S->all, '\0', sizeof(S->all));
+
+	S->types   = NULL;
+	S->current = -1;
+
+	return;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function returns the number of the histogram bucket that a
+ * value is recorded in.
+ *
+ * \param value	The value whose bucket is to be returned.
+ *
+ * \return	The bucket number is returned.
+ */
+
+static unsigned int _bucket(const uint64_t value)
+
+{
+	unsigned int exponent;
+
+
+	if ( value < SUB_BUCKETS )
+		return value;
+
+	exponent = 63 - __builtin_clzll(value);
+	return (exponent - SUB_BITS + 1) * SUB_BUCKETS + \
+		((value >> (exponent - SUB_BITS)) & (SUB_BUCKETS - 1));
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function returns the largest value that is recorded in a
+ * histogram bucket.
+ *
+ * \param bucket	The number of the bucket.
+ *
+ * \return		The largest value of the bucket is returned.
+ */
+
+static uint64_t _bucket_value(const unsigned int bucket)
+
+{
+	unsigned int shift;
+
+
+	if ( bucket < SUB_BUCKETS )
+		return bucket;
+
+	shift = bucket / SUB_BUCKETS - 1;
+	return ((uint64_t) (SUB_BUCKETS + bucket % SUB_BUCKETS + 1) << \
+		shift) - 1;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function adds a value to a histogram, allocating the
+ * histogram if needed.
+ *
+ * \param hp	A pointer to the pointer to the histogram.
+ *
+ * \param value	The value to be added.
+ *
+ * \return	A boolean value is used to indicate whether or not the
+ *		value was added.  A false value indicates the histogram
+ *		could not be allocated.
+ */
+
+static _Bool _add_value(struct histogram **hp, const uint64_t value)
+
+{
+	struct histogram *hist = *hp;
+
+
+	if ( hist == NULL ) {
+		if ( (hist = calloc(1, sizeof(struct histogram))) == NULL )
+			return false;
+		hist->min = UINT64_MAX;
+		*hp = hist;
+	}
+
+	++hist->count;
+	hist->sum += value;
+	if ( value < hist->min )
+		hist->min = value;
+	if ( value > hist->max )
+		hist->max = value;
+	++hist->buckets[_bucket(value)];
+
+	return true;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function returns a percentile of the values in a histogram.
+ *
+ * \param hist		A pointer to the histogram.
+ *
+ * \param permille	The percentile, in parts per thousand, to be
+ *			returned.
+ *
+ * \return		The value at the percentile is returned.
+ */
+
+static uint64_t _percentile(CO(struct histogram *, hist), \
+			    const unsigned int permille)
+
+{
+	unsigned int lp;
+
+	uint64_t value,
+		 seen = 0,
+		 rank = (hist->count * permille + 999) / 1000;
+
+
+	if ( rank == 0 )
+		rank = 1;
+
+	for (lp= 0; lp < HISTOGRAM_BUCKETS; ++lp) {
+		seen += hist->buckets[lp];
+		if ( seen >= rank )
+			break;
+	}
+
+	value = _bucket_value(lp);
+	return value > hist->max ? hist->max : value;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function adds the description of a histogram to the output
+ * of the statistics.
+ *
+ * \param stage	The number of the stage the histogram describes.
+ *
+ * \param type	A pointer to the name of the event type the
+ *		histogram describes.
+ *
+ * \param hist	A pointer to the histogram.
+ *
+ * \param str	The object that the description is to be added to.
+ *
+ * \return	A boolean value is used to indicate whether or not the
+ *		description was added.
+ */
+
+static _Bool _dump_histogram(const unsigned int stage, CO(char *, type), \
+			     CO(struct histogram *, hist), CO(String, str))
+
+{
+	char line[256];
+
+
+	snprintf(line, sizeof(line), "histogram stage=%s type=%s "	\
+		 "count=%lu min=%lu mean=%lu p50=%lu p90=%lu p99=%lu "	\
+		 "p999=%lu max=%lu\n", Stage_names[stage], type,	\
+		 (unsigned long int) hist->count,			\
+		 (unsigned long int) hist->min,				\
+		 (unsigned long int) (hist->sum / hist->count),		\
+		 (unsigned long int) _percentile(hist, 500),		\
+		 (unsigned long int) _percentile(hist, 900),		\
+		 (unsigned long int) _percentile(hist, 990),		\
+		 (unsigned long int) _percentile(hist, 999),		\
+		 (unsigned long int) hist->max);
+
+	return str->add(str, line);
+}
+
+
+/**
+ * External public method.
+ *
+ * This method enables or disables the collection of statistics.  The
+ * statistics that have been collected are retained when collection
+ * is disabled.
+ *
+ * \param this		A pointer to the object whose collection
+ *			status is to be set.
+ *
+ * \param enable	A flag indicating whether or not statistics
+ *			are to be collected.
+ */
+
+static void enable(CO(EventStats, this), const _Bool enable)
+
+{
+	STATE(S);
+
+
+	S->enabled = enable;
+	S->current = -1;
+
+	return;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method returns whether or not statistics are being collected.
+ *
+ * \param this	A pointer to the object being interrogated.
+ *
+ * \return	A boolean value is returned that is true if statistics
+ *		are being collected.
+ */
+
+static _Bool enabled(CO(EventStats, this))
+
+{
+	return this->state->enabled;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method returns the current time for use in timing a stage
+ * of event processing.
+ *
+ * \param this	A pointer to the object that the stage is timed for.
+ *
+ * \return	The value of the monotonic clock in nanoseconds is
+ *		returned.  A value of zero is returned if statistics
+ *		are not being collected.
+ */
+
+static uint64_t now(CO(EventStats, this))
+
+{
+	struct timespec ts;
+
+
+	if ( !this->state->enabled )
+		return 0;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method sets the type of the security event that the stage
+ * times that are subsequently recorded are to be attributed to.
+ * Events with a type that is first seen after the maximum number of
+ * types are being tracked are only included in the histograms for
+ * all event types.
+ *
+ * \param this	A pointer to the object whose event type is to be
+ *		set.
+ *
+ * \param type	A pointer to the null-terminated name of the event
+ *		type.  A NULL value indicates the times are not to be
+ *		attributed to a type.
+ *
+ * \return	A boolean value is used to indicate whether or not
+ *		the type was set.
+ */
+
+static _Bool set_type(CO(EventStats, this), CO(char *, type))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	int lp,
+	    cnt;
+
+	struct event_type *tp,
+			  entry;
+
+
+	if ( !S->enabled )
+		return true;
+	if ( S->poisoned )
+		ERR(goto done);
+
+	if ( type == NULL ) {
+		S->current = -1;
+		retn = true;
+		goto done;
+	}
+
+
+	/* Search for the type, starting with the current type. */
+	tp  = (struct event_type *) S->types->get(S->types);
+	cnt = S->types->size(S->types) / sizeof(struct event_type);
+
+	if ( (S->current >= 0) && \
+	     (strncmp(tp[S->current].name, type, TYPE_SIZE - 1) == 0) ) {
+		retn = true;
+		goto done;
+	}
+
+	for (lp= 0; lp < cnt; ++lp) {
+		if ( strncmp(tp[lp].name, type, TYPE_SIZE - 1) == 0 ) {
+			S->current = lp;
+			retn = true;
+			goto done;
+		}
+	}
+
+
+	/* Add the type if there is room for it. */
+	S->current = -1;
+	if ( cnt == MAX_TYPES ) {
+		retn = true;
+		goto done;
+	}
+
+	memset(&entry, '\0', sizeof(entry));
+	strncpy(entry.name, type, sizeof(entry.name) - 1);
+	if ( !S->types->add(S->types, (unsigned char *) &entry, \
+			    sizeof(entry)) )
+		ERR(goto done);
+
+	S->current = cnt;
+	retn = true;
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method records the time spent in a stage of event processing.
+ *
+ * \param this	A pointer to the object that the time is to be
+ *		recorded in.
+ *
+ * \param stage	The number of the stage, one of the values of the
+ *		EventStats_stage enumeration.
+ *
+ * \param time	The time, in nanoseconds, that was spent in the
+ *		stage.
+ *
+ * \return	A boolean value is used to indicate whether or not
+ *		the time was recorded.
+ */
+
+static _Bool record(CO(EventStats, this), const unsigned int stage, \
+		    const uint64_t time)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	struct event_type *tp;
+
+
+	if ( !S->enabled )
+		return true;
+	if ( S->poisoned )
+		ERR(goto done);
+	if ( stage >= EVENTSTATS_STAGES )
+		ERR(goto done);
+
+	if ( !_add_value(&S->all[stage], time) )
+		ERR(goto done);
+
+	if ( S->current >= 0 ) {
+		tp = (struct event_type *) S->types->get(S->types);
+		if ( !_add_value(&tp[S->current].stage[stage], time) )
+			ERR(goto done);
+	}
+
+	retn = true;
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method increments one of the event processing counters.
+ *
+ * \param this		A pointer to the object whose counter is to
+ *			be incremented.
+ *
+ * \param counter	The number of the counter, one of the values
+ *			of the EventStats_counter enumeration.
+ */
+
+static void increment(CO(EventStats, this), const unsigned int counter)
+
+{
+	STATE(S);
+
+
+	if ( S->enabled && (counter < EVENTSTATS_COUNTERS) )
+		++S->counters[counter];
+
+	return;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method generates a description of the statistics that have
+ * been collected.  The description consists of lines of space
+ * separated key=value pairs.  The first line holds the counters and
+ * is followed by a line for each histogram, with the histograms for
+ * all event types preceding those for the individual types.  All
+ * times are in nanoseconds.
+ *
+ * \param this	A pointer to the object whose statistics are to be
+ *		output.
+ *
+ * \param str	The object that the description is to be added to.
+ *
+ * \return	A boolean value is used to indicate whether or not
+ *		the description was generated.
+ */
+
+static _Bool dump(CO(EventStats, this), CO(String, str))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	char line[64];
+
+	unsigned int lp,
+		     stage,
+		     cnt;
+
+	struct event_type *tp;
+
+
+	if ( S->poisoned )
+		ERR(goto done);
+
+
+	/* Output the counters. */
+	if ( !str->add(str, "counters") )
+		ERR(goto done);
+	for (lp= 0; lp < EVENTSTATS_COUNTERS; ++lp) {
+		snprintf(line, sizeof(line), " %s=%lu", Counter_names[lp], \
+			 (unsigned long int) S->counters[lp]);
+		if ( !str->add(str, line) )
+			ERR(goto done);
+	}
+	if ( !str->add(str, "\n") )
+		ERR(goto done);
+
+
+	/* Output the histograms. */
+	tp  = (struct event_type *) S->types->get(S->types);
+	cnt = S->types->size(S->types) / sizeof(struct event_type);
+
+	for (stage= 0; stage < EVENTSTATS_STAGES; ++stage) {
+		if ( S->all[stage] == NULL )
+			continue;
+		if ( !_dump_histogram(stage, "all", S->all[stage], str) )
+			ERR(goto done);
+
+		for (lp= 0; lp < cnt; ++lp) {
+			if ( tp[lp].stage[stage] == NULL )
+				continue;
+			if ( !_dump_histogram(stage, tp[lp].name, \
+					      tp[lp].stage[stage], str) )
+				ERR(goto done);
+		}
+	}
+
+	retn = true;
+
+
+ done:
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method clears the statistics that have been collected.
+ *
+ * \param this	A pointer to the object whose statistics are to be
+ *		cleared.
+ */
+
+static void reset(CO(EventStats, this))
+
+{
+	STATE(S);
+
+	unsigned int lp,
+		     stage,
+		     cnt;
+
+	struct event_type *tp;
+
+
+	tp  = (struct event_type *) S->types->get(S->types);
+	cnt = S->types->size(S->types) / sizeof(struct event_type);
+
+	for (stage= 0; stage < EVENTSTATS_STAGES; ++stage) {
+		free(S->all[stage]);
+		S->all[stage] = NULL;
+		for (lp= 0; lp < cnt; ++lp)
+			free(tp[lp].stage[stage]);
+	}
+
+	S->types->reset(S->types);
+	S->current = -1;
+
+	memset(S->counters, '\0', sizeof(S->counters));
+	S->poisoned = false;
+
+	return;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements a destructor for an EventStats object.
+ *
+ * \param this	A pointer to the object which is to be destroyed.
+ */
+
+static void whack(CO(EventStats, this))
+
+{
+	STATE(S);
+
+
+	reset(this);
+	WHACK(S->types);
+
+	S->root->whack(S->root, this, S);
+	return;
+}
+
+
+/**
+ * External constructor call.
+ *
+ * This function implements a constructor call for an EventStats object.
+ *
+ * \return	A pointer to the initialized EventStats.  A null value
+ *		indicates an error was encountered in object generation.
+ */
+
+extern EventStats NAAAIM_EventStats_Init(void)
+
+{
+	Origin root;
+
+	EventStats this = NULL;
+
+	struct HurdLib_Origin_Retn retn;
+
+
+	/* Get the root object. */
+	root = HurdLib_Origin_Init();
+
+	/* Allocate the object and internal state. */
+	retn.object_size  = sizeof(struct NAAAIM_EventStats);
+	retn.state_size   = sizeof(struct NAAAIM_EventStats_State);
+	if ( !root->init(root, NAAAIM_LIBID, NAAAIM_EventStats_OBJID, &retn) )
+		return NULL;
+	this	    	  = retn.object;
+	this->state 	  = retn.state;
+	this->state->root = root;
+
+	/* Initialize object state. */
+	_init_state(this->state);
+
+	/* Initialize aggregate objects. */
+	INIT(HurdLib, Buffer, this->state->types, goto fail);
+
+	/* Method initialization. */
+	this->enable  = enable;
+	this->enabled = enabled;
+
+	this->now	= now;
+	this->set_type	= set_type;
+	this->record	= record;
+	this->increment = increment;
+
+	this->dump  = dump;
+	this->reset = reset;
+	this->whack = whack;
+
+	return this;
+
+
+ fail:
+	root->whack(root, this, this->state);
+	return NULL;
+}
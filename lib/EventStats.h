@@ -0,0 +1,76 @@
+/** \file
+ * This file contains the API definitions for an object which
+ * collects the latency histograms and counters that describe the
+ * processing of security events by an orchestrator.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+#ifndef NAAAIM_EventStats_HEADER
+#define NAAAIM_EventStats_HEADER
+
+
+/* The stages of security event processing that are timed. */
+enum EventStats_stage {
+	EVENTSTATS_QUEUE = 0,
+	EVENTSTATS_PARSE,
+	EVENTSTATS_MODEL,
+	EVENTSTATS_PSEUDONYM,
+	EVENTSTATS_MEASURE,
+	EVENTSTATS_LOOKUP,
+	EVENTSTATS_RELEASE,
+	EVENTSTATS_WRITE,
+	EVENTSTATS_TOTAL,
+	EVENTSTATS_STAGES
+};
+
+/* The security event processing counters. */
+enum EventStats_counter {
+	EVENTSTATS_EVENTS = 0,
+	EVENTSTATS_CACHE_HITS,
+	EVENTSTATS_NEW_POINTS,
+	EVENTSTATS_FORENSICS,
+	EVENTSTATS_DISCIPLINES,
+	EVENTSTATS_RELEASES,
+	EVENTSTATS_ASYNC_EVENTS,
+	EVENTSTATS_ERRORS,
+	EVENTSTATS_COUNTERS
+};
+
+
+/* Object type definitions. */
+typedef struct NAAAIM_EventStats * EventStats;
+
+typedef struct NAAAIM_EventStats_State * EventStats_State;
+
+/**
+ * External EventStats object representation.
+ */
+struct NAAAIM_EventStats
+{
+	/* External methods. */
+	void (*enable)(const EventStats, const _Bool);
+	_Bool (*enabled)(const EventStats);
+
+	uint64_t (*now)(const EventStats);
+	_Bool (*set_type)(const EventStats, const char *);
+	_Bool (*record)(const EventStats, const unsigned int, const uint64_t);
+	void (*increment)(const EventStats, const unsigned int);
+
+	_Bool (*dump)(const EventStats, const String);
+	void (*reset)(const EventStats);
+	void (*whack)(const EventStats);
+
+	/* Private state. */
+	EventStats_State state;
+};
+
+
+/* EventStats constructor call. */
+extern HCLINK EventStats NAAAIM_EventStats_Init(void);
+#endif
@@ -0,0 +1,138 @@
+/** \file
+ * This file implements a test driver for the EventStats object.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <HurdLib.h>
+#include <String.h>
+
+#include <NAAAIM.h>
+#include "EventStats.h"
+
+
+extern int main(int argc, char *argv[])
+
+{
+	int retn = 1;
+
+	uint64_t lp,
+		 start;
+
+	String str = NULL;
+
+	EventStats stats = NULL;
+
+
+	INIT(HurdLib, String, str, ERR(goto done));
+	INIT(NAAAIM, EventStats, stats, ERR(goto done));
+
+
+	/* Nothing is collected before the object is enabled. */
+	if ( stats->now(stats) != 0 ) {
+		fputs("Time returned while disabled.\n", stdout);
+		goto done;
+	}
+	if ( !stats->set_type(stats, "file_open") )
+		ERR(goto done);
+	if ( !stats->record(stats, EVENTSTATS_TOTAL, 100) )
+		ERR(goto done);
+	stats->increment(stats, EVENTSTATS_EVENTS);
+
+	if ( !stats->dump(stats, str) )
+		ERR(goto done);
+	if ( strstr(str->get(str), "histogram") != NULL ) {
+		fputs("Statistics collected while disabled.\n", stdout);
+		goto done;
+	}
+	fputs("Disabled: OK\n", stdout);
+
+
+	/* Record a known distribution. */
+	stats->enable(stats, true);
+	if ( (start = stats->now(stats)) == 0 ) {
+		fputs("No time returned.\n", stdout);
+		goto done;
+	}
+
+	if ( !stats->set_type(stats, "file_open") )
+		ERR(goto done);
+	for (lp= 1; lp <= 1000; ++lp) {
+		if ( !stats->record(stats, EVENTSTATS_TOTAL, lp * 1000) )
+			ERR(goto done);
+		stats->increment(stats, EVENTSTATS_EVENTS);
+	}
+
+	if ( !stats->set_type(stats, "task_kill") )
+		ERR(goto done);
+	if ( !stats->record(stats, EVENTSTATS_TOTAL, 5) )
+		ERR(goto done);
+	if ( !stats->record(stats, EVENTSTATS_MODEL, \
+			    stats->now(stats) - start) )
+		ERR(goto done);
+	stats->increment(stats, EVENTSTATS_EVENTS);
+	stats->increment(stats, EVENTSTATS_CACHE_HITS);
+
+	str->reset(str);
+	if ( !stats->dump(stats, str) )
+		ERR(goto done);
+	fputs(str->get(str), stdout);
+
+
+	/* Verify the counters and the percentiles. */
+	if ( strstr(str->get(str), "events=1001 cache_hits=1 ") == NULL ) {
+		fputs("Counter mismatch.\n", stdout);
+		goto done;
+	}
+	if ( strstr(str->get(str), "stage=total type=file_open count=1000 " \
+		    "min=1000 mean=500500 ") == NULL ) {
+		fputs("Histogram summary mismatch.\n", stdout);
+		goto done;
+	}
+	if ( strstr(str->get(str), "p50=507903 p90=917503 p99=1000000 " \
+		    "p999=1000000 max=1000000") == NULL ) {
+		fputs("Percentile mismatch.\n", stdout);
+		goto done;
+	}
+	if ( strstr(str->get(str), "stage=total type=task_kill count=1 " \
+		    "min=5 mean=5 p50=5") == NULL ) {
+		fputs("Exact bucket mismatch.\n", stdout);
+		goto done;
+	}
+	fputs("Histograms: OK\n", stdout);
+
+
+	/* Verify the statistics are cleared. */
+	stats->reset(stats);
+	str->reset(str);
+	if ( !stats->dump(stats, str) )
+		ERR(goto done);
+	if ( strcmp(str->get(str), "counters events=0 cache_hits=0 "	   \
+		    "new_points=0 forensics=0 disciplines=0 releases=0 " \
+		    "async_events=0 errors=0\n") != 0 ) {
+		fputs("Statistics not cleared.\n", stdout);
+		goto done;
+	}
+	fputs("Reset: OK\n", stdout);
+	retn = 0;
+
+
+ done:
+	fprintf(stdout, "\nEventStats tests: %s\n", retn ? "FAILED" : "OK");
+
+	WHACK(str);
+	WHACK(stats);
+
+	return retn;
+}
@@ -2,9 +2,18 @@
  * This file provides the method implementations for an object which
  * implements the execution of commands against an HTTP server.
  *
- * In order to expedite development of this object the initial
- * development strategy is to use this object as a wrapper around the
- * wget command.
+ * The object was originally implemented as a wrapper around the wget
+ * command.  Requests are now carried out by a native HTTP/1.1 client
+ * which keeps connections open between requests.  Idle connections
+ * are held in a process wide pool so that a connection, and for
+ * HTTPS the TLS session, established by one object is reused by the
+ * next object which posts to the same server.  Requests which are
+ * queued are pipelined over a single connection.
+ *
+ * The wget command-line arguements used by callers of the object are
+ * interpreted by the native client.  If an arguement is added which
+ * the native client does not implement the request is carried out
+ * by the wget command as before.
  */
 
 /**************************************************************************
@@ -15,6 +24,7 @@
  **************************************************************************/
 
 /* Local defines. */
+#define _GNU_SOURCE
 
 /* Macro to clear an array object. */
 #define GWHACK(type, var) {			\
@@ -26,6 +36,15 @@
 	}					\
 }
 
+/* Number of connections held in the connection pool. */
+#define POOL_SIZE 8
+
+/* Size of the receive buffer for a connection. */
+#define RECEIVE_SIZE 16384
+
+/* Number of seconds to wait for data from a server. */
+#define RECEIVE_TIMEOUT 60
+
 
 /* Include files. */
 #include <stdint.h>
@@ -33,9 +52,21 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <poll.h>
+#include <netdb.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#include <openssl/ssl.h>
 
 #include <Origin.h>
 #include <HurdLib.h>
@@ -59,108 +90,1369 @@
 #endif
 
 
-/** HTTP private state information. */
-struct NAAAIM_HTTP_State
-{
-	/* The root object. */
-	Origin root;
+/**
+ * The following structure describes a connection to a server.  The
+ * key identifies the server and the TLS configuration the connection
+ * was established with.  The TLS context and session are retained
+ * after the connection is closed so a new connection to the same
+ * server can resume the session.
+ */
+struct connection {
+	char *key;
+	_Bool busy;
+	_Bool pooled;
+	unsigned long int used;
+
+	int fd;
+	SSL_CTX *ctx;
+	SSL *ssl;
+	SSL_SESSION *session;
+
+	size_t start;
+	size_t end;
+	uint8_t bufr[RECEIVE_SIZE];
+};
+
+/* The pool of connections and the lock which protects it. */
+static struct connection Pool[POOL_SIZE];
+
+static unsigned long int Pool_clock = 0;
+
+static pthread_mutex_t Pool_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/**
+ * The following structure holds the components of a URL which are
+ * used by the native client.
+ */
+struct url {
+	_Bool tls;
+	char host[256];
+	char port[8];
+	const char *path;
+};
+
+
+/**
+ * The following structure describes a post which has been queued
+ * for transmission by the ->flush method.
+ */
+struct request {
+	String url;
+	Buffer input;
+	Buffer output;
+};
+
+
+/** HTTP private state information. */
+struct NAAAIM_HTTP_State
+{
+	/* The root object. */
+	Origin root;
+
+	/* Library identifier. */
+	uint32_t libid;
+
+	/* Object identifier. */
+	uint32_t objid;
+
+	/* Object status. */
+	_Bool poisoned;
+
+	/* Command-line arguements and pointers. */
+	Buffer args;
+
+	/* Flag to indicate the wget utility is to be used. */
+	_Bool wget;
+
+	/* Native client options derived from the arguements. */
+	_Bool save_headers;
+	_Bool verify;
+	int tls_version;
+
+	String headers;
+	String ca_file;
+	String certificate;
+	String private_key;
+
+	/* Posts queued for pipelining. */
+	Buffer queue;
+};
+
+
+/**
+ * Internal private method.
+ *
+ * This method is responsible for initializing the NAAAIM_HTTP_State
+ * structure which holds state information for each instantiated object.
+ *
+ * \param S A pointer to the object containing the state information which
+ *        is to be initialized.
+ */
+
+static void _init_state(CO(HTTP_State, S)) {
+
+	S->libid = NAAAIM_LIBID;
+	S->objid = NAAAIM_HTTP_OBJID;
+
+	S->poisoned  = false;
+
+	S->wget		= false;
+	S->save_headers = false;
+	S->verify	= true;
+	S->tls_version	= 0;
+
+	S->headers     = NULL;
+	S->ca_file     = NULL;
+	S->certificate = NULL;
+	S->private_key = NULL;
+
+	S->queue = NULL;
+
+	return;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function loads a string object with an option value, creating
+ * the object if needed.
+ *
+ * \param option	A pointer to the variable holding the object
+ *			which is to be loaded.
+ *
+ * \param value		A pointer to the null-terminated buffer
+ *			containing the value to be loaded.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the value was loaded.
+ */
+
+static _Bool _set_option(String *option, CO(char *, value))
+
+{
+	if ( *option == NULL ) {
+		INIT(HurdLib, String, *option, return false);
+	}
+	else
+		(*option)->reset(*option);
+
+	return (*option)->add(*option, value);
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements a method for adding an arguement to the
+ * set of command-line arguements which will be passed to the wget
+ * utility.
+ *
+ * The arguements which callers use to configure the request are
+ * also interpreted for the native client.  An arguement which is
+ * not understood causes the request to be carried out by the wget
+ * utility.
+ *
+ * \param this		A pointer to the object which will execute
+ *			the HTTP request.
+ *
+ * \param arg		A pointer to the null-terminated character
+ *			buffer containing the command-line arguement
+ *			to be added.
+ *
+ * \return	If an error is encountered while adding the
+ *		command-line arguement a false value is returned.  A
+ *		true value indicates the arguement was successfully
+ *		added.
+ */
+
+static _Bool add_arg(CO(HTTP, this), CO(char *, arg))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	const char *value;
+
+	String entry;
+
+
+	/* Validate object. */
+	if ( S->poisoned )
+		ERR(goto done);
+
+
+	/* Add the pointer to the current arguement list. */
+	INIT(HurdLib, String, entry, ERR(goto done));
+	if ( !entry->add(entry, arg) )
+		ERR(goto done);
+
+	if ( !S->args->add(S->args, (void *) &entry, sizeof(entry)) )
+		ERR(goto done);
+
+
+	/* Translate the arguement for the native client. */
+	if ( (strcmp(arg, "-q") == 0) || (strcmp(arg, "--quiet") == 0) ) {
+		retn = true;
+		goto done;
+	}
+
+	if ( strcmp(arg, "--save-headers") == 0 ) {
+		S->save_headers = true;
+		retn = true;
+		goto done;
+	}
+
+	if ( strcmp(arg, "--no-check-certificate") == 0 ) {
+		S->verify = false;
+		retn = true;
+		goto done;
+	}
+
+	if ( strncmp(arg, "--header=", 9) == 0 ) {
+		if ( S->headers == NULL )
+			INIT(HurdLib, String, S->headers, ERR(goto done));
+		if ( !S->headers->add(S->headers, arg + 9) )
+			ERR(goto done);
+		if ( !S->headers->add(S->headers, "\r\n") )
+			ERR(goto done);
+		retn = true;
+		goto done;
+	}
+
+	if ( strncmp(arg, "--secure-protocol=", 18) == 0 ) {
+		value = arg + 18;
+		if ( strcmp(value, "auto") == 0 )
+			S->tls_version = 0;
+		else if ( strcmp(value, "TLSv1_2") == 0 )
+			S->tls_version = TLS1_2_VERSION;
+		else if ( strcmp(value, "TLSv1_3") == 0 )
+			S->tls_version = TLS1_3_VERSION;
+		else
+			S->wget = true;
+		retn = true;
+		goto done;
+	}
+
+	if ( strncmp(arg, "--ca-certificate=", 17) == 0 ) {
+		if ( !_set_option(&S->ca_file, arg + 17) )
+			ERR(goto done);
+		retn = true;
+		goto done;
+	}
+
+	if ( strncmp(arg, "--certificate=", 14) == 0 ) {
+		if ( !_set_option(&S->certificate, arg + 14) )
+			ERR(goto done);
+		retn = true;
+		goto done;
+	}
+
+	if ( strncmp(arg, "--private-key=", 14) == 0 ) {
+		if ( !_set_option(&S->private_key, arg + 14) )
+			ERR(goto done);
+		retn = true;
+		goto done;
+	}
+
+	S->wget = true;
+	retn = true;
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method selects whether or not requests are to be carried out
+ * by the wget utility rather than the native client.
+ *
+ * \param this		A pointer to the object whose request mode is
+ *			to be set.
+ *
+ * \param wget		A flag indicating whether or not the wget
+ *			utility is to be used.
+ *
+ * \return	No return value is defined.
+ */
+
+static void use_wget(CO(HTTP, this), const _Bool wget)
+
+{
+	STATE(S);
+
+
+	S->wget = wget;
+	return;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function parses a URL into the components needed to open a
+ * connection to the server and issue a request.
+ *
+ * \param url		A pointer to the null-terminated buffer
+ *			containing the URL to be parsed.
+ *
+ * \param parsed	A pointer to the structure which will be loaded
+ *			with the components of the URL.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the URL was parsed.  A false value
+ *			indicates the URL uses a scheme or form which
+ *			the native client does not implement.
+ */
+
+static _Bool _parse_url(CO(char *, url), struct url *parsed)
+
+{
+	const char *p = url,
+		   *port;
+
+	size_t len;
+
+
+	if ( strncmp(p, "https://", 8) == 0 ) {
+		parsed->tls = true;
+		p += 8;
+	} else if ( strncmp(p, "http://", 7) == 0 ) {
+		parsed->tls = false;
+		p += 7;
+	} else
+		return false;
+
+	len = strcspn(p, ":/?#");
+	if ( (len == 0) || (len >= sizeof(parsed->host)) )
+		return false;
+	memcpy(parsed->host, p, len);
+	parsed->host[len] = '\0';
+	p += len;
+
+	if ( *p == ':' ) {
+		port = ++p;
+		len  = strspn(p, "0123456789");
+		if ( (len == 0) || (len >= sizeof(parsed->port)) )
+			return false;
+		memcpy(parsed->port, port, len);
+		parsed->port[len] = '\0';
+		p += len;
+	} else
+		strcpy(parsed->port, parsed->tls ? "443" : "80");
+
+	if ( (*p != '\0') && (*p != '/') )
+		return false;
+	parsed->path = (*p == '\0') ? "/" : p;
+
+	return true;
+}
+
+
+/**
+ * Internal private method.
+ *
+ * This method generates the key which identifies the connections
+ * that a request can be carried over.  A connection is only shared
+ * between requests directed to the same server with the same TLS
+ * configuration.
+ *
+ * \param S		A pointer to the state of the object issueing
+ *			the request.
+ *
+ * \param url		A pointer to the structure describing the
+ *			server the request is directed to.
+ *
+ * \param key		The object which the key is to be loaded into.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the key was generated.
+ */
+
+static _Bool _connection_key(CO(HTTP_State, S), CO(struct url *, url), \
+			     CO(String, key))
+
+{
+	key->reset(key);
+	key->add_sprintf(key, "%s://%s:%s", url->tls ? "https" : "http", \
+			 url->host, url->port);
+	if ( url->tls )
+		key->add_sprintf(key, "|%d|%d|%s|%s|%s", S->tls_version, \
+				 S->verify,				 \
+				 S->ca_file ? S->ca_file->get(S->ca_file) : "",\
+				 S->certificate ?			 \
+				 S->certificate->get(S->certificate) : "", \
+				 S->private_key ?			 \
+				 S->private_key->get(S->private_key) : "");
+
+	return !key->poisoned(key);
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function closes the network connection and TLS channel
+ * associated with a connection.  The TLS session is retained so
+ * that it can be resumed by the next connection to the server.
+ *
+ * \param conn	A pointer to the connection to be closed.
+ */
+
+static void _disconnect(struct connection *conn)
+
+{
+	SSL_SESSION *session;
+
+
+	if ( conn->ssl != NULL ) {
+		if ( (session = SSL_get1_session(conn->ssl)) != NULL ) {
+			if ( SSL_SESSION_is_resumable(session) ) {
+				SSL_SESSION_free(conn->session);
+				conn->session = session;
+			} else
+				SSL_SESSION_free(session);
+		}
+		SSL_set_quiet_shutdown(conn->ssl, 1);
+		SSL_shutdown(conn->ssl);
+		SSL_free(conn->ssl);
+		conn->ssl = NULL;
+	}
+
+	if ( conn->fd != -1 ) {
+		close(conn->fd);
+		conn->fd = -1;
+	}
+
+	conn->start = 0;
+	conn->end   = 0;
+	return;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function releases all of the resources associated with a
+ * connection and returns it to its unused state.
+ *
+ * \param conn	A pointer to the connection to be released.
+ */
+
+static void _release(struct connection *conn)
+
+{
+	_disconnect(conn);
+
+	SSL_SESSION_free(conn->session);
+	SSL_CTX_free(conn->ctx);
+	free(conn->key);
+
+	conn->session = NULL;
+	conn->ctx     = NULL;
+	conn->key     = NULL;
+	return;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function obtains a connection for the server identified by
+ * the supplied key.  An idle pooled connection to the server is
+ * preferred, followed by an unused pool entry and then by the least
+ * recently used idle entry.  If all of the pool entries are in use
+ * a connection is allocated outside of the pool.
+ *
+ * \param key	A pointer to the null-terminated buffer containing
+ *		the key which identifies the server.
+ *
+ * \return	A pointer to the connection is returned.  A NULL value
+ *		indicates an error was encountered.
+ */
+
+static struct connection *_checkout(CO(char *, key))
+
+{
+	unsigned int lp;
+
+	struct pollfd pfd;
+
+	struct connection *conn = NULL,
+			  *unused = NULL,
+			  *lru	  = NULL;
+
+
+	pthread_mutex_lock(&Pool_lock);
+
+	for (lp= 0; lp < POOL_SIZE; ++lp) {
+		if ( Pool[lp].busy )
+			continue;
+		if ( Pool[lp].key == NULL ) {
+			if ( unused == NULL )
+				unused = &Pool[lp];
+			continue;
+		}
+		if ( strcmp(Pool[lp].key, key) == 0 ) {
+			if ( (conn == NULL) || (Pool[lp].fd != -1) )
+				conn = &Pool[lp];
+			continue;
+		}
+		if ( (lru == NULL) || (Pool[lp].used < lru->used) )
+			lru = &Pool[lp];
+	}
+
+	if ( conn == NULL ) {
+		if ( (conn = unused) == NULL )
+			conn = lru;
+		if ( conn != NULL ) {
+			_release(conn);
+			conn->fd = -1;
+			if ( (conn->key = strdup(key)) == NULL )
+				conn = NULL;
+		}
+		if ( conn != NULL )
+			conn->pooled = true;
+	}
+	if ( conn != NULL )
+		conn->busy = true;
+
+	pthread_mutex_unlock(&Pool_lock);
+
+
+	/* All of the pool entries are in use. */
+	if ( (conn == NULL) && \
+	     ((conn = calloc(1, sizeof(struct connection))) != NULL) ) {
+		conn->fd = -1;
+		if ( (conn->key = strdup(key)) == NULL ) {
+			free(conn);
+			return NULL;
+		}
+		conn->busy = true;
+	}
+
+	/*
+	 * An idle connection which has become readable has been
+	 * closed by the server.
+	 */
+	if ( (conn != NULL) && (conn->fd != -1) ) {
+		pfd.fd	    = conn->fd;
+		pfd.events  = POLLIN;
+		pfd.revents = 0;
+		if ( (conn->start != conn->end) || (poll(&pfd, 1, 0) != 0) )
+			_disconnect(conn);
+	}
+
+	return conn;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function returns a connection to the pool once a request has
+ * been completed.
+ *
+ * \param conn	A pointer to the connection to be returned.
+ *
+ * \param keep	A flag indicating whether or not the connection can
+ *		be reused for another request.
+ */
+
+static void _checkin(struct connection *conn, const _Bool keep)
+
+{
+	if ( !keep )
+		_disconnect(conn);
+
+	if ( !conn->pooled ) {
+		_release(conn);
+		free(conn);
+		return;
+	}
+
+	pthread_mutex_lock(&Pool_lock);
+	conn->busy = false;
+	conn->used = ++Pool_clock;
+	pthread_mutex_unlock(&Pool_lock);
+
+	return;
+}
+
+
+/**
+ * Internal private method.
+ *
+ * This method creates the TLS context used by connections to a
+ * server from the TLS options which have been set for the object.
+ *
+ * \param S	A pointer to the state of the object issueing the
+ *		request.
+ *
+ * \return	A pointer to the TLS context is returned.  A NULL value
+ *		indicates an error was encountered.
+ */
+
+static SSL_CTX *_tls_context(CO(HTTP_State, S))
+
+{
+	_Bool retn = false;
+
+	SSL_CTX *ctx = NULL;
+
+
+	if ( (ctx = SSL_CTX_new(TLS_client_method())) == NULL )
+		ERR(goto done);
+
+	if ( S->tls_version != 0 ) {
+		if ( !SSL_CTX_set_min_proto_version(ctx, S->tls_version) )
+			ERR(goto done);
+		if ( !SSL_CTX_set_max_proto_version(ctx, S->tls_version) )
+			ERR(goto done);
+	}
+
+	if ( S->verify ) {
+		SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, NULL);
+		if ( S->ca_file != NULL ) {
+			if ( SSL_CTX_load_verify_locations(ctx, \
+				 S->ca_file->get(S->ca_file), NULL) != 1 )
+				ERR(goto done);
+		} else if ( SSL_CTX_set_default_verify_paths(ctx) != 1 )
+			ERR(goto done);
+	}
+
+	if ( S->certificate != NULL ) {
+		if ( SSL_CTX_use_certificate_chain_file(ctx, \
+				 S->certificate->get(S->certificate)) != 1 )
+			ERR(goto done);
+	}
+	if ( S->private_key != NULL ) {
+		if ( SSL_CTX_use_PrivateKey_file(ctx, \
+				 S->private_key->get(S->private_key), \
+				 SSL_FILETYPE_PEM) != 1 )
+			ERR(goto done);
+	}
+
+	SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT);
+	retn = true;
+
+
+ done:
+	if ( !retn ) {
+		SSL_CTX_free(ctx);
+		ctx = NULL;
+	}
+
+	return ctx;
+}
+
+
+/**
+ * Internal private method.
+ *
+ * This method opens a network connection to a server and, for an
+ * HTTPS server, negotiates the TLS channel.  A TLS session retained
+ * from a previous connection to the server is offered for
+ * resumption.
+ *
+ * \param S	A pointer to the state of the object issueing the
+ *		request.
+ *
+ * \param conn	A pointer to the connection to be opened.
+ *
+ * \param url	A pointer to the structure describing the server
+ *		which is to be connected to.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the connection was opened.
+ */
+
+static _Bool _connect(CO(HTTP_State, S), struct connection *conn, \
+		      CO(struct url *, url))
+
+{
+	_Bool retn = false;
+
+	int fd	 = -1,
+	    flag = 1;
+
+	struct addrinfo hints,
+			*ap,
+			*addrs = NULL;
+
+
+	/* Open the network connection. */
+	memset(&hints, '\0', sizeof(hints));
+	hints.ai_family	  = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	if ( getaddrinfo(url->host, url->port, &hints, &addrs) != 0 )
+		ERR(goto done);
+
+	for (ap= addrs; ap != NULL; ap = ap->ai_next) {
+		fd = socket(ap->ai_family, ap->ai_socktype | SOCK_CLOEXEC, \
+			    ap->ai_protocol);
+		if ( fd == -1 )
+			continue;
+		if ( connect(fd, ap->ai_addr, ap->ai_addrlen) == 0 )
+			break;
+		close(fd);
+		fd = -1;
+	}
+	if ( fd == -1 )
+		ERR(goto done);
+
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+	conn->fd    = fd;
+	conn->start = 0;
+	conn->end   = 0;
+
+	if ( !url->tls ) {
+		retn = true;
+		goto done;
+	}
+
+
+	/* Negotiate the TLS channel. */
+	if ( (conn->ctx == NULL) && ((conn->ctx = _tls_context(S)) == NULL) )
+		ERR(goto done);
+	if ( (conn->ssl = SSL_new(conn->ctx)) == NULL )
+		ERR(goto done);
+	if ( SSL_set_fd(conn->ssl, fd) != 1 )
+		ERR(goto done);
+	if ( SSL_set_tlsext_host_name(conn->ssl, url->host) != 1 )
+		ERR(goto done);
+	if ( S->verify && (SSL_set1_host(conn->ssl, url->host) != 1) )
+		ERR(goto done);
+
+	if ( conn->session != NULL )
+		SSL_set_session(conn->ssl, conn->session);
+	if ( SSL_connect(conn->ssl) != 1 )
+		ERR(goto done);
+
+	retn = true;
+
+
+ done:
+	if ( addrs != NULL )
+		freeaddrinfo(addrs);
+	if ( !retn ) {
+		SSL_SESSION_free(conn->session);
+		conn->session = NULL;
+		_disconnect(conn);
+	}
+
+	return retn;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function writes a buffer to a connection.  The SIGPIPE signal
+ * generated by writing to a connection the server has closed is
+ * blocked and discarded so the failure is reported through the
+ * return value.
+ *
+ * \param conn	A pointer to the connection to be written to.
+ *
+ * \param bufr	The object containing the data to be written.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the data was written.
+ */
+
+static _Bool _send(struct connection *conn, CO(Buffer, bufr))
+
+{
+	_Bool retn = true;
+
+	unsigned char *p = bufr->get(bufr);
+
+	size_t left = bufr->size(bufr);
+
+	ssize_t cnt;
+
+	sigset_t pipe,
+		 mask;
+
+	struct timespec zero = {0, 0};
+
+
+	sigemptyset(&pipe);
+	sigaddset(&pipe, SIGPIPE);
+	pthread_sigmask(SIG_BLOCK, &pipe, &mask);
+
+	while ( left > 0 ) {
+		if ( conn->ssl != NULL )
+			cnt = SSL_write(conn->ssl, p, left);
+		else
+			cnt = write(conn->fd, p, left);
+		if ( (cnt < 0) && (conn->ssl == NULL) && (errno == EINTR) )
+			continue;
+		if ( cnt <= 0 ) {
+			retn = false;
+			break;
+		}
+		p    += cnt;
+		left -= cnt;
+	}
+
+	if ( !retn && !sigismember(&mask, SIGPIPE) )
+		while ( sigtimedwait(&pipe, NULL, &zero) == SIGPIPE )
+			continue;
+	pthread_sigmask(SIG_SETMASK, &mask, NULL);
+
+	return retn;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function reads additional data from a connection into its
+ * receive buffer.
+ *
+ * \param conn	A pointer to the connection to be read from.
+ *
+ * \return	The number of bytes read is returned.  A value of zero
+ *		indicates the server has closed the connection and a
+ *		negative value indicates an error or timeout.
+ */
+
+static ssize_t _fill(struct connection *conn)
+
+{
+	ssize_t cnt;
+
+	struct pollfd pfd;
+
+
+	if ( conn->start == conn->end ) {
+		conn->start = 0;
+		conn->end   = 0;
+	} else if ( conn->start > 0 ) {
+		memmove(conn->bufr, conn->bufr + conn->start, \
+			conn->end - conn->start);
+		conn->end  -= conn->start;
+		conn->start = 0;
+	}
+
+	if ( (conn->ssl == NULL) || (SSL_pending(conn->ssl) == 0) ) {
+		pfd.fd	    = conn->fd;
+		pfd.events  = POLLIN;
+		pfd.revents = 0;
+		if ( poll(&pfd, 1, RECEIVE_TIMEOUT * 1000) != 1 )
+			return -1;
+	}
+
+	do {
+		if ( conn->ssl != NULL )
+			cnt = SSL_read(conn->ssl, conn->bufr + conn->end, \
+				       sizeof(conn->bufr) - conn->end);
+		else
+			cnt = read(conn->fd, conn->bufr + conn->end, \
+				   sizeof(conn->bufr) - conn->end);
+	} while ( (cnt < 0) && (conn->ssl == NULL) && (errno == EINTR) );
+
+	if ( (cnt < 0) && (conn->ssl != NULL) && \
+	     (SSL_get_error(conn->ssl, cnt) == SSL_ERROR_ZERO_RETURN) )
+		cnt = 0;
+	if ( cnt > 0 )
+		conn->end += cnt;
+
+	return cnt;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function reads a line terminated by a newline from a
+ * connection.  The line, including its terminator, is appended to
+ * the supplied object.
+ *
+ * \param conn	A pointer to the connection to be read from.
+ *
+ * \param line	The object which the line is to be added to.
+ *
+ * \return	A value of one is returned if a line was read.  A value
+ *		of zero indicates the connection was closed before any
+ *		data was read and a negative value indicates an error.
+ */
+
+static int _read_line(struct connection *conn, CO(Buffer, line))
+
+{
+	_Bool read = false;
+
+	uint8_t *p;
+
+	size_t len;
+
+	ssize_t cnt;
+
+
+	while ( true ) {
+		p = memchr(conn->bufr + conn->start, '\n', \
+			   conn->end - conn->start);
+		len = (p == NULL) ? conn->end - conn->start : \
+			p - (conn->bufr + conn->start) + 1;
+		if ( len > 0 ) {
+			read = true;
+			if ( !line->add(line, conn->bufr + conn->start, len) )
+				return -1;
+			conn->start += len;
+		}
+		if ( p != NULL )
+			return 1;
+
+		if ( (cnt = _fill(conn)) < 0 )
+			return -1;
+		if ( cnt == 0 )
+			return read ? -1 : 0;
+	}
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function reads a specified amount of data from a connection.
+ *
+ * \param conn		A pointer to the connection to be read from.
+ *
+ * \param output	The object which the data is to be added to.
+ *
+ * \param length	The number of bytes to be read.  A value of
+ *			SIZE_MAX reads until the connection is closed.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the data was read.
+ */
+
+static _Bool _read_body(struct connection *conn, CO(Buffer, output), \
+			size_t length)
+
+{
+	_Bool eof = (length == SIZE_MAX);
+
+	size_t len;
+
+	ssize_t cnt;
+
+
+	while ( length > 0 ) {
+		len = conn->end - conn->start;
+		if ( len > length )
+			len = length;
+		if ( len > 0 ) {
+			if ( !output->add(output, conn->bufr + conn->start, \
+					  len) )
+				return false;
+			conn->start += len;
+			length	    -= len;
+			continue;
+		}
+
+		if ( (cnt = _fill(conn)) < 0 )
+			return false;
+		if ( cnt == 0 )
+			return eof;
+	}
+
+	return true;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function reads a body which has been sent with chunked
+ * transfer encoding.  The chunk framing and any trailer fields are
+ * removed.
+ *
+ * \param conn		A pointer to the connection to be read from.
+ *
+ * \param output	The object which the body is to be added to.
+ *
+ * \param line		An object used to hold the framing lines.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the body was read.
+ */
+
+static _Bool _read_chunked(struct connection *conn, CO(Buffer, output), \
+			   CO(Buffer, line))
+
+{
+	char *ep;
+
+	size_t size;
+
+
+	while ( true ) {
+		line->reset(line);
+		if ( (_read_line(conn, line) != 1) || \
+		     !line->add(line, (unsigned char *) "\0", 1) )
+			return false;
+		size = strtoul((char *) line->get(line), &ep, 16);
+		if ( ep == (char *) line->get(line) )
+			return false;
+
+		if ( size == 0 )
+			break;
+		if ( !_read_body(conn, output, size) )
+			return false;
+
+		line->reset(line);
+		if ( _read_line(conn, line) != 1 )
+			return false;
+	}
+
+	/* Discard the trailer. */
+	do {
+		line->reset(line);
+		if ( _read_line(conn, line) != 1 )
+			return false;
+	} while ( line->size(line) > 2 );
+
+	return true;
+}
+
+
+/**
+ * Internal private method.
+ *
+ * This method reads the response to a request from a connection.
+ * Interim responses are discarded.  If headers are being saved the
+ * header block is placed in the output object ahead of the body
+ * consistent with the output of the wget utility.
+ *
+ * \param S		A pointer to the state of the object which
+ *			issued the request.
+ *
+ * \param conn		A pointer to the connection the response is to
+ *			be read from.
+ *
+ * \param output	The object which the response is to be loaded
+ *			into.
+ *
+ * \param status	A pointer to the variable which will be loaded
+ *			with the status code of the response.
+ *
+ * \param keep		A pointer to the variable which will be set
+ *			to indicate whether or not the connection can
+ *			carry further requests.
+ *
+ * \return		A value of one is returned if a response was
+ *			read.  A value of zero indicates the connection
+ *			was closed before a response was started and
+ *			the request can be retried.  A negative value
+ *			indicates an error.
+ */
+
+static int _receive(CO(HTTP_State, S), struct connection *conn, \
+		    CO(Buffer, output), int *status, _Bool *keep)
+
+{
+	_Bool chunked;
+
+	char *p;
+
+	int rc,
+	    minor;
+
+	size_t length;
+
+	Buffer line	= NULL,
+	       headers	= NULL;
+
+
+	INIT(HurdLib, Buffer, line, ERR(rc = -1; goto done));
+	INIT(HurdLib, Buffer, headers, ERR(rc = -1; goto done));
+
+	do {
+		headers->reset(headers);
+		chunked = false;
+		length	= SIZE_MAX;
+
+		/* Read and parse the status line. */
+		line->reset(line);
+		if ( (rc = _read_line(conn, line)) != 1 )
+			goto done;
+		if ( !headers->add_Buffer(headers, line) || \
+		     !line->add(line, (unsigned char *) "\0", 1) )
+			ERR(rc = -1; goto done);
+
+		p = (char *) line->get(line);
+		if ( sscanf(p, "HTTP/1.%d %3d", &minor, status) != 2 )
+			ERR(rc = -1; goto done);
+		*keep = (minor > 0);
+
+		/* Read the header fields. */
+		do {
+			line->reset(line);
+			if ( _read_line(conn, line) != 1 )
+				ERR(rc = -1; goto done);
+			if ( !headers->add_Buffer(headers, line) || \
+			     !line->add(line, (unsigned char *) "\0", 1) )
+				ERR(rc = -1; goto done);
+
+			p = (char *) line->get(line);
+			if ( strncasecmp(p, "Content-Length:", 15) == 0 )
+				length = strtoul(p + 15, NULL, 10);
+			if ( (strncasecmp(p, "Transfer-Encoding:", 18) == 0) \
+			     && (strstr(p, "chunked") != NULL) )
+				chunked = true;
+			if ( strncasecmp(p, "Connection:", 11) == 0 ) {
+				if ( strcasestr(p, "close") != NULL )
+					*keep = false;
+				if ( strcasestr(p, "keep-alive") != NULL )
+					*keep = true;
+			}
+		} while ( line->size(line) > 3 );
+	} while ( (*status >= 100) && (*status < 200) );
+
+
+	/* Read the body. */
+	if ( S->save_headers && !output->add_Buffer(output, headers) )
+		ERR(rc = -1; goto done);
+
+	if ( (*status == 204) || (*status == 304) )
+		length = 0;
+
+	if ( chunked ) {
+		if ( !_read_chunked(conn, output, line) )
+			ERR(rc = -1; goto done);
+	} else {
+		if ( length == SIZE_MAX )
+			*keep = false;
+		if ( !_read_body(conn, output, length) )
+			ERR(rc = -1; goto done);
+	}
+
+	rc = 1;
 
-	/* Library identifier. */
-	uint32_t libid;
 
-	/* Object identifier. */
-	uint32_t objid;
+ done:
+	if ( rc != 1 )
+		*keep = false;
 
-	/* Object status. */
-	_Bool poisoned;
+	WHACK(line);
+	WHACK(headers);
 
-	/* Command-line arguements and pointers. */
-	Buffer args;
-};
+	return rc;
+}
 
 
 /**
  * Internal private method.
  *
- * This method is responsible for initializing the NAAAIM_HTTP_State
- * structure which holds state information for each instantiated object.
+ * This method adds a POST request to the set of requests which are
+ * to be transmitted to a server.
  *
- * \param S A pointer to the object containing the state information which
- *        is to be initialized.
+ * \param S		A pointer to the state of the object issueing
+ *			the request.
+ *
+ * \param url		A pointer to the structure describing the URL
+ *			the request is directed to.
+ *
+ * \param input		The object containing the data to be posted.
+ *
+ * \param request	The object which the request is to be added
+ *			to.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the request was added.
  */
 
-static void _init_state(CO(HTTP_State, S)) {
+static _Bool _request(CO(HTTP_State, S), CO(struct url *, url), \
+		      CO(Buffer, input), CO(Buffer, request))
 
-	S->libid = NAAAIM_LIBID;
-	S->objid = NAAAIM_HTTP_OBJID;
+{
+	_Bool content_type = false;
 
-	S->poisoned  = false;
+	char *p;
 
-	return;
+	String hdr = NULL;
+
+
+	/* Locate a caller supplied content type. */
+	if ( S->headers != NULL ) {
+		p = S->headers->get(S->headers);
+		while ( *p != '\0' ) {
+			if ( strncasecmp(p, "Content-Type:", 13) == 0 )
+				content_type = true;
+			if ( (p = strstr(p, "\r\n")) == NULL )
+				break;
+			p += 2;
+		}
+	}
+
+	INIT(HurdLib, String, hdr, return false);
+
+	hdr->add_sprintf(hdr, "POST %s HTTP/1.1\r\n", url->path);
+	if ( (strcmp(url->port, url->tls ? "443" : "80") == 0) )
+		hdr->add_sprintf(hdr, "Host: %s\r\n", url->host);
+	else
+		hdr->add_sprintf(hdr, "Host: %s:%s\r\n", url->host, url->port);
+	hdr->add(hdr, "Accept: */*\r\n");
+	hdr->add(hdr, "Connection: keep-alive\r\n");
+	if ( !content_type )
+		hdr->add(hdr, "Content-Type: " \
+			 "application/x-www-form-urlencoded\r\n");
+	hdr->add_sprintf(hdr, "Content-Length: %zu\r\n", input->size(input));
+	if ( S->headers != NULL )
+		hdr->add(hdr, S->headers->get(S->headers));
+	hdr->add(hdr, "\r\n");
+
+	if ( hdr->poisoned(hdr) )
+		ERR(goto done);
+	if ( !request->add(request, (unsigned char *) hdr->get(hdr), \
+			   hdr->size(hdr)) )
+		ERR(goto done);
+	request->add_Buffer(request, input);
+
+
+ done:
+	WHACK(hdr);
+
+	return !request->poisoned(request);
 }
 
 
 /**
- * External public method.
+ * Internal private method.
  *
- * This method implements a method for adding an arguement to the
- * set of command-line arguements which will be passed to the wget
- * utility.
+ * This method carries out a set of POST requests to a single server
+ * over a persistent connection.  The requests are written to the
+ * connection together and the responses are read in order.  If the
+ * server closes the connection before all of the responses have been
+ * read the unanswered requests are resent over a new connection.
  *
- * \param this		A pointer to the object which will execute
- *			the HTTP request.
+ * \param S		A pointer to the state of the object issueing
+ *			the requests.
  *
- * \param arg		A pointer to the null-terminated character
- *			buffer containing the command-line arguement
- *			to be added.
+ * \param reqs		A pointer to the array of structures
+ *			describing the requests.
  *
- * \return	If an error is encountered while adding the
- *		command-line arguement a false value is returned.  A
- *		true value indicates the arguement was successfully
- *		added.
+ * \param cnt		The number of requests in the array.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not all of the requests were successful.
  */
 
-static _Bool add_arg(CO(HTTP, this), CO(char *, arg))
+static _Bool _post_native(CO(HTTP_State, S), CO(struct request *, reqs), \
+			  const size_t cnt)
 
 {
-	STATE(S);
+	_Bool keep  = false,
+	      retn  = false,
+	      fresh;
 
-	_Bool retn = false;
+	int rc,
+	    status;
 
-	String entry;
+	size_t lp,
+	       first,
+	       done = 0;
 
+	struct url url;
 
-	/* Validate object. */
-	if ( S->poisoned )
-		ERR(goto done);
+	struct connection *conn = NULL;
 
+	Buffer request = NULL;
 
-	/* Add the pointer to the current arguement list. */
-	INIT(HurdLib, String, entry, ERR(goto done));
-	if ( !entry->add(entry, arg) )
+	String key = NULL;
+
+
+	if ( !_parse_url(reqs[0].url->get(reqs[0].url), &url) )
 		ERR(goto done);
 
-	if ( !S->args->add(S->args, (void *) &entry, sizeof(entry)) )
+	INIT(HurdLib, Buffer, request, ERR(goto done));
+	INIT(HurdLib, String, key, ERR(goto done));
+	if ( !_connection_key(S, &url, key) )
 		ERR(goto done);
+	if ( (conn = _checkout(key->get(key))) == NULL )
+		ERR(goto done);
+
+
+	while ( done < cnt ) {
+		fresh = (conn->fd == -1);
+		if ( fresh && !_connect(S, conn, &url) )
+			ERR(goto done);
+
+		request->reset(request);
+		for (lp= done; lp < cnt; ++lp) {
+			if ( !_parse_url(reqs[lp].url->get(reqs[lp].url), &url) )
+				ERR(goto done);
+			if ( !_request(S, &url, reqs[lp].input, request) )
+				ERR(goto done);
+		}
+
+		if ( !_send(conn, request) ) {
+			_disconnect(conn);
+			if ( fresh )
+				ERR(goto done);
+			continue;
+		}
+
+		first = done;
+		for (lp= done; lp < cnt; ++lp) {
+			rc = _receive(S, conn, reqs[lp].output, &status, &keep);
+			if ( rc < 0 )
+				ERR(goto done);
+			if ( (rc == 0) && fresh && (lp == first) )
+				ERR(goto done);
+			if ( rc == 0 )
+				break;
+
+			++done;
+			if ( (status < 200) || (status >= 300) ) {
+				fprintf(stderr, "HTTP status: %d\n", status);
+				ERR(goto done);
+			}
+			if ( !keep )
+				break;
+		}
+
+		if ( !keep )
+			_disconnect(conn);
+	}
+
 	retn = true;
 
 
  done:
-	if ( !retn )
-		S->poisoned = true;
+	if ( conn != NULL )
+		_checkin(conn, retn && keep);
+
+	WHACK(request);
+	WHACK(key);
 
 	return retn;
 }
 
 
 /**
- * External public method.
+ * Internal private method.
  *
- * This method implements a method for issueing a POST command to
- * a server with capturing of the message body of the server.
+ * This method implements issueing a POST command by executing the
+ * wget utility with the command-line arguements which have been
+ * added to the object.  It is used when an arguement has been added
+ * which the native client does not implement or when use of the
+ * utility has been requested.
  *
- * \param this		A pointer to the object which will execute
- *			the the POST command.
+ * \param S		A pointer to the state of the object which will
+ *			execute the POST command.
  *
  * \param url		A pointer to a null-terminated buffer
  *			containing the URL which the post is to be
@@ -180,12 +1472,10 @@ static _Bool add_arg(CO(HTTP, this), CO(char *, arg))
  *		any data.
  */
 
-static _Bool post(CO(HTTP, this), CO(char *, url), CO(Buffer, input), \
-		  CO(Buffer, output))
+static _Bool _post_wget(CO(HTTP_State, S), CO(char *, url), \
+		       CO(Buffer, input), CO(Buffer, output))
 
 {
-	STATE(S);
-
 	_Bool retn = false;
 
 	int rc,
@@ -360,6 +1650,233 @@ static _Bool post(CO(HTTP, this), CO(char *, url), CO(Buffer, input), \
 }
 
 
+
+
+/**
+ * External public method.
+ *
+ * This method implements issueing a POST command to the specified
+ * URL.
+ *
+ * \param this		A pointer to the object which will execute
+ *			the POST command.
+ *
+ * \param url		A pointer to a null-terminated buffer
+ *			containing the URL which the post is to be
+ *			directed to.
+ *
+ * \param input		A pointer to the buffer containing the data
+ *			that is to be posted to the server.
+ *
+ * \param output	A pointer to the buffer that will contain the
+ *			results of the post command.
+ *
+ * \return	If an error is encountered while executing the command
+ *		a false value is returned.  A true value indicates the
+ *		command was successfully processed.  It is important
+ *		to note that a successful response does not
+ *		necessarily imply that the output buffer will contain
+ *		any data.
+ */
+
+static _Bool post(CO(HTTP, this), CO(char *, url), CO(Buffer, input), \
+		  CO(Buffer, output))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	struct url parsed;
+
+	struct request request = {NULL, input, output};
+
+
+	/* Validate object and inputs. */
+	if ( S->poisoned )
+		ERR(goto done);
+	if ( input->poisoned(input) )
+		ERR(goto done);
+	if ( output->poisoned(output) )
+		ERR(goto done);
+
+	if ( S->wget || !_parse_url(url, &parsed) ) {
+		retn = _post_wget(S, url, input, output);
+		goto done;
+	}
+
+
+	/* Issue the request with the native client. */
+	INIT(HurdLib, String, request.url, ERR(goto done));
+	if ( !request.url->add(request.url, url) )
+		ERR(goto done);
+
+	retn = _post_native(S, &request, 1);
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+
+	WHACK(request.url);
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method queues a POST command for transmission by the ->flush
+ * method.  The input and output objects are referenced rather than
+ * copied and must remain valid until the queue has been flushed.
+ *
+ * \param this		A pointer to the object which will execute
+ *			the POST command.
+ *
+ * \param url		A pointer to a null-terminated buffer
+ *			containing the URL which the post is to be
+ *			directed to.
+ *
+ * \param input		A pointer to the buffer containing the data
+ *			that is to be posted to the server.
+ *
+ * \param output	A pointer to the buffer that will contain the
+ *			results of the post command.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the command was queued.
+ */
+
+static _Bool queue(CO(HTTP, this), CO(char *, url), CO(Buffer, input), \
+		   CO(Buffer, output))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	struct request request = {NULL, input, output};
+
+
+	/* Validate object and inputs. */
+	if ( S->poisoned )
+		ERR(goto done);
+	if ( input->poisoned(input) )
+		ERR(goto done);
+	if ( output->poisoned(output) )
+		ERR(goto done);
+
+	INIT(HurdLib, String, request.url, ERR(goto done));
+	if ( !request.url->add(request.url, url) )
+		ERR(goto done);
+
+	if ( !S->queue->add(S->queue, (void *) &request, sizeof(request)) )
+		ERR(goto done);
+	retn = true;
+
+
+ done:
+	if ( !retn ) {
+		S->poisoned = true;
+		WHACK(request.url);
+	}
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method transmits the POST commands which have been queued.
+ * Consecutive commands which are directed to the same server are
+ * pipelined over a single connection.  The queue is emptied
+ * whether or not the commands are successful.
+ *
+ * \param this	A pointer to the object whose queued commands are
+ *		to be transmitted.
+ *
+ * \return	If an error is encountered while executing any of the
+ *		commands a false value is returned.  A true value
+ *		indicates all of the commands were successfully
+ *		processed.
+ */
+
+static _Bool flush(CO(HTTP, this))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	size_t lp,
+	       run,
+	       cnt = S->queue->size(S->queue) / sizeof(struct request);
+
+	struct url parsed;
+
+	struct request *reqs = (struct request *) S->queue->get(S->queue);
+
+	String key  = NULL,
+	       next = NULL;
+
+
+	/* Validate object. */
+	if ( S->poisoned )
+		ERR(goto done);
+
+	INIT(HurdLib, String, key, ERR(goto done));
+	INIT(HurdLib, String, next, ERR(goto done));
+
+
+	for (lp= 0; lp < cnt; lp += run) {
+		run = 1;
+
+		if ( S->wget || \
+		     !_parse_url(reqs[lp].url->get(reqs[lp].url), &parsed) ) {
+			if ( !_post_wget(S, reqs[lp].url->get(reqs[lp].url), \
+					 reqs[lp].input, reqs[lp].output) )
+				ERR(goto done);
+			continue;
+		}
+
+		/* Find the requests directed to the same server. */
+		if ( !_connection_key(S, &parsed, key) )
+			ERR(goto done);
+		while ( (lp + run) < cnt ) {
+			if ( !_parse_url(reqs[lp + run].url->get(reqs[lp + run].url),\
+					 &parsed) )
+				break;
+			if ( !_connection_key(S, &parsed, next) )
+				ERR(goto done);
+			if ( strcmp(key->get(key), next->get(next)) != 0 )
+				break;
+			++run;
+		}
+
+		if ( !_post_native(S, &reqs[lp], run) )
+			ERR(goto done);
+	}
+
+	retn = true;
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+
+	for (lp= 0; lp < cnt; ++lp)
+		WHACK(reqs[lp].url);
+	S->queue->reset(S->queue);
+
+	WHACK(key);
+	WHACK(next);
+
+	return retn;
+}
+
+
 /**
  * External public method.
  *
@@ -373,10 +1890,25 @@ static void whack(CO(HTTP, this))
 {
 	STATE(S);
 
+	size_t cnt = S->queue->size(S->queue) / sizeof(struct request);
+
+	struct request *reqs = (struct request *) S->queue->get(S->queue);
+
+
+	while ( cnt-- ) {
+		WHACK(reqs->url);
+		++reqs;
+	}
+	WHACK(S->queue);
 
 	GWHACK(String, S->args);
 	WHACK(S->args);
 
+	WHACK(S->headers);
+	WHACK(S->ca_file);
+	WHACK(S->certificate);
+	WHACK(S->private_key);
+
 	S->root->whack(S->root, this, S);
 	return;
 }
@@ -418,11 +1950,15 @@ extern HTTP NAAAIM_HTTP_Init(void)
 
 	/* Initialize aggregate objects. */
 	INIT(HurdLib, Buffer, this->state->args, goto err);
+	INIT(HurdLib, Buffer, this->state->queue, goto err);
 
 	/* Method initialization. */
-	this->post = post;
+	this->post  = post;
+	this->queue = queue;
+	this->flush = flush;
 
-	this->add_arg = add_arg;
+	this->add_arg  = add_arg;
+	this->use_wget = use_wget;
 
 	this->whack = whack;
 
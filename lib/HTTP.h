@@ -26,8 +26,11 @@ typedef struct NAAAIM_HTTP_State * HTTP_State;
 struct NAAAIM_HTTP
 {
 	_Bool (*add_arg)(const HTTP, const char *);
+	void (*use_wget)(const HTTP, const _Bool);
 
 	_Bool (*post)(const HTTP, const char *, const Buffer, const Buffer);
+	_Bool (*queue)(const HTTP, const char *, const Buffer, const Buffer);
+	_Bool (*flush)(const HTTP);
 
 	void (*whack)(const HTTP);
 
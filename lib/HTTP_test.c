@@ -0,0 +1,671 @@
+/** \file
+ * This file implements a test driver for the HTTP object.
+ *
+ * A stub HTTP/1.1 server is started on the loopback interface which
+ * echoes the body of each POST request.  The server numbers the
+ * connections it accepts so the test can verify that connections are
+ * reused between posts and that queued posts are pipelined over a
+ * single connection.  The -B option also measures the number of
+ * posts per second completed by the native client, by pipelined
+ * queues and by the wget utility.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+/* Local defines. */
+#define _GNU_SOURCE
+
+/* Number of posts which are queued by the pipelining test. */
+#define QUEUE_SIZE 10
+
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <strings.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include <HurdLib.h>
+#include <Buffer.h>
+#include <String.h>
+
+#include <NAAAIM.h>
+#include "HTTP.h"
+
+
+/* Base URL of the stub server. */
+static char Server[64];
+
+
+/**
+ * Private function.
+ *
+ * This function returns the number of seconds which have elapsed
+ * since the supplied starting time.
+ *
+ * \param start	A pointer to the structure containing the starting
+ *		time.
+ *
+ * \return	The number of elapsed seconds.
+ */
+
+static double elapsed(const struct timespec *start)
+
+{
+	struct timespec end;
+
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) + \
+		(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function writes a response to a client connection.
+ *
+ * \param fd		The client connection.
+ *
+ * \param response	A pointer to the buffer containing the response.
+ *
+ * \param len		The length of the response.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the response was written.
+ */
+
+static _Bool send_all(int fd, const char *response, size_t len)
+
+{
+	ssize_t cnt;
+
+
+	while ( len > 0 ) {
+		if ( (cnt = write(fd, response, len)) <= 0 )
+			return false;
+		response += cnt;
+		len	 -= cnt;
+	}
+
+	return true;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function services the requests received over a client
+ * connection until the client closes the connection.  The response
+ * to a request is selected by the path of the request.
+ *
+ * \param fd		The client connection.
+ *
+ * \param number	The number of the connection.
+ */
+
+static void serve(int fd, unsigned int number)
+
+{
+	_Bool close_conn;
+
+	char *p,
+	     *ep,
+	     path[64],
+	     hdr[256],
+	     bufr[65536];
+
+	size_t length,
+	       have = 0;
+
+	ssize_t cnt;
+
+
+	while ( true ) {
+		/* Read a complete request. */
+		while ( (ep = memmem(bufr, have, "\r\n\r\n", 4)) == NULL ) {
+			if ( (cnt = read(fd, bufr + have, \
+					 sizeof(bufr) - have - 1)) <= 0 )
+				return;
+			have += cnt;
+		}
+
+		*ep = '\0';
+		p = strcasestr(bufr, "Content-Length:");
+		length = (p != NULL) ? strtoul(p + 15, NULL, 10) : 0;
+		close_conn = (strcasestr(bufr, "Connection: close") != NULL);
+		if ( sscanf(bufr, "POST %63s", path) != 1 )
+			return;
+		ep += 4;
+
+		while ( have < (ep - bufr + length) ) {
+			if ( (cnt = read(fd, bufr + have, \
+					 sizeof(bufr) - have - 1)) <= 0 )
+				return;
+			have += cnt;
+		}
+
+
+		/* Generate the response. */
+		if ( strcmp(path, "/chunked") == 0 ) {
+			snprintf(hdr, sizeof(hdr), "HTTP/1.1 200 OK\r\n"   \
+				 "X-Connection: %u\r\n"			   \
+				 "Transfer-Encoding: chunked\r\n\r\n"	   \
+				 "7\r\nchunked\r\n6\r\n reply\r\n0\r\n"	   \
+				 "X-Trailer: done\r\n\r\n", number);
+			if ( !send_all(fd, hdr, strlen(hdr)) )
+				return;
+		}
+		else if ( strcmp(path, "/close") == 0 ) {
+			snprintf(hdr, sizeof(hdr), "HTTP/1.1 200 OK\r\n" \
+				 "X-Connection: %u\r\n"			 \
+				 "Connection: close\r\n\r\n", number);
+			if ( !send_all(fd, hdr, strlen(hdr)) )
+				return;
+			send_all(fd, ep, length);
+			return;
+		}
+		else if ( strcmp(path, "/error") == 0 ) {
+			snprintf(hdr, sizeof(hdr), "HTTP/1.1 500 Error\r\n" \
+				 "X-Connection: %u\r\n"			    \
+				 "Content-Length: 5\r\n\r\nerror", number);
+			if ( !send_all(fd, hdr, strlen(hdr)) )
+				return;
+		}
+		else {
+			snprintf(hdr, sizeof(hdr), "%s"			   \
+				 "HTTP/1.1 200 OK\r\n"			   \
+				 "X-Connection: %u\r\n"			   \
+				 "Content-Length: %zu\r\n\r\n",		   \
+				 strcmp(path, "/continue") == 0 ?	   \
+				 "HTTP/1.1 100 Continue\r\n\r\n" : "",	   \
+				 number, length);
+			if ( !send_all(fd, hdr, strlen(hdr)) )
+				return;
+			if ( !send_all(fd, ep, length) )
+				return;
+		}
+
+		if ( close_conn )
+			return;
+
+		/* Retain any pipelined requests. */
+		have -= (ep + length) - bufr;
+		memmove(bufr, ep + length, have);
+	}
+}
+
+
+/**
+ * Private function.
+ *
+ * This function starts the stub server on an ephemeral port of the
+ * loopback interface.  Each connection accepted is serviced by a
+ * separate process.
+ *
+ * \return	The process identifier of the server is returned.  A
+ *		negative value indicates the server could not be
+ *		started.
+ */
+
+static pid_t start_server(void)
+
+{
+	int fd,
+	    client,
+	    flag = 1;
+
+	unsigned int number = 0;
+
+	socklen_t len;
+
+	pid_t pid;
+
+	struct sockaddr_in addr;
+
+
+	if ( (fd = socket(AF_INET, SOCK_STREAM, 0)) == -1 )
+		return -1;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &flag, sizeof(flag));
+
+	memset(&addr, '\0', sizeof(addr));
+	addr.sin_family	     = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if ( bind(fd, (struct sockaddr *) &addr, sizeof(addr)) == -1 )
+		return -1;
+	if ( listen(fd, 64) == -1 )
+		return -1;
+
+	len = sizeof(addr);
+	if ( getsockname(fd, (struct sockaddr *) &addr, &len) == -1 )
+		return -1;
+	snprintf(Server, sizeof(Server), "http://127.0.0.1:%u", \
+		 ntohs(addr.sin_port));
+
+	if ( (pid = fork()) != 0 ) {
+		close(fd);
+		return pid;
+	}
+
+	signal(SIGCHLD, SIG_IGN);
+	while ( true ) {
+		if ( (client = accept(fd, NULL, NULL)) == -1 )
+			continue;
+		setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &flag, \
+			   sizeof(flag));
+		++number;
+		if ( fork() == 0 ) {
+			close(fd);
+			serve(client, number);
+			_exit(0);
+		}
+		close(client);
+	}
+}
+
+
+/**
+ * Private function.
+ *
+ * This function posts a string to a path on the stub server.
+ *
+ * \param http		The object which is to issue the post.
+ *
+ * \param path		A pointer to the null-terminated buffer
+ *			containing the path of the request.
+ *
+ * \param data		A pointer to the null-terminated buffer
+ *			containing the data to be posted.
+ *
+ * \param output	The object which the response is to be loaded
+ *			into.  The response is null-terminated.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the post was successful.
+ */
+
+static _Bool post(CO(HTTP, http), CO(char *, path), CO(char *, data), \
+		  CO(Buffer, output))
+
+{
+	_Bool retn = false;
+
+	char url[128];
+
+	Buffer input = NULL;
+
+
+	INIT(HurdLib, Buffer, input, ERR(goto done));
+	if ( !input->add(input, (unsigned char *) data, strlen(data)) )
+		ERR(goto done);
+
+	snprintf(url, sizeof(url), "%s%s", Server, path);
+	output->reset(output);
+	if ( !http->post(http, url, input, output) )
+		goto done;
+	if ( !output->add(output, (unsigned char *) "\0", 1) )
+		ERR(goto done);
+	retn = true;
+
+
+ done:
+	WHACK(input);
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function returns the connection number reported by the stub
+ * server in a response which includes the response headers.
+ *
+ * \param output	The object containing the response.
+ *
+ * \return		The connection number is returned.  A value of
+ *			zero indicates the number was not found.
+ */
+
+static unsigned int connection(CO(Buffer, output))
+
+{
+	char *p;
+
+
+	if ( (p = strstr((char *) output->get(output), "X-Connection:")) \
+	     == NULL )
+		return 0;
+	return strtoul(p + 13, NULL, 10);
+}
+
+
+/**
+ * Private function.
+ *
+ * This function reports the result of a test.
+ *
+ * \param name	A pointer to the null-terminated buffer containing the
+ *		name of the test.
+ *
+ * \param ok	The result of the test.
+ *
+ * \return	The result of the test is returned.
+ */
+
+static _Bool report(CO(char *, name), const _Bool ok)
+
+{
+	fprintf(stdout, "%-40s %s\n", name, ok ? "OK" : "FAILED");
+	return ok;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function verifies the native client against the stub server.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		all of the tests passed.
+ */
+
+static _Bool verify(void)
+
+{
+	_Bool ok,
+	      retn = false;
+
+	char *body,
+	     data[96];
+
+	unsigned int lp,
+		     first;
+
+	Buffer output = NULL,
+	       inputs[QUEUE_SIZE],
+	       outputs[QUEUE_SIZE];
+
+	HTTP http = NULL;
+
+
+	memset(inputs, '\0', sizeof(inputs));
+	memset(outputs, '\0', sizeof(outputs));
+	INIT(HurdLib, Buffer, output, ERR(goto done));
+
+
+	/* Basic post. */
+	INIT(NAAAIM, HTTP, http, ERR(goto done));
+	http->add_arg(http, "-q");
+	ok = post(http, "/echo", "hello", output) && \
+		(strcmp((char *) output->get(output), "hello") == 0);
+	if ( !report("Post", ok) )
+		goto done;
+	WHACK(http);
+
+	/* Saved headers and connection reuse. */
+	INIT(NAAAIM, HTTP, http, ERR(goto done));
+	http->add_arg(http, "--save-headers");
+	ok = post(http, "/echo", "first", output);
+	first = connection(output);
+	body = strstr((char *) output->get(output), "\r\n\r\n");
+	ok = ok && (strncmp((char *) output->get(output), "HTTP/1.1 200", \
+			    12) == 0) && (body != NULL) &&		  \
+		(strcmp(body + 4, "first") == 0);
+	if ( !report("Saved headers", ok) )
+		goto done;
+
+	ok = post(http, "/echo", "second", output) && (first != 0) && \
+		(connection(output) == first);
+	if ( !report("Connection reuse", ok) )
+		goto done;
+
+	/* Interim response. */
+	ok = post(http, "/continue", "continue", output) && \
+		(strstr((char *) output->get(output), "100 Continue") == NULL);
+	if ( !report("Interim response", ok) )
+		goto done;
+	WHACK(http);
+
+	/* Chunked transfer encoding. */
+	INIT(NAAAIM, HTTP, http, ERR(goto done));
+	ok = post(http, "/chunked", "", output) && \
+		(strcmp((char *) output->get(output), "chunked reply") == 0);
+	if ( !report("Chunked response", ok) )
+		goto done;
+
+	/* Closed connection followed by a new connection. */
+	http->add_arg(http, "--save-headers");
+	ok = post(http, "/close", "closed", output);
+	first = connection(output);
+	body = strstr((char *) output->get(output), "\r\n\r\n");
+	ok = ok && (body != NULL) && (strcmp(body + 4, "closed") == 0);
+	ok = ok && post(http, "/echo", "reopened", output) && \
+		(connection(output) > first);
+	if ( !report("Connection close", ok) )
+		goto done;
+	WHACK(http);
+
+	/* Error status. */
+	INIT(NAAAIM, HTTP, http, ERR(goto done));
+	ok = !post(http, "/error", "error", output);
+	if ( !report("Error status", ok) )
+		goto done;
+	WHACK(http);
+
+	/* Pipelined posts. */
+	INIT(NAAAIM, HTTP, http, ERR(goto done));
+	for (lp= 0; lp < QUEUE_SIZE; ++lp) {
+		INIT(HurdLib, Buffer, inputs[lp], ERR(goto done));
+		INIT(HurdLib, Buffer, outputs[lp], ERR(goto done));
+		snprintf(data, sizeof(data), "request %u", lp);
+		if ( !inputs[lp]->add(inputs[lp], (unsigned char *) data, \
+				      strlen(data)) )
+			ERR(goto done);
+		snprintf(data, sizeof(data), "%s/echo%u", Server, lp);
+		if ( !http->queue(http, data, inputs[lp], outputs[lp]) )
+			ERR(goto done);
+	}
+
+	ok = http->flush(http);
+	for (lp= 0; ok && (lp < QUEUE_SIZE); ++lp)
+		ok = inputs[lp]->equal(inputs[lp], outputs[lp]);
+	if ( !report("Pipelined posts", ok) )
+		goto done;
+	WHACK(http);
+
+	/* Equivalence with the wget utility. */
+	if ( system("wget --version >/dev/null 2>&1") == 0 ) {
+		INIT(NAAAIM, HTTP, http, ERR(goto done));
+		http->add_arg(http, "-q");
+		http->add_arg(http, "--header=Content-Type: application/json");
+		http->use_wget(http, true);
+		ok = post(http, "/echo", "{\"wget\": true}", output) && \
+			(strcmp((char *) output->get(output), \
+				"{\"wget\": true}") == 0);
+		if ( !report("Wget post", ok) )
+			goto done;
+		WHACK(http);
+	} else
+		fputs("Wget not available, skipping wget post.\n", stdout);
+
+	retn = true;
+
+
+ done:
+	for (lp= 0; lp < QUEUE_SIZE; ++lp) {
+		WHACK(inputs[lp]);
+		WHACK(outputs[lp]);
+	}
+	WHACK(output);
+	WHACK(http);
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function measures the rate at which posts are completed by
+ * the native client, by pipelined queues and by the wget utility.
+ * A new object is used for each post in the manner of the callers
+ * of the object.
+ *
+ * \param count	The number of posts to be completed by the native
+ *		client.  One tenth of this number of posts is issued
+ *		through the wget utility.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the benchmark was completed.
+ */
+
+static _Bool benchmark(const unsigned long int count)
+
+{
+	_Bool retn = false;
+
+	char url[128],
+	     data[512];
+
+	unsigned long int lp,
+			  cnt;
+
+	struct timespec start;
+
+	Buffer input  = NULL,
+	       output = NULL,
+	       outputs[QUEUE_SIZE];
+
+	HTTP http = NULL;
+
+
+	memset(outputs, '\0', sizeof(outputs));
+	INIT(HurdLib, Buffer, input, ERR(goto done));
+	INIT(HurdLib, Buffer, output, ERR(goto done));
+	for (lp= 0; lp < QUEUE_SIZE; ++lp)
+		INIT(HurdLib, Buffer, outputs[lp], ERR(goto done));
+
+	memset(data, 'x', sizeof(data));
+	if ( !input->add(input, (unsigned char *) data, sizeof(data)) )
+		ERR(goto done);
+	snprintf(url, sizeof(url), "%s/echo", Server);
+	fputs("\nPosts per second:\n", stdout);
+
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (lp= 0; lp < count; ++lp) {
+		INIT(NAAAIM, HTTP, http, ERR(goto done));
+		output->reset(output);
+		if ( !http->post(http, url, input, output) )
+			ERR(goto done);
+		WHACK(http);
+	}
+	fprintf(stdout, "  native:    %9.0f (%lu posts)\n", \
+		count / elapsed(&start), count);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (lp= 0; lp < count; lp += QUEUE_SIZE) {
+		INIT(NAAAIM, HTTP, http, ERR(goto done));
+		for (cnt= 0; cnt < QUEUE_SIZE; ++cnt) {
+			outputs[cnt]->reset(outputs[cnt]);
+			if ( !http->queue(http, url, input, outputs[cnt]) )
+				ERR(goto done);
+		}
+		if ( !http->flush(http) )
+			ERR(goto done);
+		WHACK(http);
+	}
+	fprintf(stdout, "  pipelined: %9.0f (%lu posts)\n", \
+		lp / elapsed(&start), lp);
+
+	cnt = count / 10;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (lp= 0; lp < cnt; ++lp) {
+		INIT(NAAAIM, HTTP, http, ERR(goto done));
+		http->add_arg(http, "-q");
+		http->use_wget(http, true);
+		output->reset(output);
+		if ( !http->post(http, url, input, output) )
+			ERR(goto done);
+		WHACK(http);
+	}
+	fprintf(stdout, "  wget:      %9.0f (%lu posts)\n", \
+		cnt / elapsed(&start), cnt);
+
+	retn = true;
+
+
+ done:
+	for (lp= 0; lp < QUEUE_SIZE; ++lp)
+		WHACK(outputs[lp]);
+	WHACK(input);
+	WHACK(output);
+	WHACK(http);
+
+	return retn;
+}
+
+
+extern int main(int argc, char *argv[])
+
+{
+	_Bool retn = 1,
+	      bench = false;
+
+	int opt;
+
+	unsigned long int count = 1000;
+
+	pid_t server;
+
+
+	while ( (opt = getopt(argc, argv, "Bn:")) != EOF )
+		switch ( opt ) {
+			case 'B':
+				bench = true;
+				break;
+			case 'n':
+				count = strtoul(optarg, NULL, 0);
+				break;
+		}
+
+
+	if ( (server = start_server()) < 0 ) {
+		fputs("Cannot start server.\n", stderr);
+		goto done;
+	}
+	fprintf(stdout, "Server: %s\n", Server);
+
+	if ( !verify() )
+		goto done;
+	if ( bench && !benchmark(count) )
+		goto done;
+
+	retn = 0;
+
+
+ done:
+	if ( server > 0 ) {
+		kill(server, SIGTERM);
+		waitpid(server, NULL, 0);
+	}
+
+	return retn;
+}
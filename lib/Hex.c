@@ -0,0 +1,598 @@
+/** \file
+ * This file implements the functions which convert between binary
+ * data and its ASCII hexadecimal representation.
+ *
+ * Digests are carried in hexadecimal form through the security event
+ * descriptions, the security model definitions and the trajectory and
+ * forensics output.  On x86 platforms the conversion routines in this
+ * file use the SSSE3 or AVX2 instruction sets in order to convert 16
+ * or 32 bytes of binary data per iteration.  The vector versions are
+ * compiled for these instructions independently of the build flags
+ * and are selected at runtime if the processor supports them.  A
+ * table driven scalar implementation is used for the remainder of
+ * the data, on processors without these instructions and in enclave
+ * and firmware builds.
+ *
+ * Decoding accepts either upper or lower case characters and fails
+ * if the input contains a character which is not a hexadecimal
+ * digit.  Encoding generates lower case characters.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+
+/* Include files. */
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+/*
+ * Runtime instruction set selection requires CPUID and the processor
+ * model data of the compiler runtime, neither of which is available
+ * to SGX enclave or Mini-OS builds.
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && \
+	!defined(SRDE_ENCLAVE) && !defined(__MINIOS__)
+#define HEX_X86
+#include <immintrin.h>
+#endif
+
+#include <HurdLib.h>
+#include <Buffer.h>
+#include <String.h>
+
+#include "Hex.h"
+
+
+/* Size of the local buffers used by the object helper functions. */
+#define HEX_CHUNK 128
+
+/* Hexadecimal digits used for encoding. */
+static const char Digits[] = "0123456789abcdef";
+
+/**
+ * Table which maps an ASCII character to one more than the value of
+ * the hexadecimal digit it represents.  Characters which are not
+ * hexadecimal digits have a zero value.
+ */
+static const uint8_t Nybble[256] = {
+	['0'] = 0x1, ['1'] = 0x2, ['2'] = 0x3, ['3'] = 0x4, ['4'] = 0x5,
+	['5'] = 0x6, ['6'] = 0x7, ['7'] = 0x8, ['8'] = 0x9, ['9'] = 0xa,
+	['A'] = 0xb, ['B'] = 0xc, ['C'] = 0xd, ['D'] = 0xe, ['E'] = 0xf,
+	['F'] = 0x10,
+	['a'] = 0xb, ['b'] = 0xc, ['c'] = 0xd, ['d'] = 0xe, ['e'] = 0xf,
+	['f'] = 0x10
+};
+
+
+/**
+ * Private function.
+ *
+ * This function implements the scalar conversion of hexadecimal
+ * characters into binary form.  The table values are biased by one so
+ * that an unlisted character, which has a zero value, can be detected
+ * after the conversion is complete rather than with a test for each
+ * character.
+ *
+ * \param hex	A pointer to the characters to be converted.
+ *
+ * \param cnt	The number of bytes to be generated.
+ *
+ * \param out	A pointer to the buffer which the binary value is to
+ *		be written to.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		all of the characters were valid.
+ */
+
+static _Bool _decode_scalar(const unsigned char *hex, size_t cnt, \
+			    uint8_t *out)
+
+{
+	uint8_t hi,
+		lo,
+		bad = 0;
+
+
+	while ( cnt-- ) {
+		hi = Nybble[*hex++];
+		lo = Nybble[*hex++];
+		bad |= (uint8_t) ((hi == 0) | (lo == 0));
+		*out++ = (uint8_t) (((hi - 1U) << 4) | ((lo - 1U) & 0xf));
+	}
+
+	return bad == 0;
+}
+
+
+#if defined(HEX_X86)
+/**
+ * Private function.
+ *
+ * This function converts a vector of hexadecimal characters into the
+ * vector of nybbles which they represent.
+ *
+ * \param v	The vector of characters.
+ *
+ * \param ok	A pointer to the vector which will have all bits set
+ *		in the lanes which contain a valid character.
+ *
+ * \return	The vector of nybble values.
+ */
+
+__attribute__((target("ssse3")))
+static inline __m128i _nybbles128(__m128i v, __m128i *ok)
+
+{
+	__m128i lower,
+		digit,
+		alpha,
+		is_digit,
+		is_alpha;
+
+
+	/* Lanes with the high bit set are negative and never match. */
+	digit	 = _mm_sub_epi8(v, _mm_set1_epi8('0'));
+	is_digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), \
+				 _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+
+	lower	 = _mm_or_si128(v, _mm_set1_epi8(0x20));
+	alpha	 = _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10));
+	is_alpha = _mm_and_si128(_mm_cmpgt_epi8(lower,			  \
+						_mm_set1_epi8('a' - 1)),  \
+				 _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+
+	*ok = _mm_or_si128(is_digit, is_alpha);
+	return _mm_or_si128(_mm_and_si128(is_digit, digit), \
+			    _mm_and_si128(is_alpha, alpha));
+}
+
+
+/**
+ * Private function.
+ *
+ * This function is the 256 bit equivalent of the _nybbles128
+ * function.
+ *
+ * \param v	The vector of characters.
+ *
+ * \param ok	A pointer to the vector which will have all bits set
+ *		in the lanes which contain a valid character.
+ *
+ * \return	The vector of nybble values.
+ */
+
+__attribute__((target("avx2")))
+static inline __m256i _nybbles256(__m256i v, __m256i *ok)
+
+{
+	__m256i lower,
+		digit,
+		alpha,
+		is_digit,
+		is_alpha;
+
+
+	digit	 = _mm256_sub_epi8(v, _mm256_set1_epi8('0'));
+	is_digit = _mm256_and_si256(					  \
+		_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)),	  \
+		_mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+
+	lower	 = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+	alpha	 = _mm256_sub_epi8(lower, _mm256_set1_epi8('a' - 10));
+	is_alpha = _mm256_and_si256(					  \
+		_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),	  \
+		_mm256_cmpgt_epi8(_mm256_set1_epi8('f' + 1), lower));
+
+	*ok = _mm256_or_si256(is_digit, is_alpha);
+	return _mm256_or_si256(_mm256_and_si256(is_digit, digit), \
+			       _mm256_and_si256(is_alpha, alpha));
+}
+
+
+/**
+ * Private function.
+ *
+ * This function converts hexadecimal characters into binary form
+ * eight bytes at a time with the SSSE3 instructions.  The remainder
+ * of the characters are converted by the scalar implementation.
+ *
+ * \param hex	A pointer to the characters to be converted.
+ *
+ * \param cnt	The number of bytes to be generated.
+ *
+ * \param out	A pointer to the buffer which the binary value is to
+ *		be written to.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		all of the characters were valid.
+ */
+
+__attribute__((target("ssse3")))
+static _Bool _decode_ssse3(const unsigned char *hex, size_t cnt, \
+			   uint8_t *out)
+
+{
+	__m128i v,
+		ok;
+
+
+	while ( cnt >= 8 ) {
+		v = _mm_loadu_si128((const __m128i *) hex);
+		v = _nybbles128(v, &ok);
+		if ( _mm_movemask_epi8(ok) != 0xffff )
+			return false;
+
+		v = _mm_maddubs_epi16(v, _mm_set1_epi16(0x0110));
+		v = _mm_packus_epi16(v, v);
+		_mm_storel_epi64((__m128i *) out, v);
+
+		hex += 16;
+		out += 8;
+		cnt -= 8;
+	}
+
+	return _decode_scalar(hex, cnt, out);
+}
+
+
+/**
+ * Private function.
+ *
+ * This function is the AVX2 equivalent of the _decode_ssse3 function
+ * and converts sixteen bytes at a time.
+ *
+ * \param hex	A pointer to the characters to be converted.
+ *
+ * \param cnt	The number of bytes to be generated.
+ *
+ * \param out	A pointer to the buffer which the binary value is to
+ *		be written to.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		all of the characters were valid.
+ */
+
+__attribute__((target("avx2")))
+static _Bool _decode_avx2(const unsigned char *hex, size_t cnt, \
+			  uint8_t *out)
+
+{
+	__m256i v,
+		ok;
+
+	__m128i r;
+
+
+	/*
+	 * Adjacent nybbles are combined into 16 bit words with a
+	 * multiply-add, the words are packed back to bytes within each
+	 * lane and the two halves are then gathered into the low 128
+	 * bits.
+	 */
+	while ( cnt >= 16 ) {
+		v = _mm256_loadu_si256((const __m256i *) hex);
+		v = _nybbles256(v, &ok);
+		if ( _mm256_movemask_epi8(ok) != -1 )
+			return false;
+
+		v = _mm256_maddubs_epi16(v, _mm256_set1_epi16(0x0110));
+		v = _mm256_packus_epi16(v, v);
+		v = _mm256_permute4x64_epi64(v, 0x08);
+		r = _mm256_castsi256_si128(v);
+		_mm_storeu_si128((__m128i *) out, r);
+
+		hex += 32;
+		out += 16;
+		cnt -= 16;
+	}
+
+	return _decode_ssse3(hex, cnt, out);
+}
+#endif
+
+
+/**
+ * External function.
+ *
+ * This function converts a string of hexadecimal characters into
+ * the binary value which it represents.
+ *
+ * \param hex	A pointer to the characters to be converted.
+ *
+ * \param len	The number of characters to be converted.  This value
+ *		must be a multiple of two.
+ *
+ * \param out	A pointer to the buffer which the binary value is to
+ *		be written to.  This buffer must be at least one half
+ *		of the size of the number of characters to be
+ *		converted.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the conversion was successful.  A false value indicates
+ *		the length was not valid or a character was not a
+ *		hexadecimal digit.  The contents of the output buffer
+ *		are undefined in this case.
+ */
+
+_Bool Hex_decode(const char *hex, const size_t len, uint8_t *out)
+
+{
+	const unsigned char *p = (const unsigned char *) hex;
+
+
+	if ( (len % 2) != 0 )
+		return false;
+
+#if defined(HEX_X86)
+	if ( __builtin_cpu_supports("avx2") )
+		return _decode_avx2(p, len / 2, out);
+	if ( __builtin_cpu_supports("ssse3") )
+		return _decode_ssse3(p, len / 2, out);
+#endif
+
+	return _decode_scalar(p, len / 2, out);
+}
+
+
+/**
+ * Private function.
+ *
+ * This function implements the scalar conversion of binary data into
+ * its hexadecimal representation.
+ *
+ * \param in	A pointer to the data to be converted.
+ *
+ * \param cnt	The number of bytes to be converted.
+ *
+ * \param out	A pointer to the buffer which the characters are to
+ *		be written to.
+ */
+
+static void _encode_scalar(const uint8_t *in, size_t cnt, char *out)
+
+{
+	while ( cnt-- ) {
+		*out++ = Digits[*in >> 4];
+		*out++ = Digits[*in++ & 0xf];
+	}
+
+	return;
+}
+
+
+#if defined(HEX_X86)
+/**
+ * Private function.
+ *
+ * This function converts binary data into its hexadecimal
+ * representation sixteen bytes at a time with the SSSE3
+ * instructions.  The remainder of the data is converted by the
+ * scalar implementation.
+ *
+ * \param in	A pointer to the data to be converted.
+ *
+ * \param cnt	The number of bytes to be converted.
+ *
+ * \param out	A pointer to the buffer which the characters are to
+ *		be written to.
+ */
+
+__attribute__((target("ssse3")))
+static void _encode_ssse3(const uint8_t *in, size_t cnt, char *out)
+
+{
+	__m128i v,
+		hi,
+		lo,
+		mask  = _mm_set1_epi8(0x0f),
+		table = _mm_loadu_si128((const __m128i *) Digits);
+
+
+	while ( cnt >= 16 ) {
+		v  = _mm_loadu_si128((const __m128i *) in);
+		hi = _mm_and_si128(_mm_srli_epi16(v, 4), mask);
+		lo = _mm_and_si128(v, mask);
+		hi = _mm_shuffle_epi8(table, hi);
+		lo = _mm_shuffle_epi8(table, lo);
+
+		_mm_storeu_si128((__m128i *) out, _mm_unpacklo_epi8(hi, lo));
+		_mm_storeu_si128((__m128i *) (out + 16), \
+				 _mm_unpackhi_epi8(hi, lo));
+
+		in  += 16;
+		out += 32;
+		cnt -= 16;
+	}
+
+	_encode_scalar(in, cnt, out);
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function is the AVX2 equivalent of the _encode_ssse3 function
+ * and converts thirty-two bytes at a time.
+ *
+ * \param in	A pointer to the data to be converted.
+ *
+ * \param cnt	The number of bytes to be converted.
+ *
+ * \param out	A pointer to the buffer which the characters are to
+ *		be written to.
+ */
+
+__attribute__((target("avx2")))
+static void _encode_avx2(const uint8_t *in, size_t cnt, char *out)
+
+{
+	__m256i v,
+		hi,
+		lo,
+		mask  = _mm256_set1_epi8(0x0f),
+		table = _mm256_broadcastsi128_si256(			\
+			_mm_loadu_si128((const __m128i *) Digits));
+
+
+	/*
+	 * The interleave instructions operate within each 128 bit lane
+	 * so the lanes are exchanged to restore the order of the output.
+	 */
+	while ( cnt >= 32 ) {
+		v  = _mm256_loadu_si256((const __m256i *) in);
+		hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), mask);
+		lo = _mm256_and_si256(v, mask);
+		hi = _mm256_shuffle_epi8(table, hi);
+		lo = _mm256_shuffle_epi8(table, lo);
+
+		v  = _mm256_unpacklo_epi8(hi, lo);
+		hi = _mm256_unpackhi_epi8(hi, lo);
+		_mm256_storeu_si256((__m256i *) out, \
+				    _mm256_permute2x128_si256(v, hi, 0x20));
+		_mm256_storeu_si256((__m256i *) (out + 32), \
+				    _mm256_permute2x128_si256(v, hi, 0x31));
+
+		in  += 32;
+		out += 64;
+		cnt -= 32;
+	}
+
+	_encode_ssse3(in, cnt, out);
+	return;
+}
+#endif
+
+
+/**
+ * External function.
+ *
+ * This function converts binary data into its hexadecimal
+ * representation.
+ *
+ * \param in	A pointer to the data to be converted.
+ *
+ * \param len	The number of bytes to be converted.
+ *
+ * \param out	A pointer to the buffer which the characters are to
+ *		be written to.  This buffer must be at least twice the
+ *		size of the data to be converted.  The output is not
+ *		terminated.
+ */
+
+void Hex_encode(const uint8_t *in, const size_t len, char *out)
+
+{
+#if defined(HEX_X86)
+	if ( __builtin_cpu_supports("avx2") ) {
+		_encode_avx2(in, len, out);
+		return;
+	}
+	if ( __builtin_cpu_supports("ssse3") ) {
+		_encode_ssse3(in, len, out);
+		return;
+	}
+#endif
+
+	_encode_scalar(in, len, out);
+	return;
+}
+
+
+/**
+ * External function.
+ *
+ * This function converts a null-terminated hexadecimal string and
+ * adds the resulting binary value to a Buffer object.  It replaces
+ * the add_hexstring method of the Buffer object on paths which are
+ * performance sensitive.
+ *
+ * \param bufr	The object which the binary value is to be added to.
+ *
+ * \param hex	A pointer to the null-terminated string to be
+ *		converted.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the conversion was successful.  A false value indicates
+ *		the string was empty, of an odd length or contained a
+ *		character which was not a hexadecimal digit.
+ */
+
+_Bool Hex_add_Buffer(CO(Buffer, bufr), CO(char *, hex))
+
+{
+	uint8_t bp[HEX_CHUNK];
+
+	size_t cnt,
+	       len;
+
+	const char *p = hex;
+
+
+	if ( (hex == NULL) || bufr->poisoned(bufr) )
+		return false;
+
+	len = strlen(hex);
+	if ( (len == 0) || ((len % 2) != 0) )
+		return false;
+
+	while ( len > 0 ) {
+		cnt = len > (2 * HEX_CHUNK) ? 2 * HEX_CHUNK : len;
+		if ( !Hex_decode(p, cnt, bp) )
+			return false;
+		if ( !bufr->add(bufr, bp, cnt / 2) )
+			return false;
+		p   += cnt;
+		len -= cnt;
+	}
+
+	return true;
+}
+
+
+/**
+ * External function.
+ *
+ * This function adds the hexadecimal representation of binary data
+ * to a String object.
+ *
+ * \param str	The object which the representation is to be added
+ *		to.
+ *
+ * \param in	A pointer to the data to be converted.
+ *
+ * \param len	The number of bytes to be converted.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the representation was added to the object.
+ */
+
+_Bool Hex_add_String(CO(String, str), CO(uint8_t *, in), const size_t len)
+
+{
+	char bp[2 * HEX_CHUNK + 1];
+
+	size_t cnt,
+	       left = len;
+
+	const uint8_t *p = in;
+
+
+	while ( left > 0 ) {
+		cnt = left > HEX_CHUNK ? HEX_CHUNK : left;
+		Hex_encode(p, cnt, bp);
+		bp[2 * cnt] = '\0';
+		if ( !str->add(str, bp) )
+			return false;
+		p    += cnt;
+		left -= cnt;
+	}
+
+	return !str->poisoned(str);
+}
@@ -0,0 +1,26 @@
+/** \file
+ * This file contains the API definitions for the functions which
+ * convert between binary data and its ASCII hexadecimal
+ * representation.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+#ifndef NAAAIM_Hex_HEADER
+#define NAAAIM_Hex_HEADER
+
+
+/* Conversion functions. */
+extern HCLINK _Bool Hex_decode(const char *, const size_t, uint8_t *);
+extern HCLINK void Hex_encode(const uint8_t *, const size_t, char *);
+
+/* Object helper functions. */
+extern HCLINK _Bool Hex_add_Buffer(const Buffer, const char *);
+extern HCLINK _Bool Hex_add_String(const String, const uint8_t *, \
+				   const size_t);
+#endif
@@ -0,0 +1,259 @@
+/** \file
+ * This file implements a test and microbenchmark driver for the
+ * hexadecimal conversion functions.
+ *
+ * The conversion functions are first verified against a reference
+ * conversion for all lengths up to 256 bytes, with both upper and
+ * lower case input, and verified to reject invalid characters at
+ * every position.  The cost of converting a 32 byte digest in each
+ * direction is then measured, along with the cost of the conversion
+ * through the Buffer object and the formatted output conversion which
+ * the functions replace.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+
+#include <HurdLib.h>
+#include <Buffer.h>
+#include <String.h>
+
+#include "Hex.h"
+
+
+/* Size of the test vectors. */
+#define MAX_SIZE 256
+
+/* Size of the digest used for the benchmark. */
+#define DIGEST_SIZE 32
+
+
+/**
+ * Private function.
+ *
+ * This function returns the number of nanoseconds which have elapsed
+ * since the supplied starting time.
+ *
+ * \param start	A pointer to the structure containing the starting
+ *		time.
+ *
+ * \return	The number of elapsed nanoseconds.
+ */
+
+static double elapsed_ns(const struct timespec *start)
+
+{
+	struct timespec end;
+
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) * 1e9 + \
+		(end.tv_nsec - start->tv_nsec);
+}
+
+
+/**
+ * Private function.
+ *
+ * This function verifies the conversion functions.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the functions generated the expected results.
+ */
+
+static _Bool verify(void)
+
+{
+	_Bool retn = false;
+
+	char *p,
+	     hex[2 * MAX_SIZE + 1],
+	     ref[2 * MAX_SIZE + 1];
+
+	uint8_t in[MAX_SIZE],
+		out[MAX_SIZE];
+
+	size_t lp,
+	       pos;
+
+
+	for (lp= 0; lp < MAX_SIZE; ++lp)
+		in[lp] = random();
+
+	for (lp= 0; lp <= MAX_SIZE; ++lp) {
+		for (pos= 0, p = ref; pos < lp; ++pos, p += 2)
+			sprintf(p, "%02x", in[pos]);
+
+		memset(hex, '\0', sizeof(hex));
+		Hex_encode(in, lp, hex);
+		if ( memcmp(hex, ref, 2 * lp) != 0 ) {
+			fprintf(stdout, "Encode failed, length=%zu\n", lp);
+			goto done;
+		}
+
+		memset(out, '\0', sizeof(out));
+		if ( !Hex_decode(hex, 2 * lp, out) || \
+		     (memcmp(in, out, lp) != 0) ) {
+			fprintf(stdout, "Decode failed, length=%zu\n", lp);
+			goto done;
+		}
+
+		for (pos= 0; pos < 2 * lp; ++pos)
+			hex[pos] = toupper(hex[pos]);
+		memset(out, '\0', sizeof(out));
+		if ( !Hex_decode(hex, 2 * lp, out) || \
+		     (memcmp(in, out, lp) != 0) ) {
+			fprintf(stdout, "Upper case decode failed, "
+				"length=%zu\n", lp);
+			goto done;
+		}
+
+		for (pos= 0; pos < 2 * lp; ++pos) {
+			hex[pos] ^= 0x80;
+			if ( Hex_decode(hex, 2 * lp, out) ) {
+				fprintf(stdout, "Invalid character accepted, "
+					"length=%zu, position=%zu\n", lp, pos);
+				goto done;
+			}
+			hex[pos] ^= 0x80;
+		}
+
+		for (pos= 0; pos < 2 * lp; ++pos) {
+			hex[pos] = "/:@G`g"[pos % 6];
+			if ( Hex_decode(hex, 2 * lp, out) ) {
+				fprintf(stdout, "Boundary character accepted, "
+					"length=%zu, position=%zu\n", lp, pos);
+				goto done;
+			}
+			hex[pos] = ref[pos];
+		}
+	}
+
+	if ( Hex_decode("abc", 3, out) ) {
+		fputs("Odd length accepted.\n", stdout);
+		goto done;
+	}
+
+	fputs("Conversion verified.\n", stdout);
+	retn = true;
+
+
+ done:
+	return retn;
+}
+
+
+extern int main(int argc, char *argv[])
+
+{
+	int opt,
+	    retn = 1;
+
+	char hex[2 * DIGEST_SIZE + 1];
+
+	uint8_t digest[DIGEST_SIZE];
+
+	unsigned long int lp,
+			  pos,
+			  count = 1000000;
+
+	struct timespec start;
+
+	Buffer bufr = NULL;
+
+	String str = NULL;
+
+
+	while ( (opt = getopt(argc, argv, "n:")) != EOF )
+		switch ( opt ) {
+			case 'n':
+				count = strtoul(optarg, NULL, 0);
+				break;
+		}
+
+	if ( !verify() )
+		goto done;
+
+	INIT(HurdLib, Buffer, bufr, ERR(goto done));
+	INIT(HurdLib, String, str, ERR(goto done));
+
+	for (lp= 0; lp < sizeof(digest); ++lp)
+		digest[lp] = random();
+	Hex_encode(digest, sizeof(digest), hex);
+	hex[sizeof(hex) - 1] = '\0';
+
+
+	/* Digest conversions with the conversion functions. */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (lp= 0; lp < count; ++lp) {
+		Hex_decode(hex, sizeof(hex) - 1, digest);
+		__asm__ volatile("" : : "r" (digest) : "memory");
+	}
+	fprintf(stdout, "Hex_decode:      %8.2f ns/digest\n", \
+		elapsed_ns(&start) / count);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (lp= 0; lp < count; ++lp) {
+		Hex_encode(digest, sizeof(digest), hex);
+		__asm__ volatile("" : : "r" (hex) : "memory");
+	}
+	fprintf(stdout, "Hex_encode:      %8.2f ns/digest\n", \
+		elapsed_ns(&start) / count);
+
+
+	/* Digest conversions through the objects. */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (lp= 0; lp < count; ++lp) {
+		bufr->reset(bufr);
+		bufr->add_hexstring(bufr, hex);
+	}
+	fprintf(stdout, "add_hexstring:   %8.2f ns/digest\n", \
+		elapsed_ns(&start) / count);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (lp= 0; lp < count; ++lp) {
+		bufr->reset(bufr);
+		Hex_add_Buffer(bufr, hex);
+	}
+	fprintf(stdout, "Hex_add_Buffer:  %8.2f ns/digest\n", \
+		elapsed_ns(&start) / count);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (lp= 0; lp < count; ++lp) {
+		str->reset(str);
+		for (pos= 0; pos < sizeof(digest); ++pos)
+			str->add_sprintf(str, "%02x", digest[pos]);
+	}
+	fprintf(stdout, "add_sprintf:     %8.2f ns/digest\n", \
+		elapsed_ns(&start) / count);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (lp= 0; lp < count; ++lp) {
+		str->reset(str);
+		Hex_add_String(str, digest, sizeof(digest));
+	}
+	fprintf(stdout, "Hex_add_String:  %8.2f ns/digest\n", \
+		elapsed_ns(&start) / count);
+
+	retn = 0;
+
+
+ done:
+	WHACK(bufr);
+	WHACK(str);
+
+	return retn;
+}
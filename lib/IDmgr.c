@@ -1,7 +1,14 @@
 /** \file
  * This file implements the methods for implementing transactions
  * against the identity manager daemon.  Communications is carried
- * out through a POSIX shared memory region.
+ * out through a request ring in a POSIX shared memory region.  Each
+ * client transaction claims its own slot in the ring so multiple
+ * transactions can be outstanding against the daemon at once.
+ *
+ * A daemon which waits for requests with the ->wait_request method
+ * is woken through the ring.  Clients signal a daemon which has not
+ * done so with SIGUSR1, such a daemon is expected to call the
+ * ->get_idtype method from its signal handler.
  */
 
 /**************************************************************************
@@ -16,6 +23,9 @@
 /* Maximum lenth of an identity name. */
 #define NAME_LENGTH 64
 
+/* Number of request slots in the shared memory region. */
+#define SLOTS 16
+
 
 /* Include files. */
 #include <stdint.h>
@@ -68,15 +78,26 @@ struct NAAAIM_IDmgr_State
 
 	/* Identity manager IPC object.*/
 	IPC ipc;
+
+	/* Flag indicating the daemon is waiting on the ring. */
+	_Bool listening;
+
+	/* Flag and number of the request slot being served. */
+	_Bool selected;
+	unsigned int slot;
 };
 
-/* Structure for the shared memory region. */
-struct IDmgr_ipc
+/* Structure for the shared memory header. */
+struct IDmgr_header
 {
 	pid_t pid;
 
-	_Bool valid;
+	_Bool listening;
+};
 
+/* Structure for a request slot. */
+struct IDmgr_ipc
+{
 	IDmgr_type type;
 
 	char name[NAME_LENGTH];
@@ -131,10 +152,107 @@ static void _init_state(CO(IDmgr_State, S))
 
 	S->poisoned = false;
 
+	S->ipc	     = NULL;
+	S->listening = false;
+	S->selected  = false;
+	S->slot	     = 0;
+
 	return;
 }
 
 
+/**
+ * Internal private function.
+ *
+ * This function selects the next request to be served by the daemon
+ * if one is not already selected.
+ *
+ * \param S	A pointer to the state of the object which is
+ *		serving requests.
+ *
+ * \param wait	A flag indicating whether or not to wait for a
+ *		request if none are pending.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		a request is selected.
+ */
+
+static _Bool _select(CO(IDmgr_State, S), const _Bool wait)
+
+{
+	_Bool found;
+
+
+	if ( S->selected )
+		return true;
+
+	if ( !S->ipc->next(S->ipc, &S->slot, &found, wait) )
+		return false;
+	S->selected = found;
+
+	return S->selected;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function returns the response in the selected slot to the
+ * client.  If the daemon is driven by signals and further requests
+ * are pending the next request is selected and the signal is raised
+ * again since the signals from the clients may have been merged.
+ *
+ * \param S	A pointer to the state of the object which is
+ *		serving requests.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the response was returned.
+ */
+
+static _Bool _respond(CO(IDmgr_State, S))
+
+{
+	if ( !S->ipc->respond(S->ipc, S->slot) )
+		return false;
+	S->selected = false;
+
+	if ( !S->listening && _select(S, false) )
+		kill(getpid(), SIGUSR1);
+
+	return true;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function posts the request in a slot to the daemon and waits
+ * for the response.
+ *
+ * \param S	A pointer to the state of the object which is
+ *		making the request.
+ *
+ * \param slot	The number of the slot containing the request.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		a response was received.
+ */
+
+static _Bool _request(CO(IDmgr_State, S), const unsigned int slot)
+
+{
+	struct IDmgr_header *header = S->ipc->get(S->ipc);
+
+
+	if ( !S->ipc->post(S->ipc, slot) )
+		return false;
+	if ( !header->listening )
+		kill(header->pid, SIGUSR1);
+
+	return S->ipc->wait(S->ipc, slot);
+}
+
+
 /**
  * External public method.
  *
@@ -158,16 +276,17 @@ static _Bool setup(CO(IDmgr, this))
 
 	_Bool retn = false;
 
-	struct IDmgr_ipc *idipc;
+	struct IDmgr_header *header;
 
 
 	INIT(NAAAIM, IPC, S->ipc, goto done);
-	if ( !S->ipc->create(S->ipc, "IDmgr", sizeof(struct IDmgr_ipc)) )
+	if ( !S->ipc->create_ring(S->ipc, "IDmgr", \
+				  sizeof(struct IDmgr_header), \
+				  sizeof(struct IDmgr_ipc), SLOTS) )
 		goto done;
 
-	idipc = S->ipc->get(S->ipc);
-	memset(idipc, '\0', sizeof(struct IDmgr_ipc));
-	idipc->pid = getpid();
+	header = S->ipc->get(S->ipc);
+	header->pid = getpid();
 
 	retn = true;
 
@@ -214,6 +333,54 @@ static _Bool attach(CO(IDmgr, this))
 }
 
 
+/**
+ * External public method.
+ *
+ * This method implements waiting by the identity manager for the
+ * next request from a client.  The request is selected for the
+ * ->get_idtype, ->get_idname and response methods.  Once this method
+ * has been called clients wake the daemon through the request ring
+ * rather than by signaling it.  Clients which post requests before
+ * the first call still signal the daemon so a daemon using this
+ * method should ignore SIGUSR1.
+ *
+ * \param this	A pointer to the identity manager object which is
+ *		to wait for a request.
+ *
+ * \return	If a request was selected a true value is returned.
+ *		A false value indicates an error was encountered
+ *		while waiting.
+ */
+
+static _Bool wait_request(CO(IDmgr, this))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	struct IDmgr_header *header;
+
+
+	if ( S->poisoned )
+		goto done;
+
+	if ( !S->listening ) {
+		header = S->ipc->get(S->ipc);
+		header->listening = true;
+		S->listening	  = true;
+	}
+
+	retn = _select(S, true);
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+	return retn;
+}
+
+
 /**
  * External public method.
  *
@@ -233,21 +400,21 @@ static IDmgr_type get_idtype(CO(IDmgr, this))
 {
 	STATE(S);
 
-        IDmgr_type retn = IDmgr_none;
+	IDmgr_type retn = IDmgr_none;
 
 	struct IDmgr_ipc *ipc;
 
 
 	if ( S->poisoned )
 		goto done;
+	if ( !_select(S, false) )
+		goto done;
 
-	ipc = S->ipc->get(S->ipc);
+	ipc  = S->ipc->get_slot(S->ipc, S->slot);
 	retn = ipc->type;
 
 
  done:
-	if ( ipc->type == IDmgr_none )
-		ipc->valid = true;
 	return retn;
 }
 
@@ -278,12 +445,12 @@ static _Bool get_idname(CO(IDmgr, this), CO(String, name))
 	struct IDmgr_ipc *ipc;
 
 
-	if ( S->poisoned )
-		return NULL;
+	if ( S->poisoned || !S->selected )
+		return false;
 	if ( (name == NULL) || name->poisoned(name) )
-		return NULL;
+		return false;
 
-	ipc = S->ipc->get(S->ipc);
+	ipc = S->ipc->get_slot(S->ipc, S->slot);
 	if ( ipc->name[NAME_LENGTH-1] != '\0' )
 		ipc->name[NAME_LENGTH - 1] = '\0';
 	if ( name->add(name, ipc->name) )
@@ -322,12 +489,12 @@ static _Bool set_idtoken(CO(IDmgr, this), CO(IDtoken, token))
 	Buffer b;
 
 
-	if ( S->poisoned )
+	if ( S->poisoned || !S->selected )
 		goto done;
 	if ( token == NULL )
 		goto done;
 
-	ipc = S->ipc->get(S->ipc);
+	ipc = S->ipc->get_slot(S->ipc, S->slot);
 
 	b = token->get_element(token, IDtoken_orgkey);
 	memcpy(ipc->assertion_key, b->get(b), b->size(b));
@@ -340,8 +507,7 @@ static _Bool set_idtoken(CO(IDmgr, this), CO(IDtoken, token))
 	b = token->get_element(token, IDtoken_key);
 	memcpy(ipc->idkey, b->get(b), b->size(b));
 
-	ipc->valid = true;
-	retn = true;
+	retn = _respond(S);
 
 
  done:
@@ -376,10 +542,12 @@ static _Bool get_idtoken(CO(IDmgr, this), CO(String, name), CO(IDtoken, token))
 {
 	STATE(S);
 
-	_Bool retn   = false,
-	      locked = false;
+	_Bool retn    = false,
+	      claimed = false;
 
-	struct IDmgr_ipc *ipc;
+	unsigned int slot;
+
+	struct IDmgr_ipc *ipc = NULL;
 
 	Buffer b = NULL;
 
@@ -397,20 +565,17 @@ static _Bool get_idtoken(CO(IDmgr, this), CO(String, name), CO(IDtoken, token))
 	if ( name->size(name) >= NAME_LENGTH )
 		goto done;
 
-	ipc = S->ipc->get(S->ipc);
-	if ( !S->ipc->lock(S->ipc) )
+	if ( !S->ipc->claim(S->ipc, &slot) )
 		goto done;
-	locked = true;
+	claimed = true;
+	ipc = S->ipc->get_slot(S->ipc, slot);
 
 	memset(ipc->name, '\0', sizeof(ipc->name));
 	memcpy(ipc->name, name->get(name), name->size(name));
+	ipc->type = IDmgr_token;
 
-	ipc->type  = IDmgr_token;
-	ipc->valid = false;
-
-	kill(ipc->pid, SIGUSR1);
-	while ( !ipc->valid )
-		continue;
+	if ( !_request(S, slot) )
+		goto done;
 
 	b->add(b, ipc->assertion_key, sizeof(ipc->assertion_key));
 	if ( !token->set_element(token, IDtoken_orgkey, b) )
@@ -434,9 +599,9 @@ static _Bool get_idtoken(CO(IDmgr, this), CO(String, name), CO(IDtoken, token))
 
 
  done:
-	_clear_ipc(ipc);
-	if ( locked ) {
-		if ( !S->ipc->unlock(S->ipc) )
+	if ( claimed ) {
+		_clear_ipc(ipc);
+		if ( !S->ipc->release(S->ipc, slot) )
 			retn = false;
 	}
 
@@ -479,10 +644,12 @@ static _Bool get_id_key(CO(IDmgr, this), CO(String, name), \
 {
 	STATE(S);
 
-	_Bool retn   = false,
-	      locked = false;
+	_Bool retn    = false,
+	      claimed = false;
 
-	struct IDmgr_ipc *ipc;
+	unsigned int slot;
+
+	struct IDmgr_ipc *ipc = NULL;
 
 
 	if ( S->poisoned )
@@ -493,21 +660,20 @@ static _Bool get_id_key(CO(IDmgr, this), CO(String, name), \
 		goto done;
 	if ( (idkey == NULL) || idkey->poisoned(idkey) )
 		goto done;
+	if ( name->size(name) >= NAME_LENGTH )
+		goto done;
 
-	ipc = S->ipc->get(S->ipc);
-	if ( !S->ipc->lock(S->ipc) )
+	if ( !S->ipc->claim(S->ipc, &slot) )
 		goto done;
-	locked = true;
+	claimed = true;
+	ipc = S->ipc->get_slot(S->ipc, slot);
 
 	memset(ipc->name, '\0', sizeof(ipc->name));
 	memcpy(ipc->name, name->get(name), name->size(name));
+	ipc->type = IDmgr_idhash;
 
-	ipc->type  = IDmgr_idhash;
-	ipc->valid = false;
-
-	kill(ipc->pid, SIGUSR1);
-	while ( !ipc->valid )
-		continue;
+	if ( !_request(S, slot) )
+		goto done;
 
 	if ( !idhash->add(idhash, ipc->idhash, sizeof(ipc->idhash)) )
 		goto done;
@@ -518,9 +684,9 @@ static _Bool get_id_key(CO(IDmgr, this), CO(String, name), \
 
 
  done:
-	_clear_ipc(ipc);
-	if ( locked ) {
-		if ( !S->ipc->unlock(S->ipc) )
+	if ( claimed ) {
+		_clear_ipc(ipc);
+		if ( !S->ipc->release(S->ipc, slot) )
 			retn = false;
 	}
 
@@ -561,21 +727,20 @@ static _Bool set_id_key(CO(IDmgr, this), CO(IDtoken, idtoken))
 	Buffer b;
 
 
-	if ( S->poisoned )
+	if ( S->poisoned || !S->selected )
 		goto done;
 	if ( idtoken == NULL )
 		goto done;
 
-	ipc = S->ipc->get(S->ipc);
+	ipc = S->ipc->get_slot(S->ipc, S->slot);
 
-        b = idtoken->get_element(idtoken, IDtoken_id);
+	b = idtoken->get_element(idtoken, IDtoken_id);
 	memcpy(ipc->idhash, b->get(b), b->size(b));
 
 	b = idtoken->get_element(idtoken, IDtoken_key);
 	memcpy(ipc->idkey, b->get(b), b->size(b));
 
-	ipc->valid = true;
-	retn	   = true;
+	retn = _respond(S);
 
 
  done:
@@ -598,6 +763,13 @@ static void whack(CO(IDmgr, this))
 {
 	STATE(S);
 
+	struct IDmgr_header *header;
+
+
+	if ( S->listening ) {
+		header = S->ipc->get(S->ipc);
+		header->listening = false;
+	}
 
 	if ( S->ipc != NULL )
 		WHACK(S->ipc);
@@ -647,6 +819,8 @@ extern IDmgr NAAAIM_IDmgr_Init(void)
 	this->setup  = setup;
 	this->attach = attach;
 
+	this->wait_request = wait_request;
+
 	this->get_idtype = get_idtype;
 	this->get_idname = get_idname;
 
@@ -34,6 +34,8 @@ struct NAAAIM_IDmgr
 	_Bool (*setup)(const IDmgr);
 	_Bool (*attach)(const IDmgr);
 
+	_Bool (*wait_request)(const IDmgr);
+
 	IDmgr_type (*get_idtype)(const IDmgr);
 	_Bool (*get_idname)(const IDmgr, const String);
 
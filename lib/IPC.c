@@ -3,6 +3,12 @@
  * allows POSIX style shared memory regions to be created and
  * manipulated.  The object also provides access to a POSIX shared
  * memory semaphore for locking the shared region.
+ *
+ * A shared region can also be created with a request ring.  The ring
+ * is an array of request slots which are handed between clients and
+ * a server with atomic operations, with futexes in the region used
+ * to sleep and wake processes.  This allows multiple clients to have
+ * requests outstanding without serializing on the region semaphore.
  */
 
 /**************************************************************************
@@ -23,6 +29,8 @@
 #include <semaphore.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 #include <Origin.h>
 #include <HurdLib.h>
@@ -44,6 +52,72 @@
 #error Object identifier not defined.
 #endif
 
+/*
+ * The following definitions describe the layout of a shared region
+ * which contains a request ring.  The region begins with the ring
+ * header, which is followed by a header area for the user of the
+ * ring and then by the array of request slots.  Each element is
+ * aligned to a cache line so that the slots being used by different
+ * processes do not share a line.
+ */
+#define LINE_SIZE 64
+#define ALIGN(size) (((size) + LINE_SIZE - 1) & ~((off_t) LINE_SIZE - 1))
+
+/* Value used to identify a region which contains a ring. */
+#define RING_MAGIC 0x52494e47
+
+/* The states of a request slot. */
+#define SLOT_FREE	0
+#define SLOT_CLAIMED	1
+#define SLOT_REQUEST	2
+#define SLOT_SERVING	3
+#define SLOT_RESPONSE	4
+
+/** Header of a shared region which contains a request ring. */
+struct IPC_ring
+{
+	/* Ring identifier. */
+	uint32_t magic;
+
+	/* Number of request slots. */
+	uint32_t slots;
+
+	/* Offset and size of the user header area. */
+	uint32_t header;
+
+	/* Offset of the first slot and the size of each slot. */
+	uint32_t slot_offset;
+	uint32_t stride;
+
+	/*
+	 * Count of posted requests and number of servers waiting for
+	 * a request.  The count is used as the futex which servers
+	 * sleep on.
+	 */
+	uint32_t posted;
+	uint32_t servers;
+
+	/*
+	 * Count of released slots and number of clients waiting for
+	 * a free slot.  The count is used as the futex which clients
+	 * sleep on.
+	 */
+	uint32_t released;
+	uint32_t claimers;
+};
+
+/** A request slot. */
+struct IPC_slot
+{
+	/* The slot state, also used as the futex for the response. */
+	uint32_t state;
+
+	uint32_t pad;
+
+	/* The request and response area. */
+	unsigned char payload[];
+};
+
 
 /** IPC private state information. */
 struct NAAAIM_IPC_State
@@ -74,6 +148,22 @@ struct NAAAIM_IPC_State
 
 	/* String object with the shared memory region name. */
 	String name;
+
+	/* Pointer to the ring header and the next slot to be served. */
+	struct IPC_ring *ring;
+	unsigned int cursor;
+
+	/*
+	 * Private copy of the ring geometry.  The copy is validated
+	 * when the ring is attached and is the only source used to
+	 * locate the header area and the slots, so a process which
+	 * rewrites the shared ring header cannot move them outside
+	 * of the mapping.
+	 */
+	uint32_t slots;
+	uint32_t header;
+	uint32_t slot_offset;
+	uint32_t stride;
 };
 
 
@@ -99,7 +189,14 @@ static void _init_state(CO(IPC_State, S)) {
 	S->ptr	= MAP_FAILED;
 	S->sem	= SEM_FAILED;
 	S->name = NULL;
-	
+
+	S->ring	  = NULL;
+	S->cursor = 0;
+
+	S->slots       = 0;
+	S->header      = 0;
+	S->slot_offset = 0;
+	S->stride      = 0;
 
 	return;
 }
@@ -223,6 +320,34 @@ static _Bool attach(CO(IPC, this), CO(char *, path))
 	if ( S->sem == SEM_FAILED )
 		goto done;
 
+	/*
+	 * Locate a request ring if the region contains one and take
+	 * a private copy of its geometry before validating it.
+	 */
+	S->ring = S->ptr;
+	if ( (S->size < sizeof(struct IPC_ring)) || \
+	     (__atomic_load_n(&S->ring->magic, __ATOMIC_ACQUIRE) != \
+	      RING_MAGIC) )
+		S->ring = NULL;
+	else {
+		S->slots       = __atomic_load_n(&S->ring->slots, \
+						 __ATOMIC_RELAXED);
+		S->header      = __atomic_load_n(&S->ring->header, \
+						 __ATOMIC_RELAXED);
+		S->slot_offset = __atomic_load_n(&S->ring->slot_offset, \
+						 __ATOMIC_RELAXED);
+		S->stride      = __atomic_load_n(&S->ring->stride, \
+						 __ATOMIC_RELAXED);
+
+		if ( (S->slots == 0) || \
+		     (S->stride < sizeof(struct IPC_slot)) || \
+		     (S->header < sizeof(struct IPC_ring)) || \
+		     (S->header > S->slot_offset) || \
+		     (S->slot_offset + (off_t) S->slots * S->stride > \
+		      S->size) )
+			goto done;
+	}
+
 	retn = true;
 
 	
@@ -287,7 +412,8 @@ static _Bool copy(CO(IPC, this), CO(unsigned char *, ptr), \
  * External public method.
  *
  * This method implements an accessor method for obtaining the pointer
- * to the shared memory region.
+ * to the shared memory region.  If the region contains a request ring
+ * a pointer to the header area of the ring is returned.
  *
  * \param this		A pointer to the object whose memory segment
  *			is to be written to.
@@ -311,6 +437,8 @@ static void * get(CO(IPC, this))
 {
 	STATE(S);
 
+	if ( S->ring != NULL )
+		return (unsigned char *) S->ptr + S->header;
 	return S->ptr;
 }
 
@@ -390,6 +518,541 @@ static _Bool unlock(CO(IPC, this))
 	return retn;
 }
 
+
+/**
+ * Private function.
+ *
+ * This function waits for a futex in the shared region to change
+ * from an expected value.
+ *
+ * \param word		A pointer to the futex.
+ *
+ * \param value		The value which the futex is expected to
+ *			hold.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the wait completed.  A false value
+ *			indicates an error other than a change in the
+ *			futex value or an interruption.
+ */
+
+static _Bool _futex_wait(uint32_t *word, const uint32_t value)
+
+{
+	if ( syscall(SYS_futex, word, FUTEX_WAIT, value, NULL, NULL, 0) == 0 )
+		return true;
+	if ( (errno == EAGAIN) || (errno == EINTR) )
+		return true;
+	return false;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function wakes processes which are waiting on a futex in the
+ * shared region.
+ *
+ * \param word		A pointer to the futex.
+ *
+ * \param count		The number of processes to be woken.
+ */
+
+static void _futex_wake(uint32_t *word, const int count)
+
+{
+	syscall(SYS_futex, word, FUTEX_WAKE, count, NULL, NULL, 0);
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function returns a pointer to a slot in a request ring.
+ *
+ * \param S	A pointer to the state of the object whose slot is to
+ *		be returned.
+ *
+ * \param slot	The number of the slot to be returned.
+ *
+ * \return	A pointer to the slot is returned.  A null value
+ *		indicates the object does not contain a ring or the
+ *		slot number is not valid.
+ */
+
+static struct IPC_slot * _get_slot(CO(IPC_State, S), const unsigned int slot)
+
+{
+	if ( S->poisoned || (S->ring == NULL) )
+		return NULL;
+	if ( slot >= S->slots )
+		return NULL;
+
+	return (struct IPC_slot *) ((unsigned char *) S->ptr + \
+				    S->slot_offset + \
+				    (off_t) slot * S->stride);
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements creating a shared memory object which
+ * contains a request ring.  The ring allows multiple clients to have
+ * requests outstanding to the process serving the ring at the same
+ * time.  Slots are claimed and handed between the clients and the
+ * server with atomic operations on the slot state, processes which
+ * need to wait for a slot, request or response sleep on a futex in
+ * the shared region.
+ *
+ * \param this		A pointer to the shared memory object which is
+ *			to be created.
+ *
+ * \param path		A pointer to a null-terminated buffer
+ *			containing the name of the object to be
+ *			created.
+ *
+ * \param header	The size of the header area which will be
+ *			returned by the ->get method.
+ *
+ * \param size		The size of the request area of each slot.
+ *
+ * \param slots		The number of slots in the ring.
+ *
+ * \return		If an error is encountered during creation of
+ *			the shared memory object a false value is
+ *			returned.  A true value indicates the ring was
+ *			created and is available for use.
+ */
+
+static _Bool create_ring(CO(IPC, this), CO(char *, path), off_t header, \
+			 off_t size, unsigned int slots)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	off_t stride,
+	      slot_offset;
+
+	struct IPC_ring *ring;
+
+
+	if ( S->poisoned )
+		goto done;
+	if ( (size <= 0) || (slots == 0) )
+		goto done;
+
+	slot_offset = ALIGN(sizeof(struct IPC_ring)) + ALIGN(header);
+	stride	    = ALIGN(sizeof(struct IPC_slot) + size);
+	if ( (slot_offset + slots * stride) > UINT32_MAX )
+		goto done;
+
+	if ( !this->create(this, path, slot_offset + slots * stride) )
+		goto done;
+	memset(S->ptr, '\0', S->size);
+
+	ring = S->ptr;
+	ring->slots	  = slots;
+	ring->header	  = ALIGN(sizeof(struct IPC_ring));
+	ring->slot_offset = slot_offset;
+	ring->stride	  = stride;
+	__atomic_store_n(&ring->magic, RING_MAGIC, __ATOMIC_RELEASE);
+
+	S->ring	       = ring;
+	S->slots       = slots;
+	S->header      = ALIGN(sizeof(struct IPC_ring));
+	S->slot_offset = slot_offset;
+	S->stride      = stride;
+
+	retn = true;
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements an accessor method for obtaining the
+ * request area of a ring slot.
+ *
+ * \param this	A pointer to the object containing the ring.
+ *
+ * \param slot	The number of the slot whose request area is to be
+ *		returned.
+ *
+ * \return	A pointer to the request area of the slot.  A null
+ *		value is returned if the object does not contain a
+ *		ring or the slot number is invalid.
+ */
+
+static void * get_slot(CO(IPC, this), const unsigned int slot)
+
+{
+	STATE(S);
+
+	struct IPC_slot *sp;
+
+
+	if ( (sp = _get_slot(S, slot)) == NULL )
+		return NULL;
+	return sp->payload;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements claiming a free slot in a request ring by a
+ * client.  The search for a free slot starts at a position derived
+ * from the process identifier so that concurrent clients contend
+ * for different slots.  If all of the slots are in use the client
+ * sleeps until a slot is released.
+ *
+ * \param this	A pointer to the object containing the ring.
+ *
+ * \param slot	A pointer to the variable which will be loaded with
+ *		the number of the claimed slot.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		a slot was claimed.
+ */
+
+static _Bool claim(CO(IPC, this), unsigned int *slot)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	uint32_t seq,
+		 state;
+
+	unsigned int lp,
+		     start,
+		     number;
+
+	struct IPC_ring *ring = S->ring;
+
+	struct IPC_slot *sp;
+
+
+	if ( S->poisoned || (ring == NULL) )
+		goto done;
+
+	start = getpid() % S->slots;
+	while ( true ) {
+		seq = __atomic_load_n(&ring->released, __ATOMIC_SEQ_CST);
+
+		for (lp= 0; lp < S->slots; ++lp) {
+			number = (start + lp) % S->slots;
+			sp     = _get_slot(S, number);
+			state  = SLOT_FREE;
+			if ( __atomic_compare_exchange_n(&sp->state, &state, \
+						SLOT_CLAIMED, false, \
+						__ATOMIC_ACQ_REL, \
+						__ATOMIC_RELAXED) ) {
+				*slot = number;
+				retn  = true;
+				goto done;
+			}
+		}
+
+		__atomic_add_fetch(&ring->claimers, 1, __ATOMIC_SEQ_CST);
+		retn = _futex_wait(&ring->released, seq);
+		__atomic_sub_fetch(&ring->claimers, 1, __ATOMIC_SEQ_CST);
+		if ( !retn )
+			goto done;
+	}
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements posting the request in a claimed slot to
+ * the server of the ring.
+ *
+ * \param this	A pointer to the object containing the ring.
+ *
+ * \param slot	The number of the slot containing the request.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the request was posted.
+ */
+
+static _Bool post(CO(IPC, this), const unsigned int slot)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	struct IPC_ring *ring = S->ring;
+
+	struct IPC_slot *sp;
+
+
+	if ( (sp = _get_slot(S, slot)) == NULL )
+		goto done;
+	if ( __atomic_load_n(&sp->state, __ATOMIC_RELAXED) != SLOT_CLAIMED )
+		goto done;
+
+	__atomic_store_n(&sp->state, SLOT_REQUEST, __ATOMIC_SEQ_CST);
+	__atomic_add_fetch(&ring->posted, 1, __ATOMIC_SEQ_CST);
+	if ( __atomic_load_n(&ring->servers, __ATOMIC_SEQ_CST) > 0 )
+		_futex_wake(&ring->posted, 1);
+
+	retn = true;
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements waiting by a client for the response to a
+ * posted request.
+ *
+ * \param this	A pointer to the object containing the ring.
+ *
+ * \param slot	The number of the slot containing the request.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		a response was received.
+ */
+
+static _Bool wait_response(CO(IPC, this), const unsigned int slot)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	uint32_t state;
+
+	struct IPC_slot *sp;
+
+
+	if ( (sp = _get_slot(S, slot)) == NULL )
+		goto done;
+
+	while ( true ) {
+		state = __atomic_load_n(&sp->state, __ATOMIC_ACQUIRE);
+		if ( state == SLOT_RESPONSE )
+			break;
+		if ( (state != SLOT_REQUEST) && (state != SLOT_SERVING) )
+			goto done;
+		if ( !_futex_wait(&sp->state, state) )
+			goto done;
+	}
+
+	retn = true;
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements the release of a claimed slot by a client.
+ * A client waiting for a free slot is woken if one is present.
+ *
+ * \param this	A pointer to the object containing the ring.
+ *
+ * \param slot	The number of the slot to be released.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the slot was released.
+ */
+
+static _Bool release(CO(IPC, this), const unsigned int slot)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	uint32_t state;
+
+	struct IPC_ring *ring = S->ring;
+
+	struct IPC_slot *sp;
+
+
+	if ( (sp = _get_slot(S, slot)) == NULL )
+		goto done;
+
+	state = __atomic_load_n(&sp->state, __ATOMIC_RELAXED);
+	if ( (state != SLOT_CLAIMED) && (state != SLOT_RESPONSE) )
+		goto done;
+
+	__atomic_store_n(&sp->state, SLOT_FREE, __ATOMIC_SEQ_CST);
+	__atomic_add_fetch(&ring->released, 1, __ATOMIC_SEQ_CST);
+	if ( __atomic_load_n(&ring->claimers, __ATOMIC_SEQ_CST) > 0 )
+		_futex_wake(&ring->released, 1);
+
+	retn = true;
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements the selection of the next posted request
+ * by the server of a ring.  Slots are scanned starting after the
+ * last request selected so that requests are served in rotation.
+ *
+ * \param this	A pointer to the object containing the ring.
+ *
+ * \param slot	A pointer to the variable which will be loaded with
+ *		the number of the slot containing the request.
+ *
+ * \param found	A pointer to the variable which will be set to
+ *		indicate whether or not a request was selected.
+ *
+ * \param wait	A flag indicating whether or not the server should
+ *		sleep until a request is posted if none are pending.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the ring was checked for a request.  A false value
+ *		indicates an error and no assumption can be made about
+ *		the selection status.
+ */
+
+static _Bool next(CO(IPC, this), unsigned int *slot, _Bool *found, \
+		  const _Bool wait)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	uint32_t seq,
+		 state;
+
+	unsigned int lp,
+		     number;
+
+	struct IPC_ring *ring = S->ring;
+
+	struct IPC_slot *sp;
+
+
+	if ( S->poisoned || (ring == NULL) )
+		goto done;
+
+	*found = false;
+	while ( true ) {
+		seq = __atomic_load_n(&ring->posted, __ATOMIC_SEQ_CST);
+
+		for (lp= 0; lp < S->slots; ++lp) {
+			number = (S->cursor + lp) % S->slots;
+			sp     = _get_slot(S, number);
+			state  = SLOT_REQUEST;
+			if ( __atomic_compare_exchange_n(&sp->state, &state, \
+						SLOT_SERVING, false, \
+						__ATOMIC_ACQ_REL, \
+						__ATOMIC_RELAXED) ) {
+				S->cursor = number + 1;
+				*slot	  = number;
+				*found	  = true;
+				retn	  = true;
+				goto done;
+			}
+		}
+
+		if ( !wait ) {
+			retn = true;
+			goto done;
+		}
+
+		__atomic_add_fetch(&ring->servers, 1, __ATOMIC_SEQ_CST);
+		retn = _futex_wait(&ring->posted, seq);
+		__atomic_sub_fetch(&ring->servers, 1, __ATOMIC_SEQ_CST);
+		if ( !retn )
+			goto done;
+	}
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements the return of the response to a request by
+ * the server of a ring.  The client waiting for the response is
+ * woken.
+ *
+ * \param this	A pointer to the object containing the ring.
+ *
+ * \param slot	The number of the slot containing the response.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the response was returned.
+ */
+
+static _Bool respond(CO(IPC, this), const unsigned int slot)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	struct IPC_slot *sp;
+
+
+	if ( (sp = _get_slot(S, slot)) == NULL )
+		goto done;
+	if ( __atomic_load_n(&sp->state, __ATOMIC_RELAXED) != SLOT_SERVING )
+		goto done;
+
+	__atomic_store_n(&sp->state, SLOT_RESPONSE, __ATOMIC_RELEASE);
+	_futex_wake(&sp->state, 1);
+
+	retn = true;
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+	return retn;
+}
+
 	
 /**
  * External public method.
@@ -469,6 +1132,17 @@ extern IPC NAAAIM_IPC_Init(void)
 	this->lock   = lock;
 	this->unlock = unlock;
 
+	this->create_ring = create_ring;
+	this->get_slot	  = get_slot;
+
+	this->claim   = claim;
+	this->post    = post;
+	this->wait    = wait_response;
+	this->release = release;
+
+	this->next    = next;
+	this->respond = respond;
+
 	this->whack = whack;
 
 	return this;
@@ -34,6 +34,18 @@ struct NAAAIM_IPC
 	_Bool (*lock)(const IPC);
 	_Bool (*unlock)(const IPC);
 
+	_Bool (*create_ring)(const IPC, const char *, off_t, off_t, \
+			     unsigned int);
+	void * (*get_slot)(const IPC, const unsigned int);
+
+	_Bool (*claim)(const IPC, unsigned int *);
+	_Bool (*post)(const IPC, const unsigned int);
+	_Bool (*wait)(const IPC, const unsigned int);
+	_Bool (*release)(const IPC, const unsigned int);
+
+	_Bool (*next)(const IPC, unsigned int *, _Bool *, const _Bool);
+	_Bool (*respond)(const IPC, const unsigned int);
+
 	void (*whack)(const IPC);
 
 	/* Private state. */
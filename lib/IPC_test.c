@@ -1,3 +1,16 @@
+/** \file
+ * This file implements a test driver for the IPC object.
+ *
+ * By default a shared region is created and its semaphore is passed
+ * between this process and a second instance of the program.  The -R
+ * option instead measures the throughput of a request ring with a
+ * number of client processes, each with one request outstanding at a
+ * time, against a single server.  The throughput is compared with the
+ * single slot protocol which was previously used by the identity
+ * manager, where clients serialize on the region semaphore and signal
+ * the server for each request.
+ */
+
 /**************************************************************************
  * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
  *
@@ -12,15 +25,334 @@
 #include <string.h>
 #include <time.h>
 #include <limits.h>
+#include <signal.h>
+#include <sys/wait.h>
 
 #include <HurdLib.h>
 
+#include <NAAAIM.h>
 #include "IPC.h"
 
 
+/* Name of the region used by the ring benchmark. */
+#define RING_NAME "IPC_test.ring"
+
+/* Number of slots in the benchmark ring. */
+#define RING_SLOTS 16
+
+/* Request and response area of a ring slot. */
+struct request {
+	pid_t pid;
+	unsigned long int value;
+};
+
+/* Single slot region used by the previous protocol. */
+struct single {
+	pid_t pid;
+	_Bool valid;
+	struct request request;
+};
+
+
+/**
+ * Private function.
+ *
+ * This function returns the number of seconds which have elapsed
+ * since the supplied starting time.
+ *
+ * \param start	A pointer to the structure containing the starting
+ *		time.
+ *
+ * \return	The number of elapsed seconds.
+ */
+
+static double elapsed(const struct timespec *start)
+
+{
+	struct timespec end;
+
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) + \
+		(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function implements a benchmark client of the request ring.
+ * Each request carries a value which the server increments.
+ *
+ * \param count	The number of requests to be made.
+ *
+ * \return	The exit status for the client process.
+ */
+
+static int ring_client(const unsigned long int count)
+
+{
+	int retn = 1;
+
+	unsigned int slot;
+
+	unsigned long int lp;
+
+	struct request *rp;
+
+	IPC ipc = NULL;
+
+
+	INIT(NAAAIM, IPC, ipc, ERR(goto done));
+	if ( !ipc->attach(ipc, RING_NAME) )
+		ERR(goto done);
+
+	for (lp= 0; lp < count; ++lp) {
+		if ( !ipc->claim(ipc, &slot) )
+			ERR(goto done);
+		rp = ipc->get_slot(ipc, slot);
+		rp->pid	  = getpid();
+		rp->value = lp;
+
+		if ( !ipc->post(ipc, slot) )
+			ERR(goto done);
+		if ( !ipc->wait(ipc, slot) )
+			ERR(goto done);
+		if ( (rp->pid != getpid()) || (rp->value != lp + 1) ) {
+			fprintf(stderr, "Client %d: bad response.\n", getpid());
+			goto done;
+		}
+
+		if ( !ipc->release(ipc, slot) )
+			ERR(goto done);
+	}
+
+	retn = 0;
+
+
+ done:
+	WHACK(ipc);
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function implements a benchmark client of the single slot
+ * protocol.
+ *
+ * \param ipc	The object containing the single slot region.
+ *
+ * \param count	The number of requests to be made.
+ *
+ * \return	The exit status for the client process.
+ */
+
+static int single_client(CO(IPC, ipc), const unsigned long int count)
+
+{
+	int retn = 1;
+
+	unsigned long int lp;
+
+	volatile struct single *sp = ipc->get(ipc);
+
+
+	for (lp= 0; lp < count; ++lp) {
+		if ( !ipc->lock(ipc) )
+			ERR(goto done);
+
+		sp->request.pid	  = getpid();
+		sp->request.value = lp;
+		sp->valid	  = false;
+
+		kill(sp->pid, SIGUSR1);
+		while ( !sp->valid )
+			continue;
+
+		if ( (sp->request.pid != getpid()) || \
+		     (sp->request.value != lp + 1) ) {
+			fprintf(stderr, "Client %d: bad response.\n", getpid());
+			goto done;
+		}
+
+		if ( !ipc->unlock(ipc) )
+			ERR(goto done);
+	}
+
+	retn = 0;
+
+
+ done:
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function waits for the benchmark clients to exit.
+ *
+ * \param clients	The number of client processes.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not all of the clients completed
+ *			successfully.
+ */
+
+static _Bool reap(const unsigned int clients)
+
+{
+	_Bool retn = true;
+
+	int status;
+
+	unsigned int lp;
+
+
+	for (lp= 0; lp < clients; ++lp) {
+		if ( (wait(&status) == -1) || !WIFEXITED(status) || \
+		     (WEXITSTATUS(status) != 0) )
+			retn = false;
+	}
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function measures the request throughput of the ring and of
+ * the single slot protocol.
+ *
+ * \param clients	The number of client processes.
+ *
+ * \param count		The number of requests made by each client.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the benchmark completed successfully.
+ */
+
+static _Bool benchmark(const unsigned int clients, \
+		       const unsigned long int count)
+
+{
+	_Bool retn = false,
+	      found;
+
+	int sig;
+
+	unsigned int lp,
+		     slot;
+
+	unsigned long int served,
+			  total = clients * count;
+
+	pid_t pid;
+
+	sigset_t signals;
+
+	struct timespec start;
+
+	struct request *rp;
+
+	volatile struct single *sp;
+
+	IPC ipc = NULL;
+
+
+	fprintf(stdout, "%u clients, %lu requests per client:\n", clients, \
+		count);
+
+	/* Request ring. */
+	INIT(NAAAIM, IPC, ipc, ERR(goto done));
+	if ( !ipc->create_ring(ipc, RING_NAME, 0, sizeof(struct request), \
+			       RING_SLOTS) )
+		ERR(goto done);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (lp= 0; lp < clients; ++lp) {
+		if ( (pid = fork()) == -1 )
+			ERR(goto done);
+		if ( pid == 0 )
+			_exit(ring_client(count));
+	}
+
+	for (served= 0; served < total; ++served) {
+		if ( !ipc->next(ipc, &slot, &found, true) || !found )
+			ERR(goto done);
+		rp = ipc->get_slot(ipc, slot);
+		++rp->value;
+		if ( !ipc->respond(ipc, slot) )
+			ERR(goto done);
+	}
+	if ( !reap(clients) ) {
+		fputs("Ring client failed.\n", stdout);
+		goto done;
+	}
+	fprintf(stdout, "  ring:        %10.0f requests/second\n", \
+		total / elapsed(&start));
+	WHACK(ipc);
+
+
+	/* Single slot protocol. */
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGUSR1);
+	sigprocmask(SIG_BLOCK, &signals, NULL);
+
+	INIT(NAAAIM, IPC, ipc, ERR(goto done));
+	if ( !ipc->create(ipc, RING_NAME, sizeof(struct single)) )
+		ERR(goto done);
+	sp = ipc->get(ipc);
+	sp->pid = getpid();
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (lp= 0; lp < clients; ++lp) {
+		if ( (pid = fork()) == -1 )
+			ERR(goto done);
+		if ( pid == 0 )
+			_exit(single_client(ipc, count));
+	}
+
+	for (served= 0; served < total; ) {
+		if ( sigwait(&signals, &sig) != 0 )
+			ERR(goto done);
+		if ( sp->valid )
+			continue;
+		++sp->request.value;
+		sp->valid = true;
+		++served;
+	}
+	if ( !reap(clients) ) {
+		fputs("Single slot client failed.\n", stdout);
+		goto done;
+	}
+	fprintf(stdout, "  single slot: %10.0f requests/second\n", \
+		total / elapsed(&start));
+
+	retn = true;
+
+
+ done:
+	WHACK(ipc);
+
+	return retn;
+}
+
+
 extern int main(int argc, char *argv[])
 
 {
+	_Bool ring = false;
+
+	int opt;
+
+	unsigned int clients = 8;
+
+	unsigned long int count = 10000;
+
 	pid_t pid;
 
 	const char * const ipcname = "IPC_test";
@@ -30,6 +362,23 @@ extern int main(int argc, char *argv[])
 	IPC ipc = NULL;
 
 
+	while ( (opt = getopt(argc, argv, "Rc:n:")) != EOF )
+		switch ( opt ) {
+			case 'R':
+				ring = true;
+				break;
+			case 'c':
+				clients = strtoul(optarg, NULL, 0);
+				break;
+			case 'n':
+				count = strtoul(optarg, NULL, 0);
+				break;
+		}
+
+	if ( ring )
+		return benchmark(clients, count) ? 0 : 1;
+
+
 	INIT(NAAAIM, IPC, ipc, goto done);
 
 	if ( argv[1] == NULL ) {
@@ -0,0 +1,788 @@
+/** \file
+ * This file contains the implementation of an object which manages
+ * an index of identity verifiers (Ivy objects).
+ *
+ * The index is a single file consisting of a header, a table of
+ * fixed size entries and a data area.  Each entry holds the identity
+ * material of a verifier, which is the organizational key and
+ * identity from its identity token, along with the location of the
+ * encoded verifier and the name of the file it was generated from.
+ *
+ * An identity assertion is an HMAC of the identity material under a
+ * key chosen by the counter-party for each connection.  The
+ * assertion therefore cannot be used to address the index directly,
+ * but it can be checked against each entry with a single HMAC over
+ * the mapped identity material.  Only the verifier which matches the
+ * assertion is decoded.
+ *
+ * The index is updated incrementally.  Entries whose source verifier
+ * file has not changed are carried forward without being decoded.
+ *
+ * A matching entry is only returned if its source verifier file still
+ * exists with the modification time and size recorded in the entry.
+ * Removing or replacing a verifier file therefore revokes the entry
+ * without the index being regenerated, the caller falls back to
+ * examining the verifier files themselves.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+
+/* Local defines. */
+#define INDEX_MAGIC "IVYINDEX"
+#define INDEX_VERSION 1
+
+
+/* Include files. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <glob.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <Origin.h>
+#include <HurdLib.h>
+#include <Buffer.h>
+#include <String.h>
+#include <File.h>
+
+#include "NAAAIM.h"
+#include "SHA256_hmac.h"
+#include "IDtoken.h"
+#include "Ivy.h"
+#include "IvyIndex.h"
+
+
+/* Verify library/object header file inclusions. */
+#if !defined(NAAAIM_LIBID)
+#error Library identifier not defined.
+#endif
+
+#if !defined(NAAAIM_IvyIndex_OBJID)
+#error Object identifier not defined.
+#endif
+
+
+/* Object state extraction macro. */
+#define STATE(var) CO(IvyIndex_State, var) = this->state
+
+
+/**
+ * The following structure defines the header of the index file.
+ */
+struct index_header {
+	char magic[8];
+	uint32_t version;
+	uint32_t count;
+};
+
+/**
+ * The following structure defines an entry in the index table.  The
+ * verifier and the name of its source file are stored contiguously
+ * at the offset in the entry.
+ */
+struct index_entry {
+	uint8_t identity[2 * NAAAIM_IDSIZE];
+	int64_t mtime;
+	uint64_t size;
+	uint64_t offset;
+	uint32_t length;
+	uint32_t pathlen;
+};
+
+
+/** IvyIndex private state information. */
+struct NAAAIM_IvyIndex_State
+{
+	/* The root object. */
+	Origin root;
+
+	/* Library identifier. */
+	uint32_t libid;
+
+	/* Object identifier. */
+	uint32_t objid;
+
+	/* Object status. */
+	_Bool poisoned;
+
+	/* The mapped index file. */
+	uint8_t *map;
+	size_t map_size;
+
+	/* The table of index entries. */
+	const struct index_entry *entries;
+	uint32_t count;
+};
+
+
+/**
+ * Internal private method.
+ *
+ * This method is responsible for initializing the NAAAIM_IvyIndex_State
+ * structure which holds state information for each instantiated object.
+ *
+ * \param S A pointer to the object containing the state information which
+ *        is to be initialized.
+ */
+
+static void _init_state(CO(IvyIndex_State, S))
+
+{
+	S->libid = NAAAIM_LIBID;
+	S->objid = NAAAIM_IvyIndex_OBJID;
+
+	S->poisoned = false;
+
+	S->map	    = NULL;
+	S->map_size = 0;
+
+	S->entries = NULL;
+	S->count   = 0;
+
+	return;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function verifies that the data described by an index entry
+ * falls within the mapped index file.
+ *
+ * \param S	A pointer to the state of the object holding the index.
+ *
+ * \param ep	A pointer to the entry to be verified.
+ *
+ * \return	A true value is returned if the entry is valid.
+ */
+
+static _Bool _valid_entry(CO(IvyIndex_State, S), \
+			  CO(struct index_entry *, ep))
+
+{
+	uint64_t end = ep->offset + ep->length + ep->pathlen;
+
+
+	if ( (end < ep->offset) || (end > S->map_size) )
+		return false;
+	return true;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements mapping an index file into the object.
+ *
+ * \param this	A pointer to the object which is to map the index.
+ *
+ * \param path	A pointer to a null-terminated character buffer
+ *		containing the name of the index file.
+ *
+ * \return	A boolean value is used to indicate whether or not
+ *		the index was mapped.  A false value indicates the
+ *		file could not be mapped or was not a valid index.
+ */
+
+static _Bool load(CO(IvyIndex, this), CO(char *, path))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	int fd = -1;
+
+	uint32_t lp;
+
+	struct stat statbuf;
+
+	const struct index_header *hp;
+
+
+	if ( S->poisoned )
+		ERR(goto done);
+	this->reset(this);
+
+	if ( (fd = open(path, O_RDONLY)) == -1 )
+		goto done;
+	if ( fstat(fd, &statbuf) == -1 )
+		ERR(goto done);
+	if ( (size_t) statbuf.st_size < sizeof(struct index_header) )
+		ERR(goto done);
+
+	S->map = mmap(NULL, statbuf.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if ( S->map == MAP_FAILED ) {
+		S->map = NULL;
+		ERR(goto done);
+	}
+	S->map_size = statbuf.st_size;
+
+	/* Verify the header and entry table. */
+	hp = (const struct index_header *) S->map;
+	if ( memcmp(hp->magic, INDEX_MAGIC, sizeof(hp->magic)) != 0 )
+		ERR(goto done);
+	if ( hp->version != INDEX_VERSION )
+		ERR(goto done);
+	if ( hp->count > ((S->map_size - sizeof(struct index_header)) / \
+			  sizeof(struct index_entry)) )
+		ERR(goto done);
+
+	S->entries = (const struct index_entry *) (S->map + sizeof(*hp));
+	for (lp= 0; lp < hp->count; ++lp) {
+		if ( !_valid_entry(S, &S->entries[lp]) )
+			ERR(goto done);
+	}
+	S->count = hp->count;
+
+	retn = true;
+
+
+ done:
+	if ( fd != -1 )
+		close(fd);
+	if ( !retn )
+		this->reset(this);
+
+	return retn;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function extracts the identity material from an encoded
+ * verifier.
+ *
+ * \param bufr		The object containing the encoded verifier.
+ *
+ * \param identity	A pointer to the area which the identity
+ *			material is to be copied into.
+ *
+ * \return		A boolean value is used to indicate whether
+ *			or not the identity material was extracted.
+ */
+
+static _Bool _extract_identity(CO(Buffer, bufr), uint8_t *identity)
+
+{
+	_Bool retn = false;
+
+	Buffer b;
+
+	IDtoken token = NULL;
+
+	Ivy ivy = NULL;
+
+
+	INIT(NAAAIM, IDtoken, token, goto done);
+	INIT(NAAAIM, Ivy, ivy, goto done);
+
+	if ( !ivy->decode(ivy, bufr) )
+		ERR(goto done);
+	if ( (b = ivy->get_element(ivy, Ivy_id)) == NULL )
+		ERR(goto done);
+	if ( !token->decode(token, b) )
+		ERR(goto done);
+
+	if ( (b = token->get_element(token, IDtoken_orgkey)) == NULL )
+		ERR(goto done);
+	if ( b->size(b) != NAAAIM_IDSIZE )
+		ERR(goto done);
+	memcpy(identity, b->get(b), NAAAIM_IDSIZE);
+
+	if ( (b = token->get_element(token, IDtoken_orgid)) == NULL )
+		ERR(goto done);
+	if ( b->size(b) != NAAAIM_IDSIZE )
+		ERR(goto done);
+	memcpy(identity + NAAAIM_IDSIZE, b->get(b), NAAAIM_IDSIZE);
+
+	retn = true;
+
+
+ done:
+	WHACK(token);
+	WHACK(ivy);
+
+	return retn;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function verifies that the verifier file an index entry was
+ * generated from has not been removed or modified since the entry
+ * was generated.
+ *
+ * \param S	A pointer to the state of the object holding the index.
+ *
+ * \param ep	A pointer to the entry to be verified.
+ *
+ * \return	A true value is returned if the verifier file is
+ *		unchanged.
+ */
+
+static _Bool _current_entry(CO(IvyIndex_State, S), \
+			    CO(struct index_entry *, ep))
+
+{
+	char path[PATH_MAX];
+
+	struct stat statbuf;
+
+
+	if ( ep->pathlen >= sizeof(path) )
+		return false;
+	memcpy(path, S->map + ep->offset + ep->length, ep->pathlen);
+	path[ep->pathlen] = '\0';
+
+	if ( stat(path, &statbuf) == -1 )
+		return false;
+	if ( (ep->mtime != statbuf.st_mtime) || \
+	     (ep->size != (uint64_t) statbuf.st_size) )
+		return false;
+
+	return true;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function searches the currently mapped index for the entry
+ * generated from a verifier file.  The entry is only returned if the
+ * file has not been modified since the entry was generated.
+ *
+ * \param S		A pointer to the state of the object holding
+ *			the index.
+ *
+ * \param path		A pointer to the name of the verifier file.
+ *
+ * \param statbuf	A pointer to the status of the verifier file.
+ *
+ * \return		A pointer to the matching entry is returned or
+ *			NULL if there is no current entry for the file.
+ */
+
+static const struct index_entry * _find_current(CO(IvyIndex_State, S), \
+						CO(char *, path),      \
+						const struct stat *statbuf)
+
+{
+	uint32_t lp;
+
+	size_t pathlen = strlen(path);
+
+	const struct index_entry *ep;
+
+
+	for (lp= 0; lp < S->count; ++lp) {
+		ep = &S->entries[lp];
+		if ( (ep->pathlen != pathlen) ||			     \
+		     (memcmp(S->map + ep->offset + ep->length, path, pathlen) \
+		      != 0) )
+			continue;
+		if ( (ep->mtime == statbuf->st_mtime) && \
+		     (ep->size == (uint64_t) statbuf->st_size) )
+			return ep;
+		return NULL;
+	}
+
+	return NULL;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements generating or updating an index file from
+ * a set of verifier files.  Entries for files which are unchanged
+ * since the index was last generated are carried forward from the
+ * existing index.  The new index is written to a temporary file which
+ * is then renamed over the index so that readers which have the
+ * previous version mapped are unaffected.  The object is left
+ * mapping the updated index.
+ *
+ * \param this		A pointer to the object which is to update
+ *			the index.
+ *
+ * \param path		A pointer to a null-terminated character
+ *			buffer containing the name of the index file.
+ *
+ * \param pattern	A pointer to a null-terminated character
+ *			buffer containing the glob pattern which
+ *			selects the verifier files to be indexed.
+ *
+ * \return		A boolean value is used to indicate whether
+ *			or not the index was updated.
+ */
+
+static _Bool update(CO(IvyIndex, this), CO(char *, path), \
+		    CO(char *, pattern))
+
+{
+	STATE(S);
+
+	_Bool retn	= false,
+	      have_glob = false;
+
+	uint64_t offset;
+
+	size_t lp;
+
+	glob_t files;
+
+	struct stat statbuf;
+
+	struct index_header header;
+
+	struct index_entry entry;
+
+	const struct index_entry *ep;
+
+	Buffer table = NULL,
+	       data  = NULL,
+	       bufr  = NULL;
+
+	String tmpname = NULL;
+
+	File file = NULL;
+
+
+	if ( S->poisoned )
+		ERR(goto done);
+
+	INIT(HurdLib, Buffer, table, goto done);
+	INIT(HurdLib, Buffer, data, goto done);
+	INIT(HurdLib, Buffer, bufr, goto done);
+	INIT(HurdLib, File, file, goto done);
+
+	/* Map the current index, if any, to carry forward entries. */
+	this->load(this, path);
+
+	switch ( glob(pattern, 0, NULL, &files) ) {
+		case 0:
+			have_glob = true;
+			break;
+		case GLOB_NOMATCH:
+			files.gl_pathc = 0;
+			break;
+		default:
+			ERR(goto done);
+	}
+
+	/* Generate the entry table and data area. */
+	memset(&header, '\0', sizeof(header));
+	memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+	header.version = INDEX_VERSION;
+	header.count   = files.gl_pathc;
+
+	offset = sizeof(header) + files.gl_pathc * sizeof(entry);
+
+	for (lp= 0; lp < files.gl_pathc; ++lp) {
+		if ( stat(files.gl_pathv[lp], &statbuf) == -1 )
+			ERR(goto done);
+
+		memset(&entry, '\0', sizeof(entry));
+		entry.mtime   = statbuf.st_mtime;
+		entry.size    = statbuf.st_size;
+		entry.offset  = offset + data->size(data);
+		entry.pathlen = strlen(files.gl_pathv[lp]);
+
+		bufr->reset(bufr);
+		if ( (ep = _find_current(S, files.gl_pathv[lp], &statbuf)) \
+		     != NULL ) {
+			memcpy(entry.identity, ep->identity, \
+			       sizeof(entry.identity));
+			bufr->add(bufr, S->map + ep->offset, ep->length);
+		}
+		else {
+			file->reset(file);
+			if ( !file->open_ro(file, files.gl_pathv[lp]) )
+				ERR(goto done);
+			if ( !file->slurp(file, bufr) )
+				ERR(goto done);
+			if ( !_extract_identity(bufr, entry.identity) )
+				ERR(goto done);
+		}
+		entry.length = bufr->size(bufr);
+
+		data->add_Buffer(data, bufr);
+		data->add(data, (unsigned char *) files.gl_pathv[lp], \
+			  entry.pathlen);
+		if ( !table->add(table, (unsigned char *) &entry, \
+				 sizeof(entry)) )
+			ERR(goto done);
+	}
+	if ( data->poisoned(data) )
+		ERR(goto done);
+
+	/* Write the index to a temporary file and move it into place. */
+	bufr->reset(bufr);
+	bufr->add(bufr, (unsigned char *) &header, sizeof(header));
+	bufr->add_Buffer(bufr, table);
+	if ( !bufr->add_Buffer(bufr, data) )
+		ERR(goto done);
+
+	if ( (tmpname = HurdLib_String_Init_cstr(path)) == NULL )
+		ERR(goto done);
+	if ( !tmpname->add(tmpname, ".tmp") )
+		ERR(goto done);
+
+	file->reset(file);
+	if ( !file->open_rw(file, tmpname->get(tmpname)) )
+		ERR(goto done);
+	if ( !file->write_Buffer(file, bufr) )
+		ERR(goto done);
+	file->reset(file);
+
+	if ( rename(tmpname->get(tmpname), path) == -1 )
+		ERR(goto done);
+
+	retn = this->load(this, path);
+
+
+ done:
+	if ( have_glob )
+		globfree(&files);
+	if ( !retn && (tmpname != NULL) )
+		unlink(tmpname->get(tmpname));
+
+	WHACK(table);
+	WHACK(data);
+	WHACK(bufr);
+	WHACK(tmpname);
+	WHACK(file);
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements searching the index for the verifier which
+ * matches the identity assertion in a POSSUM packet.  A matching
+ * entry whose verifier file has been removed or modified since the
+ * index was generated is not returned.
+ *
+ * \param this		A pointer to the index which is to be searched.
+ *
+ * \param packet	The Buffer object containing the type 1 POSSUM
+ *			packet which was received.
+ *
+ * \param token		The IDtoken object which will be loaded with
+ *			the identity token of the counter-party.
+ *
+ * \param ivy		The identity verifier object which will be
+ *			loaded with the verifier of the counter-party.
+ *
+ * \return		A true value is used to indicate the search
+ *			was successful.  A false value is returned if
+ *			the counter-party was not found or its index
+ *			entry is no longer current.
+ */
+
+static _Bool find(CO(IvyIndex, this), CO(Buffer, packet), \
+		  CO(IDtoken, token), CO(Ivy, ivy))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	uint32_t lp;
+
+	unsigned char *identity;
+
+	const struct index_entry *ep;
+
+	Buffer b,
+	       idkey = NULL;
+
+	SHA256_hmac idf = NULL;
+
+
+	if ( S->poisoned )
+		ERR(goto done);
+	if ( (packet == NULL) || packet->poisoned(packet) )
+		ERR(goto done);
+	if ( packet->size(packet) < (2 * NAAAIM_IDSIZE) )
+		ERR(goto done);
+
+	/* Load the identity key and the asserted identity. */
+	INIT(HurdLib, Buffer, idkey, goto done);
+	if ( !idkey->add(idkey, packet->get(packet), NAAAIM_IDSIZE) )
+		ERR(goto done);
+	identity = packet->get(packet) + NAAAIM_IDSIZE;
+
+	if ( (idf = NAAAIM_SHA256_hmac_Init(idkey)) == NULL )
+		ERR(goto done);
+
+	/* Compute the assertion for each entry. */
+	for (lp= 0; lp < S->count; ++lp) {
+		ep = &S->entries[lp];
+
+		idf->add(idf, ep->identity, sizeof(ep->identity));
+		if ( !idf->compute(idf) )
+			ERR(goto done);
+		if ( memcmp(idf->get(idf), identity, NAAAIM_IDSIZE) != 0 ) {
+			idf->reset(idf);
+			continue;
+		}
+		if ( !_current_entry(S, ep) )
+			goto done;
+
+		/* Decode the matching verifier and identity. */
+		token->reset(token);
+		ivy->reset(ivy);
+
+		idkey->reset(idkey);
+		if ( !idkey->add(idkey, S->map + ep->offset, ep->length) )
+			ERR(goto done);
+		if ( !ivy->decode(ivy, idkey) )
+			ERR(goto done);
+		if ( (b = ivy->get_element(ivy, Ivy_id)) == NULL )
+			ERR(goto done);
+		if ( !token->decode(token, b) )
+			ERR(goto done);
+
+		retn = true;
+		break;
+	}
+
+
+ done:
+	WHACK(idkey);
+	WHACK(idf);
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements an accessor for the number of verifiers in
+ * the mapped index.
+ *
+ * \param this	A pointer to the object whose size is to be returned.
+ *
+ * \return	The number of entries in the index.
+ */
+
+static size_t size(CO(IvyIndex, this))
+
+{
+	STATE(S);
+
+
+	return S->count;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements unmapping the index held by the object.
+ *
+ * \param this	A pointer to the object which is to be reset.
+ */
+
+static void reset(CO(IvyIndex, this))
+
+{
+	STATE(S);
+
+
+	if ( S->map != NULL )
+		munmap(S->map, S->map_size);
+
+	S->map	    = NULL;
+	S->map_size = 0;
+	S->entries  = NULL;
+	S->count    = 0;
+
+	return;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements a destructor for an IvyIndex object.
+ *
+ * \param this	A pointer to the object which is to be destroyed.
+ */
+
+static void whack(CO(IvyIndex, this))
+
+{
+	STATE(S);
+
+
+	this->reset(this);
+
+	S->root->whack(S->root, this, S);
+	return;
+}
+
+
+/**
+ * External constructor call.
+ *
+ * This function implements a constructor call for an IvyIndex object.
+ *
+ * \return	A pointer to the initialized IvyIndex.  A null value
+ *		indicates an error was encountered in object generation.
+ */
+
+extern IvyIndex NAAAIM_IvyIndex_Init(void)
+
+{
+	Origin root;
+
+	IvyIndex this = NULL;
+
+	struct HurdLib_Origin_Retn retn;
+
+
+	/* Get the root object. */
+	root = HurdLib_Origin_Init();
+
+	/* Allocate the object and internal state. */
+	retn.object_size  = sizeof(struct NAAAIM_IvyIndex);
+	retn.state_size   = sizeof(struct NAAAIM_IvyIndex_State);
+	if ( !root->init(root, NAAAIM_LIBID, NAAAIM_IvyIndex_OBJID, &retn) )
+		return NULL;
+	this	    	  = retn.object;
+	this->state 	  = retn.state;
+	this->state->root = root;
+
+	/* Initialize object state. */
+	_init_state(this->state);
+
+	/* Method initialization. */
+	this->load   = load;
+	this->update = update;
+
+	this->find = find;
+	this->size = size;
+
+	this->reset = reset;
+	this->whack = whack;
+
+	return this;
+}
@@ -0,0 +1,52 @@
+/** \file
+ * This file contains the API definitions for an object which implements
+ * an index of identity verifiers.  The index is a single file which
+ * holds the identity material of each verifier along with its encoded
+ * Ivy object.  The file is memory mapped so that a counter-party can
+ * be located without reading and decoding each verifier file.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+
+#ifndef NAAAIM_IvyIndex_HEADER
+#define NAAAIM_IvyIndex_HEADER
+
+
+/* Default location of the verifier index. */
+#define IVYINDEX_DEFAULT "/etc/conf/ivy.idx"
+
+
+/* Object type definitions. */
+typedef struct NAAAIM_IvyIndex * IvyIndex;
+
+typedef struct NAAAIM_IvyIndex_State * IvyIndex_State;
+
+/**
+ * External IvyIndex object representation.
+ */
+struct NAAAIM_IvyIndex
+{
+	/* External methods. */
+	_Bool (*load)(const IvyIndex, const char *);
+	_Bool (*update)(const IvyIndex, const char *, const char *);
+
+	_Bool (*find)(const IvyIndex, const Buffer, const IDtoken, const Ivy);
+	size_t (*size)(const IvyIndex);
+
+	void (*reset)(const IvyIndex);
+	void (*whack)(const IvyIndex);
+
+	/* Private state. */
+	IvyIndex_State state;
+};
+
+
+/* IvyIndex constructor call. */
+extern HCLINK IvyIndex NAAAIM_IvyIndex_Init(void);
+#endif
@@ -0,0 +1,242 @@
+/** \file
+ * This file implements a test and timing driver for the IvyIndex
+ * object.
+ *
+ * The -u option generates or updates an index from the identity
+ * verifiers selected by a glob pattern.  The -f option specifies a
+ * verifier whose identity assertion is computed and then located in
+ * the index.  The -c option specifies the number of lookups to be
+ * timed.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <time.h>
+
+#include <HurdLib.h>
+#include <Buffer.h>
+#include <String.h>
+#include <File.h>
+
+#include <NAAAIM.h>
+#include "SHA256_hmac.h"
+#include "IDtoken.h"
+#include "Ivy.h"
+#include "IvyIndex.h"
+
+
+/**
+ * Private function.
+ *
+ * This function returns the number of milliseconds which have elapsed
+ * since the supplied starting time.
+ *
+ * \param start	A pointer to the structure holding the starting time.
+ *
+ * \return	The elapsed time in milliseconds.
+ */
+
+static double elapsed_ms(const struct timespec *start)
+
+{
+	struct timespec now;
+
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1000.0 + \
+		(now.tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function generates the identity assertion packet which a
+ * counter-party holding the supplied verifier would send.
+ *
+ * \param verifier	The name of the file holding the verifier.
+ *
+ * \param packet	The object which the packet is to be loaded into.
+ *
+ * \return		A boolean value is used to indicate whether or
+ *			not the packet was generated.
+ */
+
+static _Bool make_packet(CO(char *, verifier), CO(Buffer, packet))
+
+{
+	_Bool retn = false;
+
+	unsigned char lp;
+
+	Buffer b,
+	       bufr = NULL;
+
+	File file = NULL;
+
+	IDtoken token = NULL;
+
+	Ivy ivy = NULL;
+
+	SHA256_hmac idf = NULL;
+
+
+	INIT(HurdLib, Buffer, bufr, goto done);
+	INIT(HurdLib, File, file, goto done);
+	INIT(NAAAIM, IDtoken, token, goto done);
+	INIT(NAAAIM, Ivy, ivy, goto done);
+
+	if ( !file->open_ro(file, verifier) )
+		ERR(goto done);
+	if ( !file->slurp(file, bufr) )
+		ERR(goto done);
+	if ( !ivy->decode(ivy, bufr) )
+		ERR(goto done);
+	if ( (b = ivy->get_element(ivy, Ivy_id)) == NULL )
+		ERR(goto done);
+	if ( !token->decode(token, b) )
+		ERR(goto done);
+
+	/* Use a fixed identity key for reproducible timing. */
+	bufr->reset(bufr);
+	for (lp= 0; lp < NAAAIM_IDSIZE; ++lp)
+		bufr->add(bufr, &lp, 1);
+	if ( (idf = NAAAIM_SHA256_hmac_Init(bufr)) == NULL )
+		ERR(goto done);
+
+	if ( (b = token->get_element(token, IDtoken_orgkey)) == NULL )
+		ERR(goto done);
+	idf->add_Buffer(idf, b);
+	if ( (b = token->get_element(token, IDtoken_orgid)) == NULL )
+		ERR(goto done);
+	idf->add_Buffer(idf, b);
+	if ( !idf->compute(idf) )
+		ERR(goto done);
+
+	packet->add_Buffer(packet, bufr);
+	if ( !packet->add_Buffer(packet, idf->get_Buffer(idf)) )
+		ERR(goto done);
+
+	retn = true;
+
+
+ done:
+	WHACK(bufr);
+	WHACK(file);
+	WHACK(token);
+	WHACK(ivy);
+	WHACK(idf);
+
+	return retn;
+}
+
+
+extern int main(int argc, char *argv[])
+
+{
+	char *index   = IVYINDEX_DEFAULT,
+	     *pattern  = NULL,
+	     *verifier = NULL;
+
+	int opt,
+	    retn = 1;
+
+	unsigned long int lp,
+			  count = 1;
+
+	struct timespec start;
+
+	Buffer packet = NULL;
+
+	IDtoken token = NULL;
+
+	Ivy ivy = NULL;
+
+	IvyIndex idx = NULL;
+
+
+	while ( (opt = getopt(argc, argv, "c:f:i:u:")) != EOF )
+		switch ( opt ) {
+			case 'c':
+				count = strtoul(optarg, NULL, 0);
+				break;
+			case 'f':
+				verifier = optarg;
+				break;
+			case 'i':
+				index = optarg;
+				break;
+			case 'u':
+				pattern = optarg;
+				break;
+		}
+
+
+	INIT(NAAAIM, IvyIndex, idx, ERR(goto done));
+
+	if ( pattern != NULL ) {
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		if ( !idx->update(idx, index, pattern) ) {
+			fputs("Index update failed.\n", stderr);
+			goto done;
+		}
+		fprintf(stdout, "Indexed %zu verifiers in %.3f ms.\n", \
+			idx->size(idx), elapsed_ms(&start));
+	}
+	else {
+		if ( !idx->load(idx, index) ) {
+			fprintf(stderr, "Cannot load index: %s\n", index);
+			goto done;
+		}
+		fprintf(stdout, "Loaded %zu verifiers.\n", idx->size(idx));
+	}
+
+	if ( verifier == NULL ) {
+		retn = 0;
+		goto done;
+	}
+
+
+	/* Time lookups of the counter-party. */
+	INIT(HurdLib, Buffer, packet, ERR(goto done));
+	INIT(NAAAIM, IDtoken, token, ERR(goto done));
+	INIT(NAAAIM, Ivy, ivy, ERR(goto done));
+
+	if ( !make_packet(verifier, packet) ) {
+		fputs("Cannot generate identity assertion.\n", stderr);
+		goto done;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (lp= 0; lp < count; ++lp) {
+		if ( !idx->find(idx, packet, token, ivy) ) {
+			fputs("Verifier not found.\n", stderr);
+			goto done;
+		}
+	}
+	fprintf(stdout, "%lu lookups: %.3f ms, %.3f us/lookup.\n", count, \
+		elapsed_ms(&start), elapsed_ms(&start) * 1000.0 / count);
+
+	fputs("Identity:\n", stdout);
+	token->print(token);
+	retn = 0;
+
+
+ done:
+	WHACK(packet);
+	WHACK(token);
+	WHACK(ivy);
+	WHACK(idx);
+
+	return retn;
+}
@@ -0,0 +1,493 @@
+/** \file
+ * This file contains the implementation of an object which implements
+ * a cache of signed security models whose signatures have been
+ * verified.
+ *
+ * Each orchestrator launch of a cartridge with a signed security
+ * model verifies the RSA signature over the model.  When a large
+ * number of workloads are started with the same model this
+ * verification is repeated for each launch.  This object allows the
+ * result of a successful verification to be recorded in a directory
+ * so that subsequent launches can accept the model on the basis of
+ * the earlier verification.
+ *
+ * A cache entry is a file whose name is formed from the hexadecimal
+ * representation of the digest of the signed model contents and the
+ * digest, or fingerprint, of the public key that verified it.  The
+ * entry contains the digest of the verified signature so that an
+ * entry is only used for the signature that was verified.
+ *
+ * Since a cache entry stands in for a signature verification the
+ * cache directory, and each entry, is only trusted if it is owned by
+ * the effective user of the process and is not writable by any other
+ * user.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+
+/* Include files. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <Origin.h>
+#include <HurdLib.h>
+#include <Buffer.h>
+#include <String.h>
+
+#include "NAAAIM.h"
+#include "SHA256.h"
+#include "Hex.h"
+#include "ModelCache.h"
+
+
+/* Verify library/object header file inclusions. */
+#if !defined(NAAAIM_LIBID)
+#error Library identifier not defined.
+#endif
+
+#if !defined(NAAAIM_ModelCache_OBJID)
+#error Object identifier not defined.
+#endif
+
+
+/* Object state extraction macro. */
+#define STATE(var) CO(ModelCache_State, var) = this->state
+
+/* Size of a cache entry name. */
+#define NAME_SIZE (4 * NAAAIM_IDSIZE + 2)
+
+
+/** ModelCache private state information. */
+struct NAAAIM_ModelCache_State
+{
+	/* The root object. */
+	Origin root;
+
+	/* Library identifier. */
+	uint32_t libid;
+
+	/* Object identifier. */
+	uint32_t objid;
+
+	/* Object status. */
+	_Bool poisoned;
+
+	/* The cache directory. */
+	int dirfd;
+};
+
+
+/**
+ * Internal private method.
+ *
+ * This method is responsible for initializing the NAAAIM_ModelCache_State
+ * structure which holds state information for each instantiated object.
+ *
+ * \param S A pointer to the object containing the state information which
+ *        is to be initialized.
+ */
+
+static void _init_state(CO(ModelCache_State, S))
+
+{
+	S->libid = NAAAIM_LIBID;
+	S->objid = NAAAIM_ModelCache_OBJID;
+
+	S->poisoned = false;
+
+	S->dirfd = -1;
+
+	return;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function tests whether or not a cache directory or entry can
+ * be trusted.
+ *
+ * \param fd	The file descriptor of the directory or entry.
+ *
+ * \param type	The file type which the descriptor must refer to.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the file can be trusted.  A true value indicates the
+ *		file is owned by the effective user and is not writable
+ *		by any other user.
+ */
+
+static _Bool _trusted(const int fd, const mode_t type)
+
+{
+	struct stat statbuf;
+
+
+	if ( fstat(fd, &statbuf) == -1 )
+		return false;
+
+	if ( (statbuf.st_mode & S_IFMT) != type )
+		return false;
+	if ( statbuf.st_uid != geteuid() )
+		return false;
+	if ( (statbuf.st_mode & (S_IWGRP | S_IWOTH)) != 0 )
+		return false;
+
+	return true;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function computes the digest of the supplied object.
+ *
+ * \param bufr		The object whose digest is to be computed.
+ *
+ * \param digest	A pointer to the buffer which the digest is to
+ *			be copied into.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the digest was computed.
+ */
+
+static _Bool _digest(CO(Buffer, bufr), uint8_t *digest)
+
+{
+	_Bool retn = false;
+
+	Sha256 sha256 = NULL;
+
+
+	INIT(NAAAIM, Sha256, sha256, ERR(goto done));
+	if ( !sha256->add(sha256, bufr) )
+		ERR(goto done);
+	if ( !sha256->compute(sha256) )
+		ERR(goto done);
+
+	memcpy(digest, sha256->get(sha256), NAAAIM_IDSIZE);
+	retn = true;
+
+
+ done:
+	WHACK(sha256);
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function generates the name of the cache entry for a model
+ * digest and signing key.
+ *
+ * \param digest	The object containing the digest of the model.
+ *
+ * \param key		The object containing the public key that
+ *			verifies the model.
+ *
+ * \param name		A pointer to the buffer which the name is to
+ *			be written into.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the name was generated.
+ */
+
+static _Bool _entry_name(CO(Buffer, digest), CO(Buffer, key), char *name)
+
+{
+	uint8_t fingerprint[NAAAIM_IDSIZE];
+
+
+	if ( digest->size(digest) != NAAAIM_IDSIZE )
+		return false;
+	if ( !_digest(key, fingerprint) )
+		return false;
+
+	Hex_encode(digest->get(digest), NAAAIM_IDSIZE, name);
+	name[2 * NAAAIM_IDSIZE] = '-';
+	Hex_encode(fingerprint, sizeof(fingerprint), \
+		   name + 2 * NAAAIM_IDSIZE + 1);
+	name[NAME_SIZE - 1] = '\0';
+
+	return true;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method opens the directory which holds the cache.  The
+ * directory is created if it does not exist.
+ *
+ * \param this	A pointer to the cache object which is to be opened.
+ *
+ * \param dir	A pointer to a null-terminated buffer containing the
+ *		name of the cache directory.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the cache was opened.  A false value indicates the
+ *		directory could not be opened or could not be trusted.
+ */
+
+static _Bool open_cache(CO(ModelCache, this), const char *dir)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+
+	if ( S->poisoned )
+		ERR(goto done);
+	if ( S->dirfd != -1 )
+		ERR(goto done);
+
+	if ( (mkdir(dir, 0700) == -1) && (errno != EEXIST) )
+		goto done;
+
+	S->dirfd = open(dir, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | \
+			O_CLOEXEC);
+	if ( S->dirfd == -1 )
+		goto done;
+	if ( !_trusted(S->dirfd, S_IFDIR) ) {
+		close(S->dirfd);
+		S->dirfd = -1;
+		goto done;
+	}
+
+	retn = true;
+
+
+ done:
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method checks whether or not a model signature has been
+ * previously verified.
+ *
+ * \param this		A pointer to the cache object which is to be
+ *			checked.
+ *
+ * \param digest	The object containing the digest of the signed
+ *			contents of the model.
+ *
+ * \param key		The object containing the public key which
+ *			verifies the model.
+ *
+ * \param signature	The object containing the model signature.
+ *
+ * \param hit		A pointer to the boolean value which will be
+ *			set to indicate whether or not the signature
+ *			was previously verified.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the check was carried out.  A false
+ *			value indicates an error was encountered and no
+ *			assumption can be made about the hit status.
+ */
+
+static _Bool check(CO(ModelCache, this), CO(Buffer, digest), \
+		   CO(Buffer, key), CO(Buffer, signature), _Bool *hit)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	char name[NAME_SIZE];
+
+	uint8_t entry[NAAAIM_IDSIZE],
+		sigdigest[NAAAIM_IDSIZE];
+
+	int fd = -1;
+
+
+	if ( S->poisoned )
+		ERR(goto done);
+	if ( S->dirfd == -1 )
+		ERR(goto done);
+
+	if ( !_entry_name(digest, key, name) )
+		ERR(goto done);
+	if ( !_digest(signature, sigdigest) )
+		ERR(goto done);
+
+	*hit = false;
+	if ( (fd = openat(S->dirfd, name, O_RDONLY | O_NOFOLLOW | \
+			  O_CLOEXEC)) == -1 ) {
+		retn = true;
+		goto done;
+	}
+
+	if ( _trusted(fd, S_IFREG) && \
+	     (read(fd, entry, sizeof(entry)) == sizeof(entry)) && \
+	     (memcmp(entry, sigdigest, sizeof(entry)) == 0) )
+		*hit = true;
+	retn = true;
+
+
+ done:
+	if ( fd != -1 )
+		close(fd);
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method records a verified model signature in the cache.  The
+ * entry is written to a temporary file which is then renamed so that
+ * a partially written entry is never visible.
+ *
+ * \param this		A pointer to the cache object which is to be
+ *			updated.
+ *
+ * \param digest	The object containing the digest of the signed
+ *			contents of the model.
+ *
+ * \param key		The object containing the public key which
+ *			verified the model.
+ *
+ * \param signature	The object containing the verified model
+ *			signature.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the cache entry was recorded.
+ */
+
+static _Bool add(CO(ModelCache, this), CO(Buffer, digest), \
+		 CO(Buffer, key), CO(Buffer, signature))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	char name[NAME_SIZE],
+	     tmpname[NAME_SIZE + 16];
+
+	uint8_t sigdigest[NAAAIM_IDSIZE];
+
+	int fd = -1;
+
+
+	if ( S->poisoned )
+		ERR(goto done);
+	if ( S->dirfd == -1 )
+		ERR(goto done);
+
+	if ( !_entry_name(digest, key, name) )
+		ERR(goto done);
+	if ( !_digest(signature, sigdigest) )
+		ERR(goto done);
+
+	snprintf(tmpname, sizeof(tmpname), ".%.16s.%d", name, getpid());
+	if ( (fd = openat(S->dirfd, tmpname, O_WRONLY | O_CREAT | O_EXCL | \
+			  O_NOFOLLOW | O_CLOEXEC, 0600)) == -1 )
+		ERR(goto done);
+
+	if ( write(fd, sigdigest, sizeof(sigdigest)) != sizeof(sigdigest) )
+		ERR(goto done);
+	if ( renameat(S->dirfd, tmpname, S->dirfd, name) == -1 )
+		ERR(goto done);
+
+	retn = true;
+
+
+ done:
+	if ( fd != -1 ) {
+		close(fd);
+		if ( !retn )
+			unlinkat(S->dirfd, tmpname, 0);
+	}
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements a destructor for a ModelCache object.
+ *
+ * \param this	A pointer to the object which is to be destroyed.
+ */
+
+static void whack(CO(ModelCache, this))
+
+{
+	STATE(S);
+
+
+	if ( S->dirfd != -1 )
+		close(S->dirfd);
+
+	S->root->whack(S->root, this, S);
+	return;
+}
+
+
+/**
+ * External constructor call.
+ *
+ * This function implements a constructor call for a ModelCache object.
+ *
+ * \return	A pointer to the initialized ModelCache.  A null value
+ *		indicates an error was encountered in object generation.
+ */
+
+extern ModelCache NAAAIM_ModelCache_Init(void)
+
+{
+	Origin root;
+
+	ModelCache this = NULL;
+
+	struct HurdLib_Origin_Retn retn;
+
+
+	/* Get the root object. */
+	root = HurdLib_Origin_Init();
+
+	/* Allocate the object and internal state. */
+	retn.object_size  = sizeof(struct NAAAIM_ModelCache);
+	retn.state_size   = sizeof(struct NAAAIM_ModelCache_State);
+	if ( !root->init(root, NAAAIM_LIBID, NAAAIM_ModelCache_OBJID, &retn) )
+		return NULL;
+	this	    	  = retn.object;
+	this->state 	  = retn.state;
+	this->state->root = root;
+
+	/* Initialize object state. */
+	_init_state(this->state);
+
+	/* Method initialization. */
+	this->open = open_cache;
+
+	this->check = check;
+	this->add   = add;
+
+	this->whack = whack;
+
+	return this;
+}
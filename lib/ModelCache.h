@@ -0,0 +1,45 @@
+/** \file
+ * This file contains the API definitions for an object which
+ * implements a cache of signed security models whose signatures
+ * have been verified.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+#ifndef NAAAIM_ModelCache_HEADER
+#define NAAAIM_ModelCache_HEADER
+
+
+/* Object type definitions. */
+typedef struct NAAAIM_ModelCache * ModelCache;
+
+typedef struct NAAAIM_ModelCache_State * ModelCache_State;
+
+/**
+ * External ModelCache object representation.
+ */
+struct NAAAIM_ModelCache
+{
+	/* External methods. */
+	_Bool (*open)(const ModelCache, const char *);
+
+	_Bool (*check)(const ModelCache, const Buffer, const Buffer, \
+		       const Buffer, _Bool *);
+	_Bool (*add)(const ModelCache, const Buffer, const Buffer, \
+		     const Buffer);
+
+	void (*whack)(const ModelCache);
+
+	/* Private state. */
+	ModelCache_State state;
+};
+
+
+/* ModelCache constructor call. */
+extern HCLINK ModelCache NAAAIM_ModelCache_Init(void);
+#endif
@@ -0,0 +1,164 @@
+/** \file
+ * This file implements a test driver for the ModelCache object.
+ *
+ * A cache is created in a temporary directory and verified to return
+ * a hit only for the model digest, key and signature combination
+ * that was added to it.  The cache is also verified to refuse a
+ * directory which is writable by other users.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <HurdLib.h>
+#include <Buffer.h>
+
+#include <NAAAIM.h>
+#include "ModelCache.h"
+
+
+/**
+ * Private function.
+ *
+ * This function checks a cache for an entry and compares the result
+ * with the expected result.
+ *
+ * \param cache		The cache to be checked.
+ *
+ * \param digest	The model digest to check for.
+ *
+ * \param key		The model key to check for.
+ *
+ * \param sig		The model signature to check for.
+ *
+ * \param expected	The expected hit status.
+ *
+ * \param msg		A description of the check.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the check gave the expected result.
+ */
+
+static _Bool expect(CO(ModelCache, cache), CO(Buffer, digest), \
+		    CO(Buffer, key), CO(Buffer, sig), const _Bool expected, \
+		    CO(char *, msg))
+
+{
+	_Bool hit;
+
+
+	if ( !cache->check(cache, digest, key, sig, &hit) ) {
+		fprintf(stdout, "%s: check failed.\n", msg);
+		return false;
+	}
+	if ( hit != expected ) {
+		fprintf(stdout, "%s: expected %s.\n", msg, \
+			expected ? "hit" : "miss");
+		return false;
+	}
+
+	fprintf(stdout, "%s: %s\n", msg, hit ? "hit" : "miss");
+	return true;
+}
+
+
+extern int main(int argc, char *argv[])
+
+{
+	int retn = 1;
+
+	char dir[] = "/tmp/ModelCache_test.XXXXXX",
+	     path[sizeof(dir) + 16];
+
+	uint8_t lp;
+
+	Buffer digest = NULL,
+	       key    = NULL,
+	       sig    = NULL;
+
+	ModelCache cache = NULL;
+
+
+	INIT(HurdLib, Buffer, digest, ERR(goto done));
+	INIT(HurdLib, Buffer, key, ERR(goto done));
+	INIT(HurdLib, Buffer, sig, ERR(goto done));
+
+	for (lp= 0; lp < NAAAIM_IDSIZE; ++lp)
+		digest->add(digest, &lp, 1);
+	key->add(key, (unsigned char *) "public key", 10);
+	sig->add(sig, (unsigned char *) "signature", 9);
+
+	if ( mkdtemp(dir) == NULL )
+		ERR(goto done);
+	snprintf(path, sizeof(path), "%s/cache", dir);
+
+
+	/* Verify entries are only found for the verified combination. */
+	INIT(NAAAIM, ModelCache, cache, ERR(goto done));
+	if ( !cache->open(cache, path) ) {
+		fputs("Cannot open cache.\n", stdout);
+		goto done;
+	}
+
+	if ( !expect(cache, digest, key, sig, false, "Empty cache") )
+		goto done;
+	if ( !cache->add(cache, digest, key, sig) )
+		ERR(goto done);
+	if ( !expect(cache, digest, key, sig, true, "Added entry") )
+		goto done;
+
+	sig->add(sig, (unsigned char *) "x", 1);
+	if ( !expect(cache, digest, key, sig, false, "Other signature") )
+		goto done;
+	sig->shrink(sig, 1);
+
+	key->add(key, (unsigned char *) "x", 1);
+	if ( !expect(cache, digest, key, sig, false, "Other key") )
+		goto done;
+	key->shrink(key, 1);
+
+	digest->get(digest)[0] ^= 1;
+	if ( !expect(cache, digest, key, sig, false, "Other model") )
+		goto done;
+	digest->get(digest)[0] ^= 1;
+
+
+	/* Verify a directory writable by others is refused. */
+	WHACK(cache);
+	if ( chmod(path, 0770) == -1 )
+		ERR(goto done);
+
+	INIT(NAAAIM, ModelCache, cache, ERR(goto done));
+	if ( cache->open(cache, path) ) {
+		fputs("Group writable cache accepted.\n", stdout);
+		goto done;
+	}
+	fputs("Group writable cache refused.\n", stdout);
+
+	retn = 0;
+
+
+ done:
+	snprintf(path, sizeof(path), "rm -rf %s", dir);
+	if ( system(path) == -1 )
+		retn = 1;
+
+	WHACK(digest);
+	WHACK(key);
+	WHACK(sig);
+	WHACK(cache);
+
+	return retn;
+}
@@ -11,6 +11,13 @@
  * at the time of identity creation as the birthdate of the identity.
  *
  * The remaining 128 bits is used as the user identification key.
+ *
+ * Since each epoch offset seeds an independent hash chain a key
+ * schedule cannot be derived from the schedule of a neighbouring
+ * epoch.  An optional cache of completed schedules, indexed by the
+ * epoch offset, allows a server which is repeatedly asked for the
+ * keys of a small window of recent epochs to avoid re-running the
+ * scheduler.
  */
 
 
@@ -24,10 +31,15 @@
 /* Include files. */
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <time.h>
+#include <string.h>
 #include <netinet/in.h>
 
+#include <openssl/evp.h>
+#include <openssl/crypto.h>
+
 #include <Origin.h>
 #include <HurdLib.h>
 #include <Buffer.h>
@@ -53,6 +65,21 @@
 /* The size of the initialization vector. */
 #define IV_SIZE 16
 
+/* The size of the generated key. */
+#define KEY_SIZE 32
+
+
+/** A completed key schedule held in the schedule cache. */
+struct schedule {
+	_Bool valid;
+
+	time_t offset;
+
+	unsigned char tag[KEY_SIZE],
+		      key[KEY_SIZE],
+		      iv[IV_SIZE];
+};
+
 
 /** OTEDKS private state information. */
 struct NAAAIM_OTEDKS_State
@@ -89,6 +116,16 @@ struct NAAAIM_OTEDKS_State
 
 	/* The initialization vector. */
 	Buffer iv;
+
+	/* The digest and context used for the key iteration rounds. */
+	EVP_MD *md;
+	EVP_MD_CTX *context;
+
+	/* The number of slots in the schedule cache. */
+	unsigned int slots;
+
+	/* The schedule cache. */
+	struct schedule *cache;
 };
 
 
@@ -113,6 +150,9 @@ static void _init_state(CO(OTEDKS_State, S), time_t const epoch)
 	S->offset = 0;
 	S->rounds = 0;
 
+	S->slots = 0;
+	S->cache = NULL;
+
 	return;
 }
 
@@ -149,6 +189,19 @@ static _Bool _init_aggregates(CO(OTEDKS_State, S))
 	if ( (S->hmac = NAAAIM_SHA256_hmac_Init(S->hmac_key)) == NULL )
 		return false;
 
+	/*
+	 * The digest is fetched once so that the provider lookup is
+	 * not repeated on each iteration round.
+	 */
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	if ( (S->md = EVP_MD_fetch(NULL, "SHA256", NULL)) == NULL )
+		return false;
+#else
+	S->md = (EVP_MD *) EVP_sha256();
+#endif
+	if ( (S->context = EVP_MD_CTX_new()) == NULL )
+		return false;
+
 	return true;
 }
 
@@ -325,6 +378,11 @@ static _Bool create_vector2(CO(OTEDKS, this), CO(Buffer, userkey), \
  * N rounds of iterative hashing where N is the round value computed from
  * the first vector.
  *
+ * The rounds are run over a fixed size digest array rather than
+ * through the SHA256 and Buffer objects so that no per round
+ * object resets or copies are needed.  The key Buffer is loaded with
+ * the final digest.
+ *
  * \param this	The key object whose final key is to be generated.
  *
  * \return	A boolean value is used to indicate the success or failure
@@ -337,45 +395,88 @@ static _Bool iterate(CO(OTEDKS, this))
 {
 	STATE(S);
 
-	int round = S->rounds;
+	_Bool retn = false;
+
+	unsigned char chain[KEY_SIZE];
 
+	unsigned int size;
 
-	while ( round > 0 ) {
-		if ( !S->digest->add(S->digest, S->key) )
-			return false;
-		if ( !S->digest->compute(S->digest) )
-			return false;
+	int round = S->rounds;
 
-		S->key->reset(S->key); 
-		if ( !S->key->add_Buffer(S->key, \
-					 S->digest->get_Buffer(S->digest)) )
-			return false;
 
-		S->digest->reset(S->digest);
-		--round;
+	if ( round == 0 )
+		return true;
+
+	/* The first round is over the full key vector. */
+	if ( !EVP_DigestInit_ex(S->context, S->md, NULL) )
+		goto done;
+	if ( !EVP_DigestUpdate(S->context, S->key->get(S->key), \
+			       S->key->size(S->key)) )
+		goto done;
+	if ( !EVP_DigestFinal_ex(S->context, chain, &size) )
+		goto done;
+
+	while ( --round > 0 ) {
+		if ( !EVP_DigestInit_ex(S->context, S->md, NULL) )
+			goto done;
+		if ( !EVP_DigestUpdate(S->context, chain, sizeof(chain)) )
+			goto done;
+		if ( !EVP_DigestFinal_ex(S->context, chain, &size) )
+			goto done;
 	}
 
+	S->key->reset(S->key);
+	if ( !S->key->add(S->key, chain, sizeof(chain)) )
+		goto done;
+	retn = true;
 
-	/*
-	 * HACK
-	 * Due to poor field deployment of SHA-256 the digest and MAC
-	 * objects downgrade the digest size to SHA1 (160 bits) if the
-	 * 256 bit digest is not available.
-	 *
-	 * For the purposes of the example code we detect this by
-	 * examining the size of the digest object.  If it is 20 bytes
-	 * in length we run one more iteration of the hash and add
-	 * sufficient bytes to the key to get a full 32 byte (256 bit)
-	 * key.
-	 */
-	if ( S->key->size(S->key) == 20 ) {
-		if ( !S->digest->add(S->digest, S->key) )
-			return false;
-		if ( !S->digest->compute(S->digest) )
-			return false;
-		if ( !S->key->add(S->key, S->digest->get(S->digest), 12) )
-			return false;
-	}
+
+ done:
+	OPENSSL_cleanse(chain, sizeof(chain));
+	return retn;
+}
+
+
+/**
+ * Internal private method.
+ *
+ * This method computes the tag which binds a cached key schedule to
+ * the identity it was generated for.  The tag is a digest over the
+ * user key and the identity token so that the identity material
+ * itself is not retained in the cache.
+ *
+ * \param S		A pointer to the state of the object whose
+ *			identity tag is to be computed.
+ *
+ * \param userkey	The user key of the identity.
+ *
+ * \param token		The identity token.
+ *
+ * \param tag		A pointer to the buffer which the tag is to be
+ *			written to.
+ *
+ * \return		A boolean value is used to indicate whether or
+ *			not the tag was computed.  A true value indicates
+ *			success.
+ */
+
+static _Bool _identity_tag(CO(OTEDKS_State, S), CO(Buffer, userkey), \
+			   CO(Buffer, token), unsigned char *tag)
+
+{
+	unsigned int size;
+
+
+	if ( !EVP_DigestInit_ex(S->context, S->md, NULL) )
+		return false;
+	if ( !EVP_DigestUpdate(S->context, userkey->get(userkey), \
+			       userkey->size(userkey)) )
+		return false;
+	if ( !EVP_DigestUpdate(S->context, token->get(token), \
+			       token->size(token)) )
+		return false;
+	if ( !EVP_DigestFinal_ex(S->context, tag, &size) )
+		return false;
 
 	return true;
 }
@@ -408,6 +509,10 @@ static Buffer compute(CO(OTEDKS, this), time_t const authtime, \
 {
 	STATE(S);
 
+	unsigned char tag[KEY_SIZE];
+
+	struct schedule *sp = NULL;
+
 
 	/* Compute the epoch time offset. */
 	if ( S->epoch < authtime )
@@ -416,6 +521,25 @@ static Buffer compute(CO(OTEDKS, this), time_t const authtime, \
 		S->offset = S->epoch - authtime;
 
 
+	/* Use a cached schedule for this identity and offset. */
+	if ( S->cache != NULL ) {
+		if ( !_identity_tag(S, userkey, token, tag) )
+			return NULL;
+
+		sp = &S->cache[S->offset % S->slots];
+		if ( sp->valid && (sp->offset == S->offset) && \
+		     (memcmp(sp->tag, tag, sizeof(tag)) == 0) ) {
+			S->key->reset(S->key);
+			S->iv->reset(S->iv);
+			if ( !S->key->add(S->key, sp->key, sizeof(sp->key)) )
+				return NULL;
+			if ( !S->iv->add(S->iv, sp->iv, sizeof(sp->iv)) )
+				return NULL;
+			return S->key;
+		}
+	}
+
+
 	/* Compute the vectors for the key scheduler. */
 	if ( !create_vector1(this, userkey) )
 		return NULL;
@@ -428,10 +552,61 @@ static Buffer compute(CO(OTEDKS, this), time_t const authtime, \
 		return NULL;
 
 
+	/* Retain the schedule. */
+	if ( sp != NULL ) {
+		sp->valid  = true;
+		sp->offset = S->offset;
+		memcpy(sp->tag, tag, sizeof(sp->tag));
+		memcpy(sp->key, S->key->get(S->key), sizeof(sp->key));
+		memcpy(sp->iv, S->iv->get(S->iv), sizeof(sp->iv));
+	}
+
 	return this->state->key;
 }
 
 
+/**
+ * External public method.
+ *
+ * This method configures the cache of completed key schedules.  The
+ * cache is indexed by the epoch offset so a cache of N slots retains
+ * the schedules of the N most recent consecutive epochs.  A slot
+ * count of zero releases the cache and disables caching.
+ *
+ * \param this		A pointer to the key object whose cache is to
+ *			be configured.
+ *
+ * \param slots		The number of schedules to be cached.
+ *
+ * \return		A boolean value is used to indicate whether or
+ *			not the cache was configured.  A true value
+ *			indicates success.
+ */
+
+static _Bool set_cache(CO(OTEDKS, this), const unsigned int slots)
+
+{
+	STATE(S);
+
+
+	if ( S->cache != NULL ) {
+		OPENSSL_cleanse(S->cache, S->slots * sizeof(*S->cache));
+		free(S->cache);
+		S->cache = NULL;
+		S->slots = 0;
+	}
+
+	if ( slots == 0 )
+		return true;
+
+	if ( (S->cache = calloc(slots, sizeof(*S->cache))) == NULL )
+		return false;
+	S->slots = slots;
+
+	return true;
+}
+
+
 /**
  * This function implements an accessor function for returning the Buffer
  * containing the generated key.
@@ -532,6 +707,12 @@ static void whack(CO(OTEDKS, this))
 	if ( S->hmac != NULL )
 		S->hmac->whack(S->hmac);
 
+	EVP_MD_CTX_free(S->context);
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+	EVP_MD_free(S->md);
+#endif
+	set_cache(this, 0);
+
 	S->root->whack(S->root, this, S);
 	return;
 }
@@ -581,7 +762,8 @@ extern OTEDKS NAAAIM_OTEDKS_Init(time_t const epoch)
 	this->create_vector2 = create_vector2;
 	this->iterate = iterate;
 
-	this->compute  = compute;
+	this->compute	= compute;
+	this->set_cache = set_cache;
 
 	this->get_key = get_key;
 	this->get_iv  = get_iv;
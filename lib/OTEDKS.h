@@ -32,6 +32,7 @@ struct NAAAIM_OTEDKS
 	_Bool (*iterate)(const OTEDKS);
 
 	Buffer (*compute)(const OTEDKS, time_t, const Buffer, const Buffer);
+	_Bool (*set_cache)(const OTEDKS, const unsigned int);
 
 	Buffer (*get_key)(const OTEDKS);
 	Buffer (*get_iv)(const OTEDKS);
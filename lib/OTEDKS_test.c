@@ -1,3 +1,13 @@
+/** \file
+ * This file implements a test driver for the OTEDKS key scheduler.
+ *
+ * By default keys are scheduled for an identity token and key
+ * supplied on the command-line.  The -B option instead verifies the
+ * scheduler against the original object based implementation and
+ * measures the cost of scheduling a key over a sweep of epoch
+ * offsets, with and without the schedule cache.
+ */
+
 /**************************************************************************
  * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
  *
@@ -12,6 +22,7 @@
 #include <string.h>
 #include <time.h>
 #include <limits.h>
+#include <netinet/in.h>
 
 #include <HurdLib.h>
 #include <Buffer.h>
@@ -19,6 +30,7 @@
 
 #include <IDtoken.h>
 #include <SHA256.h>
+#include <SHA256_hmac.h>
 
 #include "OTEDKS.h"
 
@@ -27,10 +39,281 @@
 	if ( (var = CCALL(lib,obj,Init)()) == NULL ) action
 
 
+/* Number of schedule cache slots used by the benchmark. */
+#define CACHE_SLOTS 16
+
+/* Epoch offsets swept by the benchmark. */
+static const time_t Offsets[] = {
+	0, 1, 60, 3600, 86400, 604800, 2592000, 31536000
+};
+
+
+/**
+ * Private function.
+ *
+ * This function returns the number of microseconds which have elapsed
+ * since the supplied starting time.
+ *
+ * \param start	A pointer to the structure containing the starting
+ *		time.
+ *
+ * \return	The number of elapsed microseconds.
+ */
+
+static double elapsed_us(const struct timespec *start)
+
+{
+	struct timespec end;
+
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) * 1e6 + \
+		(end.tv_nsec - start->tv_nsec) / 1e3;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function implements the key schedule as the OTEDKS object
+ * originally computed it, with each round run through the SHA256
+ * and Buffer objects.
+ *
+ * \param bdate		The birthdate of the identity.
+ *
+ * \param atime		The authentication time.
+ *
+ * \param userkey	The user key of the identity.
+ *
+ * \param token		The identity token hash.
+ *
+ * \param key		The object which the key is to be loaded into.
+ *
+ * \param iv		The object which the initialization vector
+ *			is to be loaded into.
+ *
+ * \return		The number of rounds in the schedule is
+ *			returned.  A value of zero indicates an error.
+ */
+
+static int legacy_compute(time_t bdate, const time_t atime,		\
+			  CO(Buffer, userkey), CO(Buffer, token),	\
+			  CO(Buffer, key), CO(Buffer, iv))
+
+{
+	int lp,
+	    rounds = 0;
+
+	uint32_t offset,
+		 epoch = htonl(bdate);
+
+	Buffer hkey = NULL;
+
+	Sha256 digest = NULL;
+
+	SHA256_hmac hmac = NULL;
+
+
+	offset = htonl(bdate < atime ? atime - bdate : bdate - atime);
+
+	INIT(HurdLib, Buffer, hkey, goto done);
+	INIT(NAAAIM, Sha256, digest, goto done);
+	if ( (hmac = NAAAIM_SHA256_hmac_Init(hkey)) == NULL )
+		goto done;
+
+	/* Vector 1 and the round count. */
+	hkey->add_Buffer(hkey, userkey);
+	hkey->add(hkey, (unsigned char *) &offset, sizeof(offset));
+	hmac->add(hmac, (unsigned char *) &epoch, sizeof(epoch));
+	if ( !hmac->compute(hmac) )
+		goto done;
+	key->add_Buffer(key, hmac->get_Buffer(hmac));
+
+	lp = gmtime(&bdate)->tm_mday - 1;
+	rounds = *(hmac->get(hmac) + lp);
+	if ( rounds < 10 )
+		rounds += 10;
+	hmac->reset(hmac);
+	hkey->reset(hkey);
+
+	/* Vector 2 and the initialization vector. */
+	hkey->add_Buffer(hkey, token);
+	hkey->add(hkey, (unsigned char *) &offset, sizeof(offset));
+	hmac->add_Buffer(hmac, userkey);
+	if ( !hmac->compute(hmac) ) {
+		rounds = 0;
+		goto done;
+	}
+	iv->add(iv, hmac->get(hmac), 16);
+	key->add_Buffer(key, hmac->get_Buffer(hmac));
+
+	/* Iteration rounds. */
+	for (lp= rounds; lp > 0; --lp) {
+		digest->add(digest, key);
+		if ( !digest->compute(digest) ) {
+			rounds = 0;
+			goto done;
+		}
+		key->reset(key);
+		key->add_Buffer(key, digest->get_Buffer(digest));
+		digest->reset(digest);
+	}
+
+
+ done:
+	WHACK(hkey);
+	WHACK(digest);
+	WHACK(hmac);
+
+	return rounds;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function verifies the key scheduler against the original
+ * implementation and measures the cost of key scheduling for each
+ * of the benchmark epoch offsets.  The cached cost is measured by
+ * repeatedly scheduling keys for a window of consecutive epochs which
+ * fits in the schedule cache.
+ *
+ * \param count	The number of keys to be scheduled for each
+ *		measurement.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the benchmark completed.
+ */
+
+static _Bool benchmark(const unsigned long int count)
+
+{
+	_Bool retn = false;
+
+	int rounds = 0;
+
+	unsigned int lp;
+
+	unsigned long int cnt;
+
+	time_t atime,
+	       bdate = time(NULL);
+
+	double legacy,
+	       uncached,
+	       cached;
+
+	struct timespec start;
+
+	Buffer userkey = NULL,
+	       token   = NULL,
+	       key     = NULL,
+	       iv      = NULL;
+
+	OTEDKS otkey = NULL;
+
+
+	INIT(HurdLib, Buffer, userkey, goto done);
+	INIT(HurdLib, Buffer, token, goto done);
+	INIT(HurdLib, Buffer, key, goto done);
+	INIT(HurdLib, Buffer, iv, goto done);
+	if ( (otkey = NAAAIM_OTEDKS_Init(bdate)) == NULL )
+		goto done;
+
+	for (lp= 0; lp < 32; ++lp) {
+		cnt = random();
+		userkey->add(userkey, (unsigned char *) &cnt, 1);
+		cnt = random();
+		token->add(token, (unsigned char *) &cnt, 1);
+	}
+
+
+	/* Verify cached and uncached schedules. */
+	for (lp= 0; lp < 4 * CACHE_SLOTS; ++lp) {
+		atime = bdate + (lp % 3 ? lp * 977 : -lp);
+
+		key->reset(key);
+		iv->reset(iv);
+		if ( legacy_compute(bdate, atime, userkey, token, key, \
+				    iv) == 0 )
+			goto done;
+
+		if ( !otkey->set_cache(otkey, (lp % 2) ? CACHE_SLOTS : 0) )
+			goto done;
+		for (cnt= 0; cnt < 2; ++cnt) {
+			otkey->reset(otkey);
+			if ( otkey->compute(otkey, atime, userkey, token) \
+			     == NULL )
+				goto done;
+			if ( !key->equal(key, otkey->get_key(otkey)) || \
+			     !iv->equal(iv, otkey->get_iv(otkey)) ) {
+				fprintf(stdout, "Key mismatch, offset=%ld, "
+					"pass=%lu\n", (long int) (atime - bdate),
+					cnt);
+				goto done;
+			}
+		}
+	}
+	fputs("Key schedule verified.\n\n", stdout);
+
+
+	/* Sweep the epoch offsets. */
+	fprintf(stdout, "%10s %6s %12s %12s %12s\n", "Offset", "Rounds", \
+		"Legacy us", "Compute us", "Cached us");
+
+	for (lp= 0; lp < sizeof(Offsets) / sizeof(Offsets[0]); ++lp) {
+		atime = bdate + Offsets[lp];
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (cnt= 0; cnt < count; ++cnt) {
+			key->reset(key);
+			iv->reset(iv);
+			rounds = legacy_compute(bdate, atime, userkey, \
+						token, key, iv);
+		}
+		legacy = elapsed_us(&start) / count;
+
+		otkey->set_cache(otkey, 0);
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (cnt= 0; cnt < count; ++cnt) {
+			otkey->reset(otkey);
+			otkey->compute(otkey, atime, userkey, token);
+		}
+		uncached = elapsed_us(&start) / count;
+
+		otkey->set_cache(otkey, CACHE_SLOTS);
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (cnt= 0; cnt < count; ++cnt) {
+			otkey->reset(otkey);
+			otkey->compute(otkey, atime + (cnt % CACHE_SLOTS), \
+				       userkey, token);
+		}
+		cached = elapsed_us(&start) / count;
+
+		fprintf(stdout, "%10ld %6d %12.2f %12.2f %12.2f\n", \
+			(long int) Offsets[lp], rounds, legacy, uncached, \
+			cached);
+	}
+
+	retn = true;
+
+
+ done:
+	WHACK(userkey);
+	WHACK(token);
+	WHACK(key);
+	WHACK(iv);
+	WHACK(otkey);
+
+	return retn;
+}
+
+
 extern int main(int argc, char *argv[])
 
 {
-	_Bool debug = false;
+	_Bool debug = false,
+	      bench = false;
 
 	int opt;
 
@@ -57,8 +340,11 @@ extern int main(int argc, char *argv[])
 	Sha256 sha256 = NULL;
 
 
-	while ( (opt = getopt(argc, argv, "da:b:i:k:n:")) != EOF )
+	while ( (opt = getopt(argc, argv, "Bda:b:i:k:n:")) != EOF )
 		switch ( opt ) {
+			case 'B':
+				bench = true;
+				break;
 			case 'd':
 				debug = true;
 				break;
@@ -82,6 +368,16 @@ extern int main(int argc, char *argv[])
 				break;
 		}
 
+	if ( bench ) {
+		if ( id_count == INT_MAX )
+			id_count = 2000;
+		if ( id_count <= 0 ) {
+			fputs("Invalid benchmark count.\n", stderr);
+			goto done;
+		}
+		return benchmark(id_count) ? 0 : 1;
+	}
+
 	if ( (idtoken == NULL) || (idkey == NULL) ) {
 		fputs("Invalid input, need -i and -k arguements.\n", stderr);
 		goto done;
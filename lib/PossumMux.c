@@ -0,0 +1,966 @@
+/** \file
+ * This file contains the implementation of an object which multiplexes
+ * independent streams of data over a single established PossumPipe
+ * connection.  This allows a number of concurrent exchanges between
+ * two hosts to share one attested session and its socket.
+ *
+ * Each PossumPipe_stream packet carries one frame consisting of a
+ * frame type, a stream identifier and the frame data.  The party
+ * which initiated the connection allocates odd stream identifiers
+ * and the responding party allocates even identifiers so that the
+ * two parties can open streams without coordination.
+ *
+ * Flow control is implemented on a per-stream basis.  A party may
+ * have at most POSSUMMUX_WINDOW bytes of uncredited data outstanding
+ * on a stream, with the receiver issuing credit as the data is
+ * consumed by the application.  A party which is blocked waiting for
+ * credit also credits the data it has queued so that two parties
+ * which transmit to each other without reading cannot deadlock.  A
+ * stream which is blocked by its window does not delay the other
+ * streams.
+ *
+ * Data which is queued for transmission is scheduled round-robin
+ * across the streams, with at most POSSUMMUX_QUANTUM bytes of a
+ * stream being sent before the next stream with pending data is
+ * serviced.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+
+/* Local defines. */
+#define FRAME_HEADER 5
+
+
+/* Include files. */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#include <Origin.h>
+#include <HurdLib.h>
+#include <Buffer.h>
+
+#include "NAAAIM.h"
+#include "PossumPipe.h"
+#include "PossumMux.h"
+
+
+/* Verify library/object header file inclusions. */
+#if !defined(NAAAIM_LIBID)
+#error Library identifier not defined.
+#endif
+
+#if !defined(NAAAIM_PossumMux_OBJID)
+#error Object identifier not defined.
+#endif
+
+
+/* Object state extraction macro. */
+#define STATE(var) CO(PossumMux_State, var) = this->state
+
+
+/**
+ * Enumerated definitions for the frame types.
+ */
+typedef enum {
+	frame_open=1,
+	frame_data,
+	frame_window,
+	frame_close
+} frame_type;
+
+/**
+ * The following structure holds the state of a single stream.
+ */
+struct stream {
+	_Bool active;
+	_Bool accepted;
+	_Bool local_closed;
+	_Bool remote_closed;
+
+	uint32_t id;
+
+	/* Transmit credit and queued transmit data. */
+	uint32_t window;
+	size_t sent;
+	Buffer output;
+
+	/*
+	 * Received data not yet consumed by the application and the
+	 * number of received bytes which have not been credited.
+	 */
+	Buffer input;
+	uint32_t owed;
+};
+
+
+/** PossumMux private state information. */
+struct NAAAIM_PossumMux_State
+{
+	/* The root object. */
+	Origin root;
+
+	/* Library identifier. */
+	uint32_t libid;
+
+	/* Object identifier. */
+	uint32_t objid;
+
+	/* Object status. */
+	_Bool poisoned;
+
+	/* The pipe carrying the streams. */
+	PossumPipe pipe;
+
+	/* The next stream identifier to be allocated. */
+	uint32_t next_id;
+
+	/* Round-robin positions for transmission and reception. */
+	unsigned int next_send;
+	unsigned int next_read;
+
+	/* The stream table. */
+	struct stream streams[POSSUMMUX_MAX_STREAMS];
+
+	/* Frame buffer. */
+	Buffer frame;
+};
+
+
+/**
+ * Internal private method.
+ *
+ * This method is responsible for initializing the NAAAIM_PossumMux_State
+ * structure which holds state information for each instantiated object.
+ *
+ * \param S A pointer to the object containing the state information which
+ *        is to be initialized.
+ */
+
+static void _init_state(CO(PossumMux_State, S))
+
+{
+	S->libid = NAAAIM_LIBID;
+	S->objid = NAAAIM_PossumMux_OBJID;
+
+	S->poisoned = false;
+
+	S->pipe	     = NULL;
+	S->next_id   = 0;
+	S->next_send = 0;
+	S->next_read = 0;
+
+	memset(S->streams, '\0', sizeof(S->streams));
+	S->frame = NULL;
+
+	return;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function locates an active stream in the stream table.
+ *
+ * \param S	A pointer to the state of the multiplexer.
+ *
+ * \param id	The identifier of the stream to be located.
+ *
+ * \return	A pointer to the stream is returned or NULL if the
+ *		stream is not active.
+ */
+
+static struct stream * _find(CO(PossumMux_State, S), const uint32_t id)
+
+{
+	unsigned int lp;
+
+
+	for (lp= 0; lp < POSSUMMUX_MAX_STREAMS; ++lp) {
+		if ( S->streams[lp].active && (S->streams[lp].id == id) )
+			return &S->streams[lp];
+	}
+
+	return NULL;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function allocates a slot in the stream table for a stream.
+ *
+ * \param S	A pointer to the state of the multiplexer.
+ *
+ * \param id	The identifier of the stream to be allocated.
+ *
+ * \return	A pointer to the stream is returned or NULL if the
+ *		table is full.
+ */
+
+static struct stream * _allocate(CO(PossumMux_State, S), const uint32_t id)
+
+{
+	unsigned int lp;
+
+	struct stream *st = NULL;
+
+
+	for (lp= 0; lp < POSSUMMUX_MAX_STREAMS; ++lp) {
+		if ( !S->streams[lp].active ) {
+			st = &S->streams[lp];
+			break;
+		}
+	}
+	if ( st == NULL )
+		return NULL;
+
+	memset(st, '\0', sizeof(*st));
+	INIT(HurdLib, Buffer, st->output, goto fail);
+	INIT(HurdLib, Buffer, st->input, goto fail);
+
+	st->id	   = id;
+	st->window = POSSUMMUX_WINDOW;
+	st->active = true;
+
+	return st;
+
+
+ fail:
+	WHACK(st->output);
+	return NULL;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function releases a stream once it has been closed by both
+ * parties and all of its data has been delivered.
+ *
+ * \param st	A pointer to the stream to be checked.
+ */
+
+static void _reap(struct stream *st)
+
+{
+	if ( !st->local_closed || !st->remote_closed )
+		return;
+	if ( (st->input->size(st->input) > 0) || \
+	     (st->sent < st->output->size(st->output)) )
+		return;
+
+	WHACK(st->output);
+	WHACK(st->input);
+	st->active = false;
+
+	return;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function transmits a frame over the pipe.
+ *
+ * \param S	A pointer to the state of the multiplexer.
+ *
+ * \param type	The type of frame to be sent.
+ *
+ * \param id	The stream identifier of the frame.
+ *
+ * \param data	A pointer to the frame data.
+ *
+ * \param size	The number of bytes of frame data.
+ *
+ * \return	A boolean value is used to indicate whether or not the
+ *		frame was sent.
+ */
+
+static _Bool _send_frame(CO(PossumMux_State, S), const frame_type type, \
+			 const uint32_t id, CO(unsigned char *, data),	\
+			 const size_t size)
+
+{
+	unsigned char hdr[FRAME_HEADER];
+
+	uint32_t nid = htonl(id);
+
+
+	hdr[0] = type;
+	memcpy(hdr + 1, &nid, sizeof(nid));
+
+	S->frame->reset(S->frame);
+	S->frame->add(S->frame, hdr, sizeof(hdr));
+	if ( size > 0 )
+		S->frame->add(S->frame, data, size);
+	if ( S->frame->poisoned(S->frame) )
+		return false;
+
+	return S->pipe->send_packet(S->pipe, PossumPipe_stream, S->frame);
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function issues credit to the counter-party for the data
+ * which has been received on a stream but not yet credited.
+ *
+ * \param S	A pointer to the state of the multiplexer.
+ *
+ * \param st	A pointer to the stream to be credited.
+ *
+ * \return	A boolean value is used to indicate whether or not the
+ *		credit was sent.  A false value poisons the
+ *		multiplexer.
+ */
+
+static _Bool _credit(CO(PossumMux_State, S), struct stream *st)
+
+{
+	uint32_t credit;
+
+
+	if ( (st->owed == 0) || st->remote_closed ) {
+		st->owed = 0;
+		return true;
+	}
+
+	credit = htonl(st->owed);
+	if ( !_send_frame(S, frame_window, st->id, (unsigned char *) &credit, \
+			  sizeof(credit)) ) {
+		S->poisoned = true;
+		return false;
+	}
+	st->owed = 0;
+
+	return true;
+}
+
+
+/**
+ * Internal private function.
+ *
+ * This function receives and dispatches a single frame from the
+ * pipe.  The caller blocks until a frame is available.
+ *
+ * \param S	A pointer to the state of the multiplexer.
+ *
+ * \return	A boolean value is used to indicate whether or not a
+ *		valid frame was processed.  A false value poisons the
+ *		multiplexer.
+ */
+
+static _Bool _process_frame(CO(PossumMux_State, S))
+
+{
+	_Bool retn = false;
+
+	unsigned char *p;
+
+	uint32_t id,
+		 credit;
+
+	size_t size;
+
+	struct stream *st;
+
+
+	S->frame->reset(S->frame);
+	if ( S->pipe->receive_packet(S->pipe, S->frame) != PossumPipe_stream )
+		ERR(goto done);
+	if ( (size = S->frame->size(S->frame)) < FRAME_HEADER )
+		ERR(goto done);
+
+	p = S->frame->get(S->frame);
+	memcpy(&id, p + 1, sizeof(id));
+	id = ntohl(id);
+	size -= FRAME_HEADER;
+
+	st = _find(S, id);
+	switch ( p[0] ) {
+		case frame_open:
+			if ( (st != NULL) || ((id & 1) == (S->next_id & 1)) )
+				ERR(goto done);
+			if ( _allocate(S, id) == NULL )
+				ERR(goto done);
+			break;
+
+		case frame_data:
+			if ( (st == NULL) || st->remote_closed )
+				ERR(goto done);
+			if ( (st->owed + size) > POSSUMMUX_WINDOW )
+				ERR(goto done);
+			if ( !st->input->add(st->input, p + FRAME_HEADER, \
+					     size) )
+				ERR(goto done);
+			st->owed += size;
+			break;
+
+		case frame_window:
+			if ( size != sizeof(credit) )
+				ERR(goto done);
+			if ( st == NULL )
+				break;
+			memcpy(&credit, p + FRAME_HEADER, sizeof(credit));
+			credit = ntohl(credit);
+			if ( (st->window + credit) > POSSUMMUX_WINDOW )
+				ERR(goto done);
+			st->window += credit;
+			break;
+
+		case frame_close:
+			if ( st == NULL )
+				ERR(goto done);
+			st->remote_closed = true;
+			_reap(st);
+			break;
+
+		default:
+			ERR(goto done);
+	}
+
+	retn = true;
+
+
+ done:
+	if ( !retn )
+		S->poisoned = true;
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements binding the multiplexer to a pipe which has
+ * completed its host or client mode startup.
+ *
+ * \param this		A pointer to the multiplexer to be initialized.
+ *
+ * \param pipe		The pipe which is to carry the streams.  The
+ *			pipe remains owned by the caller.
+ *
+ * \param initiator	A flag indicating whether this party initiated
+ *			the connection.  The two parties to a pipe must
+ *			use opposite values.
+ *
+ * \return		A boolean value is used to indicate whether
+ *			or not the multiplexer was initialized.
+ */
+
+static _Bool init(CO(PossumMux, this), CO(PossumPipe, pipe), \
+		  const _Bool initiator)
+
+{
+	STATE(S);
+
+
+	if ( S->poisoned || (pipe == NULL) )
+		return false;
+
+	S->pipe	   = pipe;
+	S->next_id = initiator ? 1 : 2;
+
+	return true;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements opening a new stream to the counter-party.
+ *
+ * \param this	A pointer to the multiplexer which is to open the
+ *		stream.
+ *
+ * \param id	A pointer to the variable which will be loaded with
+ *		the identifier of the new stream.
+ *
+ * \return	A boolean value is used to indicate whether or not the
+ *		stream was opened.
+ */
+
+static _Bool open_stream(CO(PossumMux, this), uint32_t *id)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	struct stream *st;
+
+
+	if ( S->poisoned || (S->pipe == NULL) )
+		ERR(goto done);
+
+	if ( (st = _allocate(S, S->next_id)) == NULL )
+		goto done;
+	st->accepted = true;
+
+	if ( !_send_frame(S, frame_open, st->id, NULL, 0) ) {
+		S->poisoned = true;
+		ERR(goto done);
+	}
+
+	*id = st->id;
+	S->next_id += 2;
+	retn = true;
+
+
+ done:
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements waiting for the counter-party to open a
+ * stream.  Frames for other streams which arrive while waiting are
+ * queued on their respective streams.
+ *
+ * \param this	A pointer to the multiplexer which is to accept the
+ *		stream.
+ *
+ * \param id	A pointer to the variable which will be loaded with
+ *		the identifier of the accepted stream.
+ *
+ * \return	A boolean value is used to indicate whether or not a
+ *		stream was accepted.
+ */
+
+static _Bool accept_stream(CO(PossumMux, this), uint32_t *id)
+
+{
+	STATE(S);
+
+	unsigned int lp;
+
+
+	if ( S->poisoned || (S->pipe == NULL) )
+		return false;
+
+	while ( true ) {
+		for (lp= 0; lp < POSSUMMUX_MAX_STREAMS; ++lp) {
+			if ( S->streams[lp].active && \
+			     !S->streams[lp].accepted ) {
+				S->streams[lp].accepted = true;
+				*id = S->streams[lp].id;
+				return true;
+			}
+		}
+		if ( !_process_frame(S) )
+			return false;
+	}
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements closing the local side of a stream.  Any
+ * data queued on the multiplexer is transmitted before the stream
+ * is closed.
+ *
+ * \param this	A pointer to the multiplexer holding the stream.
+ *
+ * \param id	The identifier of the stream to be closed.
+ *
+ * \return	A boolean value is used to indicate whether or not the
+ *		stream was closed.
+ */
+
+static _Bool close_stream(CO(PossumMux, this), const uint32_t id)
+
+{
+	STATE(S);
+
+	struct stream *st;
+
+
+	if ( S->poisoned )
+		return false;
+	if ( ((st = _find(S, id)) == NULL) || st->local_closed )
+		return false;
+
+	if ( !this->flush(this) )
+		return false;
+	if ( !_send_frame(S, frame_close, id, NULL, 0) ) {
+		S->poisoned = true;
+		return false;
+	}
+
+	st->local_closed = true;
+	_reap(st);
+
+	return true;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements queueing data for transmission on a stream.
+ * The data is transmitted by the flush method.
+ *
+ * \param this	A pointer to the multiplexer holding the stream.
+ *
+ * \param id	The identifier of the stream the data is to be sent on.
+ *
+ * \param bufr	The object containing the data to be sent.
+ *
+ * \return	A boolean value is used to indicate whether or not the
+ *		data was queued.
+ */
+
+static _Bool send_data(CO(PossumMux, this), const uint32_t id, \
+		       CO(Buffer, bufr))
+
+{
+	STATE(S);
+
+	struct stream *st;
+
+
+	if ( S->poisoned )
+		return false;
+	if ( (bufr == NULL) || bufr->poisoned(bufr) )
+		return false;
+	if ( ((st = _find(S, id)) == NULL) || st->local_closed )
+		return false;
+
+	return st->output->add_Buffer(st->output, bufr);
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements transmission of the data queued on all
+ * streams.  Streams are serviced round-robin with each stream
+ * sending up to POSSUMMUX_QUANTUM bytes per round.  If all of the
+ * streams with pending data have exhausted their window the method
+ * blocks processing incoming frames until credit is issued.  While
+ * blocked the data received on each stream is queued for the
+ * application and credited so that a counter-party which is also
+ * flushing continues to make progress.
+ *
+ * \param this	A pointer to the multiplexer to be flushed.
+ *
+ * \return	A boolean value is used to indicate whether or not all
+ *		of the queued data was transmitted.
+ */
+
+static _Bool flush(CO(PossumMux, this))
+
+{
+	STATE(S);
+
+	_Bool pending,
+	      progress;
+
+	unsigned int lp;
+
+	size_t size;
+
+	struct stream *st;
+
+
+	if ( S->poisoned || (S->pipe == NULL) )
+		return false;
+
+	do {
+		pending	 = false;
+		progress = false;
+
+		for (lp= 0; lp < POSSUMMUX_MAX_STREAMS; ++lp) {
+			st = &S->streams[(S->next_send + lp) % \
+					 POSSUMMUX_MAX_STREAMS];
+			if ( !st->active )
+				continue;
+			size = st->output->size(st->output) - st->sent;
+			if ( size == 0 )
+				continue;
+
+			pending = true;
+			if ( st->window == 0 )
+				continue;
+
+			if ( size > POSSUMMUX_QUANTUM )
+				size = POSSUMMUX_QUANTUM;
+			if ( size > st->window )
+				size = st->window;
+
+			if ( !_send_frame(S, frame_data, st->id,	 \
+					  st->output->get(st->output) + \
+					  st->sent, size) ) {
+				S->poisoned = true;
+				return false;
+			}
+			st->sent   += size;
+			st->window -= size;
+			progress    = true;
+
+			if ( st->sent == st->output->size(st->output) ) {
+				st->output->reset(st->output);
+				st->sent = 0;
+				_reap(st);
+			}
+		}
+		S->next_send = (S->next_send + 1) % POSSUMMUX_MAX_STREAMS;
+
+		if ( pending && !progress ) {
+			for (lp= 0; lp < POSSUMMUX_MAX_STREAMS; ++lp) {
+				st = &S->streams[lp];
+				if ( st->active && !_credit(S, st) )
+					return false;
+			}
+			if ( !_process_frame(S) )
+				return false;
+		}
+	} while ( pending );
+
+	return true;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements receiving data from a stream.  The caller
+ * blocks until data is available on the stream.  All of the data
+ * which is queued on the stream is returned and credit is issued to
+ * the counter-party for the data which has not already been
+ * credited.
+ *
+ * \param this	A pointer to the multiplexer holding the stream.
+ *
+ * \param id	The identifier of the stream to be read.
+ *
+ * \param bufr	The object which the data is to be added to.
+ *
+ * \return	A boolean value is used to indicate whether or not data
+ *		was received.  A false value is returned without the
+ *		multiplexer being poisoned when the counter-party has
+ *		closed the stream.
+ */
+
+static _Bool receive_data(CO(PossumMux, this), const uint32_t id, \
+			  CO(Buffer, bufr))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	struct stream *st;
+
+
+	if ( S->poisoned || (S->pipe == NULL) )
+		ERR(goto done);
+	if ( (bufr == NULL) || bufr->poisoned(bufr) )
+		ERR(goto done);
+	if ( (st = _find(S, id)) == NULL )
+		ERR(goto done);
+
+	while ( (st->input->size(st->input) == 0) && !st->remote_closed ) {
+		if ( !_process_frame(S) )
+			ERR(goto done);
+		if ( !st->active )
+			goto done;
+	}
+	if ( st->input->size(st->input) == 0 ) {
+		_reap(st);
+		goto done;
+	}
+
+	if ( !bufr->add_Buffer(bufr, st->input) )
+		ERR(goto done);
+	st->input->reset(st->input);
+
+	if ( !_credit(S, st) )
+		ERR(goto done);
+	_reap(st);
+
+	retn = true;
+
+
+ done:
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements waiting for any stream to become readable.
+ * A stream is readable if it has data queued or has been closed by
+ * the counter-party.  Streams are reported round-robin so that a
+ * busy stream does not starve the others.  A stream which was
+ * opened by the counter-party is accepted when it is reported.
+ *
+ * \param this	A pointer to the multiplexer to be waited on.
+ *
+ * \param id	A pointer to the variable which will be loaded with
+ *		the identifier of the readable stream.
+ *
+ * \return	A boolean value is used to indicate whether or not a
+ *		readable stream was found.
+ */
+
+static _Bool next_ready(CO(PossumMux, this), uint32_t *id)
+
+{
+	STATE(S);
+
+	unsigned int lp,
+		     slot;
+
+	struct stream *st;
+
+
+	if ( S->poisoned || (S->pipe == NULL) )
+		return false;
+
+	while ( true ) {
+		for (lp= 0; lp < POSSUMMUX_MAX_STREAMS; ++lp) {
+			slot = (S->next_read + lp) % POSSUMMUX_MAX_STREAMS;
+			st   = &S->streams[slot];
+			if ( !st->active || st->local_closed )
+				continue;
+			if ( (st->input->size(st->input) > 0) || \
+			     st->remote_closed ) {
+				st->accepted = true;
+				S->next_read = (slot + 1) % \
+					POSSUMMUX_MAX_STREAMS;
+				*id = st->id;
+				return true;
+			}
+		}
+		if ( !_process_frame(S) )
+			return false;
+	}
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements an accessor for determining whether or not
+ * the multiplexer has been poisoned by a transmission or protocol
+ * error.
+ *
+ * \param this	The multiplexer whose status is to be returned.
+ *
+ * \return	A true value indicates the multiplexer is poisoned and
+ *		no longer usable.
+ */
+
+static _Bool poisoned(CO(PossumMux, this))
+
+{
+	STATE(S);
+
+
+	return S->poisoned;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements a destructor for a PossumMux object.  The
+ * pipe the multiplexer was bound to is not released.
+ *
+ * \param this	A pointer to the object which is to be destroyed.
+ */
+
+static void whack(CO(PossumMux, this))
+
+{
+	STATE(S);
+
+	unsigned int lp;
+
+
+	for (lp= 0; lp < POSSUMMUX_MAX_STREAMS; ++lp) {
+		WHACK(S->streams[lp].output);
+		WHACK(S->streams[lp].input);
+	}
+	WHACK(S->frame);
+
+	S->root->whack(S->root, this, S);
+	return;
+}
+
+
+/**
+ * External constructor call.
+ *
+ * This function implements a constructor call for a PossumMux object.
+ *
+ * \return	A pointer to the initialized PossumMux.  A null value
+ *		indicates an error was encountered in object generation.
+ */
+
+extern PossumMux NAAAIM_PossumMux_Init(void)
+
+{
+	Origin root;
+
+	PossumMux this = NULL;
+
+	struct HurdLib_Origin_Retn retn;
+
+
+	/* Get the root object. */
+	root = HurdLib_Origin_Init();
+
+	/* Allocate the object and internal state. */
+	retn.object_size  = sizeof(struct NAAAIM_PossumMux);
+	retn.state_size   = sizeof(struct NAAAIM_PossumMux_State);
+	if ( !root->init(root, NAAAIM_LIBID, NAAAIM_PossumMux_OBJID, &retn) )
+		return NULL;
+	this	    	  = retn.object;
+	this->state 	  = retn.state;
+	this->state->root = root;
+
+	/* Initialize object state. */
+	_init_state(this->state);
+
+	INIT(HurdLib, Buffer, this->state->frame, goto fail);
+
+	/* Method initialization. */
+	this->init = init;
+
+	this->open_stream   = open_stream;
+	this->accept_stream = accept_stream;
+	this->close_stream  = close_stream;
+
+	this->send_data = send_data;
+	this->flush	= flush;
+
+	this->receive_data = receive_data;
+	this->next_ready   = next_ready;
+
+	this->poisoned = poisoned;
+	this->whack    = whack;
+
+	return this;
+
+
+ fail:
+	root->whack(root, this, this->state);
+	return NULL;
+}
@@ -0,0 +1,62 @@
+/** \file
+ * This file contains the API definitions for an object which
+ * multiplexes independent streams of data over a single established
+ * PossumPipe connection.
+ */
+
+/**************************************************************************
+ * Copyright (c) Enjellic Systems Development, LLC. All rights reserved.
+ *
+ * Please refer to the file named Documentation/COPYRIGHT in the top of
+ * the source tree for copyright and licensing information.
+ **************************************************************************/
+
+
+#ifndef NAAAIM_PossumMux_HEADER
+#define NAAAIM_PossumMux_HEADER
+
+
+/* Maximum number of concurrently open streams. */
+#define POSSUMMUX_MAX_STREAMS 64
+
+/* Number of bytes a peer may send on a stream before it is credited. */
+#define POSSUMMUX_WINDOW 65536
+
+/* Maximum amount of data sent for a stream in one scheduling round. */
+#define POSSUMMUX_QUANTUM 16384
+
+
+/* Object type definitions. */
+typedef struct NAAAIM_PossumMux * PossumMux;
+
+typedef struct NAAAIM_PossumMux_State * PossumMux_State;
+
+/**
+ * External PossumMux object representation.
+ */
+struct NAAAIM_PossumMux
+{
+	/* External methods. */
+	_Bool (*init)(const PossumMux, const PossumPipe, const _Bool);
+
+	_Bool (*open_stream)(const PossumMux, uint32_t *);
+	_Bool (*accept_stream)(const PossumMux, uint32_t *);
+	_Bool (*close_stream)(const PossumMux, const uint32_t);
+
+	_Bool (*send_data)(const PossumMux, const uint32_t, const Buffer);
+	_Bool (*flush)(const PossumMux);
+
+	_Bool (*receive_data)(const PossumMux, const uint32_t, const Buffer);
+	_Bool (*next_ready)(const PossumMux, uint32_t *);
+
+	_Bool (*poisoned)(const PossumMux);
+	void (*whack)(const PossumMux);
+
+	/* Private state. */
+	PossumMux_State state;
+};
+
+
+/* PossumMux constructor call. */
+extern HCLINK PossumMux NAAAIM_PossumMux_Init(void);
+#endif
@@ -17,12 +17,33 @@
 #define ENCRYPTION_BLOCKSIZE 16
 #define CHECKSUM_SIZE 32
 
+/*
+ * Session resumption definitions.  The resumption request is
+ * identified by a leading magic value.  The ticket plaintext consists
+ * of the issue time, packet protection mode, resumption secret,
+ * counter-party software status, counter-party identity and the
+ * digest of the platform quote of the counter-party.  The
+ * resumption request carries the ticket, the client nonce and an
+ * assertion of the client identity.
+ */
+#define RESUME_MAGIC "PPresume"
+#define RESUME_MAGIC_SIZE 8
+#define TICKET_PLAINTEXT_SIZE (8 + 1 + NAAAIM_IDSIZE + NAAAIM_IDSIZE + \
+			       NAAAIM_IDSIZE + NAAAIM_IDSIZE)
+#define TICKET_BLOB_SIZE (AES256_GCM_IV_SIZE + TICKET_PLAINTEXT_SIZE + \
+			  AES256_GCM_TAG_SIZE)
+#define RESUME_REQUEST_SIZE (RESUME_MAGIC_SIZE + TICKET_BLOB_SIZE + \
+			     NAAAIM_IDSIZE + 2*NAAAIM_IDSIZE + NAAAIM_IDSIZE)
+#define RESUME_REPLY_SIZE (1 + NAAAIM_IDSIZE + NAAAIM_IDSIZE)
+#define TICKET_REQUEST 0x80
+
 
 /* Include files. */
 #include <stdint.h>
 #include <stdbool.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 #include <glob.h>
 
@@ -41,6 +62,7 @@
 #include "SHA256_hmac.h"
 #include "RandomBuffer.h"
 #include "AES256_cbc.h"
+#include "AES256_gcm.h"
 #include "IDtoken.h"
 #include "Duct.h"
 #include "SoftwareStatus.h"
@@ -48,6 +70,7 @@
 #include "PossumPacket.h"
 #include "IDmgr.h"
 #include "Ivy.h"
+#include "IvyIndex.h"
 #include "TPMcmd.h"
 #include "PossumPipe.h"
 
@@ -96,6 +119,45 @@ struct NAAAIM_PossumPipe_State
 
 	/* Remote software status. */
 	Buffer software;
+
+	/* Identity of the counter-party verified at session setup. */
+	Buffer identity;
+
+	/* Digest of the verified platform quote of the counter-party. */
+	Buffer quote;
+
+	/* Packet protection mode proposed and in use for the session. */
+	PossumPipe_cipher proposal;
+	PossumPipe_cipher cipher;
+
+	/*
+	 * Session cipher contexts, packet sequence numbers and the
+	 * local software status used by the authenticated encryption
+	 * mode.
+	 */
+	AES256_gcm encrypter;
+	AES256_gcm decrypter;
+
+	uint64_t send_sequence;
+	uint64_t receive_sequence;
+
+	Buffer local_software;
+
+	/*
+	 * Session resumption state.  A host which issues tickets holds
+	 * the key used to seal them, the key it replaced and their
+	 * lifetime.  A client holds the ticket it was issued for the
+	 * current session.
+	 */
+	time_t ticket_lifetime;
+	Buffer ticket_key;
+	Buffer previous_key;
+
+	_Bool ticket_requested;
+	Buffer ticket;
+
+	/* The index of counter-party identity verifiers. */
+	IvyIndex index;
 };
 
 
@@ -142,6 +204,27 @@ static void _init_state(CO(PossumPipe_State,S))
 	S->received = NULL;
 
 	S->software = NULL;
+	S->identity = NULL;
+	S->quote    = NULL;
+
+	S->proposal = PossumPipe_cbc_hmac;
+	S->cipher   = PossumPipe_cbc_hmac;
+
+	S->encrypter = NULL;
+	S->decrypter = NULL;
+
+	S->send_sequence    = 0;
+	S->receive_sequence = 0;
+
+	S->local_software = NULL;
+
+	S->ticket_lifetime  = 0;
+	S->ticket_key	    = NULL;
+	S->previous_key	    = NULL;
+	S->ticket_requested = false;
+	S->ticket	    = NULL;
+
+	S->index = NULL;
 
 	return;
 }
@@ -323,6 +406,46 @@ static _Bool accept_connection(CO(PossumPipe, this))
 }
 
 
+/**
+ * External public method.
+ *
+ * This method implements attaching a connection which was accepted
+ * by an external listener, such as the DuctServer object, to the
+ * pipe.  The pipe is placed in server mode and is ready for the
+ * host side of the connection to be started.
+ *
+ * \param this	The object which is to take ownership of the
+ *		connection.
+ *
+ * \param fd	The file descriptor of the connected socket.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the connection was attached.  A true value indicates
+ *		the pipe is ready for host mode startup.
+ */
+
+static _Bool set_connection(CO(PossumPipe, this), const int fd)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+
+	if ( !S->duct->init_server(S->duct) )
+		ERR(goto done);
+	S->duct->do_reverse(S->duct, false);
+	if ( !S->duct->set_connection(S->duct, fd) )
+		ERR(goto done);
+
+	retn = true;
+
+
+ done:
+	return retn;
+}
+
+
 /**
  * Internal private method.
  *
@@ -547,6 +670,35 @@ done:
 }
 
 
+/**
+ * Internal private function.
+ *
+ * This function generates the initialization vector used to protect
+ * a packet in the authenticated encryption mode.  The vector is the
+ * packet sequence number of the direction the packet is travelling
+ * in.  Since each direction has its own key the vector is never
+ * re-used under the same key for the lifetime of a session.
+ *
+ * \param sequence	The sequence number of the packet.
+ *
+ * \param iv		A pointer to the AES256_GCM_IV_SIZE byte area
+ *			which will be loaded with the vector.
+ */
+
+static void _sequence_iv(const uint64_t sequence, unsigned char *iv)
+
+{
+	unsigned int lp;
+
+
+	memset(iv, '\0', AES256_GCM_IV_SIZE);
+	for (lp= 0; lp < sizeof(sequence); ++lp)
+		iv[AES256_GCM_IV_SIZE - 1 - lp] = (sequence >> (8 * lp)) & 0xff;
+
+	return;
+}
+
+
 /**
  * External public method.
  *
@@ -556,6 +708,11 @@ done:
  * is added.  The resulting data structure is transmitted to the
  * endpoint.
  *
+ * If the session has negotiated authenticated encryption the
+ * encoded packet is instead encrypted in place with the session
+ * cipher context.  The local software status is authenticated with
+ * the packet in place of the HMAC checksum.
+ *
  * \param this		A pointer to the object which is to initiate
  *			the send.
  *
@@ -585,6 +742,8 @@ static _Bool send_packet(CO(PossumPipe, this), const PossumPipe_type type, \
 
 	int asn_size;
 
+	unsigned char iv[AES256_GCM_IV_SIZE];
+
 	possum_packet *packet = NULL;
 
 	Buffer b,
@@ -625,6 +784,15 @@ static _Bool send_packet(CO(PossumPipe, this), const PossumPipe_type type, \
 	if ( !bufr->add(bufr, asn, asn_size) )
 		ERR(goto done);
 
+	/* Encrypt and authenticate with the session context. */
+	if ( S->cipher == PossumPipe_aes256_gcm ) {
+		_sequence_iv(S->send_sequence++, iv);
+		if ( !S->encrypter->encrypt(S->encrypter, iv, \
+					    S->local_software, bufr) )
+			ERR(goto done);
+		goto send;
+	}
+
 	/* Encrypt the buffer contents and add an authentication checksum. */
 	INIT(NAAAIM, SoftwareStatus, software, goto done);
 	if ( !software->open(software) )
@@ -645,6 +813,7 @@ static _Bool send_packet(CO(PossumPipe, this), const PossumPipe_type type, \
 		ERR(goto done);
 
 	/* Send the processed buffer. */
+ send:
 	if ( !S->duct->send_Buffer(S->duct, bufr) )
 		ERR(goto done);
 
@@ -659,6 +828,7 @@ static _Bool send_packet(CO(PossumPipe, this), const PossumPipe_type type, \
 		S->poisoned = true;
 	if ( packet != NULL )
 		possum_packet_free(packet);
+	OPENSSL_free(asn);
 
 	return retn;
 }
@@ -748,8 +918,9 @@ done:
  *
  * This method implements the reception and decoding of a packet from
  * a remote endpoint.  The raw packet is decrypted and authenticated
- * with the trailing checksum.  The ASN1 data structure is decoded and
- * loaded into the supplied buffer.
+ * with the trailing checksum, or with the session cipher context if
+ * authenticated encryption was negotiated.  The ASN1 data structure
+ * is decoded and loaded into the supplied buffer.
  *
  * \param this	A pointer to the object which is to initiate
  *		the send.
@@ -776,6 +947,8 @@ static PossumPipe_type receive_packet(CO(PossumPipe, this), CO(Buffer, bufr))
 
 	int asn_size;
 
+	unsigned char iv[AES256_GCM_IV_SIZE];
+
 	possum_packet *packet = NULL;
 
 
@@ -789,12 +962,20 @@ static PossumPipe_type receive_packet(CO(PossumPipe, this), CO(Buffer, bufr))
 		ERR(goto done);
 
 	/* Decrypt the payload. */
-	if ( !_verify_checksum(S, bufr) )
-		ERR(goto done);
-	if ( !_decrypt_packet(S, bufr) )
-		ERR(goto done);
-	if ( !S->shared1->rehash(S->shared1, 1) )
-		ERR(goto done);
+	if ( S->cipher == PossumPipe_aes256_gcm ) {
+		_sequence_iv(S->receive_sequence++, iv);
+		if ( !S->decrypter->decrypt(S->decrypter, iv, S->software, \
+					    bufr) )
+			ERR(goto done);
+	}
+	else {
+		if ( !_verify_checksum(S, bufr) )
+			ERR(goto done);
+		if ( !_decrypt_packet(S, bufr) )
+			ERR(goto done);
+		if ( !S->shared1->rehash(S->shared1, 1) )
+			ERR(goto done);
+	}
 
 	/* Decode the packet. */
 	p = bufr->get(bufr);
@@ -831,7 +1012,12 @@ static PossumPipe_type receive_packet(CO(PossumPipe, this), CO(Buffer, bufr))
  * Private function.
  *
  * This function is responsible for searching the list of attestable
- * clients based on the identification challenge.
+ * clients based on the identification challenge.  The verifier index
+ * is searched first, if one is available, with the verifier files
+ * being scanned if the index does not contain the client.
+ *
+ * \param S		A pointer to the state of the pipe which is
+ *			searching for the client.
  *
  * \param packet	The Buffer object containing the type 1 POSSUM
  *			packet which was received.
@@ -849,7 +1035,8 @@ static PossumPipe_type receive_packet(CO(PossumPipe, this), CO(Buffer, bufr))
  *			is returned if the search was unsuccessful.
  */
 
-static _Bool find_client(CO(Buffer, packet), CO(IDtoken, token), CO(Ivy, ivy))
+static _Bool find_client(CO(PossumPipe_State, S), CO(Buffer, packet), \
+			CO(IDtoken, token), CO(Ivy, ivy))
 
 {
 	_Bool retn	 = false,
@@ -897,6 +1084,22 @@ static _Bool find_client(CO(Buffer, packet), CO(IDtoken, token), CO(Ivy, ivy))
 		ERR(goto done);
 	changed_id = true;
 
+	/*
+	 * The index only returns verifiers whose file is unchanged,
+	 * a removed or replaced verifier is resolved by the scan of
+	 * the verifier files which follows.
+	 */
+	if ( S->index == NULL ) {
+		INIT(NAAAIM, IvyIndex, S->index, goto done);
+		if ( !S->index->load(S->index, IVYINDEX_DEFAULT) )
+			WHACK(S->index);
+	}
+	if ( (S->index != NULL) && S->index->find(S->index, packet, token, \
+						  ivy) ) {
+		retn = true;
+		goto done;
+	}
+
 	if ( glob("/etc/conf/*.ivy", 0, NULL, &identities) != 0 )
 		ERR(goto done);
 
@@ -955,6 +1158,119 @@ static _Bool find_client(CO(Buffer, packet), CO(IDtoken, token), CO(Ivy, ivy))
 }
 
 
+/**
+ * Private function.
+ *
+ * This function computes the value which a resumption ticket uses to
+ * bind a session to the identity of the client it was issued to.  The
+ * identity is computed from the identity token of the client as
+ * follows:
+ *
+ *	Identity = SHA256(Organization key || Organization identity)
+ *
+ * \param token		The identity token of the client.
+ *
+ * \param identity	The object which will be loaded with the
+ *			identity.
+ *
+ * \return		A true value is used to indicate the identity
+ *			was computed.  A false value indicates an error.
+ */
+
+static _Bool _client_identity(CO(IDtoken, token), CO(Buffer, identity))
+
+{
+	_Bool retn = false;
+
+	Buffer b;
+
+	Sha256 sha256 = NULL;
+
+
+	INIT(NAAAIM, Sha256, sha256, goto done);
+
+	if ( (b = token->get_element(token, IDtoken_orgkey)) == NULL )
+		ERR(goto done);
+	sha256->add(sha256, b);
+	if ( (b = token->get_element(token, IDtoken_orgid)) == NULL )
+		ERR(goto done);
+	sha256->add(sha256, b);
+	if ( !sha256->compute(sha256) )
+		ERR(goto done);
+
+	identity->reset(identity);
+	if ( !identity->add_Buffer(identity, sha256->get_Buffer(sha256)) )
+		ERR(goto done);
+	retn = true;
+
+
+ done:
+	WHACK(sha256);
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function composes the identity assertion which a client
+ * presents when it resumes a session.  The assertion has the same
+ * form as the assertion in the session initiation packet so that
+ * the host can verify it against its identity verifiers:
+ *
+ *	Key || HMAC_Key(Organization key || Organization identity)
+ *
+ * \param token		The identity token of the client.
+ *
+ * \param bufr		The object which the assertion will be added
+ *			to.
+ *
+ * \return		A true value is used to indicate the assertion
+ *			was added.  A false value indicates an error.
+ */
+
+static _Bool _assert_identity(CO(IDtoken, token), CO(Buffer, bufr))
+
+{
+	_Bool retn = false;
+
+	Buffer b;
+
+	RandomBuffer key = NULL;
+
+	SHA256_hmac hmac = NULL;
+
+
+	INIT(NAAAIM, RandomBuffer, key, goto done);
+	if ( !key->generate(key, NAAAIM_IDSIZE) )
+		ERR(goto done);
+	if ( (hmac = NAAAIM_SHA256_hmac_Init(key->get_Buffer(key))) == NULL )
+		ERR(goto done);
+
+	if ( (b = token->get_element(token, IDtoken_orgkey)) == NULL )
+		ERR(goto done);
+	hmac->add_Buffer(hmac, b);
+	if ( (b = token->get_element(token, IDtoken_orgid)) == NULL )
+		ERR(goto done);
+	hmac->add_Buffer(hmac, b);
+	if ( !hmac->compute(hmac) )
+		ERR(goto done);
+
+	bufr->add_Buffer(bufr, key->get_Buffer(key));
+	if ( !bufr->add_Buffer(bufr, hmac->get_Buffer(hmac)) )
+		ERR(goto done);
+	retn = true;
+
+
+ done:
+	WHACK(key);
+	WHACK(hmac);
+
+	return retn;
+}
+
+
 #if 0
 /**
  * Private function.
@@ -1018,49 +1334,38 @@ static _Bool set_counter_party_personality(CO(Config, cfg), CO(IDtoken, token))
 
 
 /**
- * Private method.
- *
- * This function is responsible for generating the shared keys which
- * will be used to generate to generate.  Two separate schedules are
- * generated.
- *
- * The first is based on the following:
+ * Private function.
  *
- *	Shared1 = sha256(HMAC_dhkey(client_nonce ^ host_nonce))
+ * This function is responsible for deriving the two shared keys from
+ * a shared secret and the nonces supplied by the two endpoints.  Two
+ * separate schedules are generated:
  *
- *	Shared2 = sha256(HMAC_dhkey(host_nonce || client_nonce))
+ *	Shared1 = sha256(HMAC_key(nonce2 || nonce1))
  *
- *	Where dhkey is the shared secret generated from the Diffie-Hellman
- *	key exchange.
+ *	Shared2 = sha256(HMAC_key(nonce1 ^ nonce2))
  *
  * The two shared keys are stored in the object state for subsequent
  * generation of the encryption and authentication keys.
  *
- * \param this		The object whose shared keys are to be generated.
-
+ * \param S		The state of the object whose shared keys are to
+ *			be generated.
+ *
  * \param nonce1	The first nonce to be used in key generation.
  *
  * \param nonce2	The second nonce to be used in key generation.
  *
- * \param dhkey		The Diffie-Hellman key to be used in computing
- *			the shared secret.
-
- * \param public	The public key to be used in combination with
- *			the public key in the dhkey parameter to generate
- *			shared secret.
+ * \param key		The shared secret which the keys are to be
+ *			derived from.
  *
  * \return		A true value is used to indicate the keys were
  *			successfully generated.  A false value indicates
  *			that key generation failed.
  */
 
-static _Bool generate_shared_keys(CO(PossumPipe, this), CO(Buffer, nonce1),   \
-				  CO(Buffer, nonce2),  CO(Curve25519, dhkey), \
-				  CO(Buffer, public))
+static _Bool _derive_shared_keys(CO(PossumPipe_State, S), CO(Buffer, nonce1), \
+				 CO(Buffer, nonce2), CO(Buffer, key))
 
 {
-	STATE(S);
-
 	_Bool retn = false;
 
 	unsigned char *p,
@@ -1068,18 +1373,12 @@ static _Bool generate_shared_keys(CO(PossumPipe, this), CO(Buffer, nonce1),   \
 
 	unsigned int lp;
 
-	Buffer xor = NULL,
-	       key = NULL;
-
-	Sha256 sha256 = NULL;
-
-	SHA256_hmac hmac;
+	Buffer xor = NULL;
 
+	SHA256_hmac hmac = NULL;
 
-	/* Compute the shared secret and initialize the HMAC. */
-	INIT(HurdLib, Buffer, key, goto done);
-	dhkey->compute(dhkey, public, key);
 
+	/* Initialize the HMAC with the shared secret. */
 	if ( (hmac = NAAAIM_SHA256_hmac_Init(key)) == NULL )
 		ERR(goto done);
 
@@ -1114,7 +1413,7 @@ static _Bool generate_shared_keys(CO(PossumPipe, this), CO(Buffer, nonce1),   \
 
 	/*
 	 * Generate the HMACsha256 hash of the XOR'ed buffer under
-	 * the ECDH generated key.
+	 * the shared secret.
 	 */
 	hmac->reset(hmac);
 	hmac->add_Buffer(hmac, xor);
@@ -1130,8 +1429,6 @@ static _Bool generate_shared_keys(CO(PossumPipe, this), CO(Buffer, nonce1),   \
 
  done:
 	WHACK(xor);
-	WHACK(key);
-	WHACK(sha256);
 	WHACK(hmac);
 
 	return retn;
@@ -1141,47 +1438,208 @@ static _Bool generate_shared_keys(CO(PossumPipe, this), CO(Buffer, nonce1),   \
 /**
  * Private method.
  *
- * This method receives and authenticates the hardware reference
- * quote.
+ * This function is responsible for generating the shared keys which
+ * will be used to generate to generate.  Two separate schedules are
+ * generated.
  *
- * \param this		The object which is to receive the hardware
- *			reference quote.
+ * The first is based on the following:
  *
- * \param bufr		The Buffer object which is to be used to receive
- *			the platform quote.
+ *	Shared1 = sha256(HMAC_dhkey(client_nonce ^ host_nonce))
  *
- * \param ivy		The identify reference which is to be used to
- *			verify the platform reference quote.
+ *	Shared2 = sha256(HMAC_dhkey(host_nonce || client_nonce))
  *
- * \param nonce		The nonce which was used to create the reference.
+ *	Where dhkey is the shared secret generated from the Diffie-Hellman
+ *	key exchange.
  *
- * \return		If the quote is received and verified a true
- *			value is returned.  If an error is encountered a
- *			false value is returned.
+ * The two shared keys are stored in the object state for subsequent
+ * generation of the encryption and authentication keys.
+ *
+ * \param this		The object whose shared keys are to be generated.
+
+ * \param nonce1	The first nonce to be used in key generation.
+ *
+ * \param nonce2	The second nonce to be used in key generation.
+ *
+ * \param dhkey		The Diffie-Hellman key to be used in computing
+ *			the shared secret.
+
+ * \param public	The public key to be used in combination with
+ *			the public key in the dhkey parameter to generate
+ *			shared secret.
+ *
+ * \return		A true value is used to indicate the keys were
+ *			successfully generated.  A false value indicates
+ *			that key generation failed.
  */
 
-static _Bool receive_platform_quote(CO(PossumPipe, this), CO(Buffer, bufr), \
-				    CO(Ivy, ivy), CO(Buffer, nonce))
+static _Bool generate_shared_keys(CO(PossumPipe, this), CO(Buffer, nonce1),   \
+				  CO(Buffer, nonce2),  CO(Curve25519, dhkey), \
+				  CO(Buffer, public))
 
 {
 	STATE(S);
 
 	_Bool retn = false;
 
-	size_t payload;
+	Buffer key = NULL;
 
-	Buffer pubkey,
-	       ref,
-	       key   = S->shared2->get_Buffer(S->shared2),
-	       cksum = NULL,
-	       iv    = NULL,
-	       quote = NULL;
 
-	TPMcmd tpmcmd = NULL;
+	/* Compute the shared secret and derive the shared keys. */
+	INIT(HurdLib, Buffer, key, goto done);
+	dhkey->compute(dhkey, public, key);
 
-	AES256_cbc cipher = NULL;
+	if ( !_derive_shared_keys(S, nonce1, nonce2, key) )
+		ERR(goto done);
 
-	SHA256_hmac hmac = NULL;
+	retn = true;
+
+
+ done:
+	WHACK(key);
+
+	return retn;
+}
+
+
+/**
+ * Private method.
+ *
+ * This method is responsible for creating the session cipher contexts
+ * used when authenticated encryption has been negotiated for the
+ * session.  It is called once the send and receive roots have been
+ * established.  Separate keys are derived for each direction of the
+ * session as follows:
+ *
+ *	Send key = HMAC_shared2(send root)
+ *
+ *	Receive key = HMAC_shared2(receive root)
+ *
+ * The send root of one endpoint is the receive root of its
+ * counter-party so the two keys match across the connection.
+ *
+ * The local software status is measured once and authenticated with
+ * every packet which is sent.  This replaces the per packet
+ * measurement used to generate the HMAC checksum key.
+ *
+ * \param S	The state of the object whose session contexts are to
+ *		be created.
+ *
+ * \return	A true value is used to indicate the session contexts
+ *		were successfully created.  A false value indicates
+ *		that setup failed.
+ */
+
+static _Bool _setup_session_ciphers(CO(PossumPipe_State, S))
+
+{
+	_Bool retn = false;
+
+	Buffer b;
+
+	SoftwareStatus software = NULL;
+
+	SHA256_hmac key = NULL;
+
+
+	if ( S->cipher != PossumPipe_aes256_gcm )
+		return true;
+
+	WHACK(S->encrypter);
+	WHACK(S->decrypter);
+	S->send_sequence    = 0;
+	S->receive_sequence = 0;
+
+	/* Generate the directional keys and their cipher contexts. */
+	b = S->shared2->get_Buffer(S->shared2);
+	if ( (key = NAAAIM_SHA256_hmac_Init(b)) == NULL )
+		ERR(goto done);
+
+	key->add_Buffer(key, S->sent->get_Buffer(S->sent));
+	if ( !key->compute(key) )
+		ERR(goto done);
+	if ( (S->encrypter = \
+	      NAAAIM_AES256_gcm_Init_encrypt(key->get_Buffer(key))) == NULL )
+		ERR(goto done);
+
+	key->reset(key);
+	key->add_Buffer(key, S->received->get_Buffer(S->received));
+	if ( !key->compute(key) )
+		ERR(goto done);
+	if ( (S->decrypter = \
+	      NAAAIM_AES256_gcm_Init_decrypt(key->get_Buffer(key))) == NULL )
+		ERR(goto done);
+
+	/* Measure the software status to be authenticated by packets. */
+	INIT(NAAAIM, SoftwareStatus, software, goto done);
+	if ( !software->open(software) )
+		ERR(goto done);
+	if ( !software->measure(software) )
+		ERR(goto done);
+
+	if ( S->local_software == NULL )
+		INIT(HurdLib, Buffer, S->local_software, goto done);
+	S->local_software->reset(S->local_software);
+	if ( !S->local_software->add_Buffer(S->local_software, \
+				    software->get_template_hash(software)) )
+		ERR(goto done);
+
+	retn = true;
+
+
+ done:
+	WHACK(software);
+	WHACK(key);
+
+	return retn;
+}
+
+
+/**
+ * Private method.
+ *
+ * This method receives and authenticates the hardware reference
+ * quote.
+ *
+ * \param this		The object which is to receive the hardware
+ *			reference quote.
+ *
+ * \param bufr		The Buffer object which is to be used to receive
+ *			the platform quote.
+ *
+ * \param ivy		The identify reference which is to be used to
+ *			verify the platform reference quote.
+ *
+ * \param nonce		The nonce which was used to create the reference.
+ *
+ * \return		If the quote is received and verified a true
+ *			value is returned.  If an error is encountered a
+ *			false value is returned.
+ */
+
+static _Bool receive_platform_quote(CO(PossumPipe, this), CO(Buffer, bufr), \
+				    CO(Ivy, ivy), CO(Buffer, nonce))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	size_t payload;
+
+	Buffer pubkey,
+	       ref,
+	       key   = S->shared2->get_Buffer(S->shared2),
+	       cksum = NULL,
+	       iv    = NULL,
+	       quote = NULL;
+
+	TPMcmd tpmcmd = NULL;
+
+	AES256_cbc cipher = NULL;
+
+	SHA256_hmac hmac = NULL;
+
+	Sha256 sha256 = NULL;
 
 
 	if ( !S->duct->receive_Buffer(S->duct, bufr) )
@@ -1230,6 +1688,18 @@ static _Bool receive_platform_quote(CO(PossumPipe, this), CO(Buffer, bufr), \
 	if ( !tpmcmd->verify(tpmcmd, pubkey, ref, nonce, quote) )
 		ERR(goto done);
 
+	/* Retain the digest of the quote for resumption tickets. */
+	INIT(NAAAIM, Sha256, sha256, goto done);
+	sha256->add(sha256, quote);
+	if ( !sha256->compute(sha256) )
+		ERR(goto done);
+
+	if ( S->quote == NULL )
+		INIT(HurdLib, Buffer, S->quote, goto done);
+	S->quote->reset(S->quote);
+	if ( !S->quote->add_Buffer(S->quote, sha256->get_Buffer(sha256)) )
+		ERR(goto done);
+
 	retn = true;
 
 
@@ -1240,6 +1710,7 @@ static _Bool receive_platform_quote(CO(PossumPipe, this), CO(Buffer, bufr), \
 	WHACK(tpmcmd);
 	WHACK(cipher);
 	WHACK(hmac);
+	WHACK(sha256);
 
 	return retn;
 }
@@ -1351,7 +1822,9 @@ static _Bool send_platform_quote(CO(PossumPipe, this), CO(Buffer, bufr), \
  * Private method.
  *
  * This function receives and confirms a request to initiate a
- * connection from the client.
+ * connection from the client.  The authenticator may be followed
+ * by the packet protection mode proposed by the client.  A client
+ * which does not propose a mode is assigned the CBC/HMAC mode.
  *
  * \param this	The object which is to receive the connection start.
  *
@@ -1377,6 +1850,7 @@ static _Bool receive_connection_start(CO(PossumPipe, this), CO(Buffer, bufr))
 	Duct duct = S->duct;
 
 	Buffer b,
+	       auth,
 	       key   = S->shared2->get_Buffer(S->shared2),
 	       cksum = NULL,
 	       iv    = NULL;
@@ -1422,13 +1896,29 @@ static _Bool receive_connection_start(CO(PossumPipe, this), CO(Buffer, bufr))
 		ERR(goto done);
 
 
+	/* Extract the proposed packet protection mode. */
+	auth		    = cipher->get_Buffer(cipher);
+	S->cipher	    = PossumPipe_cbc_hmac;
+	S->ticket_requested = false;
+
+	if ( auth->size(auth) == (NAAAIM_IDSIZE + 1) ) {
+		S->cipher = *(auth->get(auth) + NAAAIM_IDSIZE);
+		auth->shrink(auth, 1);
+
+		S->ticket_requested = (S->cipher & TICKET_REQUEST) != 0;
+		S->cipher &= ~TICKET_REQUEST;
+	}
+	if ( (S->cipher != PossumPipe_cbc_hmac) && \
+	     (S->cipher != PossumPipe_aes256_gcm) )
+		ERR(goto done);
+
 	/* Confirm the authenticator. */
 	INIT(NAAAIM, Sha256, sha256, goto done);
 	sha256->add(sha256, key);
 	if ( !sha256->compute(sha256) )
 		ERR(goto done);
 	b = sha256->get_Buffer(sha256);
-	if ( !b->equal(b, cipher->get_Buffer(cipher)) )
+	if ( !b->equal(b, auth) )
 		ERR(goto done);
 
 	retn = true;
@@ -1446,6 +1936,527 @@ static _Bool receive_connection_start(CO(PossumPipe, this), CO(Buffer, bufr))
 }
 
 
+/**
+ * Private method.
+ *
+ * This method establishes the session state once the shared keys
+ * have been generated.  The send and receive roots are computed
+ * from the shared keys, in opposite order for the host and client,
+ * followed by creation of the session cipher contexts and the
+ * packet nonce generator.
+ *
+ * \param S		The state of the object whose session is to be
+ *			established.
+ *
+ * \param host		A flag indicating whether the session is being
+ *			established for the host side of the connection.
+ *
+ * \return		A true value is used to indicate the session was
+ *			successfully established.  A false value indicates
+ *			that setup failed.
+ */
+
+static _Bool _setup_session(CO(PossumPipe_State, S), const _Bool host)
+
+{
+	_Bool retn = false;
+
+	Sha256 first  = host ? S->shared1 : S->shared2,
+	       second = host ? S->shared2 : S->shared1;
+
+
+	if ( S->sent == NULL )
+		INIT(NAAAIM, Sha256, S->sent, goto done);
+	S->sent->reset(S->sent);
+	S->sent->add(S->sent, first->get_Buffer(first));
+	S->sent->add(S->sent, second->get_Buffer(second));
+	if ( !S->sent->compute(S->sent) )
+		ERR(goto done);
+	fputs("Send root:\n", stderr);
+	S->sent->print(S->sent);
+
+	if ( S->received == NULL )
+		INIT(NAAAIM, Sha256, S->received, goto done);
+	S->received->reset(S->received);
+	S->received->add(S->received, second->get_Buffer(second));
+	S->received->add(S->received, first->get_Buffer(first));
+	if ( !S->received->compute(S->received) )
+		ERR(goto done);
+	fputs("Receive root:\n", stderr);
+	S->received->print(S->received);
+	fputc('\n', stderr);
+
+	/* Create the session cipher contexts. */
+	if ( !_setup_session_ciphers(S) )
+		ERR(goto done);
+
+	/* Setup client nonce. */
+	WHACK(S->nonce);
+	if ( !_setup_nonce(S) )
+		ERR(goto done);
+
+	retn = true;
+
+
+ done:
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function computes the secret which a resumed session derives
+ * its shared keys from.  The secret is computed from the shared keys
+ * of the fully attested session as follows:
+ *
+ *	Secret = HMAC_shared1(shared2)
+ *
+ * \param S		The state of the object whose resumption secret
+ *			is to be computed.
+ *
+ * \param secret	The object which will be loaded with the secret.
+ *
+ * \return		A true value is used to indicate the secret was
+ *			computed.  A false value indicates an error.
+ */
+
+static _Bool _resumption_secret(CO(PossumPipe_State, S), CO(Buffer, secret))
+
+{
+	_Bool retn = false;
+
+	SHA256_hmac hmac = NULL;
+
+
+	if ( (hmac = NAAAIM_SHA256_hmac_Init(S->shared1->get_Buffer(S->shared1))) \
+	     == NULL )
+		ERR(goto done);
+	hmac->add_Buffer(hmac, S->shared2->get_Buffer(S->shared2));
+	if ( !hmac->compute(hmac) )
+		ERR(goto done);
+
+	if ( !secret->add_Buffer(secret, hmac->get_Buffer(hmac)) )
+		ERR(goto done);
+	retn = true;
+
+
+ done:
+	WHACK(hmac);
+
+	return retn;
+}
+
+
+/**
+ * Private method.
+ *
+ * This method issues a resumption ticket to a client at the end of a
+ * fully attested session setup.  The ticket is sealed with the host
+ * ticket key and binds the resumption secret to the identity,
+ * software status and platform quote digest of the attested client
+ * and the time the ticket was issued.  The ticket is transmitted in
+ * a ticket packet preceded by the ticket lifetime.
+ *
+ * A ticket is only issued if the client requested one and the host
+ * has enabled session resumption.  An empty ticket is sent if the
+ * client requested a ticket which the host will not issue.
+ *
+ * \param this		The object which is to issue the ticket.
+ *
+ * \return		A true value is used to indicate the ticket was
+ *			issued or not required.  A false value indicates
+ *			an error was encountered.
+ */
+
+static _Bool _issue_ticket(CO(PossumPipe, this))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	unsigned char *p,
+		      mode = S->cipher;
+
+	unsigned int lp;
+
+	uint64_t value;
+
+	Buffer b,
+	       bufr   = NULL,
+	       ticket = NULL;
+
+	RandomBuffer iv = NULL;
+
+	AES256_gcm cipher = NULL;
+
+
+	if ( !S->ticket_requested )
+		return true;
+
+	INIT(HurdLib, Buffer, bufr, goto done);
+	if ( S->ticket_key == NULL ) {
+		if ( !this->send_packet(this, PossumPipe_ticket, bufr) )
+			ERR(goto done);
+		retn = true;
+		goto done;
+	}
+
+	/* Compose the ticket plaintext. */
+	value = time(NULL);
+	for (lp= 0; lp < sizeof(value); ++lp) {
+		p = (unsigned char *) &value + sizeof(value) - 1 - lp;
+		bufr->add(bufr, p, 1);
+	}
+	bufr->add(bufr, &mode, sizeof(mode));
+	if ( !_resumption_secret(S, bufr) )
+		ERR(goto done);
+	if ( !bufr->add_Buffer(bufr, S->software) )
+		ERR(goto done);
+	if ( (S->identity == NULL) || (S->quote == NULL) )
+		ERR(goto done);
+	if ( !bufr->add_Buffer(bufr, S->identity) )
+		ERR(goto done);
+	if ( !bufr->add_Buffer(bufr, S->quote) )
+		ERR(goto done);
+	if ( bufr->size(bufr) != TICKET_PLAINTEXT_SIZE )
+		ERR(goto done);
+
+	/* Seal the ticket. */
+	INIT(NAAAIM, RandomBuffer, iv, goto done);
+	if ( !iv->generate(iv, AES256_GCM_IV_SIZE) )
+		ERR(goto done);
+	b = iv->get_Buffer(iv);
+	p = b->get(b);
+
+	if ( (cipher = NAAAIM_AES256_gcm_Init_encrypt(S->ticket_key)) == NULL )
+		ERR(goto done);
+	if ( !cipher->encrypt(cipher, p, NULL, bufr) )
+		ERR(goto done);
+
+	/* Prefix the lifetime and initialization vector and send. */
+	INIT(HurdLib, Buffer, ticket, goto done);
+
+	value = S->ticket_lifetime;
+	for (lp= 0; lp < sizeof(value); ++lp)
+		ticket->add(ticket, (unsigned char *) &value + \
+			    sizeof(value) - 1 - lp, 1);
+	ticket->add(ticket, p, AES256_GCM_IV_SIZE);
+	if ( !ticket->add_Buffer(ticket, bufr) )
+		ERR(goto done);
+
+	if ( !this->send_packet(this, PossumPipe_ticket, ticket) )
+		ERR(goto done);
+
+	retn = true;
+
+
+ done:
+	WHACK(bufr);
+	WHACK(ticket);
+	WHACK(iv);
+	WHACK(cipher);
+
+	return retn;
+}
+
+
+/**
+ * Private method.
+ *
+ * This method receives the resumption ticket issued by a host at the
+ * end of a fully attested session setup.  The client ticket retained
+ * by the object consists of the following:
+ *
+ *	Expiry time || Mode || Resumption secret || Host software ||
+ *	Sealed ticket
+ *
+ * \param this		The object which is to receive the ticket.
+ *
+ * \return		A true value is used to indicate the ticket was
+ *			received or was not requested.  A false value
+ *			indicates an error was encountered.
+ */
+
+static _Bool _receive_ticket(CO(PossumPipe, this))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	unsigned char *p,
+		      mode = S->cipher;
+
+	unsigned int lp;
+
+	uint64_t value = 0;
+
+	Buffer bufr = NULL;
+
+
+	if ( !S->ticket_requested )
+		return true;
+
+	INIT(HurdLib, Buffer, bufr, goto done);
+	if ( this->receive_packet(this, bufr) != PossumPipe_ticket )
+		ERR(goto done);
+
+	/* A host may decline to issue a ticket. */
+	WHACK(S->ticket);
+	if ( bufr->size(bufr) == 0 ) {
+		retn = true;
+		goto done;
+	}
+	if ( bufr->size(bufr) != (sizeof(value) + TICKET_BLOB_SIZE) )
+		ERR(goto done);
+
+	p = bufr->get(bufr);
+	for (lp= 0; lp < sizeof(value); ++lp)
+		value = (value << 8) | *p++;
+	value += time(NULL);
+
+	INIT(HurdLib, Buffer, S->ticket, goto done);
+	for (lp= 0; lp < sizeof(value); ++lp)
+		S->ticket->add(S->ticket, (unsigned char *) &value + \
+			       sizeof(value) - 1 - lp, 1);
+	S->ticket->add(S->ticket, &mode, sizeof(mode));
+	if ( !_resumption_secret(S, S->ticket) )
+		ERR(goto done);
+	S->ticket->add_Buffer(S->ticket, S->software);
+	if ( !S->ticket->add(S->ticket, p, TICKET_BLOB_SIZE) )
+		ERR(goto done);
+
+	retn = true;
+
+
+ done:
+	WHACK(bufr);
+
+	return retn;
+}
+
+
+/**
+ * Private method.
+ *
+ * This method implements the host side of a session resumption.  The
+ * sealed ticket in the request is opened, with the current ticket key
+ * or the key it replaced, and the request is authenticated with the
+ * resumption secret which it contains.  The identity asserted by the
+ * client is verified against the identity verifiers of the host and
+ * must match the identity the ticket was issued to.  A request
+ * carrying a ticket which cannot be opened, which has outlived the
+ * ticket lifetime or which is presented by a client other than the
+ * one it was issued to is declined so that the client proceeds with
+ * a fully attested session setup.
+ *
+ * If the ticket is accepted the host returns its nonce and the
+ * shared keys of the resumed session are derived from the
+ * resumption secret and the nonces of the two endpoints.
+ *
+ * \param this		The object which is to resume the session.
+ *
+ * \param bufr		The object containing the resumption request.
+ *
+ * \param resumed	A pointer to the variable which will be set to
+ *			indicate whether or not the session was resumed.
+ *
+ * \return		A false value is returned if an error was
+ *			encountered.  A true value indicates the request
+ *			was either accepted or declined.
+ */
+
+static _Bool _resume_host(CO(PossumPipe, this), CO(Buffer, bufr), \
+			  _Bool *resumed)
+
+{
+	STATE(S);
+
+	_Bool retn   = false,
+	      opened = false;
+
+	unsigned char *p,
+		      status = 0;
+
+	unsigned int lp;
+
+	uint64_t issued = 0;
+
+	PossumPipe_cipher mode;
+
+	Buffer key,
+	       ticket	= NULL,
+	       secret	= NULL,
+	       nonce	= NULL,
+	       identity = NULL;
+
+	RandomBuffer host_nonce = NULL;
+
+	AES256_gcm cipher = NULL;
+
+	SHA256_hmac hmac = NULL;
+
+	IDtoken token = NULL;
+
+	Ivy ivy = NULL;
+
+
+	*resumed = false;
+	INIT(HurdLib, Buffer, ticket, goto done);
+	INIT(HurdLib, Buffer, secret, goto done);
+	INIT(HurdLib, Buffer, nonce, goto done);
+	INIT(HurdLib, Buffer, identity, goto done);
+
+	/*
+	 * Open the ticket with the current ticket key, or the key it
+	 * replaced, and verify it has not expired.
+	 */
+	if ( S->ticket_key == NULL )
+		goto decline;
+
+	p = bufr->get(bufr) + RESUME_MAGIC_SIZE;
+	for (lp= 0; lp < 2; ++lp) {
+		key = (lp == 0) ? S->ticket_key : S->previous_key;
+		if ( key == NULL )
+			break;
+
+		ticket->reset(ticket);
+		if ( !ticket->add(ticket, p + AES256_GCM_IV_SIZE, \
+				  TICKET_BLOB_SIZE - AES256_GCM_IV_SIZE) )
+			ERR(goto done);
+
+		WHACK(cipher);
+		if ( (cipher = NAAAIM_AES256_gcm_Init_decrypt(key)) == NULL )
+			ERR(goto done);
+		if ( cipher->decrypt(cipher, p, NULL, ticket) ) {
+			opened = true;
+			break;
+		}
+	}
+	if ( !opened )
+		goto decline;
+
+	p = ticket->get(ticket);
+	for (lp= 0; lp < sizeof(issued); ++lp)
+		issued = (issued << 8) | *p++;
+	if ( (issued + S->ticket_lifetime) <= (uint64_t) time(NULL) )
+		goto decline;
+
+	mode = *p++;
+	if ( !secret->add(secret, p, NAAAIM_IDSIZE) )
+		ERR(goto done);
+	p += NAAAIM_IDSIZE;
+
+	/* Authenticate the request with the resumption secret. */
+	if ( (hmac = NAAAIM_SHA256_hmac_Init(secret)) == NULL )
+		ERR(goto done);
+	hmac->add(hmac, bufr->get(bufr), RESUME_REQUEST_SIZE - NAAAIM_IDSIZE);
+	if ( !hmac->compute(hmac) )
+		ERR(goto done);
+	if ( memcmp(hmac->get(hmac), bufr->get(bufr) + RESUME_REQUEST_SIZE - \
+		    NAAAIM_IDSIZE, NAAAIM_IDSIZE) != 0 )
+		goto decline;
+
+	/*
+	 * Verify the identity asserted by the client and require it
+	 * to be the identity the ticket was issued to.
+	 */
+	if ( !identity->add(identity, bufr->get(bufr) + RESUME_MAGIC_SIZE + \
+			    TICKET_BLOB_SIZE + NAAAIM_IDSIZE,		 \
+			    2*NAAAIM_IDSIZE) )
+		ERR(goto done);
+
+	INIT(NAAAIM, IDtoken, token, goto done);
+	INIT(NAAAIM, Ivy, ivy, goto done);
+	if ( !find_client(S, identity, token, ivy) )
+		goto decline;
+	if ( !_client_identity(token, identity) )
+		ERR(goto done);
+	if ( memcmp(identity->get(identity), p + NAAAIM_IDSIZE, \
+		    NAAAIM_IDSIZE) != 0 )
+		goto decline;
+
+	/* Restore the attested state of the client. */
+	if ( S->software == NULL )
+		INIT(HurdLib, Buffer, S->software, goto done);
+	S->software->reset(S->software);
+	if ( !S->software->add(S->software, p, NAAAIM_IDSIZE) )
+		ERR(goto done);
+	S->cipher = mode;
+
+	WHACK(S->identity);
+	S->identity = identity;
+	identity    = NULL;
+
+	if ( S->quote == NULL )
+		INIT(HurdLib, Buffer, S->quote, goto done);
+	S->quote->reset(S->quote);
+	if ( !S->quote->add(S->quote, p + 2*NAAAIM_IDSIZE, NAAAIM_IDSIZE) )
+		ERR(goto done);
+
+	/* Return the host nonce to the client. */
+	INIT(NAAAIM, RandomBuffer, host_nonce, goto done);
+	if ( !host_nonce->generate(host_nonce, NAAAIM_IDSIZE) )
+		ERR(goto done);
+	if ( !nonce->add(nonce, bufr->get(bufr) + RESUME_MAGIC_SIZE + \
+			 TICKET_BLOB_SIZE, NAAAIM_IDSIZE) )
+		ERR(goto done);
+
+	status = 1;
+	bufr->reset(bufr);
+	bufr->add(bufr, &status, sizeof(status));
+	bufr->add_Buffer(bufr, host_nonce->get_Buffer(host_nonce));
+
+	hmac->reset(hmac);
+	hmac->add_Buffer(hmac, bufr);
+	hmac->add_Buffer(hmac, nonce);
+	if ( !hmac->compute(hmac) )
+		ERR(goto done);
+	if ( !bufr->add_Buffer(bufr, hmac->get_Buffer(hmac)) )
+		ERR(goto done);
+	if ( !S->duct->send_Buffer(S->duct, bufr) )
+		ERR(goto done);
+
+	/* Derive the session keys. */
+	S->shared1->reset(S->shared1);
+	S->shared2->reset(S->shared2);
+	if ( !_derive_shared_keys(S, host_nonce->get_Buffer(host_nonce), \
+				  nonce, secret) )
+		ERR(goto done);
+	if ( !_setup_session(S, true) )
+		ERR(goto done);
+
+	*resumed = true;
+	retn	 = true;
+	goto done;
+
+
+ decline:
+	bufr->reset(bufr);
+	if ( !bufr->add(bufr, &status, sizeof(status)) )
+		ERR(goto done);
+	if ( !S->duct->send_Buffer(S->duct, bufr) )
+		ERR(goto done);
+	retn = true;
+
+
+ done:
+	WHACK(ticket);
+	WHACK(secret);
+	WHACK(nonce);
+	WHACK(identity);
+	WHACK(host_nonce);
+	WHACK(cipher);
+	WHACK(hmac);
+	WHACK(token);
+	WHACK(ivy);
+
+	return retn;
+}
+
+
 /**
  * External public method.
  *
@@ -1476,6 +2487,8 @@ static _Bool start_host_mode(CO(PossumPipe, this))
 
 	Duct duct = S->duct;
 
+	_Bool resumed;
+
 	Buffer b,
 	       netbufr		= NULL,
 	       nonce		= NULL,
@@ -1496,24 +2509,47 @@ static _Bool start_host_mode(CO(PossumPipe, this))
 	Ivy ivy = NULL;
 
 
-	/* Get current software status. */
-	INIT(NAAAIM, SoftwareStatus, software_status, goto done);
-	software_status->open(software_status);
-	fputs("Measuring software status.\n", stderr);
-	if ( !software_status->measure(software_status) )
-		ERR(goto done);
-	fputs("Host software status:\n", stdout);
-	b = software_status->get_template_hash(software_status);
-	b->print(b);
-
 	/* Setup the network port. */
 	INIT(HurdLib, Buffer, netbufr, goto done);
-	INIT(HurdLib, Buffer, S->software, goto done);
 
 	/* Wait for a packet to arrive. */
 	fprintf(stderr, "%s: Waiting for initialization packet.\n", __func__);
 	if ( !duct->receive_Buffer(duct, netbufr) )
 		ERR(goto done);
+
+	/*
+	 * Attempt to resume a previously attested session.  If the
+	 * ticket is declined the client follows with a full session
+	 * setup request.
+	 */
+	if ( (netbufr->size(netbufr) == RESUME_REQUEST_SIZE) &&	      \
+	     (memcmp(netbufr->get(netbufr), RESUME_MAGIC,	      \
+		     RESUME_MAGIC_SIZE) == 0) ) {
+		if ( !_resume_host(this, netbufr, &resumed) )
+			ERR(goto done);
+		if ( resumed ) {
+			retn = true;
+			goto done;
+		}
+
+		netbufr->reset(netbufr);
+		if ( !duct->receive_Buffer(duct, netbufr) )
+			ERR(goto done);
+	}
+
+	/* Get current software status. */
+	INIT(NAAAIM, SoftwareStatus, software_status, goto done);
+	software_status->open(software_status);
+	fputs("Measuring software status.\n", stderr);
+	if ( !software_status->measure(software_status) )
+		ERR(goto done);
+	fputs("Host software status:\n", stdout);
+	b = software_status->get_template_hash(software_status);
+	b->print(b);
+
+	if ( S->software == NULL )
+		INIT(HurdLib, Buffer, S->software, goto done);
+	S->software->reset(S->software);
 	fprintf(stdout, "\n%s: Raw receive packet:\n", __func__);
 	netbufr->hprint(netbufr);
 	fputc('\n', stdout);
@@ -1521,7 +2557,12 @@ static _Bool start_host_mode(CO(PossumPipe, this))
 	/* Lookup the client identity. */
 	INIT(NAAAIM, IDtoken, token, goto done);
 	INIT(NAAAIM, Ivy, ivy, goto done);
-	if ( !find_client(netbufr, token, ivy) )
+	if ( !find_client(S, netbufr, token, ivy) )
+		ERR(goto done);
+
+	if ( S->identity == NULL )
+		INIT(HurdLib, Buffer, S->identity, goto done);
+	if ( !_client_identity(token, S->identity) )
 		ERR(goto done);
 
 	/* Set the client configuration personality. */
@@ -1668,25 +2709,11 @@ static _Bool start_host_mode(CO(PossumPipe, this))
 	S->shared2->print(S->shared2);
 	fputc('\n', stderr);
 
-	INIT(NAAAIM, Sha256, S->sent, goto done);
-	S->sent->add(S->sent, S->shared1->get_Buffer(S->shared1));
-	S->sent->add(S->sent, S->shared2->get_Buffer(S->shared2));
-	if ( !S->sent->compute(S->sent) )
-		ERR(goto done);
-	fputs("Send root:\n", stderr);
-	S->sent->print(S->sent);
-
-	INIT(NAAAIM, Sha256, S->received, goto done);
-	S->received->add(S->received, S->shared2->get_Buffer(S->shared2));
-	S->received->add(S->received, S->shared1->get_Buffer(S->shared1));
-	if ( !S->received->compute(S->received) )
+	if ( !_setup_session(S, true) )
 		ERR(goto done);
-	fputs("Receive root:\n", stderr);
-	S->received->print(S->received);
-	fputc('\n', stderr);
 
-	/* Setup client nonce. */
-	if ( !_setup_nonce(S) )
+	/* Issue a resumption ticket if the client requested one. */
+	if ( !_issue_ticket(this) )
 		ERR(goto done);
 
 	retn = true;
@@ -1714,7 +2741,11 @@ static _Bool start_host_mode(CO(PossumPipe, this))
  *
  * This function transmits confirmation for the host to move forward
  * with the secured connection.  The confirmation consists of
- * the SHA256 hash of the negotiated secret.
+ * the SHA256 hash of the negotiated secret followed by the packet
+ * protection mode being proposed for the session.  The proposal is
+ * omitted if the CBC/HMAC mode is being requested without a
+ * resumption ticket in order to maintain compatibility with hosts
+ * which do not negotiate a mode.
  *
  * \param duct		The network object which the reference quote is
  *			to be received on.
@@ -1738,8 +2769,11 @@ static _Bool send_connection_start(CO(PossumPipe, this), CO(Buffer, bufr))
 
 	_Bool retn = false;
 
+	unsigned char proposal = S->proposal;
+
 	Buffer b,
-	       key = S->shared2->get_Buffer(S->shared2);
+	       key  = S->shared2->get_Buffer(S->shared2),
+	       auth = NULL;
 
 	Duct duct = S->duct;
 
@@ -1765,11 +2799,21 @@ static _Bool send_connection_start(CO(PossumPipe, this), CO(Buffer, bufr))
 	if ( !sha256->compute(sha256) )
 		ERR(goto done);
 
+	INIT(HurdLib, Buffer, auth, goto done);
+	if ( !auth->add_Buffer(auth, sha256->get_Buffer(sha256)) )
+		ERR(goto done);
+	if ( S->ticket_requested )
+		proposal |= TICKET_REQUEST;
+	if ( proposal != PossumPipe_cbc_hmac ) {
+		if ( !auth->add(auth, &proposal, sizeof(proposal)) )
+			ERR(goto done);
+	}
+
 	/* Encrypt the authenticator. */
 	b = iv->get_Buffer(iv);
 	if ( (cipher = NAAAIM_AES256_cbc_Init_encrypt(key, b)) == NULL )
 		ERR(goto done);
-	if ( !cipher->encrypt(cipher, sha256->get_Buffer(sha256)) )
+	if ( !cipher->encrypt(cipher, auth) )
 		ERR(goto done);
 	if ( !bufr->add_Buffer(bufr, cipher->get_Buffer(cipher)) )
 		ERR(goto done);
@@ -1787,10 +2831,12 @@ static _Bool send_connection_start(CO(PossumPipe, this), CO(Buffer, bufr))
 	if ( !duct->send_Buffer(duct, bufr) )
 		ERR(goto done);
 
+	S->cipher = S->proposal;
 	retn = true;
 
 
  done:
+	WHACK(auth);
 	WHACK(iv);
 	WHACK(cipher);
 	WHACK(sha256);
@@ -1921,7 +2967,7 @@ static _Bool start_client_mode(CO(PossumPipe, this))
 	/* Find the host identity. */
 	INIT(NAAAIM, Ivy, ivy, goto done);
 	token->reset(token);
-	if ( !find_client(bufr, token, ivy) )
+	if ( !find_client(S, bufr, token, ivy) )
 		ERR(goto done);
 
 	/* Set the host configuration personality. */
@@ -1935,7 +2981,9 @@ static _Bool start_client_mode(CO(PossumPipe, this))
 	     ERR(goto done);
 #endif
 
-	INIT(HurdLib, Buffer, S->software, goto done);
+	if ( S->software == NULL )
+		INIT(HurdLib, Buffer, S->software, goto done);
+	S->software->reset(S->software);
 	if ( (b = ivy->get_element(ivy, Ivy_software)) == NULL )
 		ERR(goto done);
 	S->software->add_Buffer(S->software, b);
@@ -1987,25 +3035,11 @@ static _Bool start_client_mode(CO(PossumPipe, this))
 	S->shared2->print(S->shared2);
 	fputc('\n', stderr);
 
-	INIT(NAAAIM, Sha256, S->sent, goto done);
-	S->sent->add(S->sent, S->shared2->get_Buffer(S->shared2));
-	S->sent->add(S->sent, S->shared1->get_Buffer(S->shared1));
-	if ( !S->sent->compute(S->sent) )
-		ERR(goto done);
-	fputs("Send root:\n", stderr);
-	S->sent->print(S->sent);
-
-	INIT(NAAAIM, Sha256, S->received, goto done);
-	S->received->add(S->received, S->shared1->get_Buffer(S->shared1));
-	S->received->add(S->received, S->shared2->get_Buffer(S->shared2));
-	if ( !S->received->compute(S->received) )
+	if ( !_setup_session(S, false) )
 		ERR(goto done);
-	fputs("Receive root:\n", stderr);
-	S->received->print(S->received);
-	fputc('\n', stderr);
 
-	/* Setup client nonce. */
-	if ( !_setup_nonce(S) )
+	/* Receive the resumption ticket if one was requested. */
+	if ( !_receive_ticket(this) )
 		ERR(goto done);
 
 	retn = true;
@@ -2026,6 +3060,380 @@ static _Bool start_client_mode(CO(PossumPipe, this))
 }
 
 
+/**
+ * External public method.
+ *
+ * This method implements enabling session resumption.  When called
+ * on an object which is to be used in host mode it sets the lifetime
+ * of the resumption tickets issued to clients.  Once a ticket has
+ * outlived this lifetime the client is required to carry out a fully
+ * attested session setup.  If a ticket key has not been set with the
+ * ->set_ticket_key method a random key is generated, tickets sealed
+ * with it can only be redeemed with this object.
+ *
+ * When called on an object which is to be used in client mode the
+ * object requests a resumption ticket from the host during session
+ * setup.
+ *
+ * \param this		A pointer to the object which is to have
+ *			session resumption enabled.
+ *
+ * \param lifetime	The number of seconds for which an issued
+ *			ticket is valid.  A value of zero disables
+ *			session resumption.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not resumption was configured.
+ */
+
+static _Bool enable_resumption(CO(PossumPipe, this), const time_t lifetime)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	RandomBuffer key = NULL;
+
+
+	S->ticket_requested = false;
+	if ( (S->ticket_lifetime = lifetime) <= 0 ) {
+		S->ticket_lifetime = 0;
+		WHACK(S->ticket_key);
+		WHACK(S->previous_key);
+		return true;
+	}
+
+	if ( S->ticket_key == NULL ) {
+		INIT(NAAAIM, RandomBuffer, key, goto done);
+		if ( !key->generate(key, NAAAIM_IDSIZE) )
+			ERR(goto done);
+
+		INIT(HurdLib, Buffer, S->ticket_key, goto done);
+		if ( !S->ticket_key->add_Buffer(S->ticket_key, \
+						key->get_Buffer(key)) )
+			ERR(goto done);
+	}
+
+	S->ticket_requested = true;
+	retn = true;
+
+
+ done:
+	WHACK(key);
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements setting the key which a host uses to seal
+ * and open resumption tickets.  Setting the same key in each of the
+ * objects which service connections, whether in other threads,
+ * processes or after a restart of the server, allows a ticket issued
+ * by any of them to be redeemed with any other.
+ *
+ * The key is rotated by setting a new key.  Tickets are sealed with
+ * the most recently set key while tickets sealed with the key it
+ * replaced continue to be accepted until they expire.  Rotating the
+ * key at intervals no shorter than the ticket lifetime therefore
+ * never declines a valid ticket.
+ *
+ * \param this		A pointer to the object whose ticket key is to
+ *			be set.
+ *
+ * \param key		The object containing the 32 byte ticket key.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the key was set.
+ */
+
+static _Bool set_ticket_key(CO(PossumPipe, this), CO(Buffer, key))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	Buffer bufr = NULL;
+
+
+	if ( (key == NULL) || key->poisoned(key) )
+		ERR(goto done);
+	if ( key->size(key) != NAAAIM_IDSIZE )
+		ERR(goto done);
+
+	INIT(HurdLib, Buffer, bufr, goto done);
+	if ( !bufr->add_Buffer(bufr, key) )
+		ERR(goto done);
+
+	WHACK(S->previous_key);
+	S->previous_key = S->ticket_key;
+	S->ticket_key	= bufr;
+	bufr		= NULL;
+
+	retn = true;
+
+
+ done:
+	WHACK(bufr);
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements an accessor for obtaining the resumption
+ * ticket which a client was issued during session setup.  The ticket
+ * is an opaque object which is supplied to the ->resume_client_mode
+ * method of a subsequent connection to the same host.
+ *
+ * \param this		A pointer to the object whose ticket is to be
+ *			returned.
+ *
+ * \param bufr		The object which the ticket is to be loaded
+ *			into.
+ *
+ * \return		A false value is returned if a ticket is not
+ *			available.  A true value indicates the supplied
+ *			object holds a valid ticket.
+ */
+
+static _Bool get_ticket(CO(PossumPipe, this), CO(Buffer, bufr))
+
+{
+	STATE(S);
+
+
+	if ( S->ticket == NULL )
+		return false;
+	if ( (bufr == NULL) || bufr->poisoned(bufr) )
+		return false;
+
+	return bufr->add_Buffer(bufr, S->ticket);
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements resuming a session with a remote host using
+ * a ticket issued to a previous connection.  A resumed session is
+ * established with a single round trip which replaces the identity
+ * lookup, key agreement and platform quote exchanges of a full
+ * session setup.  The request asserts the identity of the client
+ * which the host requires to match the identity the ticket was
+ * issued to.
+ *
+ * If the ticket has expired, or is declined by the host, a fully
+ * attested session setup is carried out on the connection.
+ *
+ * \param this		A pointer to the object which is to resume a
+ *			remote connection.
+ *
+ * \param ticket	The object containing the ticket returned by the
+ *			->get_ticket method of a previous connection.
+ *
+ * \return		A boolean value is returned to indicate the
+ *			status of session initiation.  A false value
+ *			indicates that connection setup failed while
+ *			a true value indicates a session has been
+ *			established and is valid.
+ */
+
+static _Bool resume_client_mode(CO(PossumPipe, this), CO(Buffer, ticket))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	unsigned char *p;
+
+	unsigned int lp;
+
+	uint64_t expiry = 0;
+
+	PossumPipe_cipher mode;
+
+	Buffer b,
+	       bufr   = NULL,
+	       secret = NULL,
+	       nonce  = NULL;
+
+	String name = NULL;
+
+	RandomBuffer client_nonce = NULL;
+
+	SHA256_hmac hmac = NULL;
+
+	IDmgr idmgr = NULL;
+
+	IDtoken token = NULL;
+
+
+	if ( (ticket == NULL) || ticket->poisoned(ticket) )
+		ERR(goto done);
+	if ( ticket->size(ticket) != (8 + 1 + NAAAIM_IDSIZE + NAAAIM_IDSIZE + \
+				      TICKET_BLOB_SIZE) )
+		ERR(goto done);
+
+	/* Carry out a full setup if the ticket has expired. */
+	p = ticket->get(ticket);
+	for (lp= 0; lp < sizeof(expiry); ++lp)
+		expiry = (expiry << 8) | *p++;
+	if ( expiry <= (uint64_t) time(NULL) )
+		return this->start_client_mode(this);
+
+	mode = *p++;
+	INIT(HurdLib, Buffer, secret, goto done);
+	if ( !secret->add(secret, p, NAAAIM_IDSIZE) )
+		ERR(goto done);
+	p += NAAAIM_IDSIZE;
+
+	/* Load the identity token the request will assert. */
+	INIT(NAAAIM, IDtoken, token, goto done);
+	INIT(NAAAIM, IDmgr, idmgr, goto done);
+	if ( (name = HurdLib_String_Init_cstr("device")) == NULL )
+		ERR(goto done);
+
+	idmgr->attach(idmgr);
+	if ( !idmgr->get_idtoken(idmgr, name, token) )
+		ERR(goto done);
+
+	/* Compose and send the resumption request. */
+	INIT(NAAAIM, RandomBuffer, client_nonce, goto done);
+	if ( !client_nonce->generate(client_nonce, NAAAIM_IDSIZE) )
+		ERR(goto done);
+
+	INIT(HurdLib, Buffer, bufr, goto done);
+	bufr->add(bufr, (unsigned char *) RESUME_MAGIC, RESUME_MAGIC_SIZE);
+	bufr->add(bufr, p + NAAAIM_IDSIZE, TICKET_BLOB_SIZE);
+	bufr->add_Buffer(bufr, client_nonce->get_Buffer(client_nonce));
+	if ( !_assert_identity(token, bufr) )
+		ERR(goto done);
+
+	if ( (hmac = NAAAIM_SHA256_hmac_Init(secret)) == NULL )
+		ERR(goto done);
+	hmac->add_Buffer(hmac, bufr);
+	if ( !hmac->compute(hmac) )
+		ERR(goto done);
+	if ( !bufr->add_Buffer(bufr, hmac->get_Buffer(hmac)) )
+		ERR(goto done);
+
+	if ( !S->duct->send_Buffer(S->duct, bufr) )
+		ERR(goto done);
+
+	/* Fall back to a full setup if the host declines the ticket. */
+	bufr->reset(bufr);
+	if ( !S->duct->receive_Buffer(S->duct, bufr) )
+		ERR(goto done);
+	if ( (bufr->size(bufr) == 1) && (*bufr->get(bufr) == 0) ) {
+		retn = this->start_client_mode(this);
+		goto done;
+	}
+
+	/* Authenticate the host reply. */
+	if ( bufr->size(bufr) != RESUME_REPLY_SIZE )
+		ERR(goto done);
+	if ( *bufr->get(bufr) != 1 )
+		ERR(goto done);
+
+	hmac->reset(hmac);
+	hmac->add(hmac, bufr->get(bufr), 1 + NAAAIM_IDSIZE);
+	hmac->add_Buffer(hmac, client_nonce->get_Buffer(client_nonce));
+	if ( !hmac->compute(hmac) )
+		ERR(goto done);
+	if ( memcmp(hmac->get(hmac), bufr->get(bufr) + 1 + NAAAIM_IDSIZE, \
+		    NAAAIM_IDSIZE) != 0 )
+		ERR(goto done);
+
+	/* Restore the attested state of the host and derive the keys. */
+	if ( S->software == NULL )
+		INIT(HurdLib, Buffer, S->software, goto done);
+	S->software->reset(S->software);
+	if ( !S->software->add(S->software, p, NAAAIM_IDSIZE) )
+		ERR(goto done);
+	S->cipher = mode;
+
+	INIT(HurdLib, Buffer, nonce, goto done);
+	if ( !nonce->add(nonce, bufr->get(bufr) + 1, NAAAIM_IDSIZE) )
+		ERR(goto done);
+
+	S->shared1->reset(S->shared1);
+	S->shared2->reset(S->shared2);
+	b = client_nonce->get_Buffer(client_nonce);
+	if ( !_derive_shared_keys(S, nonce, b, secret) )
+		ERR(goto done);
+	if ( !_setup_session(S, false) )
+		ERR(goto done);
+
+	/* Retain the ticket for subsequent connections. */
+	if ( S->ticket != ticket ) {
+		WHACK(S->ticket);
+		INIT(HurdLib, Buffer, S->ticket, goto done);
+		if ( !S->ticket->add_Buffer(S->ticket, ticket) )
+			ERR(goto done);
+	}
+
+	retn = true;
+
+
+ done:
+	WHACK(bufr);
+	WHACK(secret);
+	WHACK(nonce);
+	WHACK(name);
+	WHACK(client_nonce);
+	WHACK(hmac);
+	WHACK(idmgr);
+	WHACK(token);
+
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method implements setting the packet protection mode which
+ * the object will propose when it initiates a session in client
+ * mode.  The mode used by a host is the mode proposed by the client
+ * which connects to it.
+ *
+ * The CBC/HMAC mode is proposed by default so that a client remains
+ * able to connect to hosts which do not negotiate a mode.  The
+ * authenticated encryption mode must be requested explicitly.
+ *
+ * \param this		A pointer to the object whose packet protection
+ *			mode is to be set.
+ *
+ * \param cipher	The packet protection mode to be proposed.
+ *
+ * \return		A boolean value is returned to indicate whether
+ *			or not the mode was set.  A false value indicates
+ *			an unknown mode was requested.
+ */
+
+static _Bool set_cipher(CO(PossumPipe, this), const PossumPipe_cipher cipher)
+
+{
+	STATE(S);
+
+
+	if ( (cipher != PossumPipe_cbc_hmac) && \
+	     (cipher != PossumPipe_aes256_gcm) )
+		return false;
+
+	S->proposal = cipher;
+	return true;
+}
+
+
 /**
  * External public method.
  *
@@ -2057,6 +3465,18 @@ static void reset(CO(PossumPipe, this))
 	S->received->reset(S->received);
 
 	S->software->reset(S->software);
+	WHACK(S->identity);
+	WHACK(S->quote);
+
+	/* Release the session cipher contexts. */
+	WHACK(S->encrypter);
+	WHACK(S->decrypter);
+
+	S->cipher	    = PossumPipe_cbc_hmac;
+	S->send_sequence    = 0;
+	S->receive_sequence = 0;
+
+	WHACK(S->ticket);
 
 	/* Close the underlying communications object. */
 	S->duct->reset(S->duct);
@@ -2090,6 +3510,18 @@ static void whack(CO(PossumPipe, this))
 	WHACK(S->received);
 
 	S->software->whack(S->software);
+	WHACK(S->identity);
+	WHACK(S->quote);
+
+	WHACK(S->encrypter);
+	WHACK(S->decrypter);
+	WHACK(S->local_software);
+
+	WHACK(S->ticket_key);
+	WHACK(S->previous_key);
+	WHACK(S->ticket);
+
+	WHACK(S->index);
 
 	S->root->whack(S->root, this, S);
 	return;
@@ -2140,6 +3572,7 @@ extern PossumPipe NAAAIM_PossumPipe_Init(void)
 	this->init_client = init_client;
 
 	this->accept_connection = accept_connection;
+	this->set_connection	= set_connection;
 
 	this->send_packet    = send_packet;
 	this->receive_packet = receive_packet;
@@ -2147,6 +3580,13 @@ extern PossumPipe NAAAIM_PossumPipe_Init(void)
 	this->start_host_mode	= start_host_mode;
 	this->start_client_mode = start_client_mode;
 
+	this->set_cipher = set_cipher;
+
+	this->enable_resumption	 = enable_resumption;
+	this->set_ticket_key	 = set_ticket_key;
+	this->get_ticket	 = get_ticket;
+	this->resume_client_mode = resume_client_mode;
+
 	this->reset = reset;
 	this->whack = whack;
 
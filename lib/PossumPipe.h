@@ -28,9 +28,20 @@ typedef enum {
 	PossumPipe_error,
 	PossumPipe_setup,
 	PossumPipe_data,
-	PossumPipe_rekey
+	PossumPipe_rekey,
+	PossumPipe_ticket,
+	PossumPipe_stream
 } PossumPipe_type;
 
+/**
+ * Enumerated definitions for the packet protection modes which can
+ * be negotiated for a session.
+ */
+typedef enum {
+	PossumPipe_cbc_hmac=1,
+	PossumPipe_aes256_gcm
+} PossumPipe_cipher;
+
 /**
  * External PossumPipe object representation.
  */
@@ -41,10 +52,18 @@ struct NAAAIM_PossumPipe
 	_Bool (*init_client)(const PossumPipe, const char *, int port);
 
 	_Bool (*accept_connection)(const PossumPipe);
+	_Bool (*set_connection)(const PossumPipe, const int);
 
 	_Bool (*start_host_mode)(const PossumPipe);
 	_Bool (*start_client_mode)(const PossumPipe);
 
+	_Bool (*set_cipher)(const PossumPipe, const PossumPipe_cipher);
+
+	_Bool (*enable_resumption)(const PossumPipe, const time_t);
+	_Bool (*set_ticket_key)(const PossumPipe, const Buffer);
+	_Bool (*get_ticket)(const PossumPipe, const Buffer);
+	_Bool (*resume_client_mode)(const PossumPipe, const Buffer);
+
 	_Bool (*send_packet)(const PossumPipe, PossumPipe_type, const Buffer);
 	PossumPipe_type (*receive_packet)(const PossumPipe, const Buffer);
 
@@ -6,9 +6,11 @@
  **************************************************************************/
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include <unistd.h>
 #include <string.h>
+#include <time.h>
 #include <arpa/inet.h>
 
 #include <HurdLib.h>
@@ -16,6 +18,7 @@
 #include <NAAAIM.h>
 
 #include "PossumPipe.h"
+#include "PossumMux.h"
 
 #define KEY1 "0000000000000000000000000000000000000000000000000000000000000000"
 #define KEY2 "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"
@@ -28,6 +31,20 @@ enum {
 	server
 } Mode;
 
+/* Number and size of packets to be sent in benchmark mode. */
+static unsigned long Count = 0;
+
+static size_t Length = 16384;
+
+/* Resumption ticket lifetime, a value of zero disables resumption. */
+static time_t Lifetime = 0;
+
+/* Hexadecimal ticket key shared by the servers which accept tickets. */
+static char *TicketKey = NULL;
+
+/* Number of multiplexed streams to be exercised. */
+static unsigned int Streams = 0;
+
 
 static _Bool ping(CO(PossumPipe, pipe))
 
@@ -84,22 +101,289 @@ static _Bool ping(CO(PossumPipe, pipe))
 }
 
 
+/**
+ * Private function.
+ *
+ * This function implements a bulk throughput benchmark of an
+ * established pipe.  The client transmits the requested number of
+ * data packets and the server returns a single packet once all of
+ * them have been received.  The client reports the throughput
+ * measured over the complete exchange.
+ *
+ * \param pipe	The pipe over which the benchmark is to be run.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		the benchmark completed successfully.
+ */
+
+static _Bool benchmark(CO(PossumPipe, pipe))
+
+{
+	_Bool retn = false;
+
+	unsigned long lp;
+
+	double elapsed;
+
+	struct timespec start,
+			end;
+
+	Buffer bufr    = NULL,
+	       payload = NULL;
+
+
+	INIT(HurdLib, Buffer, bufr, goto done);
+	INIT(HurdLib, Buffer, payload, goto done);
+
+	if ( Mode == server ) {
+		for (lp= 0; lp < Count; ++lp) {
+			bufr->reset(bufr);
+			if ( pipe->receive_packet(pipe, bufr) != \
+			     PossumPipe_data ) {
+				fputs("Error receiving packet.\n", stderr);
+				goto done;
+			}
+		}
+
+		bufr->reset(bufr);
+		bufr->add_hexstring(bufr, KEY2);
+		if ( !pipe->send_packet(pipe, PossumPipe_data, bufr) ) {
+			fputs("Error sending packet.\n", stderr);
+			goto done;
+		}
+
+		retn = true;
+	}
+
+	if ( Mode == client ) {
+		for (lp= 0; lp < Length; ++lp)
+			payload->add(payload, (unsigned char *) &lp, 1);
+		if ( payload->poisoned(payload) ) {
+			fputs("Error creating payload.\n", stderr);
+			goto done;
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (lp= 0; lp < Count; ++lp) {
+			bufr->reset(bufr);
+			bufr->add_Buffer(bufr, payload);
+			if ( !pipe->send_packet(pipe, PossumPipe_data, \
+						bufr) ) {
+				fputs("Error sending packet.\n", stderr);
+				goto done;
+			}
+		}
+
+		bufr->reset(bufr);
+		if ( pipe->receive_packet(pipe, bufr) != PossumPipe_data ) {
+			fputs("Error receiving packet.\n", stderr);
+			goto done;
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+
+		elapsed  = end.tv_sec - start.tv_sec;
+		elapsed += (end.tv_nsec - start.tv_nsec) / 1e9;
+		fprintf(stdout, "Sent %lu packets of %zu bytes in %.3f " \
+			"seconds.\n", Count, Length, elapsed);
+		fprintf(stdout, "Throughput: %.0f packets/sec, %.2f " \
+			"MB/sec\n", Count / elapsed,			 \
+			(Count * Length) / elapsed / (1024 * 1024));
+
+		retn = true;
+	}
+
+
+ done:
+	WHACK(bufr);
+	WHACK(payload);
+
+	return retn;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function returns the number of milliseconds which have elapsed
+ * since the supplied starting time.
+ *
+ * \param start	A pointer to the structure containing the starting
+ *		time.
+ *
+ * \return	The number of elapsed milliseconds.
+ */
+
+static double elapsed_ms(const struct timespec *start)
+
+{
+	struct timespec end;
+
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	return (end.tv_sec - start->tv_sec) * 1e3 + \
+		(end.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+
+/**
+ * Private function.
+ *
+ * This function exercises stream multiplexing over an established
+ * pipe.  The client opens the requested number of streams and sends
+ * Length bytes on each of them before closing them.  The server
+ * replies on each stream with the number of bytes it received once
+ * the client has closed the stream.
+ *
+ * \param pipe	The pipe over which the streams are to be run.
+ *
+ * \return	A boolean value is returned to indicate whether or not
+ *		all of the streams completed successfully.
+ */
+
+static _Bool multiplex(CO(PossumPipe, pipe))
+
+{
+	_Bool retn = false;
+
+	uint32_t id,
+		 ids[POSSUMMUX_MAX_STREAMS];
+
+	unsigned int lp,
+		     closed = 0;
+
+	size_t total,
+	       received[POSSUMMUX_MAX_STREAMS * 2 + 2];
+
+	struct timespec start;
+
+	Buffer bufr    = NULL,
+	       payload = NULL;
+
+	PossumMux mux = NULL;
+
+
+	if ( Streams > POSSUMMUX_MAX_STREAMS ) {
+		fputs("Too many streams requested.\n", stderr);
+		return false;
+	}
+
+	INIT(HurdLib, Buffer, bufr, goto done);
+	INIT(HurdLib, Buffer, payload, goto done);
+	INIT(NAAAIM, PossumMux, mux, goto done);
+
+	if ( Mode == server ) {
+		if ( !mux->init(mux, pipe, false) )
+			goto done;
+		memset(received, '\0', sizeof(received));
+
+		while ( closed < Streams ) {
+			if ( !mux->next_ready(mux, &id) ) {
+				fputs("Error waiting for stream.\n", stderr);
+				goto done;
+			}
+			if ( id >= (sizeof(received) / sizeof(size_t)) ) {
+				fputs("Invalid stream identifier.\n", stderr);
+				goto done;
+			}
+
+			bufr->reset(bufr);
+			if ( mux->receive_data(mux, id, bufr) ) {
+				received[id] += bufr->size(bufr);
+				continue;
+			}
+
+			bufr->reset(bufr);
+			bufr->add(bufr, (unsigned char *) &received[id], \
+				  sizeof(received[id]));
+			if ( !mux->send_data(mux, id, bufr) )
+				goto done;
+			if ( !mux->close_stream(mux, id) )
+				goto done;
+			++closed;
+		}
+
+		retn = true;
+	}
+
+	if ( Mode == client ) {
+		if ( !mux->init(mux, pipe, true) )
+			goto done;
+		for (total= 0; total < Length; ++total)
+			payload->add(payload, (unsigned char *) &total, 1);
+		if ( payload->poisoned(payload) ) {
+			fputs("Error creating payload.\n", stderr);
+			goto done;
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (lp= 0; lp < Streams; ++lp) {
+			if ( !mux->open_stream(mux, &ids[lp]) ) {
+				fputs("Error opening stream.\n", stderr);
+				goto done;
+			}
+			if ( !mux->send_data(mux, ids[lp], payload) )
+				goto done;
+		}
+		if ( !mux->flush(mux) ) {
+			fputs("Error sending stream data.\n", stderr);
+			goto done;
+		}
+
+		for (lp= 0; lp < Streams; ++lp) {
+			if ( !mux->close_stream(mux, ids[lp]) )
+				goto done;
+		}
+
+		for (lp= 0; lp < Streams; ++lp) {
+			bufr->reset(bufr);
+			if ( !mux->receive_data(mux, ids[lp], bufr) || \
+			     (bufr->size(bufr) != sizeof(total)) ) {
+				fputs("Error receiving stream reply.\n", \
+				      stderr);
+				goto done;
+			}
+			memcpy(&total, bufr->get(bufr), sizeof(total));
+			if ( total != Length ) {
+				fprintf(stderr, "Stream %u: received %zu " \
+					"bytes.\n", ids[lp], total);
+				goto done;
+			}
+		}
+
+		fprintf(stdout, "Multiplexed %u streams of %zu bytes in " \
+			"%.3f ms\n", Streams, Length, elapsed_ms(&start));
+		retn = true;
+	}
+
+
+ done:
+	WHACK(bufr);
+	WHACK(payload);
+	WHACK(mux);
+
+	return retn;
+}
+
+
 extern int main(int argc, char *argv[])
 
 {
-	_Bool do_reverse = false;
+	_Bool gcm	 = false,
+	      do_reverse = false;
 
 	char *host = NULL;
 
 	int retn;
 
+	struct timespec start;
+
 	PossumPipe pipe = NULL;
 
 	Buffer bufr = NULL;
 
 
         /* Get operational mode. */
-        while ( (retn = getopt(argc, argv, "CSrh:")) != EOF )
+        while ( (retn = getopt(argc, argv, "CGSrb:h:k:l:m:t:")) != EOF )
                 switch ( retn ) {
 			case 'C':
 				Mode = client;
@@ -108,9 +392,29 @@ extern int main(int argc, char *argv[])
 				Mode = server;
 				break;
 
+			case 'G':
+				gcm = true;
+				break;
+
+			case 'b':
+				Count = strtoul(optarg, NULL, 0);
+				break;
+			case 'l':
+				Length = strtoul(optarg, NULL, 0);
+				break;
+			case 'm':
+				Streams = strtoul(optarg, NULL, 0);
+				break;
+			case 't':
+				Lifetime = strtoul(optarg, NULL, 0);
+				break;
+
 			case 'h':
 				host = optarg;
 				break;
+			case 'k':
+				TicketKey = optarg;
+				break;
 
 			case 'r':
 				do_reverse = true;
@@ -143,6 +447,18 @@ extern int main(int argc, char *argv[])
 			fputs("Cannot set server mode.\n", stderr);
 			goto done;
 		}
+		if ( TicketKey != NULL ) {
+			if ( !bufr->add_hexstring(bufr, TicketKey) || \
+			     !pipe->set_ticket_key(pipe, bufr) ) {
+				fputs("Cannot set ticket key.\n", stderr);
+				goto done;
+			}
+			bufr->reset(bufr);
+		}
+		if ( !pipe->enable_resumption(pipe, Lifetime) ) {
+			fputs("Cannot enable session resumption.\n", stderr);
+			goto done;
+		}
 
 		fputs("Waiting for client connection.\n", stderr);
 		if ( !pipe->accept_connection(pipe) ) {
@@ -157,6 +473,25 @@ extern int main(int argc, char *argv[])
 		}
 
 		ping(pipe);
+		if ( Count > 0 )
+			benchmark(pipe);
+		if ( Streams > 0 )
+			multiplex(pipe);
+
+		if ( Lifetime > 0 ) {
+			pipe->reset(pipe);
+			fputs("Waiting for resumed connection.\n", stderr);
+			if ( !pipe->accept_connection(pipe) ) {
+				fputs("Error accepting connection.\n", stderr);
+				goto done;
+			}
+			if ( !pipe->start_host_mode(pipe) ) {
+				fputs("Resumption of host mode failed.\n", \
+				      stderr);
+				goto done;
+			}
+			ping(pipe);
+		}
 		sleep(5);
 	}
 
@@ -173,12 +508,55 @@ extern int main(int argc, char *argv[])
 			fputs("Cannot initialize client pipe.\n", stderr);
 			goto done;
 		}
+		if ( gcm && !pipe->set_cipher(pipe, PossumPipe_aes256_gcm) ) {
+			fputs("Cannot set GCM packet mode.\n", stderr);
+			goto done;
+		}
+		if ( !pipe->enable_resumption(pipe, Lifetime) ) {
+			fputs("Cannot enable session resumption.\n", stderr);
+			goto done;
+		}
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
 		if ( !pipe->start_client_mode(pipe)) {
 			fputs("Error starting client mode.\n", stderr);
 			goto done;
 		}
+		fprintf(stdout, "Session setup: %.3f ms\n", elapsed_ms(&start));
 
 		ping(pipe);
+		if ( Count > 0 )
+			benchmark(pipe);
+		if ( Streams > 0 )
+			multiplex(pipe);
+
+		if ( Lifetime > 0 ) {
+			if ( !pipe->get_ticket(pipe, bufr) ) {
+				fputs("No resumption ticket issued.\n", stderr);
+				goto done;
+			}
+			WHACK(pipe);
+
+			if ( (pipe = NAAAIM_PossumPipe_Init()) == NULL ) {
+				fputs("Cannot initialize PossumPipe.\n", \
+				      stderr);
+				goto done;
+			}
+			if ( !pipe->init_client(pipe, host, 11990) ) {
+				fputs("Cannot initialize client pipe.\n", \
+				      stderr);
+				goto done;
+			}
+
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			if ( !pipe->resume_client_mode(pipe, bufr) ) {
+				fputs("Error resuming client mode.\n", stderr);
+				goto done;
+			}
+			fprintf(stdout, "Session resumption: %.3f ms\n", \
+				elapsed_ms(&start));
+			ping(pipe);
+		}
 	}
 
 
@@ -1051,6 +1051,110 @@ static _Bool verify(CO(RSAkey, this), CO(Buffer, signature), \
 	return retn;
 }
 
+/**
+ * External public method.
+ *
+ * This method implements verification of a signature over a SHA256
+ * digest which has already been computed.  This allows a caller
+ * which hashes the signed data as it is read to verify the signature
+ * without retaining the data and having it hashed a second time.
+ *
+ * \param this		A pointer to the object describing the key that
+ *			is to be used for verifying a signature.
+ *
+ * \param signature	The object containing the signature that is to
+ *			be verified.
+ *
+ * \param digest	The object containing the SHA256 digest of the
+ *			data whose signature is to be verified.
+ *
+ * \param status	A pointer to a boolean value used to indicate
+ *			whether or not the provided signature was
+ *			correct.
+ *
+ * \return		A boolean value is returned to indicate the
+ *			status of the verification process.  A false
+ *			value implies an error was encountered and
+ *			no assumptions can be made about the status
+ *			value.  A true value indicates the process
+ *			succeeded and the status variable will be
+ *			updated to reflect the status of the
+ *			signature verification.
+ */
+
+static _Bool verify_digest(CO(RSAkey, this), CO(Buffer, signature), \
+			   CO(Buffer, digest), _Bool *status)
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	int verify_retn;
+
+	EVP_PKEY *pkey = NULL;
+
+	EVP_PKEY_CTX *ctx = NULL;
+
+
+	/* Verify object status. */
+	if ( signature == NULL )
+		ERR(goto done);
+	if ( signature->poisoned(signature) )
+		ERR(goto done);
+	if ( digest == NULL )
+		ERR(goto done);
+	if ( digest->poisoned(digest) )
+		ERR(goto done);
+	if ( digest->size(digest) != NAAAIM_IDSIZE )
+		ERR(goto done);
+	if ( (S->certificate == NULL) && (S->type != public_key) )
+		ERR(goto done);
+
+
+	/* Setup the RSA key that will be used. */
+	if ( S->certificate != NULL ) {
+		if ( (pkey = X509_get_pubkey(S->certificate)) == NULL )
+			ERR(goto done);
+	} else {
+		if ( (pkey = EVP_PKEY_new()) == NULL )
+			ERR(goto done);
+		if ( EVP_PKEY_set1_RSA(pkey, S->key) == 0 )
+			ERR(goto done);
+	}
+
+
+	/* Initialize a PKCS1 verification context for a SHA256 digest. */
+	if ( (ctx = EVP_PKEY_CTX_new(pkey, NULL)) == NULL )
+		ERR(goto done);
+	if ( EVP_PKEY_verify_init(ctx) <= 0 )
+		ERR(goto done);
+	if ( EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_PADDING) <= 0 )
+		ERR(goto done);
+	if ( EVP_PKEY_CTX_set_signature_md(ctx, EVP_sha256()) <= 0 )
+		ERR(goto done);
+
+
+	/* Verify the signature. */
+	verify_retn = EVP_PKEY_verify(ctx, signature->get(signature), \
+				      signature->size(signature),    \
+				      digest->get(digest),	     \
+				      digest->size(digest));
+	if ( verify_retn < 0 )
+		ERR(goto done);
+
+	retn	= true;
+	*status = verify_retn == 1;
+
+
+ done:
+	EVP_PKEY_free(pkey);
+	EVP_PKEY_CTX_free(ctx);
+
+	return retn;
+}
+
+
 
 /**
  * External public method.
@@ -1148,6 +1252,104 @@ static _Bool sign(CO(RSAkey, this), CO(Buffer, data), CO(Buffer, signature))
 }
 
 
+/**
+ * External public method.
+ *
+ * This method implements signing of a SHA256 digest which has already
+ * been computed.  It is the counterpart of the verify_digest method
+ * and allows a caller which hashes a large body of data as it is
+ * generated to sign it without retaining the data.
+ *
+ * \param this		A pointer to the object describing the key that
+ *			is to be used for generating the signature.
+ *
+ * \param digest	The object containing the SHA256 digest of the
+ *			data which is to be signed.
+ *
+ * \param signature	The object which the signature will be loaded
+ *			into.
+ *
+ * \return		A boolean value is returned to indicate the
+ *			status of the signature generation.  A false
+ *			value implies an error was encountered and
+ *			no assumptions can be made about the data
+ *			in the output object.  A true value indicates
+ *			the signing succeeded and the output object
+ *			contains a valid signature.
+ */
+
+static _Bool sign_digest(CO(RSAkey, this), CO(Buffer, digest), \
+			 CO(Buffer, signature))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	size_t outsize;
+
+	EVP_PKEY *pkey = NULL;
+
+	EVP_PKEY_CTX *ctx = NULL;
+
+
+	/* Verify object status. */
+	if ( digest == NULL )
+		ERR(goto done);
+	if ( digest->poisoned(digest) )
+		ERR(goto done);
+	if ( digest->size(digest) != NAAAIM_IDSIZE )
+		ERR(goto done);
+	if ( signature == NULL )
+		ERR(goto done);
+	if ( signature->poisoned(signature) )
+		ERR(goto done);
+	if ( signature->size(signature) != 0 )
+		ERR(goto done);
+	if ( S->type != private_key )
+		ERR(goto done);
+
+
+	/* Setup the RSA key that will be used. */
+	if ( (pkey = EVP_PKEY_new()) == NULL )
+		ERR(goto done);
+	if ( EVP_PKEY_set1_RSA(pkey, S->key) == 0 )
+		ERR(goto done);
+
+
+	/* Initialize a PKCS1 signing context for a SHA256 digest. */
+	if ( (ctx = EVP_PKEY_CTX_new(pkey, NULL)) == NULL )
+		ERR(goto done);
+	if ( EVP_PKEY_sign_init(ctx) <= 0 )
+		ERR(goto done);
+	if ( EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_PADDING) <= 0 )
+		ERR(goto done);
+	if ( EVP_PKEY_CTX_set_signature_md(ctx, EVP_sha256()) <= 0 )
+		ERR(goto done);
+
+
+	/* Scale the output object and generate the signature. */
+	while ( signature->size(signature) < EVP_PKEY_size(pkey) )
+		signature->add(signature, (unsigned char *) "\0", 1);
+	if ( signature->poisoned(signature) )
+		ERR(goto done);
+
+	outsize = signature->size(signature);
+	if ( EVP_PKEY_sign(ctx, signature->get(signature), &outsize, \
+			   digest->get(digest), digest->size(digest)) <= 0 )
+		ERR(goto done);
+
+	retn = true;
+
+
+ done:
+	EVP_PKEY_free(pkey);
+	EVP_PKEY_CTX_free(ctx);
+
+	return retn;
+}
+
+
 /**
  * External public method.
  *
@@ -1396,8 +1598,10 @@ extern RSAkey NAAAIM_RSAkey_Init(void)
 	this->encrypt = encrypt;
 	this->decrypt = decrypt;
 
-	this->verify = verify;
-	this->sign   = sign;
+	this->verify	     = verify;
+	this->verify_digest = verify_digest;
+	this->sign	     = sign;
+	this->sign_digest   = sign_digest;
 
 	this->init_engine = init_engine;
 	this->set_padding = set_padding;
@@ -12,8 +12,25 @@
  **************************************************************************/
 
 /* Local definitions. */
-#define CONTROL_FILE	"/sys/kernel/security/tsem/control"
-#define ID_FILE		"/sys/kernel/security/tsem/id"
+#define _GNU_SOURCE
+
+#define TSEM_DIRECTORY	"/sys/kernel/security/tsem"
+#define CONTROL_FILE	"control"
+#define ID_FILE		"id"
+#define UPDATE_FILE	"external_tma/%llu"
+
+/*
+ * The environment variable that relocates the TSEM directory so that
+ * the orchestrators can be run against the quixote-replay harness.
+ * The relocation is only compiled into builds configured with
+ * BUILD_REPLAY, since any process that controls the environment of
+ * an orchestrator would otherwise be able to redirect its control
+ * commands.  The variable is also ignored by setuid, setgid and
+ * capability elevated executions.
+ */
+#if defined(TSEM_REPLAY)
+#define TSEM_DIRECTORY_ENV "TSEM_SECURITYFS"
+#endif
 
 
 /* Include files. */
@@ -23,6 +40,9 @@
 #include <stdio.h>
 #include <sched.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
 
 #include <Origin.h>
 #include <HurdLib.h>
@@ -32,6 +52,7 @@
 
 #include "NAAAIM.h"
 #include "RandomBuffer.h"
+#include "EventLoop.h"
 #include "TSEMcontrol.h"
 
 
@@ -75,6 +96,12 @@ struct NAAAIM_TSEMcontrol_State
 
 	/* File object that implements I/O to the control file. */
 	File file;
+
+	/* Event loop that control commands are queued to. */
+	EventLoop loop;
+
+	/* Control file descriptor used by the event loop. */
+	int fd;
 };
 
 
@@ -97,15 +124,55 @@ static void _init_state(CO(TSEMcontrol_State, S)) {
 
 	S->key = NULL;
 
+	S->loop = NULL;
+	S->fd	= -1;
+
 	return;
 }
 
 
+/**
+ * Internal private function.
+ *
+ * This function generates the pathname of a file in the TSEM control
+ * directory.
+ *
+ * \param bufr	A pointer to the buffer that the pathname is to be
+ *		placed in.
+ *
+ * \param size	The size of the buffer.
+ *
+ * \param file	A pointer to a null-terminated buffer containing the
+ *		name of the file relative to the TSEM directory.
+ *
+ * \return	A boolean value is used to indicate whether or not the
+ *		pathname was generated.  A false value indicates the
+ *		pathname was too long for the buffer.
+ */
+
+static _Bool _pathname(char *bufr, const size_t size, CO(char *, file))
+
+{
+	const char *root = TSEM_DIRECTORY;
+
+#if defined(TSEM_DIRECTORY_ENV)
+	const char *env;
+
+
+	if ( (env = secure_getenv(TSEM_DIRECTORY_ENV)) != NULL )
+		root = env;
+#endif
+
+	return snprintf(bufr, size, "%s/%s", root, file) < size;
+}
+
+
 /**
  * Internal private method.
  *
  * This method implements writing the contents of the supplied String
- * variable to the control file.
+ * variable to the control file.  If an event loop has been set the
+ * command is queued to the loop rather than being written directly.
  *
  *
  * \param S     A pointer to the state information for the object that
@@ -122,6 +189,18 @@ static _Bool _write_cmd(CO(TSEMcontrol_State, S))
 	_Bool retn = false;
 
 
+	if ( S->loop != NULL ) {
+		if ( !S->loop->queue_write(S->loop, S->fd,		   \
+			   (unsigned char *) S->cmdstr->get(S->cmdstr),	   \
+			   S->cmdstr->size(S->cmdstr)) ) {
+			S->cmdstr->reset(S->cmdstr);
+			ERR(goto done);
+		}
+		S->cmdstr->reset(S->cmdstr);
+		retn = true;
+		goto done;
+	}
+
 	if ( !S->bufr->add(S->bufr,
 			   (unsigned char *) S->cmdstr->get(S->cmdstr), \
 			   S->cmdstr->size(S->cmdstr)) )
@@ -415,13 +494,18 @@ static _Bool id(CO(TSEMcontrol, this), uint64_t *idptr)
 
 	_Bool retn = false;
 
+	char fname[PATH_MAX];
+
 	uint64_t id;
 
 	File file = NULL;
 
 
+	if ( !_pathname(fname, sizeof(fname), ID_FILE) )
+		ERR(goto done);
+
 	INIT(HurdLib, File, file, ERR(goto done));
-	if ( !file->open_ro(file, ID_FILE) )
+	if ( !file->open_ro(file, fname) )
 		ERR(goto done);
 
 	S->cmdstr->reset(S->cmdstr);
@@ -613,6 +697,83 @@ static _Bool generate_key(CO(TSEMcontrol, this))
 }
 
 
+/**
+ * External public method.
+ *
+ * This method sets the event loop that subsequent control commands
+ * are to be queued to.  This allows the commands that release the
+ * processes that generated a batch of security events to be written
+ * together by the event loop.
+ *
+ * \param this	The object whose commands are to be queued.
+ *
+ * \param loop	The event loop the commands are to be queued to.  A
+ *		NULL value causes the commands to be written directly.
+ *
+ * \return	A boolean value is used to indicate the status of
+ *		setting the event loop.  A false value indicates the
+ *		control file could not be opened for the loop while a
+ *		true value indicates the loop has been set.
+ */
+
+static _Bool set_loop(CO(TSEMcontrol, this), CO(EventLoop, loop))
+
+{
+	STATE(S);
+
+	_Bool retn = false;
+
+	char fname[PATH_MAX];
+
+
+	if ( (loop != NULL) && (S->fd == -1) ) {
+		if ( !_pathname(fname, sizeof(fname), CONTROL_FILE) )
+			ERR(goto done);
+		if ( (S->fd = open(fname, O_WRONLY | O_CLOEXEC)) < 0 )
+			ERR(goto done);
+	}
+
+	S->loop = loop;
+	retn = true;
+
+
+ done:
+	return retn;
+}
+
+
+/**
+ * External public method.
+ *
+ * This method generates the pathname of the file that the security
+ * events of an externally modeled namespace are read from.
+ *
+ * \param this	The object whose namespace file is to be located.
+ *
+ * \param id	The identifier of the namespace.
+ *
+ * \param bufr	A pointer to the buffer that the pathname is to be
+ *		placed in.
+ *
+ * \param size	The size of the buffer.
+ *
+ * \return	A boolean value is used to indicate whether or not the
+ *		pathname was generated.  A false value indicates the
+ *		pathname was too long for the buffer.
+ */
+
+static _Bool update_file(CO(TSEMcontrol, this), const uint64_t id, \
+			 char *bufr, const size_t size)
+
+{
+	char file[32];
+
+
+	snprintf(file, sizeof(file), UPDATE_FILE, (long long unsigned int) id);
+	return _pathname(bufr, size, file);
+}
+
+
 /**
  * External public method.
  *
@@ -632,6 +793,9 @@ static void whack(CO(TSEMcontrol, this))
 	WHACK(S->key);
 	WHACK(S->file);
 
+	if ( S->fd != -1 )
+		close(S->fd);
+
 	S->root->whack(S->root, this, S);
 	return;
 }
@@ -655,6 +819,8 @@ extern TSEMcontrol NAAAIM_TSEMcontrol_Init(void)
 
 	struct HurdLib_Origin_Retn retn;
 
+	char fname[PATH_MAX];
+
 
 	/* Get the root object. */
 	root = HurdLib_Origin_Init();
@@ -673,7 +839,9 @@ extern TSEMcontrol NAAAIM_TSEMcontrol_Init(void)
 	INIT(HurdLib, String, this->state->cmdstr, goto fail);
 
 	INIT(HurdLib, File, this->state->file, goto fail);
-	if ( !this->state->file->open_wo(this->state->file, CONTROL_FILE) )
+	if ( !_pathname(fname, sizeof(fname), CONTROL_FILE) )
+		goto fail;
+	if ( !this->state->file->open_wo(this->state->file, fname) )
 		goto fail;
 
 	/* Initialize object state. */
@@ -691,9 +859,11 @@ extern TSEMcontrol NAAAIM_TSEMcontrol_Init(void)
 	this->add_state = add_state;
 	this->pseudonym = pseudonym;
 
-	this->id = id;
+	this->id	  = id;
+	this->update_file = update_file;
 
 	this->generate_key = generate_key;
+	this->set_loop	   = set_loop;
 	this->whack = whack;
 
 	return this;
@@ -54,8 +54,11 @@ struct NAAAIM_TSEMcontrol
 	_Bool (*pseudonym)(const TSEMcontrol, const Buffer);
 
 	_Bool (*id)(const TSEMcontrol, uint64_t *);
+	_Bool (*update_file)(const TSEMcontrol, const uint64_t, char *, \
+			     const size_t);
 
 	_Bool (*generate_key)(const TSEMcontrol);
+	_Bool (*set_loop)(const TSEMcontrol, const EventLoop);
 	void (*whack)(const TSEMcontrol);
 
 	/* Private state. */